@@ -42,7 +42,9 @@ check_include_file("portaudio.h"         HAVE_PORTAUDIO_H)
 check_include_file("pwd.h"               HAVE_PWD_H)
 check_include_file("stdint.h"            HAVE_STDINT_H)
 check_include_file("sys/ioctl.h"         HAVE_SYS_IOCTL_H)
+check_include_file("sys/mman.h"          HAVE_SYS_MMAN_H)
 check_include_file("sys/param.h"         HAVE_SYS_PARAM_H)
+check_include_file("sys/sdt.h"           HAVE_SYS_SDT_H)
 check_include_file("sys/socket.h"        HAVE_SYS_SOCKET_H)
 check_include_file("sys/sockio.h"        HAVE_SYS_SOCKIO_H)
 check_include_file("sys/stat.h"          HAVE_SYS_STAT_H)
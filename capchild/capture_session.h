@@ -62,6 +62,7 @@ typedef struct _capture_session {
 #endif
     gboolean  session_started;
     guint32   count;                      /**< Total number of frames captured */
+    guint32   count_pending;              /**< Number of frames captured that we haven't read yet */
     capture_options *capture_opts;        /**< options for this capture */
     struct    _capture_file *cf;          /**< handle to cfile */
     struct _info_data *cap_data_info;          /**< stats for this capture */
@@ -1060,8 +1060,14 @@ cleanup_capture_info(capture_info *cf_info)
   cf_info->idb_info_strings = NULL;
 }
 
+/*
+ * Read through a file and fill in *info with what we found.  *have_info
+ * is set to TRUE if there's anything to report and, if so, *info must
+ * be cleaned up with cleanup_capture_info().
+ */
 static int
-process_cap_file(wtap *wth, const char *filename)
+process_cap_file(wtap *wth, const char *filename, capture_info *info,
+                 gboolean *have_info)
 {
   int                   status = 0;
   int                   err;
@@ -1090,6 +1096,7 @@ process_cap_file(wtap *wth, const char *filename)
   g_assert(wth != NULL);
   g_assert(filename != NULL);
 
+  *have_info = FALSE;
   nstime_set_zero(&start_time);
   start_time_tsprec = WTAP_TSPREC_UNKNOWN;
   nstime_set_zero(&stop_time);
@@ -1302,17 +1309,110 @@ process_cap_file(wtap *wth, const char *filename)
     cf_info.packet_size = (double)bytes / packet;                  /* Avg packet size      */
   }
 
-  if (long_report) {
-    print_stats(filename, &cf_info);
-  } else {
-    print_stats_table(filename, &cf_info);
+  *info = cf_info;
+  *have_info = TRUE;
+
+  return status;
+}
+
+/*
+ * A file to report on.  With more than one file, the files are hashed
+ * and read by a pool of threads, several at a time, but the reports
+ * are printed by the main thread in the order the files were given.
+ */
+typedef struct {
+  const char   *filename;
+  gchar         file_sha256[HASH_STR_SIZE];
+  gchar         file_rmd160[HASH_STR_SIZE];
+  gchar         file_sha1[HASH_STR_SIZE];
+  wtap         *wth;
+  int           err;                    /* why we couldn't open it */
+  gchar        *err_info;
+  int           status;                 /* from process_cap_file() */
+  gboolean      have_info;
+  capture_info  cf_info;
+  gboolean      done;
+} capinfos_job_t;
+
+#if GLIB_CHECK_VERSION(2,36,0)
+#define USE_JOB_THREADS
+/* Only libgcrypt 1.6 and later can be used from several threads without
+   setting up thread callbacks. */
+#if GCRYPT_VERSION_NUMBER >= 0x010600
+#define HASH_THREAD_SAFE TRUE
+#else
+#define HASH_THREAD_SAFE FALSE
+#endif
+/* How many files per thread to read ahead of the one being reported on */
+#define JOBS_AHEAD 4
+
+static GMutex jobs_mtx;
+static GCond jobs_cond;
+#endif
+
+static void
+hash_to_str(const unsigned char *hash, size_t length, char *str) {
+  int i;
+
+  for (i = 0; i < (int) length; i++) {
+    g_snprintf(str+(i*2), 3, "%02x", hash[i]);
   }
+}
 
-  cleanup_capture_info(&cf_info);
+static void
+run_job(capinfos_job_t *job)
+{
+  FILE  *fh;
+  char  *hash_buf;
+  gcry_md_hd_t hd = NULL;
+  size_t hash_bytes;
 
-  return status;
+  g_strlcpy(job->file_sha256, "<unknown>", HASH_STR_SIZE);
+  g_strlcpy(job->file_rmd160, "<unknown>", HASH_STR_SIZE);
+  g_strlcpy(job->file_sha1, "<unknown>", HASH_STR_SIZE);
+
+  if (cap_file_hashes) {
+    gcry_md_open(&hd, GCRY_MD_SHA256, 0);
+    if (hd) {
+      gcry_md_enable(hd, GCRY_MD_RMD160);
+      gcry_md_enable(hd, GCRY_MD_SHA1);
+    }
+    fh = ws_fopen(job->filename, "rb");
+    if (fh && hd) {
+      hash_buf = (char *)g_malloc(HASH_BUF_SIZE);
+      while((hash_bytes = fread(hash_buf, 1, HASH_BUF_SIZE, fh)) > 0) {
+        gcry_md_write(hd, hash_buf, hash_bytes);
+      }
+      g_free(hash_buf);
+      gcry_md_final(hd);
+      hash_to_str(gcry_md_read(hd, GCRY_MD_SHA256), HASH_SIZE_SHA256, job->file_sha256);
+      hash_to_str(gcry_md_read(hd, GCRY_MD_RMD160), HASH_SIZE_RMD160, job->file_rmd160);
+      hash_to_str(gcry_md_read(hd, GCRY_MD_SHA1), HASH_SIZE_SHA1, job->file_sha1);
+    }
+    if (fh) fclose(fh);
+    if (hd) gcry_md_close(hd);
+  }
+
+  job->wth = wtap_open_offline(job->filename, WTAP_TYPE_AUTO, &job->err, &job->err_info, FALSE);
+  if (job->wth)
+    job->status = process_cap_file(job->wth, job->filename, &job->cf_info, &job->have_info);
 }
 
+#ifdef USE_JOB_THREADS
+static void
+job_thread(gpointer data, gpointer user_data _U_)
+{
+  capinfos_job_t *job = (capinfos_job_t *)data;
+
+  run_job(job);
+
+  g_mutex_lock(&jobs_mtx);
+  job->done = TRUE;
+  g_cond_broadcast(&jobs_cond);
+  g_mutex_unlock(&jobs_mtx);
+}
+#endif
+
 static void
 print_usage(FILE *output)
 {
@@ -1398,24 +1498,12 @@ failure_message_cont(const char *msg_format, va_list ap)
   fprintf(stderr, "\n");
 }
 
-static void
-hash_to_str(const unsigned char *hash, size_t length, char *str) {
-  int i;
-
-  for (i = 0; i < (int) length; i++) {
-    g_snprintf(str+(i*2), 3, "%02x", hash[i]);
-  }
-}
-
 int
 main(int argc, char *argv[])
 {
   GString *comp_info_str;
   GString *runtime_info_str;
   char  *init_progfile_dir_error;
-  wtap  *wth;
-  int    err;
-  gchar *err_info;
   int    opt;
   int    overall_error_status = EXIT_SUCCESS;
   static const struct option long_options[] = {
@@ -1424,11 +1512,14 @@ main(int argc, char *argv[])
       {0, 0, 0, 0 }
   };
 
-  int status = 0;
-  FILE  *fh;
-  char  *hash_buf = NULL;
-  gcry_md_hd_t hd = NULL;
-  size_t hash_bytes;
+  int    n_jobs = 0;
+  capinfos_job_t *jobs = NULL;
+  capinfos_job_t *job;
+#ifdef USE_JOB_THREADS
+  GThreadPool *pool = NULL;
+  int    n_threads = 1;
+  int    next_job = 0;
+#endif
 
   /* Set the C-language locale to the native environment. */
   setlocale(LC_ALL, "");
@@ -1687,61 +1778,86 @@ main(int argc, char *argv[])
 
   if (cap_file_hashes) {
     gcry_check_version(NULL);
-    gcry_md_open(&hd, GCRY_MD_SHA256, 0);
-    if (hd) {
-      gcry_md_enable(hd, GCRY_MD_RMD160);
-      gcry_md_enable(hd, GCRY_MD_SHA1);
-    }
-    hash_buf = (char *)g_malloc(HASH_BUF_SIZE);
   }
 
   overall_error_status = 0;
 
-  for (opt = optind; opt < argc; opt++) {
+  n_jobs = argc - optind;
+  jobs = g_new0(capinfos_job_t, n_jobs);
+  for (opt = 0; opt < n_jobs; opt++)
+    jobs[opt].filename = argv[optind + opt];
+
+#ifdef USE_JOB_THREADS
+  if (n_jobs > 1 && (HASH_THREAD_SAFE || !cap_file_hashes)) {
+    n_threads = g_get_num_processors();
+    if (n_threads > 1)
+      pool = g_thread_pool_new(job_thread, NULL, n_threads, FALSE, NULL);
+  }
+#endif
 
-    g_strlcpy(file_sha256, "<unknown>", HASH_STR_SIZE);
-    g_strlcpy(file_rmd160, "<unknown>", HASH_STR_SIZE);
-    g_strlcpy(file_sha1, "<unknown>", HASH_STR_SIZE);
+  for (opt = 0; opt < n_jobs; opt++) {
+    job = &jobs[opt];
 
-    if (cap_file_hashes) {
-      fh = ws_fopen(argv[opt], "rb");
-      if (fh && hd) {
-        while((hash_bytes = fread(hash_buf, 1, HASH_BUF_SIZE, fh)) > 0) {
-          gcry_md_write(hd, hash_buf, hash_bytes);
-        }
-        gcry_md_final(hd);
-        hash_to_str(gcry_md_read(hd, GCRY_MD_SHA256), HASH_SIZE_SHA256, file_sha256);
-        hash_to_str(gcry_md_read(hd, GCRY_MD_RMD160), HASH_SIZE_RMD160, file_rmd160);
-        hash_to_str(gcry_md_read(hd, GCRY_MD_SHA1), HASH_SIZE_SHA1, file_sha1);
-      }
-      if (fh) fclose(fh);
-      if (hd) gcry_md_reset(hd);
-    }
+#ifdef USE_JOB_THREADS
+    if (pool != NULL) {
+      while (next_job < n_jobs && next_job <= opt + JOBS_AHEAD * n_threads)
+        g_thread_pool_push(pool, &jobs[next_job++], NULL);
 
-    wth = wtap_open_offline(argv[opt], WTAP_TYPE_AUTO, &err, &err_info, FALSE);
+      g_mutex_lock(&jobs_mtx);
+      while (!job->done)
+        g_cond_wait(&jobs_cond, &jobs_mtx);
+      g_mutex_unlock(&jobs_mtx);
+    } else
+#endif
+      run_job(job);
 
-    if (!wth) {
-      cfile_open_failure_message("capinfos", argv[opt], err, err_info);
+    if (!job->wth) {
+      cfile_open_failure_message("capinfos", job->filename, job->err, job->err_info);
       overall_error_status = 2; /* remember that an error has occurred */
       if (!continue_after_wtap_open_offline_failure)
         goto exit;
+      continue;
     }
 
-    if (wth) {
-      if ((opt > optind) && (long_report))
-        printf("\n");
-      status = process_cap_file(wth, argv[opt]);
-
-      wtap_close(wth);
-      if (status) {
-        overall_error_status = status;
-        goto exit;
+    if ((opt > 0) && (long_report))
+      printf("\n");
+    if (job->have_info) {
+      g_strlcpy(file_sha256, job->file_sha256, HASH_STR_SIZE);
+      g_strlcpy(file_rmd160, job->file_rmd160, HASH_STR_SIZE);
+      g_strlcpy(file_sha1, job->file_sha1, HASH_STR_SIZE);
+      if (long_report) {
+        print_stats(job->filename, &job->cf_info);
+      } else {
+        print_stats_table(job->filename, &job->cf_info);
       }
+      cleanup_capture_info(&job->cf_info);
+      job->have_info = FALSE;
+    }
+
+    wtap_close(job->wth);
+    job->wth = NULL;
+    if (job->status) {
+      overall_error_status = job->status;
+      goto exit;
     }
   }
 
 exit:
-  g_free(hash_buf);
+#ifdef USE_JOB_THREADS
+  if (pool != NULL) {
+    /* Don't start any more files, but let the ones being read finish. */
+    g_thread_pool_free(pool, TRUE, TRUE);
+  }
+#endif
+  if (jobs != NULL) {
+    for (opt = 0; opt < n_jobs; opt++) {
+      if (jobs[opt].have_info)
+        cleanup_capture_info(&jobs[opt].cf_info);
+      if (jobs[opt].wth != NULL)
+        wtap_close(jobs[opt].wth);
+    }
+    g_free(jobs);
+  }
   wtap_cleanup();
   free_progdirs();
 #ifdef HAVE_PLUGINS
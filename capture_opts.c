@@ -116,6 +116,7 @@ capture_opts_init(capture_options *capture_opts)
     capture_opts->file_interval                   = 60;               /* 1 min */
     capture_opts->has_ring_num_files              = FALSE;
     capture_opts->ring_num_files                  = RINGBUFFER_MIN_NUM_FILES;
+    capture_opts->ring_compress                   = FALSE;
 
     capture_opts->has_autostop_files              = FALSE;
     capture_opts->autostop_files                  = 1;
@@ -260,6 +261,7 @@ capture_opts_log(const char *log_domain, GLogLevelFlags log_level, capture_optio
     g_log(log_domain, log_level, "FileDuration    (%u) : %u", capture_opts->has_file_duration, capture_opts->file_duration);
     g_log(log_domain, log_level, "FileInterval    (%u) : %u", capture_opts->has_file_interval, capture_opts->file_interval);
     g_log(log_domain, log_level, "RingNumFiles    (%u) : %u", capture_opts->has_ring_num_files, capture_opts->ring_num_files);
+    g_log(log_domain, log_level, "RingCompress        : %u", capture_opts->ring_compress);
 
     g_log(log_domain, log_level, "AutostopFiles   (%u) : %u", capture_opts->has_autostop_files, capture_opts->autostop_files);
     g_log(log_domain, log_level, "AutostopPackets (%u) : %u", capture_opts->has_autostop_packets, capture_opts->autostop_packets);
@@ -417,6 +419,17 @@ get_ring_arguments(capture_options *capture_opts, const char *arg)
     } else if (strcmp(arg,"interval") == 0) {
         capture_opts->has_file_interval = TRUE;
         capture_opts->file_interval = get_positive_int(p, "ring buffer interval");
+    } else if (strcmp(arg,"compress") == 0) {
+#ifdef HAVE_ZLIB
+        if (strcmp(p,"gzip") != 0) {
+            *colonp = ':';
+            return FALSE;
+        }
+        capture_opts->ring_compress = TRUE;
+#else
+        *colonp = ':';
+        return FALSE;
+#endif
     }
 
     *colonp = ':';    /* put the colon back */
@@ -319,6 +319,8 @@ typedef struct capture_options_tag {
     gint32             file_interval;         /**< Create time intervals of n seconds */
     gboolean           has_ring_num_files;    /**< TRUE if ring num_files specified */
     guint32            ring_num_files;        /**< Number of multiple buffer files */
+    gboolean           ring_compress;         /**< TRUE to gzip ring buffer files
+                                                   once they're closed */
 
     /* autostop conditions */
     gboolean           has_autostop_files;    /**< TRUE if maximum number of capture files
@@ -55,6 +55,15 @@ typedef enum {
   SD_BACKWARD
 } search_direction;
 
+/* Running totals over a set of frames, for summary_fill_in() */
+typedef struct {
+  guint32      count;                /* Number of frames */
+  guint32      count_ts;             /* Number of them with time stamps */
+  guint64      bytes;                /* Sum of their packet lengths */
+  nstime_t     start;                /* Earliest time stamp */
+  nstime_t     stop;                 /* Latest time stamp */
+} frame_totals_t;
+
 #ifdef WANT_PACKET_EDITOR
 /* XXX, where this struct should go? */
 typedef struct {
@@ -69,6 +78,8 @@ typedef struct _capture_file {
   gchar       *filename;             /* Name of capture file */
   gchar       *source;               /* Temp file source, e.g. "Pipe from elsewhere" */
   gboolean     is_tempfile;          /* Is capture file a temporary file? */
+  gchar      **merged_filenames;     /* Files opened together as this one, or NULL */
+  gboolean     merged_append;        /* Are they appended rather than merged by time? */
   gboolean     unsaved_changes;      /* Does the capture file have changes that have not been saved? */
   gboolean     stop_flag;            /* Stop current processing (loading, searching, etc.) */
 
@@ -84,6 +95,10 @@ typedef struct _capture_file {
   guint32      marked_count;         /* Number of marked frames */
   guint32      ignored_count;        /* Number of ignored frames */
   guint32      ref_time_count;       /* Number of time referenced frames */
+  frame_totals_t all_totals;         /* Totals over all frames */
+  frame_totals_t filtered_totals;    /* Totals over the frames that passed the display filter */
+  frame_totals_t marked_totals;      /* Totals over the marked frames */
+  gboolean     marked_times_stale;   /* marked_totals.start/stop may be out of date after an unmark */
   gboolean     drops_known;          /* TRUE if we know how many packets were dropped */
   guint32      drops;                /* Dropped packets */
   nstime_t     elapsed_time;         /* Elapsed time */
@@ -93,6 +108,10 @@ typedef struct _capture_file {
   dfilter_t   *dfcode;               /* Compiled display filter program */
   gchar       *dfilter;              /* Display filter string */
   gboolean     redissecting;         /* TRUE if currently redissecting (cf_redissect_packets) */
+  const guint32 *filter_frames;      /* Only frames that can match the next display filter, or NULL */
+  guint32      filter_frames_count;  /* Number of frames in filter_frames */
+  struct _ph_stats_t *ph_stats;      /* Protocol hierarchy counted on the first pass, or NULL */
+  struct _protocol_index *protocol_index; /* Protocols in each frame's first-pass tree, or NULL */
   /* search */
   gchar       *sfilter;              /* Filter, hex value, or string being searched */
   gboolean     hex;                  /* TRUE if "Hex value" search was last selected */
@@ -119,6 +138,7 @@ typedef struct _capture_file {
   frame_data  *current_frame;        /* Frame data for current frame */
   gint         current_row;          /* Row number for current frame */
   epan_dissect_t *edt;               /* Protocol dissection for currently selected packet */
+  struct _edt_cache *edt_cache;      /* Recent dissections, private to file.c */
   field_info  *finfo_selected;       /* Field info for currently selected field */
 #ifdef WANT_PACKET_EDITOR
   GTree       *edited_frames;        /* BST with modified frames */
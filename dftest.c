@@ -34,6 +34,8 @@
 #include <epan/timestamp.h>
 #include <epan/prefs.h>
 #include <epan/dfilter/dfilter.h>
+#include <epan/proto.h>
+#include <epan/tvbuff.h>
 
 #ifdef HAVE_PLUGINS
 #include <wsutil/plugins.h>
@@ -41,6 +43,7 @@
 #include <wsutil/filesystem.h>
 #include <wsutil/privileges.h>
 #include <wsutil/report_message.h>
+#include <wsutil/microbench.h>
 
 #include <wiretap/wtap.h>
 
@@ -52,6 +55,7 @@ static void open_failure_message(const char *filename, int err,
 	gboolean for_writing);
 static void read_failure_message(const char *filename, int err);
 static void write_failure_message(const char *filename, int err);
+static void run_benchmarks(const char *text, dfilter_t *df);
 
 int
 main(int argc, char **argv)
@@ -60,6 +64,8 @@ main(int argc, char **argv)
 	char		*text;
 	dfilter_t	*df;
 	gchar		*err_msg;
+	gboolean	benchmark = FALSE;
+	int		first_arg = 1;
 
 	/*
 	 * Get credential information for later use.
@@ -114,14 +120,21 @@ main(int argc, char **argv)
 	line that its preferences have changed. */
 	prefs_apply_all();
 
+	/* "dftest --benchmark <filter>" times the filter instead of
+	   dumping it */
+	if (argc > 1 && strcmp(argv[1], "--benchmark") == 0) {
+		benchmark = TRUE;
+		first_arg = 2;
+	}
+
 	/* Check for filter on command line */
-	if (argc <= 1) {
-		fprintf(stderr, "Usage: dftest <filter>\n");
+	if (argc <= first_arg) {
+		fprintf(stderr, "Usage: dftest [--benchmark] <filter>\n");
 		exit(1);
 	}
 
 	/* Get filter text */
-	text = get_args_as_string(argc, argv, 1);
+	text = get_args_as_string(argc, argv, first_arg);
 
 	printf("Filter: \"%s\"\n", text);
 
@@ -137,6 +150,8 @@ main(int argc, char **argv)
 
 	if (df == NULL)
 		printf("Filter is empty\n");
+	else if (benchmark)
+		run_benchmarks(text, df);
 	else
 		dfilter_dump(df);
 
@@ -145,6 +160,131 @@ main(int argc, char **argv)
 	exit(0);
 }
 
+/*
+ * The benchmarks apply the filter to a fixed IPv4/TCP packet, whose
+ * fields are added to the tree by hand so that no dissector code is
+ * timed; filter on the fields below to time their comparisons.
+ */
+static const guint8 bench_packet[] = {
+	/* IPv4, 10.1.2.3 -> 10.4.5.6, TCP */
+	0x45, 0x00, 0x05, 0xdc, 0x1c, 0x46, 0x40, 0x00,
+	0x40, 0x06, 0x00, 0x00, 0x0a, 0x01, 0x02, 0x03,
+	0x0a, 0x04, 0x05, 0x06,
+	/* TCP, 1234 -> 80 */
+	0x04, 0xd2, 0x00, 0x50, 0x00, 0x00, 0x00, 0x01,
+	0x00, 0x00, 0x00, 0x00, 0x50, 0x18, 0xfa, 0xf0,
+	0x00, 0x00, 0x00, 0x00
+};
+
+static const struct {
+	const char	*name;
+	gint		 offset;
+	gint		 length;
+} bench_fields[] = {
+	{ "ip",		 0, 20 },
+	{ "ip.len",	 2,  2 },
+	{ "ip.ttl",	 8,  1 },
+	{ "ip.proto",	 9,  1 },
+	{ "ip.src",	12,  4 },
+	{ "ip.addr",	12,  4 },
+	{ "ip.dst",	16,  4 },
+	{ "ip.addr",	16,  4 },
+	{ "tcp",	20, 20 },
+	{ "tcp.srcport", 20, 2 },
+	{ "tcp.port",	20,  2 },
+	{ "tcp.dstport", 22, 2 },
+	{ "tcp.port",	22,  2 },
+	{ "tcp.window_size_value", 34, 2 }
+};
+
+#define BENCH_COMPILES	128
+#define BENCH_APPLIES	10000
+
+typedef struct {
+	const char	*text;
+	dfilter_t	*df;
+	proto_tree	*tree;
+} bench_t;
+
+static void
+bench_compile_cached(gpointer data)
+{
+	bench_t		*b = (bench_t *)data;
+	dfilter_t	*df;
+	int		i;
+
+	for (i = 0; i < BENCH_COMPILES; i++) {
+		dfilter_compile(b->text, &df, NULL);
+		dfilter_free(df);
+	}
+}
+
+/*
+ * Compiled filters are cached by their text, so make each text
+ * different by padding it with up to BENCH_COMPILES - 1 spaces; the cache
+ * drops unused filters long before a padding comes around again.
+ */
+static void
+bench_compile(gpointer data)
+{
+	bench_t		*b = (bench_t *)data;
+	dfilter_t	*df;
+	gchar		*text;
+	int		i;
+
+	for (i = 0; i < BENCH_COMPILES; i++) {
+		text = g_strdup_printf("%s%*s", b->text, i, "");
+		dfilter_compile(text, &df, NULL);
+		dfilter_free(df);
+		g_free(text);
+	}
+}
+
+static void
+bench_apply(gpointer data)
+{
+	bench_t		*b = (bench_t *)data;
+	int		i;
+
+	for (i = 0; i < BENCH_APPLIES; i++)
+		dfilter_apply(b->df, b->tree);
+}
+
+static void
+run_benchmarks(const char *text, dfilter_t *df)
+{
+	bench_t		b;
+	tvbuff_t	*tvb;
+	int		hfid;
+	guint		i;
+
+	b.text = text;
+	b.df = df;
+
+	tvb = tvb_new_real_data(bench_packet, sizeof bench_packet, sizeof bench_packet);
+	b.tree = proto_tree_create_root(NULL);
+	proto_tree_set_visible(b.tree, TRUE);
+	dfilter_prime_proto_tree(df, b.tree);
+	for (i = 0; i < G_N_ELEMENTS(bench_fields); i++) {
+		hfid = proto_registrar_get_id_byname(bench_fields[i].name);
+		if (hfid != -1)
+			proto_tree_add_item(b.tree, hfid, tvb, bench_fields[i].offset,
+			    bench_fields[i].length, ENC_BIG_ENDIAN);
+	}
+
+	printf("Filter %s the sample packet\n\n",
+	    dfilter_apply(df, b.tree) ? "matches" : "doesn't match");
+
+	ws_microbench_header();
+	ws_microbench_run("dfilter_compile", BENCH_COMPILES, bench_compile, &b);
+	ws_microbench_run("dfilter_compile (cached)", BENCH_COMPILES,
+	    bench_compile_cached, &b);
+	ws_microbench_run("dfilter_apply", BENCH_APPLIES, bench_apply, &b);
+
+	proto_tree_free(b.tree);
+	tvb_free(tvb);
+}
+
 /*
  * General errors and warnings are reported with an console message
  * in "dftest".
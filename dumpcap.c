@@ -57,6 +57,7 @@
 #include <wsutil/cmdarg_err.h>
 #include <wsutil/crash_info.h>
 #include <wsutil/strtoi.h>
+#include <wsutil/ws_trace.h>
 #include <version_info.h>
 
 #ifndef HAVE_GETOPT_LONG
@@ -245,6 +246,22 @@ enable_kernel_bpf_jit_compiler(void)
 #define MUST_DO_SELECT
 #endif
 
+#ifdef MUST_DO_SELECT
+/*
+ * How many packets to process per pcap_dispatch() call once select() says
+ * there's something to read.  Without pcap_breakloop() we do one at a time,
+ * so that a signal can stop the capture right away; with it, the signal
+ * handler breaks out of the batch for us, so we take everything libpcap
+ * has already buffered (with TPACKET_V3 that's a whole ring block) rather
+ * than paying for a select() and a pcap_dispatch() per packet.
+ */
+#ifdef HAVE_PCAP_BREAKLOOP
+#define SELECT_DISPATCH_COUNT -1
+#else
+#define SELECT_DISPATCH_COUNT 1
+#endif
+#endif
+
 /** init the capture filter */
 typedef enum {
     INITFILTER_NO_ERROR,
@@ -266,6 +283,32 @@ typedef enum {
     PIPNEXIST
 } cap_pipe_err_t;
 
+/*
+ * The per-flow caps are kept in a fixed-size table per capture source
+ * indexed by the flow hash, with no chaining: a flow that hashes to a slot
+ * used by another one takes the slot over and starts counting from zero.
+ * That keeps the cost per packet constant and the memory bounded no matter
+ * how many flows there are, at the price of occasionally saving a bit more
+ * of a flow than asked for.
+ */
+typedef struct {
+    guint32 hash;                /* 0 if unused */
+    guint32 packets;
+    guint32 bytes;
+} flow_slot;
+
+#define FLOW_SLOTS (1 << 18)
+
+/*
+ * A histogram for --capture-stats: bucket i counts the values that are
+ * less than 2^i but at least 2^(i-1), bucket 0 the zeroes.
+ */
+#define STATS_HIST_BUCKETS 33
+
+typedef struct {
+    guint32 count[STATS_HIST_BUCKETS];
+} stats_hist;
+
 /*
  * A source of packets from which we're capturing.
  */
@@ -297,6 +340,9 @@ typedef struct _capture_src {
     char *                       cap_pipe_databuf;       /**< Pointer to the data buffer we've allocated */
     size_t                       cap_pipe_databuf_size;  /**< Current size of the data buffer */
     guint                        cap_pipe_max_pkt_size;  /**< Maximum packet size allowed */
+    char *                       cap_pipe_rdbuf;         /**< Read-ahead buffer for cap_pipe_read_buffered() */
+    size_t                       cap_pipe_rdbuf_len;     /**< Bytes in cap_pipe_rdbuf */
+    size_t                       cap_pipe_rdbuf_pos;     /**< Bytes of them already handed out */
 #if defined(_WIN32)
     char *                       cap_pipe_buf;           /**< Pointer to the buffer we read into */
     DWORD                        cap_pipe_bytes_to_read; /**< Used by cap_pipe_dispatch */
@@ -308,6 +354,13 @@ typedef struct _capture_src {
     cap_pipe_state_t cap_pipe_state;
     cap_pipe_err_t cap_pipe_err;
 
+    flow_slot                   *flow_slots;             /**< Per-flow counts for --flow-packets/--flow-bytes */
+
+    /* --capture-stats; each is only updated by one thread */
+    stats_hist                   delivery_hist;          /**< Usecs from capture to callback (capture thread) */
+    stats_hist                   queue_hist;             /**< Usecs spent in the packet queue (writer) */
+    stats_hist                   write_hist;             /**< Usecs taken to write a packet (writer) */
+
 #if defined(_WIN32)
     GMutex                      *cap_pipe_read_mtx;
     GAsyncQueue                 *cap_pipe_pending_q, *cap_pipe_done_q;
@@ -333,12 +386,17 @@ typedef struct _loop_data {
     int       save_file_fd;
     guint64   bytes_written;
     guint32   autostop_files;
+    /* --capture-stats */
+    guint64   bytes_flushed;       /**< bytes_written at the last flush */
+    stats_hist flush_hist;         /**< Bytes written between flushes */
+    guint64   stats_time;          /**< When we last reported the stats */
 } loop_data;
 
 typedef struct _pcap_queue_element {
     capture_src        *pcap_src;
     struct pcap_pkthdr  phdr;
     u_char             *pd;
+    guint64             queue_time;   /**< When it was queued, for --capture-stats */
 } pcap_queue_element;
 
 /*
@@ -390,6 +448,23 @@ static gboolean need_timeout_workaround;
 
 #define WRITER_THREAD_TIMEOUT 100000 /* usecs */
 
+#define LONGOPT_HEADERS_ONLY (65536+1)
+#define LONGOPT_FLOW_SAMPLE  (65536+2)
+#define LONGOPT_FLOW_PACKETS (65536+3)
+#define LONGOPT_FLOW_BYTES   (65536+4)
+#define LONGOPT_CAPTURE_STATS (65536+5)
+
+/*
+ * Size of the stdio buffer for the capture file.  pcapio writes each block
+ * as several small fwrite()s, and we only sync the file every
+ * DUMPCAP_UPD_TIME ms (or every packet when writing to a pipe), so a buffer
+ * much bigger than the default BUFSIZ saves a lot of write() calls at high
+ * packet rates.  Only one capture file is open at a time, ring buffer files
+ * are closed before the next one is opened, so one buffer does.
+ */
+#define OUTPUT_BUFFER_SIZE (1024 * 1024)
+static char output_buffer[OUTPUT_BUFFER_SIZE];
+
 static void
 console_log_handler(const char *log_domain, GLogLevelFlags log_level,
                     const char *message, gpointer user_data _U_);
@@ -398,6 +473,11 @@ console_log_handler(const char *log_domain, GLogLevelFlags log_level,
 static capture_options global_capture_opts;
 static gboolean quiet = FALSE;
 static gboolean use_threads = FALSE;
+static gboolean headers_only = FALSE;
+static guint32 flow_sample_rate = 0;     /* save 1 in N flows; 0 saves all */
+static guint32 flow_packet_cap = 0;      /* packets to save per flow; 0 is no cap */
+static guint32 flow_byte_cap = 0;        /* bytes to save per flow; 0 is no cap */
+static guint32 capture_stats_interval = 0; /* seconds between stats reports; 0 is off */
 static guint64 start_time;
 
 static void capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
@@ -469,6 +549,117 @@ create_timestamp(void) {
     return timestamp;
 }
 
+static void
+stats_hist_add(stats_hist *hist, guint64 value)
+{
+    guint bucket = 0;
+
+    while (value != 0 && bucket < STATS_HIST_BUCKETS - 1) {
+        value >>= 1;
+        bucket++;
+    }
+    hist->count[bucket]++;
+}
+
+/* Append the nonzero buckets of a histogram, as "<limit:count" */
+static void
+stats_hist_append(GString *str, const char *name, const stats_hist *hist)
+{
+    guint    i;
+    gboolean first = TRUE;
+
+    g_string_append_printf(str, " %s=[", name);
+    for (i = 0; i < STATS_HIST_BUCKETS; i++) {
+        if (hist->count[i] == 0)
+            continue;
+        g_string_append_printf(str, "%s<%" G_GINT64_MODIFIER "u:%u",
+                               first ? "" : ",",
+                               (guint64)1 << i, hist->count[i]);
+        first = FALSE;
+    }
+    g_string_append_c(str, ']');
+}
+
+/* Time between the kernel time stamping a packet and our seeing it */
+static void
+stats_note_delivery(capture_src *pcap_src, const struct pcap_pkthdr *phdr)
+{
+    guint64 now = create_timestamp();
+    guint64 captured;
+
+    captured = (guint64)phdr->ts.tv_sec * 1000000 +
+               (pcap_src->ts_nsec ? (guint64)phdr->ts.tv_usec / 1000 : (guint64)phdr->ts.tv_usec);
+    stats_hist_add(&pcap_src->delivery_hist, now > captured ? now - captured : 0);
+}
+
+/* We've just synced out the capture file */
+static void
+stats_note_flush(loop_data *ld)
+{
+    if (capture_stats_interval == 0)
+        return;
+    /* bytes_written starts again from 0 with each ring buffer file */
+    if (ld->bytes_written < ld->bytes_flushed)
+        ld->bytes_flushed = 0;
+    if (ld->bytes_written != ld->bytes_flushed)
+        stats_hist_add(&ld->flush_hist, ld->bytes_written - ld->bytes_flushed);
+    ld->bytes_flushed = ld->bytes_written;
+}
+
+/*
+ * Report the --capture-stats counters for each interface.  They're
+ * totals since the start of the capture, so that a capture thread
+ * updating them while we read them costs at most a count.  With pcapng
+ * they go into an interface statistics block in the capture file, with
+ * the histograms in its comment, otherwise on the standard error (unless
+ * that's the sync pipe to our parent).
+ */
+static void
+capture_loop_report_stats(capture_options *capture_opts, loop_data *ld)
+{
+    guint        i;
+    capture_src *pcap_src;
+    guint64      now = create_timestamp();
+    GString     *str = g_string_new("");
+    int          err;
+
+    for (i = 0; i < ld->pcaps->len; i++) {
+        guint64          isb_ifrecv, isb_ifdrop;
+        struct pcap_stat stats;
+
+        pcap_src = g_array_index(ld->pcaps, capture_src *, i);
+        if (!pcap_src->from_cap_pipe && pcap_stats(pcap_src->pcap_h, &stats) >= 0) {
+            isb_ifrecv = pcap_src->received;
+            isb_ifdrop = stats.ps_drop + pcap_src->dropped + pcap_src->flushed;
+        } else {
+            isb_ifrecv = G_MAXUINT64;
+            isb_ifdrop = G_MAXUINT64;
+        }
+
+        g_string_printf(str, "Capture stats provided by dumpcap: received=%u dropped=%u flushed=%u",
+                        pcap_src->received, pcap_src->dropped, pcap_src->flushed);
+        stats_hist_append(str, "delivery_us", &pcap_src->delivery_hist);
+        if (use_threads)
+            stats_hist_append(str, "queue_us", &pcap_src->queue_hist);
+        stats_hist_append(str, "write_us", &pcap_src->write_hist);
+        stats_hist_append(str, "flush_bytes", &ld->flush_hist);
+
+        if (capture_opts->use_pcapng) {
+            if (ld->pdh != NULL &&
+                !pcapng_write_interface_statistics_block(ld->pdh, i, &ld->bytes_written,
+                                                         str->str, start_time, now,
+                                                         isb_ifrecv, isb_ifdrop, &err)) {
+                ld->go = FALSE;
+                ld->err = err;
+            }
+        } else if (!capture_child) {
+            fprintf(stderr, "Interface %u:%s\n", i, str->str + strlen("Capture stats provided by dumpcap:"));
+        }
+    }
+    g_string_free(str, TRUE);
+    ld->stats_time = now;
+}
+
 static void
 print_usage(FILE *output)
 {
@@ -529,6 +720,9 @@ print_usage(FILE *output)
     fprintf(output, "                           interval:NUM - create time intervals of NUM secs\n");
     fprintf(output, "                           filesize:NUM - switch to next file after NUM KB\n");
     fprintf(output, "                              files:NUM - ringbuffer: replace after NUM files\n");
+#ifdef HAVE_ZLIB
+    fprintf(output, "                          compress:gzip - gzip each file once it's closed\n");
+#endif
     fprintf(output, "  -n                       use pcapng format instead of pcap (default)\n");
     fprintf(output, "  -P                       use libpcap format instead of pcapng\n");
     fprintf(output, "  --capture-comment <comment>\n");
@@ -540,6 +734,12 @@ print_usage(FILE *output)
     fprintf(output, "  -C <byte_limit>          maximum number of bytes used for buffering packets\n");
     fprintf(output, "                           within dumpcap\n");
     fprintf(output, "  -t                       use a separate thread per interface\n");
+    fprintf(output, "  --headers-only           only save packet headers, up to and including\n");
+    fprintf(output, "                           TCP/UDP/ICMP (Ethernet, Linux SLL and raw IP)\n");
+    fprintf(output, "  --flow-sample <n>        only save packets of 1 in <n> IP flows\n");
+    fprintf(output, "  --flow-packets <n>       only save the first <n> packets of each IP flow\n");
+    fprintf(output, "  --flow-bytes <kbytes>    only save the first <kbytes> KB of each IP flow\n");
+    fprintf(output, "  --capture-stats <secs>   report latency and drop stats every <secs> seconds\n");
     fprintf(output, "  -q                       don't report packet capture counts\n");
     fprintf(output, "  -v                       print version information and exit\n");
     fprintf(output, "  -h                       display this help and exit\n");
@@ -1266,6 +1466,48 @@ cap_pipe_read(int pipe_fd, char *buf, size_t sz, gboolean from_socket _U_)
 #endif
 }
 
+/*
+ * Fast capture sources write many small records, and reading each
+ * record header and record body with its own read() (and, on UN*X, its
+ * own select()) caps the rate well below what they can deliver.  So
+ * cap_pipe_dispatch() reads the pipe in large blocks into a read-ahead
+ * buffer and takes the records out of that.
+ */
+#define CAP_PIPE_RDBUF_SIZE (1024 * 1024)
+
+/* TRUE if cap_pipe_read_buffered() can return data without reading */
+static gboolean
+cap_pipe_has_buffered_data(const capture_src *pcap_src)
+{
+    return pcap_src->cap_pipe_rdbuf_pos < pcap_src->cap_pipe_rdbuf_len;
+}
+
+/* Like cap_pipe_read(), but served from the read-ahead buffer */
+static ssize_t
+cap_pipe_read_buffered(capture_src *pcap_src, char *buf, size_t sz)
+{
+    ssize_t b;
+    size_t  avail;
+
+    if (!cap_pipe_has_buffered_data(pcap_src)) {
+        if (pcap_src->cap_pipe_rdbuf == NULL)
+            pcap_src->cap_pipe_rdbuf = (char *)g_malloc(CAP_PIPE_RDBUF_SIZE);
+        b = cap_pipe_read(pcap_src->cap_pipe_fd, pcap_src->cap_pipe_rdbuf,
+                          CAP_PIPE_RDBUF_SIZE, pcap_src->from_cap_socket);
+        if (b <= 0)
+            return b;
+        pcap_src->cap_pipe_rdbuf_len = (size_t)b;
+        pcap_src->cap_pipe_rdbuf_pos = 0;
+    }
+
+    avail = pcap_src->cap_pipe_rdbuf_len - pcap_src->cap_pipe_rdbuf_pos;
+    if (avail > sz)
+        avail = sz;
+    memcpy(buf, pcap_src->cap_pipe_rdbuf + pcap_src->cap_pipe_rdbuf_pos, avail);
+    pcap_src->cap_pipe_rdbuf_pos += avail;
+    return (ssize_t)avail;
+}
+
 #if defined(_WIN32)
 /*
  * Thread function that reads from a pipe and pushes the data
@@ -1944,8 +2186,8 @@ cap_pipe_dispatch(loop_data *ld, capture_src *pcap_src, char *errmsg, int errmsg
         if (pcap_src->from_cap_socket)
 #endif
         {
-            b = cap_pipe_read(pcap_src->cap_pipe_fd, ((char *)&pcap_src->cap_pipe_rechdr)+pcap_src->cap_pipe_bytes_read,
-                 pcap_src->cap_pipe_bytes_to_read - pcap_src->cap_pipe_bytes_read, pcap_src->from_cap_socket);
+            b = cap_pipe_read_buffered(pcap_src, ((char *)&pcap_src->cap_pipe_rechdr)+pcap_src->cap_pipe_bytes_read,
+                 pcap_src->cap_pipe_bytes_to_read - pcap_src->cap_pipe_bytes_read);
             if (b <= 0) {
                 if (b == 0)
                     result = PD_PIPE_EOF;
@@ -2003,10 +2245,9 @@ cap_pipe_dispatch(loop_data *ld, capture_src *pcap_src, char *errmsg, int errmsg
         if (pcap_src->from_cap_socket)
 #endif
         {
-            b = cap_pipe_read(pcap_src->cap_pipe_fd,
+            b = cap_pipe_read_buffered(pcap_src,
                               pcap_src->cap_pipe_databuf+pcap_src->cap_pipe_bytes_read,
-                              pcap_src->cap_pipe_bytes_to_read - pcap_src->cap_pipe_bytes_read,
-                              pcap_src->from_cap_socket);
+                              pcap_src->cap_pipe_bytes_to_read - pcap_src->cap_pipe_bytes_read);
             if (b <= 0) {
                 if (b == 0)
                     result = PD_PIPE_EOF;
@@ -2254,8 +2495,18 @@ capture_loop_open_input(capture_options *capture_opts, loop_data *ld,
 #endif
         pcap_src->cap_pipe_bytes_to_read = 0;
         pcap_src->cap_pipe_bytes_read = 0;
+        pcap_src->cap_pipe_rdbuf = NULL;
+        pcap_src->cap_pipe_rdbuf_len = 0;
+        pcap_src->cap_pipe_rdbuf_pos = 0;
         pcap_src->cap_pipe_state = STATE_EXPECT_REC_HDR;
         pcap_src->cap_pipe_err = PIPOK;
+        if (flow_packet_cap != 0 || flow_byte_cap != 0)
+            pcap_src->flow_slots = g_new0(flow_slot, FLOW_SLOTS);
+        else
+            pcap_src->flow_slots = NULL;
+        memset(&pcap_src->delivery_hist, 0, sizeof(stats_hist));
+        memset(&pcap_src->queue_hist, 0, sizeof(stats_hist));
+        memset(&pcap_src->write_hist, 0, sizeof(stats_hist));
 #ifdef _WIN32
 #if GLIB_CHECK_VERSION(2,31,0)
         pcap_src->cap_pipe_read_mtx = g_malloc(sizeof(GMutex));
@@ -2416,6 +2667,9 @@ static void capture_loop_close_input(loop_data *ld)
                 g_free(pcap_src->cap_pipe_databuf);
                 pcap_src->cap_pipe_databuf = NULL;
             }
+            g_free(pcap_src->cap_pipe_rdbuf);
+            pcap_src->cap_pipe_rdbuf = NULL;
+            pcap_src->cap_pipe_rdbuf_len = pcap_src->cap_pipe_rdbuf_pos = 0;
 	} else {
 	    /* Capture device.  If open, close the pcap_t. */
             if (pcap_src->pcap_h != NULL) {
@@ -2424,6 +2678,8 @@ static void capture_loop_close_input(loop_data *ld)
                 pcap_src->pcap_h = NULL;
             }
         }
+        g_free(pcap_src->flow_slots);
+        pcap_src->flow_slots = NULL;
     }
 
     ld->go = FALSE;
@@ -2497,6 +2753,7 @@ capture_loop_init_output(capture_options *capture_opts, loop_data *ld, char *err
         }
     }
     if (ld->pdh) {
+        setvbuf(ld->pdh, output_buffer, _IOFBF, OUTPUT_BUFFER_SIZE);
         if (capture_opts->use_pcapng) {
             char    *appname;
             GString *cpu_info_str;
@@ -2663,7 +2920,11 @@ capture_loop_dispatch(loop_data *ld,
         g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG, "capture_loop_dispatch: from capture pipe");
 #endif
 #ifndef _WIN32
-        sel_ret = cap_pipe_select(pcap_src->cap_pipe_fd);
+        /* Records already read ahead needn't wait for the pipe */
+        if (cap_pipe_has_buffered_data(pcap_src))
+            sel_ret = 1;
+        else
+            sel_ret = cap_pipe_select(pcap_src->cap_pipe_fd);
         if (sel_ret <= 0) {
             if (sel_ret < 0 && errno != EINTR) {
                 g_snprintf(errmsg, errmsg_len,
@@ -2677,6 +2938,9 @@ capture_loop_dispatch(loop_data *ld,
              */
 #endif
             inpkts = cap_pipe_dispatch(ld, pcap_src, errmsg, errmsg_len);
+            /* Take the rest of what was read ahead as a batch */
+            while (inpkts >= 0 && ld->go && cap_pipe_has_buffered_data(pcap_src))
+                inpkts = cap_pipe_dispatch(ld, pcap_src, errmsg, errmsg_len);
             if (inpkts < 0) {
                 ld->go = FALSE;
             }
@@ -2711,15 +2975,13 @@ capture_loop_dispatch(loop_data *ld,
                  * "select()" says we can read from it without blocking; go for
                  * it.
                  *
-                 * We don't have pcap_breakloop(), so we only process one packet
-                 * per pcap_dispatch() call, to allow a signal to stop the
-                 * processing immediately, rather than processing all packets
-                 * in a batch before quitting.
+                 * See SELECT_DISPATCH_COUNT for how many packets we take
+                 * per pcap_dispatch() call.
                  */
                 if (use_threads) {
-                    inpkts = pcap_dispatch(pcap_src->pcap_h, 1, capture_loop_queue_packet_cb, (u_char *)pcap_src);
+                    inpkts = pcap_dispatch(pcap_src->pcap_h, SELECT_DISPATCH_COUNT, capture_loop_queue_packet_cb, (u_char *)pcap_src);
                 } else {
-                    inpkts = pcap_dispatch(pcap_src->pcap_h, 1, capture_loop_write_packet_cb, (u_char *)pcap_src);
+                    inpkts = pcap_dispatch(pcap_src->pcap_h, SELECT_DISPATCH_COUNT, capture_loop_write_packet_cb, (u_char *)pcap_src);
                 }
                 if (inpkts < 0) {
                     if (inpkts == -1) {
@@ -2887,7 +3149,8 @@ capture_loop_open_output(capture_options *capture_opts, int *save_file_fd,
                 /* ringbuffer is enabled */
                 *save_file_fd = ringbuf_init(capfile_name,
                                              (capture_opts->has_ring_num_files) ? capture_opts->ring_num_files : 0,
-                                             capture_opts->group_read_access);
+                                             capture_opts->group_read_access,
+                                             capture_opts->ring_compress);
 
                 /* we need the ringbuf name */
                 if (*save_file_fd != -1) {
@@ -2999,6 +3262,7 @@ do_file_switch_or_stop(capture_options *capture_opts,
                                 &global_ld.save_file_fd, &global_ld.err)) {
 
             /* File switch succeeded: reset the conditions */
+            setvbuf(global_ld.pdh, output_buffer, _IOFBF, OUTPUT_BUFFER_SIZE);
             global_ld.bytes_written = 0;
             if (capture_opts->use_pcapng) {
                 char    *appname;
@@ -3141,6 +3405,8 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
     global_ld.pdh                 = NULL;
     global_ld.autostop_files      = 0;
     global_ld.save_file_fd        = -1;
+    global_ld.bytes_flushed       = 0;
+    memset(&global_ld.flush_hist, 0, sizeof(stats_hist));
 
     /* We haven't yet gotten the capture statistics. */
     *stats_known      = FALSE;
@@ -3249,6 +3515,7 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
     gettimeofday(&upd_time, NULL);
 #endif
     start_time = create_timestamp();
+    global_ld.stats_time = start_time;
     g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO, "Capture loop running.");
     capture_opts_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG, capture_opts);
 
@@ -3294,10 +3561,16 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
                       "Dequeued a packet of length %d captured on interface %d.",
                       queue_element->phdr.caplen, queue_element->pcap_src->interface_id);
 
+                if (capture_stats_interval != 0) {
+                    guint64 now = create_timestamp();
+
+                    stats_hist_add(&queue_element->pcap_src->queue_hist,
+                                   now > queue_element->queue_time ? now - queue_element->queue_time : 0);
+                }
+
                 capture_loop_write_packet_cb((u_char *) queue_element->pcap_src,
                                              &queue_element->phdr,
                                              queue_element->pd);
-                g_free(queue_element->pd);
                 g_free(queue_element);
                 inpkts = 1;
             } else {
@@ -3340,6 +3613,7 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
             } /* cnd_autostop_size */
             if (capture_opts->output_to_pipe) {
                 fflush(global_ld.pdh);
+                stats_note_flush(&global_ld);
             }
         } /* inpkts */
 
@@ -3365,10 +3639,16 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
                 *stats_known = TRUE;
             }
 #endif
+            if (capture_stats_interval != 0 &&
+                create_timestamp() - global_ld.stats_time >= (guint64)capture_stats_interval * 1000000) {
+                capture_loop_report_stats(capture_opts, &global_ld);
+            }
+
             /* Let the parent process know. */
             if (global_ld.inpkts_to_sync_pipe) {
                 /* do sync here */
                 fflush(global_ld.pdh);
+                stats_note_flush(&global_ld);
 
                 /* Send our parent a message saying we've written out
                    "global_ld.inpkts_to_sync_pipe" packets to the capture file. */
@@ -3438,7 +3718,6 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
             capture_loop_write_packet_cb((u_char *)queue_element->pcap_src,
                                          &queue_element->phdr,
                                          queue_element->pd);
-            g_free(queue_element->pd);
             g_free(queue_element);
             global_ld.inpkts_to_sync_pipe += 1;
             if (capture_opts->output_to_pipe) {
@@ -3676,6 +3955,324 @@ capture_loop_get_errmsg(char *errmsg, int errmsglen, const char *fname,
 }
 
 
+/*
+ * Flow sampling for --flow-sample, --flow-packets and --flow-bytes.
+ *
+ * The flow is the innermost IP source and destination address, protocol
+ * and, for TCP and UDP, ports, as found by the header walk below.  Its
+ * hash is the same in both directions, so both halves of a conversation
+ * are kept or dropped together, and it's the same in every dumpcap run,
+ * so sampled captures taken at different points of a network line up.
+ * Non-first IP fragments have no ports and count as a flow of their own.
+ */
+typedef struct {
+    const u_char *src;
+    const u_char *dst;
+    guint         addr_len;      /* 0 if we found no IP header */
+    guint8        proto;
+    guint16       sport;
+    guint16       dport;
+} flow_tuple;
+
+static void
+flow_tuple_set(flow_tuple *ft, const u_char *src, const u_char *dst,
+               guint addr_len, guint8 proto)
+{
+    ft->src = src;
+    ft->dst = dst;
+    ft->addr_len = addr_len;
+    ft->proto = proto;
+    ft->sport = 0;
+    ft->dport = 0;
+}
+
+/* FNV-1a over one endpoint */
+static guint32
+flow_endpoint_hash(const u_char *addr, guint addr_len, guint16 port)
+{
+    guint32 h = 2166136261U;
+    guint   i;
+
+    for (i = 0; i < addr_len; i++)
+        h = (h ^ addr[i]) * 16777619U;
+    h = (h ^ (port >> 8)) * 16777619U;
+    h = (h ^ (port & 0xff)) * 16777619U;
+    return h;
+}
+
+static guint32
+flow_tuple_hash(const flow_tuple *ft)
+{
+    guint32 h;
+
+    /* Adding the endpoint hashes makes the result direction-independent */
+    h = flow_endpoint_hash(ft->src, ft->addr_len, ft->sport) +
+        flow_endpoint_hash(ft->dst, ft->addr_len, ft->dport);
+    h ^= ft->proto;
+    /* Mix, so that the low bits used for sampling and the table are good */
+    h ^= h >> 16;
+    h *= 0x85ebca6bU;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35U;
+    h ^= h >> 16;
+    return h;
+}
+
+/*
+ * Decide whether to save a packet of the flow "ft" with on-the-wire
+ * length "len".  Packets for which we found no flow are always saved.
+ */
+static gboolean
+flow_sample_packet(capture_src *pcap_src, const flow_tuple *ft, guint32 len)
+{
+    guint32    h;
+    flow_slot *slot;
+
+    if (ft->addr_len == 0)
+        return TRUE;
+
+    h = flow_tuple_hash(ft);
+    if (flow_sample_rate > 1 && (h >> 8) % flow_sample_rate != 0)
+        return FALSE;
+
+    if (pcap_src->flow_slots == NULL)
+        return TRUE;
+    slot = &pcap_src->flow_slots[h & (FLOW_SLOTS - 1)];
+    if (h == 0)
+        h = 1;
+    if (slot->hash != h) {
+        slot->hash = h;
+        slot->packets = 0;
+        slot->bytes = 0;
+    }
+    if ((flow_packet_cap != 0 && slot->packets >= flow_packet_cap) ||
+        (flow_byte_cap != 0 && slot->bytes >= flow_byte_cap))
+        return FALSE;
+    slot->packets++;
+    slot->bytes += len;
+    return TRUE;
+}
+
+/*
+ * Header-only truncation for --headers-only.
+ *
+ * These return the offset just past the protocol headers we know about,
+ * starting at "offset", never more than "caplen".  Whatever follows is
+ * payload and doesn't get saved.  This is a quick fixed-offset walk, not
+ * dissection; anything we don't recognize ends the headers.
+ */
+#define HO_GET16(pd, off) ((guint16)(((pd)[off] << 8) | (pd)[(off)+1]))
+#define HO_MIN(a, b)      ((a) < (b) ? (a) : (b))
+#define HO_IP_DEPTH       2        /* outer IP plus one tunnelled IP */
+#define HO_GTPU_PORT      2152
+
+static guint32 headers_only_ip_len(const u_char *pd, guint32 offset, guint32 caplen, int depth,
+                                   flow_tuple *ft);
+
+/* GTPv1-U G-PDU: keep the GTP header and the user's IP headers */
+static guint32
+headers_only_gtpu_len(const u_char *pd, guint32 offset, guint32 caplen, int depth,
+                      flow_tuple *ft)
+{
+    guint32 glen = 8;
+    guint8  next_type;
+    guint32 ext_len;
+
+    if (pd[offset] & 0x07) {
+        /* sequence number, N-PDU number and next extension header type */
+        glen += 4;
+        if (offset + glen > caplen)
+            return caplen;
+        next_type = (pd[offset] & 0x04) ? pd[offset + glen - 1] : 0;
+        while (next_type != 0) {
+            if (offset + glen >= caplen)
+                return caplen;
+            /* length is in 4-octet units; the last octet is the next type */
+            ext_len = pd[offset + glen] * 4;
+            if (ext_len == 0 || offset + glen + ext_len > caplen)
+                return caplen;
+            next_type = pd[offset + glen + ext_len - 1];
+            glen += ext_len;
+        }
+    }
+    if (offset + glen >= caplen)
+        return caplen;
+    return headers_only_ip_len(pd, offset + glen, caplen, depth + 1, ft);
+}
+
+static guint32
+headers_only_l4_len(const u_char *pd, guint32 offset, guint32 caplen,
+                    guint8 proto, int depth, flow_tuple *ft)
+{
+    guint32 hlen;
+
+    if (ft != NULL && (proto == 6 || proto == 17) && offset + 4 <= caplen) {
+        ft->sport = HO_GET16(pd, offset);
+        ft->dport = HO_GET16(pd, offset + 2);
+    }
+
+    switch (proto) {
+    case 6:     /* TCP */
+        if (offset + 13 > caplen)
+            return caplen;
+        hlen = (pd[offset + 12] >> 4) * 4;
+        break;
+    case 17:    /* UDP */
+        hlen = 8;
+        if (offset + hlen + 8 <= caplen &&
+            (HO_GET16(pd, offset) == HO_GTPU_PORT || HO_GET16(pd, offset + 2) == HO_GTPU_PORT) &&
+            (pd[offset + hlen] & 0xf0) == 0x30 && pd[offset + hlen + 1] == 0xff) {
+            return headers_only_gtpu_len(pd, offset + hlen, caplen, depth, ft);
+        }
+        break;
+    case 1:     /* ICMP */
+    case 58:    /* ICMPv6 */
+        hlen = 8;
+        break;
+    case 4:     /* IP in IP */
+    case 41:    /* IPv6 in IP */
+        return headers_only_ip_len(pd, offset, caplen, depth + 1, ft);
+    default:
+        return HO_MIN(offset, caplen);
+    }
+    return HO_MIN(offset + hlen, caplen);
+}
+
+static guint32
+headers_only_ip_len(const u_char *pd, guint32 offset, guint32 caplen, int depth,
+                    flow_tuple *ft)
+{
+    guint32 hlen;
+    guint8  proto;
+
+    if (depth >= HO_IP_DEPTH || offset >= caplen)
+        return HO_MIN(offset, caplen);
+
+    switch (pd[offset] >> 4) {
+    case 4:
+        hlen = (pd[offset] & 0x0f) * 4;
+        if (offset + 20 > caplen || hlen < 20)
+            return caplen;
+        if (ft != NULL)
+            flow_tuple_set(ft, pd + offset + 12, pd + offset + 16, 4, pd[offset + 9]);
+        /* Non-first fragments carry no transport header */
+        if (HO_GET16(pd, offset + 6) & 0x1fff)
+            return HO_MIN(offset + hlen, caplen);
+        proto = pd[offset + 9];
+        break;
+    case 6:
+        hlen = 40;
+        if (offset + hlen > caplen)
+            return caplen;
+        proto = pd[offset + 6];
+        if (ft != NULL)
+            flow_tuple_set(ft, pd + offset + 8, pd + offset + 24, 16, proto);
+        /* hop-by-hop, routing, fragment and destination options headers */
+        while (proto == 0 || proto == 43 || proto == 44 || proto == 60) {
+            guint32 ext = offset + hlen;
+
+            if (ext + 8 > caplen)
+                return caplen;
+            if (proto == 44) {
+                hlen += 8;
+                /* Non-first fragments carry no transport header */
+                if (HO_GET16(pd, ext + 2) & 0xfff8)
+                    return offset + hlen;
+            } else {
+                hlen += (pd[ext + 1] + 1) * 8;
+            }
+            proto = pd[ext];
+        }
+        if (ft != NULL)
+            ft->proto = proto;
+        break;
+    default:
+        return offset;
+    }
+
+    return headers_only_l4_len(pd, offset + hlen, caplen, proto, depth, ft);
+}
+
+/*
+ * Length to save of a packet when only saving headers.  If "ft" isn't
+ * NULL, it's filled in with the addresses, protocol and ports of the
+ * innermost IP header we found.
+ */
+static guint32
+headers_only_caplen(int linktype, const u_char *pd, guint32 caplen, flow_tuple *ft)
+{
+    guint32  offset;
+    guint16  ethertype;
+
+    switch (linktype) {
+    case DLT_EN10MB:
+        offset = 12;
+        if (offset + 2 > caplen)
+            return caplen;
+        ethertype = HO_GET16(pd, offset);
+        /* VLAN tags, including QinQ */
+        while ((ethertype == 0x8100 || ethertype == 0x88a8 || ethertype == 0x9100) &&
+               offset + 6 <= caplen) {
+            offset += 4;
+            ethertype = HO_GET16(pd, offset);
+        }
+        offset += 2;
+        break;
+#ifdef DLT_LINUX_SLL
+    case DLT_LINUX_SLL:
+        offset = 16;
+        if (offset > caplen)
+            return caplen;
+        ethertype = HO_GET16(pd, 14);
+        break;
+#endif
+    case DLT_RAW:
+#ifdef DLT_IPV4
+    case DLT_IPV4:
+#endif
+#ifdef DLT_IPV6
+    case DLT_IPV6:
+#endif
+        return headers_only_ip_len(pd, 0, caplen, 0, ft);
+    default:
+        /* We don't know where the headers end; keep the whole packet */
+        return caplen;
+    }
+
+    switch (ethertype) {
+    case 0x0800:
+    case 0x86dd:
+        return headers_only_ip_len(pd, offset, caplen, 0, ft);
+    default:
+        return HO_MIN(offset, caplen);
+    }
+}
+
+/*
+ * Apply --headers-only and the flow sampling options to a packet; returns
+ * FALSE if the packet isn't to be saved, otherwise sets "*caplen" to the
+ * number of bytes of it to save.
+ */
+static gboolean
+capture_loop_select_packet(capture_src *pcap_src, const struct pcap_pkthdr *phdr,
+                           const u_char *pd, guint32 *caplen)
+{
+    flow_tuple ft;
+    guint32    hlen;
+
+    if (flow_sample_rate <= 1 && pcap_src->flow_slots == NULL) {
+        *caplen = headers_only_caplen(pcap_src->linktype, pd, phdr->caplen, NULL);
+        return TRUE;
+    }
+
+    ft.addr_len = 0;
+    hlen = headers_only_caplen(pcap_src->linktype, pd, phdr->caplen, &ft);
+    if (!flow_sample_packet(pcap_src, &ft, phdr->len))
+        return FALSE;
+    *caplen = headers_only ? hlen : phdr->caplen;
+    return TRUE;
+}
+
 /* one packet was captured, process it */
 static void
 capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
@@ -3684,6 +4281,8 @@ capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
     capture_src *pcap_src = (capture_src *) (void *) pcap_src_p;
     int          err;
     guint        ts_mul    = pcap_src->ts_nsec ? 1000000000 : 1000000;
+    struct pcap_pkthdr select_phdr;
+    guint64      write_start = 0;
 
     /* We may be called multiple times from pcap_dispatch(); if we've set
        the "stop capturing" flag, ignore this packet, as we're not
@@ -3693,12 +4292,28 @@ capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
         return;
     }
 
+    /* When threaded, this was done in the capture thread */
+    if (capture_stats_interval != 0 && !use_threads)
+        stats_note_delivery(pcap_src, phdr);
+
+    /* When threaded, the packet was already selected and cut down before
+       it was queued */
+    if ((headers_only || flow_sample_rate > 1 || pcap_src->flow_slots != NULL) && !use_threads) {
+        select_phdr = *phdr;
+        if (!capture_loop_select_packet(pcap_src, phdr, pd, &select_phdr.caplen))
+            return;
+        phdr = &select_phdr;
+    }
+
     if (global_ld.pdh) {
         gboolean successful;
 
         /* We're supposed to write the packet to a file; do so.
            If this fails, set "ld->go" to FALSE, to stop the capture, and set
            "ld->err" to the error. */
+        WS_TRACE1(capture_write_packet_entry, phdr->caplen);
+        if (capture_stats_interval != 0)
+            write_start = create_timestamp();
         if (global_capture_opts.use_pcapng) {
             successful = pcapng_write_enhanced_packet_block(global_ld.pdh,
                                                             NULL,
@@ -3715,6 +4330,12 @@ capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
                                               pd,
                                               &global_ld.bytes_written, &err);
         }
+        if (capture_stats_interval != 0) {
+            guint64 write_end = create_timestamp();
+
+            stats_hist_add(&pcap_src->write_hist, write_end > write_start ? write_end - write_start : 0);
+        }
+        WS_TRACE1(capture_write_packet_return, successful);
         if (!successful) {
             global_ld.go = FALSE;
             global_ld.err = err;
@@ -3743,6 +4364,7 @@ capture_loop_queue_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
     capture_src        *pcap_src = (capture_src *) (void *) pcap_src_p;
     pcap_queue_element *queue_element;
     gboolean            limit_reached;
+    struct pcap_pkthdr  select_phdr;
 
     /* We may be called multiple times from pcap_dispatch(); if we've set
        the "stop capturing" flag, ignore this packet, as we're not
@@ -3752,25 +4374,25 @@ capture_loop_queue_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
         return;
     }
 
-    queue_element = (pcap_queue_element *)g_malloc(sizeof(pcap_queue_element));
-    if (queue_element == NULL) {
-       pcap_src->dropped++;
-       return;
-    }
-    queue_element->pcap_src = pcap_src;
-    queue_element->phdr = *phdr;
-    queue_element->pd = (u_char *)g_malloc(phdr->caplen);
-    if (queue_element->pd == NULL) {
-        pcap_src->dropped++;
-        g_free(queue_element);
-        return;
+    if (capture_stats_interval != 0)
+        stats_note_delivery(pcap_src, phdr);
+
+    /* Sample and cut the packet down first, so that we never copy what
+       we aren't going to save */
+    if (headers_only || flow_sample_rate > 1 || pcap_src->flow_slots != NULL) {
+        select_phdr = *phdr;
+        if (!capture_loop_select_packet(pcap_src, phdr, pd, &select_phdr.caplen))
+            return;
+        phdr = &select_phdr;
     }
-    memcpy(queue_element->pd, pd, phdr->caplen);
+
+    /* Check the limits and reserve our place in the queue before doing
+       any copying, so that once the writer falls behind, dropping packets
+       costs us next to nothing. */
     g_async_queue_lock(pcap_queue);
     if (((pcap_queue_byte_limit == 0) || (pcap_queue_bytes < pcap_queue_byte_limit)) &&
         ((pcap_queue_packet_limit == 0) || (pcap_queue_packets < pcap_queue_packet_limit))) {
         limit_reached = FALSE;
-        g_async_queue_push_unlocked(pcap_queue, queue_element);
         pcap_queue_bytes += phdr->caplen;
         pcap_queue_packets += 1;
     } else {
@@ -3779,17 +4401,26 @@ capture_loop_queue_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
     g_async_queue_unlock(pcap_queue);
     if (limit_reached) {
         pcap_src->dropped++;
-        g_free(queue_element->pd);
-        g_free(queue_element);
         g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
               "Dropped a packet of length %d captured on interface %u.",
               phdr->caplen, pcap_src->interface_id);
-    } else {
-        pcap_src->received++;
-        g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
-              "Queued a packet of length %d captured on interface %u.",
-              phdr->caplen, pcap_src->interface_id);
+        return;
     }
+
+    /* The packet data follows the element in the same allocation; the
+       writer frees both with one g_free(). */
+    queue_element = (pcap_queue_element *)g_malloc(sizeof(pcap_queue_element) + phdr->caplen);
+    queue_element->pcap_src = pcap_src;
+    queue_element->phdr = *phdr;
+    queue_element->queue_time = capture_stats_interval != 0 ? create_timestamp() : 0;
+    queue_element->pd = (u_char *)(queue_element + 1);
+    memcpy(queue_element->pd, pd, phdr->caplen);
+    g_async_queue_push(pcap_queue, queue_element);
+
+    pcap_src->received++;
+    g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
+          "Queued a packet of length %d captured on interface %u.",
+          phdr->caplen, pcap_src->interface_id);
     /* I don't want to hold the mutex over the debug output. So the
        output may be wrong */
     g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
@@ -3877,6 +4508,11 @@ main(int argc, char *argv[])
     static const struct option long_options[] = {
         {"help", no_argument, NULL, 'h'},
         {"version", no_argument, NULL, 'v'},
+        {"headers-only", no_argument, NULL, LONGOPT_HEADERS_ONLY},
+        {"flow-sample", required_argument, NULL, LONGOPT_FLOW_SAMPLE},
+        {"flow-packets", required_argument, NULL, LONGOPT_FLOW_PACKETS},
+        {"flow-bytes", required_argument, NULL, LONGOPT_FLOW_BYTES},
+        {"capture-stats", required_argument, NULL, LONGOPT_CAPTURE_STATS},
         LONGOPT_CAPTURE_COMMON
         {0, 0, 0, 0 }
     };
@@ -4306,6 +4942,26 @@ main(int argc, char *argv[])
         case 't':
             use_threads = TRUE;
             break;
+        case LONGOPT_HEADERS_ONLY:
+            headers_only = TRUE;
+            break;
+        case LONGOPT_FLOW_SAMPLE:
+            flow_sample_rate = get_nonzero_guint32(optarg, "flow sampling rate");
+            break;
+        case LONGOPT_FLOW_PACKETS:
+            flow_packet_cap = get_nonzero_guint32(optarg, "packets per flow");
+            break;
+        case LONGOPT_FLOW_BYTES:
+            flow_byte_cap = get_nonzero_guint32(optarg, "kilobytes per flow");
+            if (flow_byte_cap > G_MAXUINT32 / 1024) {
+                cmdarg_err("The number of kilobytes per flow %s is too large", optarg);
+                exit_main(1);
+            }
+            flow_byte_cap *= 1024;
+            break;
+        case LONGOPT_CAPTURE_STATS:
+            capture_stats_interval = get_nonzero_guint32(optarg, "capture stats interval");
+            break;
             /*** all non capture option specific ***/
         case 'D':        /* Print a list of capture devices and exit */
             if (!list_interfaces) {
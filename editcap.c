@@ -127,6 +127,17 @@ static fd_hash_t fd_hash[MAX_DUP_DEPTH];
 static int       dup_window    = DEFAULT_DUP_DEPTH;
 static int       cur_dup_entry = 0;
 
+/*
+ * Duplicate frame detection by time window (-w) or over the whole file
+ * (--dup-all) looks the digest up in a hash table rather than comparing
+ * it with every packet in the window.  With -w the entries are also
+ * kept in a queue in the order they were read, so the ones that fall
+ * out of the time window can be dropped again.
+ */
+static GHashTable *dup_hash_table = NULL;   /* newest fd_hash_t for each digest */
+static GQueue      dup_hash_queue = G_QUEUE_INIT;
+static fd_hash_t   cur_dup_hash;            /* the packet last checked */
+
 static guint32   ignored_bytes  = 0;  /* Used with -I */
 
 #define ONE_BILLION 1000000000
@@ -179,9 +190,11 @@ static double                 err_prob                  = 0.0;
 static time_t                 starttime                 = 0;
 static time_t                 stoptime                  = 0;
 static gboolean               check_startstop           = FALSE;
+static gboolean               sorted_input              = FALSE;
 static gboolean               rem_vlan                  = FALSE;
 static gboolean               dup_detect                = FALSE;
 static gboolean               dup_detect_by_time        = FALSE;
+static gboolean               dup_detect_all            = FALSE;
 
 static int                    do_strict_time_adjustment = FALSE;
 static struct time_adjustment strict_time_adj           = {{0, 0}, 0}; /* strict time adjustment */
@@ -626,14 +639,45 @@ is_duplicate(guint8* fd, guint32 len) {
     return FALSE;
 }
 
+static guint
+fd_hash_hash(gconstpointer key)
+{
+    const fd_hash_t *entry = (const fd_hash_t *)key;
+    guint            hash;
+
+    /* The digest is already well mixed. */
+    memcpy(&hash, entry->digest, sizeof hash);
+    return hash ^ entry->len;
+}
+
 static gboolean
-is_duplicate_rel_time(guint8* fd, guint32 len, const nstime_t *current) {
-    int i;
+fd_hash_equal(gconstpointer a, gconstpointer b)
+{
+    const fd_hash_t *entry_a = (const fd_hash_t *)a;
+    const fd_hash_t *entry_b = (const fd_hash_t *)b;
+
+    return entry_a->len == entry_b->len
+        && memcmp(entry_a->digest, entry_b->digest, 16) == 0;
+}
 
+static void
+fd_hash_free(gpointer data)
+{
+    g_slice_free(fd_hash_t, data);
+}
+
+/*
+ * Is this packet a duplicate of one within the time window before it,
+ * or, with --dup-all, of any packet before it?
+ */
+static gboolean
+is_duplicate_rel_time(guint8* fd, guint32 len, const nstime_t *current) {
     /*Hint to ignore some bytes at the start of the frame for the digest calculation(-I option) */
     guint32 offset = ignored_bytes;
     guint32 new_len;
     guint8 *new_fd;
+    fd_hash_t *entry;
+    nstime_t delta;
 
     if (len <= ignored_bytes) {
         offset = 0;
@@ -642,101 +686,81 @@ is_duplicate_rel_time(guint8* fd, guint32 len, const nstime_t *current) {
     new_fd  = &fd[offset];
     new_len = len - (offset);
 
-    cur_dup_entry++;
-    if (cur_dup_entry >= dup_window)
-        cur_dup_entry = 0;
-
     /* Calculate our digest */
-    gcry_md_hash_buffer(GCRY_MD_MD5, fd_hash[cur_dup_entry].digest, new_fd, new_len);
-
-    fd_hash[cur_dup_entry].len = len;
-    fd_hash[cur_dup_entry].frame_time.secs = current->secs;
-    fd_hash[cur_dup_entry].frame_time.nsecs = current->nsecs;
-
-    /*
-     * Look for relative time related duplicates.
-     * This is hopefully a reasonably efficient mechanism for
-     * finding duplicates by rel time in the fd_hash[] cache.
-     * We check starting from the most recently added hash
-     * entries and work backwards towards older packets.
-     * This approach allows the dup test to be terminated
-     * when the relative time of a cached entry is found to
-     * be beyond the dup time window.
-     *
-     * Of course this assumes that the input trace file is
-     * "well-formed" in the sense that the packet timestamps are
-     * in strict chronologically increasing order (which is NOT
-     * always the case!!).
-     *
-     * The fd_hash[] table was deliberately created large (1,000,000).
-     * Looking for time related duplicates in large trace files with
-     * non-fractional dup time window values can potentially take
-     * a long time to complete.
-     */
+    gcry_md_hash_buffer(GCRY_MD_MD5, cur_dup_hash.digest, new_fd, new_len);
 
-    for (i = cur_dup_entry - 1;; i--) {
-        nstime_t delta;
-        int cmp;
+    cur_dup_hash.len = len;
+    if (current != NULL) {
+        cur_dup_hash.frame_time = *current;
+    } else {
+        nstime_set_unset(&cur_dup_hash.frame_time);
+    }
 
-        if (i < 0)
-            i = dup_window - 1;
+    if (dup_hash_table == NULL)
+        dup_hash_table = g_hash_table_new(fd_hash_hash, fd_hash_equal);
 
-        if (i == cur_dup_entry) {
-            /*
-             * We've decremented back to where we started.
-             * Check no more!
-             */
-            break;
-        }
+    if (dup_detect_all) {
+        /* Remember the first packet with each digest for good. */
+        if (g_hash_table_lookup(dup_hash_table, &cur_dup_hash) != NULL)
+            return TRUE;
+        entry = g_slice_dup(fd_hash_t, &cur_dup_hash);
+        g_hash_table_insert(dup_hash_table, entry, entry);
+        return FALSE;
+    }
 
-        if (nstime_is_unset(&(fd_hash[i].frame_time))) {
-            /*
-             * We've decremented to an unused fd_hash[] entry.
-             * Check no more!
-             */
+    /*
+     * Forget the packets that are now beyond the time window.  As
+     * before, this assumes that the packets are in chronological
+     * order; a packet that is earlier than the oldest one we have
+     * doesn't drop anything.
+     */
+    while ((entry = (fd_hash_t *)g_queue_peek_head(&dup_hash_queue)) != NULL) {
+        nstime_delta(&delta, current, &entry->frame_time);
+        if (nstime_cmp(&delta, &relative_time_window) <= 0)
             break;
-        }
+        g_queue_pop_head(&dup_hash_queue);
+        if (g_hash_table_lookup(dup_hash_table, entry) == entry)
+            g_hash_table_remove(dup_hash_table, entry);
+        fd_hash_free(entry);
+    }
 
-        nstime_delta(&delta, current, &fd_hash[i].frame_time);
+    /*
+     * Duplicates count as well, so the table has the most recent packet
+     * with each digest.  If that one has a later time stamp than the
+     * current packet, it is ignored, as it always was.
+     */
+    entry = (fd_hash_t *)g_hash_table_lookup(dup_hash_table, &cur_dup_hash);
+    if (entry != NULL) {
+        nstime_delta(&delta, current, &entry->frame_time);
+        if (delta.secs < 0 || delta.nsecs < 0 ||
+            nstime_cmp(&delta, &relative_time_window) > 0)
+            entry = NULL;
+    }
 
-        if (delta.secs < 0 || delta.nsecs < 0) {
-            /*
-             * A negative delta implies that the current packet
-             * has an absolute timestamp less than the cached packet
-             * that it is being compared to.  This is NOT a normal
-             * situation since trace files usually have packets in
-             * chronological order (oldest to newest).
-             *
-             * There are several possible ways to deal with this:
-             * 1. 'continue' dup checking with the next cached frame.
-             * 2. 'break' from looking for a duplicate of the current frame.
-             * 3. Take the absolute value of the delta and see if that
-             * falls within the specifed dup time window.
-             *
-             * Currently this code does option 1.  But it would pretty
-             * easy to add yet-another-editcap-option to select one of
-             * the other behaviors for dealing with out-of-sequence
-             * packets.
-             */
-            continue;
-        }
+    g_queue_push_tail(&dup_hash_queue, g_slice_dup(fd_hash_t, &cur_dup_hash));
+    g_hash_table_replace(dup_hash_table, g_queue_peek_tail(&dup_hash_queue),
+                         g_queue_peek_tail(&dup_hash_queue));
 
-        cmp = nstime_cmp(&delta, &relative_time_window);
+    return entry != NULL;
+}
 
-        if (cmp > 0) {
-            /*
-             * The delta time indicates that we are now looking at
-             * cached packets beyond the specified dup time window.
-             * Check no more!
-             */
-            break;
-        } else if (fd_hash[i].len == fd_hash[cur_dup_entry].len
-                   && memcmp(fd_hash[i].digest, fd_hash[cur_dup_entry].digest, 16) == 0) {
-            return TRUE;
+static void
+dup_hash_cleanup(void)
+{
+    if (dup_hash_table != NULL) {
+        if (dup_detect_all) {
+            GHashTableIter iter;
+            gpointer       key;
+
+            g_hash_table_iter_init(&iter, dup_hash_table);
+            while (g_hash_table_iter_next(&iter, &key, NULL))
+                fd_hash_free(key);
         }
+        g_hash_table_destroy(dup_hash_table);
+        dup_hash_table = NULL;
     }
-
-    return FALSE;
+    g_queue_foreach(&dup_hash_queue, (GFunc)fd_hash_free, NULL);
+    g_queue_clear(&dup_hash_queue);
 }
 
 static void
@@ -754,6 +778,8 @@ print_usage(FILE *output)
     fprintf(output, "                         to) the given time (format as YYYY-MM-DD hh:mm:ss).\n");
     fprintf(output, "  -B <stop time>         only output packets whose timestamp is before the\n");
     fprintf(output, "                         given time (format as YYYY-MM-DD hh:mm:ss).\n");
+    fprintf(output, "  --sorted               the packets are in time order; stop reading at the\n");
+    fprintf(output, "                         first packet at or after the -B stop time.\n");
     fprintf(output, "\n");
     fprintf(output, "Duplicate packet removal:\n");
     fprintf(output, "  --novlan               remove vlan info from packets before checking for duplicates.\n");
@@ -766,6 +792,7 @@ print_usage(FILE *output)
     fprintf(output, "                         LESS THAN <dup time window> prior to current packet.\n");
     fprintf(output, "                         A <dup time window> is specified in relative seconds\n");
     fprintf(output, "                         (e.g. 0.000001).\n");
+    fprintf(output, "  --dup-all              remove packet if duplicate of any earlier packet.\n");
     fprintf(output, "  -a <framenum>:<comment> Add or replace comment for given frame number\n");
     fprintf(output, "\n");
     fprintf(output, "  -I <bytes to ignore>   ignore the specified number of bytes at the beginning\n");
@@ -966,6 +993,8 @@ main(int argc, char *argv[])
     int           opt;
     static const struct option long_options[] = {
         {"novlan", no_argument, NULL, 0x8100},
+        {"dup-all", no_argument, NULL, 0x8101},
+        {"sorted", no_argument, NULL, 0x8102},
         {"help", no_argument, NULL, 'h'},
         {"version", no_argument, NULL, 'V'},
         {0, 0, 0, 0 }
@@ -1069,6 +1098,20 @@ main(int argc, char *argv[])
             break;
         }
 
+        case 0x8101:
+        {
+            dup_detect = FALSE;
+            dup_detect_by_time = FALSE;
+            dup_detect_all = TRUE;
+            break;
+        }
+
+        case 0x8102:
+        {
+            sorted_input = TRUE;
+            break;
+        }
+
         case 'a':
         {
             guint frame_number;
@@ -1173,12 +1216,14 @@ main(int argc, char *argv[])
         case 'd':
             dup_detect = TRUE;
             dup_detect_by_time = FALSE;
+            dup_detect_all = FALSE;
             dup_window = DEFAULT_DUP_DEPTH;
             break;
 
         case 'D':
             dup_detect = TRUE;
             dup_detect_by_time = FALSE;
+            dup_detect_all = FALSE;
             dup_window = get_guint32(optarg, "duplicate window");
             if (dup_window > MAX_DUP_DEPTH) {
                 fprintf(stderr, "editcap: \"%d\" duplicate window value must be between 0 and %d inclusive.\n",
@@ -1285,7 +1330,7 @@ main(int argc, char *argv[])
         case 'w':
             dup_detect = FALSE;
             dup_detect_by_time = TRUE;
-            dup_window = MAX_DUP_DEPTH;
+            dup_detect_all = FALSE;
             if (!set_rel_time(optarg)) {
                 ret = INVALID_OPTION;
                 goto clean_exit;
@@ -1381,7 +1426,7 @@ main(int argc, char *argv[])
         if (keep_em == FALSE)
             max_packet_number = G_MAXUINT;
 
-        if (dup_detect || dup_detect_by_time) {
+        if (dup_detect) {
             for (i = 0; i < dup_window; i++) {
                 memset(&fd_hash[i].digest, 0, 16);
                 fd_hash[i].len = 0;
@@ -1394,6 +1439,16 @@ main(int argc, char *argv[])
             if (max_packet_number <= read_count)
                 break;
 
+            /*
+             * If the packets are in time order, nothing from here on
+             * can be in the selected timeframe, so don't read the rest
+             * of what may be a very large file.
+             */
+            if (sorted_input && check_startstop &&
+                (wtap_phdr(wth)->presence_flags & WTAP_HAS_TS) &&
+                wtap_phdr(wth)->ts.secs >= stoptime)
+                break;
+
             read_count++;
 
             phdr = wtap_phdr(wth);
@@ -1671,38 +1726,33 @@ main(int argc, char *argv[])
                     }
                 } /* suppression of duplicates */
 
-                if (phdr->presence_flags & WTAP_HAS_TS) {
-                    /* suppress duplicates by time window */
-                    if (dup_detect_by_time) {
-                        nstime_t current;
-
-                        current.secs  = phdr->ts.secs;
-                        current.nsecs = phdr->ts.nsecs;
-
-                        if (is_duplicate_rel_time(buf, phdr->caplen, &current)) {
-                            if (verbose) {
-                                fprintf(stderr, "Skipped: %u, Len: %u, MD5 Hash: ",
-                                        count, phdr->caplen);
-                                for (i = 0; i < 16; i++)
-                                    fprintf(stderr, "%02x",
-                                            (unsigned char)fd_hash[cur_dup_entry].digest[i]);
-                                fprintf(stderr, "\n");
-                            }
-                            duplicate_count++;
-                            count++;
-                            continue;
-                        } else {
-                            if (verbose) {
-                                fprintf(stderr, "Packet: %u, Len: %u, MD5 Hash: ",
-                                        count, phdr->caplen);
-                                for (i = 0; i < 16; i++)
-                                    fprintf(stderr, "%02x",
-                                            (unsigned char)fd_hash[cur_dup_entry].digest[i]);
-                                fprintf(stderr, "\n");
-                            }
+                /* suppress duplicates by time window or over the whole file */
+                if ((dup_detect_by_time && (phdr->presence_flags & WTAP_HAS_TS)) ||
+                    dup_detect_all) {
+                    if (is_duplicate_rel_time(buf, phdr->caplen,
+                                              dup_detect_by_time ? &phdr->ts : NULL)) {
+                        if (verbose) {
+                            fprintf(stderr, "Skipped: %u, Len: %u, MD5 Hash: ",
+                                    count, phdr->caplen);
+                            for (i = 0; i < 16; i++)
+                                fprintf(stderr, "%02x",
+                                        (unsigned char)cur_dup_hash.digest[i]);
+                            fprintf(stderr, "\n");
+                        }
+                        duplicate_count++;
+                        count++;
+                        continue;
+                    } else {
+                        if (verbose) {
+                            fprintf(stderr, "Packet: %u, Len: %u, MD5 Hash: ",
+                                    count, phdr->caplen);
+                            for (i = 0; i < 16; i++)
+                                fprintf(stderr, "%02x",
+                                        (unsigned char)cur_dup_hash.digest[i]);
+                            fprintf(stderr, "\n");
                         }
                     }
-                } /* suppress duplicates by time window */
+                } /* suppress duplicates by time window or over the whole file */
 
                 if (change_offset > phdr->caplen) {
                     fprintf(stderr, "change offset %u is longer than caplen %u in packet %u\n",
@@ -1844,9 +1894,14 @@ main(int argc, char *argv[])
                 plurality(duplicate_count, "", "s"),
                 (long)relative_time_window.secs,
                 (long int)relative_time_window.nsecs);
+    } else if (dup_detect_all) {
+        fprintf(stderr, "%u packet%s seen, %u packet%s skipped as duplicates of earlier packets.\n",
+                count - 1, plurality(count - 1, "", "s"), duplicate_count,
+                plurality(duplicate_count, "", "s"));
     }
 
 clean_exit:
+    dup_hash_cleanup();
     wtap_block_array_free(shb_hdrs);
     wtap_block_array_free(nrb_hdrs);
     g_free(idb_inf);
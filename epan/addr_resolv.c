@@ -31,6 +31,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <time.h>
 
 #include <wsutil/strtoi.h>
 
@@ -111,6 +112,7 @@
 #include <epan/prefs.h>
 
 #define ENAME_HOSTS     "hosts"
+#define ENAME_DNS_CACHE "dns_cache"
 #define ENAME_SUBNETS   "subnets"
 #define ENAME_ETHERS    "ethers"
 #define ENAME_IPXNETS   "ipxnets"
@@ -247,6 +249,16 @@ static wmem_map_t *eth_hashtable = NULL;
 static wmem_map_t *serv_port_hashtable = NULL;
 static GHashTable *enterprises_hashtable = NULL;
 
+/*
+ * The manuf/wka, services and enterprises files are large, and many
+ * processes never look anything up in them (e.g. tshark -n, or with
+ * no fields that need them). The tables are created at startup, but
+ * the files are only read the first time a table is consulted.
+ */
+static gboolean ethers_loaded = FALSE;
+static gboolean services_loaded = FALSE;
+static gboolean enterprises_loaded = FALSE;
+
 static subnet_length_entry_t subnet_length_entries[SUBNETLENGTHSIZE]; /* Ordered array of entries */
 static gboolean have_subnet_entry = FALSE;
 
@@ -256,6 +268,13 @@ static GPtrArray* extra_hosts_files = NULL;
 
 static hashether_t *add_eth_name(const guint8 *addr, const gchar *name);
 static void add_serv_port_cb(const guint32 port, gpointer ptr);
+static void load_ethers(void);
+static void load_services(void);
+static void load_enterprises(void);
+
+#define ENSURE_ETHERS_LOADED()      do { if (!ethers_loaded) load_ethers(); } while (0)
+#define ENSURE_SERVICES_LOADED()    do { if (!services_loaded) load_services(); } while (0)
+#define ENSURE_ENTERPRISES_LOADED() do { if (!enterprises_loaded) load_enterprises(); } while (0)
 
 
 /* http://eternallyconfuzzled.com/tuts/algorithms/jsw_tut_hashing.aspx#existing
@@ -308,6 +327,8 @@ e_addr_resolve gbl_resolv_flags = {
 };
 #ifdef HAVE_C_ARES
 static guint name_resolve_concurrency = 500;
+static gboolean name_resolve_cache = FALSE;
+static guint name_resolve_cache_ttl = 24; /* hours */
 #endif
 
 /*
@@ -581,6 +602,8 @@ _serv_name_lookup(port_type proto, guint port, serv_port_t **value_ret)
 {
     serv_port_t *serv_port_table;
 
+    ENSURE_SERVICES_LOADED();
+
     serv_port_table = (serv_port_t *)wmem_map_lookup(serv_port_hashtable, &port);
 
     if (value_ret != NULL)
@@ -637,9 +660,17 @@ serv_name_lookup(port_type proto, guint port)
 static void
 initialize_services(void)
 {
-    gboolean parse_file = TRUE;
     g_assert(serv_port_hashtable == NULL);
     serv_port_hashtable = wmem_map_new(wmem_epan_scope(), g_int_hash, g_int_equal);
+    services_loaded = FALSE;
+}
+
+static void
+load_services(void)
+{
+    gboolean parse_file = TRUE;
+
+    services_loaded = TRUE;
 
     /* Compute the pathname of the services file. */
     if (g_services_path == NULL) {
@@ -667,6 +698,7 @@ static void
 service_name_lookup_cleanup(void)
 {
     serv_port_hashtable = NULL;
+    services_loaded = FALSE;
     g_free(g_services_path);
     g_services_path = NULL;
     g_free(g_pservices_path);
@@ -719,21 +751,30 @@ initialize_enterprises(void)
 {
     g_assert(enterprises_hashtable == NULL);
     enterprises_hashtable = g_hash_table_new_full(NULL, NULL, NULL, g_free);
+    enterprises_loaded = FALSE;
 
     if (g_enterprises_path == NULL) {
         g_enterprises_path = get_datafile_path(ENAME_ENTERPRISES);
     }
-    parse_enterprises_file(g_enterprises_path);
-
     if (g_penterprises_path == NULL) {
         g_penterprises_path = get_persconffile_path(ENAME_ENTERPRISES, FALSE);
     }
+}
+
+static void
+load_enterprises(void)
+{
+    enterprises_loaded = TRUE;
+
+    parse_enterprises_file(g_enterprises_path);
     parse_enterprises_file(g_penterprises_path);
 }
 
 const gchar *
 try_enterprises_lookup(guint32 value)
 {
+    ENSURE_ENTERPRISES_LOADED();
+
     return (const gchar *)g_hash_table_lookup(enterprises_hashtable, GUINT_TO_POINTER(value));
 }
 
@@ -766,6 +807,7 @@ enterprises_cleanup(void)
     g_assert(enterprises_hashtable);
     g_hash_table_destroy(enterprises_hashtable);
     enterprises_hashtable = NULL;
+    enterprises_loaded = FALSE;
     g_assert(g_enterprises_path);
     g_free(g_enterprises_path);
     g_enterprises_path = NULL;
@@ -832,6 +874,149 @@ fill_dummy_ip6(hashipv6_t* volatile tp)
 
 #ifdef HAVE_C_ARES
 
+/*
+ * Persistent cache of names obtained from the external resolver, so that
+ * opening another capture (or the same one again) in a later session does
+ * not repeat all the queries. The file is in the personal configuration
+ * directory, shared between profiles, one "address name expiry" line per
+ * entry, where expiry is in seconds since the Epoch.
+ */
+typedef struct _dns_cache_entry {
+    gchar  *name;
+    time_t  expires;
+} dns_cache_entry_t;
+
+static GHashTable *dns_cache_table = NULL;  /* printable address -> dns_cache_entry_t */
+static gboolean    dns_cache_dirty = FALSE;
+
+static void
+dns_cache_entry_free(gpointer data)
+{
+    dns_cache_entry_t *entry = (dns_cache_entry_t *)data;
+
+    g_free(entry->name);
+    g_free(entry);
+}
+
+static void
+dns_cache_insert(const char *addr_str, const char *name, time_t expires)
+{
+    dns_cache_entry_t *entry = g_new(dns_cache_entry_t, 1);
+
+    entry->name = g_strdup(name);
+    entry->expires = expires;
+    g_hash_table_replace(dns_cache_table, g_strdup(addr_str), entry);
+}
+
+/* Load the cache the first time the external resolver is about to be used. */
+static void
+dns_cache_load(void)
+{
+    char *path;
+    FILE *cf;
+    char *line = NULL;
+    int size = 0;
+    time_t now;
+
+    if (dns_cache_table != NULL || !name_resolve_cache)
+        return;
+
+    dns_cache_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, dns_cache_entry_free);
+
+    path = get_persconffile_path(ENAME_DNS_CACHE, FALSE);
+    cf = ws_fopen(path, "r");
+    g_free(path);
+    if (cf == NULL)
+        return;
+
+    now = time(NULL);
+    while (fgetline(&line, &size, cf) >= 0) {
+        gchar *addr_str, *name, *expires_str;
+        union {
+            guint32 ip4_addr;
+            struct e_in6_addr ip6_addr;
+        } host_addr;
+        gint64 expires;
+
+        if ((addr_str = strtok(line, " \t")) == NULL ||
+            (name = strtok(NULL, " \t")) == NULL ||
+            (expires_str = strtok(NULL, " \t")) == NULL)
+            continue;
+
+        if (!ws_strtoi64(expires_str, NULL, &expires) || expires <= (gint64)now)
+            continue; /* stale entries are dropped on the next save */
+
+        if (ws_inet_pton6(addr_str, &host_addr.ip6_addr)) {
+            add_ipv6_name(&host_addr.ip6_addr, name);
+        } else if (ws_inet_pton4(addr_str, &host_addr.ip4_addr)) {
+            add_ipv4_name(host_addr.ip4_addr, name);
+        } else {
+            continue;
+        }
+        dns_cache_insert(addr_str, name, (time_t)expires);
+    }
+    wmem_free(wmem_epan_scope(), line);
+    fclose(cf);
+}
+
+static void
+dns_cache_add(const async_dns_queue_msg_t *caqm, const char *name)
+{
+    char addr_str[WS_INET6_ADDRSTRLEN];
+
+    if (dns_cache_table == NULL || !name || name[0] == '\0')
+        return;
+
+    if (caqm->family == AF_INET)
+        ws_inet_ntop4(&caqm->addr.ip4, addr_str, sizeof(addr_str));
+    else
+        ws_inet_ntop6(&caqm->addr.ip6, addr_str, sizeof(addr_str));
+
+    dns_cache_insert(addr_str, name, time(NULL) + (time_t)name_resolve_cache_ttl * 3600);
+    dns_cache_dirty = TRUE;
+}
+
+static void
+dns_cache_save(void)
+{
+    char *pf_dir_path;
+    char *path;
+    FILE *cf;
+    GHashTableIter iter;
+    gpointer key, value;
+    time_t now;
+
+    if (dns_cache_table == NULL)
+        return;
+
+    if (dns_cache_dirty && create_persconffile_dir(&pf_dir_path) == -1) {
+        report_open_failure(pf_dir_path, errno, TRUE);
+        g_free(pf_dir_path);
+    } else if (dns_cache_dirty) {
+        path = get_persconffile_path(ENAME_DNS_CACHE, FALSE);
+        if ((cf = ws_fopen(path, "w")) != NULL) {
+            now = time(NULL);
+            fputs("# Names resolved by Wireshark's external resolver: address name expiry.\n", cf);
+            g_hash_table_iter_init(&iter, dns_cache_table);
+            while (g_hash_table_iter_next(&iter, &key, &value)) {
+                dns_cache_entry_t *entry = (dns_cache_entry_t *)value;
+
+                if (entry->expires > now)
+                    fprintf(cf, "%s %s %" G_GINT64_FORMAT "\n",
+                            (const char *)key, entry->name, (gint64)entry->expires);
+            }
+            fclose(cf);
+        } else {
+            report_open_failure(path, errno, TRUE);
+        }
+        g_free(path);
+    }
+
+    g_hash_table_destroy(dns_cache_table);
+    dns_cache_table = NULL;
+    dns_cache_dirty = FALSE;
+}
+
 static void
 c_ares_ghba_cb(void *arg, int status, int timeouts _U_, struct hostent *he) {
     async_dns_queue_msg_t *caqm = (async_dns_queue_msg_t *)arg;
@@ -842,6 +1027,7 @@ c_ares_ghba_cb(void *arg, int status, int timeouts _U_, struct hostent *he) {
     async_dns_in_flight--;
 
     if (status == ARES_SUCCESS) {
+        dns_cache_add(caqm, he->h_name);
         for (p = he->h_addr_list; *p != NULL; p++) {
             switch(caqm->family) {
                 case AF_INET:
@@ -877,6 +1063,11 @@ host_lookup(const guint addr)
 {
     hashipv4_t * volatile tp;
 
+#ifdef HAVE_C_ARES
+    if (gbl_resolv_flags.network_name && gbl_resolv_flags.use_external_net_name_resolver)
+        dns_cache_load();
+#endif
+
     tp = (hashipv4_t *)wmem_map_lookup(ipv4_hash_table, GUINT_TO_POINTER(addr));
     if (tp == NULL) {
         /*
@@ -931,6 +1122,9 @@ host_lookup6(const struct e_in6_addr *addr)
     hashipv6_t * volatile tp;
 #ifdef HAVE_C_ARES
     async_dns_queue_msg_t *caqm;
+
+    if (gbl_resolv_flags.network_name && gbl_resolv_flags.use_external_net_name_resolver)
+        dns_cache_load();
 #endif
 
     tp = (hashipv6_t *)wmem_map_lookup(ipv6_hash_table, addr);
@@ -1289,6 +1483,8 @@ manuf_name_lookup(const guint8 *addr)
     guint8       oct;
     hashmanuf_t  *manuf_value;
 
+    ENSURE_ETHERS_LOADED();
+
     /* manuf needs only the 3 most significant octets of the ethernet address */
     manuf_key = addr[0];
     manuf_key = manuf_key<<8;
@@ -1334,6 +1530,8 @@ wka_name_lookup(const guint8 *addr, const unsigned int mask)
     if (wka_hashtable == NULL) {
         return NULL;
     }
+    ENSURE_ETHERS_LOADED();
+
     /* Get the part of the address covered by the mask. */
     for (i = 0, num = mask; num >= 8; i++, num -= 8)
         masked_addr[i] = addr[i];   /* copy octets entirely covered by the mask */
@@ -1381,9 +1579,6 @@ eth_addr_cmp(gconstpointer a, gconstpointer b)
 static void
 initialize_ethers(void)
 {
-    ether_t *eth;
-    guint    mask = 0;
-
     /* hash table initialization */
     wka_hashtable   = wmem_map_new(wmem_epan_scope(), eth_addr_hash, eth_addr_cmp);
     manuf_hashtable = wmem_map_new(wmem_epan_scope(), g_int_hash, g_int_equal);
@@ -1404,29 +1599,42 @@ initialize_ethers(void)
     if (g_manuf_path == NULL)
         g_manuf_path = get_datafile_path(ENAME_MANUF);
 
-    /* Read it and initialize the hash table */
+    /* Compute the pathname of the wka file */
+    if (g_wka_path == NULL)
+        g_wka_path = get_datafile_path(ENAME_WKA);
+
+    ethers_loaded = FALSE;
+} /* initialize_ethers */
+
+static void
+load_ethers(void)
+{
+    ether_t *eth;
+    guint    mask = 0;
+
+    /* Set first, since adding mask 48 entries goes through add_eth_name() */
+    ethers_loaded = TRUE;
+
+    /* Read the manuf file and initialize the hash tables */
     set_ethent(g_manuf_path);
     while ((eth = get_ethent(&mask, TRUE))) {
         add_manuf_name(eth->addr, mask, eth->name, eth->longname);
     }
     end_ethent();
 
-    /* Compute the pathname of the wka file */
-    if (g_wka_path == NULL)
-        g_wka_path = get_datafile_path(ENAME_WKA);
-
-    /* Read it and initialize the hash table */
+    /* Read the wka file and initialize the hash table */
     set_ethent(g_wka_path);
     while ((eth = get_ethent(&mask, TRUE))) {
         add_manuf_name(eth->addr, mask, eth->name, eth->longname);
     }
     end_ethent();
 
-} /* initialize_ethers */
+} /* load_ethers */
 
 static void
 ethers_cleanup(void)
 {
+    ethers_loaded = FALSE;
     g_free(g_ethers_path);
     g_ethers_path = NULL;
     g_free(g_pethers_path);
@@ -1571,6 +1779,8 @@ add_eth_name(const guint8 *addr, const gchar *name)
 {
     hashether_t *tp;
 
+    ENSURE_ETHERS_LOADED();
+
     tp = (hashether_t *)wmem_map_lookup(eth_hashtable, addr);
 
     if (tp == NULL) {
@@ -1591,6 +1801,8 @@ eth_name_lookup(const guint8 *addr, const gboolean resolve)
 {
     hashether_t  *tp;
 
+    ENSURE_ETHERS_LOADED();
+
     tp = (hashether_t *)wmem_map_lookup(eth_hashtable, addr);
 
     if (tp == NULL) {
@@ -2484,6 +2696,20 @@ addr_resolve_pref_init(module_t *nameres)
             " your DNS server behave badly.",
             10,
             &name_resolve_concurrency);
+
+    prefs_register_bool_preference(nameres, "name_resolve_cache",
+            "Keep resolved names between sessions",
+            "Save the names returned by the external resolver in the"
+            " personal \"dns_cache\" file and reuse them in later"
+            " sessions instead of querying them again.",
+            &name_resolve_cache);
+
+    prefs_register_uint_preference(nameres, "name_resolve_cache_ttl",
+            "Cached name lifetime (hours)",
+            "How long a name saved in the \"dns_cache\" file is used"
+            " before it is looked up again.",
+            10,
+            &name_resolve_cache_ttl);
 #else
     prefs_register_static_text_preference(nameres, "use_external_name_resolver",
             "Use an external network name resolver: N/A",
@@ -2542,7 +2768,7 @@ host_name_lookup_process(void) {
 
     head = wmem_list_head(async_dns_queue_head);
 
-    while (head != NULL && async_dns_in_flight <= name_resolve_concurrency) {
+    while (head != NULL && async_dns_in_flight < name_resolve_concurrency) {
         caqm = (async_dns_queue_msg_t *)wmem_list_frame_data(head);
         wmem_list_remove_frame(async_dns_queue_head, head);
         if (caqm->family == AF_INET) {
@@ -2577,6 +2803,8 @@ static void
 _host_name_lookup_cleanup(void) {
     async_dns_queue_head = NULL;
 
+    dns_cache_save();
+
     if (async_dns_initialized) {
         ares_destroy(ghba_chan);
         ares_destroy(ghbn_chan);
@@ -3045,6 +3273,8 @@ get_manuf_name_if_known(const guint8 *addr)
     oct = addr[2];
     manuf_key = manuf_key | oct;
 
+    ENSURE_ETHERS_LOADED();
+
     manuf_value = (hashmanuf_t *)wmem_map_lookup(manuf_hashtable, &manuf_key);
     if ((manuf_value == NULL) || (manuf_value->status == HASHETHER_STATUS_UNRESOLVED)) {
         return NULL;
@@ -3059,6 +3289,8 @@ uint_get_manuf_name_if_known(const guint manuf_key)
 {
     hashmanuf_t *manuf_value;
 
+    ENSURE_ETHERS_LOADED();
+
     manuf_value = (hashmanuf_t *)wmem_map_lookup(manuf_hashtable, &manuf_key);
     if ((manuf_value == NULL) || (manuf_value->status == HASHETHER_STATUS_UNRESOLVED)) {
         return NULL;
@@ -3251,24 +3483,28 @@ get_host_ipaddr6(const char *host, struct e_in6_addr *addrp)
 wmem_map_t *
 get_manuf_hashtable(void)
 {
+    ENSURE_ETHERS_LOADED();
     return manuf_hashtable;
 }
 
 wmem_map_t *
 get_wka_hashtable(void)
 {
+    ENSURE_ETHERS_LOADED();
     return wka_hashtable;
 }
 
 wmem_map_t *
 get_eth_hashtable(void)
 {
+    ENSURE_ETHERS_LOADED();
     return eth_hashtable;
 }
 
 wmem_map_t *
 get_serv_port_hashtable(void)
 {
+    ENSURE_SERVICES_LOADED();
     return serv_port_hashtable;
 }
 
@@ -27,6 +27,7 @@
 #include "config.h"
 
 #include <stdio.h>
+#include <string.h>
 
 #include <glib.h>
 
@@ -46,6 +47,7 @@
 #include "app_mem_usage.h"
 
 #define MAX_COMPONENTS 16
+#define MAX_ALLOCATORS 16
 
 #if defined(_WIN32)
 static gsize
@@ -178,6 +180,15 @@ static guint memory_register_num = 0
 #endif
 	;
 
+typedef struct {
+	const char *name;
+	wmem_allocator_t *allocator;
+} allocator_usage_t;
+
+static allocator_usage_t memory_allocators[MAX_ALLOCATORS];
+
+static guint memory_allocator_num = 0;
+
 /* public API */
 
 void
@@ -189,16 +200,51 @@ memory_usage_component_register(const ws_mem_usage_t *component)
 	memory_components[memory_register_num++] = component;
 }
 
+void
+memory_usage_allocator_register(const char *name, wmem_allocator_t *allocator)
+{
+	if (memory_allocator_num >= MAX_ALLOCATORS)
+		return;
+
+	memory_allocators[memory_allocator_num].name = name;
+	memory_allocators[memory_allocator_num].allocator = allocator;
+	memory_allocator_num++;
+}
+
+void
+memory_usage_allocator_unregister(wmem_allocator_t *allocator)
+{
+	guint i;
+
+	for (i = 0; i < memory_allocator_num; i++) {
+		if (memory_allocators[i].allocator == allocator) {
+			/* keep the order, the GUI graphs are by index */
+			memmove(&memory_allocators[i], &memory_allocators[i + 1],
+				(memory_allocator_num - i - 1) * sizeof(memory_allocators[0]));
+			memory_allocator_num--;
+			return;
+		}
+	}
+}
+
 const char *
 memory_usage_get(guint idx, gsize *value)
 {
-	if (idx >= memory_register_num)
+	if (idx < memory_register_num) {
+		if (value)
+			*value = memory_components[idx]->fetch();
+
+		return memory_components[idx]->name;
+	}
+
+	idx -= memory_register_num;
+	if (idx >= memory_allocator_num)
 		return NULL;
 
 	if (value)
-		*value = memory_components[idx]->fetch();
+		*value = wmem_allocator_footprint(memory_allocators[idx].allocator);
 
-	return memory_components[idx]->name;
+	return memory_allocators[idx].name;
 }
 
 void
@@ -210,6 +256,9 @@ memory_usage_gc(void)
 		if (memory_components[i]->gc)
 			memory_components[i]->gc();
 	}
+
+	for (i = 0; i < memory_allocator_num; i++)
+		wmem_gc(memory_allocators[i].allocator);
 }
 
 
@@ -24,6 +24,8 @@
 
 #include "ws_symbol_export.h"
 
+#include <epan/wmem/wmem.h>
+
 typedef struct {
 	const char *name;
 	gsize (*fetch)(void);
@@ -33,8 +35,17 @@ typedef struct {
 
 WS_DLL_PUBLIC void memory_usage_component_register(const ws_mem_usage_t *component);
 
+/* Report the footprint of a wmem pool under the name of its owner, e.g.
+ * a subsystem or a protocol with a pool of its own. The name isn't copied.
+ * A pool that's destroyed before the end of the program must be
+ * unregistered first. */
+WS_DLL_PUBLIC void memory_usage_allocator_register(const char *name, wmem_allocator_t *allocator);
+
+WS_DLL_PUBLIC void memory_usage_allocator_unregister(wmem_allocator_t *allocator);
+
 WS_DLL_PUBLIC void memory_usage_gc(void);
 
+/* Components come first, then pools, in the order they were registered */
 WS_DLL_PUBLIC const char *memory_usage_get(guint idx, gsize *value);
 
 #endif /* APP_MEM_USAGE_H */
@@ -22,6 +22,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <glib.h>
 
 #include <epan/proto.h>
@@ -62,6 +64,28 @@
  *    http://www-03.ibm.com/systems/i/software/globalization/codepages.html
  */
 
+/*
+ * Return how many of the length bytes at ptr are ASCII before the first
+ * one with the high-order bit set, testing eight bytes at a time.  The
+ * ASCII bytes of most encodings are the same in UTF-8, so they can be
+ * copied as they are.
+ */
+static gint
+ascii_prefix_length(const guint8 *ptr, gint length)
+{
+    guint64 word;
+    gint    i = 0;
+
+    for (; i + 8 <= length; i += 8) {
+        memcpy(&word, ptr + i, sizeof word);
+        if (word & G_GUINT64_CONSTANT(0x8080808080808080))
+            break;
+    }
+    while (i < length && ptr[i] < 0x80)
+        i++;
+    return i;
+}
+
 /*
  * Given a wmem scope, a pointer, and a length, treat the string of bytes
  * referred to by the pointer and length as an ASCII string, with all bytes
@@ -74,22 +98,34 @@
 guint8 *
 get_ascii_string(wmem_allocator_t *scope, const guint8 *ptr, gint length)
 {
-    wmem_strbuf_t *str;
+    guint8 *str, *out;
+    gint    ascii_length;
 
-    str = wmem_strbuf_sized_new(scope, length+1, 0);
+    ascii_length = ascii_prefix_length(ptr, length);
+
+    /* Each invalid octet takes the 3 bytes of a REPLACEMENT CHARACTER */
+    str = (guint8 *)wmem_alloc(scope, ascii_length + (length - ascii_length) * 3 + 1);
+    memcpy(str, ptr, ascii_length);
+    out = str + ascii_length;
+    ptr += ascii_length;
+    length -= ascii_length;
 
     while (length > 0) {
         guint8 ch = *ptr;
 
-        if (ch < 0x80)
-            wmem_strbuf_append_c(str, ch);
-        else
-            wmem_strbuf_append_unichar(str, UNREPL);
+        if (ch < 0x80) {
+            *out++ = ch;
+        } else {
+            *out++ = 0xEF;
+            *out++ = 0xBF;
+            *out++ = 0xBD;
+        }
         ptr++;
         length--;
     }
+    *out = '\0';
 
-    return (guint8 *) wmem_strbuf_finalize(str);
+    return str;
 }
 
 /*
@@ -100,29 +136,39 @@ get_ascii_string(wmem_allocator_t *scope, const guint8 *ptr, gint length)
 guint8 *
 get_8859_1_string(wmem_allocator_t *scope, const guint8 *ptr, gint length)
 {
-    wmem_strbuf_t *str;
+    guint8 *str, *out;
+    gint    ascii_length;
 
-    str = wmem_strbuf_sized_new(scope, length+1, 0);
+    ascii_length = ascii_prefix_length(ptr, length);
+
+    /* The upper half of ISO 8859/1 takes 2 bytes in UTF-8 */
+    str = (guint8 *)wmem_alloc(scope, ascii_length + (length - ascii_length) * 2 + 1);
+    memcpy(str, ptr, ascii_length);
+    out = str + ascii_length;
+    ptr += ascii_length;
+    length -= ascii_length;
 
     while (length > 0) {
         guint8 ch = *ptr;
 
-        if (ch < 0x80)
-            wmem_strbuf_append_c(str, ch);
-        else {
+        if (ch < 0x80) {
+            *out++ = ch;
+        } else {
             /*
              * Note: we assume here that the code points
              * 0x80-0x9F are used for C1 control characters,
              * and thus have the same value as the corresponding
              * Unicode code points.
              */
-            wmem_strbuf_append_unichar(str, ch);
+            *out++ = 0xC0 | (ch >> 6);
+            *out++ = 0x80 | (ch & 0x3F);
         }
         ptr++;
         length--;
     }
+    *out = '\0';
 
-    return (guint8 *) wmem_strbuf_finalize(str);
+    return str;
 }
 
 /*
@@ -484,22 +530,31 @@ const gunichar2 charset_table_cp437[0x80] = {
 guint8 *
 get_unichar2_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, const gunichar2 table[0x80])
 {
-    wmem_strbuf_t *str;
+    guint8 *str, *out;
+    gint    ascii_length;
 
-    str = wmem_strbuf_sized_new(scope, length+1, 0);
+    ascii_length = ascii_prefix_length(ptr, length);
+
+    /* A BMP character takes at most 3 bytes in UTF-8 */
+    str = (guint8 *)wmem_alloc(scope, ascii_length + (length - ascii_length) * 3 + 1);
+    memcpy(str, ptr, ascii_length);
+    out = str + ascii_length;
+    ptr += ascii_length;
+    length -= ascii_length;
 
     while (length > 0) {
         guint8 ch = *ptr;
 
         if (ch < 0x80)
-            wmem_strbuf_append_c(str, ch);
+            *out++ = ch;
         else
-            wmem_strbuf_append_unichar(str, table[ch-0x80]);
+            out += g_unichar_to_utf8(table[ch-0x80], (gchar *)out);
         ptr++;
         length--;
     }
+    *out = '\0';
 
-    return (guint8 *) wmem_strbuf_finalize(str);
+    return str;
 }
 
 /*
@@ -523,9 +578,10 @@ get_ucs_2_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, const
 {
     gunichar2      uchar;
     gint           i;       /* Byte counter for string */
-    wmem_strbuf_t *strbuf;
+    guint8        *str, *out;
 
-    strbuf = wmem_strbuf_sized_new(scope, length+1, 0);
+    /* Each 2-byte character takes at most 3 bytes in UTF-8 */
+    str = out = (guint8 *)wmem_alloc(scope, (length / 2) * 3 + 1);
 
     for(i = 0; i + 1 < length; i += 2) {
         if (encoding == ENC_BIG_ENDIAN){
@@ -533,14 +589,18 @@ get_ucs_2_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, const
         }else{
             uchar = pletoh16(ptr + i);
         }
-        wmem_strbuf_append_unichar(strbuf, uchar);
+        if (uchar < 0x80)
+            *out++ = (guint8)uchar;
+        else
+            out += g_unichar_to_utf8(uchar, (gchar *)out);
     }
+    *out = '\0';
 
     /*
      * XXX - if i < length, this means we were handed an odd
      * number of bytes, so we're not a valid UCS-2 string.
      */
-    return (guint8 *) wmem_strbuf_finalize(strbuf);
+    return str;
 }
 
 /*
@@ -562,12 +622,16 @@ get_ucs_2_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, const
 guint8 *
 get_utf_16_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, const guint encoding)
 {
-    wmem_strbuf_t *strbuf;
+    guint8        *str, *out;
     gunichar2      uchar2, lead_surrogate;
     gunichar       uchar;
     gint           i;       /* Byte counter for string */
 
-    strbuf = wmem_strbuf_sized_new(scope, length+1, 0);
+    /*
+     * A BMP character takes at most 3 bytes in UTF-8, and a surrogate
+     * pair 4, so no more than 3 per 2-byte code unit.
+     */
+    str = out = (guint8 *)wmem_alloc(scope, (length / 2) * 3 + 1);
 
     for(i = 0; i + 1 < length; i += 2) {
         if (encoding == ENC_BIG_ENDIAN)
@@ -599,7 +663,7 @@ get_utf_16_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, const
             if (IS_TRAIL_SURROGATE(uchar2)) {
                 /* Trail surrogate. */
                 uchar = SURROGATE_VALUE(lead_surrogate, uchar2);
-                wmem_strbuf_append_unichar(strbuf, uchar);
+                out += g_unichar_to_utf8(uchar, (gchar *)out);
             } else {
                 /*
                  * Not a trail surrogate.
@@ -624,16 +688,20 @@ get_utf_16_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, const
                 /*
                  * Non-surrogate; just append it.
                  */
-                wmem_strbuf_append_unichar(strbuf, uchar2);
+                if (uchar2 < 0x80)
+                    *out++ = (guint8)uchar2;
+                else
+                    out += g_unichar_to_utf8(uchar2, (gchar *)out);
             }
         }
     }
+    *out = '\0';
 
     /*
      * XXX - if i < length, this means we were handed an odd
      * number of bytes, so we're not a valid UTF-16 string.
      */
-    return (guint8 *) wmem_strbuf_finalize(strbuf);
+    return str;
 }
 
 /*
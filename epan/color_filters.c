@@ -260,6 +260,9 @@ color_filter_clone(color_filter_t *colorf)
     new_colorf->fg_color            = colorf->fg_color;
     new_colorf->disabled            = colorf->disabled;
     new_colorf->c_colorfilter       = NULL;
+    new_colorf->c_ran               = 0;
+    new_colorf->c_skipped           = 0;
+    new_colorf->c_matched           = 0;
     new_colorf->color_edit_dlg_info = NULL;
     new_colorf->selected            = FALSE;
 
@@ -510,6 +513,7 @@ color_filters_colorize_packet(epan_dissect_t *edt)
 {
     GSList         *curr;
     color_filter_t *colorf;
+    gboolean        ran;
 
     /* If we have color filters, "search" for the matching one. */
     if ((edt->tree != NULL) && (color_filters_used())) {
@@ -518,9 +522,22 @@ color_filters_colorize_packet(epan_dissect_t *edt)
         while(curr != NULL) {
             colorf = (color_filter_t *)curr->data;
             if ( (!colorf->disabled) &&
-                 (colorf->c_colorfilter != NULL) &&
-                 dfilter_apply_edt(colorf->c_colorfilter, edt)) {
-                return colorf;
+                 (colorf->c_colorfilter != NULL) ) {
+                /*
+                 * Most packets have none of the fields most of the
+                 * rules look at; don't run those rules at all.
+                 */
+                gboolean matched = dfilter_apply_edt_if_present(colorf->c_colorfilter, edt, &ran);
+
+                if (ran)
+                    colorf->c_ran++;
+                else
+                    colorf->c_skipped++;
+
+                if (matched) {
+                    colorf->c_matched++;
+                    return colorf;
+                }
             }
             curr = g_slist_next(curr);
         }
@@ -49,6 +49,11 @@ typedef struct _color_filter {
                                     /* only used inside of color_filters.c */
     struct epan_dfilter *c_colorfilter;  /* compiled filter expression */
 
+                                    /* statistics, updated by color_filters_colorize_packet() */
+    guint64    c_ran;               /* packets the filter had to be run on */
+    guint64    c_skipped;           /* packets without any of its fields, so it wasn't run */
+    guint64    c_matched;           /* packets it colored (it was the first to match) */
+
                                     /* only used outside of color_filters.c (beside init) */
     void      *color_edit_dlg_info; /* if filter is being edited, ptr to req'd info. GTK+ only. */
 } color_filter_t;
@@ -1963,7 +1963,7 @@ col_set_addr(packet_info *pinfo, const int col, const address *addr, const gbool
 
 /* ------------------------ */
 static void
-col_set_port(packet_info *pinfo, const int col, const gboolean is_res, const gboolean is_src, const gboolean fill_col_exprs _U_)
+col_set_port(packet_info *pinfo, const int col, const gboolean is_res, const gboolean is_src, const gboolean fill_col_exprs)
 {
   guint32 port;
   col_item_t* col_item = &pinfo->cinfo->columns[col];
@@ -1973,52 +1973,45 @@ col_set_port(packet_info *pinfo, const int col, const gboolean is_res, const gbo
   else
     port = pinfo->destport;
 
-  /* TODO: Use fill_col_exprs */
-
+  /*
+   * This is done for every packet, so write straight into the column
+   * buffers rather than going through the *_port_to_display() routines,
+   * which allocate a copy of the string, and only fill in the column
+   * expressions if they're wanted.
+   */
   switch (pinfo->ptype) {
   case PT_SCTP:
-    if (is_res)
-      g_strlcpy(col_item->col_buf, sctp_port_to_display(pinfo->pool, port), COL_MAX_LEN);
-    else
-      guint32_to_str_buf(port, col_item->col_buf, COL_MAX_LEN);
-    break;
-
   case PT_TCP:
-    guint32_to_str_buf(port, pinfo->cinfo->col_expr.col_expr_val[col], COL_MAX_LEN);
-    if (is_res)
-      g_strlcpy(col_item->col_buf, tcp_port_to_display(pinfo->pool, port), COL_MAX_LEN);
-    else
-      g_strlcpy(col_item->col_buf, pinfo->cinfo->col_expr.col_expr_val[col], COL_MAX_LEN);
-    if (is_src)
-      pinfo->cinfo->col_expr.col_expr[col] = "tcp.srcport";
-    else
-      pinfo->cinfo->col_expr.col_expr[col] = "tcp.dstport";
-    break;
-
   case PT_UDP:
-    guint32_to_str_buf(port, pinfo->cinfo->col_expr.col_expr_val[col], COL_MAX_LEN);
-    if (is_res)
-      g_strlcpy(col_item->col_buf, udp_port_to_display(pinfo->pool, port), COL_MAX_LEN);
+    if (is_res && gbl_resolv_flags.transport_name)
+      g_strlcpy(col_item->col_buf, serv_name_lookup(pinfo->ptype, port), COL_MAX_LEN);
     else
-      g_strlcpy(col_item->col_buf, pinfo->cinfo->col_expr.col_expr_val[col], COL_MAX_LEN);
-    if (is_src)
-      pinfo->cinfo->col_expr.col_expr[col] = "udp.srcport";
+      guint32_to_str_buf(port, col_item->col_buf, COL_MAX_LEN);
+    if (!fill_col_exprs || pinfo->ptype == PT_SCTP)
+      break;
+    guint32_to_str_buf(port, pinfo->cinfo->col_expr.col_expr_val[col], COL_MAX_LEN);
+    if (pinfo->ptype == PT_TCP)
+      pinfo->cinfo->col_expr.col_expr[col] = is_src ? "tcp.srcport" : "tcp.dstport";
     else
-      pinfo->cinfo->col_expr.col_expr[col] = "udp.dstport";
+      pinfo->cinfo->col_expr.col_expr[col] = is_src ? "udp.srcport" : "udp.dstport";
     break;
 
   case PT_DDP:
+    guint32_to_str_buf(port, col_item->col_buf, COL_MAX_LEN);
+    if (!fill_col_exprs)
+      break;
     if (is_src)
       pinfo->cinfo->col_expr.col_expr[col] = "ddp.src_socket";
     else
       pinfo->cinfo->col_expr.col_expr[col] = "ddp.dst_socket";
-    guint32_to_str_buf(port, pinfo->cinfo->col_expr.col_expr_val[col], COL_MAX_LEN);
-    g_strlcpy(col_item->col_buf, pinfo->cinfo->col_expr.col_expr_val[col], COL_MAX_LEN);
+    g_strlcpy(pinfo->cinfo->col_expr.col_expr_val[col], col_item->col_buf, COL_MAX_LEN);
     break;
 
   case PT_IPX:
     /* XXX - resolve IPX socket numbers */
     ws_snprintf(col_item->col_buf, COL_MAX_LEN, "0x%04x", port);
+    if (!fill_col_exprs)
+      break;
     g_strlcpy(pinfo->cinfo->col_expr.col_expr_val[col], col_item->col_buf,COL_MAX_LEN);
     if (is_src)
       pinfo->cinfo->col_expr.col_expr[col] = "ipx.src.socket";
@@ -2029,6 +2022,8 @@ col_set_port(packet_info *pinfo, const int col, const gboolean is_res, const gbo
   case PT_IDP:
     /* XXX - resolve IDP socket numbers */
     ws_snprintf(col_item->col_buf, COL_MAX_LEN, "0x%04x", port);
+    if (!fill_col_exprs)
+      break;
     g_strlcpy(pinfo->cinfo->col_expr.col_expr_val[col], col_item->col_buf,COL_MAX_LEN);
     if (is_src)
       pinfo->cinfo->col_expr.col_expr[col] = "idp.src.socket";
@@ -2039,6 +2034,8 @@ col_set_port(packet_info *pinfo, const int col, const gboolean is_res, const gbo
   case PT_USB:
     /* XXX - resolve USB endpoint numbers */
     ws_snprintf(col_item->col_buf, COL_MAX_LEN, "0x%08x", port);
+    if (!fill_col_exprs)
+      break;
     g_strlcpy(pinfo->cinfo->col_expr.col_expr_val[col], col_item->col_buf,COL_MAX_LEN);
     if (is_src)
       pinfo->cinfo->col_expr.col_expr[col] = "usb.src.endpoint";
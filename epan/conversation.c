@@ -59,6 +59,37 @@ static wmem_map_t *conversation_hashtable_no_addr2_or_port2 = NULL;
 
 static guint32 new_index;
 
+/*
+ * Bumped whenever a conversation is added to, removed from or moved
+ * between the hash tables above, so that cached lookup results can be
+ * recognized as stale.
+ */
+static guint32 conversation_generation = 1;
+
+/*
+ * The arguments and result of the last find_conversation() call.
+ * Several dissectors in the stack of a packet usually look up the same
+ * conversation for that packet (e.g. TCP, then the conversation
+ * dissector, then the application dissector itself), and a lookup can
+ * take up to eight probes into the hash tables if it has to try the
+ * wildcard tables.
+ */
+#define CONVERSATION_CACHE_ADDR_LEN	16
+
+static struct {
+	guint32		generation;	/* 0 if nothing is cached */
+	guint32		frame_num;
+	address		addr_a;
+	address		addr_b;
+	port_type	ptype;
+	guint32		port_a;
+	guint32		port_b;
+	guint		options;
+	conversation_t	*conversation;	/* may be NULL: nothing was found */
+	guint8		addr_a_data[CONVERSATION_CACHE_ADDR_LEN];
+	guint8		addr_b_data[CONVERSATION_CACHE_ADDR_LEN];
+} conversation_cache;
+
 /*
  * Creates a new conversation with known endpoints based on a conversation
  * created with the CONVERSATION_TEMPLATE option while keeping the
@@ -457,6 +488,7 @@ conversation_init(void)
 	    wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), conversation_hash_no_addr2_or_port2,
 	      conversation_match_no_addr2_or_port2);
 
+	conversation_generation++;
 }
 
 /**
@@ -468,6 +500,11 @@ void conversation_epan_reset(void)
 	 * Start the conversation indices over at 0.
 	 */
 	new_index = 0;
+
+	/*
+	 * The conversations of the previous pass are gone.
+	 */
+	conversation_generation++;
 }
 
 /*
@@ -481,6 +518,8 @@ conversation_insert_into_hashtable(wmem_map_t *hashtable, conversation_t *conv)
 {
 	conversation_t *chain_head, *chain_tail, *cur, *prev;
 
+	conversation_generation++;
+
 	chain_head = (conversation_t *)wmem_map_lookup(hashtable, conv->key_ptr);
 
 	if (NULL==chain_head) {
@@ -537,6 +576,8 @@ conversation_remove_from_hashtable(wmem_map_t *hashtable, conversation_t *conv)
 {
 	conversation_t *chain_head, *cur, *prev;
 
+	conversation_generation++;
+
 	chain_head = (conversation_t *)wmem_map_lookup(hashtable, conv->key_ptr);
 
 	if (conv == chain_head) {
@@ -739,6 +780,13 @@ conversation_lookup_hashtable(wmem_map_t *hashtable, const guint32 frame_num, co
 	conversation_t* chain_head=NULL;
 	conversation_key key;
 
+	/*
+	 * Don't bother hashing the key if there's nothing to find; most
+	 * of the time most of the wildcard tables are empty.
+	 */
+	if (wmem_map_size(hashtable) == 0)
+		return NULL;
+
 	/*
 	 * We don't make a copy of the address data, we just copy the
 	 * pointer to it, as "key" disappears when we return.
@@ -810,8 +858,8 @@ conversation_lookup_hashtable(wmem_map_t *hashtable, const guint32 frame_num, co
  *
  *	otherwise, we found no matching conversation, and return NULL.
  */
-conversation_t *
-find_conversation(const guint32 frame_num, const address *addr_a, const address *addr_b, const port_type ptype,
+static conversation_t *
+find_conversation_uncached(const guint32 frame_num, const address *addr_a, const address *addr_b, const port_type ptype,
     const guint32 port_a, const guint32 port_b, const guint options)
 {
 	conversation_t *conversation;
@@ -1147,6 +1195,67 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
 	return NULL;
 }
 
+conversation_t *
+find_conversation(const guint32 frame_num, const address *addr_a, const address *addr_b, const port_type ptype,
+    const guint32 port_a, const guint32 port_b, const guint options)
+{
+	conversation_t *conversation;
+	guint32 generation;
+
+	if (conversation_cache.generation == conversation_generation &&
+	    conversation_cache.frame_num == frame_num &&
+	    conversation_cache.ptype == ptype &&
+	    conversation_cache.port_a == port_a &&
+	    conversation_cache.port_b == port_b &&
+	    conversation_cache.options == options &&
+	    addresses_equal(&conversation_cache.addr_a, addr_a) &&
+	    addresses_equal(&conversation_cache.addr_b, addr_b)) {
+		DPRINT(("found in the lookup cache"));
+		return conversation_cache.conversation;
+	}
+
+	generation = conversation_generation;
+	conversation = find_conversation_uncached(frame_num, addr_a, addr_b,
+	    ptype, port_a, port_b, options);
+
+	/*
+	 * Only remember the result if the lookup didn't change the tables
+	 * (by filling in a wildcard or instantiating a template, which
+	 * would make the next lookup take a different path), and if the
+	 * addresses fit into the cache.
+	 */
+	if (generation != conversation_generation ||
+	    addr_a->len > CONVERSATION_CACHE_ADDR_LEN ||
+	    addr_b->len > CONVERSATION_CACHE_ADDR_LEN) {
+		conversation_cache.generation = 0;
+		return conversation;
+	}
+
+	if (addr_a->len > 0) {
+		memcpy(conversation_cache.addr_a_data, addr_a->data, addr_a->len);
+		set_address(&conversation_cache.addr_a, addr_a->type, addr_a->len,
+		    conversation_cache.addr_a_data);
+	} else {
+		set_address(&conversation_cache.addr_a, addr_a->type, 0, NULL);
+	}
+	if (addr_b->len > 0) {
+		memcpy(conversation_cache.addr_b_data, addr_b->data, addr_b->len);
+		set_address(&conversation_cache.addr_b, addr_b->type, addr_b->len,
+		    conversation_cache.addr_b_data);
+	} else {
+		set_address(&conversation_cache.addr_b, addr_b->type, 0, NULL);
+	}
+	conversation_cache.frame_num = frame_num;
+	conversation_cache.ptype = ptype;
+	conversation_cache.port_a = port_a;
+	conversation_cache.port_b = port_b;
+	conversation_cache.options = options;
+	conversation_cache.conversation = conversation;
+	conversation_cache.generation = generation;
+
+	return conversation;
+}
+
 void
 conversation_add_proto_data(conversation_t *conv, const int proto, void *proto_data)
 {
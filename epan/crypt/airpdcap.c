@@ -118,6 +118,15 @@ extern const UINT32 crc32_table[256];
 
 /****************************************************************************/
 
+/****************************************************************************/
+/*      Global variables                                                        */
+
+/* PMKs derived from WPA passphrases, keyed by "<hex SSID>:<passphrase>".  */
+/* Survives AirPDcapInitContext() so that reloading keys is cheap.         */
+static GHashTable *pmk_cache = NULL;
+
+/****************************************************************************/
+
 /****************************************************************************/
 /*      Type definitions                                                        */
 
@@ -1057,6 +1066,8 @@ INT AirPDcapInitContext(
     ctx->pkt_ssid_len = 0;
 
     memset(ctx->sa, 0, AIRPDCAP_MAX_SEC_ASSOCIATIONS_NR * sizeof(AIRPDCAP_SEC_ASSOCIATION));
+    if (ctx->sa_hash!=NULL)
+        g_hash_table_remove_all(ctx->sa_hash);
 
     AIRPDCAP_DEBUG_PRINT_LINE("AirPDcapInitContext", "Context initialized!", AIRPDCAP_DEBUG_LEVEL_5);
     AIRPDCAP_DEBUG_TRACE_END("AirPDcapInitContext");
@@ -1081,6 +1092,16 @@ INT AirPDcapDestroyContext(
     ctx->index=-1;
     ctx->sa_index=-1;
 
+    if (ctx->sa_hash!=NULL) {
+        g_hash_table_destroy(ctx->sa_hash);
+        ctx->sa_hash=NULL;
+    }
+
+    if (pmk_cache!=NULL) {
+        g_hash_table_destroy(pmk_cache);
+        pmk_cache=NULL;
+    }
+
     AIRPDCAP_DEBUG_PRINT_LINE("AirPDcapDestroyContext", "Context destroyed!", AIRPDCAP_DEBUG_LEVEL_5);
     AIRPDCAP_DEBUG_TRACE_END("AirPDcapDestroyContext");
     return AIRPDCAP_RET_SUCCESS;
@@ -1633,26 +1654,45 @@ AirPDcapValidateKey(
     return ret;
 }
 
+static guint
+AirPDcapSaIdHash(
+    gconstpointer key)
+{
+    const UCHAR *p = (const UCHAR *)key;
+    guint h = 5381;
+    size_t i;
+
+    for (i = 0; i < sizeof(AIRPDCAP_SEC_ASSOCIATION_ID); i++)
+        h = (h << 5) + h + p[i];
+    return h;
+}
+
+static gboolean
+AirPDcapSaIdEqual(
+    gconstpointer a,
+    gconstpointer b)
+{
+    return memcmp(a, b, sizeof(AIRPDCAP_SEC_ASSOCIATION_ID)) == 0;
+}
+
 static INT
 AirPDcapGetSa(
     PAIRPDCAP_CONTEXT ctx,
     AIRPDCAP_SEC_ASSOCIATION_ID *id)
 {
-    INT sa_index;
-    if (ctx->sa_index!=-1) {
-        /* at least one association was stored                               */
-        /* search for the association from sa_index to 0 (most recent added) */
-        for (sa_index=ctx->sa_index; sa_index>=0; sa_index--) {
-            if (ctx->sa[sa_index].used) {
-                if (memcmp(id, &(ctx->sa[sa_index].saId), sizeof(AIRPDCAP_SEC_ASSOCIATION_ID))==0) {
-                    ctx->index=sa_index;
-                    return sa_index;
-                }
-            }
-        }
+    PAIRPDCAP_SEC_ASSOCIATION sa;
+
+    if (ctx->sa_index==-1 || ctx->sa_hash==NULL) {
+        /* no association was stored */
+        return -1;
     }
 
-    return -1;
+    sa = (PAIRPDCAP_SEC_ASSOCIATION)g_hash_table_lookup(ctx->sa_hash, id);
+    if (sa == NULL || !sa->used)
+        return -1;
+
+    ctx->index=(INT)(sa - ctx->sa);
+    return ctx->index;
 }
 
 static INT
@@ -1693,6 +1733,11 @@ AirPDcapStoreSa(
     /* set the info structure */
     memcpy(&(ctx->sa[ctx->index].saId), id, sizeof(AIRPDCAP_SEC_ASSOCIATION_ID));
 
+    /* the key lives in the SA itself, so it stays valid as long as the entry */
+    if (ctx->sa_hash==NULL)
+        ctx->sa_hash=g_hash_table_new(AirPDcapSaIdHash, AirPDcapSaIdEqual);
+    g_hash_table_insert(ctx->sa_hash, &(ctx->sa[ctx->index].saId), &(ctx->sa[ctx->index]));
+
     /* increment by 1 the first_free_index (heuristic) */
     ctx->first_free_index++;
 
@@ -1927,10 +1972,36 @@ AirPDcapRsnaPwd2Psk(
     UCHAR *output)
 {
     UCHAR m_output[40] = { 0 };
-    GByteArray *pp_ba = g_byte_array_new();
+    GByteArray *pp_ba;
+    GString *cache_key;
+    size_t i;
+    UCHAR *pmk;
+
+    /*
+     * Deriving the PMK takes 8192 HMAC-SHA1 rounds, and it's redone every
+     * time the keys are set (on each preference change or capture reload)
+     * and for every handshake using a wildcard SSID.  Remember the result
+     * for each passphrase/SSID pair instead.
+     */
+    cache_key = g_string_new(NULL);
+    for (i = 0; i < ssidLength; i++)
+        g_string_append_printf(cache_key, "%02x", (guint8)ssid[i]);
+    g_string_append_c(cache_key, ':');
+    g_string_append(cache_key, passphrase);
+
+    if (pmk_cache != NULL) {
+        pmk = (UCHAR *)g_hash_table_lookup(pmk_cache, cache_key->str);
+        if (pmk != NULL) {
+            memcpy(output, pmk, AIRPDCAP_WPA_PSK_LEN);
+            g_string_free(cache_key, TRUE);
+            return 0;
+        }
+    }
 
+    pp_ba = g_byte_array_new();
     if (!uri_str_to_bytes(passphrase, pp_ba)) {
         g_byte_array_free(pp_ba, TRUE);
+        g_string_free(cache_key, TRUE);
         return 0;
     }
 
@@ -1940,6 +2011,11 @@ AirPDcapRsnaPwd2Psk(
     memcpy(output, m_output, AIRPDCAP_WPA_PSK_LEN);
     g_byte_array_free(pp_ba, TRUE);
 
+    if (pmk_cache == NULL)
+        pmk_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    g_hash_table_insert(pmk_cache, g_string_free(cache_key, FALSE),
+                        g_memdup(m_output, AIRPDCAP_WPA_PSK_LEN));
+
     return 0;
 }
 
@@ -163,6 +163,9 @@ typedef struct _AIRPDCAP_CONTEXT {
 
 	INT index;
 	INT first_free_index;
+
+	/* Security Associations indexed by saId, values point into sa[] */
+	GHashTable *sa_hash;
 } AIRPDCAP_CONTEXT, *PAIRPDCAP_CONTEXT;
 
 /************************************************************************/
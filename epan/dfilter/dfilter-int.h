@@ -27,17 +27,28 @@
 #include <epan/proto.h>
 #include <stdio.h>
 
+struct _dfvm_code;
+
 /* Passed back to user */
 struct epan_dfilter {
 	GPtrArray	*insns;
 	GPtrArray	*consts;
+	struct _dfvm_code *code;	/* insns, compiled by dfvm_compile() */
 	guint		num_registers;
 	guint		max_registers;
 	GList		**registers;
 	gboolean	*attempted_load;
 	int		*interesting_fields;
 	int		num_interesting_fields;
+	int		*required_protocols; /* protocols a frame must have to match */
+	int		num_required_protocols;
+	gboolean	matches_empty;	/* result with none of the interesting fields present */
 	GPtrArray	*deprecated;
+	header_field_info *batch_hfinfo; /* field of a filter dfvm_apply_uint_batch() can run, or NULL */
+	int		batch_op;	/* ... the dfvm_opcode_t comparing it ... */
+	guint64		batch_value;	/* ... with this constant */
+	gchar		*cache_key;	/* expanded text, if in the compiled filter cache */
+	guint		refcount;	/* users of a cached filter */
 };
 
 typedef struct {
@@ -53,6 +64,7 @@ typedef struct {
 	int		next_const_id;
 	int		next_register;
 	int		first_constant; /* first register used as a constant */
+	gboolean	uses_host_names; /* resolved names, so the filter can't be cached */
 } dfwork_t;
 
 /*
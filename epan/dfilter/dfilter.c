@@ -33,6 +33,7 @@
 #include "dfilter-macro.h"
 #include "scanner_lex.h"
 #include <wsutil/ws_printf.h> /* ws_debug_printf */
+#include <wsutil/ws_trace.h>
 
 
 #define DFILTER_TOKEN_ID_OFFSET	1
@@ -46,6 +47,57 @@ static void*	ParserObj = NULL;
  */
 dfwork_t *global_dfw;
 
+/*
+ * Compiled filters, keyed by their text after macro expansion. The same
+ * filter text gets compiled over and over (the display filter, tap, color
+ * and graph filters, and all of them again on every profile switch), so we
+ * keep the dfilter_t and hand it out again. A filter is only changed by
+ * dfvm_apply(), which leaves it as it found it, so it can be shared by
+ * callers that apply it one after the other. The cache is emptied when the
+ * registered fields change.
+ */
+#define DFILTER_CACHE_MAX_UNUSED	64
+
+static GHashTable *dfilter_cache = NULL;
+static guint dfilter_cache_generation = 0;
+static guint dfilter_cache_unused = 0;	/* cached filters nobody uses */
+
+static void dfilter_free_compiled(dfilter_t *df);
+
+static gboolean
+dfilter_cache_drop_unused(gpointer key _U_, gpointer value, gpointer user_data _U_)
+{
+	dfilter_t *df = (dfilter_t *)value;
+
+	if (df->refcount > 0)
+		return FALSE;
+	dfilter_free_compiled(df);
+	return TRUE;
+}
+
+static gboolean
+dfilter_cache_drop(gpointer key _U_, gpointer value, gpointer user_data _U_)
+{
+	dfilter_t *df = (dfilter_t *)value;
+
+	if (df->refcount == 0) {
+		dfilter_free_compiled(df);
+	} else {
+		/* Still in use; the last dfilter_free() frees it */
+		g_free(df->cache_key);
+		df->cache_key = NULL;
+	}
+	return TRUE;
+}
+
+static void
+dfilter_cache_flush(void)
+{
+	if (dfilter_cache)
+		g_hash_table_foreach_remove(dfilter_cache, dfilter_cache_drop, NULL);
+	dfilter_cache_unused = 0;
+}
+
 void
 dfilter_fail(dfwork_t *dfw, const char *format, ...)
 {
@@ -92,6 +144,12 @@ dfilter_cleanup(void)
 {
 	dfilter_macro_cleanup();
 
+	dfilter_cache_flush();
+	if (dfilter_cache) {
+		g_hash_table_destroy(dfilter_cache);
+		dfilter_cache = NULL;
+	}
+
 	/* Free the Lemon Parser object */
 	if (ParserObj) {
 		DfilterFree(ParserObj, g_free);
@@ -131,11 +189,30 @@ free_insns(GPtrArray *insns)
 void
 dfilter_free(dfilter_t *df)
 {
-	guint i;
-
 	if (!df)
 		return;
 
+	if (df->refcount > 0) {
+		if (--df->refcount > 0)
+			return;
+		if (df->cache_key != NULL) {
+			/* Keep it for the next compile of the same text */
+			if (++dfilter_cache_unused > DFILTER_CACHE_MAX_UNUSED) {
+				g_hash_table_foreach_remove(dfilter_cache, dfilter_cache_drop_unused, NULL);
+				dfilter_cache_unused = 0;
+			}
+			return;
+		}
+	}
+
+	dfilter_free_compiled(df);
+}
+
+static void
+dfilter_free_compiled(dfilter_t *df)
+{
+	guint i;
+
 	if (df->insns) {
 		free_insns(df->insns);
 	}
@@ -143,7 +220,10 @@ dfilter_free(dfilter_t *df)
 		free_insns(df->consts);
 	}
 
+	g_free(df->code);
+
 	g_free(df->interesting_fields);
+	g_free(df->required_protocols);
 
 	/* clear registers */
 	for (i = 0; i < df->max_registers; i++) {
@@ -162,6 +242,7 @@ dfilter_free(dfilter_t *df)
 
 	g_free(df->registers);
 	g_free(df->attempted_load);
+	g_free(df->cache_key);
 	g_free(df);
 }
 
@@ -222,6 +303,7 @@ dfilter_compile(const gchar *text, dfilter_t **dfp, gchar **err_msg)
 	guint		i;
 	/* XXX, GHashTable */
 	GPtrArray	*deprecated;
+	proto_tree	*empty_tree;
 
 	g_assert(dfp);
 
@@ -236,6 +318,19 @@ dfilter_compile(const gchar *text, dfilter_t **dfp, gchar **err_msg)
 		return FALSE;
 	}
 
+	if (dfilter_cache_generation != proto_registrar_get_generation()) {
+		dfilter_cache_flush();
+		dfilter_cache_generation = proto_registrar_get_generation();
+	}
+	if (dfilter_cache != NULL &&
+	    (dfilter = (dfilter_t *)g_hash_table_lookup(dfilter_cache, expanded_text)) != NULL) {
+		if (dfilter->refcount++ == 0)
+			dfilter_cache_unused--;
+		*dfp = dfilter;
+		wmem_free(NULL, expanded_text);
+		return TRUE;
+	}
+
 	if (df_lex_init(&scanner) != 0) {
 		wmem_free(NULL, expanded_text);
 		*dfp = NULL;
@@ -355,6 +450,8 @@ dfilter_compile(const gchar *text, dfilter_t **dfp, gchar **err_msg)
 		dfw->consts = NULL;
 		dfilter->interesting_fields = dfw_interesting_fields(dfw,
 			&dfilter->num_interesting_fields);
+		dfilter->required_protocols = dfw_required_protocols(dfw,
+			&dfilter->num_required_protocols);
 
 		/* Initialize run-time space */
 		dfilter->num_registers = dfw->first_constant;
@@ -365,9 +462,26 @@ dfilter_compile(const gchar *text, dfilter_t **dfp, gchar **err_msg)
 		/* Initialize constants */
 		dfvm_init_const(dfilter);
 
+		/* Lay the instructions out for dfvm_apply() */
+		dfvm_compile(dfilter);
+
+		/* What it gives when none of its fields are there, for
+		 * dfilter_apply_edt_if_present() */
+		empty_tree = proto_tree_create_root(NULL);
+		dfilter->matches_empty = dfvm_apply(dfilter, empty_tree);
+		proto_tree_free(empty_tree);
+
 		/* Add any deprecated items */
 		dfilter->deprecated = deprecated;
 
+		if (!dfw->uses_host_names) {
+			if (dfilter_cache == NULL)
+				dfilter_cache = g_hash_table_new(g_str_hash, g_str_equal);
+			dfilter->cache_key = g_strdup(expanded_text);
+			dfilter->refcount = 1;
+			g_hash_table_insert(dfilter_cache, dfilter->cache_key, dfilter);
+		}
+
 		/* And give it to the user. */
 		*dfp = dfilter;
 	}
@@ -407,18 +521,73 @@ FAILURE:
 }
 
 
+static inline gboolean
+dfilter_run(dfilter_t *df, proto_tree *tree)
+{
+	gboolean matched;
+
+	WS_TRACE0(dfilter_apply_entry);
+	matched = dfvm_apply(df, tree);
+	WS_TRACE1(dfilter_apply_return, matched);
+	return matched;
+}
+
 gboolean
 dfilter_apply(dfilter_t *df, proto_tree *tree)
 {
-	return dfvm_apply(df, tree);
+	return dfilter_run(df, tree);
 }
 
 gboolean
 dfilter_apply_edt(dfilter_t *df, epan_dissect_t* edt)
 {
-	return dfvm_apply(df, edt->tree);
+	return dfilter_run(df, edt->tree);
 }
 
+gboolean
+dfilter_apply_edt_if_present(dfilter_t *df, epan_dissect_t* edt, gboolean *ran)
+{
+	int i;
+
+	/*
+	 * The filter can only look at the tree through its interesting
+	 * fields, so if none of them are there it has to give what it
+	 * gives for an empty tree.
+	 */
+	for (i = 0; i < df->num_interesting_fields; i++) {
+		GPtrArray *finfos = proto_get_finfo_ptr_array(edt->tree, df->interesting_fields[i]);
+
+		if (finfos != NULL && g_ptr_array_len(finfos) > 0) {
+			if (ran)
+				*ran = TRUE;
+			return dfilter_run(df, edt->tree);
+		}
+	}
+
+	if (ran)
+		*ran = FALSE;
+	return df->matches_empty;
+}
+
+int
+dfilter_batch_uint_field(const dfilter_t *df)
+{
+	return df->batch_hfinfo ? df->batch_hfinfo->id : -1;
+}
+
+void
+dfilter_apply_uint_batch(const dfilter_t *df, const guint64 *values,
+		const guint32 *present, guint count, guint32 *matches)
+{
+	guint i;
+
+	dfvm_apply_uint_batch(df, values, count, matches);
+
+	if (present) {
+		for (i = 0; i < (count + 31) / 32; i++)
+			matches[i] &= present[i];
+	}
+}
 
 void
 dfilter_prime_proto_tree(const dfilter_t *df, proto_tree *tree)
@@ -436,6 +605,52 @@ dfilter_has_interesting_fields(const dfilter_t *df)
 	return (df->num_interesting_fields > 0);
 }
 
+gboolean
+dfilter_only_references(const dfilter_t *df, const int *hf_ids, guint num_hf_ids)
+{
+	int i;
+	guint j;
+
+	for (i = 0; i < df->num_interesting_fields; i++) {
+		for (j = 0; j < num_hf_ids; j++) {
+			if (df->interesting_fields[i] == hf_ids[j])
+				break;
+		}
+		if (j == num_hf_ids)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+GArray *
+dfilter_referenced_protocols(const dfilter_t *df)
+{
+	GArray *protocols;
+	header_field_info *hfinfo;
+	int i, proto_id;
+	guint j;
+
+	protocols = g_array_new(FALSE, FALSE, sizeof(int));
+	for (i = 0; i < df->num_interesting_fields; i++) {
+		hfinfo = proto_registrar_get_nth(df->interesting_fields[i]);
+		proto_id = hfinfo->parent == -1 ? hfinfo->id : hfinfo->parent;
+		for (j = 0; j < protocols->len; j++) {
+			if (g_array_index(protocols, int, j) == proto_id)
+				break;
+		}
+		if (j == protocols->len)
+			g_array_append_val(protocols, proto_id);
+	}
+	return protocols;
+}
+
+const int *
+dfilter_required_protocols(const dfilter_t *df, int *num_protocols)
+{
+	*num_protocols = df->num_required_protocols;
+	return df->required_protocols;
+}
+
 GPtrArray *
 dfilter_deprecated_tokens(dfilter_t *df) {
 	if (df->deprecated && df->deprecated->len > 0) {
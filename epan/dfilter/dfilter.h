@@ -80,10 +80,59 @@ dfilter_apply(dfilter_t *df, proto_tree *tree);
 void
 dfilter_prime_proto_tree(const dfilter_t *df, proto_tree *tree);
 
+/* Apply compiled dfilter to the edt's tree, without running it if none
+ * of the fields it references are in the tree (the result is then the
+ * one it gives for an empty tree, found when it was compiled).  The tree
+ * must have been primed with the dfilter.  If ran isn't NULL, it's set
+ * to whether the dfilter had to be run. */
+WS_DLL_PUBLIC
+gboolean
+dfilter_apply_edt_if_present(dfilter_t *df, struct epan_dissect *edt, gboolean *ran);
+
+/* If the dfilter only compares one unsigned integer field with a
+ * constant, return the field's id, otherwise -1; such a dfilter can be
+ * run over many packets' values of the field at once with
+ * dfilter_apply_uint_batch(). */
+WS_DLL_PUBLIC
+int
+dfilter_batch_uint_field(const dfilter_t *df);
+
+/* Apply a dfilter for which dfilter_batch_uint_field() gave a field to
+ * count packets' values of the field (a field that occurs at most once
+ * in a packet), setting bit (i % 32) of matches[i / 32] to whether
+ * packet i matches; matches must have room
+ * for (count + 31) / 32 words.  If present isn't NULL it's a bitmap laid
+ * out the same way of which packets have the field, and packets without
+ * it don't match. */
+WS_DLL_PUBLIC
+void
+dfilter_apply_uint_batch(const dfilter_t *df, const guint64 *values,
+		const guint32 *present, guint count, guint32 *matches);
+
 /* Check if dfilter has interesting fields */
 gboolean
 dfilter_has_interesting_fields(const dfilter_t *df);
 
+/* Check if every field or protocol the dfilter references is one of
+ * the num_hf_ids ids in hf_ids. */
+WS_DLL_PUBLIC
+gboolean
+dfilter_only_references(const dfilter_t *df, const int *hf_ids, guint num_hf_ids);
+
+/* Get the ids of the protocols the dfilter references, directly or
+ * through their fields.  The caller frees the array. */
+WS_DLL_PUBLIC
+GArray *
+dfilter_referenced_protocols(const dfilter_t *df);
+
+/* Get the ids of the protocols a frame must have for the dfilter to
+ * match it, from tests for the protocols joined by "&&" at the top of
+ * the dfilter ("http && !tcp.analysis.retransmission" needs "http").
+ * The array belongs to the dfilter; it's NULL if num_protocols is 0. */
+WS_DLL_PUBLIC
+const int *
+dfilter_required_protocols(const dfilter_t *df, int *num_protocols);
+
 WS_DLL_PUBLIC
 GPtrArray *
 dfilter_deprecated_tokens(dfilter_t *df);
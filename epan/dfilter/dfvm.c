@@ -20,6 +20,9 @@
 
 #include "config.h"
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "dfvm.h"
 
 #include <ftypes/ftypes-int.h>
@@ -38,6 +41,58 @@ dfvm_insn_new(dfvm_opcode_t op)
 	return insn;
 }
 
+/* Sets with fewer members than this are left as a series of ANY_EQ
+ * tests, which is as quick for them. */
+#define FVALUE_SET_MIN_SIZE	8
+
+struct _dfvm_fvalue_set {
+	ftenum_t	ftype;
+	GPtrArray	*fvalues;	/* the members, owned by the set */
+	guint64		*keys;		/* one per member, sorted */
+	guint		num_masks;	/* FT_IPv4: distinct netmasks in keys */
+	guint32		masks[33];
+};
+
+static void
+fvalue_set_free(dfvm_fvalue_set_t *set)
+{
+	guint i;
+
+	for (i = 0; i < set->fvalues->len; i++) {
+		FVALUE_FREE((fvalue_t *)g_ptr_array_index(set->fvalues, i));
+	}
+	g_ptr_array_free(set->fvalues, TRUE);
+	g_free(set->keys);
+	g_free(set);
+}
+
+/* Fewer OR-ed tests than this are left alone, and a pattern set may have
+ * at most this many automaton states, i.e. 16 MB of transitions. */
+#define PATTERN_SET_MIN_SIZE	4
+#define PATTERN_SET_MAX_STATES	16384
+
+struct _dfvm_pattern_set {
+	gboolean	strings;	/* the members are strings, not byte arrays */
+	FvalueCmp	cmp_contains;	/* the members' contains method */
+	GPtrArray	*fvalues;	/* the members, owned by the set */
+	guint32		*next;		/* Aho-Corasick transitions, 256 per state */
+	guint8		*match;		/* does a member end in this state? */
+};
+
+static void
+pattern_set_free(dfvm_pattern_set_t *set)
+{
+	guint i;
+
+	for (i = 0; i < set->fvalues->len; i++) {
+		FVALUE_FREE((fvalue_t *)g_ptr_array_index(set->fvalues, i));
+	}
+	g_ptr_array_free(set->fvalues, TRUE);
+	g_free(set->next);
+	g_free(set->match);
+	g_free(set);
+}
+
 static void
 dfvm_value_free(dfvm_value_t *v)
 {
@@ -48,6 +103,12 @@ dfvm_value_free(dfvm_value_t *v)
 		case DRANGE:
 			drange_free(v->value.drange);
 			break;
+		case FVALUE_SET:
+			fvalue_set_free(v->value.fvalue_set);
+			break;
+		case PATTERN_SET:
+			pattern_set_free(v->value.pattern_set);
+			break;
 		default:
 			/* nothing */
 			;
@@ -84,6 +145,304 @@ dfvm_value_new(dfvm_value_type_t type)
 	return v;
 }
 
+/* Gets the key under which fv is kept in a set of ftype. The keys
+ * compare equal exactly when the ftype's cmp_eq method says the values
+ * do. An IPv4 key includes the netmask; an address is looked up once
+ * for each netmask in the set. */
+static gboolean
+fvalue_set_key(ftenum_t ftype, const fvalue_t *fv, guint64 *key)
+{
+	switch (ftype) {
+		case FT_CHAR:
+		case FT_UINT8:
+		case FT_UINT16:
+		case FT_UINT24:
+		case FT_UINT32:
+		case FT_INT8:
+		case FT_INT16:
+		case FT_INT24:
+		case FT_INT32:
+		case FT_FRAMENUM:
+			*key = fv->value.uinteger;
+			return TRUE;
+
+		case FT_UINT40:
+		case FT_UINT48:
+		case FT_UINT56:
+		case FT_UINT64:
+		case FT_INT40:
+		case FT_INT48:
+		case FT_INT56:
+		case FT_INT64:
+			*key = fv->value.uinteger64;
+			return TRUE;
+
+		case FT_IPv4:
+			*key = ((guint64)fv->value.ipv4.nmask << 32) |
+				(fv->value.ipv4.addr & fv->value.ipv4.nmask);
+			return TRUE;
+
+		default:
+			return FALSE;
+	}
+}
+
+static gint
+fvalue_set_key_cmp(gconstpointer a, gconstpointer b)
+{
+	guint64 key_a = *(const guint64 *)a;
+	guint64 key_b = *(const guint64 *)b;
+
+	return (key_a > key_b) - (key_a < key_b);
+}
+
+dfvm_fvalue_set_t*
+dfvm_fvalue_set_new(GPtrArray *fvalues)
+{
+	dfvm_fvalue_set_t	*set;
+	const fvalue_t		*fv;
+	ftenum_t		ftype;
+	guint64			key;
+	guint			i, j;
+
+	if (fvalues->len < FVALUE_SET_MIN_SIZE)
+		return NULL;
+
+	ftype = ((const fvalue_t *)g_ptr_array_index(fvalues, 0))->ftype->ftype;
+	for (i = 0; i < fvalues->len; i++) {
+		fv = (const fvalue_t *)g_ptr_array_index(fvalues, i);
+		if (fv->ftype->ftype != ftype || !fvalue_set_key(ftype, fv, &key))
+			return NULL;
+	}
+
+	set = g_new0(dfvm_fvalue_set_t, 1);
+	set->ftype = ftype;
+	set->fvalues = fvalues;
+	set->keys = g_new(guint64, fvalues->len);
+	for (i = 0; i < fvalues->len; i++) {
+		fv = (const fvalue_t *)g_ptr_array_index(fvalues, i);
+		fvalue_set_key(ftype, fv, &set->keys[i]);
+
+		if (ftype == FT_IPv4) {
+			for (j = 0; j < set->num_masks; j++) {
+				if (set->masks[j] == fv->value.ipv4.nmask)
+					break;
+			}
+			if (j == set->num_masks)
+				set->masks[set->num_masks++] = fv->value.ipv4.nmask;
+		}
+	}
+	qsort(set->keys, fvalues->len, sizeof(guint64), fvalue_set_key_cmp);
+
+	return set;
+}
+
+static gboolean
+fvalue_set_lookup(const dfvm_fvalue_set_t *set, guint64 key)
+{
+	return bsearch(&key, set->keys, set->fvalues->len, sizeof(guint64),
+			fvalue_set_key_cmp) != NULL;
+}
+
+/* Gets the octets that fv, a string or byte array, stands for in a
+ * "contains" test. */
+static void
+pattern_data(gboolean strings, const fvalue_t *fv, const guint8 **data, guint *len)
+{
+	if (strings) {
+		*data = (const guint8 *)fv->value.string;
+		*len = (guint)strlen(fv->value.string);
+	}
+	else {
+		*data = fv->value.bytes->data;
+		*len = fv->value.bytes->len;
+	}
+}
+
+dfvm_pattern_set_t*
+dfvm_pattern_set_new(GPtrArray *fvalues)
+{
+	dfvm_pattern_set_t	*set;
+	const fvalue_t		*fv;
+	ftenum_t		ftype;
+	gboolean		strings;
+	const guint8		*data;
+	guint			len, total_len, num_states, i, j, c;
+	guint32			state, child, *queue, head, tail;
+	guint32			*fail;
+
+	if (fvalues->len < PATTERN_SET_MIN_SIZE)
+		return NULL;
+
+	fv = (const fvalue_t *)g_ptr_array_index(fvalues, 0);
+	ftype = fv->ftype->ftype;
+	if (IS_FT_STRING(ftype) || ftype == FT_UINT_STRING)
+		strings = TRUE;
+	else if (ftype == FT_BYTES || ftype == FT_UINT_BYTES)
+		strings = FALSE;
+	else
+		return NULL;
+
+	/* An empty member never matches a string, so don't deal with it */
+	total_len = 0;
+	for (i = 0; i < fvalues->len; i++) {
+		fv = (const fvalue_t *)g_ptr_array_index(fvalues, i);
+		if (fv->ftype->ftype != ftype)
+			return NULL;
+		pattern_data(strings, fv, &data, &len);
+		if (len == 0)
+			return NULL;
+		total_len += len;
+		if (total_len >= PATTERN_SET_MAX_STATES)
+			return NULL;
+	}
+
+	set = g_new0(dfvm_pattern_set_t, 1);
+	set->strings = strings;
+	set->cmp_contains = fv->ftype->cmp_contains;
+	set->fvalues = fvalues;
+	set->next = g_new0(guint32, (total_len + 1) * 256);
+	set->match = g_new0(guint8, total_len + 1);
+
+	/* Build the trie of the members; a transition to state 0, the
+	 * root, means that there's no child yet */
+	num_states = 1;
+	for (i = 0; i < fvalues->len; i++) {
+		pattern_data(strings, (const fvalue_t *)g_ptr_array_index(fvalues, i), &data, &len);
+		state = 0;
+		for (j = 0; j < len; j++) {
+			child = set->next[state * 256 + data[j]];
+			if (child == 0) {
+				child = num_states++;
+				set->next[state * 256 + data[j]] = child;
+			}
+			state = child;
+		}
+		set->match[state] = 1;
+	}
+
+	/* Turn it into a DFA, breadth first, so that the failure state of
+	 * each state is complete before the state's children are done */
+	fail = g_new0(guint32, num_states);
+	queue = g_new(guint32, num_states);
+	head = tail = 0;
+	for (c = 0; c < 256; c++) {
+		child = set->next[c];
+		if (child != 0) {
+			fail[child] = 0;
+			queue[tail++] = child;
+		}
+	}
+	while (head < tail) {
+		state = queue[head++];
+		if (set->match[fail[state]])
+			set->match[state] = 1;
+		for (c = 0; c < 256; c++) {
+			child = set->next[state * 256 + c];
+			if (child != 0) {
+				fail[child] = set->next[fail[state] * 256 + c];
+				queue[tail++] = child;
+			}
+			else {
+				set->next[state * 256 + c] = set->next[fail[state] * 256 + c];
+			}
+		}
+	}
+	g_free(queue);
+	g_free(fail);
+
+	return set;
+}
+
+static gboolean
+pattern_set_search(const dfvm_pattern_set_t *set, const guint8 *data, guint len)
+{
+	guint32	state = 0;
+	guint	i;
+
+	for (i = 0; i < len; i++) {
+		state = set->next[state * 256 + data[i]];
+		if (set->match[state])
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/* Can pattern be put in a group, without changing its meaning, as one
+ * alternative of a larger pattern? Be conservative: no back references
+ * or subroutine calls, whose group numbers would change, no inline
+ * options other than caseless, as after (?x) a '#' would comment out
+ * the closing parenthesis, and only ASCII, so that G_REGEX_RAW isn't
+ * needed for the combination. */
+static gboolean
+pcre_pattern_combinable(const char *pattern)
+{
+	const char *p;
+
+	for (p = pattern; *p; p++) {
+		if ((guchar)*p >= 0x80)
+			return FALSE;
+		if (p[0] == '\\') {
+			if (p[1] == 'g' || p[1] == 'k' || (p[1] >= '1' && p[1] <= '9'))
+				return FALSE;
+			if (p[1] != '\0')
+				p++;
+			continue;
+		}
+		if (p[0] != '(' || p[1] != '?')
+			continue;
+		/* (?: (?= (?! (?<= (?<! (?i) and (?i: are fine */
+		if (p[2] == ':' || p[2] == '=' || p[2] == '!')
+			continue;
+		if (p[2] == '<' && (p[3] == '=' || p[3] == '!'))
+			continue;
+		if (p[2] == 'i' && (p[3] == ')' || p[3] == ':'))
+			continue;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+fvalue_t*
+dfvm_pcre_combine(GPtrArray *fvalues)
+{
+	GString		*combined;
+	fvalue_t	*fv;
+	const char	*pattern;
+	gchar		*err_msg = NULL;
+	guint		i;
+
+	if (fvalues->len < PATTERN_SET_MIN_SIZE)
+		return NULL;
+
+	combined = g_string_new(NULL);
+	for (i = 0; i < fvalues->len; i++) {
+		fv = (fvalue_t *)g_ptr_array_index(fvalues, i);
+		if (fv->ftype->ftype != FT_PCRE || fv->value.re == NULL) {
+			g_string_free(combined, TRUE);
+			return NULL;
+		}
+		pattern = g_regex_get_pattern(fv->value.re);
+		if (!pcre_pattern_combinable(pattern)) {
+			g_string_free(combined, TRUE);
+			return NULL;
+		}
+		g_string_append_printf(combined, "%s(?:%s)", i ? "|" : "", pattern);
+	}
+
+	fv = fvalue_from_unparsed(FT_PCRE, combined->str, FALSE, &err_msg);
+	g_string_free(combined, TRUE);
+	if (fv == NULL) {
+		g_free(err_msg);
+		return NULL;
+	}
+
+	for (i = 0; i < fvalues->len; i++) {
+		FVALUE_FREE((fvalue_t *)g_ptr_array_index(fvalues, i));
+	}
+	return fv;
+}
+
 
 void
 dfvm_dump(FILE *f, dfilter_t *df)
@@ -130,6 +489,8 @@ dfvm_dump(FILE *f, dfilter_t *df)
 			case ANY_BITWISE_AND:
 			case ANY_CONTAINS:
 			case ANY_MATCHES:
+			case ANY_IN:
+			case ANY_CONTAINS_SET:
 			case NOT:
 			case RETURN:
 			case IF_TRUE_GOTO:
@@ -264,6 +625,19 @@ dfvm_dump(FILE *f, dfilter_t *df)
 					id, arg1->value.numeric, arg2->value.numeric);
 				break;
 
+			case ANY_IN:
+				fprintf(f, "%05d ANY_IN\t\treg#%u in {%u values <%s>}\n",
+					id, arg1->value.numeric,
+					arg2->value.fvalue_set->fvalues->len,
+					ftype_name(arg2->value.fvalue_set->ftype));
+				break;
+
+			case ANY_CONTAINS_SET:
+				fprintf(f, "%05d ANY_CONTAINS_SET\treg#%u contains any of %u values\n",
+					id, arg1->value.numeric,
+					arg2->value.pattern_set->fvalues->len);
+				break;
+
 			case NOT:
 				fprintf(f, "%05d NOT\n", id);
 				break;
@@ -347,28 +721,129 @@ put_fvalue(dfilter_t *df, fvalue_t *fv, int reg)
 	return TRUE;
 }
 
-typedef gboolean (*FvalueCmpFunc)(const fvalue_t*, const fvalue_t*);
+/* Returns the comparison method of ftype for a comparison opcode. */
+static inline FvalueCmp
+ftype_cmp_func(const ftype_t *ftype, dfvm_opcode_t op)
+{
+	switch (op) {
+		case ANY_EQ:		return ftype->cmp_eq;
+		case ANY_NE:		return ftype->cmp_ne;
+		case ANY_GT:		return ftype->cmp_gt;
+		case ANY_GE:		return ftype->cmp_ge;
+		case ANY_LT:		return ftype->cmp_lt;
+		case ANY_LE:		return ftype->cmp_le;
+		case ANY_BITWISE_AND:	return ftype->cmp_bitwise_and;
+		case ANY_CONTAINS:	return ftype->cmp_contains;
+		case ANY_MATCHES:	return ftype->cmp_matches;
+		default:
+			g_assert_not_reached();
+			return NULL;
+	}
+}
 
+/* Does any value in reg1 compare true against any value in reg2?
+ * The values in a register almost always share an ftype, so the
+ * comparison method is looked up only when the ftype changes rather
+ * than going through fvalue_eq() and friends for every pair. */
 static gboolean
-any_test(dfilter_t *df, FvalueCmpFunc cmp, int reg1, int reg2)
+any_test(dfilter_t *df, dfvm_opcode_t op, int reg1, int reg2)
 {
-	GList	*list_a, *list_b;
+	GList		*list_a, *list_b;
+	const fvalue_t	*a;
+	ftype_t		*ftype = NULL;
+	FvalueCmp	cmp = NULL;
+
+	for (list_a = df->registers[reg1]; list_a; list_a = g_list_next(list_a)) {
+		a = (const fvalue_t *)list_a->data;
+		if (a->ftype != ftype) {
+			ftype = a->ftype;
+			cmp = ftype_cmp_func(ftype, op);
+			/* XXX - check compatibility of a and b */
+			g_assert(cmp);
+		}
+		for (list_b = df->registers[reg2]; list_b; list_b = g_list_next(list_b)) {
+			if (cmp(a, (const fvalue_t *)list_b->data)) {
+				return TRUE;
+			}
+		}
+	}
+	return FALSE;
+}
 
-	list_a = df->registers[reg1];
 
-	while (list_a) {
-		list_b = df->registers[reg2];
-		while (list_b) {
-			if (cmp((fvalue_t *)list_a->data, (fvalue_t *)list_b->data)) {
+/* Is any value in reg equal to a member of set? Values of another
+ * ftype, and IPv4 values that are themselves subnets, are compared
+ * against each member as ANY_EQ would. */
+static gboolean
+any_in(dfilter_t *df, int reg, const dfvm_fvalue_set_t *set)
+{
+	GList		*list_a;
+	const fvalue_t	*a;
+	FvalueCmp	cmp;
+	guint64		key;
+	guint32		addr, nmask;
+	guint		i;
+
+	for (list_a = df->registers[reg]; list_a; list_a = g_list_next(list_a)) {
+		a = (const fvalue_t *)list_a->data;
+		if (a->ftype->ftype != set->ftype ||
+		    (set->ftype == FT_IPv4 && a->value.ipv4.nmask != 0xffffffff)) {
+			cmp = ftype_cmp_func(a->ftype, ANY_EQ);
+			g_assert(cmp);
+			for (i = 0; i < set->fvalues->len; i++) {
+				if (cmp(a, (const fvalue_t *)g_ptr_array_index(set->fvalues, i))) {
+					return TRUE;
+				}
+			}
+		}
+		else if (set->ftype == FT_IPv4) {
+			addr = a->value.ipv4.addr;
+			for (i = 0; i < set->num_masks; i++) {
+				nmask = set->masks[i];
+				if (fvalue_set_lookup(set, ((guint64)nmask << 32) | (addr & nmask))) {
+					return TRUE;
+				}
+			}
+		}
+		else {
+			fvalue_set_key(set->ftype, a, &key);
+			if (fvalue_set_lookup(set, key)) {
 				return TRUE;
 			}
-			list_b = g_list_next(list_b);
 		}
-		list_a = g_list_next(list_a);
 	}
 	return FALSE;
 }
 
+/* Does any value in reg contain a member of set? Values whose ftype
+ * has another contains method are tested against each member. */
+static gboolean
+any_contains_set(dfilter_t *df, int reg, const dfvm_pattern_set_t *set)
+{
+	GList		*list_a;
+	const fvalue_t	*a;
+	const guint8	*data;
+	guint		len, i;
+
+	for (list_a = df->registers[reg]; list_a; list_a = g_list_next(list_a)) {
+		a = (const fvalue_t *)list_a->data;
+		if (a->ftype->cmp_contains == set->cmp_contains) {
+			pattern_data(set->strings, a, &data, &len);
+			if (pattern_set_search(set, data, len)) {
+				return TRUE;
+			}
+		}
+		else {
+			g_assert(a->ftype->cmp_contains);
+			for (i = 0; i < set->fvalues->len; i++) {
+				if (a->ftype->cmp_contains(a, (const fvalue_t *)g_ptr_array_index(set->fvalues, i))) {
+					return TRUE;
+				}
+			}
+		}
+	}
+	return FALSE;
+}
 
 /* Free the list nodes w/o freeing the memory that each
  * list node points to. */
@@ -415,34 +890,248 @@ mk_range(dfilter_t *df, int from_reg, int to_reg, drange_t *d_range)
 
 
 
-gboolean
-dfvm_apply(dfilter_t *df, proto_tree *tree)
+/* Lay df->insns out as an array of dfvm_code_t, terminated by the
+ * filter's RETURN instruction. */
+/*
+ * See if the filter compares a single unsigned integer field with a
+ * constant, which gencode turns into
+ *
+ *	00000 READ_TREE		field -> reg#0
+ *	00001 IF-FALSE-GOTO	3
+ *	00002 ANY_GT		reg#0 > reg#1
+ *	00003 RETURN
+ *
+ * with the constant in reg#1 (or the registers swapped if the constant
+ * came first). Such a filter can be run by dfvm_apply_uint_batch().
+ */
+static void
+find_batch_test(dfilter_t *df)
 {
-	int		id, length;
-	gboolean	accum = TRUE;
-	dfvm_insn_t	*insn;
-	dfvm_value_t	*arg1;
-	dfvm_value_t	*arg2;
-	dfvm_value_t	*arg3 = NULL;
-	dfvm_value_t	*arg4 = NULL;
+	const dfvm_code_t	*code = df->code;
 	header_field_info	*hfinfo;
-	GList		*param1;
-	GList		*param2;
+	fvalue_t		*fv;
+	int			const_reg;
+	gboolean		swapped;
+
+	df->batch_hfinfo = NULL;
+
+	if (df->insns->len != 4 ||
+	    code[0].op != READ_TREE ||
+	    code[1].op != IF_FALSE_GOTO || code[1].reg1 != 3 ||
+	    code[3].op != RETURN)
+		return;
+
+	switch (code[2].op) {
+		case ANY_EQ:
+		case ANY_NE:
+		case ANY_GT:
+		case ANY_GE:
+		case ANY_LT:
+		case ANY_LE:
+		case ANY_BITWISE_AND:
+			break;
+		default:
+			return;
+	}
 
-	g_assert(tree);
+	/* A name registered more than once would need all its fields */
+	hfinfo = code[0].hfinfo;
+	if (!IS_FT_UINT(hfinfo->type) ||
+	    hfinfo->same_name_prev_id != -1 || hfinfo->same_name_next != NULL)
+		return;
+
+	if (code[2].reg1 == code[0].reg1) {
+		const_reg = code[2].reg2;
+		swapped = FALSE;
+	} else if (code[2].reg2 == code[0].reg1) {
+		const_reg = code[2].reg1;
+		swapped = TRUE;
+	} else {
+		return;
+	}
+	if (const_reg < (int)df->num_registers || df->registers[const_reg] == NULL ||
+	    df->registers[const_reg]->next != NULL)
+		return;
+
+	fv = (fvalue_t *)df->registers[const_reg]->data;
+	if (IS_FT_UINT32(fvalue_type_ftenum(fv)))
+		df->batch_value = fvalue_get_uinteger(fv);
+	else if (IS_FT_UINT(fvalue_type_ftenum(fv)))
+		df->batch_value = fvalue_get_uinteger64(fv);
+	else
+		return;
+
+	df->batch_op = code[2].op;
+	if (swapped) {
+		/* "100 < frame.len" is "frame.len > 100" */
+		switch (code[2].op) {
+			case ANY_GT: df->batch_op = ANY_LT; break;
+			case ANY_GE: df->batch_op = ANY_LE; break;
+			case ANY_LT: df->batch_op = ANY_GT; break;
+			case ANY_LE: df->batch_op = ANY_GE; break;
+			default: break;
+		}
+	}
+	df->batch_hfinfo = hfinfo;
+}
+
+/*
+ * Set a bit in matches for each value the test is true for, 32 values
+ * to a word; simple enough loops for the compiler to vectorize.
+ */
+#define BATCH_LOOP(test) \
+	for (i = 0; i < count; i += 32) { \
+		n = MIN(count - i, 32); \
+		bits = 0; \
+		for (j = 0; j < n; j++) \
+			bits |= (guint32)(test) << j; \
+		matches[i / 32] = bits; \
+	}
+
+void
+dfvm_apply_uint_batch(const dfilter_t *df, const guint64 *values, guint count, guint32 *matches)
+{
+	const guint64	c = df->batch_value;
+	guint		i, j, n;
+	guint32		bits;
+
+	g_assert(df->batch_hfinfo);
+
+	switch (df->batch_op) {
+		case ANY_EQ:
+			BATCH_LOOP(values[i + j] == c);
+			break;
+		case ANY_NE:
+			BATCH_LOOP(values[i + j] != c);
+			break;
+		case ANY_GT:
+			BATCH_LOOP(values[i + j] > c);
+			break;
+		case ANY_GE:
+			BATCH_LOOP(values[i + j] >= c);
+			break;
+		case ANY_LT:
+			BATCH_LOOP(values[i + j] < c);
+			break;
+		case ANY_LE:
+			BATCH_LOOP(values[i + j] <= c);
+			break;
+		case ANY_BITWISE_AND:
+			BATCH_LOOP((values[i + j] & c) != 0);
+			break;
+		default:
+			g_assert_not_reached();
+	}
+}
+
+void
+dfvm_compile(dfilter_t *df)
+{
+	int		id, length;
+	dfvm_insn_t	*insn;
+	dfvm_code_t	*code;
 
 	length = df->insns->len;
+	df->code = g_new0(dfvm_code_t, length);
 
 	for (id = 0; id < length; id++) {
+		insn = (dfvm_insn_t *)g_ptr_array_index(df->insns, id);
+		code = &df->code[id];
 
-	  AGAIN:
-		insn = (dfvm_insn_t	*)g_ptr_array_index(df->insns, id);
-		arg1 = insn->arg1;
-		arg2 = insn->arg2;
+		code->op = insn->op;
+		code->reg1 = code->reg2 = code->reg3 = code->reg4 = -1;
 
 		switch (insn->op) {
 			case CHECK_EXISTS:
-				hfinfo = arg1->value.hfinfo;
+				code->hfinfo = insn->arg1->value.hfinfo;
+				break;
+
+			case READ_TREE:
+				code->hfinfo = insn->arg1->value.hfinfo;
+				code->reg1 = insn->arg2->value.numeric;
+				break;
+
+			case CALL_FUNCTION:
+				code->funcdef = insn->arg1->value.funcdef;
+				code->reg1 = insn->arg2->value.numeric;
+				if (insn->arg3) {
+					code->reg3 = insn->arg3->value.numeric;
+				}
+				if (insn->arg4) {
+					code->reg4 = insn->arg4->value.numeric;
+				}
+				break;
+
+			case MK_RANGE:
+				code->reg1 = insn->arg1->value.numeric;
+				code->reg2 = insn->arg2->value.numeric;
+				code->drange = insn->arg3->value.drange;
+				break;
+
+			case ANY_EQ:
+			case ANY_NE:
+			case ANY_GT:
+			case ANY_GE:
+			case ANY_LT:
+			case ANY_LE:
+			case ANY_BITWISE_AND:
+			case ANY_CONTAINS:
+			case ANY_MATCHES:
+				code->reg1 = insn->arg1->value.numeric;
+				code->reg2 = insn->arg2->value.numeric;
+				break;
+
+			case ANY_IN:
+				code->reg1 = insn->arg1->value.numeric;
+				code->fvalue_set = insn->arg2->value.fvalue_set;
+				break;
+
+			case ANY_CONTAINS_SET:
+				code->reg1 = insn->arg1->value.numeric;
+				code->pattern_set = insn->arg2->value.pattern_set;
+				break;
+
+			case IF_TRUE_GOTO:
+			case IF_FALSE_GOTO:
+				g_assert(insn->arg1->value.numeric < (guint32)length);
+				code->reg1 = insn->arg1->value.numeric;
+				break;
+
+			case NOT:
+			case RETURN:
+				break;
+
+			case PUT_FVALUE:
+				/* These are in df->consts, not df->insns */
+			default:
+				g_assert_not_reached();
+				break;
+		}
+	}
+
+	g_assert(length > 0 && df->code[length - 1].op == RETURN);
+
+	find_batch_test(df);
+}
+
+gboolean
+dfvm_apply(dfilter_t *df, proto_tree *tree)
+{
+	gboolean		accum = TRUE;
+	const dfvm_code_t	*code;
+	header_field_info	*hfinfo;
+	GList			*param1;
+	GList			*param2;
+
+	g_assert(tree);
+	g_assert(df->code);
+
+	for (code = df->code; ; code++) {
+
+	  AGAIN:
+		switch (code->op) {
+			case CHECK_EXISTS:
+				hfinfo = code->hfinfo;
 				while(hfinfo) {
 					accum = proto_check_for_protocol_or_field(tree,
 							hfinfo->id);
@@ -456,75 +1145,44 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 				break;
 
 			case READ_TREE:
-				accum = read_tree(df, tree,
-						arg1->value.hfinfo, arg2->value.numeric);
+				accum = read_tree(df, tree, code->hfinfo, code->reg1);
 				break;
 
 			case CALL_FUNCTION:
-				arg3 = insn->arg3;
-				arg4 = insn->arg4;
 				param1 = NULL;
 				param2 = NULL;
-				if (arg3) {
-					param1 = df->registers[arg3->value.numeric];
+				if (code->reg3 >= 0) {
+					param1 = df->registers[code->reg3];
 				}
-				if (arg4) {
-					param2 = df->registers[arg4->value.numeric];
+				if (code->reg4 >= 0) {
+					param2 = df->registers[code->reg4];
 				}
-				accum = arg1->value.funcdef->function(param1, param2,
-						&df->registers[arg2->value.numeric]);
+				accum = code->funcdef->function(param1, param2,
+						&df->registers[code->reg1]);
 				break;
 
 			case MK_RANGE:
-				arg3 = insn->arg3;
-				mk_range(df,
-						arg1->value.numeric, arg2->value.numeric,
-						arg3->value.drange);
+				mk_range(df, code->reg1, code->reg2, code->drange);
 				break;
 
 			case ANY_EQ:
-				accum = any_test(df, fvalue_eq,
-						arg1->value.numeric, arg2->value.numeric);
-				break;
-
 			case ANY_NE:
-				accum = any_test(df, fvalue_ne,
-						arg1->value.numeric, arg2->value.numeric);
-				break;
-
 			case ANY_GT:
-				accum = any_test(df, fvalue_gt,
-						arg1->value.numeric, arg2->value.numeric);
-				break;
-
 			case ANY_GE:
-				accum = any_test(df, fvalue_ge,
-						arg1->value.numeric, arg2->value.numeric);
-				break;
-
 			case ANY_LT:
-				accum = any_test(df, fvalue_lt,
-						arg1->value.numeric, arg2->value.numeric);
-				break;
-
 			case ANY_LE:
-				accum = any_test(df, fvalue_le,
-						arg1->value.numeric, arg2->value.numeric);
-				break;
-
 			case ANY_BITWISE_AND:
-				accum = any_test(df, fvalue_bitwise_and,
-						arg1->value.numeric, arg2->value.numeric);
+			case ANY_CONTAINS:
+			case ANY_MATCHES:
+				accum = any_test(df, code->op, code->reg1, code->reg2);
 				break;
 
-			case ANY_CONTAINS:
-				accum = any_test(df, fvalue_contains,
-						arg1->value.numeric, arg2->value.numeric);
+			case ANY_IN:
+				accum = any_in(df, code->reg1, code->fvalue_set);
 				break;
 
-			case ANY_MATCHES:
-				accum = any_test(df, fvalue_matches,
-						arg1->value.numeric, arg2->value.numeric);
+			case ANY_CONTAINS_SET:
+				accum = any_contains_set(df, code->reg1, code->pattern_set);
 				break;
 
 			case NOT:
@@ -537,26 +1195,20 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 
 			case IF_TRUE_GOTO:
 				if (accum) {
-					id = arg1->value.numeric;
+					code = &df->code[code->reg1];
 					goto AGAIN;
 				}
 				break;
 
 			case IF_FALSE_GOTO:
 				if (!accum) {
-					id = arg1->value.numeric;
+					code = &df->code[code->reg1];
 					goto AGAIN;
 				}
 				break;
 
 			case PUT_FVALUE:
-#if 0
 				/* These were handled in the constants initialization */
-				accum = put_fvalue(df,
-						arg1->value.fvalue, arg2->value.numeric);
-				break;
-#endif
-
 			default:
 				g_assert_not_reached();
 				break;
@@ -601,6 +1253,8 @@ dfvm_init_const(dfilter_t *df)
 			case ANY_BITWISE_AND:
 			case ANY_CONTAINS:
 			case ANY_MATCHES:
+			case ANY_IN:
+			case ANY_CONTAINS_SET:
 			case NOT:
 			case RETURN:
 			case IF_TRUE_GOTO:
@@ -27,6 +27,14 @@
 #include "drange.h"
 #include "dfunctions.h"
 
+/* A constant set of values for the "in" operator that can be searched
+ * rather than compared against one member at a time. */
+typedef struct _dfvm_fvalue_set dfvm_fvalue_set_t;
+
+/* A set of constant strings or byte sequences for OR-ed "contains"
+ * tests of one field, searched for in a single pass over each value. */
+typedef struct _dfvm_pattern_set dfvm_pattern_set_t;
+
 typedef enum {
 	EMPTY,
 	FVALUE,
@@ -35,7 +43,9 @@ typedef enum {
 	REGISTER,
 	INTEGER,
 	DRANGE,
-	FUNCTION_DEF
+	FUNCTION_DEF,
+	FVALUE_SET,
+	PATTERN_SET
 } dfvm_value_type_t;
 
 typedef struct {
@@ -47,6 +57,8 @@ typedef struct {
 		drange_t		*drange;
 		header_field_info	*hfinfo;
         df_func_def_t   *funcdef;
+		dfvm_fvalue_set_t	*fvalue_set;
+		dfvm_pattern_set_t	*pattern_set;
 	} value;
 
 } dfvm_value_t;
@@ -70,6 +82,8 @@ typedef enum {
 	ANY_BITWISE_AND,
 	ANY_CONTAINS,
 	ANY_MATCHES,
+	ANY_IN,
+	ANY_CONTAINS_SET,
 	MK_RANGE,
     CALL_FUNCTION
 
@@ -84,6 +98,23 @@ typedef struct {
 	dfvm_value_t	*arg4;
 } dfvm_insn_t;
 
+/* An instruction as run by dfvm_apply(): dfvm_compile() lays the
+ * instructions of a filter out in one array, with their operands
+ * resolved, so that running the filter doesn't have to chase
+ * dfvm_value_t pointers. */
+typedef struct _dfvm_code {
+	dfvm_opcode_t		op;
+	int			reg1;	/* or jump target */
+	int			reg2;
+	int			reg3;	/* -1 if not used */
+	int			reg4;	/* -1 if not used */
+	header_field_info	*hfinfo;
+	df_func_def_t		*funcdef;
+	drange_t		*drange;
+	dfvm_fvalue_set_t	*fvalue_set;
+	dfvm_pattern_set_t	*pattern_set;
+} dfvm_code_t;
+
 dfvm_insn_t*
 dfvm_insn_new(dfvm_opcode_t op);
 
@@ -93,6 +124,24 @@ dfvm_insn_free(dfvm_insn_t *insn);
 dfvm_value_t*
 dfvm_value_new(dfvm_value_type_t type);
 
+/* Builds a searchable set from an array of fvalue_t's of one ftype.
+ * Returns NULL, leaving the fvalues to the caller, if the set is too
+ * small to be worth it or its ftype can't be searched; otherwise the
+ * set takes ownership of the array and its fvalues. */
+dfvm_fvalue_set_t*
+dfvm_fvalue_set_new(GPtrArray *fvalues);
+
+/* Builds a pattern set from the right-hand sides of "contains" tests,
+ * with the same ownership rules as dfvm_fvalue_set_new(). */
+dfvm_pattern_set_t*
+dfvm_pattern_set_new(GPtrArray *fvalues);
+
+/* Combines the FT_PCRE fvalues of "matches" tests into one FT_PCRE
+ * matching any of them. Returns NULL if the patterns can't safely be
+ * combined; otherwise the fvalues are freed and the array is not. */
+fvalue_t*
+dfvm_pcre_combine(GPtrArray *fvalues);
+
 void
 dfvm_dump(FILE *f, dfilter_t *df);
 
@@ -102,4 +151,10 @@ dfvm_apply(dfilter_t *df, proto_tree *tree);
 void
 dfvm_init_const(dfilter_t *df);
 
+void
+dfvm_compile(dfilter_t *df);
+
+void
+dfvm_apply_uint_batch(const dfilter_t *df, const guint64 *values, guint count, guint32 *matches);
+
 #endif
@@ -289,8 +289,35 @@ fixup_jumps(gpointer data, gpointer user_data)
 	}
 }
 
+/* If every item of the set is a constant, try to make a searchable set
+ * of them, taking the fvalues from the set's nodes. */
+static dfvm_fvalue_set_t *
+gen_fvalue_set(GSList *nodelist)
+{
+	GPtrArray		*fvalues;
+	dfvm_fvalue_set_t	*set;
+	stnode_t		*node;
+	GSList			*l;
+
+	fvalues = g_ptr_array_new();
+	for (l = nodelist; l; l = g_slist_next(l)) {
+		node = (stnode_t*)l->data;
+		if (stnode_type_id(node) != STTYPE_FVALUE) {
+			g_ptr_array_free(fvalues, TRUE);
+			return NULL;
+		}
+		g_ptr_array_add(fvalues, stnode_data(node));
+	}
+
+	set = dfvm_fvalue_set_new(fvalues);
+	if (!set)
+		g_ptr_array_free(fvalues, TRUE);
+	return set;
+}
+
 /* Generate the code for the in operator.  It behaves much like an OR-ed
- * series of == tests, but without the redundant existence checks. */
+ * series of == tests, but without the redundant existence checks.
+ * A large set of constants is searched by one ANY_IN instead. */
 static void
 gen_relation_in(dfwork_t *dfw, stnode_t *st_arg1, stnode_t *st_arg2)
 {
@@ -301,10 +328,30 @@ gen_relation_in(dfwork_t *dfw, stnode_t *st_arg1, stnode_t *st_arg2)
 	stnode_t	*node;
 	GSList		*nodelist;
 	GSList		*jumplist = NULL;
+	dfvm_fvalue_set_t *set;
 
 	/* Create code for the LHS of the relation */
 	reg1 = gen_entity(dfw, st_arg1, &jmp1);
 
+	set = gen_fvalue_set((GSList*)stnode_data(st_arg2));
+	if (set) {
+		insn = dfvm_insn_new(ANY_IN);
+		val1 = dfvm_value_new(REGISTER);
+		val1->value.numeric = reg1;
+		val2 = dfvm_value_new(FVALUE_SET);
+		val2->value.fvalue_set = set;
+		insn->arg1 = val1;
+		insn->arg2 = val2;
+		dfw_append_insn(dfw, insn);
+
+		/* Jump here if the LHS entity was not present */
+		if (jmp1) {
+			jmp1->value.numeric = dfw->next_insn_id;
+		}
+		set_nodelist_free((GSList*)stnode_data(st_arg2));
+		return;
+	}
+
 	/* Create code for the set on the RHS of the relation */
 	nodelist = (GSList*)stnode_data(st_arg2);
 	while (nodelist) {
@@ -392,6 +439,200 @@ gen_entity(dfwork_t *dfw, stnode_t *st_arg, dfvm_value_t **p_jmp)
 }
 
 
+/* The OR-ed "contains" or "matches" tests of one field against
+ * constants, to be run as one test. */
+typedef struct {
+	test_op_t		op;
+	header_field_info	*hfinfo;
+	GPtrArray		*tests;		/* of stnode_t */
+	dfvm_pattern_set_t	*pattern_set;	/* for "contains" */
+	fvalue_t		*pcre;		/* for "matches" */
+} pattern_group_t;
+
+/* Collect the operands of a chain of ORs. */
+static void
+collect_or_tests(stnode_t *st_node, GPtrArray *tests)
+{
+	test_op_t	st_op;
+	stnode_t	*st_arg1, *st_arg2;
+
+	sttype_test_get(st_node, &st_op, &st_arg1, &st_arg2);
+	if (st_op == TEST_OP_OR) {
+		collect_or_tests(st_arg1, tests);
+		collect_or_tests(st_arg2, tests);
+	}
+	else {
+		g_ptr_array_add(tests, st_node);
+	}
+}
+
+/* If st_node is a "contains" or "matches" test of a field against a
+ * constant, return the field. */
+static header_field_info *
+pattern_test_field(stnode_t *st_node, test_op_t *p_op)
+{
+	stnode_t	*st_arg1, *st_arg2;
+
+	sttype_test_get(st_node, p_op, &st_arg1, &st_arg2);
+	if ((*p_op != TEST_OP_CONTAINS && *p_op != TEST_OP_MATCHES) ||
+	    stnode_type_id(st_arg1) != STTYPE_FIELD ||
+	    stnode_type_id(st_arg2) != STTYPE_FVALUE) {
+		return NULL;
+	}
+	return (header_field_info*)stnode_data(st_arg1);
+}
+
+static pattern_group_t *
+find_pattern_group(GPtrArray *groups, test_op_t op, header_field_info *hfinfo)
+{
+	pattern_group_t	*group;
+	guint		i;
+
+	for (i = 0; i < groups->len; i++) {
+		group = (pattern_group_t*)g_ptr_array_index(groups, i);
+		if (group->op == op && group->hfinfo == hfinfo) {
+			return group;
+		}
+	}
+	return NULL;
+}
+
+static void
+pattern_group_free(gpointer data)
+{
+	pattern_group_t	*group = (pattern_group_t*)data;
+
+	g_ptr_array_free(group->tests, TRUE);
+	g_free(group);
+}
+
+static void
+gen_pattern_group(dfwork_t *dfw, pattern_group_t *group)
+{
+	test_op_t	st_op;
+	stnode_t	*st_arg1, *st_arg2;
+	dfvm_insn_t	*insn;
+	dfvm_value_t	*val1, *val2;
+	dfvm_value_t	*jmp1 = NULL;
+	int		reg1;
+
+	sttype_test_get((stnode_t*)g_ptr_array_index(group->tests, 0),
+			&st_op, &st_arg1, &st_arg2);
+	reg1 = gen_entity(dfw, st_arg1, &jmp1);
+
+	val1 = dfvm_value_new(REGISTER);
+	val1->value.numeric = reg1;
+	if (group->pattern_set) {
+		insn = dfvm_insn_new(ANY_CONTAINS_SET);
+		val2 = dfvm_value_new(PATTERN_SET);
+		val2->value.pattern_set = group->pattern_set;
+	}
+	else {
+		insn = dfvm_insn_new(ANY_MATCHES);
+		val2 = dfvm_value_new(REGISTER);
+		val2->value.numeric = dfw_append_put_fvalue(dfw, group->pcre);
+	}
+	insn->arg1 = val1;
+	insn->arg2 = val2;
+	dfw_append_insn(dfw, insn);
+
+	if (jmp1) {
+		jmp1->value.numeric = dfw->next_insn_id;
+	}
+}
+
+/* Generate the code for a chain of ORs in which several operands test
+ * the same field with "contains", or with "matches", so that each such
+ * group is run as one test that scans the field's values once.
+ * Returns FALSE, having generated nothing, if there's no such group. */
+static gboolean
+gen_or_pattern_groups(dfwork_t *dfw, stnode_t *st_node)
+{
+	GPtrArray	*tests, *groups, *fvalues;
+	pattern_group_t	*group;
+	header_field_info *hfinfo;
+	test_op_t	st_op;
+	stnode_t	*test, *st_arg1, *st_arg2;
+	dfvm_insn_t	*insn;
+	dfvm_value_t	*val1;
+	GSList		*jumplist = NULL;
+	gboolean	combined = FALSE;
+	guint		i, j;
+
+	tests = g_ptr_array_new();
+	collect_or_tests(st_node, tests);
+
+	groups = g_ptr_array_new_with_free_func(pattern_group_free);
+	for (i = 0; i < tests->len; i++) {
+		test = (stnode_t*)g_ptr_array_index(tests, i);
+		hfinfo = pattern_test_field(test, &st_op);
+		if (!hfinfo)
+			continue;
+		group = find_pattern_group(groups, st_op, hfinfo);
+		if (!group) {
+			group = g_new0(pattern_group_t, 1);
+			group->op = st_op;
+			group->hfinfo = hfinfo;
+			group->tests = g_ptr_array_new();
+			g_ptr_array_add(groups, group);
+		}
+		g_ptr_array_add(group->tests, test);
+	}
+
+	for (i = 0; i < groups->len; i++) {
+		group = (pattern_group_t*)g_ptr_array_index(groups, i);
+		fvalues = g_ptr_array_new();
+		for (j = 0; j < group->tests->len; j++) {
+			sttype_test_get((stnode_t*)g_ptr_array_index(group->tests, j),
+					&st_op, &st_arg1, &st_arg2);
+			g_ptr_array_add(fvalues, stnode_data(st_arg2));
+		}
+		if (group->op == TEST_OP_CONTAINS) {
+			group->pattern_set = dfvm_pattern_set_new(fvalues);
+			if (!group->pattern_set)
+				g_ptr_array_free(fvalues, TRUE);
+		}
+		else {
+			group->pcre = dfvm_pcre_combine(fvalues);
+			g_ptr_array_free(fvalues, TRUE);
+		}
+		if (group->pattern_set || group->pcre)
+			combined = TRUE;
+	}
+
+	if (combined) {
+		for (i = 0; i < tests->len; i++) {
+			test = (stnode_t*)g_ptr_array_index(tests, i);
+			hfinfo = pattern_test_field(test, &st_op);
+			group = hfinfo ? find_pattern_group(groups, st_op, hfinfo) : NULL;
+			if (group && !group->pattern_set && !group->pcre)
+				group = NULL;
+			if (group && g_ptr_array_index(group->tests, 0) != test)
+				continue;
+
+			/* Exit as soon as one of the operands is true */
+			if (i > 0) {
+				insn = dfvm_insn_new(IF_TRUE_GOTO);
+				val1 = dfvm_value_new(INSN_NUMBER);
+				insn->arg1 = val1;
+				dfw_append_insn(dfw, insn);
+				jumplist = g_slist_prepend(jumplist, val1);
+			}
+
+			if (group)
+				gen_pattern_group(dfw, group);
+			else
+				gencode(dfw, test);
+		}
+		g_slist_foreach(jumplist, fixup_jumps, dfw);
+		g_slist_free(jumplist);
+	}
+
+	g_ptr_array_free(groups, TRUE);
+	g_ptr_array_free(tests, TRUE);
+	return combined;
+}
+
 static void
 gen_test(dfwork_t *dfw, stnode_t *st_node)
 {
@@ -451,6 +692,9 @@ gen_test(dfwork_t *dfw, stnode_t *st_node)
 			break;
 
 		case TEST_OP_OR:
+			if (gen_or_pattern_groups(dfw, st_node))
+				break;
+
 			gencode(dfw, st_arg1);
 
 			insn = dfvm_insn_new(IF_TRUE_GOTO);
@@ -645,6 +889,55 @@ dfw_interesting_fields(dfwork_t *dfw, int *caller_num_fields)
 	return hki.fields;
 }
 
+/* Add the protocols tested for by "proto" or "proto && ..." to protocols */
+static void
+find_required_protocols(stnode_t *node, GArray *protocols)
+{
+	test_op_t		op;
+	stnode_t		*st_arg1, *st_arg2;
+	header_field_info	*hfinfo;
+
+	if (stnode_type_id(node) != STTYPE_TEST)
+		return;
+
+	sttype_test_get(node, &op, &st_arg1, &st_arg2);
+	switch (op) {
+		case TEST_OP_AND:
+			find_required_protocols(st_arg1, protocols);
+			find_required_protocols(st_arg2, protocols);
+			break;
+
+		case TEST_OP_EXISTS:
+			if (stnode_type_id(st_arg1) != STTYPE_FIELD)
+				break;
+			/* A name registered more than once is there if
+			 * any of its protocols is */
+			hfinfo = (header_field_info *)stnode_data(st_arg1);
+			if (hfinfo->type == FT_PROTOCOL &&
+			    hfinfo->same_name_prev_id == -1 && hfinfo->same_name_next == NULL)
+				g_array_append_val(protocols, hfinfo->id);
+			break;
+
+		default:
+			/* A field can be put in the tree by a dissector
+			 * other than its protocol's, so only a test for the
+			 * protocol itself says the protocol must be there. */
+			break;
+	}
+}
+
+int*
+dfw_required_protocols(dfwork_t *dfw, int *caller_num_protocols)
+{
+	GArray	*protocols;
+
+	protocols = g_array_new(FALSE, FALSE, sizeof(int));
+	find_required_protocols(dfw->st_root, protocols);
+
+	*caller_num_protocols = protocols->len;
+	return (int *)g_array_free(protocols, protocols->len == 0);
+}
+
 /*
  * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
  *
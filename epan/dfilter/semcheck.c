@@ -152,10 +152,38 @@ compatible_ftypes(ftenum_t a, ftenum_t b)
 	return FALSE;
 }
 
+/*
+ * Addresses can be given as host names, which are resolved now; what they
+ * resolve to may change, so note that the filter shouldn't be cached.
+ * Anything but a plain numeric address is treated as a name.
+ */
+static void
+check_host_name(dfwork_t *dfw, ftenum_t ftype, const char *s)
+{
+	const char *p;
+
+	if (ftype == FT_IPv4) {
+		for (p = s; *p != '\0'; p++) {
+			if (!g_ascii_isdigit(*p) && *p != '.' && *p != '/')
+				dfw->uses_host_names = TRUE;
+		}
+	} else if (ftype == FT_IPv6) {
+		/* "beef" is a name, not an address */
+		if (strchr(s, ':') == NULL)
+			dfw->uses_host_names = TRUE;
+		for (p = s; *p != '\0'; p++) {
+			if (!g_ascii_isxdigit(*p) && *p != ':' && *p != '.' && *p != '/')
+				dfw->uses_host_names = TRUE;
+		}
+	}
+}
+
 /* Gets an fvalue from a string, and sets the error message on failure. */
 static fvalue_t*
 dfilter_fvalue_from_unparsed(dfwork_t *dfw, ftenum_t ftype, const char *s, gboolean allow_partial_value)
 {
+	check_host_name(dfw, ftype, s);
+
 	/*
 	 * Don't set the error message if it's already set.
 	 */
@@ -167,6 +195,8 @@ dfilter_fvalue_from_unparsed(dfwork_t *dfw, ftenum_t ftype, const char *s, gbool
 static fvalue_t*
 dfilter_fvalue_from_string(dfwork_t *dfw, ftenum_t ftype, const char *s)
 {
+	check_host_name(dfw, ftype, s);
+
 	return fvalue_from_string(ftype, s,
 	    dfw->error_message == NULL ? &dfw->error_message : NULL);
 }
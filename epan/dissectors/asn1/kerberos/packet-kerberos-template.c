@@ -286,6 +286,38 @@ add_encryption_key(packet_info *pinfo, int keytype, int keylength, const char *k
 	/*XXX this needs to be freed later */
 	new_key->keyvalue=(char *)g_memdup(keyvalue, keylength);
 }
+
+/*
+ * The key that last decrypted something with each key usage.  It is tried
+ * before the others, as with a big keytab most of the time would otherwise
+ * go into trying keys that don't fit.  Keys are never freed, so at worst a
+ * hint is tried in vain.
+ */
+#define KRB_KEY_USAGE_HINTS 64
+static enc_key_t *krb_key_usage_hints[KRB_KEY_USAGE_HINTS];
+
+static enc_key_t *
+krb_key_usage_hint(int usage, int keytype)
+{
+	enc_key_t *ek;
+
+	if (usage < 0 || usage >= KRB_KEY_USAGE_HINTS) {
+		return NULL;
+	}
+	ek = krb_key_usage_hints[usage];
+	if (ek && (keytype != -1) && (ek->keytype != keytype)) {
+		return NULL;
+	}
+	return ek;
+}
+
+static void
+krb_set_key_usage_hint(int usage, enc_key_t *ek)
+{
+	if (usage >= 0 && usage < KRB_KEY_USAGE_HINTS) {
+		krb_key_usage_hints[usage] = ek;
+	}
+}
 #endif /* HAVE_HEIMDAL_KERBEROS || HAVE_MIT_KERBEROS */
 
 #if defined(HAVE_MIT_KERBEROS)
@@ -362,6 +394,21 @@ read_keytab_file(const char *filename)
 	}
 }
 
+static gboolean
+decrypt_krb5_with_key(enc_key_t *ek, int usage, const guint8 *cryptotext, int length, krb5_data *data)
+{
+	krb5_enc_data input;
+	krb5_keytab_entry key;
+
+	input.enctype = ek->keytype;
+	input.ciphertext.length = length;
+	input.ciphertext.data = (guint8 *)cryptotext;
+
+	key.key.enctype=ek->keytype;
+	key.key.length=ek->keylength;
+	key.key.contents=ek->keyvalue;
+	return krb5_c_decrypt(krb5_ctx, &(key.key), usage, 0, &input, data) == 0;
+}
 
 guint8 *
 decrypt_krb5_data(proto_tree *tree _U_, packet_info *pinfo,
@@ -370,10 +417,8 @@ decrypt_krb5_data(proto_tree *tree _U_, packet_info *pinfo,
 					int keytype,
 					int *datalen)
 {
-	krb5_error_code ret;
-	enc_key_t *ek;
+	enc_key_t *ek, *hint;
 	krb5_data data = {0,0,NULL};
-	krb5_keytab_entry key;
 	int length = tvb_captured_length(cryptotvb);
 	const guint8 *cryptotext = tvb_get_ptr(cryptotvb, 0, length);
 
@@ -391,38 +436,36 @@ decrypt_krb5_data(proto_tree *tree _U_, packet_info *pinfo,
 	data.data = (char *)wmem_alloc(pinfo->pool, length);
 	data.length = length;
 
-	for(ek=enc_key_list;ek;ek=ek->next){
-		krb5_enc_data input;
-
-		/* shortcircuit and bail out if enctypes are not matching */
-		if((keytype != -1) && (ek->keytype != keytype)) {
-			continue;
-		}
-
-		input.enctype = ek->keytype;
-		input.ciphertext.length = length;
-		input.ciphertext.data = (guint8 *)cryptotext;
-
-		key.key.enctype=ek->keytype;
-		key.key.length=ek->keylength;
-		key.key.contents=ek->keyvalue;
-		ret = krb5_c_decrypt(krb5_ctx, &(key.key), usage, 0, &input, &data);
-		if(ret == 0){
-			char *user_data;
-
-			expert_add_info_format(pinfo, NULL, &ei_kerberos_decrypted_keytype,
-								   "Decrypted keytype %d in frame %u using %s",
-								   ek->keytype, pinfo->num, ek->key_origin);
-
-			user_data=data.data;
-			if (datalen) {
-				*datalen = data.length;
+	hint = krb_key_usage_hint(usage, keytype);
+	if (hint && decrypt_krb5_with_key(hint, usage, cryptotext, length, &data)) {
+		ek = hint;
+	} else {
+		for(ek=enc_key_list;ek;ek=ek->next){
+			/* shortcircuit and bail out if enctypes are not matching */
+			if((keytype != -1) && (ek->keytype != keytype)) {
+				continue;
+			}
+			if (ek == hint) {
+				continue;
+			}
+			if (decrypt_krb5_with_key(ek, usage, cryptotext, length, &data)) {
+				break;
 			}
-			return user_data;
 		}
 	}
+	if (ek == NULL) {
+		return NULL;
+	}
+	krb_set_key_usage_hint(usage, ek);
 
-	return NULL;
+	expert_add_info_format(pinfo, NULL, &ei_kerberos_decrypted_keytype,
+						   "Decrypted keytype %d in frame %u using %s",
+						   ek->keytype, pinfo->num, ek->key_origin);
+
+	if (datalen) {
+		*datalen = data.length;
+	}
+	return data.data;
 }
 USES_APPLE_RST
 
@@ -502,6 +545,38 @@ read_keytab_file(const char *filename)
 USES_APPLE_RST
 
 
+/* Returns 0 if ek decrypted the data, 1 if it didn't, and -1 on error */
+static int
+decrypt_krb5_with_key(enc_key_t *ek, int usage, const guint8 *cryptotext, int length, krb5_data *data)
+{
+	krb5_error_code ret;
+	krb5_keytab_entry key;
+	krb5_crypto crypto;
+	guint8 *cryptocopy; /* workaround for pre-0.6.1 heimdal bug */
+
+	key.keyblock.keytype=ek->keytype;
+	key.keyblock.keyvalue.length=ek->keylength;
+	key.keyblock.keyvalue.data=ek->keyvalue;
+	ret = krb5_crypto_init(krb5_ctx, &(key.keyblock), (krb5_enctype)ENCTYPE_NULL, &crypto);
+	if(ret){
+		return -1;
+	}
+
+	/* pre-0.6.1 versions of Heimdal would sometimes change
+	   the cryptotext data even when the decryption failed.
+	   This would obviously not work since we iterate over the
+	   keys. So just give it a copy of the crypto data instead.
+	   This has been seen for RC4-HMAC blobs.
+	*/
+	cryptocopy = (guint8 *)wmem_memdup(wmem_packet_scope(), cryptotext, length);
+	ret = krb5_decrypt_ivec(krb5_ctx, crypto, usage,
+							cryptocopy, length,
+							data,
+							NULL);
+	krb5_crypto_destroy(krb5_ctx, crypto);
+	return ((ret == 0) && (length>0)) ? 0 : 1;
+}
+
 guint8 *
 decrypt_krb5_data(proto_tree *tree _U_, packet_info *pinfo,
 					int usage,
@@ -509,9 +584,10 @@ decrypt_krb5_data(proto_tree *tree _U_, packet_info *pinfo,
 					int keytype,
 					int *datalen)
 {
-	krb5_error_code ret;
+	int ret = 1;
 	krb5_data data;
-	enc_key_t *ek;
+	enc_key_t *ek, *hint;
+	char *user_data;
 	int length = tvb_captured_length(cryptotvb);
 	const guint8 *cryptotext = tvb_get_ptr(cryptotvb, 0, length);
 
@@ -527,53 +603,45 @@ decrypt_krb5_data(proto_tree *tree _U_, packet_info *pinfo,
 
 	read_keytab_file_from_preferences();
 
-	for(ek=enc_key_list;ek;ek=ek->next){
-		krb5_keytab_entry key;
-		krb5_crypto crypto;
-		guint8 *cryptocopy; /* workaround for pre-0.6.1 heimdal bug */
-
-		/* shortcircuit and bail out if enctypes are not matching */
-		if((keytype != -1) && (ek->keytype != keytype)) {
-			continue;
+	hint = krb_key_usage_hint(usage, keytype);
+	if (hint) {
+		ret = decrypt_krb5_with_key(hint, usage, cryptotext, length, &data);
+	}
+	if (ret == 0) {
+		ek = hint;
+	} else {
+		for(ek=enc_key_list;ek;ek=ek->next){
+			/* shortcircuit and bail out if enctypes are not matching */
+			if((keytype != -1) && (ek->keytype != keytype)) {
+				continue;
+			}
+			if (ek == hint) {
+				continue;
+			}
+			ret = decrypt_krb5_with_key(ek, usage, cryptotext, length, &data);
+			if (ret < 0) {
+				return NULL;
+			}
+			if (ret == 0) {
+				break;
+			}
 		}
+	}
+	if (ek == NULL) {
+		return NULL;
+	}
+	krb_set_key_usage_hint(usage, ek);
 
-		key.keyblock.keytype=ek->keytype;
-		key.keyblock.keyvalue.length=ek->keylength;
-		key.keyblock.keyvalue.data=ek->keyvalue;
-		ret = krb5_crypto_init(krb5_ctx, &(key.keyblock), (krb5_enctype)ENCTYPE_NULL, &crypto);
-		if(ret){
-			return NULL;
-		}
+	expert_add_info_format(pinfo, NULL, &ei_kerberos_decrypted_keytype,
+						   "Decrypted keytype %d in frame %u using %s",
+						   ek->keytype, pinfo->num, ek->key_origin);
 
-		/* pre-0.6.1 versions of Heimdal would sometimes change
-		   the cryptotext data even when the decryption failed.
-		   This would obviously not work since we iterate over the
-		   keys. So just give it a copy of the crypto data instead.
-		   This has been seen for RC4-HMAC blobs.
-		*/
-		cryptocopy = (guint8 *)wmem_memdup(wmem_packet_scope(), cryptotext, length);
-		ret = krb5_decrypt_ivec(krb5_ctx, crypto, usage,
-								cryptocopy, length,
-								&data,
-								NULL);
-		if((ret == 0) && (length>0)){
-			char *user_data;
-
-			expert_add_info_format(pinfo, NULL, &ei_kerberos_decrypted_keytype,
-								   "Decrypted keytype %d in frame %u using %s",
-								   ek->keytype, pinfo->num, ek->key_origin);
-
-			krb5_crypto_destroy(krb5_ctx, crypto);
-			/* return a private wmem_alloced blob to the caller */
-			user_data = (char *)wmem_memdup(pinfo->pool, data.data, (guint)data.length);
-			if (datalen) {
-				*datalen = (int)data.length;
-			}
-			return user_data;
-		}
-		krb5_crypto_destroy(krb5_ctx, crypto);
+	/* return a private wmem_alloced blob to the caller */
+	user_data = (char *)wmem_memdup(pinfo->pool, data.data, (guint)data.length);
+	if (datalen) {
+		*datalen = (int)data.length;
 	}
-	return NULL;
+	return user_data;
 }
 
 #elif defined (HAVE_LIBNETTLE)
@@ -1280,6 +1280,22 @@ dissect_ber_identifier(packet_info *pinfo _U_, proto_tree *tree, tvbuff_t *tvb,
     return offset;
 }
 
+/*
+ * Lengths found by walking indefinite length encodings, keyed by a pointer
+ * to the first content octet. Without this, every nesting level of an
+ * indefinite length encoding walks all of its contents again each time it
+ * is looked at. The map lives in packet scope and is recreated for each
+ * packet.
+ */
+static wmem_map_t *indef_length_cache = NULL;
+
+static gboolean
+indef_length_cache_free_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event _U_, void *user_data _U_)
+{
+    indef_length_cache = NULL;
+    return FALSE;
+}
+
 /** Try to get the length octets of the BER TLV.
  * Only (TAGs and) LENGTHs that fit inside 32 bit integers are supported.
  *
@@ -1298,6 +1314,8 @@ try_get_ber_length(tvbuff_t *tvb, int offset, guint32 *length, gboolean *ind, gi
     gint8    tclass;
     gboolean tpc;
     gint32   ttag;
+    const guint8 *cache_key;
+    gpointer cached;
 
     tmp_length = 0;
     tmp_ind    = FALSE;
@@ -1325,6 +1343,17 @@ try_get_ber_length(tvbuff_t *tvb, int offset, guint32 *length, gboolean *ind, gi
         } else {
             /* 8.1.3.6 */
 
+            cache_key = tvb_get_ptr(tvb, offset, 1);
+            if (indef_length_cache) {
+                cached = wmem_map_lookup(indef_length_cache, cache_key);
+                if (cached) {
+                    /* stored as length + 1 so that 0 means not found */
+                    tmp_length = GPOINTER_TO_UINT(cached) - 1;
+                    tmp_ind = TRUE;
+                    goto done;
+                }
+            }
+
             tmp_offset = offset;
             /* ok in here we can traverse the BER to find the length, this will fix most indefinite length issues */
             /* Assumption here is that indefinite length is always used on constructed types*/
@@ -1343,9 +1372,16 @@ try_get_ber_length(tvbuff_t *tvb, int offset, guint32 *length, gboolean *ind, gi
             tmp_length += 2;
             tmp_ind = TRUE;
             offset = tmp_offset;
+
+            if (!indef_length_cache) {
+                indef_length_cache = wmem_map_new(wmem_packet_scope(), g_direct_hash, g_direct_equal);
+                wmem_register_callback(wmem_packet_scope(), indef_length_cache_free_cb, NULL);
+            }
+            wmem_map_insert(indef_length_cache, cache_key, GUINT_TO_POINTER(tmp_length + 1));
         }
     }
 
+done:
     if (length)
         *length = tmp_length;
     if (ind)
@@ -1799,7 +1799,7 @@ dcerpc_bind_hash(gconstpointer k)
     hash += key->ctx_id;
     /* sizeof(guint) might be smaller than sizeof(guint64) */
     hash += (guint)key->transport_salt;
-    hash += (guint)(key->transport_salt << sizeof(guint));
+    hash += (guint)(key->transport_salt >> (8 * sizeof(guint)));
 
     return hash;
 }
@@ -1854,7 +1854,7 @@ dcerpc_cn_call_hash(gconstpointer k)
     hash += key->call_id;
     /* sizeof(guint) might be smaller than sizeof(guint64) */
     hash += (guint)key->transport_salt;
-    hash += (guint)(key->transport_salt << sizeof(guint));
+    hash += (guint)(key->transport_salt >> (8 * sizeof(guint)));
 
     return hash;
 }
@@ -1898,7 +1898,8 @@ static guint
 dcerpc_matched_hash(gconstpointer k)
 {
     const dcerpc_matched_key *key = (const dcerpc_matched_key *)k;
-    return key->frame;
+    /* different calls in one frame shouldn't all collide */
+    return key->frame ^ (key->call_id << 16) ^ (key->call_id >> 16);
 }
 
 static gboolean
@@ -7092,15 +7093,18 @@ proto_register_dcerpc(void)
 
     uuid_dissector_table = register_dissector_table("dcerpc.uuid", "DCE/RPC UUIDs", proto_dcerpc, FT_GUID, BASE_HEX);
 
+    /* These get an entry for nearly every PDU of a big capture, so they
+       keep their items inline rather than in a chain of nodes */
+
     /* structures and data for BIND */
-    dcerpc_binds = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), dcerpc_bind_hash, dcerpc_bind_equal);
+    dcerpc_binds = wmem_map_new_autoreset_open(wmem_epan_scope(), wmem_file_scope(), dcerpc_bind_hash, dcerpc_bind_equal);
 
     /* structures and data for CALL */
-    dcerpc_cn_calls = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), dcerpc_cn_call_hash, dcerpc_cn_call_equal);
-    dcerpc_dg_calls = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), dcerpc_dg_call_hash, dcerpc_dg_call_equal);
+    dcerpc_cn_calls = wmem_map_new_autoreset_open(wmem_epan_scope(), wmem_file_scope(), dcerpc_cn_call_hash, dcerpc_cn_call_equal);
+    dcerpc_dg_calls = wmem_map_new_autoreset_open(wmem_epan_scope(), wmem_file_scope(), dcerpc_dg_call_hash, dcerpc_dg_call_equal);
 
     /* structure and data for MATCHED */
-    dcerpc_matched = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), dcerpc_matched_hash, dcerpc_matched_equal);
+    dcerpc_matched = wmem_map_new_autoreset_open(wmem_epan_scope(), wmem_file_scope(), dcerpc_matched_hash, dcerpc_matched_equal);
 
     register_init_routine(decode_dcerpc_inject_bindings);
 
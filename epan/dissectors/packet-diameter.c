@@ -147,8 +147,12 @@ struct _diam_avp_t {
 #define VND_AVP_VS_LEN(v)  (wmem_array_get_count((v)->vs_avps))
 #define VND_CMD_VS(v)      ((value_string *)(void *)(wmem_array_get_raw((v)->vs_cmds)))
 
+/* Base protocol AVPs with a code below this are indexed directly */
+#define DIAM_BASE_AVP_CODES 4096
+
 typedef struct _diam_dictionary_t {
-	wmem_tree_t *avps;
+	diam_avp_t **base_avps;	/* vendor 0 AVPs by code, up to DIAM_BASE_AVP_CODES */
+	wmem_map_t *avps;	/* the others, by vendor id << 32 | code */
 	wmem_tree_t *vnds;
 	value_string_ext *applications;
 	value_string *commands;
@@ -199,7 +203,7 @@ static diam_vnd_t unknown_vendor = { 0xffffffff, NULL, NULL, NULL };
 static diam_vnd_t no_vnd = { 0, NULL, NULL, NULL };
 static diam_avp_t unknown_avp = {0, &unknown_vendor, simple_avp, simple_avp, -1, -1, NULL };
 static GArray *all_cmds;
-static diam_dictionary_t dictionary = { NULL, NULL, NULL, NULL };
+static diam_dictionary_t dictionary = { NULL, NULL, NULL, NULL, NULL };
 static struct _build_dict build_dict;
 static const value_string *vnd_short_vs;
 static dissector_handle_t data_handle;
@@ -638,6 +642,34 @@ call_avp_subdissector(guint32 vendorid, guint32 code, tvbuff_t *subtvb, packet_i
 	ENDTRY;
 }
 
+static diam_avp_t *
+dictionary_avp_lookup(guint32 code, guint32 vendorid)
+{
+	guint64 key;
+
+	if (vendorid == 0 && code < DIAM_BASE_AVP_CODES)
+		return dictionary.base_avps[code];
+
+	key = ((guint64)vendorid << 32) | code;
+	return (diam_avp_t *)wmem_map_lookup(dictionary.avps, &key);
+}
+
+/* A later definition of the same AVP replaces the earlier one */
+static void
+dictionary_avp_insert(guint32 code, guint32 vendorid, diam_avp_t *avp)
+{
+	guint64 *key;
+
+	if (vendorid == 0 && code < DIAM_BASE_AVP_CODES) {
+		dictionary.base_avps[code] = avp;
+		return;
+	}
+
+	key = wmem_new(wmem_epan_scope(), guint64);
+	*key = ((guint64)vendorid << 32) | code;
+	wmem_map_insert(dictionary.avps, key, avp);
+}
+
 /* Dissect an AVP at offset */
 static int
 dissect_diameter_avp(diam_ctx_t *c, tvbuff_t *tvb, int offset, diam_sub_dis_t *diam_sub_dis_inf)
@@ -648,7 +680,6 @@ dissect_diameter_avp(diam_ctx_t *c, tvbuff_t *tvb, int offset, diam_sub_dis_t *d
 	guint32 flags_bits_idx = (len & 0xE0000000) >> 29;
 	guint32 flags_bits     = (len & 0xFF000000) >> 24;
 	guint32 vendorid       = vendor_flag ? tvb_get_ntohl(tvb,offset+8) : 0 ;
-	wmem_tree_key_t k[3];
 	diam_avp_t *a;
 	proto_item *pi, *avp_item;
 	proto_tree *avp_tree, *save_tree;
@@ -658,16 +689,7 @@ dissect_diameter_avp(diam_ctx_t *c, tvbuff_t *tvb, int offset, diam_sub_dis_t *d
 	const char *avp_str = NULL;
 	guint8 pad_len;
 
-	k[0].length = 1;
-	k[0].key = &code;
-
-	k[1].length = 1;
-	k[1].key = &vendorid;
-
-	k[2].length = 0;
-	k[2].key = NULL;
-
-	a = (diam_avp_t *)wmem_tree_lookup32_array(dictionary.avps,k);
+	a = dictionary_avp_lookup(code, vendorid);
 
 	len &= 0x00ffffff;
 	pad_len =  (len % 4) ? 4 - (len % 4) : 0 ;
@@ -1893,7 +1915,8 @@ dictionary_load(void)
 	build_dict.avps = g_hash_table_new(strcase_hash,strcase_equal);
 
 	dictionary.vnds = wmem_tree_new(wmem_epan_scope());
-	dictionary.avps = wmem_tree_new(wmem_epan_scope());
+	dictionary.base_avps = wmem_alloc0_array(wmem_epan_scope(), diam_avp_t *, DIAM_BASE_AVP_CODES);
+	dictionary.avps = wmem_map_new_open(wmem_epan_scope(), g_int64_hash, g_int64_equal);
 
 	unknown_vendor.vs_cmds = wmem_array_new(wmem_epan_scope(), sizeof(value_string));
 	wmem_array_set_null_terminator(unknown_vendor.vs_cmds);
@@ -2111,19 +2134,7 @@ dictionary_load(void)
 		avp = type->build( type, a->code, vnd, a->name, vs, avp_data);
 		if (avp != NULL) {
 			g_hash_table_insert(build_dict.avps, a->name, avp);
-
-			{
-				wmem_tree_key_t k[3];
-
-				k[0].length = 1;
-				k[0].key	= &(a->code);
-				k[1].length = 1;
-				k[1].key	= &(vnd->code);
-				k[2].length = 0;
-				k[2].key	= NULL;
-
-				wmem_tree_insert32_array(dictionary.avps,k,avp);
-			}
+			dictionary_avp_insert(a->code, vnd->code, avp);
 		}
 	}
 	g_hash_table_destroy(build_dict.types);
@@ -45,6 +45,7 @@
 #include <epan/afn.h>
 #include <epan/tap.h>
 #include <epan/stats_tree.h>
+#include <epan/proto_data.h>
 #include "packet-ssl.h"
 #include "packet-dtls.h"
 
@@ -448,7 +449,7 @@ typedef struct _dns_transaction_t {
 
 /* Structure containing conversation specific information */
 typedef struct _dns_conv_info_t {
-  wmem_tree_t *pdus;
+  wmem_map_t *pdus;     /* latest request dns_transaction_t by id, first pass only */
 } dns_conv_info_t;
 
 /* DNS structs and definitions */
@@ -1181,6 +1182,17 @@ expand_dns_name(tvbuff_t *tvb, int offset, int max_len, int dns_data_offset,
             maxname--;
           }
         }
+        /* Copy the whole label at once when nothing can go wrong in it */
+        if (component_len <= maxname &&
+            (!max_len || offset + component_len - start_offset <= max_len) &&
+            tvb_bytes_exist(tvb, offset, component_len)) {
+          tvb_memcpy(tvb, np, offset, component_len);
+          np += component_len;
+          (*name_len) += component_len;
+          maxname -= component_len;
+          offset += component_len;
+          component_len = 0;
+        }
         while (component_len > 0) {
           if (max_len && offset - start_offset > max_len - 1) {
             THROW(ReportedBoundsError);
@@ -3654,7 +3666,6 @@ dissect_dns_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
   conversation_t    *conversation;
   dns_conv_info_t   *dns_info;
   dns_transaction_t *dns_trans;
-  wmem_tree_key_t    key[3];
   struct DnsTap     *dns_stats;
   guint              qtype = 0;
   guint              qclass = 0;
@@ -3715,17 +3726,15 @@ dissect_dns_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
      * it to the list of information structures.
      */
     dns_info = wmem_new(wmem_file_scope(), dns_conv_info_t);
-    dns_info->pdus=wmem_tree_new(wmem_file_scope());
+    dns_info->pdus=wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
     conversation_add_proto_data(conversation, proto_dns, dns_info);
   }
 
-  key[0].length = 1;
-  key[0].key = &id;
-  key[1].length = 1;
-  key[1].key = &pinfo->num;
-  key[2].length = 0;
-  key[2].key = NULL;
-
+  /*
+   * The first pass matches a response with the latest request with its
+   * id, and leaves the transaction with the frames of both, so that later
+   * passes needn't look for it.
+   */
   if (!pinfo->fd->flags.visited) {
     if (!(flags&F_RESPONSE)) {
       /* This is a request */
@@ -3734,22 +3743,18 @@ dissect_dns_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
       dns_trans->rep_frame=0;
       dns_trans->req_time=pinfo->abs_ts;
       dns_trans->id = id;
-      wmem_tree_insert32_array(dns_info->pdus, key, (void *)dns_trans);
+      wmem_map_insert(dns_info->pdus, GUINT_TO_POINTER(id), (void *)dns_trans);
     } else {
-      dns_trans=(dns_transaction_t *)wmem_tree_lookup32_array_le(dns_info->pdus, key);
+      dns_trans=(dns_transaction_t *)wmem_map_lookup(dns_info->pdus, GUINT_TO_POINTER(id));
       if (dns_trans) {
-        if (dns_trans->id != id) {
-          dns_trans = NULL;
-        } else {
-          dns_trans->rep_frame=pinfo->num;
-        }
+        dns_trans->rep_frame=pinfo->num;
       }
     }
-  } else {
-    dns_trans=(dns_transaction_t *)wmem_tree_lookup32_array_le(dns_info->pdus, key);
-    if (dns_trans && dns_trans->id != id) {
-      dns_trans = NULL;
+    if (dns_trans) {
+      p_add_proto_data(wmem_file_scope(), pinfo, proto_dns, id, dns_trans);
     }
+  } else {
+    dns_trans=(dns_transaction_t *)p_get_proto_data(wmem_file_scope(), pinfo, proto_dns, id);
   }
   if (!dns_trans) {
     /* create a "fake" pana_trans structure */
@@ -541,11 +541,12 @@ dissect_eth_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree,
 /* -------------- */
 static gboolean check_is_802_2(tvbuff_t *tvb, int fcs_len)
 {
-  volatile gboolean is_802_2;
-  volatile int length;
+  int length;
   gint captured_length, reported_length;
-
-  is_802_2 = TRUE;
+  gboolean CCSDS_len = TRUE;
+  gboolean CCSDS_ver = TRUE;
+  gboolean CCSDS_head = TRUE;
+  gboolean CCSDS_bit = TRUE;
 
     /* Is there an 802.2 layer? I can tell by looking at the first 2
        bytes after the 802.3 header. If they are 0xffff, then what
@@ -553,68 +554,67 @@ static gboolean check_is_802_2(tvbuff_t *tvb, int fcs_len)
        A non-0xffff value means that there's an 802.2 layer or CCSDS
        layer inside the 802.3 layer */
 
-  TRY {
-    if (tvb_get_ntohs(tvb, 14) == 0xffff) {
-        is_802_2 = FALSE;
+  /* This is called for every 802.3 frame, so rather than catching the
+     bounds errors of a short frame, check up front that the bytes we
+     look at are there; if they aren't, assume 802.2. */
+  if (!tvb_bytes_exist(tvb, ETH_HEADER_SIZE, 2))
+    return TRUE;
+  if (tvb_get_ntohs(tvb, ETH_HEADER_SIZE) == 0xffff)
+    return FALSE;
+
+  /* Is this a CCSDS payload instead of an 802.2 (LLC)?
+     Check the conditions enabled by the user for CCSDS presence */
+  if (!(ccsds_heuristic_length || ccsds_heuristic_version ||
+        ccsds_heuristic_header || ccsds_heuristic_bit))
+    return TRUE;
+
+  /* See if the reported payload size matches the
+     size contained in the CCSDS header. */
+  if (ccsds_heuristic_length) {
+    /* The following technique to account for FCS
+       is copied from packet-ieee8023.c dissect_802_3() */
+    length = tvb_get_ntohs(tvb, 12);
+    reported_length = tvb_reported_length_remaining(tvb, ETH_HEADER_SIZE);
+    if (fcs_len > 0) {
+      if (reported_length >= fcs_len)
+        reported_length -= fcs_len;
     }
-    /* Is this a CCSDS payload instead of an 802.2 (LLC)?
-       Check the conditions enabled by the user for CCSDS presence */
-    else if (ccsds_heuristic_length || ccsds_heuristic_version ||
-             ccsds_heuristic_header || ccsds_heuristic_bit) {
-      gboolean CCSDS_len = TRUE;
-      gboolean CCSDS_ver = TRUE;
-      gboolean CCSDS_head = TRUE;
-      gboolean CCSDS_bit = TRUE;
-      /* See if the reported payload size matches the
-         size contained in the CCSDS header. */
-      if (ccsds_heuristic_length) {
-        /* The following technique to account for FCS
-           is copied from packet-ieee8023.c dissect_802_3() */
-        length = tvb_get_ntohs(tvb, 12);
-        reported_length = tvb_reported_length_remaining(tvb, ETH_HEADER_SIZE);
-        if (fcs_len > 0) {
-          if (reported_length >= fcs_len)
-            reported_length -= fcs_len;
-        }
-        /* Make sure the length in the 802.3 header doesn't go past the end of
-           the payload. */
-        if (length > reported_length) {
-          length = reported_length;
-        }
-        /* Only allow inspection of 'length' number of bytes. */
-        captured_length = tvb_captured_length_remaining(tvb, ETH_HEADER_SIZE);
-        if (captured_length > length)
-          captured_length = length;
-
-        /* Check if payload is large enough to contain a CCSDS header */
-        if (captured_length >= 6) {
-          /* Compare length to packet length contained in CCSDS header. */
-          if (length != 7 + tvb_get_ntohs(tvb, ETH_HEADER_SIZE + 4))
-            CCSDS_len = FALSE;
-        }
-      }
-      /* Check if CCSDS Version number (first 3 bits of payload) is zero */
-      if ((ccsds_heuristic_version) && (tvb_get_bits8(tvb, 8*ETH_HEADER_SIZE, 3)!=0))
-        CCSDS_ver = FALSE;
-      /* Check if Secondary Header Flag (4th bit of payload) is set to one. */
-      if ((ccsds_heuristic_header) && (tvb_get_bits8(tvb, 8*ETH_HEADER_SIZE + 4, 1)!=1))
-        CCSDS_head = FALSE;
-      /* Check if spare bit (1st bit of 7th word of payload) is zero. */
-      if ((ccsds_heuristic_bit) && (tvb_get_bits8(tvb, 8*ETH_HEADER_SIZE + 16*6, 1)!=0))
-        CCSDS_bit = FALSE;
-      /* If all the conditions are true, don't interpret payload as an 802.2 (LLC).
-       * Additional check in packet-802.3.c will distinguish between
-       * IPX and CCSDS packets*/
-      if (CCSDS_len && CCSDS_ver && CCSDS_head && CCSDS_bit)
-        is_802_2 = FALSE;
+    /* Make sure the length in the 802.3 header doesn't go past the end of
+       the payload. */
+    if (length > reported_length) {
+      length = reported_length;
+    }
+    /* Only allow inspection of 'length' number of bytes. */
+    captured_length = tvb_captured_length_remaining(tvb, ETH_HEADER_SIZE);
+    if (captured_length > length)
+      captured_length = length;
+
+    /* Check if payload is large enough to contain a CCSDS header */
+    if (captured_length >= 6) {
+      /* Compare length to packet length contained in CCSDS header. */
+      if (length != 7 + tvb_get_ntohs(tvb, ETH_HEADER_SIZE + 4))
+        CCSDS_len = FALSE;
     }
   }
-  CATCH_BOUNDS_ERRORS {
-        ; /* do nothing */
-
+  /* Check if CCSDS Version number (first 3 bits of payload) is zero */
+  if ((ccsds_heuristic_version) && (tvb_get_bits8(tvb, 8*ETH_HEADER_SIZE, 3)!=0))
+    CCSDS_ver = FALSE;
+  /* Check if Secondary Header Flag (4th bit of payload) is set to one. */
+  if ((ccsds_heuristic_header) && (tvb_get_bits8(tvb, 8*ETH_HEADER_SIZE + 4, 1)!=1))
+    CCSDS_head = FALSE;
+  /* Check if spare bit (1st bit of 7th word of payload) is zero. */
+  if (ccsds_heuristic_bit) {
+    if (!tvb_bytes_exist(tvb, ETH_HEADER_SIZE + 12, 1))
+      return TRUE;
+    if (tvb_get_bits8(tvb, 8*ETH_HEADER_SIZE + 16*6, 1)!=0)
+      CCSDS_bit = FALSE;
   }
-  ENDTRY;
-  return is_802_2;
+  /* If all the conditions are true, don't interpret payload as an 802.2 (LLC).
+   * Additional check in packet-802.3.c will distinguish between
+   * IPX and CCSDS packets*/
+  if (CCSDS_len && CCSDS_ver && CCSDS_head && CCSDS_bit)
+    return FALSE;
+  return TRUE;
 }
 
 
@@ -202,6 +202,38 @@ register_frame_end_routine(packet_info *pinfo, void (*func)(void))
 	pinfo->frame_end_routines = g_slist_append(pinfo->frame_end_routines, (gpointer)func);
 }
 
+/*
+ * Returns TRUE if df only references fields that dissect_frame() fills in
+ * from the frame_data alone, so that it can be applied to an already
+ * visited frame with the metadata-only dissection, without reading or
+ * dissecting the packet data.  "frame" itself isn't on the list as it
+ * is "syscall" for system call records, nor is anything taken from the
+ * wtap_pkthdr, the packet data or the sub-dissectors.
+ */
+gboolean
+frame_dfilter_is_metadata_only(const dfilter_t *df)
+{
+	const int hf_ids[] = {
+		hf_frame_arrival_time,
+		hf_frame_shift_offset,
+		hf_frame_arrival_time_epoch,
+		hf_frame_time_delta,
+		hf_frame_time_delta_displayed,
+		hf_frame_time_relative,
+		hf_frame_time_reference,
+		hf_frame_number,
+		hf_frame_len,
+		hf_frame_capture_len,
+		hf_frame_file_off,
+		hf_frame_marked,
+		hf_frame_ignored
+	};
+
+	if (df == NULL)
+		return FALSE;
+	return dfilter_only_references(df, hf_ids, G_N_ELEMENTS(hf_ids));
+}
+
 typedef void (*void_func_t)(void);
 
 static void
@@ -436,7 +468,7 @@ dissect_frame(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, void*
 								  (long) pinfo->abs_ts.nsecs);
 			}
 			item = proto_tree_add_time(fh_tree, hf_frame_shift_offset, tvb,
-					    0, 0, &(pinfo->fd->shift_offset));
+					    0, 0, epan_get_frame_shift_offset(pinfo->epan, pinfo->num));
 			PROTO_ITEM_SET_GENERATED(item);
 
 			if (generate_epoch_time) {
@@ -531,6 +563,12 @@ dissect_frame(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, void*
 		return tvb_captured_length(tvb);
 	}
 
+	if (fr_data->metadata_only) {
+		/* Only the frame metadata was asked for; the packet data
+		   might not even have been read. */
+		return tvb_captured_length(tvb);
+	}
+
 	/* Portable Exception Handling to trap Wireshark specific exceptions like BoundsError exceptions */
 	TRY {
 #ifdef _MSC_VER
@@ -22,6 +22,7 @@
  */
 
 #include "ws_symbol_export.h"
+#include <epan/dfilter/dfilter.h>
 
 /*
  * Routine used to register frame end routine.  The routine should only
@@ -30,3 +31,11 @@
  */
 void
 register_frame_end_routine(packet_info *pinfo, void (*func)(void));
+
+/*
+ * Returns TRUE if the filter only references frame metadata fields,
+ * i.e. it can be evaluated on a visited frame with
+ * epan_dissect_set_metadata_only() set.
+ */
+WS_DLL_PUBLIC gboolean
+frame_dfilter_is_metadata_only(const dfilter_t *df);
@@ -300,21 +300,20 @@ dissect_gre_wccp2_redirect_header(tvbuff_t *tvb, int offset, proto_tree *tree)
 {
     proto_item *ti;
     proto_tree *rh_tree;
+    static const proto_header_field_t redirect_header_fields[] = {
+        { &hf_gre_wccp_dynamic_service,          0, 1, ENC_BIG_ENDIAN },
+        { &hf_gre_wccp_alternative_bucket_used,  0, 1, ENC_BIG_ENDIAN },
+        { &hf_gre_wccp_redirect_header_valid,    0, 1, ENC_BIG_ENDIAN },
+        { &hf_gre_wccp_service_id,               1, 1, ENC_BIG_ENDIAN },
+        { &hf_gre_wccp_alternative_bucket,       2, 1, ENC_BIG_ENDIAN },
+        { &hf_gre_wccp_primary_bucket,           3, 1, ENC_BIG_ENDIAN },
+        { NULL, 0, 0, 0 }
+    };
 
     ti = proto_tree_add_item(tree, hf_gre_wccp_redirect_header, tvb, offset, 4, ENC_NA);
     rh_tree = proto_item_add_subtree(ti, ett_gre_wccp2_redirect_header);
 
-    proto_tree_add_item(rh_tree, hf_gre_wccp_dynamic_service, tvb, offset, 1, ENC_BIG_ENDIAN);
-
-    proto_tree_add_item(rh_tree, hf_gre_wccp_alternative_bucket_used, tvb, offset, 1, ENC_BIG_ENDIAN);
-
-    proto_tree_add_item(rh_tree, hf_gre_wccp_redirect_header_valid, tvb, offset, 1, ENC_BIG_ENDIAN);
-
-    proto_tree_add_item(rh_tree, hf_gre_wccp_service_id, tvb, offset +1, 1, ENC_BIG_ENDIAN);
-
-    proto_tree_add_item(rh_tree, hf_gre_wccp_alternative_bucket, tvb, offset +2, 1, ENC_BIG_ENDIAN);
-
-    proto_tree_add_item(rh_tree, hf_gre_wccp_primary_bucket, tvb, offset +3, 1, ENC_BIG_ENDIAN);
+    proto_tree_add_header_fields(rh_tree, tvb, offset, redirect_header_fields);
 }
 
 static gboolean
@@ -1876,80 +1876,129 @@ guint32 gtp_session_count;
 
 /* Relation between frame -> session */
 GHashTable* session_table;
-/* Relation between <teid,ip> -> frame */
-wmem_tree_t* frame_tree;
-
-typedef struct gtp_info {
+/* Relation between session -> frames, the other way round */
+static GHashTable* session_frames;
+/* Relation between <ip,teid> -> frames that announced it, the newest last */
+static GHashTable* teid_frames;
+/* Relation between frame -> the <ip,teid> keys it added to teid_frames */
+static GHashTable* frame_teids;
+
+typedef struct gtp_teid_key {
+    address ip;
     guint32 teid;
-    guint32 frame;
-} gtp_info_t;
+} gtp_teid_key_t;
+
+static guint
+gtp_teid_key_hash(gconstpointer k)
+{
+    const gtp_teid_key_t *key = (const gtp_teid_key_t *)k;
+
+    return add_address_to_hash(key->teid, &key->ip);
+}
+
+static gboolean
+gtp_teid_key_equal(gconstpointer k1, gconstpointer k2)
+{
+    const gtp_teid_key_t *key1 = (const gtp_teid_key_t *)k1;
+    const gtp_teid_key_t *key2 = (const gtp_teid_key_t *)k2;
+
+    return key1->teid == key2->teid && addresses_equal(&key1->ip, &key2->ip);
+}
+
+static void
+gtp_array_free(gpointer data)
+{
+    g_array_free((GArray *)data, TRUE);
+}
+
+static void
+gtp_ptr_array_free(gpointer data)
+{
+    g_ptr_array_free((GPtrArray *)data, TRUE);
+}
 
 /* GTP Session funcs*/
 guint32
 get_frame(address ip, guint32 teid, guint32 *frame) {
-    gboolean found = FALSE;
-    wmem_list_frame_t *elem;
-    gtp_info_t *info;
-    wmem_list_t *info_list;
-    gchar *ip_str;
-
-    /* First we get the teid list*/
-    ip_str = address_to_str(wmem_packet_scope(), &ip);
-    info_list = (wmem_list_t*)wmem_tree_lookup_string(frame_tree, ip_str, 0);
-    if (info_list != NULL) {
-        elem = wmem_list_head(info_list);
-        while (!found && elem) {
-            info = (gtp_info_t*)wmem_list_frame_data(elem);
-            if (teid == info->teid) {
-                *frame = info->frame;
-                return 1;
-            }
-            elem = wmem_list_frame_next(elem);
-        }
+    gtp_teid_key_t key;
+    GArray *frames;
+
+    key.ip = ip;
+    key.teid = teid;
+    frames = (GArray *)g_hash_table_lookup(teid_frames, &key);
+    if (frames != NULL && frames->len > 0) {
+        *frame = g_array_index(frames, guint32, frames->len - 1);
+        return 1;
     }
     return 0;
 }
 
-static void
-call_foreach_ip(const void *key _U_, void *value, void *data){
-    wmem_list_frame_t * elem;
-    wmem_list_t *info_list = (wmem_list_t *)value;
-    gtp_info_t *info;
-    guint32* frame = (guint32*)data;
-
-    /* We loop over the <teid, frame> list */
-    elem = wmem_list_head(info_list);
-    while (elem) {
-        info = (gtp_info_t*)wmem_list_frame_data(elem);
-        if (info->frame == *frame) {
-            wmem_list_frame_t * del = elem;
-            /* proceed to next request */
-            elem = wmem_list_frame_next(elem);
-            /* If we find the frame we remove its information from the list */
-            wmem_list_remove_frame(info_list, del);
-            wmem_free(wmem_file_scope(), info);
-        }
-        else {
-            elem = wmem_list_frame_next(elem);
+void
+remove_frame_info(guint32 *f) {
+    GPtrArray *keys;
+    GArray *frames;
+    guint i, j;
+
+    keys = (GPtrArray *)g_hash_table_lookup(frame_teids, GUINT_TO_POINTER(*f));
+    if (keys == NULL) {
+        return;
+    }
+    /* For each <ip,teid> the frame added, forget that it did */
+    for (i = 0; i < keys->len; i++) {
+        frames = (GArray *)g_hash_table_lookup(teid_frames, g_ptr_array_index(keys, i));
+        /* It's normally the last frame that used them, so look from the end */
+        for (j = frames->len; j > 0; j--) {
+            if (g_array_index(frames, guint32, j - 1) == *f) {
+                g_array_remove_index(frames, j - 1);
+            }
         }
     }
+    g_hash_table_remove(frame_teids, GUINT_TO_POINTER(*f));
 }
 
-void
-remove_frame_info(guint32 *f) {
-    /* For each ip node */
-    wmem_tree_foreach(frame_tree, (wmem_foreach_func)call_foreach_ip, (void *)f);
+/* Remove the <ip,teid> information of all the frames in the session of frame */
+static void
+remove_session_info(guint32 frame) {
+    guint32 *session, *frame_session;
+    GArray *frames;
+    guint32 fr;
+    guint i;
+
+    session = (guint32 *)g_hash_table_lookup(session_table, &frame);
+    if (session == NULL) {
+        return;
+    }
+    frames = (GArray *)g_hash_table_lookup(session_frames, GUINT_TO_POINTER(*session));
+    if (frames == NULL) {
+        return;
+    }
+    for (i = 0; i < frames->len; i++) {
+        fr = g_array_index(frames, guint32, i);
+        /* Skip the frames that have been given another session since */
+        frame_session = (guint32 *)g_hash_table_lookup(session_table, &fr);
+        if (frame_session != NULL && *frame_session == *session) {
+            remove_frame_info(&fr);
+        }
+    }
 }
 
 void
 add_gtp_session(guint32 frame, guint32 session) {
     guint32 *f, *session_count;
+    GArray *frames;
 
     f = wmem_new0(wmem_file_scope(), guint32);
     session_count = wmem_new0(wmem_file_scope(), guint32);
     *f = frame;
     *session_count = session;
     g_hash_table_insert(session_table, f, session_count);
+
+    frames = (GArray *)g_hash_table_lookup(session_frames, GUINT_TO_POINTER(session));
+    if (frames == NULL) {
+        frames = g_array_new(FALSE, FALSE, sizeof(guint32));
+        g_hash_table_insert(session_frames, GUINT_TO_POINTER(session), frames);
+    }
+    g_array_append_val(frames, frame);
 }
 
 gboolean
@@ -1982,67 +2031,40 @@ ip_exists(address ip, wmem_list_t *ip_list) {
     return found;
 }
 
-static gboolean
-info_exists(gtp_info_t *wanted, wmem_list_t *info_list) {
-    wmem_list_frame_t *elem;
-    gtp_info_t *info;
-    gboolean found;
-    found = FALSE;
-    elem = wmem_list_head(info_list);
-    while (!found && elem) {
-        info = (gtp_info_t*)wmem_list_frame_data(elem);
-        found = wanted->teid == info->teid;
-        elem = wmem_list_frame_next(elem);
-    }
-    return found;
-}
-
 void
 fill_map(wmem_list_t *teid_list, wmem_list_t *ip_list, guint32 frame) {
     wmem_list_frame_t *elem_ip, *elem_teid;
-    gtp_info_t *gtp_info;
-    wmem_list_t * info_list; /* List of <teids,frames>*/
-    guint32 *f, *session, *fr, *session_count;
-    GHashTableIter iter;
-    guint32 teid;
-    gchar *ip;
+    gtp_teid_key_t key, *stored_key;
+    GArray *frames;
+    GPtrArray *keys;
 
     elem_ip = wmem_list_head(ip_list);
     while (elem_ip) {
-        ip = address_to_str(wmem_file_scope(), (address*)wmem_list_frame_data(elem_ip));
-        /* We check if a teid list exists for this ip */
-        info_list = (wmem_list_t*)wmem_tree_lookup_string(frame_tree, ip, 0);
-        if (info_list == NULL) {
-            info_list = wmem_list_new(wmem_file_scope());
-        }
+        key.ip = *(address*)wmem_list_frame_data(elem_ip);
         /* We loop over the teid list */
         elem_teid = wmem_list_head(teid_list);
         while (elem_teid) {
-            teid = *(guint32*)wmem_list_frame_data(elem_teid);
-            f = wmem_new0(wmem_file_scope(), guint32);
-            *f = frame;
-            gtp_info = wmem_new0(wmem_file_scope(), gtp_info_t);
-            gtp_info->teid = teid;
-            gtp_info->frame = *f;
-            if (info_exists(gtp_info, info_list)) {
+            key.teid = *(guint32*)wmem_list_frame_data(elem_teid);
+            if (!g_hash_table_lookup_extended(teid_frames, &key, (gpointer *)&stored_key, (gpointer *)&frames)) {
+                stored_key = wmem_new(wmem_file_scope(), gtp_teid_key_t);
+                copy_address_wmem(wmem_file_scope(), &stored_key->ip, &key.ip);
+                stored_key->teid = key.teid;
+                frames = g_array_new(FALSE, FALSE, sizeof(guint32));
+                g_hash_table_insert(teid_frames, stored_key, frames);
+            } else if (frames->len > 0) {
                 /* If the teid and ip already existed, that means that we need to remove old info about that session */
-                /* We look for its session ID */
-                session = (guint32 *)g_hash_table_lookup(session_table, f);
-                if (session) {
-                    g_hash_table_iter_init(&iter, session_table);
-                    while (g_hash_table_iter_next(&iter, (gpointer*)&fr, (gpointer*)&session_count)) {
-                        /* If the msg has the same session ID and it's not the upd req we have to remove its info */
-                        if (*session_count == *session) {
-                            /* If it's the session we are looking for, we remove all the frame information */
-                            remove_frame_info(fr);
-                        }
-                    }
-                }
+                remove_session_info(frame);
             }
-            wmem_list_prepend(info_list, gtp_info);
+            g_array_append_val(frames, frame);
+
+            keys = (GPtrArray *)g_hash_table_lookup(frame_teids, GUINT_TO_POINTER(frame));
+            if (keys == NULL) {
+                keys = g_ptr_array_new();
+                g_hash_table_insert(frame_teids, GUINT_TO_POINTER(frame), keys);
+            }
+            g_ptr_array_add(keys, stored_key);
             elem_teid = wmem_list_frame_next(elem_teid);
         }
-        wmem_tree_insert_string(frame_tree, ip, info_list, 0);
         elem_ip = wmem_list_frame_next(elem_ip);
     }
 }
@@ -8514,27 +8536,34 @@ dissect_gtp_common(tvbuff_t * tvb, packet_info * pinfo, proto_tree * tree)
     }
 
     /*
-    * Do we have a conversation for this connection?
+    * Only signalling messages are matched up, so don't bother with the
+    * conversation for the G-PDUs that carry the user traffic.
     */
-    conversation = find_or_create_conversation(pinfo);
+    gtp_info = NULL;
+    if (octet != GTP_MSG_TPDU) {
+        /*
+        * Do we have a conversation for this connection?
+        */
+        conversation = find_or_create_conversation(pinfo);
 
-    /*
-    * Do we already know this conversation?
-    */
-    gtp_info = (gtp_conv_info_t *)conversation_get_proto_data(conversation, proto_gtp);
-    if (gtp_info == NULL) {
-        /* No.  Attach that information to the conversation, and add
-        * it to the list of information structures.
+        /*
+        * Do we already know this conversation?
         */
-        gtp_info = (gtp_conv_info_t *)wmem_alloc(wmem_file_scope(), sizeof(gtp_conv_info_t));
-        /*Request/response matching tables*/
-        gtp_info->matched = g_hash_table_new(gtp_sn_hash, gtp_sn_equal_matched);
-        gtp_info->unmatched = g_hash_table_new(gtp_sn_hash, gtp_sn_equal_unmatched);
+        gtp_info = (gtp_conv_info_t *)conversation_get_proto_data(conversation, proto_gtp);
+        if (gtp_info == NULL) {
+            /* No.  Attach that information to the conversation, and add
+            * it to the list of information structures.
+            */
+            gtp_info = (gtp_conv_info_t *)wmem_alloc(wmem_file_scope(), sizeof(gtp_conv_info_t));
+            /*Request/response matching tables*/
+            gtp_info->matched = g_hash_table_new(gtp_sn_hash, gtp_sn_equal_matched);
+            gtp_info->unmatched = g_hash_table_new(gtp_sn_hash, gtp_sn_equal_unmatched);
 
-        conversation_add_proto_data(conversation, proto_gtp, gtp_info);
+            conversation_add_proto_data(conversation, proto_gtp, gtp_info);
 
-        gtp_info->next = gtp_info_items;
-        gtp_info_items = gtp_info;
+            gtp_info->next = gtp_info_items;
+            gtp_info_items = gtp_info;
+        }
     }
 
     gtp_hdr->flags = tvb_get_guint8(tvb, offset);
@@ -8962,7 +8991,10 @@ gtp_init(void)
 {
     gtp_session_count = 1;
     session_table = g_hash_table_new(g_int_hash, g_int_equal);
-    frame_tree = wmem_tree_new(wmem_file_scope());
+    session_frames = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, gtp_array_free);
+    /* The keys are in file scope */
+    teid_frames = g_hash_table_new_full(gtp_teid_key_hash, gtp_teid_key_equal, NULL, gtp_array_free);
+    frame_teids = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, gtp_ptr_array_free);
 }
 
 static void
@@ -8990,6 +9022,18 @@ gtp_cleanup(void)
         g_hash_table_destroy(session_table);
     }
     session_table = NULL;
+    if (session_frames != NULL) {
+        g_hash_table_destroy(session_frames);
+    }
+    session_frames = NULL;
+    if (teid_frames != NULL) {
+        g_hash_table_destroy(teid_frames);
+    }
+    teid_frames = NULL;
+    if (frame_teids != NULL) {
+        g_hash_table_destroy(frame_teids);
+    }
+    frame_teids = NULL;
 }
 
 void
@@ -161,9 +161,6 @@ typedef struct session_args {
 /* Relation between frame -> session */
 extern GHashTable* session_table;
 
-/* Relation between <teid,ip> -> frame */
-extern wmem_tree_t* frame_tree;
-
 guint32 get_frame(address ip, guint32 teid, guint32 *frame);
 
 void remove_frame_info(guint32 *f);
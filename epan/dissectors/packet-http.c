@@ -759,6 +759,82 @@ static void push_res(http_conv_t *conv_data, packet_info *pinfo)
  */
 static http_info_value_t	*stat_info;
 
+/*
+ * Decompressed entity bodies of frames that have been visited, so that
+ * dissecting a frame again, as when it is selected, doesn't inflate its
+ * body again.  They're keyed by frame number and body offset; the
+ * compressed body's length and hash guard against a different body
+ * turning up there.  Only so much is kept, as this comes on top of the
+ * reassembled bodies.
+ */
+#define HTTP_DECOMPRESSED_CACHE_MAX	(64 * 1024 * 1024)
+
+typedef struct {
+	guint	 comprlen;
+	guint32	 compr_hash;
+	guint8	*data;
+	guint	 len;
+} http_decompressed_t;
+
+static wmem_map_t *http_decompressed_bodies;
+static guint http_decompressed_bytes;
+
+static void
+http_decompressed_init(void)
+{
+	http_decompressed_bytes = 0;
+}
+
+/* FNV-1a */
+static guint32
+http_body_hash(tvbuff_t *tvb, guint len)
+{
+	const guint8 *p = tvb_get_ptr(tvb, 0, len);
+	guint32 hash = 2166136261U;
+	guint i;
+
+	for (i = 0; i < len; i++)
+		hash = (hash ^ p[i]) * 16777619U;
+	return hash;
+}
+
+static tvbuff_t *
+http_uncompress_body(tvbuff_t *tvb, tvbuff_t *body_tvb, packet_info *pinfo,
+		     int offset)
+{
+	guint comprlen = tvb_captured_length(body_tvb);
+	guint64 key = ((guint64)pinfo->num << 32) | (guint32)offset;
+	guint32 hash;
+	http_decompressed_t *entry;
+	tvbuff_t *uncomp_tvb;
+	guint64 *new_key;
+
+	/* Most frames are only dissected once then */
+	if (!PINFO_FD_VISITED(pinfo))
+		return tvb_child_uncompress(tvb, body_tvb, 0, comprlen);
+
+	hash = http_body_hash(body_tvb, comprlen);
+	entry = (http_decompressed_t *)wmem_map_lookup(http_decompressed_bodies, &key);
+	if (entry != NULL && entry->comprlen == comprlen &&
+	    entry->compr_hash == hash)
+		return tvb_new_child_real_data(tvb, entry->data, entry->len, entry->len);
+
+	uncomp_tvb = tvb_child_uncompress(tvb, body_tvb, 0, comprlen);
+	if (uncomp_tvb != NULL && entry == NULL &&
+	    http_decompressed_bytes + tvb_captured_length(uncomp_tvb) <= HTTP_DECOMPRESSED_CACHE_MAX) {
+		entry = wmem_new(wmem_file_scope(), http_decompressed_t);
+		entry->comprlen = comprlen;
+		entry->compr_hash = hash;
+		entry->len = tvb_captured_length(uncomp_tvb);
+		entry->data = (guint8 *)tvb_memdup(wmem_file_scope(), uncomp_tvb, 0, entry->len);
+		new_key = wmem_new(wmem_file_scope(), guint64);
+		*new_key = key;
+		wmem_map_insert(http_decompressed_bodies, new_key, entry);
+		http_decompressed_bytes += entry->len;
+	}
+	return uncomp_tvb;
+}
+
 static int
 dissect_http_message(tvbuff_t *tvb, int offset, packet_info *pinfo,
 		     proto_tree *tree, http_conv_t *conv_data,
@@ -1477,8 +1553,8 @@ dissect_http_message(tvbuff_t *tvb, int offset, packet_info *pinfo,
 			     g_ascii_strcasecmp(headers.content_encoding, "x-gzip") == 0 ||
 			     g_ascii_strcasecmp(headers.content_encoding, "x-deflate") == 0))
 			{
-				uncomp_tvb = tvb_child_uncompress(tvb, next_tvb, 0,
-				    tvb_captured_length(next_tvb));
+				uncomp_tvb = http_uncompress_body(tvb, next_tvb, pinfo,
+				    offset);
 			}
 
 			/*
@@ -3745,6 +3821,10 @@ proto_register_http(void)
 	register_follow_stream(proto_http, "http_follow", tcp_follow_conv_filter, tcp_follow_index_filter, tcp_follow_address_filter,
 							tcp_port_to_display, follow_tvb_tap_listener);
 	http_eo_tap = register_export_object(proto_http, http_eo_packet, NULL);
+
+	http_decompressed_bodies = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(),
+	    g_int64_hash, g_int64_equal);
+	register_init_routine(http_decompressed_init);
 }
 
 /*
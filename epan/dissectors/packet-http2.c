@@ -207,6 +207,8 @@ typedef struct {
     http2_header_repr_info_t header_repr_info[2];
     wmem_map_t *per_stream_info;
     guint32 current_stream_id;
+    /* per_stream_info entry last looked up, normally current_stream_id's */
+    http2_stream_info_t *current_stream_info;
 #endif
     tcp_flow_t *fwd_flow;
 } http2_session_t;
@@ -538,8 +540,15 @@ get_stream_info(http2_session_t *http2_session)
 {
     guint32 stream_id = http2_session->current_stream_id;
     wmem_map_t *stream_map = http2_session->per_stream_info;
+    http2_stream_info_t *stream_info = http2_session->current_stream_info;
 
-    http2_stream_info_t *stream_info = (http2_stream_info_t *)wmem_map_lookup(stream_map, GINT_TO_POINTER(stream_id));
+    /* The stream info is wanted several times per frame, so try the
+       last one we looked up first */
+    if (stream_info != NULL && stream_info->stream_id == stream_id) {
+        return stream_info;
+    }
+
+    stream_info = (http2_stream_info_t *)wmem_map_lookup(stream_map, GINT_TO_POINTER(stream_id));
     if (stream_info == NULL) {
         stream_info = wmem_new0(wmem_file_scope(), http2_stream_info_t);
         stream_info->oneway_stream_info[0].header_stream_info.stream_header_list = wmem_list_new(wmem_file_scope());
@@ -547,6 +556,7 @@ get_stream_info(http2_session_t *http2_session)
         stream_info->stream_id = stream_id;
         wmem_map_insert(stream_map, GINT_TO_POINTER(stream_id), stream_info);
     }
+    http2_session->current_stream_info = stream_info;
 
     return stream_info;
 }
@@ -824,15 +834,14 @@ process_http2_header_repr_info(wmem_array_t *headers,
 
         if(header_repr_info->complete) {
             if(header_repr_info->type == HTTP2_HD_HEADER_TABLE_SIZE_UPDATE) {
-                http2_header_t *out;
-
-                out = wmem_new(wmem_file_scope(), http2_header_t);
+                http2_header_t out;
 
-                out->type = header_repr_info->type;
-                out->length = i - start;
-                out->table.header_table_size = header_repr_info->integer;
+                out.type = header_repr_info->type;
+                out.length = i - start;
+                out.table.header_table_size = header_repr_info->integer;
 
-                wmem_array_append(headers, out, 1);
+                /* The array holds a copy */
+                wmem_array_append(headers, &out, 1);
 
                 reset_http2_header_repr_info(header_repr_info);
                 /* continue to decode header table size update or
@@ -1086,7 +1095,9 @@ inflate_http2_header_block(tvbuff_t *tvb, packet_info *pinfo, guint offset,
                 char *cached_pstr;
                 guint32 len;
                 guint datalen = (guint)(4 + nv.namelen + 4 + nv.valuelen);
-                http2_header_t *out;
+                http2_header_t out_header;
+                /* The headers array holds a copy, so fill one in on the stack */
+                http2_header_t *out = &out_header;
 
                 if (decompressed_bytes + datalen >= MAX_HTTP2_HEADER_SIZE) {
                     header_data->header_size_reached = decompressed_bytes;
@@ -1094,8 +1105,6 @@ inflate_http2_header_block(tvbuff_t *tvb, packet_info *pinfo, guint offset,
                     break;
                 }
 
-                out = wmem_new(wmem_file_scope(), http2_header_t);
-
                 out->type = header_repr_info->type;
                 out->length = rv;
                 out->table.data.idx = header_repr_info->integer;
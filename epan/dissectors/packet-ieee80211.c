@@ -2923,6 +2923,10 @@ typedef struct retransmit_key {
 
 static GHashTable *fc_analyse_retransmit_table = NULL;
 static GHashTable *fc_first_frame_table = NULL;
+/* Entry of fc_analyse_retransmit_table looked up last; most data frames
+   come in runs from the same station */
+static retransmit_key *fc_last_retransmit_key = NULL;
+static gint retransmit_equal(gconstpointer k1, gconstpointer k2);
 
 static int hf_ieee80211_fc_analysis_retransmission = -1;
 static int hf_ieee80211_fc_analysis_retransmission_frame = -1;
@@ -18719,7 +18723,11 @@ dissect_ieee80211_common(tvbuff_t *tvb, packet_info *pinfo,
           memcpy(key.bssid, whdr->bssid.data, 6);
           memcpy(key.src, whdr->src.data, 6);
           key.seq_control = 0;
-          result = (retransmit_key *)g_hash_table_lookup(fc_analyse_retransmit_table, &key);
+          if (fc_last_retransmit_key && retransmit_equal(fc_last_retransmit_key, &key)) {
+            result = fc_last_retransmit_key;
+          } else {
+            result = (retransmit_key *)g_hash_table_lookup(fc_analyse_retransmit_table, &key);
+          }
           if (result && (result->seq_control == seq_control)) {
             /* keep a pointer to the first seen frame, could be done with proto data? */
             fnum = result->fnum;
@@ -18736,6 +18744,7 @@ dissect_ieee80211_common(tvbuff_t *tvb, packet_info *pinfo,
             result->seq_control = seq_control;
             result->fnum =  pinfo->num;
           }
+          fc_last_retransmit_key = result;
         }
         else if ((fnum = GPOINTER_TO_UINT(g_hash_table_lookup(fc_first_frame_table, GINT_TO_POINTER(pinfo->num))))) {
           retransmitted = TRUE;
@@ -19418,12 +19427,15 @@ retransmit_hash(gconstpointer k)
   guint hash_val;
   int   i;
 
-  hash_val = 0;
+  /* Summing the bytes would put all the stations of one vendor behind
+     the same BSSID into a handful of buckets, so mix them in as
+     g_str_hash() does */
+  hash_val = 5381;
   for (i = 0; i < 6; i++)
-    hash_val += key->bssid[i];
+    hash_val = (hash_val << 5) + hash_val + key->bssid[i];
 
   for (i = 0; i < 6; i++)
-    hash_val += key->src[i];
+    hash_val = (hash_val << 5) + hash_val + key->src[i];
 
   return hash_val;
 }
@@ -19822,6 +19834,7 @@ wlan_retransmit_init(void)
     g_hash_table_destroy(fc_first_frame_table);
     fc_first_frame_table = NULL;
   }
+  fc_last_retransmit_key = NULL;
 
   if (wlan_subdissector)
     return;
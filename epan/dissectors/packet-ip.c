@@ -3006,6 +3006,7 @@ proto_register_ip(void)
     &try_heuristic_first);
 
   ip_handle = register_dissector("ip", dissect_ip, proto_ip);
+  reassembly_table_set_composite(&ip_reassembly_table, TRUE);
   reassembly_table_register(&ip_reassembly_table,
                         &addresses_reassembly_table_functions);
   ip_tap = register_tap("ip");
@@ -3594,6 +3594,7 @@ proto_register_ipv6(void)
                                    &ipv6_exthdr_hide_len_oct_field);
 
     ipv6_handle = register_dissector("ipv6", dissect_ipv6, proto_ipv6);
+    reassembly_table_set_composite(&ipv6_reassembly_table, TRUE);
     reassembly_table_register(&ipv6_reassembly_table,
                           &addresses_reassembly_table_functions);
     ipv6_tap = register_tap("ipv6");
@@ -335,6 +335,25 @@ static range_t *current_kafka_tcp_range = NULL;
  * by default */
 static gboolean kafka_show_string_bytes_lengths = FALSE;
 
+/* How much decompressed message set data to keep, so that compressed message
+ * sets needn't be decompressed again each time their frame is dissected */
+static guint kafka_decompress_cache_mb = 64;
+
+typedef struct _kafka_decompressed_key_t {
+    guint32  frame;
+    guint    offset;        /* of the compressed data in its data source */
+    guint    length;        /* of the compressed data */
+} kafka_decompressed_key_t;
+
+typedef struct _kafka_decompressed_t {
+    guint8  *data;
+    guint    length;
+} kafka_decompressed_t;
+
+/* kafka_decompressed_key_t -> kafka_decompressed_t, in file scope */
+static wmem_map_t *kafka_decompressed_map = NULL;
+static guint64 kafka_decompressed_bytes = 0;
+
 typedef struct _kafka_query_response_t {
     kafka_api_key_t     api_key;
     kafka_api_version_t api_version;
@@ -679,6 +698,76 @@ dissect_kafka_timestamp(tvbuff_t *tvb, packet_info *pinfo _U_, proto_tree *tree,
 }
 
 /* Calculate and show the reduction in transmitted size due to compression */
+static guint
+kafka_decompressed_key_hash(gconstpointer k)
+{
+    const kafka_decompressed_key_t *key = (const kafka_decompressed_key_t *)k;
+
+    return key->frame ^ (key->offset << 16) ^ key->length;
+}
+
+static gboolean
+kafka_decompressed_key_equal(gconstpointer k1, gconstpointer k2)
+{
+    const kafka_decompressed_key_t *key1 = (const kafka_decompressed_key_t *)k1;
+    const kafka_decompressed_key_t *key2 = (const kafka_decompressed_key_t *)k2;
+
+    return key1->frame == key2->frame && key1->offset == key2->offset &&
+           key1->length == key2->length;
+}
+
+static void
+kafka_decompressed_key_init(kafka_decompressed_key_t *key, packet_info *pinfo, tvbuff_t *raw)
+{
+    key->frame = pinfo->num;
+    key->offset = tvb_raw_offset(raw);
+    key->length = tvb_reported_length(raw);
+}
+
+/* The earlier decompression of raw, as a child of tvb, or NULL */
+static tvbuff_t *
+kafka_get_decompressed(tvbuff_t *tvb, packet_info *pinfo, tvbuff_t *raw)
+{
+    kafka_decompressed_key_t key;
+    kafka_decompressed_t *entry;
+
+    kafka_decompressed_key_init(&key, pinfo, raw);
+    entry = (kafka_decompressed_t *)wmem_map_lookup(kafka_decompressed_map, &key);
+    if (entry == NULL)
+        return NULL;
+    return tvb_new_child_real_data(tvb, entry->data, entry->length, entry->length);
+}
+
+/* Remember the decompression of raw, if there's room for it */
+static void
+kafka_add_decompressed(packet_info *pinfo, tvbuff_t *raw, tvbuff_t *payload)
+{
+    kafka_decompressed_key_t lookup_key, *key;
+    kafka_decompressed_t *entry;
+    guint length = tvb_captured_length(payload);
+
+    if (kafka_decompressed_bytes + length > (guint64)kafka_decompress_cache_mb * 1024 * 1024)
+        return;
+
+    kafka_decompressed_key_init(&lookup_key, pinfo, raw);
+    if (wmem_map_lookup(kafka_decompressed_map, &lookup_key) != NULL)
+        return;
+
+    key = wmem_new(wmem_file_scope(), kafka_decompressed_key_t);
+    *key = lookup_key;
+    entry = wmem_new(wmem_file_scope(), kafka_decompressed_t);
+    entry->data = (guint8 *)tvb_memdup(wmem_file_scope(), payload, 0, length);
+    entry->length = length;
+    wmem_map_insert(kafka_decompressed_map, key, entry);
+    kafka_decompressed_bytes += length;
+}
+
+static void
+kafka_init(void)
+{
+    kafka_decompressed_bytes = 0;
+}
+
 static void show_compression_reduction(tvbuff_t *tvb, proto_tree *tree, guint compressed_size, guint uncompressed_size)
 {
     proto_item *ti;
@@ -740,7 +829,12 @@ dissect_kafka_message(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, int s
                 proto_tree_add_item(subtree, hf_kafka_message_value_compressed, tvb, offset, compressed_size, ENC_NA);
 
                 /* Unzip message and add payload to new data tab */
-                payload = tvb_child_uncompress(tvb, raw, 0, compressed_size);
+                payload = kafka_get_decompressed(tvb, pinfo, raw);
+                if (payload == NULL) {
+                    payload = tvb_child_uncompress(tvb, raw, 0, compressed_size);
+                    if (payload)
+                        kafka_add_decompressed(pinfo, raw, payload);
+                }
                 if (payload) {
                     show_compression_reduction(tvb, subtree, compressed_size, (guint)tvb_captured_length(payload));
 
@@ -773,7 +867,11 @@ dissect_kafka_message(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, int s
                 /* Raw compressed data */
                 proto_tree_add_item(subtree, hf_kafka_message_value_compressed, tvb, offset, compressed_size, ENC_NA);
 
-                if (tvb_memeql(raw, 0, kafka_xerial_header, sizeof(kafka_xerial_header)) == 0) {
+                payload = kafka_get_decompressed(tvb, pinfo, raw);
+                if (payload) {
+                    ret = SNAPPY_OK;
+                    uncompressed_size = tvb_captured_length(payload);
+                } else if (tvb_memeql(raw, 0, kafka_xerial_header, sizeof(kafka_xerial_header)) == 0) {
                     /* xerial framing format */
                     guint chunk_size, pos = 16;
 
@@ -814,6 +912,7 @@ dissect_kafka_message(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, int s
                     }
                 }
                 if (ret == SNAPPY_OK) {
+                    kafka_add_decompressed(pinfo, raw, payload);
                     show_compression_reduction(tvb, subtree, compressed_size, (guint)uncompressed_size);
 
                     add_new_data_source(pinfo, payload, "Uncompressed Message");
@@ -858,6 +957,11 @@ dissect_kafka_message(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, int s
                 /* Show raw compressed data */
                 proto_tree_add_item(subtree, hf_kafka_message_value_compressed, tvb, offset, compressed_size, ENC_NA);
 
+                payload = kafka_get_decompressed(tvb, pinfo, raw);
+                if (payload) {
+                    goto decompressed;
+                }
+
                 /* Allocate output buffer */
                 ret = LZ4F_createDecompressionContext(&lz4_ctxt, LZ4F_VERSION);
                 if (LZ4F_isError(ret)) {
@@ -897,13 +1001,13 @@ dissect_kafka_message(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, int s
                                       &data[src_offset], &src_size, NULL);
                 LZ4F_freeDecompressionContext(lz4_ctxt);
                 if (ret == 0) {
-                    size_t uncompressed_size = dst_size;
-
-                    show_compression_reduction(tvb, subtree, compressed_size, (guint)uncompressed_size);
+                    payload = tvb_new_child_real_data(tvb, decompressed_buffer,
+                                                      (guint32)dst_size, (guint32)dst_size);
+                    kafka_add_decompressed(pinfo, raw, payload);
+                decompressed:
+                    show_compression_reduction(tvb, subtree, compressed_size, tvb_captured_length(payload));
 
                     /* Add as separate data tab */
-                    payload = tvb_new_child_real_data(tvb, decompressed_buffer,
-                                                      (guint32)uncompressed_size, (guint32)uncompressed_size);
                     add_new_data_source(pinfo, payload, "Uncompressed Message");
 
                     /* Dissect as a message set */
@@ -4117,6 +4221,17 @@ proto_register_kafka(void)
         "Show length for string and bytes fields in the protocol tree",
         "",
         &kafka_show_string_bytes_lengths);
+
+    prefs_register_uint_preference(kafka_module, "decompress_cache_size",
+        "Decompressed message set cache size (MB)",
+        "How much decompressed message set data to keep, so that compressed "
+        "message sets don't have to be decompressed again when their frames "
+        "are dissected again. 0 disables the cache.",
+        10, &kafka_decompress_cache_mb);
+
+    kafka_decompressed_map = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(),
+                                                    kafka_decompressed_key_hash, kafka_decompressed_key_equal);
+    register_init_routine(kafka_init);
 }
 
 void
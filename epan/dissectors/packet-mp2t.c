@@ -47,6 +47,7 @@ void proto_reg_handoff_mp2t(void);
 
 #define MP2T_PID_DOCSIS  0x1FFE
 #define MP2T_PID_NULL    0x1FFF
+#define MP2T_PID_COUNT   0x2000
 
 static dissector_handle_t mp2t_handle;
 
@@ -259,7 +260,7 @@ static const fragment_items mp2t_msg_frag_items = {
  *    |
  *    +-> mp2t_analysis_data
  *          |
- *          +-> pid_table (RB tree) (key: pid)
+ *          +-> pid_table (array) (index: pid)
  *          |     |
  *          |     +-> pid_analysis_data (per pid)
  *          |     +-> pid_analysis_data
@@ -278,11 +279,11 @@ static const fragment_items mp2t_msg_frag_items = {
 
 typedef struct mp2t_analysis_data {
 
-    /* This structure contains a tree containing data for the
-     * individual pid's, this is only used when packets are
-     * processed sequentially.
+    /* This structure contains an array with data for the
+     * individual pid's, indexed by pid and allocated on first use;
+     * it has MP2T_PID_COUNT entries, NULL for the unseen pid's.
      */
-    wmem_tree_t    *pid_table;
+    struct pid_analysis_data **pid_table;
 
     /* When detecting a CC drop, store that information for the
      * given frame.  This info is needed, when clicking around in
@@ -357,7 +358,7 @@ init_mp2t_conversation_data(void)
 
     mp2t_data = wmem_new0(wmem_file_scope(), struct mp2t_analysis_data);
 
-    mp2t_data->pid_table = wmem_tree_new(wmem_file_scope());
+    mp2t_data->pid_table = NULL;
 
     mp2t_data->frame_table = wmem_tree_new(wmem_file_scope());
 
@@ -409,14 +410,19 @@ get_pid_analysis(mp2t_analysis_data_t *mp2t_data, guint32 pid)
 {
     pid_analysis_data_t  *pid_data;
 
-    pid_data = (pid_analysis_data_t *)wmem_tree_lookup32(mp2t_data->pid_table, pid);
+    /* Every TS packet needs this, so it's a direct lookup */
+    if (!mp2t_data->pid_table) {
+        mp2t_data->pid_table = wmem_alloc0_array(wmem_file_scope(), struct pid_analysis_data *, MP2T_PID_COUNT);
+    }
+    pid &= MP2T_PID_COUNT - 1;
+    pid_data = mp2t_data->pid_table[pid];
     if (!pid_data) {
         pid_data          = wmem_new0(wmem_file_scope(), struct pid_analysis_data);
         pid_data->cc_prev = -1;
         pid_data->pid     = pid;
         pid_data->frag_id = (pid << (32 - 13)) | 0x1;
 
-        wmem_tree_insert32(mp2t_data->pid_table, pid, (void *)pid_data);
+        mp2t_data->pid_table[pid] = pid_data;
     }
     return pid_data;
 }
@@ -842,10 +848,10 @@ calc_skips(gint32 curr, gint32 prev)
 
 static guint32
 detect_cc_drops(tvbuff_t *tvb, proto_tree *tree, packet_info *pinfo,
-        guint32 pid, gint32 cc_curr, mp2t_analysis_data_t *mp2t_data)
+        guint32 pid, gint32 cc_curr, mp2t_analysis_data_t *mp2t_data,
+        pid_analysis_data_t *pid_data)
 {
     gint32 cc_prev = -1;
-    pid_analysis_data_t   *pid_data              = NULL;
     ts_analysis_data_t    *ts_data               = NULL;
     frame_analysis_data_t *frame_analysis_data_p = NULL;
     proto_item            *flags_item;
@@ -856,8 +862,6 @@ detect_cc_drops(tvbuff_t *tvb, proto_tree *tree, packet_info *pinfo,
     /* The initial sequential processing stage */
     if (!pinfo->fd->flags.visited) {
         /* This is the sequential processing stage */
-        pid_data = get_pid_analysis(mp2t_data, pid);
-
         cc_prev = pid_data->cc_prev;
         pid_data->cc_prev = cc_curr;
 
@@ -1085,13 +1089,12 @@ dissect_mp2t_adaptation_field(tvbuff_t *tvb, gint offset, proto_tree *tree)
 
 static void
 dissect_tsp(tvbuff_t *tvb, gint offset, packet_info *pinfo,
-        proto_tree *tree, conversation_t *conv)
+        proto_tree *tree, mp2t_analysis_data_t *mp2t_data)
 {
     guint32              header;
     guint                afc;
     gint                 start_offset = offset;
     gint                 payload_len;
-    mp2t_analysis_data_t *mp2t_data;
     pid_analysis_data_t *pid_analysis;
 
     guint32     skips;
@@ -1134,8 +1137,6 @@ dissect_tsp(tvbuff_t *tvb, gint offset, packet_info *pinfo,
     afci = proto_tree_add_item( mp2t_header_tree, hf_mp2t_afc, tvb, offset, 4, ENC_BIG_ENDIAN);
     proto_tree_add_item( mp2t_header_tree, hf_mp2t_cc, tvb, offset, 4, ENC_BIG_ENDIAN);
 
-    mp2t_data = get_mp2t_conversation_data(conv);
-
     pid_analysis = get_pid_analysis(mp2t_data, pid);
 
     if (pid_analysis->pload_type == pid_pload_unknown) {
@@ -1170,7 +1171,7 @@ dissect_tsp(tvbuff_t *tvb, gint offset, packet_info *pinfo,
     mp2t_analysis_tree = proto_tree_add_subtree_format(mp2t_tree, tvb, offset, 0, ett_mp2t_analysis, &item, "MPEG2 PCR Analysis");
     PROTO_ITEM_SET_GENERATED(item);
 
-    skips = detect_cc_drops(tvb, mp2t_analysis_tree, pinfo, pid, cc, mp2t_data);
+    skips = detect_cc_drops(tvb, mp2t_analysis_tree, pinfo, pid, cc, mp2t_data, pid_analysis);
 
     if (skips > 0)
         proto_item_append_text(ti, " skips=%d", skips);
@@ -1207,11 +1208,14 @@ dissect_mp2t( tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U
 {
     guint         offset = 0;
     conversation_t    *conv;
+    mp2t_analysis_data_t *mp2t_data;
 
     conv = find_or_create_conversation(pinfo);
+    /* All the TS packets of the frame share it */
+    mp2t_data = get_mp2t_conversation_data(conv);
 
     for (; tvb_reported_length_remaining(tvb, offset) >= MP2T_PACKET_SIZE; offset += MP2T_PACKET_SIZE) {
-       dissect_tsp(tvb, offset, pinfo, tree, conv);
+       dissect_tsp(tvb, offset, pinfo, tree, mp2t_data);
     }
     return tvb_captured_length(tvb);
 }
@@ -294,6 +294,10 @@ typedef struct _v9_v10_tmplt_entry {
     guint16      length;
     guint32      pen;
     const gchar *pen_str;
+    /* Worked out from the above once, when the template is cached */
+    guint64      pen_type;
+    guint16      masked_type;
+    int          rev;
 } v9_v10_tmplt_entry_t;
 
 typedef enum {
@@ -321,6 +325,8 @@ typedef struct _v9_v10_tmplt {
     guint32  src_id;   /* SourceID in NetFlow V9, Observation Domain ID in IPFIX */
     guint16  tmplt_id;
     guint    length;
+    guint8   vspec;    /* version the entries' pen_type were worked out for */
+    gboolean variable_length;  /* any of the fields is of variable length */
     guint16  field_count[TF_NUM];                /* 0:scopes; 1:entries  */
     v9_v10_tmplt_entry_t *fields_p[TF_NUM_EXT];  /* 0:scopes; 1:entries; n:vendor_entries  */
 } v9_v10_tmplt_t;
@@ -4034,6 +4040,20 @@ dissect_v9_v10_data(tvbuff_t *tvb, packet_info *pinfo, proto_tree *pdutree, int
         }
         PROTO_ITEM_SET_GENERATED(ti);
 
+        if ((pdutree == NULL) && !tmplt_p->variable_length &&
+            ((tmplt_p->tmplt_id < 256) || (tmplt_p->tmplt_id > 259))) {
+            /* Nothing is shown and all the flows are the same size, so there
+               is nothing to do but count them.  The templates used for the
+               process info (see dissect_v9_v10_pdu_data()) are left out. */
+            guint flows = length / tmplt_p->length;
+
+            tvb_ensure_bytes_exist(tvb, offset, (gint)(flows * tmplt_p->length));
+            *flows_seen += flows;
+            count += flows;
+            offset += flows * tmplt_p->length;
+            length -= flows * tmplt_p->length;
+        }
+
         /* Note: If the flow contains variable length fields then          */
         /*       tmplt_p->length will be less then actual length of the flow. */
         while (length >= tmplt_p->length) {
@@ -4155,6 +4175,26 @@ dissect_v9_pdu_scope(tvbuff_t *tvb, packet_info *pinfo _U_, proto_tree *pdutree,
     return (guint) (offset - orig_offset);
 }
 
+/* Work out the key of the per-field switch in dissect_v9_v10_pdu_data() */
+static void
+v9_v10_tmplt_entry_set_type(const v9_v10_tmplt_entry_t *entry, guint8 vspec,
+                            guint64 *pen_type, guint16 *masked_type, int *rev)
+{
+    *pen_type = *masked_type = entry->type;
+    *rev      = 0;
+
+    if ((vspec == 10) && (entry->type & 0x8000)) {
+        *pen_type = *masked_type = entry->type & 0x7fff;
+        if (entry->pen == REVPEN) { /* reverse PEN */
+            *rev = 1;
+        } else if (entry->pen == 0) {
+            *pen_type = (G_GUINT64_CONSTANT(0xffff) << 16) | *pen_type;  /* hack to force "unknown" */
+        } else {
+            *pen_type = (((guint64)entry->pen) << 16) | *pen_type;
+        }
+    }
+}
+
 /* Type of duration being calculated for a flow. */
 enum duration_type_e {
     duration_type_switched,
@@ -4278,18 +4318,12 @@ dissect_v9_v10_pdu_data(tvbuff_t *tvb, packet_info *pinfo, proto_tree *pdutree,
          *    0x 0000 0001 0000 to
          *    0x ffff ffff 7fff
          */
-        pen_type = masked_type = type;
-        rev      = 0;
-
-        if ((hdrinfo_p->vspec == 10) && (type & 0x8000)) {
-            pen_type = masked_type = type & 0x7fff;
-            if (pen == REVPEN) { /* reverse PEN */
-                rev = 1;
-            } else if (pen == 0) {
-                pen_type = (G_GUINT64_CONSTANT(0xffff) << 16) | pen_type;  /* hack to force "unknown" */
-            } else {
-                pen_type = (((guint64)pen) << 16) | pen_type;
-            }
+        if (tmplt_p->vspec == hdrinfo_p->vspec) {
+            pen_type    = entries_p[i].pen_type;
+            masked_type = entries_p[i].masked_type;
+            rev         = entries_p[i].rev;
+        } else {
+            v9_v10_tmplt_entry_set_type(&entries_p[i], hdrinfo_p->vspec, &pen_type, &masked_type, &rev);
         }
 
         /* Provide a convenient (hidden) filter for any items belonging to a known PIE,
@@ -9982,13 +10016,19 @@ dissect_v9_v10_template_fields(tvbuff_t *tvb, packet_info *pinfo _U_, proto_tree
         }
 
         if (tmplt_p->fields_p[fields_type] != NULL) {
+            v9_v10_tmplt_entry_t *entry = &tmplt_p->fields_p[fields_type][i];
+
             DISSECTOR_ASSERT (i < count);
-            tmplt_p->fields_p[fields_type][i].type    = type;
-            tmplt_p->fields_p[fields_type][i].length  = length;
-            tmplt_p->fields_p[fields_type][i].pen     = pen;
-            tmplt_p->fields_p[fields_type][i].pen_str = pen_str;
+            entry->type    = type;
+            entry->length  = length;
+            entry->pen     = pen;
+            entry->pen_str = pen_str;
+            v9_v10_tmplt_entry_set_type(entry, ver, &entry->pen_type, &entry->masked_type, &entry->rev);
+            tmplt_p->vspec = ver;
             if (length != VARIABLE_LENGTH) { /* Don't include "variable length" in the total */
                 tmplt_p->length    += length;
+            } else {
+                tmplt_p->variable_length = TRUE;
             }
         }
 
@@ -1388,6 +1388,11 @@ dissect_ntp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_)
 						"Unknown version"),
 	                       val_to_str_const(flags & NTP_MODE_MASK, info_mode_types, "Unknown"));
 
+	/* The body is self-contained, so if nobody wants any of its
+	 * fields there is no need to look at it at all. */
+	if (!proto_protocol_body_is_needed(tree, proto_ntp))
+		return tvb_captured_length(tvb);
+
 	/* Dissect according to mode */
 	(*dissector)(tvb, pinfo, ntp_tree);
 	return tvb_captured_length(tvb);
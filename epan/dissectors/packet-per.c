@@ -734,14 +734,9 @@ DEBUG_ENTRY("dissect_per_restricted_character_string");
 	old_offset=offset;
 	for(char_pos=0;char_pos<length;char_pos++){
 		guchar val;
-		int i;
-		gboolean bit;
 
-		val=0;
-		for(i=0;i<bits_per_char;i++){
-			offset=dissect_per_boolean(tvb, offset, actx, tree, -1, &bit);
-			val=(val<<1)|bit;
-		}
+		val=tvb_get_bits8(tvb, offset, bits_per_char);
+		offset+=bits_per_char;
 		if(use_canonical_order == FALSE){
 			buf[char_pos]=val;
 		} else {
@@ -753,6 +748,10 @@ DEBUG_ENTRY("dissect_per_restricted_character_string");
 		}
 	}
 	buf[char_pos]=0;
+	if(length){
+		/* the characters used to be read through dissect_per_boolean() */
+		actx->created_item=NULL;
+	}
 	proto_tree_add_string(tree, hf_index, tvb, (old_offset>>3), (offset>>3)-(old_offset>>3), (char*)buf);
 	if (value_tvb) {
 		*value_tvb = tvb_new_child_real_data(tvb, buf, length, length);
@@ -760,6 +759,13 @@ DEBUG_ENTRY("dissect_per_restricted_character_string");
 	return offset;
 }
 
+/*
+ * Sorted copies of the permitted alphabets, keyed by the alphabet pointer.
+ * The generated dissectors always pass string literals, so each alphabet
+ * only has to be sorted once rather than for every string dissected.
+ */
+static wmem_map_t *sorted_alphabets = NULL;
+
 static const char*
 sort_alphabet(char *sorted_alphabet, const char *alphabet, int alphabet_length)
 {
@@ -790,12 +796,19 @@ guint32
 dissect_per_restricted_character_string(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, proto_tree *tree, int hf_index, int min_len, int max_len, gboolean has_extension, const char *alphabet, int alphabet_length, tvbuff_t **value_tvb)
 {
 	const char *alphabet_ptr;
-	char sorted_alphabet[128];
+	char *sorted_alphabet;
 
 	if (alphabet_length > 127) {
 		alphabet_ptr = alphabet;
 	} else {
-		alphabet_ptr = sort_alphabet(sorted_alphabet, alphabet, alphabet_length);
+		if (!sorted_alphabets)
+			sorted_alphabets = wmem_map_new(wmem_epan_scope(), g_direct_hash, g_direct_equal);
+		alphabet_ptr = (const char *)wmem_map_lookup(sorted_alphabets, alphabet);
+		if (!alphabet_ptr) {
+			sorted_alphabet = (char *)wmem_alloc0(wmem_epan_scope(), 128);
+			alphabet_ptr = sort_alphabet(sorted_alphabet, alphabet, alphabet_length);
+			wmem_map_insert(sorted_alphabets, alphabet, sorted_alphabet);
+		}
 	}
 	/* Not a known-multiplier character string: enforce lb and ub to max values */
 	return dissect_per_restricted_character_string_sorted(tvb, offset, actx, tree, hf_index, min_len, max_len, has_extension, 0, 65535, alphabet_ptr, alphabet_length, value_tvb);
@@ -1990,6 +1990,7 @@ dissect_rtp( tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void *data _U_
     guint16     seq_num;
     guint32     timestamp;
     guint32     sync_src;
+    tvb_view_t  hdr_view;
     struct _rtp_conversation_info *p_conv_data;
     /*struct srtp_info *srtp_info = NULL;*/
     /*unsigned int srtp_offset;*/
@@ -2080,9 +2081,10 @@ dissect_rtp( tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void *data _U_
     }
 
     /* Get the subsequent fields */
-    seq_num = tvb_get_ntohs( tvb, offset + 2 );
-    timestamp = tvb_get_ntohl( tvb, offset + 4 );
-    sync_src = tvb_get_ntohl( tvb, offset + 8 );
+    tvb_get_view( tvb, offset + 2, 10, &hdr_view );
+    seq_num = tvb_view_get_ntohs( &hdr_view, 0 );
+    timestamp = tvb_view_get_ntohl( &hdr_view, 2 );
+    sync_src = tvb_view_get_ntohl( &hdr_view, 6 );
 
     /* fill in the rtp_info structure */
     rtp_info->info_padding_set = padding_set;
@@ -511,6 +511,7 @@ typedef struct _infodata_t {
 } infodata_t;
 
 static wmem_list_t *assoc_info_list = NULL;
+static wmem_map_t *assoc_info_by_ports = NULL; /* wmem_list_t of assoc_info_t by sctp_assoc_ports_key() */
 static guint num_assocs = 0;
 
 UAT_CSTRING_CB_DEF(type_fields, type_name, type_field_t)
@@ -663,21 +664,24 @@ static gint sctp_assoc_vtag_cmp(const assoc_info_t *a, const assoc_info_t *b)
 }
 #undef RETURN_DIRECTION
 
-static infodata_t
-find_assoc_index(assoc_info_t* tmpinfo, gboolean visited)
+/* The ports of both directions of an association give the same key */
+static gpointer
+sctp_assoc_ports_key(const assoc_info_t *info)
+{
+  guint16 lo = MIN(info->sport, info->dport);
+  guint16 hi = MAX(info->sport, info->dport);
+
+  return GUINT_TO_POINTER(((guint32)lo << 16) | hi);
+}
+
+static gboolean
+find_assoc_index_in(wmem_list_t *list, assoc_info_t* tmpinfo, gboolean visited, infodata_t *inf)
 {
   assoc_info_t *info = NULL;
   wmem_list_frame_t *elem;
   gboolean cmp = FALSE;
-  infodata_t inf;
-  inf.assoc_index = -1;
-  inf.direction = 1;
-
-  if (assoc_info_list == NULL) {
-    assoc_info_list = wmem_list_new(wmem_file_scope());
-  }
 
-  for (elem = wmem_list_head(assoc_info_list); elem; elem = wmem_list_frame_next(elem))
+  for (elem = wmem_list_head(list); elem; elem = wmem_list_frame_next(elem))
   {
     info = (assoc_info_t*) wmem_list_frame_data(elem);
 
@@ -699,42 +703,76 @@ find_assoc_index(assoc_info_t* tmpinfo, gboolean visited)
         } else {
           info->direction = 2;
         }
-        inf.assoc_index = info->assoc_index;
-        inf.direction = info->direction;
-        return inf;
+        inf->assoc_index = info->assoc_index;
+        inf->direction = info->direction;
+        return TRUE;
       }
     } else {
       if ((tmpinfo->initiate_tag != 0 && tmpinfo->initiate_tag == info->initiate_tag) ||
           (tmpinfo->verification_tag1 != 0 && tmpinfo->verification_tag1 == info->verification_tag1) ||
           (tmpinfo->verification_tag2 != 0 && tmpinfo->verification_tag2 == info->verification_tag2)) {
-        inf.assoc_index = info->assoc_index;
-        inf.direction = info->direction;
-        return inf;
+        inf->assoc_index = info->assoc_index;
+        inf->direction = info->direction;
+        return TRUE;
       } else if ((tmpinfo->verification_tag1 != 0 && tmpinfo->verification_tag1 == info->verification_tag2) ||
                  (tmpinfo->verification_tag2 != 0 && tmpinfo->verification_tag2 == info->verification_tag1)) {
-        inf.assoc_index = info->assoc_index;
+        inf->assoc_index = info->assoc_index;
         if (info->direction == 1)
-          inf.direction = 2;
+          inf->direction = 2;
         else
-          inf.direction = 1;
-        return inf;
+          inf->direction = 1;
+        return TRUE;
       }
     }
   }
 
-  if (!elem && !visited) {
-    info = wmem_new0(wmem_file_scope(), assoc_info_t);
-    info->assoc_index = num_assocs;
-    info->sport = tmpinfo->sport;
-    info->dport = tmpinfo->dport;
-    info->verification_tag1 = tmpinfo->verification_tag1;
-    info->verification_tag2 = tmpinfo->verification_tag2;
-    info->initiate_tag = tmpinfo->initiate_tag;
-    num_assocs++;
-    wmem_list_prepend(assoc_info_list, info);
-    inf.assoc_index = info->assoc_index;
-    inf.direction = 1;
+  return FALSE;
+}
+
+static infodata_t
+find_assoc_index(assoc_info_t* tmpinfo, gboolean visited)
+{
+  assoc_info_t *info = NULL;
+  wmem_list_t *same_ports;
+  infodata_t inf;
+  inf.assoc_index = -1;
+  inf.direction = 1;
+
+  if (assoc_info_list == NULL) {
+    assoc_info_list = wmem_list_new(wmem_file_scope());
+    assoc_info_by_ports = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
+  }
+
+  /*
+   * sctp_assoc_vtag_cmp() only matches associations on the same ports,
+   * so look at those first.  The tags are all that is compared once
+   * the frame has been visited, so all of them are tried if none of
+   * those matches.
+   */
+  same_ports = (wmem_list_t *)wmem_map_lookup(assoc_info_by_ports, sctp_assoc_ports_key(tmpinfo));
+  if (same_ports && find_assoc_index_in(same_ports, tmpinfo, visited, &inf))
+    return inf;
+  if (visited) {
+    find_assoc_index_in(assoc_info_list, tmpinfo, visited, &inf);
+    return inf;
+  }
+
+  info = wmem_new0(wmem_file_scope(), assoc_info_t);
+  info->assoc_index = num_assocs;
+  info->sport = tmpinfo->sport;
+  info->dport = tmpinfo->dport;
+  info->verification_tag1 = tmpinfo->verification_tag1;
+  info->verification_tag2 = tmpinfo->verification_tag2;
+  info->initiate_tag = tmpinfo->initiate_tag;
+  num_assocs++;
+  wmem_list_prepend(assoc_info_list, info);
+  if (!same_ports) {
+    same_ports = wmem_list_new(wmem_file_scope());
+    wmem_map_insert(assoc_info_by_ports, sctp_assoc_ports_key(info), same_ports);
   }
+  wmem_list_prepend(same_ports, info);
+  inf.assoc_index = info->assoc_index;
+  inf.direction = 1;
 
   return inf;
 }
@@ -2691,6 +2729,7 @@ sctp_init(void)
       (GDestroyNotify)g_free, (GDestroyNotify)frag_free_msgs);
   num_assocs = 0;
   assoc_info_list = NULL;
+  assoc_info_by_ports = NULL;
 }
 
 static void
@@ -41,6 +41,7 @@
 #include <epan/asn1.h>
 #include <epan/reassemble.h>
 #include <epan/uat.h>
+#include <epan/proto_data.h>
 
 #include "packet-smb2.h"
 #include "packet-ntlmssp.h"
@@ -954,7 +955,11 @@ gboolean eosmb2_take_name_as_fid = FALSE ;
 
 /* unmatched smb_saved_info structures.
    For unmatched smb_saved_info structures we store the smb_saved_info
-   structure using the msg_id field.
+   structure using the msg_id field.  Once a request has been seen its
+   smb_saved_info is also attached to the frames of the request and of
+   the response as proto data, keyed by the low 32 bits of the msg_id,
+   and that is where later passes find it.  So only the requests that
+   are still waiting for a response stay in a hash table.
 */
 static gint
 smb2_saved_info_equal_unmatched(gconstpointer k1, gconstpointer k2)
@@ -973,27 +978,6 @@ smb2_saved_info_hash_unmatched(gconstpointer k)
 	return hash;
 }
 
-/* matched smb_saved_info structures.
-   For matched smb_saved_info structures we store the smb_saved_info
-   structure using the msg_id field.
-*/
-static gint
-smb2_saved_info_equal_matched(gconstpointer k1, gconstpointer k2)
-{
-	const smb2_saved_info_t *key1 = (const smb2_saved_info_t *)k1;
-	const smb2_saved_info_t *key2 = (const smb2_saved_info_t *)k2;
-	return key1->msg_id == key2->msg_id;
-}
-static guint
-smb2_saved_info_hash_matched(gconstpointer k)
-{
-	const smb2_saved_info_t *key = (const smb2_saved_info_t *)k;
-	guint32 hash;
-
-	hash = (guint32) (key->msg_id&0xffffffff);
-	return hash;
-}
-
 /* For Tids of a specific conversation.
    This keeps track of tid->sharename mappings and other information about the
    tid.
@@ -1098,7 +1082,6 @@ smb2_conv_destroy(wmem_allocator_t *allocator _U_, wmem_cb_event_t event _U_,
 {
 	smb2_conv_info_t *conv = (smb2_conv_info_t *)user_data;
 
-	g_hash_table_destroy(conv->matched);
 	g_hash_table_destroy(conv->unmatched);
 	g_hash_table_destroy(conv->fids);
 	g_hash_table_destroy(conv->sesids);
@@ -5264,8 +5247,23 @@ smb2_pipe_set_file_id(packet_info *pinfo, smb2_info_t *si)
 }
 
 static gboolean smb2_pipe_reassembly = TRUE;
+static gboolean smb2_dissect_rw_data = TRUE;
 static reassembly_table smb2_pipe_reassembly_table;
 
+/*
+ * Should the data of a READ or WRITE be offered to the named pipe
+ * subdissectors?  Without the preference, only if we saw the tree
+ * being connected to a named pipe share.
+ */
+static gboolean
+smb2_rw_data_may_be_pipe(const smb2_info_t *si)
+{
+	if (smb2_dissect_rw_data) {
+		return TRUE;
+	}
+	return si->tree != NULL && si->tree->share_type == SMB2_SHARE_TYPE_PIPE;
+}
+
 static int
 dissect_file_data_smb2_pipe(tvbuff_t *raw_tvb, packet_info *pinfo, proto_tree *tree _U_, int offset, guint32 datalen, proto_tree *top_tree, void *data)
 {
@@ -5595,7 +5593,7 @@ dissect_smb2_write_request(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
 	data_tvb_len=(guint32)tvb_captured_length_remaining(tvb, offset);
 
 	/* data or namedpipe ?*/
-	if (length) {
+	if (length && smb2_rw_data_may_be_pipe(si)) {
 		int oldoffset = offset;
 		smb2_pipe_set_file_id(pinfo, si);
 		offset = dissect_file_data_smb2_pipe(tvb, pinfo, tree, offset, length, si->top_tree, si);
@@ -6978,7 +6976,7 @@ dissect_smb2_read_request(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, i
 
 
 static int
-dissect_smb2_read_response(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, int offset, smb2_info_t *si _U_)
+dissect_smb2_read_response(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, int offset, smb2_info_t *si)
 {
 	guint16 dataoffset = 0;
 	guint32 data_tvb_len;
@@ -7013,7 +7011,7 @@ dissect_smb2_read_response(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
 	data_tvb_len=(guint32)tvb_captured_length_remaining(tvb, offset);
 
 	/* data or namedpipe ?*/
-	if (length) {
+	if (length && smb2_rw_data_may_be_pipe(si)) {
 		int oldoffset = offset;
 		smb2_pipe_set_file_id(pinfo, si);
 		offset = dissect_file_data_smb2_pipe(tvb, pinfo, tree, offset, length, si->top_tree, si);
@@ -9212,8 +9210,6 @@ dissect_smb2(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, gboolea
 		si->conv = wmem_new(wmem_file_scope(), smb2_conv_info_t);
 		/* qqq this leaks memory for now since we never free
 		   the hashtables */
-		si->conv->matched = g_hash_table_new(smb2_saved_info_hash_matched,
-			smb2_saved_info_equal_matched);
 		si->conv->unmatched = g_hash_table_new(smb2_saved_info_hash_unmatched,
 			smb2_saved_info_equal_unmatched);
 		si->conv->sesids = g_hash_table_new(smb2_sesid_info_hash,
@@ -9372,21 +9368,16 @@ dissect_smb2(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, gboolea
 				if (!((si->flags & SMB2_FLAGS_ASYNC_CMD)
 					&& si->status == NT_STATUS_PENDING)
 					&& ssi) {
-					/* just  set the response frame and move it to the matched table */
+					/* just  set the response frame, it's matched now */
 					ssi->frame_res = pinfo->num;
 					g_hash_table_remove(si->conv->unmatched, ssi);
-					g_hash_table_insert(si->conv->matched, ssi, ssi);
 				}
 			}
-		} else {
-			/* see if we can find this msg_id in the matched table */
-			ssi = (smb2_saved_info_t *)g_hash_table_lookup(si->conv->matched, &ssi_key);
-			/* if we couldn't find it in the matched table, it might still
-			* be in the unmatched table
-			*/
-			if (!ssi) {
-				ssi = (smb2_saved_info_t *)g_hash_table_lookup(si->conv->unmatched, &ssi_key);
+			if (ssi) {
+				p_add_proto_data(wmem_file_scope(), pinfo, proto_smb2, (guint32)ssi_key.msg_id, ssi);
 			}
+		} else {
+			ssi = (smb2_saved_info_t *)p_get_proto_data(wmem_file_scope(), pinfo, proto_smb2, (guint32)ssi_key.msg_id);
 		}
 
 		if (ssi) {
@@ -11851,6 +11842,13 @@ proto_register_smb2(void)
 		"Whether the dissector should reassemble Named Pipes over SMB2 commands",
 		&smb2_pipe_reassembly);
 
+	prefs_register_bool_preference(smb2_module, "dissect_rw_data",
+		"Dissect the data of READ and WRITE commands",
+		"Whether the data of READ and WRITE commands should be handed to the Named Pipe"
+		" subdissectors even if the tree isn't known to be a pipe share. Turning this off"
+		" makes captures of bulk file copies much faster to load",
+		&smb2_dissect_rw_data);
+
 	seskey_uat = uat_new("Secret session key to use for decryption",
 			     sizeof(smb2_seskey_field_t),
 			     "smb2_seskey_list",
@@ -101,9 +101,9 @@ typedef struct _smb2_sesid_info_t {
  * There is one such structure for each conversation.
  */
 typedef struct _smb2_conv_info_t {
-	/* these two tables are used to match requests with responses */
+	/* requests waiting for their response; the frames of matched
+	 * ones keep them as proto data */
 	GHashTable *unmatched;
-	GHashTable *matched;
 	GHashTable *sesids;
 	GHashTable *fids;
 	/* table to store some infos for smb export object */
@@ -5093,6 +5093,7 @@ ssl_load_keyfile(const gchar *ssl_keylog_filename, FILE **keylog_file,
 {
     unsigned i;
     GRegex *regex;
+    gboolean appending;
     ssl_master_key_match_group_t mk_groups[] = {
         { "encrypted_pmk",  mk_map->pre_master },
         { "session_id",     mk_map->session },
@@ -5161,6 +5162,9 @@ ssl_load_keyfile(const gchar *ssl_keylog_filename, FILE **keylog_file,
         *keylog_file = NULL;
     }
 
+    /* The file stays open between calls, so this only reads the lines that
+     * were appended since the last call. */
+    appending = *keylog_file != NULL;
     if (*keylog_file == NULL) {
         *keylog_file = ws_fopen(ssl_keylog_filename, "r");
         if (!*keylog_file) {
@@ -5173,16 +5177,29 @@ ssl_load_keyfile(const gchar *ssl_keylog_filename, FILE **keylog_file,
         char buf[512], *line;
         gsize bytes_read;
         GMatchInfo *mi;
+        long line_start;
 
+        line_start = ftell(*keylog_file);
         line = fgets(buf, sizeof(buf), *keylog_file);
-        if (!line)
+        if (!line) {
+            /* A stream at EOF stays there until cleared, which would hide
+             * any lines appended later. */
+            clearerr(*keylog_file);
             break;
+        }
 
         bytes_read = strlen(line);
         /* fgets includes the \n at the end of the line. */
         if (bytes_read > 0 && line[bytes_read - 1] == '\n') {
             line[bytes_read - 1] = 0;
             bytes_read--;
+        } else if (appending && feof(*keylog_file) && line_start >= 0) {
+            /* The application is probably still writing this line and a
+             * truncated secret would still match. Read it again next time. */
+            ssl_debug_printf("  incomplete keylog line, deferring: %s\n", line);
+            clearerr(*keylog_file);
+            fseek(*keylog_file, line_start, SEEK_SET);
+            break;
         }
         if (bytes_read > 0 && line[bytes_read - 1] == '\r') {
             line[bytes_read - 1] = 0;
@@ -520,7 +520,7 @@ ssl_follow_tap_listener(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _
                                               appl_data->data_len);
 
         /* Append the record to the follow_info structure. */
-        follow_info->payload = g_list_append(follow_info->payload, follow_record);
+        follow_info_add_record(follow_info, follow_record);
         follow_info->bytes_written[from] += appl_data->data_len;
     }
 
@@ -1012,13 +1012,8 @@ decrypt_ssl3_record(tvbuff_t *tvb, packet_info *pinfo, guint32 offset, SslDecryp
     success = ssl_decrypt_record(ssl, decoder, content_type, record_version,
                            tvb_get_ptr(tvb, offset, record_length), record_length,
                            &ssl_compressed_data, &ssl_decrypted_data, &ssl_decrypted_data_avail) == 0;
-    /*  */
-    if (!success) {
-        /* save data to update IV if valid session key is obtained later */
-        data_for_iv = (direction != 0) ? &ssl->server_data_for_iv : &ssl->client_data_for_iv;
-        data_for_iv_len = (record_length < 24) ? record_length : 24;
-        ssl_data_set(data_for_iv, (const guchar*)tvb_get_ptr(tvb, offset + record_length - data_for_iv_len, data_for_iv_len), data_for_iv_len);
-    }
+    /* On failure, data_for_iv was already saved above in case a valid
+     * session key is obtained later. */
     if (success && ssl_decrypted_data_avail > 0) {
         const guchar *data = ssl_decrypted_data.data;
         guint datalen = ssl_decrypted_data_avail;
@@ -585,6 +585,7 @@ static dissector_handle_t data_handle;
 static dissector_handle_t tcp_handle;
 static dissector_handle_t sport_handle;
 static guint32 tcp_stream_count;
+static wmem_array_t *tcp_stream_frames; /* wmem_array_t * of frame numbers for each stream */
 static guint32 mptcp_stream_count;
 
 
@@ -1011,7 +1012,7 @@ check_follow_fragments(follow_info_t *follow_info, gboolean is_server, guint32 a
                                                               fragment->data->data + new_pos,
                                                               new_frag_size);
 
-                    follow_info->payload = g_list_append(follow_info->payload, follow_record);
+                    follow_info_add_record(follow_info, follow_record);
                 }
 
                 follow_info->seq[is_server] += (fragment->data->len - new_pos);
@@ -1028,11 +1029,14 @@ check_follow_fragments(follow_info_t *follow_info, gboolean is_server, guint32 a
 
         if( EQ_SEQ(fragment->seq, follow_info->seq[is_server]) ) {
             /* this fragment fits the stream */
+            follow_info->seq[is_server] += fragment->data->len;
             if( fragment->data->len > 0 ) {
-                follow_info->payload = g_list_append(follow_info->payload, fragment);
+                follow_info_add_record(follow_info, fragment);
+            } else {
+                g_byte_array_free(fragment->data, TRUE);
+                g_free(fragment);
             }
 
-            follow_info->seq[is_server] += fragment->data->len;
             follow_info->fragments[is_server] = g_list_delete_link(follow_info->fragments[is_server], fragment_entry);
             return TRUE;
         }
@@ -1057,7 +1061,7 @@ check_follow_fragments(follow_info_t *follow_info, gboolean is_server, guint32 a
         follow_record->seq = lowest_seq;
 
         follow_info->seq[is_server] = lowest_seq;
-        follow_info->payload = g_list_append(follow_info->payload, follow_record);
+        follow_info_add_record(follow_info, follow_record);
         return TRUE;
     }
 
@@ -1103,7 +1107,7 @@ follow_tcp_tap_listener(void *tapdata, packet_info *pinfo,
             follow_info->seq[follow_record->is_server]++;
 
         follow_info->bytes_written[follow_record->is_server] += follow_record->data->len;
-        follow_info->payload = g_list_append(follow_info->payload, follow_record);
+        follow_info_add_record(follow_info, follow_record);
         return FALSE;
     }
 
@@ -1150,7 +1154,7 @@ follow_tcp_tap_listener(void *tapdata, packet_info *pinfo,
             follow_info->seq[follow_record->is_server]++;
         if (data_length > 0) {
             follow_info->bytes_written[follow_record->is_server] += follow_record->data->len;
-            follow_info->payload = g_list_append(follow_info->payload, follow_record);
+            follow_info_add_record(follow_info, follow_record);
         }
 
         /* done with the packet, see if it caused a fragment to fit */
@@ -1416,6 +1420,7 @@ static struct tcp_analysis *
 init_tcp_conversation_data(packet_info *pinfo)
 {
     struct tcp_analysis *tcpd;
+    wmem_array_t *frames;
 
     /* Initialize the tcp protocol data structure to add to the tcp conversation */
     tcpd=wmem_new0(wmem_file_scope(), struct tcp_analysis);
@@ -1456,6 +1461,9 @@ init_tcp_conversation_data(packet_info *pinfo)
     tcpd->stream = tcp_stream_count++;
     tcpd->server_port = 0;
 
+    frames = wmem_array_new(wmem_file_scope(), sizeof(guint32));
+    wmem_array_append_one(tcp_stream_frames, frames);
+
     return tcpd;
 }
 
@@ -1582,6 +1590,20 @@ guint32 get_tcp_stream_count(void)
     return tcp_stream_count;
 }
 
+/* Return the frames of a stream seen on the first pass, in frame order */
+const guint32 *get_tcp_stream_frames(guint32 stream, guint32 *count)
+{
+    wmem_array_t *frames;
+
+    if (stream >= wmem_array_get_count(tcp_stream_frames)) {
+        *count = 0;
+        return NULL;
+    }
+    frames = *(wmem_array_t **)wmem_array_index(tcp_stream_frames, stream);
+    *count = wmem_array_get_count(frames);
+    return (const guint32 *)wmem_array_get_raw(frames);
+}
+
 /* Return the mptcp current stream count */
 guint32 get_mptcp_stream_count(void)
 {
@@ -2201,6 +2223,9 @@ finished_checking_retransmission_type:
         ual->frame=pinfo->num;
         ual->seq=seq;
         ual->ts=pinfo->abs_ts;
+        if (LT_SEQ(seq, tcpd->fwd->tcp_analyze_seq_info->acked_floor)) {
+            tcpd->fwd->tcp_analyze_seq_info->acked_floor_valid = FALSE;
+        }
 
         /* next sequence number is seglen bytes away, plus SYN/FIN which counts as one byte */
         if( (flags&(TH_SYN|TH_FIN)) ) {
@@ -2251,10 +2276,22 @@ finished_checking_retransmission_type:
 
 
     /* remove all segments this ACKs and we don't need to keep around any more
+     *
+     * Once an ack has been processed, every segment left in the list starts
+     * at or after it, so a repeated (or older) ack can't match anything and
+     * we don't need to walk the list again.  That keeps runs of dup acks on
+     * a flow with many unacked segments from going quadratic.
      */
     ackcount=0;
     prevual = NULL;
     ual = tcpd->rev->tcp_analyze_seq_info->segments;
+    if (tcpd->rev->tcp_analyze_seq_info->acked_floor_valid &&
+        LE_SEQ(ack, tcpd->rev->tcp_analyze_seq_info->acked_floor)) {
+        ual = NULL;
+    } else {
+        tcpd->rev->tcp_analyze_seq_info->acked_floor = ack;
+        tcpd->rev->tcp_analyze_seq_info->acked_floor_valid = TRUE;
+    }
     while(ual) {
         tcp_unacked_t *tmpual;
 
@@ -5768,6 +5805,7 @@ dissect_tcp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_)
     struct tcp_per_packet_data_t *tcppd=NULL;
     proto_item *item;
     proto_tree *checksum_tree;
+    tvb_view_t  hdr_view;
 
     tcph = wmem_new0(wmem_packet_scope(), struct tcpheader);
     tcph->th_sport = tvb_get_ntohs(tvb, offset);
@@ -5826,12 +5864,14 @@ dissect_tcp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_)
     p_add_proto_data(pinfo->pool, pinfo, hf_tcp_srcport, pinfo->curr_layer_num, GUINT_TO_POINTER(tcph->th_sport));
     p_add_proto_data(pinfo->pool, pinfo, hf_tcp_dstport, pinfo->curr_layer_num, GUINT_TO_POINTER(tcph->th_dport));
 
-    tcph->th_rawseq = tvb_get_ntohl(tvb, offset + 4);
+    /* The rest of the fixed part of the header, checked in one go. */
+    tvb_get_view(tvb, offset + 4, 12, &hdr_view);
+    tcph->th_rawseq = tvb_view_get_ntohl(&hdr_view, 0);
     tcph->th_seq = tcph->th_rawseq;
-    tcph->th_ack = tvb_get_ntohl(tvb, offset + 8);
-    th_off_x2 = tvb_get_guint8(tvb, offset + 12);
-    tcpinfo.flags = tcph->th_flags = tvb_get_ntohs(tvb, offset + 12) & TH_MASK;
-    tcph->th_win = tvb_get_ntohs(tvb, offset + 14);
+    tcph->th_ack = tvb_view_get_ntohl(&hdr_view, 4);
+    th_off_x2 = tvb_view_get_guint8(&hdr_view, 8);
+    tcpinfo.flags = tcph->th_flags = tvb_view_get_ntohs(&hdr_view, 8) & TH_MASK;
+    tcph->th_win = tvb_view_get_ntohs(&hdr_view, 10);
     real_window = tcph->th_win;
     tcph->th_hlen = hi_nibble(th_off_x2) * 4;  /* TCP header length, in bytes */
 
@@ -5917,6 +5957,14 @@ dissect_tcp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_)
          * to tap listeners.
          */
         tcph->th_stream = tcpd->stream;
+
+        if (!PINFO_FD_VISITED(pinfo)) {
+            wmem_array_t *frames = *(wmem_array_t **)wmem_array_index(tcp_stream_frames, tcpd->stream);
+            guint32 nframes = wmem_array_get_count(frames);
+
+            if (nframes == 0 || *(guint32 *)wmem_array_index(frames, nframes - 1) != pinfo->num)
+                wmem_array_append_one(frames, pinfo->num);
+        }
     }
 
     /* Do we need to calculate timestamps relative to the tcp-stream? */
@@ -6525,6 +6573,7 @@ static void
 tcp_init(void)
 {
     tcp_stream_count = 0;
+    tcp_stream_frames = wmem_array_new(wmem_file_scope(), sizeof(wmem_array_t *));
 
     /* MPTCP init */
     mptcp_stream_count = 0;
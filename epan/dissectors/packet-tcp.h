@@ -296,6 +296,8 @@ typedef enum {
 typedef struct tcp_analyze_seq_flow_info_t {
 	tcp_unacked_t *segments;/* List of segments for which we haven't seen an ACK */
 	guint16 segment_count;	/* How many unacked segments we're currently storing */
+	gboolean acked_floor_valid; /* TRUE if no segment in the list starts before acked_floor */
+	guint32 acked_floor;	/* Last ack processed against the list */
     guint32 lastack;	/* Last seen ack for the reverse flow */
 	nstime_t lastacktime;	/* Time of the last ack packet */
 	guint32 lastnondupack;	/* frame number of last seen non dupack */
@@ -501,6 +503,17 @@ extern void add_tcp_process_info(guint32 frame_num, address *local_addr, address
  */
 WS_DLL_PUBLIC guint32 get_tcp_stream_count(void);
 
+/** Get the frames that carry a TCP stream
+ *
+ * Frames are recorded when they are first dissected, so this only covers
+ * frames that have been visited.
+ *
+ * @param stream The TCP stream index
+ * @param count Set to the number of frames
+ * @return The frame numbers in ascending order
+ */
+WS_DLL_PUBLIC const guint32 *get_tcp_stream_frames(guint32 stream, guint32 *count);
+
 /** Get the current number of MPTCP streams
  *
  * @return The number of MPTCP streams
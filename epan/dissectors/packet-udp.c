@@ -170,6 +170,7 @@ static gboolean udplite_check_checksum = FALSE;
 static dissector_table_t udp_dissector_table;
 static heur_dissector_list_t heur_subdissector_list;
 static guint32 udp_stream_count;
+static wmem_array_t *udp_stream_frames; /* wmem_array_t * of frame numbers for each stream */
 
 /* Determine if there is a sub-dissector and call it.  This has been */
 /* separated into a stand alone routine so other protocol dissectors */
@@ -224,6 +225,7 @@ static struct udp_analysis *
 init_udp_conversation_data(void)
 {
   struct udp_analysis *udpd;
+  wmem_array_t *frames;
 
   /* Initialize the udp protocol data structure to add to the udp conversation */
   udpd = wmem_new0(wmem_file_scope(), struct udp_analysis);
@@ -236,6 +238,9 @@ init_udp_conversation_data(void)
 
   udpd->stream = udp_stream_count++;
 
+  frames = wmem_array_new(wmem_file_scope(), sizeof(guint32));
+  wmem_array_append_one(udp_stream_frames, frames);
+
   return udpd;
 }
 
@@ -513,6 +518,20 @@ guint32 get_udp_stream_count(void)
     return udp_stream_count;
 }
 
+/* Return the frames of a stream seen on the first pass, in frame order */
+const guint32 *get_udp_stream_frames(guint32 stream, guint32 *count)
+{
+    wmem_array_t *frames;
+
+    if (stream >= wmem_array_get_count(udp_stream_frames)) {
+        *count = 0;
+        return NULL;
+    }
+    frames = *(wmem_array_t **)wmem_array_index(udp_stream_frames, stream);
+    *count = wmem_array_get_count(frames);
+    return (const guint32 *)wmem_array_get_raw(frames);
+}
+
 static void
 handle_export_pdu_dissection_table(packet_info *pinfo, tvbuff_t *tvb, guint32 port)
 {
@@ -903,10 +922,12 @@ dissect(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, guint32 ip_proto)
   struct udp_analysis *udpd = NULL;
   proto_tree *process_tree;
   gboolean    udp_jumbogram = FALSE;
+  tvb_view_t  ports_view;
 
   udph = wmem_new0(wmem_packet_scope(), e_udphdr);
-  udph->uh_sport = tvb_get_ntohs(tvb, offset);
-  udph->uh_dport = tvb_get_ntohs(tvb, offset + 2);
+  tvb_get_view(tvb, offset, 4, &ports_view);
+  udph->uh_sport = tvb_view_get_ntohs(&ports_view, 0);
+  udph->uh_dport = tvb_view_get_ntohs(&ports_view, 2);
   copy_address_shallow(&udph->ip_src, &pinfo->src);
   copy_address_shallow(&udph->ip_dst, &pinfo->dst);
 
@@ -1098,6 +1119,14 @@ dissect(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, guint32 ip_proto)
     * to tap listeners.
     */
     udph->uh_stream = udpd->stream;
+
+    if (!PINFO_FD_VISITED(pinfo)) {
+      wmem_array_t *frames = *(wmem_array_t **)wmem_array_index(udp_stream_frames, udpd->stream);
+      guint32 nframes = wmem_array_get_count(frames);
+
+      if (nframes == 0 || *(guint32 *)wmem_array_index(frames, nframes - 1) != pinfo->num)
+        wmem_array_append_one(frames, pinfo->num);
+    }
   }
 
   tap_queue_packet(udp_tap, pinfo, udph);
@@ -1158,6 +1187,7 @@ static void
 udp_init(void)
 {
   udp_stream_count = 0;
+  udp_stream_frames = wmem_array_new(wmem_file_scope(), sizeof(wmem_array_t *));
 }
 
 void
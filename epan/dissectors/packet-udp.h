@@ -103,6 +103,17 @@ extern void add_udp_process_info(guint32 frame_num, address *local_addr, address
  */
 WS_DLL_PUBLIC guint32 get_udp_stream_count(void);
 
+/** Get the frames that carry a UDP stream
+ *
+ * Frames are recorded when they are first dissected, so this only covers
+ * frames that have been visited.
+ *
+ * @param stream The UDP stream index
+ * @param count Set to the number of frames
+ * @return The frame numbers in ascending order
+ */
+WS_DLL_PUBLIC const guint32 *get_udp_stream_frames(guint32 stream, guint32 *count);
+
 WS_DLL_PUBLIC void decode_udp_ports(tvbuff_t *, int, packet_info *,
 	proto_tree *, int, int, int);
 
@@ -29,6 +29,7 @@ struct epan_session {
 	void *data;
 
 	const nstime_t *(*get_frame_ts)(void *data, guint32 frame_num);
+	const nstime_t *(*get_frame_shift_offset)(void *data, guint32 frame_num);
 	const char *(*get_interface_name)(void *data, guint32 interface_id);
 	const char *(*get_interface_description)(void *data, guint32 interface_id);
 	const char *(*get_user_comment)(void *data, const frame_data *fd);
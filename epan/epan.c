@@ -22,9 +22,11 @@
 #include "config.h"
 
 #include <stdarg.h>
+#include <stdio.h>
 
 #include <wsutil/wsgcrypt.h>
 #include <wsutil/ws_printf.h> /* ws_g_warning */
+#include <wsutil/ws_trace.h>
 
 #ifdef HAVE_LIBGNUTLS
 #include <gnutls/gnutls.h>
@@ -64,6 +66,7 @@
 #include "dissector_filters.h"
 #include "conversation_table.h"
 #include "reassemble.h"
+#include "app_mem_usage.h"
 #include "srt_table.h"
 #include "stats_tree.h"
 #include <dtd.h>
@@ -134,6 +137,158 @@ quiet_gcrypt_logger (void *dummy _U_, int level, const char *format, va_list arg
 }
 #endif // _WIN32
 
+/*
+ * Startup profiling, enabled by setting WIRESHARK_STARTUP_PROFILE in the
+ * environment. Records how long each phase of epan_init() took and, using
+ * the registration callback, how long each protocol's register and handoff
+ * routines took, and prints a summary to stderr.
+ */
+#define STARTUP_PROFILE_TOP_ROUTINES 25
+
+typedef struct {
+	const char *action;	/* NULL for phases */
+	gchar      *name;
+	gdouble     secs;
+} startup_profile_entry_t;
+
+static GTimer      *startup_timer = NULL;
+static gdouble      startup_phase_start;
+static gdouble      startup_routine_start;
+static const char  *startup_routine_action;
+static gchar       *startup_routine_name = NULL;
+static GArray      *startup_phases;
+static GArray      *startup_routines;
+static register_cb  startup_client_cb;
+
+static void
+startup_profile_end_routine(void)
+{
+	startup_profile_entry_t entry;
+
+	if (startup_routine_name == NULL)
+		return;
+
+	entry.action = startup_routine_action;
+	entry.name = startup_routine_name;
+	entry.secs = g_timer_elapsed(startup_timer, NULL) - startup_routine_start;
+	g_array_append_val(startup_routines, entry);
+	startup_routine_name = NULL;
+}
+
+static void
+startup_profile_cb(register_action_e action, const char *message, gpointer client_data)
+{
+	const char *action_name;
+
+	startup_profile_end_routine();
+
+	/* Don't charge the caller's callback (e.g. a splash screen) to anyone. */
+	if (startup_client_cb)
+		startup_client_cb(action, message, client_data);
+
+	switch (action) {
+	case RA_REGISTER:
+		action_name = "register";
+		break;
+	case RA_PLUGIN_REGISTER:
+		action_name = "plugin register";
+		break;
+	case RA_HANDOFF:
+		action_name = "handoff";
+		break;
+	case RA_PLUGIN_HANDOFF:
+		action_name = "plugin handoff";
+		break;
+	case RA_LUA_PLUGINS:
+		action_name = "lua";
+		break;
+	default:
+		return;
+	}
+
+	startup_routine_action = action_name;
+	startup_routine_name = g_strdup(message ? message : "(all plugins)");
+	startup_routine_start = g_timer_elapsed(startup_timer, NULL);
+}
+
+static register_cb
+startup_profile_init(register_cb cb)
+{
+	startup_client_cb = cb;
+	startup_phases = g_array_new(FALSE, FALSE, sizeof(startup_profile_entry_t));
+	startup_routines = g_array_new(FALSE, FALSE, sizeof(startup_profile_entry_t));
+	startup_timer = g_timer_new();
+	startup_phase_start = 0.0;
+	return startup_profile_cb;
+}
+
+/* Close the current phase, charging the time since the previous one to it. */
+static void
+startup_profile_phase(const char *name)
+{
+	startup_profile_entry_t entry;
+	gdouble now;
+
+	if (startup_timer == NULL)
+		return;
+
+	startup_profile_end_routine();
+
+	now = g_timer_elapsed(startup_timer, NULL);
+	entry.action = NULL;
+	entry.name = g_strdup(name);
+	entry.secs = now - startup_phase_start;
+	g_array_append_val(startup_phases, entry);
+	startup_phase_start = now;
+}
+
+static gint
+startup_profile_compare(gconstpointer a, gconstpointer b)
+{
+	const startup_profile_entry_t *ea = (const startup_profile_entry_t *)a;
+	const startup_profile_entry_t *eb = (const startup_profile_entry_t *)b;
+
+	if (ea->secs > eb->secs)
+		return -1;
+	return ea->secs < eb->secs ? 1 : 0;
+}
+
+static void
+startup_profile_report(void)
+{
+	startup_profile_entry_t *entry;
+	gdouble total;
+	guint i;
+
+	if (startup_timer == NULL)
+		return;
+
+	total = g_timer_elapsed(startup_timer, NULL);
+	fprintf(stderr, "epan_init() startup profile\n");
+	fprintf(stderr, "%10s  %s\n", "ms", "phase");
+	for (i = 0; i < startup_phases->len; i++) {
+		entry = &g_array_index(startup_phases, startup_profile_entry_t, i);
+		fprintf(stderr, "%10.2f  %s\n", entry->secs * 1000.0, entry->name);
+		g_free(entry->name);
+	}
+	fprintf(stderr, "%10.2f  total\n", total * 1000.0);
+
+	g_array_sort(startup_routines, startup_profile_compare);
+	fprintf(stderr, "\nSlowest of %u registration routines\n", startup_routines->len);
+	fprintf(stderr, "%10s  %-16s %s\n", "ms", "action", "name");
+	for (i = 0; i < startup_routines->len; i++) {
+		entry = &g_array_index(startup_routines, startup_profile_entry_t, i);
+		if (i < STARTUP_PROFILE_TOP_ROUTINES)
+			fprintf(stderr, "%10.2f  %-16s %s\n", entry->secs * 1000.0, entry->action, entry->name);
+		g_free(entry->name);
+	}
+
+	g_array_free(startup_phases, TRUE);
+	g_array_free(startup_routines, TRUE);
+	g_timer_destroy(startup_timer);
+	startup_timer = NULL;
+}
+
 /*
  * Register all the plugin types that are part of libwireshark, namely
  * dissector and tap plugins.
@@ -158,14 +313,21 @@ epan_init(void (*register_all_protocols_func)(register_cb cb, gpointer client_da
 {
 	volatile gboolean status = TRUE;
 
+	if (getenv("WIRESHARK_STARTUP_PROFILE") != NULL)
+		cb = startup_profile_init(cb);
+
 	/* initialize memory allocation subsystem */
 	wmem_init();
+	memory_usage_allocator_register("Packet scope", wmem_packet_scope());
+	memory_usage_allocator_register("File scope", wmem_file_scope());
+	memory_usage_allocator_register("Epan scope", wmem_epan_scope());
 
 	/* initialize the GUID to name mapping table */
 	guids_init();
 
 	/* initialize name resolution (addr_resolv.c) */
 	addr_resolv_init();
+	startup_profile_phase("wmem, GUIDs and name resolution");
 
 	except_init();
 	/* initialize libgcrypt (beware, it won't be thread-safe) */
@@ -183,6 +345,7 @@ epan_init(void (*register_all_protocols_func)(register_cb cb, gpointer client_da
 	xmlInitParser();
 	LIBXML_TEST_VERSION;
 #endif
+	startup_profile_phase("libraries");
 	TRY {
 		tap_init();
 		prefs_init();
@@ -191,16 +354,20 @@ epan_init(void (*register_all_protocols_func)(register_cb cb, gpointer client_da
 		conversation_init();
 		capture_dissector_init();
 		reassembly_tables_init();
+		startup_profile_phase("core subsystems");
 		proto_init(register_all_protocols_func, register_all_handoffs_func,
 		    cb, client_data);
+		startup_profile_phase("protocol registration and handoffs");
 		packet_cache_proto_handles();
 		dfilter_init();
 		final_registration_all_protocols();
 		print_cache_field_handles();
 		expert_packet_init();
 		export_pdu_init();
+		startup_profile_phase("final registration");
 #ifdef HAVE_LUA
 		wslua_init(cb, client_data);
+		startup_profile_phase("Lua");
 #endif
 	}
 	CATCH(DissectorError) {
@@ -222,6 +389,7 @@ epan_init(void (*register_all_protocols_func)(register_cb cb, gpointer client_da
 		status = FALSE;
 	}
 	ENDTRY;
+	startup_profile_report();
 	return status;
 }
 
@@ -281,6 +449,9 @@ epan_cleanup(void)
 		pinfo_pool_cache = NULL;
 	}
 
+	memory_usage_allocator_unregister(wmem_packet_scope());
+	memory_usage_allocator_unregister(wmem_file_scope());
+	memory_usage_allocator_unregister(wmem_epan_scope());
 	wmem_cleanup();
 }
 
@@ -336,6 +507,18 @@ epan_get_frame_ts(const epan_t *session, guint32 frame_num)
 	return abs_ts;
 }
 
+const nstime_t *
+epan_get_frame_shift_offset(const epan_t *session, guint32 frame_num)
+{
+	static const nstime_t no_shift = { 0, 0 };
+	const nstime_t *shift_offset = NULL;
+
+	if (session->get_frame_shift_offset)
+		shift_offset = session->get_frame_shift_offset(session->data, frame_num);
+
+	return shift_offset ? shift_offset : &no_shift;
+}
+
 void
 epan_free(epan_t *session)
 {
@@ -405,6 +588,7 @@ epan_dissect_init(epan_dissect_t *edt, epan_t *session, const gboolean create_pr
 	}
 
 	edt->tvb = NULL;
+	edt->metadata_only = FALSE;
 }
 
 void
@@ -416,7 +600,8 @@ epan_dissect_reset(epan_dissect_t *edt)
 	g_assert(edt);
 
 	g_slist_free(edt->pi.proto_data);
-	g_slist_free(edt->pi.dependent_frames);
+	if (edt->pi.dependent_frames)
+		g_array_free(edt->pi.dependent_frames, TRUE);
 
 	/* Free the data sources list. */
 	free_data_sources(&edt->pi);
@@ -455,6 +640,20 @@ epan_dissect_fake_protocols(epan_dissect_t *edt, const gboolean fake_protocols)
 		proto_tree_set_fake_protocols(edt->tree, fake_protocols);
 }
 
+void
+epan_dissect_set_field_demand(epan_dissect_t *edt, const gboolean field_demand)
+{
+	if (edt && edt->tree)
+		proto_tree_set_field_demand(edt->tree, field_demand);
+}
+
+void
+epan_dissect_set_metadata_only(epan_dissect_t *edt, const gboolean metadata_only)
+{
+	if (edt)
+		edt->metadata_only = metadata_only;
+}
+
 void
 epan_dissect_run(epan_dissect_t *edt, int file_type_subtype,
 	struct wtap_pkthdr *phdr, tvbuff_t *tvb, frame_data *fd,
@@ -464,7 +663,9 @@ epan_dissect_run(epan_dissect_t *edt, int file_type_subtype,
 	wslua_prime_dfilter(edt); /* done before entering wmem scope */
 #endif
 	wmem_enter_packet_scope();
+	WS_TRACE1(dissect_entry, fd->num);
 	dissect_record(edt, file_type_subtype, phdr, tvb, fd, cinfo);
+	WS_TRACE1(dissect_return, fd->num);
 
 	/* free all memory allocated */
 	wmem_leave_packet_scope();
@@ -477,7 +678,9 @@ epan_dissect_run_with_taps(epan_dissect_t *edt, int file_type_subtype,
 {
 	wmem_enter_packet_scope();
 	tap_queue_init(edt);
+	WS_TRACE1(dissect_entry, fd->num);
 	dissect_record(edt, file_type_subtype, phdr, tvb, fd, cinfo);
+	WS_TRACE1(dissect_return, fd->num);
 	tap_push_tapped_queue(edt);
 
 	/* free all memory allocated */
@@ -492,7 +695,9 @@ epan_dissect_file_run(epan_dissect_t *edt, struct wtap_pkthdr *phdr,
 	wslua_prime_dfilter(edt); /* done before entering wmem scope */
 #endif
 	wmem_enter_packet_scope();
+	WS_TRACE1(dissect_entry, fd->num);
 	dissect_file(edt, phdr, tvb, fd, cinfo);
+	WS_TRACE1(dissect_return, fd->num);
 
 	/* free all memory allocated */
 	wmem_leave_packet_scope();
@@ -504,7 +709,9 @@ epan_dissect_file_run_with_taps(epan_dissect_t *edt, struct wtap_pkthdr *phdr,
 {
 	wmem_enter_packet_scope();
 	tap_queue_init(edt);
+	WS_TRACE1(dissect_entry, fd->num);
 	dissect_file(edt, phdr, tvb, fd, cinfo);
+	WS_TRACE1(dissect_return, fd->num);
 	tap_push_tapped_queue(edt);
 
 	/* free all memory allocated */
@@ -517,7 +724,8 @@ epan_dissect_cleanup(epan_dissect_t* edt)
 	g_assert(edt);
 
 	g_slist_free(edt->pi.proto_data);
-	g_slist_free(edt->pi.dependent_frames);
+	if (edt->pi.dependent_frames)
+		g_array_free(edt->pi.dependent_frames, TRUE);
 
 	/* Free the data sources list. */
 	free_data_sources(&edt->pi);
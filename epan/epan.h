@@ -153,6 +153,9 @@ WS_DLL_PUBLIC const char *epan_get_interface_description(const epan_t *session,
 
 const nstime_t *epan_get_frame_ts(const epan_t *session, guint32 frame_num);
 
+/** How much the time stamp of a frame has been shifted (zero if it hasn't). */
+const nstime_t *epan_get_frame_shift_offset(const epan_t *session, guint32 frame_num);
+
 WS_DLL_PUBLIC void epan_free(epan_t *session);
 
 WS_DLL_PUBLIC const gchar*
@@ -193,6 +196,21 @@ WS_DLL_PUBLIC
 void
 epan_dissect_fake_protocols(epan_dissect_t *edt, const gboolean fake_protocols);
 
+/** Indicate whether only the fields the epan_dissect_t has been primed
+ *  with are wanted; see proto_tree_set_field_demand(). */
+WS_DLL_PUBLIC
+void
+epan_dissect_set_field_demand(epan_dissect_t *edt, const gboolean field_demand);
+
+/** Indicate whether only the frame metadata should be dissected, i.e.
+ *  the frame dissector stops before handing the data to any
+ *  sub-dissector.  Only useful on frames that have already been visited
+ *  and for filters that only reference frame metadata fields; see
+ *  frame_dfilter_is_metadata_only(). */
+WS_DLL_PUBLIC
+void
+epan_dissect_set_metadata_only(epan_dissect_t *edt, const gboolean metadata_only);
+
 /** run a single packet dissection */
 WS_DLL_PUBLIC
 void
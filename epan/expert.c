@@ -67,6 +67,11 @@ typedef struct _gpa_expertinfo_t {
 } gpa_expertinfo_t;
 static gpa_expertinfo_t gpa_expertinfo;
 
+/* Expert infos seen on the first pass, if asked for before the file was opened */
+static gboolean expert_index_wanted = FALSE;
+static GArray *expert_index = NULL;
+static GStringChunk *expert_index_strings = NULL;
+
 /* Hash table of abbreviations and IDs */
 static GHashTable *gpa_name_map = NULL;
 
@@ -259,6 +264,12 @@ expert_packet_init(void)
 	highest_severity = 0;
 
 	proto_malformed = proto_get_id_by_filter_name("_ws.malformed");
+
+	expert_packet_cleanup();
+	if (expert_index_wanted) {
+		expert_index = g_array_new(FALSE, FALSE, sizeof(expert_info_t));
+		expert_index_strings = g_string_chunk_new(4096);
+	}
 }
 
 void
@@ -275,6 +286,14 @@ expert_init(void)
 void
 expert_packet_cleanup(void)
 {
+	if (expert_index) {
+		g_array_free(expert_index, TRUE);
+		expert_index = NULL;
+	}
+	if (expert_index_strings) {
+		g_string_chunk_free(expert_index_strings);
+		expert_index_strings = NULL;
+	}
 }
 
 void
@@ -312,6 +331,39 @@ expert_get_highest_severity(void)
 	return highest_severity;
 }
 
+void
+expert_set_index_enabled(gboolean enabled)
+{
+	expert_index_wanted = enabled;
+}
+
+const expert_info_t *
+expert_get_index(guint *count)
+{
+	if (!expert_index) {
+		*count = 0;
+		return NULL;
+	}
+	*count = expert_index->len;
+	return (const expert_info_t *)(void *)expert_index->data;
+}
+
+/* Remember an expert info in the index; this doesn't need a tree */
+static void
+expert_index_add(packet_info *pinfo, int group, int severity, int hf_index, const char *summary)
+{
+	expert_info_t ei;
+
+	ei.packet_num = pinfo->num;
+	ei.group      = group;
+	ei.severity   = severity;
+	ei.hf_index   = hf_index;
+	ei.protocol   = pinfo->current_proto ? g_string_chunk_insert_const(expert_index_strings, pinfo->current_proto) : NULL;
+	ei.summary    = g_string_chunk_insert_const(expert_index_strings, summary);
+	ei.pitem      = NULL;
+	g_array_append_val(expert_index, ei);
+}
+
 void
 expert_update_comment_count(guint64 count)
 {
@@ -565,6 +617,9 @@ expert_set_info_vformat(packet_info *pinfo, proto_item *pi, int group, int sever
 					      "%s", val_to_str_const(group, expert_group_vals, "Unknown"));
 	PROTO_ITEM_SET_GENERATED(ti);
 
+	if (expert_index && !PINFO_FD_VISITED(pinfo))
+		expert_index_add(pinfo, group, severity, hf_index, formatted);
+
 	tap = have_tap_listener(expert_tap);
 
 	if (!tap)
@@ -107,6 +107,22 @@ expert_get_highest_severity(void);
 WS_DLL_PUBLIC void
 expert_update_comment_count(guint64 count);
 
+/** Keep an index of the expert infos added while frames are first
+ dissected, with or without a protocol tree. This takes effect when the
+ next file is opened or the packets are redissected.
+ @param enabled TRUE to keep the index
+ */
+WS_DLL_PUBLIC void
+expert_set_index_enabled(gboolean enabled);
+
+/** Get the expert infos of the frames dissected so far, in the order they
+ were added. pitem is always NULL.
+ @param count Set to the number of expert infos
+ @return The expert infos, or NULL if the index isn't being kept
+ */
+WS_DLL_PUBLIC const expert_info_t *
+expert_get_index(guint *count);
+
 /** Add an expert info.
  Add an expert info tree to a protocol item using registered expert info item
  @param pinfo Packet info of the currently processed packet. May be NULL if
@@ -100,6 +100,22 @@ WS_DLL_PUBLIC tap_packet_cb get_eo_packet_func(register_eo_t* eo);
  */
 WS_DLL_PUBLIC export_object_gui_reset_cb get_eo_reset_func(register_eo_t* eo);
 
+/** Mark the Export Object of a protocol as changing its entries after they
+ * have been added, e.g. files whose data arrives in chunks that are fetched
+ * with get_entry. Entries of other protocols are complete when they are
+ * added, so front ends may save and free them right away.
+ *
+ * @param proto_id is the protocol with objects to export
+ */
+WS_DLL_PUBLIC void set_eo_updates_entries(const int proto_id);
+
+/** Get whether an Export Object changes its entries after adding them
+ *
+ * @param eo Registered Export Object
+ * @return TRUE if entries can change after they have been added
+ */
+WS_DLL_PUBLIC gboolean get_eo_updates_entries(register_eo_t* eo);
+
 /** Get Export Object by its short protocol name
  *
  * @param name short protocol name to fetch.
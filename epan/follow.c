@@ -31,6 +31,7 @@
 #include <epan/packet.h>
 #include "follow.h"
 #include <epan/tap.h>
+#include <wsutil/file_util.h>
 
 struct register_follow {
     int proto_id;              /* protocol id (0-indexed) */
@@ -148,6 +149,51 @@ follow_reset_stream(follow_info_t* info)
     info->seq[0] = info->seq[1] = 0;
 }
 
+void
+follow_info_add_record(follow_info_t* follow_info, follow_record_t* follow_record)
+{
+    follow_record->spill_offset = 0;
+    follow_record->spill_len = 0;
+
+    if (follow_info->spill && follow_record->data && follow_record->data->len > 0 &&
+        ws_lseek64(follow_info->spill_fd, follow_info->spill_size, SEEK_SET) == follow_info->spill_size &&
+        ws_write(follow_info->spill_fd, follow_record->data->data, follow_record->data->len) == (int)follow_record->data->len) {
+        follow_record->spill_offset = follow_info->spill_size;
+        follow_record->spill_len = follow_record->data->len;
+        follow_info->spill_size += follow_record->data->len;
+        g_byte_array_free(follow_record->data, TRUE);
+        follow_record->data = NULL;
+    }
+
+    /* Appending to the last element doesn't walk the whole list. */
+    if (follow_info->payload == NULL) {
+        follow_info->payload = follow_info->payload_last = g_list_append(NULL, follow_record);
+    } else {
+        follow_info->payload_last = g_list_last(g_list_append(follow_info->payload_last, follow_record));
+    }
+}
+
+const guint8*
+follow_record_get_data(follow_info_t* follow_info, follow_record_t* follow_record, GByteArray* buf, guint32* len)
+{
+    if (follow_record->data) {
+        *len = follow_record->data->len;
+        return follow_record->data->data;
+    }
+
+    *len = 0;
+    if (follow_record->spill_len == 0)
+        return (const guint8 *)"";
+
+    g_byte_array_set_size(buf, follow_record->spill_len);
+    if (ws_lseek64(follow_info->spill_fd, follow_record->spill_offset, SEEK_SET) != follow_record->spill_offset ||
+        ws_read(follow_info->spill_fd, buf->data, follow_record->spill_len) != (int)follow_record->spill_len)
+        return NULL;
+
+    *len = follow_record->spill_len;
+    return buf->data;
+}
+
 void
 follow_info_free(follow_info_t* follow_info)
 {
@@ -218,7 +264,7 @@ follow_tvb_tap_listener(void *tapdata, packet_info *pinfo,
     /* update stream counter */
     follow_info->bytes_written[follow_record->is_server] += follow_record->data->len;
 
-    follow_info->payload = g_list_append(follow_info->payload, follow_record);
+    follow_info_add_record(follow_info, follow_record);
     return FALSE;
 }
 
@@ -90,7 +90,9 @@ typedef struct {
     gboolean is_server;
     guint32 packet_num;
     guint32 seq; /* TCP only */
-    GByteArray *data;
+    GByteArray *data; /* NULL once written to the spill file */
+    gint64 spill_offset; /* Where the data is in the spill file */
+    guint32 spill_len; /* Length of the data in the spill file */
 } follow_record_t;
 
 typedef struct _follow_info {
@@ -105,6 +107,10 @@ typedef struct _follow_info {
     address         client_ip;
     address         server_ip;
     void*           gui_data;
+    GList           *payload_last;  /* Last element of payload */
+    gboolean        spill;          /* Write payload data to spill_fd instead of keeping it */
+    int             spill_fd;
+    gint64          spill_size;
 } follow_info_t;
 
 struct register_follow;
@@ -205,6 +211,28 @@ WS_DLL_PUBLIC gchar* follow_get_stat_tap_string(register_follow_t* follower);
  */
 WS_DLL_PUBLIC void follow_reset_stream(follow_info_t* info);
 
+/** Append a record to the payload of follow_info_t
+ * If follow_info->spill is set, the record's data is written to the spill
+ * file and freed; it is kept in memory if that fails. Followers should use
+ * this rather than appending to payload themselves.
+ *
+ * @param follow_info [in] follower info
+ * @param follow_record [in] record to append, now owned by follow_info
+ */
+WS_DLL_PUBLIC void follow_info_add_record(follow_info_t* follow_info, follow_record_t* follow_record);
+
+/** Get the data of a payload record
+ * Data that was written to the spill file is read back into buf.
+ *
+ * @param follow_info [in] follower info
+ * @param follow_record [in] payload record
+ * @param buf [in,out] storage for data read back from the spill file
+ * @param len [out] length of the data
+ * @return The data, or NULL if it couldn't be read back
+ */
+WS_DLL_PUBLIC const guint8* follow_record_get_data(follow_info_t* follow_info, follow_record_t* follow_record,
+                                                   GByteArray* buf, guint32* len);
+
 /** Free follow_info_t structure
  * Free everything except the GUI element
  *
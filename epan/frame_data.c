@@ -190,8 +190,6 @@ frame_data_init(frame_data *fdata, guint32 num,
   fdata->tsprec = (gint16)phdr->pkt_tsprec;
   fdata->color_filter = NULL;
   fdata->abs_ts = phdr->ts;
-  fdata->shift_offset.secs = 0;
-  fdata->shift_offset.nsecs = 0;
   fdata->frame_ref_num = 0;
   fdata->prev_dis_num = 0;
 }
@@ -87,8 +87,7 @@ typedef struct _frame_data {
 
   const struct _color_filter *color_filter;  /**< Per-packet matching color_filter_t object */
 
-  nstime_t     abs_ts;       /**< Absolute timestamp */
-  nstime_t     shift_offset; /**< How much the abs_tm of the frame is shifted */
+  nstime_t     abs_ts;       /**< Absolute timestamp; see frame_data_sequence_shift_offset() for time shifts */
   guint32      frame_ref_num; /**< Previous reference frame (0 if this is one) */
   guint32      prev_dis_num; /**< Previous displayed frame (0 if first one) */
 } frame_data;
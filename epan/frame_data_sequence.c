@@ -44,6 +44,7 @@
 struct _frame_data_sequence {
   guint32      count;           /* Total number of frames */
   void        *ptree_root;      /* Pointer to the root node */
+  GArray      *shift_offsets;   /* nstime_t per frame, NULL if none is shifted */
 };
 
 /*
@@ -67,6 +68,7 @@ new_frame_data_sequence(void)
   fds = (frame_data_sequence *)g_malloc(sizeof *fds);
   fds->count = 0;
   fds->ptree_root = NULL;
+  fds->shift_offsets = NULL;
   return fds;
 }
 
@@ -319,20 +321,69 @@ free_frame_data_sequence(frame_data_sequence *fds)
     free_frame_data_array(fds->ptree_root, fds->count, levels, TRUE);
   }
 
+  if (fds->shift_offsets != NULL) {
+    g_array_free(fds->shift_offsets, TRUE);
+  }
+
   /* free the header struct */
   g_free(fds);
 }
 
+const nstime_t *
+frame_data_sequence_get_shift_offset(frame_data_sequence *fds, guint32 num)
+{
+  static const nstime_t no_shift = { 0, 0 };
+
+  if (num == 0 || fds->shift_offsets == NULL ||
+      num > fds->shift_offsets->len) {
+    return &no_shift;
+  }
+  return &g_array_index(fds->shift_offsets, nstime_t, num - 1);
+}
+
+nstime_t *
+frame_data_sequence_shift_offset(frame_data_sequence *fds, guint32 num)
+{
+  g_assert(num != 0 && num <= fds->count);
+
+  if (fds->shift_offsets == NULL) {
+    fds->shift_offsets = g_array_sized_new(FALSE, TRUE, sizeof (nstime_t), fds->count);
+  }
+  if (num > fds->shift_offsets->len) {
+    /* Zero-filled, as the array was created with clear_ set. */
+    g_array_set_size(fds->shift_offsets, fds->count);
+  }
+  return &g_array_index(fds->shift_offsets, nstime_t, num - 1);
+}
+
 void
-find_and_mark_frame_depended_upon(gpointer data, gpointer user_data)
+frame_data_sequence_mark_depended_upon(frame_data_sequence *fds, const GArray *dependent_frames)
 {
-  frame_data   *dependent_fd;
-  guint32       dependent_frame = GPOINTER_TO_UINT(data);
-  frame_data_sequence *frames   = (frame_data_sequence *)user_data;
+  const frame_range_t *range;
+  frame_data *fdata;
+  guint32     num, last;
+  guint       i;
+
+  if (fds == NULL || dependent_frames == NULL) {
+    return;
+  }
 
-  if (dependent_frame && frames) {
-    dependent_fd = frame_data_sequence_find(frames, dependent_frame);
-    dependent_fd->flags.dependent_of_displayed = 1;
+  for (i = 0; i < dependent_frames->len; i++) {
+    range = &g_array_index(dependent_frames, frame_range_t, i);
+    last = MIN(range->last, fds->count);
+    fdata = NULL;
+    for (num = range->first; num != 0 && num <= last; num++) {
+      /*
+       * The frames of a leaf node are consecutive, so only go
+       * down the tree again when we cross into the next one.
+       */
+      if (fdata == NULL || LEAF_INDEX(num - 1) == 0) {
+        fdata = frame_data_sequence_find(fds, num);
+      } else {
+        fdata++;
+      }
+      fdata->flags.dependent_of_displayed = 1;
+    }
   }
 }
 
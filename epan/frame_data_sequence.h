@@ -45,7 +45,27 @@ WS_DLL_PUBLIC frame_data *frame_data_sequence_find(frame_data_sequence *fds,
  */
 WS_DLL_PUBLIC void free_frame_data_sequence(frame_data_sequence *fds);
 
-WS_DLL_PUBLIC void find_and_mark_frame_depended_upon(gpointer data, gpointer user_data);
+/*
+ * How much the time stamp of the specified frame has been shifted by a
+ * time shift.  Shift offsets are rarely used, so they're kept apart from
+ * the frame_data structures, and only allocated once a frame is shifted.
+ */
+WS_DLL_PUBLIC const nstime_t *frame_data_sequence_get_shift_offset(frame_data_sequence *fds,
+    guint32 num);
+
+/*
+ * As frame_data_sequence_get_shift_offset(), but returns a pointer that
+ * can be used to change the shift offset, allocating it if necessary.
+ */
+WS_DLL_PUBLIC nstime_t *frame_data_sequence_shift_offset(frame_data_sequence *fds,
+    guint32 num);
+
+/*
+ * Set dependent_of_displayed in the frames of dependent_frames, a
+ * packet_info's array of frame_range_t.
+ */
+WS_DLL_PUBLIC void frame_data_sequence_mark_depended_upon(frame_data_sequence *fds,
+    const GArray *dependent_frames);
 
 
 #ifdef __cplusplus
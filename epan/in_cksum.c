@@ -35,6 +35,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <glib.h>
 
 #include <epan/tvbuff.h>
@@ -57,6 +59,7 @@ in_cksum(const vec_t *vec, int veclen)
 	register int sum = 0;
 	register int mlen = 0;
 	int byte_swapped = 0;
+	guint64 acc, v;
 
 	union {
 		guint8	c[2];
@@ -98,17 +101,25 @@ in_cksum(const vec_t *vec, int veclen)
 			byte_swapped = 1;
 		}
 		/*
-		 * Unroll the loop to make overhead from
-		 * branches &c small.
+		 * Sum the bulk of the chunk 64 bits at a time, as two
+		 * 32-bit halves into a 64-bit accumulator, which can't
+		 * overflow; as 2^16 == 1 in one's complement arithmetic,
+		 * folding that back to 16 bits gives the same result as
+		 * adding up the 16-bit words, whatever the byte order.
+		 * The loads may be unaligned, hence the memcpy().
 		 */
-		while ((mlen -= 32) >= 0) {
-			sum += w[0]; sum += w[1]; sum += w[2]; sum += w[3];
-			sum += w[4]; sum += w[5]; sum += w[6]; sum += w[7];
-			sum += w[8]; sum += w[9]; sum += w[10]; sum += w[11];
-			sum += w[12]; sum += w[13]; sum += w[14]; sum += w[15];
-			w += 16;
+		if (mlen >= 32) {
+			acc = 0;
+			while ((mlen -= 8) >= 0) {
+				memcpy(&v, w, sizeof v);
+				acc += (v & 0xffffffff) + (v >> 32);
+				w += 4;
+			}
+			mlen += 8;
+			while (acc >> 16)
+				acc = (acc & 0xffff) + (acc >> 16);
+			sum += (int)acc;
 		}
-		mlen += 32;
 		while ((mlen -= 8) >= 0) {
 			sum += w[0]; sum += w[1]; sum += w[2]; sum += w[3];
 			w += 4;
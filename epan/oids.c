@@ -294,6 +294,9 @@ static char* alnumerize(const char* name) {
 	return s;
 }
 
+/* SmiType* -> const oid_value_type_t*, while register_mibs() runs */
+static GHashTable* typedata_cache = NULL;
+
 static const oid_value_type_t* get_typedata(SmiType* smiType) {
 	/*
 	 * There has to be a better way to know if a given
@@ -338,30 +341,48 @@ static const oid_value_type_t* get_typedata(SmiType* smiType) {
 		{NULL,SMI_BASETYPE_UNKNOWN,NULL} /* SMI_BASETYPE_UNKNOWN = 0 */
 	};
 	const struct _type_mapping_t* t;
+	const oid_value_type_t* found = NULL;
 	SmiType* sT = smiType;
+	char* name;
 
 	if (!smiType) return NULL;
 
+	/*
+	 * Most nodes of a MIB share a handful of types, so remember what
+	 * we found for each; the table lives as long as register_mibs().
+	 */
+	if (typedata_cache && (found = (const oid_value_type_t*)g_hash_table_lookup(typedata_cache, smiType)))
+		return found;
+
 	do {
-		for (t = types; t->type ; t++ ) {
-			char* name = smiRenderType(sT, SMI_RENDER_NAME);
-			if (name && t->name && g_str_equal(name, t->name )) {
-				smi_free(name);
-				return t->type;
-			}
-			if (name) {
-				smi_free (name);
+		/* Render the name once per level, not once per table entry */
+		name = smiRenderType(sT, SMI_RENDER_NAME);
+		if (name) {
+			for (t = types; t->type ; t++ ) {
+				if (t->name && g_str_equal(name, t->name )) {
+					found = t->type;
+					break;
+				}
 			}
+			smi_free (name);
 		}
-	} while(( sT  = smiGetParentType(sT) ));
+	} while(!found && ( sT  = smiGetParentType(sT) ));
 
-	for (t = types; t->type ; t++ ) {
-		if(smiType->basetype == t->base) {
-			return t->type;
+	if (!found) {
+		for (t = types; t->type ; t++ ) {
+			if(smiType->basetype == t->base) {
+				found = t->type;
+				break;
+			}
 		}
 	}
 
-	return &unknown_type;
+	if (!found)
+		found = &unknown_type;
+
+	if (typedata_cache)
+		g_hash_table_insert(typedata_cache, smiType, (gpointer)found);
+	return found;
 }
 
 static guint get_non_implicit_size(SmiType* sT) {
@@ -590,6 +611,8 @@ static void register_mibs(void) {
 	g_free(path_str);
 	g_string_free(smi_errors,TRUE);
 
+	typedata_cache = g_hash_table_new(g_direct_hash, g_direct_equal);
+
 	for (smiModule = smiGetFirstModule();
 		 smiModule;
 		 smiModule = smiGetNextModule(smiModule)) {
@@ -628,10 +651,12 @@ static void register_mibs(void) {
 						       smiNode->oid);
 			smi_free (oid);
 
-			sub = oid_subid2string(NULL, smiNode->oid, smiNode->oidlen);
-			D(4,("\t\tNode: kind=%d oid=%s name=%s ",
-				 oid_data->kind, sub, oid_data->name));
-			wmem_free(NULL, sub);
+			if (debuglevel >= 4) {
+				sub = oid_subid2string(NULL, smiNode->oid, smiNode->oidlen);
+				D(4,("\t\tNode: kind=%d oid=%s name=%s ",
+					 oid_data->kind, sub, oid_data->name));
+				wmem_free(NULL, sub);
+			}
 
 			if ( typedata && oid_data->value_hfid == -2 ) {
 				SmiNamedNumber* smiEnum;
@@ -737,6 +762,9 @@ static void register_mibs(void) {
 		}
 	}
 
+	g_hash_table_destroy(typedata_cache);
+	typedata_cache = NULL;
+
 	proto_mibs = proto_register_protocol("MIBs", "MIBS", "mibs");
 
 	proto_register_field_array(proto_mibs, (hf_register_info*)wmem_array_get_raw(hfa), wmem_array_get_count(hfa));
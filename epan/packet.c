@@ -42,6 +42,7 @@
 #include "epan_dissect.h"
 
 #include "wmem/wmem.h"
+#include "conversation.h"
 
 #include <epan/exceptions.h>
 #include <epan/reassemble.h>
@@ -51,6 +52,7 @@
 #include <epan/range.h>
 #include <epan/asm_utils.h>
 
+#include <wsutil/glib-compat.h>
 #include <wsutil/str_util.h>
 #include <wsutil/ws_printf.h> /* ws_debug_printf */
 
@@ -102,10 +104,23 @@ struct dissector_table {
 	protocol_t	*protocol;
 	GHashFunc	hash_func;
 	gboolean	supports_decode_as;
+	struct dtbl_flat *flat;		/* direct-indexed small keys of a uint table, NULL if not built */
+	guint64		lookups;	/* uint lookups done while dissecting */
+	guint64		hits;		/* ... and how many of them found a dissector */
+	GHashTable	*seen;		/* pattern -> handle found, for dissector_set_lookup_tracking() */
 };
 
 static GHashTable *dissector_tables = NULL;
 
+/*
+ * Lookups in the tables that allow "Decode As" are remembered, so that
+ * dissector_table_lookups_changed() can tell whether a change to the
+ * tables could change the dissection of the frames.
+ */
+static gboolean track_lookups = FALSE;
+/* TRUE if they have been since dissection was last initialized */
+static gboolean lookups_tracked = FALSE;
+
 /*
  * List of registered dissectors.
  */
@@ -163,8 +178,27 @@ destroy_depend_dissector_list(void *data)
 struct heur_dissector_list {
 	protocol_t	*protocol;
 	GSList		*dissectors;
+	wmem_map_t	*conv_entries;	/* conversation -> entry that first accepted a packet of it */
 };
 
+/* Whether dissector_try_heuristic() measures the time taken by each heuristic */
+static gboolean heur_dissector_timing = FALSE;
+
+/* Whether calls to the dissectors of protocols are profiled */
+static gboolean dissector_profiling = FALSE;
+
+/* protocol id -> dissector_profile_t */
+static GHashTable *dissector_profiles = NULL;
+
+/* A profiled call that hasn't returned yet */
+typedef struct {
+	dissector_profile_t *profile;
+	gint64               start;
+	gint64               children_us;	/* time in profiled calls it made */
+} dissector_profile_call_t;
+
+static GArray *dissector_profile_calls = NULL;
+
 static GHashTable *heur_dissector_lists = NULL;
 
 /* Name hashtables for fast detection of duplicate names */
@@ -190,11 +224,16 @@ destroy_heuristic_dissector_list(void *data)
 	g_slice_free(struct heur_dissector_list, dissector_list);
 }
 
+static void dtbl_flat_free(dissector_table_t sub_dissectors);
+
 static void
 destroy_dissector_table(void *data)
 {
 	struct dissector_table *table = (struct dissector_table *)data;
 
+	dtbl_flat_free(table);
+	if (table->seen != NULL)
+		g_hash_table_destroy(table->seen);
 	g_hash_table_destroy(table->hash_table);
 	g_slist_free(table->dissector_handles);
 	g_slice_free(struct dissector_table, data);
@@ -312,6 +351,15 @@ register_shutdown_routine(void (*func)(void))
 }
 
 /* Initialize all data structures used for dissection. */
+static void
+dtbl_forget_lookups(gpointer key _U_, gpointer value, gpointer user_data _U_)
+{
+	dissector_table_t sub_dissectors = (dissector_table_t)value;
+
+	if (sub_dissectors->seen != NULL)
+		g_hash_table_remove_all(sub_dissectors->seen);
+}
+
 void
 init_dissection(void)
 {
@@ -337,6 +385,10 @@ init_dissection(void)
 
 	/* Initialize the expert infos */
 	expert_packet_init();
+
+	/* Forget the lookups made by the previous dissection */
+	g_hash_table_foreach(dissector_tables, dtbl_forget_lookups, NULL);
+	lookups_tracked = track_lookups;
 }
 
 void
@@ -451,10 +503,35 @@ free_data_sources(packet_info *pinfo)
 void
 mark_frame_as_depended_upon(packet_info *pinfo, guint32 frame_num)
 {
+	frame_range_t	*range;
+	frame_range_t	 new_range;
+
 	/* Don't mark a frame as dependent on itself */
-	if (frame_num != pinfo->num) {
-		pinfo->dependent_frames = g_slist_prepend(pinfo->dependent_frames, GUINT_TO_POINTER(frame_num));
+	if (frame_num == pinfo->num || frame_num == 0)
+		return;
+
+	/*
+	 * Reassembly marks the fragments of a PDU in order, so a PDU
+	 * made of 100k segments normally ends up as one run.
+	 */
+	if (pinfo->dependent_frames == NULL) {
+		pinfo->dependent_frames = g_array_new(FALSE, FALSE, sizeof(frame_range_t));
+	} else {
+		range = &g_array_index(pinfo->dependent_frames, frame_range_t,
+		    pinfo->dependent_frames->len - 1);
+		if (frame_num >= range->first && frame_num <= range->last)
+			return;
+		if (frame_num == range->last + 1) {
+			range->last = frame_num;
+			return;
+		}
+		if (frame_num + 1 == range->first) {
+			range->first = frame_num;
+			return;
+		}
 	}
+	new_range.first = new_range.last = frame_num;
+	g_array_append_val(pinfo->dependent_frames, new_range);
 }
 
 /* Allow dissectors to register a "final_registration" routine
@@ -561,6 +638,7 @@ dissect_record(epan_dissect_t *edt, int file_type_subtype,
 		frame_dissector_data.pkt_comment = NULL;
 	frame_dissector_data.file_type_subtype = file_type_subtype;
 	frame_dissector_data.color_edt = edt; /* Used strictly for "coloring rules" */
+	frame_dissector_data.metadata_only = edt->metadata_only;
 
 	TRY {
 		/* Add this tvbuffer into the data_src list */
@@ -673,12 +751,51 @@ struct dissector_handle {
  * The only time this function will return 0 is if it is a new style dissector
  * and if the dissector rejected the packet.
  */
+/* Start timing a call to a dissector of the protocol; returns the
+ * depth to hand to dissector_profile_leave() */
+static guint
+dissector_profile_enter(int proto_id)
+{
+	dissector_profile_call_t call;
+
+	call.profile = (dissector_profile_t *)g_hash_table_lookup(dissector_profiles,
+		GINT_TO_POINTER(proto_id));
+	if (call.profile == NULL) {
+		call.profile = g_new0(dissector_profile_t, 1);
+		g_hash_table_insert(dissector_profiles, GINT_TO_POINTER(proto_id), call.profile);
+	}
+	call.profile->calls++;
+	call.children_us = 0;
+	call.start = g_get_monotonic_time();
+	g_array_append_val(dissector_profile_calls, call);
+	return dissector_profile_calls->len;
+}
+
+static void
+dissector_profile_leave(guint depth, gboolean exception)
+{
+	dissector_profile_call_t *call;
+	gint64 elapsed;
+
+	call = &g_array_index(dissector_profile_calls, dissector_profile_call_t, depth - 1);
+	elapsed = g_get_monotonic_time() - call->start;
+	call->profile->total_us += elapsed;
+	call->profile->self_us += elapsed - call->children_us;
+	if (exception)
+		call->profile->exceptions++;
+	g_array_set_size(dissector_profile_calls, depth - 1);
+
+	if (depth > 1)
+		g_array_index(dissector_profile_calls, dissector_profile_call_t, depth - 2).children_us += elapsed;
+}
+
 static int
 call_dissector_through_handle(dissector_handle_t handle, tvbuff_t *tvb,
 			      packet_info *pinfo, proto_tree *tree, void *data)
 {
 	const char *saved_proto;
-	int         len;
+	int         len = 0;
+	guint       depth;
 
 	saved_proto = pinfo->current_proto;
 
@@ -687,7 +804,20 @@ call_dissector_through_handle(dissector_handle_t handle, tvbuff_t *tvb,
 			proto_get_protocol_short_name(handle->protocol);
 	}
 
-	len = (*handle->dissector)(tvb, pinfo, tree, data);
+	if (dissector_profiling && handle->protocol != NULL) {
+		depth = dissector_profile_enter(proto_get_id(handle->protocol));
+		TRY {
+			len = (*handle->dissector)(tvb, pinfo, tree, data);
+		}
+		CATCH_ALL {
+			dissector_profile_leave(depth, TRUE);
+			RETHROW;
+		}
+		ENDTRY;
+		dissector_profile_leave(depth, FALSE);
+	} else {
+		len = (*handle->dissector)(tvb, pinfo, tree, data);
+	}
 	pinfo->current_proto = saved_proto;
 
 	return len;
@@ -939,6 +1069,164 @@ find_uint_dtbl_entry(dissector_table_t sub_dissectors, const guint32 pattern)
 				   GUINT_TO_POINTER(pattern));
 }
 
+/*
+ * The entries of a uint table with keys below DTBL_FLAT_KEYS, such as
+ * Ethertypes, IP protocol numbers and port numbers, are also kept in
+ * pages of directly indexed pointers, so that looking them up while
+ * dissecting doesn't involve hashing.  Only the pages that have entries
+ * in them are allocated.  The pages are built on the first lookup and
+ * thrown away whenever an entry is added to or removed from the table
+ * (changing the handle of an existing entry, as Decode As does, doesn't
+ * move the entry, so it needn't).
+ */
+#define DTBL_FLAT_KEYS  65536
+#define DTBL_PAGE_BITS  8
+#define DTBL_PAGE_SIZE  (1 << DTBL_PAGE_BITS)
+
+struct dtbl_flat {
+	dtbl_entry_t **pages[DTBL_FLAT_KEYS / DTBL_PAGE_SIZE];
+};
+
+static void
+dtbl_flat_add_entry(gpointer key, gpointer value, gpointer user_data)
+{
+	struct dtbl_flat *flat = (struct dtbl_flat *)user_data;
+	guint32 pattern = GPOINTER_TO_UINT(key);
+	dtbl_entry_t **page;
+
+	if (pattern >= DTBL_FLAT_KEYS)
+		return;
+
+	page = flat->pages[pattern >> DTBL_PAGE_BITS];
+	if (page == NULL) {
+		page = g_new0(dtbl_entry_t *, DTBL_PAGE_SIZE);
+		flat->pages[pattern >> DTBL_PAGE_BITS] = page;
+	}
+	page[pattern & (DTBL_PAGE_SIZE - 1)] = (dtbl_entry_t *)value;
+}
+
+static void
+dtbl_flat_free(dissector_table_t sub_dissectors)
+{
+	guint i;
+
+	if (sub_dissectors->flat == NULL)
+		return;
+
+	for (i = 0; i < G_N_ELEMENTS(sub_dissectors->flat->pages); i++)
+		g_free(sub_dissectors->flat->pages[i]);
+	g_free(sub_dissectors->flat);
+	sub_dissectors->flat = NULL;
+}
+
+/* Remember which handle the first lookup of key found */
+static void
+dtbl_note_lookup(dissector_table_t sub_dissectors, gconstpointer key,
+    const dtbl_entry_t *dtbl_entry)
+{
+	if (sub_dissectors->seen == NULL) {
+		if (IS_FT_STRING(sub_dissectors->type))
+			sub_dissectors->seen = g_hash_table_new_full(g_str_hash,
+			    g_str_equal, g_free, NULL);
+		else
+			sub_dissectors->seen = g_hash_table_new(g_direct_hash,
+			    g_direct_equal);
+	} else if (g_hash_table_lookup_extended(sub_dissectors->seen, key,
+	    NULL, NULL)) {
+		return;
+	}
+
+	g_hash_table_insert(sub_dissectors->seen,
+	    IS_FT_STRING(sub_dissectors->type) ? g_strdup((const gchar *)key) : (gpointer)key,
+	    dtbl_entry != NULL ? dtbl_entry->current : NULL);
+}
+
+/* Find an entry in a uint dissector table while dissecting. */
+static dtbl_entry_t *
+lookup_uint_dtbl_entry(dissector_table_t sub_dissectors, const guint32 pattern)
+{
+	dtbl_entry_t **page;
+	dtbl_entry_t  *dtbl_entry;
+
+	sub_dissectors->lookups++;
+
+	if (pattern < DTBL_FLAT_KEYS) {
+		if (G_UNLIKELY(sub_dissectors->flat == NULL)) {
+			/* Checks the table type, too. */
+			find_uint_dtbl_entry(sub_dissectors, pattern);
+
+			sub_dissectors->flat = g_new0(struct dtbl_flat, 1);
+			g_hash_table_foreach(sub_dissectors->hash_table,
+			    dtbl_flat_add_entry, sub_dissectors->flat);
+		}
+		page = sub_dissectors->flat->pages[pattern >> DTBL_PAGE_BITS];
+		dtbl_entry = page ? page[pattern & (DTBL_PAGE_SIZE - 1)] : NULL;
+	} else {
+		dtbl_entry = find_uint_dtbl_entry(sub_dissectors, pattern);
+	}
+
+	if (dtbl_entry != NULL && dtbl_entry->current != NULL)
+		sub_dissectors->hits++;
+	if (G_UNLIKELY(track_lookups) && sub_dissectors->supports_decode_as)
+		dtbl_note_lookup(sub_dissectors, GUINT_TO_POINTER(pattern), dtbl_entry);
+	return dtbl_entry;
+}
+
+void
+dissector_table_get_lookup_stats(const char *name, guint64 *lookups, guint64 *hits)
+{
+	dissector_table_t sub_dissectors = find_dissector_table(name);
+
+	if (sub_dissectors == NULL) {
+		*lookups = 0;
+		*hits = 0;
+		return;
+	}
+	*lookups = sub_dissectors->lookups;
+	*hits = sub_dissectors->hits;
+}
+
+void
+dissector_set_lookup_tracking(gboolean enable)
+{
+	track_lookups = enable;
+	/* What a dissection without tracking looked up is unknown */
+	if (!enable)
+		lookups_tracked = FALSE;
+}
+
+static dtbl_entry_t *find_string_dtbl_entry(dissector_table_t const sub_dissectors, const gchar *pattern);
+
+gboolean
+dissector_table_lookups_changed(void)
+{
+	GHashTableIter      tables, seen;
+	gpointer            value, key, handle;
+	dissector_table_t   sub_dissectors;
+	dtbl_entry_t       *dtbl_entry;
+
+	if (!lookups_tracked)
+		return TRUE;
+
+	g_hash_table_iter_init(&tables, dissector_tables);
+	while (g_hash_table_iter_next(&tables, NULL, &value)) {
+		sub_dissectors = (dissector_table_t)value;
+		if (sub_dissectors->seen == NULL)
+			continue;
+
+		g_hash_table_iter_init(&seen, sub_dissectors->seen);
+		while (g_hash_table_iter_next(&seen, &key, &handle)) {
+			if (IS_FT_STRING(sub_dissectors->type))
+				dtbl_entry = find_string_dtbl_entry(sub_dissectors, (const gchar *)key);
+			else
+				dtbl_entry = find_uint_dtbl_entry(sub_dissectors, GPOINTER_TO_UINT(key));
+			if ((dtbl_entry != NULL ? dtbl_entry->current : NULL) != handle)
+				return TRUE;
+		}
+	}
+	return FALSE;
+}
+
 #if 0
 static void
 dissector_add_uint_sanity_check(const char *name, guint32 pattern, dissector_handle_t handle, dissector_table_t sub_dissectors)
@@ -1018,6 +1306,7 @@ dissector_add_uint(const char *name, const guint32 pattern, dissector_handle_t h
 	/* do the table insertion */
 	g_hash_table_insert( sub_dissectors->hash_table,
 			     GUINT_TO_POINTER( pattern), (gpointer)dtbl_entry);
+	dtbl_flat_free(sub_dissectors);
 
 	/*
 	 * Now, if this table supports "Decode As", add this handle
@@ -1172,6 +1461,7 @@ dissector_delete_uint(const char *name, const guint32 pattern,
 		 */
 		g_hash_table_remove(sub_dissectors->hash_table,
 				    GUINT_TO_POINTER(pattern));
+		dtbl_flat_free(sub_dissectors);
 	}
 }
 
@@ -1213,6 +1503,7 @@ void dissector_delete_all(const char *name, dissector_handle_t handle)
 	g_assert (sub_dissectors);
 
 	g_hash_table_foreach_remove (sub_dissectors->hash_table, dissector_delete_all_check, handle);
+	dtbl_flat_free(sub_dissectors);
 }
 
 static void
@@ -1222,6 +1513,7 @@ dissector_delete_from_table(gpointer key _U_, gpointer value, gpointer user_data
 	g_assert (sub_dissectors);
 
 	g_hash_table_foreach_remove(sub_dissectors->hash_table, dissector_delete_all_check, user_data);
+	dtbl_flat_free(sub_dissectors);
 	sub_dissectors->dissector_handles = g_slist_remove(sub_dissectors->dissector_handles, user_data);
 }
 
@@ -1267,6 +1559,7 @@ dissector_change_uint(const char *name, const guint32 pattern, dissector_handle_
 	/* do the table insertion */
 	g_hash_table_insert( sub_dissectors->hash_table,
 			     GUINT_TO_POINTER( pattern), (gpointer)dtbl_entry);
+	dtbl_flat_free(sub_dissectors);
 }
 
 /* Reset an entry in a uint dissector table to its initial value. */
@@ -1295,6 +1588,7 @@ dissector_reset_uint(const char *name, const guint32 pattern)
 	} else {
 		g_hash_table_remove(sub_dissectors->hash_table,
 				    GUINT_TO_POINTER(pattern));
+		dtbl_flat_free(sub_dissectors);
 	}
 }
 
@@ -1312,7 +1606,7 @@ dissector_try_uint_new(dissector_table_t sub_dissectors, const guint32 uint_val,
 	guint32                  saved_match_uint;
 	int len;
 
-	dtbl_entry = find_uint_dtbl_entry(sub_dissectors, uint_val);
+	dtbl_entry = lookup_uint_dtbl_entry(sub_dissectors, uint_val);
 	if (dtbl_entry == NULL) {
 		/*
 		 * There's no entry in the table for our value.
@@ -1374,7 +1668,7 @@ dissector_get_uint_handle(dissector_table_t const sub_dissectors, const guint32
 {
 	dtbl_entry_t *dtbl_entry;
 
-	dtbl_entry = find_uint_dtbl_entry(sub_dissectors, uint_val);
+	dtbl_entry = lookup_uint_dtbl_entry(sub_dissectors, uint_val);
 	if (dtbl_entry != NULL)
 		return dtbl_entry->current;
 	else
@@ -1435,6 +1729,17 @@ find_string_dtbl_entry(dissector_table_t const sub_dissectors, const gchar *patt
 	return ret;
 }
 
+/* Find an entry in a string dissector table while dissecting. */
+static dtbl_entry_t *
+lookup_string_dtbl_entry(dissector_table_t const sub_dissectors, const gchar *pattern)
+{
+	dtbl_entry_t *dtbl_entry = find_string_dtbl_entry(sub_dissectors, pattern);
+
+	if (G_UNLIKELY(track_lookups) && sub_dissectors->supports_decode_as)
+		dtbl_note_lookup(sub_dissectors, pattern, dtbl_entry);
+	return dtbl_entry;
+}
+
 /* Add an entry to a string dissector table. */
 void
 dissector_add_string(const char *name, const gchar *pattern,
@@ -1617,7 +1922,7 @@ dissector_try_string(dissector_table_t sub_dissectors, const gchar *string,
 
 	/* XXX ASSERT instead ? */
 	if (!string) return 0;
-	dtbl_entry = find_string_dtbl_entry(sub_dissectors, string);
+	dtbl_entry = lookup_string_dtbl_entry(sub_dissectors, string);
 	if (dtbl_entry != NULL) {
 		/*
 		 * Is there currently a dissector handle for this entry?
@@ -1670,7 +1975,7 @@ dissector_get_string_handle(dissector_table_t sub_dissectors,
 
 	/* XXX ASSERT instead ? */
 	if (!string) return NULL;
-	dtbl_entry = find_string_dtbl_entry(sub_dissectors, string);
+	dtbl_entry = lookup_string_dtbl_entry(sub_dissectors, string);
 	if (dtbl_entry != NULL)
 		return dtbl_entry->current;
 	else
@@ -2409,6 +2714,10 @@ register_dissector_table(const char *name, const char *ui_name, const int proto,
 	sub_dissectors->param   = param;
 	sub_dissectors->protocol  = find_protocol_by_id(proto);
 	sub_dissectors->supports_decode_as = FALSE;
+	sub_dissectors->flat = NULL;
+	sub_dissectors->lookups = 0;
+	sub_dissectors->hits = 0;
+	sub_dissectors->seen = NULL;
 	g_hash_table_insert( dissector_tables, (gpointer)name, (gpointer) sub_dissectors );
 	return sub_dissectors;
 }
@@ -2438,6 +2747,10 @@ dissector_table_t register_custom_dissector_table(const char *name,
 	sub_dissectors->param   = BASE_NONE;
 	sub_dissectors->protocol  = find_protocol_by_id(proto);
 	sub_dissectors->supports_decode_as = FALSE;
+	sub_dissectors->flat = NULL;
+	sub_dissectors->lookups = 0;
+	sub_dissectors->hits = 0;
+	sub_dissectors->seen = NULL;
 	g_hash_table_insert( dissector_tables, (gpointer)name, (gpointer) sub_dissectors );
 	return sub_dissectors;
 }
@@ -2553,6 +2866,9 @@ heur_dissector_add(const char *name, heur_dissector_t dissector, const char *dis
 	hdtbl_entry->short_name = g_strdup(short_name);
 	hdtbl_entry->list_name = g_strdup(name);
 	hdtbl_entry->enabled   = (enable == HEURISTIC_ENABLE);
+	hdtbl_entry->tries     = 0;
+	hdtbl_entry->hits      = 0;
+	hdtbl_entry->time_us   = 0;
 
 	/* do the table insertion */
 	g_hash_table_insert(heuristic_short_names, (gpointer)hdtbl_entry->short_name, hdtbl_entry);
@@ -2598,6 +2914,16 @@ heur_dissector_delete(const char *name, heur_dissector_t dissector, const int pr
 
 	if (found_entry) {
 		heur_dtbl_entry_t *found_hdtbl_entry = (heur_dtbl_entry_t *)(found_entry->data);
+		wmem_list_t       *convs;
+		wmem_list_frame_t *frame;
+
+		/* Forget the conversations the entry was remembered for */
+		convs = wmem_map_get_keys(NULL, sub_dissectors->conv_entries);
+		for (frame = wmem_list_head(convs); frame != NULL; frame = wmem_list_frame_next(frame)) {
+			if (wmem_map_lookup(sub_dissectors->conv_entries, wmem_list_frame_data(frame)) == found_hdtbl_entry)
+				wmem_map_remove(sub_dissectors->conv_entries, wmem_list_frame_data(frame));
+		}
+		wmem_destroy_list(convs);
 		g_free(found_hdtbl_entry->list_name);
 		g_hash_table_remove(heuristic_short_names, found_hdtbl_entry->short_name);
 		g_free(found_hdtbl_entry->short_name);
@@ -2607,6 +2933,78 @@ heur_dissector_delete(const char *name, heur_dissector_t dissector, const int pr
 	}
 }
 
+static gboolean
+heur_dtbl_entry_usable(const heur_dtbl_entry_t *hdtbl_entry)
+{
+	return hdtbl_entry->protocol == NULL ||
+		(proto_is_protocol_enabled(hdtbl_entry->protocol) && hdtbl_entry->enabled);
+}
+
+/* Hand the packet to one heuristic dissector; returns what it returned. */
+static int
+call_heur_dtbl_entry(heur_dtbl_entry_t *hdtbl_entry, tvbuff_t *tvb,
+			packet_info *pinfo, proto_tree *tree, void *data,
+			guint saved_layers_len, int saved_tree_count)
+{
+	int    proto_id = -1;
+	int    len = 0;
+	gint64 start = 0;
+	guint  depth;
+
+	if (hdtbl_entry->protocol != NULL) {
+		proto_id = proto_get_id(hdtbl_entry->protocol);
+		/* do NOT change this behavior - wslua uses the protocol short name set here in order
+		   to determine which Lua-based heurisitc dissector to call */
+		pinfo->current_proto =
+			proto_get_protocol_short_name(hdtbl_entry->protocol);
+
+		/*
+		 * Add the protocol name to the layers; we'll remove it
+		 * if the dissector fails.
+		 */
+		pinfo->curr_layer_num++;
+		wmem_list_append(pinfo->layers, GINT_TO_POINTER(proto_id));
+	}
+
+	pinfo->heur_list_name = hdtbl_entry->list_name;
+
+	hdtbl_entry->tries++;
+	if (heur_dissector_timing)
+		start = g_get_monotonic_time();
+	if (dissector_profiling && proto_id != -1) {
+		depth = dissector_profile_enter(proto_id);
+		TRY {
+			len = (hdtbl_entry->dissector)(tvb, pinfo, tree, data);
+		}
+		CATCH_ALL {
+			dissector_profile_leave(depth, TRUE);
+			RETHROW;
+		}
+		ENDTRY;
+		dissector_profile_leave(depth, FALSE);
+	} else {
+		len = (hdtbl_entry->dissector)(tvb, pinfo, tree, data);
+	}
+	if (heur_dissector_timing)
+		hdtbl_entry->time_us += g_get_monotonic_time() - start;
+
+	if (hdtbl_entry->protocol != NULL &&
+		(len == 0 || (tree && saved_tree_count == tree->tree_data->count))) {
+		/*
+		 * We added a protocol layer above. The dissector
+		 * didn't accept the packet or it didn't add any
+		 * items to the tree so remove it from the list.
+		 */
+		while (wmem_list_count(pinfo->layers) > saved_layers_len) {
+			pinfo->curr_layer_num--;
+			wmem_list_remove_frame(pinfo->layers, wmem_list_tail(pinfo->layers));
+		}
+	}
+	if (len)
+		hdtbl_entry->hits++;
+	return len;
+}
+
 gboolean
 dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 			packet_info *pinfo, proto_tree *tree, heur_dtbl_entry_t **heur_dtbl_entry, void *data)
@@ -2618,8 +3016,8 @@ dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 	guint16            saved_can_desegment;
 	guint              saved_layers_len = 0;
 	heur_dtbl_entry_t *hdtbl_entry;
-	int                proto_id;
-	int                len;
+	heur_dtbl_entry_t *conv_hdtbl_entry = NULL;
+	conversation_t    *conv = NULL;
 	int                saved_tree_count = tree ? tree->tree_data->count : 0;
 
 	/* can_desegment is set to 2 by anyone which offers this api/service.
@@ -2642,63 +3040,100 @@ dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 	saved_layers_len = wmem_list_count(pinfo->layers);
 	*heur_dtbl_entry = NULL;
 
+	/*
+	 * If a heuristic of this list has already accepted a packet of
+	 * this conversation, it's very likely to accept this one as well,
+	 * so try it before working through the whole list.
+	 */
+	if (sub_dissectors->dissectors != NULL && sub_dissectors->dissectors->next != NULL) {
+		conv = find_conversation(pinfo->num, &pinfo->src, &pinfo->dst,
+		    pinfo->ptype, pinfo->srcport, pinfo->destport, 0);
+		if (conv != NULL)
+			conv_hdtbl_entry = (heur_dtbl_entry_t *)wmem_map_lookup(sub_dissectors->conv_entries, conv);
+		if (conv_hdtbl_entry != NULL && heur_dtbl_entry_usable(conv_hdtbl_entry) &&
+		    call_heur_dtbl_entry(conv_hdtbl_entry, tvb, pinfo, tree, data,
+		    saved_layers_len, saved_tree_count)) {
+			*heur_dtbl_entry = conv_hdtbl_entry;
+			status = TRUE;
+			goto done;
+		}
+	}
+
 	for (entry = sub_dissectors->dissectors; entry != NULL;
 	    entry = g_slist_next(entry)) {
 		/* XXX - why set this now and above? */
 		pinfo->can_desegment = saved_can_desegment-(saved_can_desegment>0);
 		hdtbl_entry = (heur_dtbl_entry_t *)entry->data;
 
-		if (hdtbl_entry->protocol != NULL &&
-			(!proto_is_protocol_enabled(hdtbl_entry->protocol)||(hdtbl_entry->enabled==FALSE))) {
+		if (hdtbl_entry == conv_hdtbl_entry || !heur_dtbl_entry_usable(hdtbl_entry)) {
 			/*
-			 * No - don't try this dissector.
+			 * No - don't try this dissector (again).
 			 */
 			continue;
 		}
 
-		if (hdtbl_entry->protocol != NULL) {
-			proto_id = proto_get_id(hdtbl_entry->protocol);
-			/* do NOT change this behavior - wslua uses the protocol short name set here in order
-			   to determine which Lua-based heurisitc dissector to call */
-			pinfo->current_proto =
-				proto_get_protocol_short_name(hdtbl_entry->protocol);
-
-			/*
-			 * Add the protocol name to the layers; we'll remove it
-			 * if the dissector fails.
-			 */
-			pinfo->curr_layer_num++;
-			wmem_list_append(pinfo->layers, GINT_TO_POINTER(proto_id));
-		}
-
-		pinfo->heur_list_name = hdtbl_entry->list_name;
-
-		len = (hdtbl_entry->dissector)(tvb, pinfo, tree, data);
-		if (hdtbl_entry->protocol != NULL &&
-			(len == 0 || (tree && saved_tree_count == tree->tree_data->count))) {
-			/*
-			 * We added a protocol layer above. The dissector
-			 * didn't accept the packet or it didn't add any
-			 * items to the tree so remove it from the list.
-			 */
-			while (wmem_list_count(pinfo->layers) > saved_layers_len) {
-				pinfo->curr_layer_num--;
-				wmem_list_remove_frame(pinfo->layers, wmem_list_tail(pinfo->layers));
-			}
-		}
-		if (len) {
+		if (call_heur_dtbl_entry(hdtbl_entry, tvb, pinfo, tree, data,
+		    saved_layers_len, saved_tree_count)) {
 			*heur_dtbl_entry = hdtbl_entry;
 			status = TRUE;
+			/*
+			 * Only the first heuristic to accept a packet of the
+			 * conversation is remembered, so that dissecting the
+			 * packets again gives the same result.
+			 */
+			if (conv != NULL && conv_hdtbl_entry == NULL)
+				wmem_map_insert(sub_dissectors->conv_entries, conv, hdtbl_entry);
 			break;
 		}
 	}
 
+done:
 	pinfo->current_proto = saved_curr_proto;
 	pinfo->heur_list_name = saved_heur_list_name;
 	pinfo->can_desegment = saved_can_desegment;
 	return status;
 }
 
+void
+heur_dissector_set_timing(gboolean enable)
+{
+	heur_dissector_timing = enable;
+}
+
+void
+dissector_set_profiling(gboolean enable)
+{
+	if (enable && dissector_profiles == NULL) {
+		dissector_profiles = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+		dissector_profile_calls = g_array_new(FALSE, FALSE, sizeof(dissector_profile_call_t));
+	}
+	dissector_profiling = enable;
+	/* Time the heuristics too, for their tries and accepts */
+	if (enable)
+		heur_dissector_timing = TRUE;
+}
+
+void
+dissector_profile_reset(void)
+{
+	if (dissector_profiles != NULL)
+		g_hash_table_remove_all(dissector_profiles);
+}
+
+void
+dissector_profile_foreach(dissector_profile_func func, gpointer user_data)
+{
+	GHashTableIter      iter;
+	gpointer            key, value;
+
+	if (dissector_profiles == NULL)
+		return;
+
+	g_hash_table_iter_init(&iter, dissector_profiles);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+		func(GPOINTER_TO_INT(key), (const dissector_profile_t *)value, user_data);
+}
+
 typedef struct heur_dissector_foreach_info {
 	gpointer      caller_data;
 	DATFunc_heur  caller_func;
@@ -2847,6 +3282,8 @@ register_heur_dissector_list(const char *name, const int proto)
 	sub_dissectors = g_slice_new(struct heur_dissector_list);
 	sub_dissectors->protocol  = find_protocol_by_id(proto);
 	sub_dissectors->dissectors = NULL;	/* initially empty */
+	sub_dissectors->conv_entries = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(),
+	    g_direct_hash, g_direct_equal);
 	g_hash_table_insert(heur_dissector_lists, (gpointer)name,
 			    (gpointer) sub_dissectors);
 	return sub_dissectors;
@@ -411,6 +411,24 @@ WS_DLL_PUBLIC ftenum_t dissector_table_get_type(dissector_table_t dissector_tabl
  */
 WS_DLL_PUBLIC void dissector_table_allow_decode_as(dissector_table_t dissector_table);
 
+/** Get the number of lookups done in a uint dissector table while
+ * dissecting, and how many of them found a dissector.  Both are 0 if
+ * there's no table with that name.
+ */
+WS_DLL_PUBLIC void dissector_table_get_lookup_stats(const char *name, guint64 *lookups, guint64 *hits);
+
+/** Start or stop remembering which dissector each value looked up while
+ * dissecting found, in the uint and string tables that allow "Decode As".
+ * What was remembered is forgotten when dissection is initialized.
+ */
+WS_DLL_PUBLIC void dissector_set_lookup_tracking(gboolean enable);
+
+/** Whether a value remembered as above would now find another dissector,
+ * i.e. whether changes made to the tables since dissection was initialized
+ * can change the dissection.  TRUE if lookups weren't tracked throughout.
+ */
+WS_DLL_PUBLIC gboolean dissector_table_lookups_changed(void);
+
 /* List of "heuristic" dissectors (which get handed a packet, look at it,
    and either recognize it as being for their protocol, dissect it, and
    return TRUE, or don't recognize it and return FALSE) to be called
@@ -428,6 +446,9 @@ typedef struct heur_dtbl_entry {
 	const gchar *display_name;     /* the string used to present heuristic to user */
 	gchar *short_name;     /* string used for "internal" use to uniquely identify heuristic */
 	gboolean enabled;
+	guint64 tries;        /* times the dissector was called by dissector_try_heuristic() */
+	guint64 hits;         /* ... and how many of those times it accepted the packet */
+	guint64 time_us;      /* microseconds spent in those calls, if timing is enabled */
 } heur_dtbl_entry_t;
 
 /** A protocol uses this function to register a heuristic sub-dissector list.
@@ -483,6 +504,43 @@ WS_DLL_PUBLIC gboolean has_heur_dissector_list(const gchar *name);
 WS_DLL_PUBLIC gboolean dissector_try_heuristic(heur_dissector_list_t sub_dissectors,
     tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, heur_dtbl_entry_t **hdtbl_entry, void *data);
 
+/** Enable or disable measuring the time taken by each heuristic dissector
+ *  called by dissector_try_heuristic(), which is added to its time_us.
+ *  Tries and hits are always counted.
+ *
+ * @param enable TRUE to measure the time
+ */
+WS_DLL_PUBLIC void heur_dissector_set_timing(gboolean enable);
+
+/** What was measured for the calls to a protocol's dissectors while
+ *  profiling was enabled.  A dissector called through a handle or as a
+ *  heuristic counts, whether or not it accepted the packet. */
+typedef struct {
+	guint64 calls;
+	guint64 exceptions;   /* calls that ended with an exception */
+	guint64 total_us;     /* microseconds in the calls... */
+	guint64 self_us;      /* ... not counting those in profiled calls they made */
+} dissector_profile_t;
+
+typedef void (*dissector_profile_func)(int proto_id, const dissector_profile_t *profile,
+    gpointer user_data);
+
+/** Enable or disable profiling the dissectors of protocols; this also
+ *  enables heur_dissector_set_timing().  Disabled, it costs a test per
+ *  dissector call.  The figures are kept while it's disabled.
+ *
+ * @param enable TRUE to profile
+ */
+WS_DLL_PUBLIC void dissector_set_profiling(gboolean enable);
+
+/** Forget the figures measured so far.  Not to be called while a packet
+ *  is being dissected. */
+WS_DLL_PUBLIC void dissector_profile_reset(void);
+
+/** Call func for each protocol that had a dissector called while
+ *  profiling, in no particular order. */
+WS_DLL_PUBLIC void dissector_profile_foreach(dissector_profile_func func, gpointer user_data);
+
 /** Find a heuristic dissector table by table name.
  *
  * @param name name of the dissector table
@@ -733,6 +791,7 @@ typedef struct frame_data_s
     int file_type_subtype;
     const gchar  *pkt_comment; /**< NULL if not available */
     struct epan_dissect *color_edt; /** Used strictly for "coloring rules" */
+    gboolean metadata_only; /**< Stop after the frame metadata */
 
 } frame_data_t;
 
@@ -51,6 +51,12 @@
  */
 #define PINFO_HAS_TS            0x00000001  /**< time stamp */
 
+/** A run of consecutive frames, as in packet_info.dependent_frames */
+typedef struct {
+  guint32 first;
+  guint32 last;
+} frame_range_t;
+
 typedef struct _packet_info {
   const char *current_proto;        /**< name of protocol currently being dissected */
   struct epan_column_info *cinfo;   /**< Column formatting information */
@@ -154,7 +160,7 @@ typedef struct _packet_info {
 
   GSList* proto_data;          /**< Per packet proto data */
 
-  GSList* dependent_frames;     /**< A list of frames which this one depends on */
+  GArray* dependent_frames;     /**< frame_range_t runs of the frames which this one depends on, or NULL */
 
   GSList* frame_end_routines;
 
@@ -46,6 +46,7 @@ struct pref_module {
     wmem_tree_t *submodules;    /**< list of its submodules */
     int numprefs;               /**< number of non-obsolete preferences */
     gboolean prefs_changed;     /**< if TRUE, a preference has changed since we last checked */
+    gchar *reset_values;        /**< the values prefs_reset() found, or NULL; see call_apply_cb() */
     gboolean obsolete;          /**< if TRUE, this is a module that used to
                                  * exist but no longer does
                                  */
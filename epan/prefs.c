@@ -508,6 +508,7 @@ prefs_register_module_or_subtree(module_t *parent, const char *name,
     module->submodules = NULL;    /* no submodules, to start */
     module->numprefs = 0;
     module->prefs_changed = FALSE;
+    module->reset_values = NULL;
     module->obsolete = FALSE;
     module->use_gui = use_gui;
 
@@ -857,13 +858,53 @@ prefs_modules_foreach_submodules(module_t *module, module_cb callback,
     return prefs_module_list_foreach((module)?module->submodules:prefs_top_level_modules, callback, user_data, TRUE);
 }
 
+/*
+ * The current values of a module's preferences, one per line, for
+ * telling whether rereading the preferences has changed any of them.
+ */
+static gchar *
+module_values_str(module_t *module)
+{
+    GString *values = g_string_new("");
+    GList   *elem;
+    pref_t  *pref;
+    char    *pref_text;
+
+    for (elem = module->prefs; elem != NULL; elem = g_list_next(elem)) {
+        pref = (pref_t *)elem->data;
+        if (IS_PREF_OBSOLETE(pref->type))
+            continue;
+        pref_text = prefs_pref_to_str(pref, pref_current);
+        g_string_append(values, pref_text);
+        g_string_append_c(values, '\n');
+        g_free(pref_text);
+    }
+    return g_string_free(values, FALSE);
+}
+
 static gboolean
 call_apply_cb(const void *key _U_, void *value, void *data _U_)
 {
     module_t *module = (module_t *)value;
+    gchar    *values;
 
     if (module->obsolete)
         return FALSE;
+    /*
+     * After prefs_reset() and reading the preferences again, as when
+     * switching profiles, the flag says whether a preference differs
+     * from its default, not from what the module last saw.  Compare
+     * the values themselves instead, so modules whose preferences are
+     * the same in both profiles aren't reinitialized, and those whose
+     * preferences went back to the defaults are.
+     */
+    if (module->reset_values != NULL) {
+        values = module_values_str(module);
+        module->prefs_changed = strcmp(values, module->reset_values) != 0;
+        g_free(values);
+        g_free(module->reset_values);
+        module->reset_values = NULL;
+    }
     if (module->prefs_changed) {
         if (module->apply_cb != NULL)
             (*module->apply_cb)();
@@ -3595,6 +3636,13 @@ prefs_register_modules(void)
                                    "Look for dissectors that left some bytes undecoded.",
                                    &prefs.enable_incomplete_dissectors_check);
 
+    prefs_register_uint_preference(protocols_module, "reassembly_memory_limit",
+                                   "Reassembly memory limit (MB)",
+                                   "Drop the oldest incomplete reassemblies of a protocol when the "
+                                   "fragments they're waiting for use more than this many megabytes "
+                                   "(0 for no limit).",
+                                   10, &prefs.reassembly_memory_limit);
+
     /* Obsolete preferences
      * These "modules" were reorganized/renamed to correspond to their GUI
      * configuration screen within the preferences dialog
@@ -4121,6 +4169,7 @@ pre_init_prefs(void)
     prefs.st_sort_showfullname = FALSE;
     prefs.display_hidden_proto_items = FALSE;
     prefs.display_byte_fields_with_spaces = FALSE;
+    prefs.reassembly_memory_limit = 0;
 }
 
 /*
@@ -4215,6 +4264,10 @@ reset_module_prefs(const void *key _U_, void *value, void *data _U_)
     reset_pref_arg_t arg;
 
     arg.module = (module_t *)value;
+    /* Values the module hasn't been told about yet can't be compared */
+    if (arg.module->apply_cb != NULL && !arg.module->prefs_changed &&
+        arg.module->reset_values == NULL)
+        arg.module->reset_values = module_values_str(arg.module);
     g_list_foreach(arg.module->prefs, reset_pref_cb, &arg);
     return FALSE;
 }
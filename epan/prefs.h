@@ -220,6 +220,7 @@ typedef struct _e_prefs {
   gboolean     display_hidden_proto_items;
   gboolean     display_byte_fields_with_spaces;
   gboolean     enable_incomplete_dissectors_check;
+  guint        reassembly_memory_limit; /* MB, 0 for no limit */
   gboolean     incomplete_dissectors_check_debug;
   gboolean     gui_update_enabled;
   software_update_channel_e gui_update_channel;
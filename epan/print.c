@@ -89,9 +89,16 @@ struct _output_fields {
     gchar         aggregator;
     GPtrArray    *fields;
     GHashTable   *field_indicies;
+    gint         *field_ids;                /* hf id of each field, -1 for columns and unknown names */
+    gboolean      field_ids_usable;         /* each field name has a single hf id */
+    gboolean      primed;                   /* the fields are primed, see output_fields_prime_edt() */
     GPtrArray   **field_values;
     gchar         quote;
     gboolean      includes_col_fields;
+    struct columnar_column_s *columnar;     /* one per field, for columnar output */
+    field_info  **columnar_fi;              /* this packet's value of each field */
+    const gchar **columnar_col_data;        /* ditto, for column fields */
+    guint         columnar_rows;            /* rows in the current batch */
 };
 
 static gchar *get_field_hex_value(GSList *src_list, field_info *fi);
@@ -107,6 +114,7 @@ static void write_specified_fields(fields_format format,
                                    output_fields_t *fields,
                                    epan_dissect_t *edt, column_info *cinfo,
                                    FILE *fh);
+static void columnar_free(output_fields_t *fields);
 static void print_escaped_xml(FILE *fh, const char *unescaped_string);
 static void print_escaped_json(FILE *fh, const char *unescaped_string);
 static void print_escaped_ek(FILE *fh, const char *unescaped_string);
@@ -1736,14 +1744,22 @@ get_field_data(GSList *src_list, field_info *fi)
 static void
 print_escaped_xml(FILE *fh, const char *unescaped_string)
 {
-    const char *p;
+    const char *p, *run;
     char        temp_str[8];
 
     if (fh == NULL || unescaped_string == NULL) {
         return;
     }
 
-    for (p = unescaped_string; *p != '\0'; p++) {
+    for (p = run = unescaped_string; *p != '\0'; p++) {
+        /* Leave runs of characters that don't need escaping to one fwrite() */
+        if (g_ascii_isprint(*p) && *p != '&' && *p != '<' && *p != '>' &&
+            *p != '"' && *p != '\'')
+            continue;
+        if (p > run)
+            fwrite(run, 1, p - run, fh);
+        run = p + 1;
+
         switch (*p) {
         case '&':
             fputs("&amp;", fh);
@@ -1761,27 +1777,33 @@ print_escaped_xml(FILE *fh, const char *unescaped_string)
             fputs("&#x27;", fh);
             break;
         default:
-            if (g_ascii_isprint(*p))
-                fputc(*p, fh);
-            else {
-                g_snprintf(temp_str, sizeof(temp_str), "\\x%x", (guint8)*p);
-                fputs(temp_str, fh);
-            }
+            g_snprintf(temp_str, sizeof(temp_str), "\\x%x", (guint8)*p);
+            fputs(temp_str, fh);
         }
     }
+    if (p > run)
+        fwrite(run, 1, p - run, fh);
 }
 
 static void
 print_escaped_bare(FILE *fh, const char *unescaped_string, gboolean change_dot)
 {
-    const char *p;
+    const char *p, *run;
     char        temp_str[8];
 
     if (fh == NULL || unescaped_string == NULL) {
         return;
     }
 
-    for (p = unescaped_string; *p != '\0'; p++) {
+    for (p = run = unescaped_string; *p != '\0'; p++) {
+        /* Leave runs of characters that don't need escaping to one fwrite() */
+        if (g_ascii_isprint(*p) && *p != '"' && *p != '\\' && *p != '/' &&
+            (*p != '.' || !change_dot))
+            continue;
+        if (p > run)
+            fwrite(run, 1, p - run, fh);
+        run = p + 1;
+
         switch (*p) {
         case '"':
             fputs("\\\"", fh);
@@ -1808,20 +1830,16 @@ print_escaped_bare(FILE *fh, const char *unescaped_string, gboolean change_dot)
             fputs("\\t", fh);
             break;
         case '.':
-            if (change_dot)
-                fputs("_", fh);
-            else
-                fputs(".", fh);
+            /* Only when change_dot is set */
+            fputs("_", fh);
             break;
         default:
-            if (g_ascii_isprint(*p))
-                fputc(*p, fh);
-            else {
-                g_snprintf(temp_str, sizeof(temp_str), "\\u00%02x", (guint8)*p);
-                fputs(temp_str, fh);
-            }
+            g_snprintf(temp_str, sizeof(temp_str), "\\u00%02x", (guint8)*p);
+            fputs(temp_str, fh);
         }
     }
+    if (p > run)
+        fwrite(run, 1, p - run, fh);
 }
 
 /* Print a string, escaping out certain characters that need to
@@ -1840,10 +1858,30 @@ print_escaped_ek(FILE *fh, const char *unescaped_string)
     print_escaped_bare(fh, unescaped_string, TRUE);
 }
 
+/* Write bytes as lower-case hex digits, without a printf per byte */
+static void
+write_hex_bytes(FILE *fh, const guint8 *pd, int length)
+{
+    static const char hex_digits[] = "0123456789abcdef";
+    char              hex_buf[256];
+    size_t            n = 0;
+    int               i;
+
+    for (i = 0; i < length; i++) {
+        hex_buf[n++] = hex_digits[pd[i] >> 4];
+        hex_buf[n++] = hex_digits[pd[i] & 0x0f];
+        if (n == sizeof hex_buf) {
+            fwrite(hex_buf, 1, n, fh);
+            n = 0;
+        }
+    }
+    if (n > 0)
+        fwrite(hex_buf, 1, n, fh);
+}
+
 static void
 pdml_write_field_hex_value(write_pdml_data *pdata, field_info *fi)
 {
-    int           i;
     const guint8 *pd;
 
     if (!fi->ds_tvb)
@@ -1859,16 +1897,13 @@ pdml_write_field_hex_value(write_pdml_data *pdata, field_info *fi)
 
     if (pd) {
         /* Print a simple hex dump */
-        for (i = 0 ; i < fi->length; i++) {
-            fprintf(pdata->fh, "%02x", pd[i]);
-        }
+        write_hex_bytes(pdata->fh, pd, fi->length);
     }
 }
 
 static void
 json_write_field_hex_value(write_json_data *pdata, field_info *fi)
 {
-    int           i;
     const guint8 *pd;
 
     if (!fi->ds_tvb)
@@ -1884,9 +1919,7 @@ json_write_field_hex_value(write_json_data *pdata, field_info *fi)
 
     if (pd) {
         /* Print a simple hex dump */
-        for (i = 0 ; i < fi->length; i++) {
-            fprintf(pdata->fh, "%02x", pd[i]);
-        }
+        write_hex_bytes(pdata->fh, pd, fi->length);
     }
 }
 
@@ -2061,6 +2094,12 @@ void output_fields_free(output_fields_t* fields)
             g_free(fields->field_values);
         }
 
+        g_free(fields->field_ids);
+
+        if (NULL != fields->columnar) {
+            columnar_free(fields);
+        }
+
         for(i = 0; i < fields->fields->len; ++i) {
             gchar* field = (gchar *)g_ptr_array_index(fields->fields,i);
             g_free(field);
@@ -2123,6 +2162,71 @@ output_fields_valid(output_fields_t *fields)
     return invalid_fields;
 }
 
+gboolean
+output_fields_need_visible_tree(output_fields_t *fields)
+{
+    gsize i;
+
+    g_assert(fields);
+
+    if (fields->fields == NULL) {
+        return FALSE;
+    }
+
+    for (i = 0; i < fields->fields->len; i++) {
+        const gchar *field = (const gchar *)g_ptr_array_index(fields->fields, i);
+        header_field_info *hfinfo;
+
+        if (!strncmp(field, COLUMN_FIELD_FILTER, strlen(COLUMN_FIELD_FILTER)))
+            continue;
+
+        /* Protocols are printed using their item label, which is only
+         * filled in when the tree is visible. */
+        hfinfo = proto_registrar_get_byname(field);
+        if (hfinfo == NULL || hfinfo->type == FT_PROTOCOL)
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+void
+output_fields_prime_edt(output_fields_t *fields, epan_dissect_t *edt)
+{
+    gsize i;
+
+    g_assert(fields);
+    g_assert(edt);
+
+    if (fields->fields == NULL) {
+        return;
+    }
+
+    /* The dissection now collects the fields, so we can pick them up from
+     * there instead of searching the tree. */
+    fields->primed = TRUE;
+
+    for (i = 0; i < fields->fields->len; i++) {
+        const gchar *field = (const gchar *)g_ptr_array_index(fields->fields, i);
+        header_field_info *hfinfo;
+
+        if (!strncmp(field, COLUMN_FIELD_FILTER, strlen(COLUMN_FIELD_FILTER)))
+            continue;
+
+        hfinfo = proto_registrar_get_byname(field);
+        if (hfinfo == NULL)
+            continue;
+
+        /* Prime every field registered under this name. */
+        while (hfinfo->same_name_prev_id != -1) {
+            hfinfo = proto_registrar_get_nth(hfinfo->same_name_prev_id);
+        }
+        for (; hfinfo != NULL; hfinfo = hfinfo->same_name_next) {
+            epan_dissect_prime_with_hfid(edt, hfinfo->id);
+        }
+    }
+}
+
 gboolean output_fields_set_option(output_fields_t *info, gchar *option)
 {
     const gchar *option_name;
@@ -2354,6 +2458,60 @@ static void proto_tree_get_node_field_values(proto_node *node, gpointer data)
     }
 }
 
+/* Prepare a lookup table from string abbreviation for field to its index. */
+static void prepare_field_indicies(output_fields_t *fields)
+{
+    gsize i;
+
+    if (NULL != fields->field_indicies)
+        return;
+
+    fields->field_indicies = g_hash_table_new(g_str_hash, g_str_equal);
+
+    i = 0;
+    while (i < fields->fields->len) {
+        gchar *field = (gchar *)g_ptr_array_index(fields->fields, i);
+        /* Store field indicies +1 so that zero is not a valid value,
+         * and can be distinguished from NULL as a pointer.
+         */
+        ++i;
+        g_hash_table_insert(fields->field_indicies, field, GUINT_TO_POINTER(i));
+    }
+}
+
+/*
+ * Look up the hf id of each field. If the fields are primed and every
+ * name has a single hf id, the field_infos collected for those ids during
+ * the dissection are exactly the ones a walk of the tree would find, so
+ * the walk can be skipped. With several hf ids for a name we'd have to
+ * merge their field_infos back into tree order, so we walk the tree then.
+ */
+static gboolean use_field_ids(output_fields_t *fields)
+{
+    gsize i;
+
+    if (!fields->primed)
+        return FALSE;
+
+    if (NULL == fields->field_ids) {
+        fields->field_ids = g_new(gint, fields->fields->len);  /* free'd in output_fields_free() */
+        fields->field_ids_usable = TRUE;
+        for (i = 0; i < fields->fields->len; i++) {
+            const gchar *field = (const gchar *)g_ptr_array_index(fields->fields, i);
+            header_field_info *hfinfo = NULL;
+
+            if (strncmp(field, COLUMN_FIELD_FILTER, strlen(COLUMN_FIELD_FILTER)))
+                hfinfo = proto_registrar_get_byname(field);
+
+            fields->field_ids[i] = hfinfo ? hfinfo->id : -1;
+            if (hfinfo && (hfinfo->same_name_prev_id != -1 || hfinfo->same_name_next != NULL))
+                fields->field_ids_usable = FALSE;
+        }
+    }
+
+    return fields->field_ids_usable;
+}
+
 static void write_specified_fields(fields_format format, output_fields_t *fields, epan_dissect_t *edt, column_info *cinfo, FILE *fh)
 {
     gsize     i;
@@ -2372,20 +2530,7 @@ static void write_specified_fields(fields_format format, output_fields_t *fields
     data.fields = fields;
     data.edt = edt;
 
-    if (NULL == fields->field_indicies) {
-        /* Prepare a lookup table from string abbreviation for field to its index. */
-        fields->field_indicies = g_hash_table_new(g_str_hash, g_str_equal);
-
-        i = 0;
-        while (i < fields->fields->len) {
-            gchar *field = (gchar *)g_ptr_array_index(fields->fields, i);
-            /* Store field indicies +1 so that zero is not a valid value,
-             * and can be distinguished from NULL as a pointer.
-             */
-            ++i;
-            g_hash_table_insert(fields->field_indicies, field, GUINT_TO_POINTER(i));
-        }
-    }
+    prepare_field_indicies(fields);
 
     /* Array buffer to store values for this packet              */
     /*  Allocate an array for the 'GPtrarray *' the first time   */
@@ -2396,8 +2541,26 @@ static void write_specified_fields(fields_format format, output_fields_t *fields
     if (NULL == fields->field_values)
         fields->field_values = g_new0(GPtrArray*, fields->fields->len);  /* free'd in output_fields_free() */
 
-    proto_tree_children_foreach(edt->tree, proto_tree_get_node_field_values,
-                                &data);
+    if (use_field_ids(fields)) {
+        for (i = 0; i < fields->fields->len; i++) {
+            GPtrArray *finfos;
+            guint      j;
+
+            if (fields->field_ids[i] < 0)
+                continue;
+            finfos = proto_get_finfo_ptr_array(edt->tree, fields->field_ids[i]);
+            if (finfos == NULL)
+                continue;
+            for (j = 0; j < finfos->len; j++) {
+                format_field_values(fields, GUINT_TO_POINTER(i + 1),
+                                    get_node_field_value((field_info *)g_ptr_array_index(finfos, j), edt) /* g_ alloc'd string */
+                    );
+            }
+        }
+    } else {
+        proto_tree_children_foreach(edt->tree, proto_tree_get_node_field_values,
+                                    &data);
+    }
 
     switch (format) {
     case FORMAT_CSV:
@@ -2563,6 +2726,440 @@ void write_fields_finale(output_fields_t* fields _U_ , FILE *fh _U_)
     /* Nothing to do */
 }
 
+/*
+ * Columnar output.
+ *
+ * The values of the -e fields are written in batches of up to
+ * COLUMNAR_BATCH_ROWS packets, one typed vector per field, so that a
+ * reader can use them without parsing any text.  Everything is
+ * little-endian.
+ *
+ *   header:  "WSCOLS01", u32 number of fields, then for each field
+ *            u8 column type, u16 name length and the name
+ *   batch:   u32 number of rows (0 ends the output), then for each
+ *            field a validity bitmap of (rows + 7) / 8 bytes, bit
+ *            (row % 8) of byte (row / 8) set if the packet had the
+ *            field, followed by the values:
+ *
+ *     COLUMNAR_UINT, COLUMNAR_INT   u64 / i64 per row
+ *     COLUMNAR_DOUBLE               IEEE 754 double per row
+ *     COLUMNAR_TIME                 i64 nanoseconds per row
+ *     COLUMNAR_IPV4                 4 bytes, network order, per row
+ *     COLUMNAR_IPV6                 16 bytes per row
+ *     COLUMNAR_BYTES                u32 offsets[rows + 1], then the data
+ *     COLUMNAR_STRING               u32 dictionary size n, u32
+ *                                   offsets[n + 1], the strings, then
+ *                                   u32 dictionary index per row
+ *
+ * Missing values are zero in fixed-width vectors and empty otherwise.
+ * Each batch has its own dictionaries.  Only one occurrence of a field
+ * is kept per packet: the last one if -E occurrence=l was given, the
+ * first otherwise.
+ */
+#define COLUMNAR_MAGIC          "WSCOLS01"
+#define COLUMNAR_BATCH_ROWS     4096
+
+typedef enum {
+    COLUMNAR_UINT   = 1,
+    COLUMNAR_INT    = 2,
+    COLUMNAR_DOUBLE = 3,
+    COLUMNAR_TIME   = 4,
+    COLUMNAR_IPV4   = 5,
+    COLUMNAR_IPV6   = 6,
+    COLUMNAR_BYTES  = 7,
+    COLUMNAR_STRING = 8
+} columnar_type_e;
+
+typedef struct columnar_column_s {
+    columnar_type_e type;
+    GByteArray     *validity;
+    GByteArray     *values;     /* fixed-width values, bytes, or dictionary indexes */
+    GByteArray     *offsets;    /* u32 end offsets, for COLUMNAR_BYTES */
+    GHashTable     *dict;       /* string -> index + 1, for COLUMNAR_STRING */
+    GPtrArray      *dict_strings;
+} columnar_column_t;
+
+static columnar_type_e
+columnar_type_for_ftype(enum ftenum type)
+{
+    if (IS_FT_UINT(type) || type == FT_BOOLEAN || type == FT_EUI64)
+        return COLUMNAR_UINT;
+    if (IS_FT_INT(type))
+        return COLUMNAR_INT;
+    if (IS_FT_TIME(type))
+        return COLUMNAR_TIME;
+
+    switch (type) {
+    case FT_FLOAT:
+    case FT_DOUBLE:
+        return COLUMNAR_DOUBLE;
+    case FT_IPv4:
+        return COLUMNAR_IPV4;
+    case FT_IPv6:
+        return COLUMNAR_IPV6;
+    case FT_BYTES:
+    case FT_UINT_BYTES:
+    case FT_ETHER:
+    case FT_AX25:
+    case FT_VINES:
+    case FT_FCWWN:
+    case FT_OID:
+    case FT_REL_OID:
+    case FT_SYSTEM_ID:
+        return COLUMNAR_BYTES;
+    default:
+        return COLUMNAR_STRING;
+    }
+}
+
+static void
+columnar_append_u32(GByteArray *array, guint32 value)
+{
+    guint8 b[4];
+
+    b[0] = (guint8)value;
+    b[1] = (guint8)(value >> 8);
+    b[2] = (guint8)(value >> 16);
+    b[3] = (guint8)(value >> 24);
+    g_byte_array_append(array, b, sizeof b);
+}
+
+static void
+columnar_append_u64(GByteArray *array, guint64 value)
+{
+    columnar_append_u32(array, (guint32)value);
+    columnar_append_u32(array, (guint32)(value >> 32));
+}
+
+static void
+columnar_write_u32(FILE *fh, guint32 value)
+{
+    guint8 b[4];
+
+    b[0] = (guint8)value;
+    b[1] = (guint8)(value >> 8);
+    b[2] = (guint8)(value >> 16);
+    b[3] = (guint8)(value >> 24);
+    fwrite(b, 1, sizeof b, fh);
+}
+
+static void
+columnar_reset(columnar_column_t *column)
+{
+    g_byte_array_set_size(column->validity, 0);
+    g_byte_array_set_size(column->values, 0);
+    if (column->offsets != NULL) {
+        g_byte_array_set_size(column->offsets, 0);
+        columnar_append_u32(column->offsets, 0);
+    }
+    if (column->dict != NULL) {
+        g_hash_table_remove_all(column->dict);
+        g_ptr_array_set_size(column->dict_strings, 0);
+    }
+}
+
+static void
+columnar_free(output_fields_t *fields)
+{
+    gsize i;
+
+    for (i = 0; i < fields->fields->len; i++) {
+        columnar_column_t *column = &fields->columnar[i];
+
+        g_byte_array_free(column->validity, TRUE);
+        g_byte_array_free(column->values, TRUE);
+        if (column->offsets != NULL)
+            g_byte_array_free(column->offsets, TRUE);
+        if (column->dict != NULL) {
+            g_hash_table_destroy(column->dict);
+            g_ptr_array_free(column->dict_strings, TRUE);
+        }
+    }
+    g_free(fields->columnar);
+    g_free(fields->columnar_fi);
+    g_free(fields->columnar_col_data);
+    fields->columnar = NULL;
+}
+
+void write_columnar_preamble(output_fields_t* fields, FILE *fh)
+{
+    gsize i;
+
+    g_assert(fields);
+    g_assert(fh);
+    g_assert(fields->fields);
+
+    prepare_field_indicies(fields);
+    fields->columnar = g_new0(columnar_column_t, fields->fields->len);
+    fields->columnar_fi = g_new0(field_info *, fields->fields->len);
+    fields->columnar_col_data = g_new0(const gchar *, fields->fields->len);
+    fields->columnar_rows = 0;
+
+    fwrite(COLUMNAR_MAGIC, 1, strlen(COLUMNAR_MAGIC), fh);
+    columnar_write_u32(fh, fields->fields->len);
+
+    for (i = 0; i < fields->fields->len; i++) {
+        const gchar       *field = (const gchar *)g_ptr_array_index(fields->fields, i);
+        columnar_column_t *column = &fields->columnar[i];
+        header_field_info *hfinfo;
+        guint8             b[3];
+        size_t             len;
+
+        if (strncmp(field, COLUMN_FIELD_FILTER, strlen(COLUMN_FIELD_FILTER)) == 0 ||
+            (hfinfo = proto_registrar_get_byname(field)) == NULL)
+            column->type = COLUMNAR_STRING;
+        else
+            column->type = columnar_type_for_ftype(hfinfo->type);
+
+        column->validity = g_byte_array_new();
+        column->values = g_byte_array_new();
+        if (column->type == COLUMNAR_BYTES)
+            column->offsets = g_byte_array_new();
+        if (column->type == COLUMNAR_STRING) {
+            column->dict = g_hash_table_new(g_str_hash, g_str_equal);
+            column->dict_strings = g_ptr_array_new_with_free_func(g_free);
+        }
+        columnar_reset(column);
+
+        len = MIN(strlen(field), G_MAXUINT16);
+        b[0] = (guint8)column->type;
+        b[1] = (guint8)len;
+        b[2] = (guint8)(len >> 8);
+        fwrite(b, 1, sizeof b, fh);
+        fwrite(field, 1, len, fh);
+    }
+}
+
+static void
+columnar_append_string(columnar_column_t *column, const gchar *str)
+{
+    gpointer index_p;
+    guint32  index;
+
+    index_p = g_hash_table_lookup(column->dict, str);
+    if (index_p == NULL) {
+        gchar *copy = g_strdup(str);
+
+        g_ptr_array_add(column->dict_strings, copy);
+        index = column->dict_strings->len - 1;
+        g_hash_table_insert(column->dict, copy, GUINT_TO_POINTER(index + 1));
+    } else {
+        index = GPOINTER_TO_UINT(index_p) - 1;
+    }
+    columnar_append_u32(column->values, index);
+}
+
+/* Append a row to the column; fi and col_data are both NULL for no value */
+static void
+columnar_append(columnar_column_t *column, guint row, field_info *fi,
+                const gchar *col_data, epan_dissect_t *edt)
+{
+    gboolean valid;
+    guint64  u;
+    gdouble  d;
+    nstime_t *ts;
+    guint32  ipv4;
+    gchar   *str;
+
+    /* A field with the same name as another but of a different type can't go in its column */
+    valid = col_data != NULL ||
+            (fi != NULL && (column->type == COLUMNAR_STRING ||
+                            columnar_type_for_ftype(fi->hfinfo->type) == column->type));
+
+    if (row % 8 == 0)
+        g_byte_array_append(column->validity, (const guint8 *)"", 1);
+    if (valid)
+        column->validity->data[row / 8] |= 1 << (row % 8);
+
+    switch (column->type) {
+    case COLUMNAR_UINT:
+        u = 0;
+        if (valid) {
+            if (IS_FT_UINT32(fi->hfinfo->type))
+                u = fvalue_get_uinteger(&fi->value);
+            else
+                u = fvalue_get_uinteger64(&fi->value);
+        }
+        columnar_append_u64(column->values, u);
+        break;
+    case COLUMNAR_INT:
+        u = 0;
+        if (valid) {
+            if (fi->hfinfo->type == FT_INT40 || fi->hfinfo->type == FT_INT48 ||
+                fi->hfinfo->type == FT_INT56 || fi->hfinfo->type == FT_INT64)
+                u = (guint64)fvalue_get_sinteger64(&fi->value);
+            else
+                u = (guint64)(gint64)fvalue_get_sinteger(&fi->value);
+        }
+        columnar_append_u64(column->values, u);
+        break;
+    case COLUMNAR_DOUBLE:
+        d = valid ? fvalue_get_floating(&fi->value) : 0.0;
+        memcpy(&u, &d, sizeof u);
+        columnar_append_u64(column->values, u);
+        break;
+    case COLUMNAR_TIME:
+        u = 0;
+        if (valid) {
+            ts = (nstime_t *)fvalue_get(&fi->value);
+            u = (guint64)((gint64)ts->secs * 1000000000 + ts->nsecs);
+        }
+        columnar_append_u64(column->values, u);
+        break;
+    case COLUMNAR_IPV4:
+        ipv4 = valid ? g_htonl(((ipv4_addr_and_mask *)fvalue_get(&fi->value))->addr) : 0;
+        g_byte_array_append(column->values, (const guint8 *)&ipv4, 4);
+        break;
+    case COLUMNAR_IPV6:
+        if (valid)
+            g_byte_array_append(column->values, (const guint8 *)fvalue_get(&fi->value), 16);
+        else
+            g_byte_array_append(column->values, (const guint8 *)"\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0", 16);
+        break;
+    case COLUMNAR_BYTES:
+        if (valid)
+            g_byte_array_append(column->values, (const guint8 *)fvalue_get(&fi->value),
+                                fvalue_length(&fi->value));
+        columnar_append_u32(column->offsets, column->values->len);
+        break;
+    case COLUMNAR_STRING:
+        if (col_data != NULL) {
+            columnar_append_string(column, col_data);
+        } else if (valid) {
+            str = get_node_field_value(fi, edt);
+            columnar_append_string(column, str);
+            g_free(str);
+        } else {
+            columnar_append_u32(column->values, 0);
+        }
+        break;
+    }
+}
+
+static void
+columnar_write_batch(output_fields_t *fields, FILE *fh)
+{
+    gsize i, j;
+
+    columnar_write_u32(fh, fields->columnar_rows);
+
+    for (i = 0; i < fields->fields->len; i++) {
+        columnar_column_t *column = &fields->columnar[i];
+
+        fwrite(column->validity->data, 1, column->validity->len, fh);
+        if (column->type == COLUMNAR_BYTES) {
+            fwrite(column->offsets->data, 1, column->offsets->len, fh);
+        } else if (column->type == COLUMNAR_STRING) {
+            guint32 offset = 0;
+
+            columnar_write_u32(fh, column->dict_strings->len);
+            columnar_write_u32(fh, 0);
+            for (j = 0; j < column->dict_strings->len; j++) {
+                offset += (guint32)strlen((const gchar *)g_ptr_array_index(column->dict_strings, j));
+                columnar_write_u32(fh, offset);
+            }
+            for (j = 0; j < column->dict_strings->len; j++) {
+                fputs((const gchar *)g_ptr_array_index(column->dict_strings, j), fh);
+            }
+        }
+        fwrite(column->values->data, 1, column->values->len, fh);
+        columnar_reset(column);
+    }
+    fields->columnar_rows = 0;
+}
+
+static void proto_tree_get_node_columnar_values(proto_node *node, gpointer data)
+{
+    output_fields_t *fields = (output_fields_t *)data;
+    field_info      *fi = PNODE_FINFO(node);
+    gpointer         field_index;
+    guint            indx;
+
+    /* dissection with an invisible proto tree? */
+    g_assert(fi);
+
+    field_index = g_hash_table_lookup(fields->field_indicies, fi->hfinfo->abbrev);
+    if (NULL != field_index) {
+        indx = GPOINTER_TO_UINT(field_index) - 1;
+        if (fields->columnar_fi[indx] == NULL || fields->occurrence == 'l')
+            fields->columnar_fi[indx] = fi;
+    }
+
+    /* Recurse here. */
+    if (node->first_child != NULL) {
+        proto_tree_children_foreach(node, proto_tree_get_node_columnar_values,
+                                    fields);
+    }
+}
+
+void write_columnar_proto_tree(output_fields_t* fields, epan_dissect_t *edt, column_info *cinfo, FILE *fh)
+{
+    gsize     i;
+    gint      col;
+    gchar    *col_name;
+    gpointer  field_index;
+
+    g_assert(fields);
+    g_assert(fields->columnar);
+    g_assert(edt);
+    g_assert(fh);
+
+    memset(fields->columnar_fi, 0, fields->fields->len * sizeof *fields->columnar_fi);
+    memset(fields->columnar_col_data, 0, fields->fields->len * sizeof *fields->columnar_col_data);
+
+    if (use_field_ids(fields)) {
+        for (i = 0; i < fields->fields->len; i++) {
+            GPtrArray *finfos;
+
+            if (fields->field_ids[i] < 0)
+                continue;
+            finfos = proto_get_finfo_ptr_array(edt->tree, fields->field_ids[i]);
+            if (finfos == NULL)
+                continue;
+            fields->columnar_fi[i] = (field_info *)g_ptr_array_index(finfos,
+                fields->occurrence == 'l' ? finfos->len - 1 : 0);
+        }
+    } else {
+        proto_tree_children_foreach(edt->tree, proto_tree_get_node_columnar_values,
+                                    fields);
+    }
+
+    if (fields->includes_col_fields) {
+        for (col = 0; col < cinfo->num_cols; col++) {
+            /* Prepend COLUMN_FIELD_FILTER as the field name */
+            col_name = g_strdup_printf("%s%s", COLUMN_FIELD_FILTER, cinfo->columns[col].col_title);
+            field_index = g_hash_table_lookup(fields->field_indicies, col_name);
+            g_free(col_name);
+
+            if (NULL != field_index) {
+                fields->columnar_col_data[GPOINTER_TO_UINT(field_index) - 1] = cinfo->columns[col].col_data;
+            }
+        }
+    }
+
+    for (i = 0; i < fields->fields->len; i++) {
+        columnar_append(&fields->columnar[i], fields->columnar_rows,
+                        fields->columnar_fi[i], fields->columnar_col_data[i], edt);
+    }
+
+    if (++fields->columnar_rows == COLUMNAR_BATCH_ROWS) {
+        columnar_write_batch(fields, fh);
+    }
+}
+
+void write_columnar_finale(output_fields_t* fields, FILE *fh)
+{
+    g_assert(fields);
+    g_assert(fields->columnar);
+    g_assert(fh);
+
+    if (fields->columnar_rows > 0) {
+        columnar_write_batch(fields, fh);
+    }
+    /* An empty batch marks the end of the output */
+    columnar_write_u32(fh, 0);
+}
+
 /* Returns an g_malloced string */
 gchar* get_node_field_value(field_info* fi, epan_dissect_t* edt)
 {
@@ -2659,9 +3256,16 @@ output_fields_t* output_fields_new(void)
     fields->aggregator          = ',';
     fields->fields              = NULL; /*Do lazy initialisation */
     fields->field_indicies      = NULL;
+    fields->field_ids           = NULL;
+    fields->field_ids_usable    = FALSE;
+    fields->primed              = FALSE;
     fields->field_values        = NULL;
     fields->quote               ='\0';
     fields->includes_col_fields = FALSE;
+    fields->columnar            = NULL;
+    fields->columnar_fi         = NULL;
+    fields->columnar_col_data   = NULL;
+    fields->columnar_rows       = 0;
     return fields;
 }
 
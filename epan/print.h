@@ -81,6 +81,12 @@ WS_DLL_PUBLIC gsize output_fields_num_fields(output_fields_t* info);
 WS_DLL_PUBLIC gboolean output_fields_set_option(output_fields_t* info, gchar* option);
 WS_DLL_PUBLIC void output_fields_list_options(FILE *fh);
 WS_DLL_PUBLIC gboolean output_fields_has_cols(output_fields_t* info);
+/** Check whether printing the fields needs the item labels of a visible
+ *  tree; if not the fields can be printed from an invisible tree that
+ *  has been primed with output_fields_prime_edt(). */
+WS_DLL_PUBLIC gboolean output_fields_need_visible_tree(output_fields_t* info);
+/** Prime an epan_dissect_t with the fields to be printed. */
+WS_DLL_PUBLIC void output_fields_prime_edt(output_fields_t* info, epan_dissect_t *edt);
 
 /*
  * Higher-level packet-printing code.
@@ -134,6 +140,11 @@ WS_DLL_PUBLIC void write_fields_preamble(output_fields_t* fields, FILE *fh);
 WS_DLL_PUBLIC void write_fields_proto_tree(output_fields_t* fields, epan_dissect_t *edt, column_info *cinfo, FILE *fh);
 WS_DLL_PUBLIC void write_fields_finale(output_fields_t* fields, FILE *fh);
 
+/* Typed, batched binary output of the fields; the format is described in print.c */
+WS_DLL_PUBLIC void write_columnar_preamble(output_fields_t* fields, FILE *fh);
+WS_DLL_PUBLIC void write_columnar_proto_tree(output_fields_t* fields, epan_dissect_t *edt, column_info *cinfo, FILE *fh);
+WS_DLL_PUBLIC void write_columnar_finale(output_fields_t* fields, FILE *fh);
+
 WS_DLL_PUBLIC gchar* get_node_field_value(field_info* fi, epan_dissect_t* edt);
 
 extern void print_cache_field_handles(void);
@@ -131,6 +131,8 @@ struct ptvcursor {
 			wmem_strdup_printf(wmem_packet_scope(), "More than %d items in the tree -- possible infinite loop", MAX_TREE_ITEMS)); \
 	}								\
 	PROTO_REGISTRAR_GET_NTH(hfindex, hfinfo);			\
+	if (hfinfo->type == FT_PROTOCOL)				\
+		proto_tree_note_protocol(tree, hfinfo->id);		\
 	if (!(PTREE_DATA(tree)->visible)) {				\
 		if (PTREE_FINFO(tree)) {				\
 			if ((hfinfo->ref_type != HF_REF_TYPE_DIRECT)	\
@@ -345,20 +347,111 @@ static GPtrArray *deregistered_data = NULL;
 /* indexed by prefix, contains initializers */
 static GHashTable* prefixes = NULL;
 
+/* proto_nodes and field_infos are carved out of fixed-size slabs that
+ * belong to the tree.  proto_tree_reset() just rewinds them, so a tree
+ * that is reused for packet after packet doesn't go back to the
+ * allocator for every item, and consecutive items sit next to each
+ * other in memory. */
+#define PROTO_SLAB_ITEMS	256	/* elements per slab block */
+#define PROTO_SLAB_KEEP_BLOCKS	64	/* blocks kept across a reset */
+
+typedef struct {
+	GPtrArray *blocks;	/* each holds PROTO_SLAB_ITEMS elements */
+	gsize      elem_size;
+	guint      block;	/* index of the block being carved up */
+	guint      used;	/* elements handed out from that block */
+	guint      count;	/* elements handed out since the last reset */
+} proto_slab_t;
+
+struct _proto_tree_slabs {
+	proto_slab_t nodes;
+	proto_slab_t finfos;
+	/* field_infos whose fvalue owns memory, so proto_tree_reset()
+	 * can release it without walking the whole tree */
+	GPtrArray   *cleanup;
+	/* arrays of interesting_hfids that got fields in this dissection;
+	 * the arrays are kept across resets and only emptied */
+	GPtrArray   *interesting_used;
+	/* ids of the FT_PROTOCOL items added to the tree, faked or not */
+	GArray      *protocols;
+};
+
+static void
+proto_tree_note_protocol(proto_tree *tree, int proto_id)
+{
+	GArray *protocols = PTREE_DATA(tree)->slabs->protocols;
+
+	/* Most are added once, right after the previous protocol's */
+	if (protocols->len == 0 ||
+	    g_array_index(protocols, int, protocols->len - 1) != proto_id)
+		g_array_append_val(protocols, proto_id);
+}
+
+static void
+proto_slab_init(proto_slab_t *slab, gsize elem_size)
+{
+	slab->blocks    = g_ptr_array_new();
+	slab->elem_size = elem_size;
+	slab->block     = 0;
+	slab->used      = 0;
+	slab->count     = 0;
+}
+
+static void *
+proto_slab_alloc(proto_slab_t *slab)
+{
+	guint8 *block;
+
+	if (slab->used == PROTO_SLAB_ITEMS) {
+		slab->block++;
+		slab->used = 0;
+	}
+	if (slab->block == slab->blocks->len)
+		g_ptr_array_add(slab->blocks,
+				g_malloc(slab->elem_size * PROTO_SLAB_ITEMS));
+
+	block = (guint8 *)g_ptr_array_index(slab->blocks, slab->block);
+	slab->count++;
+	return block + slab->elem_size * slab->used++;
+}
+
+static void
+proto_slab_reset(proto_slab_t *slab)
+{
+	/* Don't hang on to everything an unusually big packet needed */
+	while (slab->blocks->len > PROTO_SLAB_KEEP_BLOCKS)
+		g_free(g_ptr_array_remove_index_fast(slab->blocks,
+						     slab->blocks->len - 1));
+
+	slab->block = 0;
+	slab->used  = 0;
+	slab->count = 0;
+}
+
+static void
+proto_slab_free(proto_slab_t *slab)
+{
+	guint i;
+
+	for (i = 0; i < slab->blocks->len; i++)
+		g_free(g_ptr_array_index(slab->blocks, i));
+	g_ptr_array_free(slab->blocks, TRUE);
+}
+
 /* Contains information about a field when a dissector calls
  * proto_tree_add_item.  */
-#define FIELD_INFO_NEW(pool, fi)  fi = wmem_new(pool, field_info)
-#define FIELD_INFO_FREE(pool, fi) wmem_free(pool, fi)
+#define FIELD_INFO_NEW(tree, fi)  \
+	fi = (field_info *)proto_slab_alloc(&PTREE_DATA(tree)->slabs->finfos)
 
 /* Contains the space for proto_nodes. */
+#define PROTO_NODE_NEW(tree, node)  \
+	node = (proto_node *)proto_slab_alloc(&PTREE_DATA(tree)->slabs->nodes)
+
 #define PROTO_NODE_INIT(node)			\
 	node->first_child = NULL;		\
 	node->last_child = NULL;		\
 	node->next = NULL;
 
-#define PROTO_NODE_FREE(pool, node)			\
-	wmem_free(pool, node)
-
 /* String space for protocol and field items for the GUI */
 #define ITEM_LABEL_NEW(pool, il)			\
 	il = wmem_new(pool, item_label_t);
@@ -381,6 +474,14 @@ typedef struct _gpa_hfinfo_t {
 
 static gpa_hfinfo_t gpa_hfinfo;
 
+/*
+ * Extended value strings built at registration time for integer fields
+ * with long, sorted, plain value_string arrays, indexed by field ID, so
+ * that labelling those fields doesn't scan the array linearly.
+ */
+#define FIELD_VS_EXT_MIN_ENTRIES 16
+static GPtrArray *field_vs_ext = NULL;
+
 /* Hash table of abbreviations and IDs */
 static GHashTable *gpa_name_map = NULL;
 static header_field_info *same_name_hfinfo;
@@ -391,6 +492,33 @@ static header_field_info *same_name_hfinfo;
 static char *last_field_name = NULL;
 static header_field_info *last_hfinfo;
 
+/*
+ * The registered abbreviations sorted case-insensitively, for prefix
+ * lookups (filter completion).  Built on first use, and thrown away
+ * whenever a field is registered or deregistered.
+ */
+static GPtrArray *gpa_prefix_index = NULL;
+
+static void
+prefix_index_invalidate(void)
+{
+	if (gpa_prefix_index) {
+		g_ptr_array_free(gpa_prefix_index, TRUE);
+		gpa_prefix_index = NULL;
+	}
+}
+
+/* Bumped whenever a field is registered or deregistered */
+static guint registrar_generation = 0;
+
+/* Called whenever the set of registered fields changes */
+static void
+registrar_changed(void)
+{
+	prefix_index_invalidate();
+	registrar_generation++;
+}
+
 static void save_same_name_hfinfo(gpointer data)
 {
 	same_name_hfinfo = (header_field_info*)data;
@@ -603,6 +731,7 @@ proto_cleanup_base(void)
 	}
 	g_free(last_field_name);
 	last_field_name = NULL;
+	registrar_changed();
 
 	while (protocols) {
 		protocol = (protocol_t *)protocols->data;
@@ -656,6 +785,12 @@ proto_cleanup_base(void)
 		deregistered_fields = NULL;
 	}
 
+	if (field_vs_ext) {
+		/* The value_string_exts themselves are in epan scope */
+		g_ptr_array_free(field_vs_ext, TRUE);
+		field_vs_ext = NULL;
+	}
+
 	if (deregistered_data) {
 		g_ptr_array_free(deregistered_data, FALSE);
 		deregistered_data = NULL;
@@ -753,13 +888,8 @@ proto_tree_children_foreach(proto_tree *tree, proto_tree_foreach_func func,
 }
 
 static void
-free_GPtrArray_value(gpointer key, gpointer value, gpointer user_data _U_)
+unreference_hfinfo(header_field_info *hfinfo)
 {
-	GPtrArray         *ptrs = (GPtrArray *)value;
-	gint               hfid = GPOINTER_TO_UINT(key);
-	header_field_info *hfinfo;
-
-	PROTO_REGISTRAR_GET_NTH(hfid, hfinfo);
 	if (hfinfo->ref_type != HF_REF_TYPE_NONE) {
 		/* when a field is referenced by a filter this also
 		   affects the refcount for the parent protocol so we need
@@ -772,18 +902,52 @@ free_GPtrArray_value(gpointer key, gpointer value, gpointer user_data _U_)
 		}
 		hfinfo->ref_type = HF_REF_TYPE_NONE;
 	}
+}
+
+static void
+free_GPtrArray_value(gpointer key, gpointer value, gpointer user_data _U_)
+{
+	GPtrArray         *ptrs = (GPtrArray *)value;
+	gint               hfid = GPOINTER_TO_UINT(key);
+	header_field_info *hfinfo;
+
+	/* Empty arrays are left over from earlier dissections; their
+	 * fields have been unreferenced when the tree was reset */
+	if (ptrs->len > 0) {
+		PROTO_REGISTRAR_GET_NTH(hfid, hfinfo);
+		unreference_hfinfo(hfinfo);
+	}
 
 	g_ptr_array_free(ptrs, TRUE);
 }
 
+/* Empty the interesting_hfids arrays that got fields, without freeing
+ * them, so the next dissection needn't allocate them again. */
 static void
-proto_tree_free_node(proto_node *node, gpointer data _U_)
+proto_tree_reset_interesting(struct _proto_tree_slabs *slabs)
 {
-	field_info *finfo  = PNODE_FINFO(node);
+	GPtrArray *ptrs;
+	guint      i;
 
-	proto_tree_children_foreach(node, proto_tree_free_node, NULL);
+	for (i = 0; i < slabs->interesting_used->len; i++) {
+		ptrs = (GPtrArray *)g_ptr_array_index(slabs->interesting_used, i);
+		unreference_hfinfo(((field_info *)g_ptr_array_index(ptrs, 0))->hfinfo);
+		g_ptr_array_set_size(ptrs, 0);
+	}
+	g_ptr_array_set_size(slabs->interesting_used, 0);
+}
 
-	FVALUE_CLEANUP(&finfo->value);
+static void
+proto_tree_cleanup_values(struct _proto_tree_slabs *slabs)
+{
+	field_info *finfo;
+	guint       i;
+
+	for (i = 0; i < slabs->cleanup->len; i++) {
+		finfo = (field_info *)g_ptr_array_index(slabs->cleanup, i);
+		FVALUE_CLEANUP(&finfo->value);
+	}
+	g_ptr_array_set_size(slabs->cleanup, 0);
 }
 
 void
@@ -791,17 +955,12 @@ proto_tree_reset(proto_tree *tree)
 {
 	tree_data_t *tree_data = PTREE_DATA(tree);
 
-	proto_tree_children_foreach(tree, proto_tree_free_node, NULL);
-
-	/* free tree data */
-	if (tree_data->interesting_hfids) {
-		/* Free all the GPtrArray's in the interesting_hfids hash. */
-		g_hash_table_foreach(tree_data->interesting_hfids,
-			free_GPtrArray_value, NULL);
-
-		/* And then remove all values. */
-		g_hash_table_remove_all(tree_data->interesting_hfids);
-	}
+	/* Empty the arrays before the finfos they point to get reused */
+	proto_tree_reset_interesting(tree_data->slabs);
+	proto_tree_cleanup_values(tree_data->slabs);
+	proto_slab_reset(&tree_data->slabs->nodes);
+	proto_slab_reset(&tree_data->slabs->finfos);
+	g_array_set_size(tree_data->slabs->protocols, 0);
 
 	/* Reset track of the number of children */
 	tree_data->count = 0;
@@ -815,7 +974,10 @@ proto_tree_free(proto_tree *tree)
 {
 	tree_data_t *tree_data = PTREE_DATA(tree);
 
-	proto_tree_children_foreach(tree, proto_tree_free_node, NULL);
+	proto_tree_cleanup_values(tree_data->slabs);
+	proto_slab_free(&tree_data->slabs->nodes);
+	proto_slab_free(&tree_data->slabs->finfos);
+	g_ptr_array_free(tree_data->slabs->cleanup, TRUE);
 
 	/* free tree data */
 	if (tree_data->interesting_hfids) {
@@ -826,6 +988,9 @@ proto_tree_free(proto_tree *tree)
 		/* And then destroy the hash. */
 		g_hash_table_destroy(tree_data->interesting_hfids);
 	}
+	g_ptr_array_free(tree_data->slabs->interesting_used, TRUE);
+	g_array_free(tree_data->slabs->protocols, TRUE);
+	g_slice_free(struct _proto_tree_slabs, tree_data->slabs);
 
 	g_slice_free(tree_data_t, tree_data);
 
@@ -852,6 +1017,12 @@ proto_tree_set_fake_protocols(proto_tree *tree, gboolean fake_protocols)
 	PTREE_DATA(tree)->fake_protocols = fake_protocols;
 }
 
+void
+proto_tree_set_field_demand(proto_tree *tree, gboolean field_demand)
+{
+	PTREE_DATA(tree)->field_demand = field_demand;
+}
+
 /* Assume dissector set only its protocol fields.
    This function is called by dissectors and allows the speeding up of filtering
    in wireshark; if this function returns FALSE it is safe to reset tree to NULL
@@ -881,6 +1052,30 @@ proto_field_is_referenced(proto_tree *tree, int proto_id)
 	return FALSE;
 }
 
+/* Stricter variant of proto_field_is_referenced() for dissectors that want
+   to skip decoding a PDU body entirely: when field demand is on, an
+   invisible tree without columns only needs the bodies of protocols that
+   have primed fields.  A NULL tree tells us nothing about what the
+   application wants, so the body is always needed then.
+*/
+gboolean
+proto_protocol_body_is_needed(proto_tree *tree, int proto_id)
+{
+	tree_data_t *tree_data;
+
+	if (!tree)
+		return TRUE;
+
+	tree_data = PTREE_DATA(tree);
+	if (!tree_data->field_demand)
+		return TRUE;
+
+	if (tree_data->pinfo && tree_data->pinfo->cinfo)
+		return TRUE;
+
+	return proto_field_is_referenced(tree, proto_id);
+}
+
 
 /* Finds a record in the hfinfo array by id. */
 header_field_info *
@@ -2081,6 +2276,8 @@ tree_data_add_maybe_interesting_field(tree_data_t *tree_data, field_info *fi)
 			g_hash_table_insert(tree_data->interesting_hfids,
 					    GINT_TO_POINTER(hfinfo->id), ptrs);
 		}
+		if (ptrs->len == 0)
+			g_ptr_array_add(tree_data->slabs->interesting_used, ptrs);
 
 		g_ptr_array_add(ptrs, fi);
 	}
@@ -5134,7 +5331,7 @@ proto_tree_add_node(proto_tree *tree, field_info *fi)
 		/* XXX - is it safe to continue here? */
 	}
 
-	pnode = wmem_new(PNODE_POOL(tree), proto_node);
+	PROTO_NODE_NEW(tree, pnode);
 	PROTO_NODE_INIT(pnode);
 	pnode->parent = tnode;
 	PNODE_FINFO(pnode) = fi;
@@ -5450,7 +5647,7 @@ new_field_info(proto_tree *tree, header_field_info *hfinfo, tvbuff_t *tvb,
 {
 	field_info *fi;
 
-	FIELD_INFO_NEW(PNODE_POOL(tree), fi);
+	FIELD_INFO_NEW(tree, fi);
 
 	fi->hfinfo     = hfinfo;
 	fi->start      = start;
@@ -5461,6 +5658,8 @@ new_field_info(proto_tree *tree, header_field_info *hfinfo, tvbuff_t *tvb,
 	if (!PTREE_DATA(tree)->visible)
 		FI_SET_FLAG(fi, FI_HIDDEN);
 	fvalue_init(&fi->value, fi->hfinfo->type);
+	if (fi->value.ftype->free_value)
+		g_ptr_array_add(PTREE_DATA(tree)->slabs->cleanup, fi);
 	fi->rep        = NULL;
 
 	/* add the data source tvbuff */
@@ -5641,10 +5840,12 @@ proto_custom_set(proto_tree* tree, GSList *field_ids, gint occurrence,
 	char *tmpbuf, *str;
 	int *field_idx;
 	int field_id;
-	int ii = 0;
+	GSList *field_id_entry;
 
 	g_assert(field_ids != NULL);
-	while ((field_idx = (int *) g_slist_nth_data(field_ids, ii++))) {
+	for (field_id_entry = field_ids;
+	     field_id_entry != NULL && (field_idx = (int *) field_id_entry->data) != NULL;
+	     field_id_entry = field_id_entry->next) {
 		field_id = *field_idx;
 		PROTO_REGISTRAR_GET_NTH((guint)field_id, hfinfo);
 
@@ -6305,12 +6506,40 @@ proto_tree_create_root(packet_info *pinfo)
 	/* Make sure that we fake protocols (if possible) */
 	pnode->tree_data->fake_protocols = TRUE;
 
+	/* Dissect everything unless told only the primed fields matter */
+	pnode->tree_data->field_demand = FALSE;
+
 	/* Keep track of the number of children */
 	pnode->tree_data->count = 0;
 
+	pnode->tree_data->slabs = g_slice_new(struct _proto_tree_slabs);
+	proto_slab_init(&pnode->tree_data->slabs->nodes, sizeof(proto_node));
+	proto_slab_init(&pnode->tree_data->slabs->finfos, sizeof(field_info));
+	pnode->tree_data->slabs->cleanup = g_ptr_array_new();
+	pnode->tree_data->slabs->interesting_used = g_ptr_array_new();
+	pnode->tree_data->slabs->protocols = g_array_new(FALSE, FALSE, sizeof(int));
+
 	return (proto_tree *)pnode;
 }
 
+const int *
+proto_tree_get_protocols(proto_tree *tree, guint *num_protocols)
+{
+	GArray *protocols = PTREE_DATA(tree)->slabs->protocols;
+
+	*num_protocols = protocols->len;
+	return (const int *)(void *)protocols->data;
+}
+
+guint
+proto_tree_get_nodes_allocated(proto_tree *tree)
+{
+	if (!tree)
+		return 0;
+
+	return PTREE_DATA(tree)->slabs->nodes.count;
+}
+
 
 /* "prime" a proto_tree with a single hfid that a dfilter
  * is interested in. */
@@ -6678,6 +6907,8 @@ proto_deregister_protocol(const char *short_name)
 	if (protocol == NULL)
 		return FALSE;
 
+	registrar_changed();
+
 	key = wrs_str_hash(protocol->name);
 	g_hash_table_remove(proto_names, &key);
 
@@ -6783,6 +7014,83 @@ proto_get_next_protocol_field(const int proto_id, void **cookie)
 	return (header_field_info *)g_ptr_array_index(protocol->fields, i);
 }
 
+static gint
+prefix_index_compare(gconstpointer a, gconstpointer b)
+{
+	const header_field_info *hfinfo_a = *(const header_field_info * const *)a;
+	const header_field_info *hfinfo_b = *(const header_field_info * const *)b;
+
+	return g_ascii_strcasecmp(hfinfo_a->abbrev, hfinfo_b->abbrev);
+}
+
+static void
+prefix_index_build(void)
+{
+	guint i;
+
+	gpa_prefix_index = g_ptr_array_sized_new(gpa_hfinfo.len);
+
+	for (i = 0; i < gpa_hfinfo.len; i++) {
+		header_field_info *hfinfo = gpa_hfinfo.hfi[i];
+
+		if (hfinfo == NULL || hfinfo->abbrev[0] == '\0')
+			continue;
+
+		if (hfinfo->same_name_prev_id != -1) /* one entry per name */
+			continue;
+
+		/* deregistered, but not freed yet */
+		if (g_hash_table_lookup(gpa_name_map, hfinfo->abbrev) == NULL)
+			continue;
+
+		g_ptr_array_add(gpa_prefix_index, hfinfo);
+	}
+
+	g_ptr_array_sort(gpa_prefix_index, prefix_index_compare);
+}
+
+void
+proto_registrar_foreach_prefix(const char *prefix, GFunc func, gpointer user_data)
+{
+	const size_t prefix_len = strlen(prefix);
+	guint lo, hi;
+
+	if (!gpa_prefix_index)
+		prefix_index_build();
+
+	/* find the first abbreviation not less than the prefix ... */
+	lo = 0;
+	hi = gpa_prefix_index->len;
+	while (lo < hi) {
+		guint mid = lo + (hi - lo) / 2;
+		header_field_info *hfinfo = (header_field_info *)g_ptr_array_index(gpa_prefix_index, mid);
+
+		if (g_ascii_strcasecmp(hfinfo->abbrev, prefix) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	/* ... the ones starting with the prefix follow it */
+	for (; lo < gpa_prefix_index->len; lo++) {
+		header_field_info *hfinfo = (header_field_info *)g_ptr_array_index(gpa_prefix_index, lo);
+		protocol_t *protocol;
+
+		if (g_ascii_strncasecmp(hfinfo->abbrev, prefix, prefix_len) != 0)
+			break;
+
+		if (hfinfo->parent == -1)
+			protocol = (protocol_t *)hfinfo->strings;
+		else
+			protocol = find_protocol_by_id(hfinfo->parent);
+
+		if (!proto_is_protocol_enabled(protocol))
+			continue;
+
+		func(hfinfo, user_data);
+	}
+}
+
 protocol_t *
 find_protocol_by_id(const int proto_id)
 {
@@ -7170,6 +7478,7 @@ proto_deregister_field (const int parent, gint hf_id)
 
 	g_free(last_field_name);
 	last_field_name = NULL;
+	registrar_changed();
 
 	if (hf_id == -1 || hf_id == 0)
 		return;
@@ -7259,6 +7568,12 @@ free_deregistered_field (gpointer data, gpointer user_data _U_)
 		}
 	}
 
+	if (field_vs_ext && (guint)hf_id < field_vs_ext->len &&
+	    g_ptr_array_index(field_vs_ext, hf_id)) {
+		value_string_ext_free((value_string_ext *)g_ptr_array_index(field_vs_ext, hf_id));
+		g_ptr_array_index(field_vs_ext, hf_id) = NULL;
+	}
+
 	if (hfi->parent == -1)
 		g_slice_free(header_field_info, hfi);
 
@@ -7277,6 +7592,8 @@ proto_free_deregistered_fields (void)
 {
 	expert_free_deregistered_expertinfos();
 
+	registrar_changed();
+
 	g_ptr_array_foreach(deregistered_fields, free_deregistered_field, NULL);
 	g_ptr_array_free(deregistered_fields, TRUE);
 	deregistered_fields = g_ptr_array_new();
@@ -7893,6 +8210,54 @@ register_number_string_decoding_error(void)
 }
 
 #define PROTO_PRE_ALLOC_HF_FIELDS_MEM (188000+PRE_ALLOC_EXPERT_FIELDS_MEM)
+/*
+ * If hfinfo is an integer field labelled from a plain value_string array
+ * with at least FIELD_VS_EXT_MIN_ENTRIES entries in strictly ascending
+ * order, remember a value_string_ext for it, which will use an index or
+ * binary search lookup. Unsorted arrays keep the linear search, as
+ * try_val_to_str() returns the first match.
+ */
+static void
+field_vs_ext_init(const header_field_info *hfinfo)
+{
+	const value_string *vs;
+	guint num_entries;
+
+	switch (hfinfo->type) {
+	case FT_CHAR:
+	case FT_UINT8:
+	case FT_UINT16:
+	case FT_UINT24:
+	case FT_UINT32:
+	case FT_INT8:
+	case FT_INT16:
+	case FT_INT24:
+	case FT_INT32:
+		break;
+	default:
+		return;
+	}
+
+	if (hfinfo->strings == NULL || (hfinfo->display & FIELD_DISPLAY_E_MASK) == BASE_CUSTOM ||
+	    (hfinfo->display & (BASE_RANGE_STRING|BASE_EXT_STRING|BASE_VAL64_STRING|BASE_UNIT_STRING)))
+		return;
+
+	vs = (const value_string *)hfinfo->strings;
+	for (num_entries = 0; vs[num_entries].strptr != NULL; num_entries++) {
+		if (num_entries > 0 && vs[num_entries].value <= vs[num_entries-1].value)
+			return;
+	}
+	if (num_entries < FIELD_VS_EXT_MIN_ENTRIES)
+		return;
+
+	if (!field_vs_ext)
+		field_vs_ext = g_ptr_array_new();
+	if ((guint)hfinfo->id >= field_vs_ext->len)
+		g_ptr_array_set_size(field_vs_ext, hfinfo->id + 1);
+	g_ptr_array_index(field_vs_ext, hfinfo->id) =
+		value_string_ext_new(vs, num_entries + 1, hfinfo->abbrev);
+}
+
 static int
 proto_register_field_init(header_field_info *hfinfo, const int parent)
 {
@@ -7903,6 +8268,8 @@ proto_register_field_init(header_field_info *hfinfo, const int parent)
 	hfinfo->same_name_next = NULL;
 	hfinfo->same_name_prev_id = -1;
 
+	registrar_changed();
+
 	/* if we always add and never delete, then id == len - 1 is correct */
 	if (gpa_hfinfo.len >= gpa_hfinfo.allocated_len) {
 		if (!gpa_hfinfo.hfi) {
@@ -7919,6 +8286,8 @@ proto_register_field_init(header_field_info *hfinfo, const int parent)
 	gpa_hfinfo.len++;
 	hfinfo->id = gpa_hfinfo.len - 1;
 
+	field_vs_ext_init(hfinfo);
+
 	/* if we have real names, enter this field in the name tree */
 	if ((hfinfo->name[0] != 0) && (hfinfo->abbrev[0] != 0 )) {
 
@@ -8520,6 +8889,8 @@ fill_label_boolean(field_info *fi, gchar *label_str)
 static const char *
 hf_try_val_to_str(guint32 value, const header_field_info *hfinfo)
 {
+	value_string_ext *vse;
+
 	if (hfinfo->display & BASE_RANGE_STRING)
 		return try_rval_to_str(value, (const range_string *) hfinfo->strings);
 
@@ -8532,6 +8903,12 @@ hf_try_val_to_str(guint32 value, const header_field_info *hfinfo)
 	if (hfinfo->display & BASE_UNIT_STRING)
 		return unit_name_string_get_value(value, (struct unit_name_string*) hfinfo->strings);
 
+	/* Check that the strings haven't been replaced since registration */
+	if (field_vs_ext && (guint)hfinfo->id < field_vs_ext->len &&
+	    (vse = (value_string_ext *)g_ptr_array_index(field_vs_ext, hfinfo->id)) != NULL &&
+	    VALUE_STRING_EXT_VS_P(vse) == (const value_string *)hfinfo->strings)
+		return try_val_to_str_ext(value, vse);
+
 	return try_val_to_str(value, (const value_string *) hfinfo->strings);
 }
 
@@ -9475,6 +9852,12 @@ proto_registrar_is_protocol(const int n)
  * in our internal representation, as in the case of IPv4).
  * 0 means undeterminable at time of registration
  * -1 means the field is not registered. */
+guint
+proto_registrar_get_generation(void)
+{
+	return registrar_generation;
+}
+
 gint
 proto_registrar_get_length(const int n)
 {
@@ -9502,32 +9885,32 @@ proto_check_for_protocol_or_field(const proto_tree* tree, const int id)
 /* Return GPtrArray* of field_info pointers for all hfindex that appear in tree.
  * This only works if the hfindex was "primed" before the dissection
  * took place, as we just pass back the already-created GPtrArray*.
- * The caller should *not* free the GPtrArray*; proto_tree_free_node()
- * handles that. */
+ * The caller should *not* free the GPtrArray*; proto_tree_reset() and
+ * proto_tree_free() handle that. */
 GPtrArray *
 proto_get_finfo_ptr_array(const proto_tree *tree, const int id)
 {
+	GPtrArray *ptrs;
+
 	if (!tree)
 		return NULL;
 
-	if (PTREE_DATA(tree)->interesting_hfids != NULL)
-		return (GPtrArray *)g_hash_table_lookup(PTREE_DATA(tree)->interesting_hfids,
-					   GINT_TO_POINTER(id));
-	else
+	if (PTREE_DATA(tree)->interesting_hfids == NULL)
 		return NULL;
+
+	/* Arrays left over from earlier dissections are empty */
+	ptrs = (GPtrArray *)g_hash_table_lookup(PTREE_DATA(tree)->interesting_hfids,
+				   GINT_TO_POINTER(id));
+	return (ptrs != NULL && ptrs->len > 0) ? ptrs : NULL;
 }
 
 gboolean
 proto_tracking_interesting_fields(const proto_tree *tree)
 {
-	GHashTable *interesting_hfids;
-
 	if (!tree)
 		return FALSE;
 
-	interesting_hfids = PTREE_DATA(tree)->interesting_hfids;
-
-	return (interesting_hfids != NULL) && g_hash_table_size(interesting_hfids);
+	return PTREE_DATA(tree)->slabs->interesting_used->len > 0;
 }
 
 /* Helper struct for proto_find_info() and	proto_all_finfos() */
@@ -10922,6 +11305,21 @@ proto_tree_add_bitmask_list(proto_tree *tree, tvbuff_t *tvb, const guint offset,
 	}
 }
 
+void
+proto_tree_add_header_fields(proto_tree *tree, tvbuff_t *tvb, const gint offset,
+								const proto_header_field_t *fields)
+{
+	const proto_header_field_t *field;
+
+	if (!tree)
+		return;
+
+	for (field = fields; field->hf != NULL; field++) {
+		proto_tree_add_item(tree, *field->hf, tvb, offset + field->offset,
+		    field->length, field->encoding);
+	}
+}
+
 WS_DLL_PUBLIC void
 proto_tree_add_bitmask_list_value(proto_tree *tree, tvbuff_t *tvb, const guint offset,
 								const int len, const int **fields, const guint64 value)
@@ -766,8 +766,10 @@ typedef struct {
     GHashTable  *interesting_hfids;
     gboolean     visible;
     gboolean     fake_protocols;
+    gboolean     field_demand;
     gint         count;
     struct _packet_info *pinfo;
+    struct _proto_tree_slabs *slabs; /**< node storage, private to proto.c */
 } tree_data_t;
 
 /** Each proto_tree, proto_item is one of these. */
@@ -932,6 +934,22 @@ extern void proto_cleanup(void);
 */
 WS_DLL_PUBLIC gboolean proto_field_is_referenced(proto_tree *tree, int proto_id);
 
+/** Check whether anything consumes the body of a protocol in this dissection.
+    This is stricter than proto_field_is_referenced(): it only returns FALSE
+    if the application enabled field demand on the tree (see
+    proto_tree_set_field_demand()), the tree is invisible, no column info
+    is being filled in and neither the protocol nor any of its fields is
+    referenced.
+    A dissector getting FALSE may skip decoding the body of its PDU
+    altogether, not just the proto_tree_add_...() calls, as long as it
+    still queues its taps when have_tap_listener() says someone listens
+    and the body hands nothing off to other dissectors that might be
+    referenced themselves.
+    @param tree the tree the protocol would be added to
+    @param proto_id the protocol id
+    @return TRUE if the protocol's body must be dissected */
+WS_DLL_PUBLIC gboolean proto_protocol_body_is_needed(proto_tree *tree, int proto_id);
+
 /** Create a subtree under an existing item.
  @param ti the parent item of the new subtree
  @param idx one of the ett_ array elements registered with proto_register_subtree_array()
@@ -1006,6 +1024,22 @@ extern proto_tree* proto_tree_create_root(struct _packet_info *pinfo);
 
 void proto_tree_reset(proto_tree *tree);
 
+/** Get the number of proto_nodes allocated in a tree since it was
+ * created or last reset, i.e. for the packet currently dissected into it.
+ @param tree the tree root
+ @return the number of nodes; faked items reuse their parent and aren't counted */
+WS_DLL_PUBLIC guint proto_tree_get_nodes_allocated(proto_tree *tree);
+
+/** Get the ids of the FT_PROTOCOL items dissectors added to the tree,
+ including the ones faked because nothing referenced them; an id can be
+ in the list more than once.  Only meaningful for a tree that wasn't set
+ up for proto_tree_set_field_demand(), as skipped protocol bodies add
+ nothing.
+ @param tree the tree the frame was dissected into
+ @param num_protocols set to the number of ids
+ @return the ids, valid until the tree is reset or freed */
+WS_DLL_PUBLIC const int *proto_tree_get_protocols(proto_tree *tree, guint *num_protocols);
+
 /** Clear memory for entry proto_tree. Clears proto_tree struct also.
  @param tree the tree to free */
 WS_DLL_PUBLIC void proto_tree_free(proto_tree *tree);
@@ -1026,6 +1060,16 @@ proto_tree_set_visible(proto_tree *tree, gboolean visible);
 extern void
 proto_tree_set_fake_protocols(proto_tree *tree, gboolean fake_protocols);
 
+/** Indicate whether only the primed fields of this tree are wanted
+ (default = FALSE).  Enables proto_protocol_body_is_needed() to report
+ unreferenced protocols as unneeded; only set this when everything that
+ will look at the dissection (filters, custom columns, output fields,
+ postdissectors) has primed the tree with the fields it uses.
+ @param tree the tree to be set
+ @param field_demand TRUE if unreferenced protocol bodies may be skipped */
+extern void
+proto_tree_set_field_demand(proto_tree *tree, gboolean field_demand);
+
 /** Mark a field/protocol ID as "interesting".
  @param tree the tree to be set (currently ignored)
  @param hfid the interesting field id
@@ -2291,6 +2335,11 @@ WS_DLL_PUBLIC gboolean proto_registrar_is_protocol(const int n);
  @return 0 means undeterminable at registration time, -1 means unknown field */
 extern gint proto_registrar_get_length(const int n);
 
+/** Get a number that changes whenever a field is registered or
+ * deregistered, so that things built from the registered fields, such as
+ * compiled display filters, can tell whether they're still valid. */
+extern guint proto_registrar_get_generation(void);
+
 
 /** Routines to use to iterate over the protocols and their fields;
  * they return the item number of the protocol in question or the
@@ -2301,6 +2350,16 @@ WS_DLL_PUBLIC int proto_get_next_protocol(void **cookie);
 WS_DLL_PUBLIC header_field_info *proto_get_first_protocol_field(const int proto_id, void **cookie);
 WS_DLL_PUBLIC header_field_info *proto_get_next_protocol_field(const int proto_id, void **cookie);
 
+/** Call func for every protocol and field whose abbreviation starts with
+ prefix (compared case-insensitively), in alphabetical order; fields
+ registered more than once under the same name are passed once, and
+ those of disabled protocols are skipped. Uses a sorted index, so this
+ is cheap enough to call on every keystroke.
+ @param prefix the start of the abbreviation; "" matches everything
+ @param func called with the header_field_info and user_data
+ @param user_data passed to func */
+WS_DLL_PUBLIC void proto_registrar_foreach_prefix(const char *prefix, GFunc func, gpointer user_data);
+
 /** Check if a protocol name is already registered.
  @param name the name to search for
  @return proto_id */
@@ -2709,6 +2768,27 @@ WS_DLL_PUBLIC void
 proto_tree_add_bitmask_list(proto_tree *tree, tvbuff_t *tvb, const guint offset,
 								const int len, const int **fields, const guint encoding);
 
+/** One field of a fixed-layout header, see proto_tree_add_header_fields(). */
+typedef struct {
+    const int *hf;          /**< the field, NULL to end the table */
+    gint       offset;      /**< offset of the field from the start of the header */
+    gint       length;      /**< length of the field */
+    guint      encoding;    /**< encoding, as for proto_tree_add_item() */
+} proto_header_field_t;
+
+/** Add the fields of a fixed-layout header, as described by a table,
+    in one call. Each entry is added as by proto_tree_add_item(); entries
+    that need their proto_item for anything (expert info, appended text)
+    should be added separately.
+ @param tree the tree to append the fields to
+ @param tvb the tv buffer of the current data
+ @param offset start of the header in tvb
+ @param fields the fields of the header, terminated by an entry with a NULL hf
+ */
+WS_DLL_PUBLIC void
+proto_tree_add_header_fields(proto_tree *tree, tvbuff_t *tvb, const gint offset,
+								const proto_header_field_t *fields);
+
 /** This function will dissect a value that describe a bitmask. Similar to proto_tree_add_bitmask_list(),
     but with a passed in value (presumably because it can't be retrieved directly from tvb)
  @param tree the tree to append this item to
@@ -0,0 +1,314 @@
+/* protocol_index.c
+ * An index of the protocols in each frame of a capture, so that frames
+ * that can't match a display filter needn't be dissected again
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <wsutil/bits_ctz.h>
+
+#include <epan/protocol_index.h>
+
+#define CHUNK_SHIFT	16
+#define CHUNK_FRAMES	(1 << CHUNK_SHIFT)
+#define CHUNK_WORDS	(CHUNK_FRAMES / 32)
+/* An array of more frames than this takes more room than a bitmap */
+#define ARRAY_MAX	(CHUNK_FRAMES / 16)
+
+typedef struct {
+	guint16	*frames;	/* sorted low 16 bits of the frame numbers, or NULL */
+	guint	 count;
+	guint	 size;
+	guint32	*bits;		/* CHUNK_WORDS words, once frames would be too big */
+} frame_chunk_t;
+
+/* frame_chunk_t pointers indexed by frame number >> CHUNK_SHIFT, NULL if empty */
+typedef GPtrArray frame_set_t;
+
+struct _protocol_index {
+	frame_set_t	*indexed;	/* frames that were added */
+	GHashTable	*protocols;	/* protocol id -> frame_set_t */
+};
+
+static void
+frame_chunk_free(gpointer data)
+{
+	frame_chunk_t *chunk = (frame_chunk_t *)data;
+
+	if (chunk == NULL)
+		return;
+	g_free(chunk->frames);
+	g_free(chunk->bits);
+	g_free(chunk);
+}
+
+static frame_set_t *
+frame_set_new(void)
+{
+	return g_ptr_array_new_with_free_func(frame_chunk_free);
+}
+
+static void
+frame_set_free(gpointer data)
+{
+	g_ptr_array_free((frame_set_t *)data, TRUE);
+}
+
+static void
+frame_chunk_to_bits(frame_chunk_t *chunk)
+{
+	guint i;
+
+	chunk->bits = g_new0(guint32, CHUNK_WORDS);
+	for (i = 0; i < chunk->count; i++)
+		chunk->bits[chunk->frames[i] / 32] |= 1U << (chunk->frames[i] % 32);
+	g_free(chunk->frames);
+	chunk->frames = NULL;
+}
+
+static void
+frame_set_add(frame_set_t *set, guint32 framenum)
+{
+	guint		 index = framenum >> CHUNK_SHIFT;
+	guint16		 low = (guint16)(framenum & (CHUNK_FRAMES - 1));
+	frame_chunk_t	*chunk;
+	guint		 lo, hi, mid;
+
+	if (set->len <= index)
+		g_ptr_array_set_size(set, index + 1);
+	chunk = (frame_chunk_t *)g_ptr_array_index(set, index);
+	if (chunk == NULL) {
+		chunk = g_new0(frame_chunk_t, 1);
+		g_ptr_array_index(set, index) = chunk;
+	}
+
+	if (chunk->bits) {
+		chunk->bits[low / 32] |= 1U << (low % 32);
+		return;
+	}
+
+	/* Frames are normally added in order, so look at the end first */
+	if (chunk->count == 0 || chunk->frames[chunk->count - 1] < low) {
+		lo = chunk->count;
+	} else {
+		lo = 0;
+		hi = chunk->count;
+		while (lo < hi) {
+			mid = lo + (hi - lo) / 2;
+			if (chunk->frames[mid] < low)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		if (chunk->frames[lo] == low)
+			return;
+	}
+
+	if (chunk->count == ARRAY_MAX) {
+		frame_chunk_to_bits(chunk);
+		chunk->bits[low / 32] |= 1U << (low % 32);
+		return;
+	}
+	if (chunk->count == chunk->size) {
+		chunk->size = chunk->size ? chunk->size * 2 : 16;
+		chunk->frames = g_renew(guint16, chunk->frames, chunk->size);
+	}
+	memmove(&chunk->frames[lo + 1], &chunk->frames[lo],
+		(chunk->count - lo) * sizeof chunk->frames[0]);
+	chunk->frames[lo] = low;
+	chunk->count++;
+}
+
+static gboolean
+frame_set_contains(const frame_set_t *set, guint32 framenum)
+{
+	guint			 index = framenum >> CHUNK_SHIFT;
+	guint16			 low = (guint16)(framenum & (CHUNK_FRAMES - 1));
+	const frame_chunk_t	*chunk;
+	guint			 lo, hi, mid;
+
+	if (set == NULL || index >= set->len)
+		return FALSE;
+	chunk = (const frame_chunk_t *)g_ptr_array_index(set, index);
+	if (chunk == NULL)
+		return FALSE;
+	if (chunk->bits)
+		return (chunk->bits[low / 32] & (1U << (low % 32))) != 0;
+
+	lo = 0;
+	hi = chunk->count;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (chunk->frames[mid] < low)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo < chunk->count && chunk->frames[lo] == low;
+}
+
+/* Set words to the bitmap of chunk index of set */
+static void
+frame_set_get_words(const frame_set_t *set, guint index, guint32 *words)
+{
+	const frame_chunk_t	*chunk = NULL;
+	guint			 i;
+
+	if (set != NULL && index < set->len)
+		chunk = (const frame_chunk_t *)g_ptr_array_index(set, index);
+
+	if (chunk == NULL) {
+		memset(words, 0, CHUNK_WORDS * sizeof words[0]);
+	} else if (chunk->bits) {
+		memcpy(words, chunk->bits, CHUNK_WORDS * sizeof words[0]);
+	} else {
+		memset(words, 0, CHUNK_WORDS * sizeof words[0]);
+		for (i = 0; i < chunk->count; i++)
+			words[chunk->frames[i] / 32] |= 1U << (chunk->frames[i] % 32);
+	}
+}
+
+protocol_index_t *
+protocol_index_new(void)
+{
+	protocol_index_t *idx = g_new(protocol_index_t, 1);
+
+	idx->indexed = frame_set_new();
+	idx->protocols = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+		NULL, frame_set_free);
+	return idx;
+}
+
+void
+protocol_index_free(protocol_index_t *idx)
+{
+	if (idx == NULL)
+		return;
+	frame_set_free(idx->indexed);
+	g_hash_table_destroy(idx->protocols);
+	g_free(idx);
+}
+
+void
+protocol_index_add_frame(protocol_index_t *idx, guint32 framenum, proto_tree *tree)
+{
+	const int	*protocols;
+	guint		 num_protocols, i;
+	frame_set_t	*set;
+
+	frame_set_add(idx->indexed, framenum);
+
+	protocols = proto_tree_get_protocols(tree, &num_protocols);
+	for (i = 0; i < num_protocols; i++) {
+		set = (frame_set_t *)g_hash_table_lookup(idx->protocols,
+			GINT_TO_POINTER(protocols[i]));
+		if (set == NULL) {
+			set = frame_set_new();
+			g_hash_table_insert(idx->protocols,
+				GINT_TO_POINTER(protocols[i]), set);
+		}
+		frame_set_add(set, framenum);
+	}
+}
+
+guint32 *
+protocol_index_filter_frames(protocol_index_t *idx, const dfilter_t *df,
+		guint32 frames_count, guint32 *count)
+{
+	const int	*required;
+	int		 num_required, i;
+	frame_set_t	**sets;
+	guint32		*words, *candidates;
+	GArray		*frames;
+	guint		 index, w;
+	guint32		 bits, framenum;
+
+	required = dfilter_required_protocols(df, &num_required);
+	if (num_required == 0 || frames_count == 0)
+		return NULL;
+
+	sets = g_new(frame_set_t *, num_required);
+	for (i = 0; i < num_required; i++)
+		sets[i] = (frame_set_t *)g_hash_table_lookup(idx->protocols,
+			GINT_TO_POINTER(required[i]));
+
+	words = g_new(guint32, CHUNK_WORDS);
+	candidates = g_new(guint32, CHUNK_WORDS);
+	frames = g_array_sized_new(FALSE, FALSE, sizeof(guint32), 1);
+
+	for (index = 0; index <= frames_count >> CHUNK_SHIFT; index++) {
+		/* A frame can match if it has all the required protocols... */
+		memset(candidates, 0xff, CHUNK_WORDS * sizeof candidates[0]);
+		for (i = 0; i < num_required; i++) {
+			frame_set_get_words(sets[i], index, words);
+			for (w = 0; w < CHUNK_WORDS; w++)
+				candidates[w] &= words[w];
+		}
+		/* ...or if we don't know what it has */
+		frame_set_get_words(idx->indexed, index, words);
+		for (w = 0; w < CHUNK_WORDS; w++)
+			candidates[w] |= ~words[w];
+
+		for (w = 0; w < CHUNK_WORDS; w++) {
+			for (bits = candidates[w]; bits != 0; bits &= bits - 1) {
+				framenum = (index << CHUNK_SHIFT) + w * 32 + ws_ctz(bits);
+				if (framenum == 0)
+					continue;
+				if (framenum > frames_count)
+					break;
+				g_array_append_val(frames, framenum);
+			}
+		}
+	}
+
+	g_free(candidates);
+	g_free(words);
+	g_free(sets);
+
+	*count = frames->len;
+	return (guint32 *)g_array_free(frames, FALSE);
+}
+
+gboolean
+protocol_index_frame_may_have(protocol_index_t *idx, guint32 framenum, int proto_id)
+{
+	if (!frame_set_contains(idx->indexed, framenum))
+		return TRUE;
+	return frame_set_contains((const frame_set_t *)g_hash_table_lookup(idx->protocols,
+		GINT_TO_POINTER(proto_id)), framenum);
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -0,0 +1,80 @@
+/* protocol_index.h
+ * Definitions for an index of the protocols in each frame of a capture
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __PROTOCOL_INDEX_H__
+#define __PROTOCOL_INDEX_H__
+
+#include <epan/proto.h>
+#include <epan/dfilter/dfilter.h>
+#include "ws_symbol_export.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * For each protocol, the set of frames whose tree it was added to, kept
+ * as a compressed bitmap: frame numbers are split into chunks of 65536,
+ * and each chunk holds either a sorted array of the frames in it or,
+ * once that would be bigger, a plain bitmap.
+ */
+typedef struct _protocol_index protocol_index_t;
+
+WS_DLL_PUBLIC protocol_index_t *protocol_index_new(void);
+
+WS_DLL_PUBLIC void protocol_index_free(protocol_index_t *idx);
+
+/* Record the protocols in the tree of frame framenum; frames are best
+ * added in increasing order.  Frames that are never added (for instance
+ * because they were dissected without a tree) are never pruned. */
+WS_DLL_PUBLIC void protocol_index_add_frame(protocol_index_t *idx, guint32 framenum, proto_tree *tree);
+
+/* Get the sorted numbers of the frames, out of 1 to frames_count, that
+ * can match df as far as the index can tell, for cf_set_filter_frames().
+ * Returns NULL if the index can't rule any frames out, otherwise an array
+ * of *count frame numbers for the caller to g_free(). */
+WS_DLL_PUBLIC guint32 *protocol_index_filter_frames(protocol_index_t *idx, const dfilter_t *df,
+		guint32 frames_count, guint32 *count);
+
+/* FALSE if frame framenum is known not to have protocol proto_id in its
+ * tree, TRUE if it has it or wasn't added. */
+WS_DLL_PUBLIC gboolean protocol_index_frame_may_have(protocol_index_t *idx, guint32 framenum,
+		int proto_id);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __PROTOCOL_INDEX_H__ */
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -26,8 +26,10 @@
 
 #include <epan/packet.h>
 #include <epan/exceptions.h>
+#include <epan/prefs.h>
 #include <epan/reassemble.h>
 #include <epan/tvbuff-int.h>
+#include <epan/app_mem_usage.h>
 
 #include <wsutil/str_util.h>
 
@@ -486,6 +488,15 @@ reassembly_table_init(reassembly_table *table,
 		table->reassembled_table = g_hash_table_new_full(reassembled_hash,
 		    reassembled_equal, reassembled_key_free, NULL);
 	}
+
+	table->pending_bytes = 0;
+	table->evicted = 0;
+}
+
+void
+reassembly_table_set_composite(reassembly_table *table, const gboolean composite)
+{
+	table->composite = composite;
 }
 
 /*
@@ -544,6 +555,146 @@ reassembly_table_destroy(reassembly_table *table)
 	}
 }
 
+/*
+ * Memory held by a reassembly in the fragment table: the fragment data
+ * saved so far or, once it's been reassembled, the reassembled data.
+ */
+static guint64
+fragment_head_bytes(const fragment_head *fd_head)
+{
+	const fragment_item *fd;
+	guint64 bytes = 0;
+
+	if (fd_head->tvb_data != NULL && !(fd_head->flags & FD_SUBSET_TVB))
+		bytes += tvb_captured_length(fd_head->tvb_data);
+	for (fd = fd_head->next; fd != NULL; fd = fd->next) {
+		if (fd->tvb_data != NULL && !(fd->flags & FD_SUBSET_TVB))
+			bytes += fd->len;
+	}
+	return bytes;
+}
+
+typedef struct {
+	gpointer key;
+	fragment_head *fd_head;
+	guint64 bytes;
+} pending_reassembly_t;
+
+static void
+collect_pending_reassembly(gpointer key, gpointer value, gpointer user_data)
+{
+	fragment_head *fd_head = (fragment_head *)value;
+	GArray *pending = (GArray *)user_data;
+	pending_reassembly_t entry;
+
+	if (fd_head->flags & FD_DEFRAGMENTED)
+		return;
+
+	entry.key = key;
+	entry.fd_head = fd_head;
+	entry.bytes = fragment_head_bytes(fd_head);
+	g_array_append_val(pending, entry);
+}
+
+static gint
+pending_reassembly_compare(gconstpointer a, gconstpointer b)
+{
+	const pending_reassembly_t *pa = (const pending_reassembly_t *)a;
+	const pending_reassembly_t *pb = (const pending_reassembly_t *)b;
+
+	if (pa->fd_head->frame != pb->fd_head->frame)
+		return pa->fd_head->frame < pb->fd_head->frame ? -1 : 1;
+	return 0;
+}
+
+/*
+ * Count the memory held by the incomplete reassemblies in a table and,
+ * if it's over the low water mark, drop the ones that were last added
+ * to longest ago until it isn't.  (Completed reassemblies are left
+ * alone; dissectors can still look them up with fragment_get() et al.
+ * when the frames are revisited.)
+ */
+static void
+reassembly_table_trim(reassembly_table *table, const guint64 low_water)
+{
+	GArray *pending;
+	guint64 bytes = 0;
+	guint i;
+
+	pending = g_array_new(FALSE, FALSE, sizeof(pending_reassembly_t));
+	g_hash_table_foreach(table->fragment_table, collect_pending_reassembly,
+	    pending);
+	for (i = 0; i < pending->len; i++)
+		bytes += g_array_index(pending, pending_reassembly_t, i).bytes;
+
+	if (bytes > low_water) {
+		g_array_sort(pending, pending_reassembly_compare);
+		for (i = 0; i < pending->len && bytes > low_water; i++) {
+			pending_reassembly_t *entry =
+			    &g_array_index(pending, pending_reassembly_t, i);
+
+			bytes -= entry->bytes;
+			free_all_fragments(entry->key, entry->fd_head, NULL);
+			g_hash_table_remove(table->fragment_table, entry->key);
+			table->evicted++;
+		}
+	}
+	g_array_free(pending, TRUE);
+
+	table->pending_bytes = bytes;
+}
+
+/*
+ * Account for a fragment about to be added to a table, and enforce the
+ * memory limit for incomplete reassemblies.  This must be called before
+ * looking up the reassembly the fragment belongs to, as that might be
+ * one of the ones that get dropped.
+ *
+ * The running total only ever grows between counts (fragments that turn
+ * out to be duplicates, and reassemblies that complete or are deleted,
+ * aren't subtracted), so it's an upper bound; when it goes over the
+ * limit, the real figure is counted.
+ */
+static void
+reassembly_table_charge(reassembly_table *table, const packet_info *pinfo,
+			const guint32 frag_data_len)
+{
+	guint64 limit;
+
+	if (pinfo->fd->flags.visited || prefs.reassembly_memory_limit == 0)
+		return;
+
+	limit = (guint64)prefs.reassembly_memory_limit * 1024 * 1024;
+	if (table->pending_bytes + frag_data_len > limit)
+		reassembly_table_trim(table, limit - limit / 4);
+	table->pending_bytes += frag_data_len;
+}
+
+static void
+count_reassembly(gpointer key _U_, gpointer value, gpointer user_data)
+{
+	fragment_head *fd_head = (fragment_head *)value;
+	reassembly_table_stats *stats = (reassembly_table_stats *)user_data;
+
+	if (fd_head->flags & FD_DEFRAGMENTED) {
+		stats->completed++;
+		stats->completed_bytes += fragment_head_bytes(fd_head);
+	} else {
+		stats->pending++;
+		stats->pending_bytes += fragment_head_bytes(fd_head);
+	}
+}
+
+void
+reassembly_table_get_stats(reassembly_table *table, reassembly_table_stats *stats)
+{
+	memset(stats, 0, sizeof(*stats));
+	if (table->fragment_table != NULL)
+		g_hash_table_foreach(table->fragment_table, count_reassembly,
+		    stats);
+	stats->evicted = table->evicted;
+}
+
 /*
  * Look up an fd_head in the fragment table, optionally returning the key
  * for it.
@@ -919,6 +1070,137 @@ MERGE_FRAG(fragment_head *fd_head, fragment_item *fd)
 	}
 	fd_i->next = fd;
 }
+
+/*
+ * Make composite, whose members are the fragments' data or subsets of
+ * it, the reassembly's data, and give it the fragments' tvbuffs:
+ * the composite is taken out of the chain of its first member, which
+ * tvb_composite_finalize() put it in, and the fragments' chains are
+ * put in its chain instead, so that freeing the reassembled data frees
+ * the fragments' data too, just as it would free a copy.  Fragments
+ * whose data isn't used at all are freed now.
+ */
+static void
+fragment_adopt_tvbs(fragment_head *fd_head, tvbuff_t *composite,
+		    tvbuff_t *first_tvb, GSList *members)
+{
+	fragment_item *fd_i;
+	tvbuff_t *prev;
+
+	for (prev = first_tvb; prev->next != composite; prev = prev->next)
+		;
+	prev->next = composite->next;
+	composite->next = NULL;
+
+	for (fd_i = fd_head->next; fd_i; fd_i = fd_i->next) {
+		if (fd_i->tvb_data == NULL)
+			continue;
+		if (g_slist_find(members, fd_i->tvb_data))
+			tvb_add_to_chain(composite, fd_i->tvb_data);
+		else
+			tvb_free(fd_i->tvb_data);
+		fd_i->tvb_data = NULL;
+	}
+
+	fd_head->tvb_data = composite;
+}
+
+/*
+ * Reassemble a datagram whose fragments are at byte offsets, as
+ * fragment_add_work() does, but build the reassembled data as a
+ * composite of the fragments' data instead of copying it.
+ *
+ * Returns FALSE, having changed nothing, for anything out of the
+ * ordinary (a partial reassembly being extended, fragments past the
+ * end of the datagram, gaps), which is left to the code that copies.
+ */
+static gboolean
+fragment_defragment_composite(fragment_head *fd_head)
+{
+	fragment_item *fd_i;
+	tvbuff_t *composite, *first_tvb = NULL;
+	GSList *members = NULL;
+	guint32 dfpos, fraglen, skip, cmp_len;
+	guint8 *old_data;
+
+	if (fd_head->tvb_data || fd_head->len || !fd_head->datalen)
+		return FALSE;
+
+	/* See whether the fragments line up. */
+	dfpos = 0;
+	for (fd_i = fd_head->next; fd_i; fd_i = fd_i->next) {
+		if (!fd_i->len)
+			continue;
+		if (fd_i->offset + fd_i->len < fd_i->offset)
+			return FALSE;
+		if (fd_i->offset + fd_i->len <= dfpos)
+			continue;
+		if (fd_i->offset >= fd_head->datalen || fd_i->offset > dfpos ||
+		    !fd_i->tvb_data || (fd_i->flags & FD_SUBSET_TVB))
+			return FALSE;
+		fraglen = MIN(fd_i->len, fd_head->datalen - fd_i->offset);
+		dfpos = MAX(dfpos, fd_i->offset + fraglen);
+	}
+	if (dfpos != fd_head->datalen)
+		return FALSE;
+
+	/* Put the parts of them that aren't overlapped together. */
+	composite = tvb_new_composite();
+	dfpos = 0;
+	for (fd_i = fd_head->next; fd_i; fd_i = fd_i->next) {
+		if (!fd_i->len || fd_i->offset + fd_i->len <= dfpos)
+			continue;
+
+		fraglen = fd_i->len;
+		if (fd_i->offset + fraglen > fd_head->datalen) {
+			fd_i->flags    |= FD_TOOLONGFRAGMENT;
+			fd_head->flags |= FD_TOOLONGFRAGMENT;
+			fraglen = fd_head->datalen - fd_i->offset;
+		}
+		skip = dfpos - fd_i->offset;
+		if (skip < fraglen) {
+			if (first_tvb == NULL)
+				first_tvb = fd_i->tvb_data;
+			if (skip == 0 && fraglen == tvb_captured_length(fd_i->tvb_data))
+				tvb_composite_append(composite, fd_i->tvb_data);
+			else
+				tvb_composite_append(composite,
+				    tvb_new_subset_length(fd_i->tvb_data, skip, fraglen - skip));
+			members = g_slist_prepend(members, fd_i->tvb_data);
+		}
+		dfpos = MAX(dfpos, fd_i->offset + fraglen);
+	}
+	tvb_composite_finalize(composite);
+
+	/* Check the overlapping parts against what they overlap. */
+	dfpos = 0;
+	for (fd_i = fd_head->next; fd_i; fd_i = fd_i->next) {
+		if (!fd_i->len || fd_i->offset + fd_i->len <= dfpos)
+			continue;
+
+		if (fd_i->offset < dfpos) {
+			cmp_len = MIN(fd_i->len, (dfpos - fd_i->offset));
+
+			fd_i->flags    |= FD_OVERLAP;
+			fd_head->flags |= FD_OVERLAP;
+			old_data = (guint8 *)g_malloc(cmp_len);
+			tvb_memcpy(composite, old_data, fd_i->offset, cmp_len);
+			if (memcmp(old_data, tvb_get_ptr(fd_i->tvb_data, 0, cmp_len),
+			    cmp_len)) {
+				fd_i->flags    |= FD_OVERLAPCONFLICT;
+				fd_head->flags |= FD_OVERLAPCONFLICT;
+			}
+			g_free(old_data);
+		}
+		dfpos = MAX(dfpos, fd_i->offset + MIN(fd_i->len, fd_head->datalen - fd_i->offset));
+	}
+
+	fragment_adopt_tvbs(fd_head, composite, first_tvb, members);
+	g_slist_free(members);
+
+	return TRUE;
+}
+
 /*
  * This function adds a new fragment to the fragment hash table.
  * If this is the first fragment seen for this datagram, a new entry
@@ -943,7 +1225,8 @@ MERGE_FRAG(fragment_head *fd_head, fragment_item *fd)
 static gboolean
 fragment_add_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
 		 const packet_info *pinfo, const guint32 frag_offset,
-		 const guint32 frag_data_len, const gboolean more_frags)
+		 const guint32 frag_data_len, const gboolean more_frags,
+		 const gboolean composite)
 {
 	fragment_item *fd;
 	fragment_item *fd_i;
@@ -1144,6 +1427,13 @@ fragment_add_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
 	/* we have received an entire packet, defragment it and
 	 * free all fragments
 	 */
+	if (composite && fragment_defragment_composite(fd_head)) {
+		fd_head->flags |= FD_DEFRAGMENTED;
+		fd_head->reassembled_in=pinfo->num;
+		fd_head->reas_in_layer_num = pinfo->curr_layer_num;
+		return TRUE;
+	}
+
 	/* store old data just in case */
 	old_tvb_data=fd_head->tvb_data;
 	data = (guint8 *) g_malloc(fd_head->datalen);
@@ -1305,6 +1595,8 @@ fragment_add_common(reassembly_table *table, tvbuff_t *tvb, const int offset,
 	 */
 	DISSECTOR_ASSERT(tvb_bytes_exist(tvb, offset, frag_data_len));
 
+	reassembly_table_charge(table, pinfo, frag_data_len);
+
 	fd_head = lookup_fd_head(table, pinfo, id, data, NULL);
 
 #if 0
@@ -1461,7 +1753,7 @@ fragment_add_common(reassembly_table *table, tvbuff_t *tvb, const int offset,
 	}
 
 	if (fragment_add_work(fd_head, tvb, offset, pinfo, frag_offset,
-		frag_data_len, more_frags)) {
+		frag_data_len, more_frags, table->composite)) {
 		/*
 		 * Reassembly is complete.
 		 */
@@ -1523,6 +1815,7 @@ fragment_add_check(reassembly_table *table, tvbuff_t *tvb, const int offset,
 	 * and a gboolean which is TRUE if the key was found. This is useful if you need to free
 	 * the memory allocated for the original key, for example before calling g_hash_table_remove()
 	 */
+	reassembly_table_charge(table, pinfo, frag_data_len);
 	fd_head = lookup_fd_head(table, pinfo, id, data, &orig_key);
 	if (fd_head == NULL) {
 		/* not found, this must be the first snooped fragment for this
@@ -1544,7 +1837,7 @@ fragment_add_check(reassembly_table *table, tvbuff_t *tvb, const int offset,
 		return NULL;
 
 	if (fragment_add_work(fd_head, tvb, offset, pinfo, frag_offset,
-		frag_data_len, more_frags)) {
+		frag_data_len, more_frags, table->composite)) {
 		/*
 		 * Reassembly is complete.
 		 * Remove this from the table of in-progress
@@ -1571,8 +1864,60 @@ fragment_add_check(reassembly_table *table, tvbuff_t *tvb, const int offset,
 	}
 }
 
+/*
+ * Like fragment_defragment_and_free(), but build the reassembled data as
+ * a composite of the blocks' data instead of copying it.  Returns FALSE,
+ * having changed nothing, if it can't (when a partial reassembly is being
+ * extended), in which case the data is copied.
+ */
+static gboolean
+fragment_defragment_seq_composite(fragment_head *fd_head, const guint32 size)
+{
+	fragment_item *fd_i;
+	fragment_item *last_fd = NULL;
+	tvbuff_t *composite, *first_tvb = NULL;
+	GSList *members = NULL;
+
+	if (fd_head->tvb_data || !size)
+		return FALSE;
+	for (fd_i = fd_head->next; fd_i; fd_i = fd_i->next) {
+		if (fd_i->len && (!fd_i->tvb_data || (fd_i->flags & FD_SUBSET_TVB)))
+			return FALSE;
+	}
+
+	composite = tvb_new_composite();
+	for (fd_i = fd_head->next; fd_i; fd_i = fd_i->next) {
+		if (fd_i->len) {
+			if (!last_fd || last_fd->offset != fd_i->offset) {
+				/* First fragment or in-sequence fragment */
+				if (first_tvb == NULL)
+					first_tvb = fd_i->tvb_data;
+				tvb_composite_append(composite, fd_i->tvb_data);
+				members = g_slist_prepend(members, fd_i->tvb_data);
+			} else {
+				/* duplicate/retransmission/overlap */
+				fd_i->flags    |= FD_OVERLAP;
+				fd_head->flags |= FD_OVERLAP;
+				if (last_fd->len != fd_i->len
+				   || tvb_memeql(last_fd->tvb_data, 0, tvb_get_ptr(fd_i->tvb_data, 0, last_fd->len), last_fd->len) ) {
+					fd_i->flags    |= FD_OVERLAPCONFLICT;
+					fd_head->flags |= FD_OVERLAPCONFLICT;
+				}
+			}
+		}
+		last_fd = fd_i;
+	}
+	tvb_composite_finalize(composite);
+
+	fragment_adopt_tvbs(fd_head, composite, first_tvb, members);
+	g_slist_free(members);
+
+	return TRUE;
+}
+
 static void
-fragment_defragment_and_free (fragment_head *fd_head, const packet_info *pinfo)
+fragment_defragment_and_free (fragment_head *fd_head, const packet_info *pinfo,
+			      const gboolean composite)
 {
 	fragment_item *fd_i = NULL;
 	fragment_item *last_fd = NULL;
@@ -1587,6 +1932,14 @@ fragment_defragment_and_free (fragment_head *fd_head, const packet_info *pinfo)
 		last_fd=fd_i;
 	}
 
+	if (composite && fragment_defragment_seq_composite(fd_head, size)) {
+		fd_head->len = size;		/* record size for caller	*/
+		fd_head->flags |= FD_DEFRAGMENTED;
+		fd_head->reassembled_in=pinfo->num;
+		fd_head->reas_in_layer_num = pinfo->curr_layer_num;
+		return;
+	}
+
 	/* store old data in case the fd_i->data pointers refer to it */
 	old_tvb_data=fd_head->tvb_data;
 	data = (guint8 *) g_malloc(size);
@@ -1650,7 +2003,8 @@ fragment_defragment_and_free (fragment_head *fd_head, const packet_info *pinfo)
 static gboolean
 fragment_add_seq_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
 		 const packet_info *pinfo, const guint32 frag_number,
-		 const guint32 frag_data_len, const gboolean more_frags)
+		 const guint32 frag_data_len, const gboolean more_frags,
+		 const gboolean composite)
 {
 	fragment_item *fd;
 	fragment_item *fd_i;
@@ -1878,7 +2232,7 @@ fragment_add_seq_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
 	/* we have received an entire packet, defragment it and
 	 * free all fragments
 	 */
-	fragment_defragment_and_free(fd_head, pinfo);
+	fragment_defragment_and_free(fd_head, pinfo, composite);
 
 	return TRUE;
 }
@@ -1977,7 +2331,8 @@ fragment_add_seq_common(reassembly_table *table, tvbuff_t *tvb,
 	}
 
 	if (fragment_add_seq_work(fd_head, tvb, offset, pinfo,
-				  frag_number, frag_data_len, more_frags)) {
+				  frag_number, frag_data_len, more_frags,
+				  table->composite)) {
 		/*
 		 * Reassembly is complete.
 		 */
@@ -1996,6 +2351,7 @@ fragment_add_seq(reassembly_table *table, tvbuff_t *tvb, const int offset,
 		 const guint32 frag_number, const guint32 frag_data_len,
 		 const gboolean more_frags, const guint32 flags)
 {
+	reassembly_table_charge(table, pinfo, frag_data_len);
 	return fragment_add_seq_common(table, tvb, offset, pinfo, id, data,
 				       frag_number, frag_data_len,
 				       more_frags, flags, NULL);
@@ -2057,6 +2413,7 @@ fragment_add_seq_check_work(reassembly_table *table, tvbuff_t *tvb,
 		return (fragment_head *)g_hash_table_lookup(table->reassembled_table, &reass_key);
 	}
 
+	reassembly_table_charge(table, pinfo, frag_data_len);
 	fd_head = fragment_add_seq_common(table, tvb, offset, pinfo, id, data,
 					  frag_number, frag_data_len,
 					  more_frags,
@@ -2203,6 +2560,7 @@ fragment_add_seq_single_work(reassembly_table *table, tvbuff_t *tvb,
 		fh = (fragment_head *)g_hash_table_lookup(table->reassembled_table, &reass_key);
 		return fh;
 	}
+	reassembly_table_charge(table, pinfo, frag_data_len);
 	/* First let's figure out where we want to add our new fragment */
 	fh = NULL;
 	if (first) {
@@ -2490,7 +2848,7 @@ fragment_end_seq_next(reassembly_table *table, const packet_info *pinfo,
 		fd_head->datalen = fd_head->offset;
 		fd_head->flags |= FD_DATALEN_SET;
 
-		fragment_defragment_and_free (fd_head, pinfo);
+		fragment_defragment_and_free (fd_head, pinfo, table->composite);
 
 		/*
 		 * Remove this from the table of in-progress reassemblies,
@@ -2835,10 +3193,33 @@ reassembly_table_cleanup_reg_tables(void)
 	g_list_foreach(reassembly_table_list, reassembly_table_cleanup_reg_table, NULL);
 }
 
+/*
+ * Memory held by the registered reassembly tables, for the memory usage
+ * report.  This walks all the reassemblies, but it's only asked for now
+ * and then.
+ */
+static gsize
+reassembly_tables_get_memory(void)
+{
+	GList *entry;
+	reassembly_table_stats stats;
+	guint64 bytes = 0;
+
+	for (entry = reassembly_table_list; entry != NULL; entry = entry->next) {
+		reassembly_table_get_stats(((register_reassembly_table_t *)entry->data)->table,
+		    &stats);
+		bytes += stats.pending_bytes + stats.completed_bytes;
+	}
+	return (gsize)bytes;
+}
+
+static const ws_mem_usage_t reassembly_usage = { "Reassembly", reassembly_tables_get_memory, NULL };
+
 void reassembly_tables_init(void)
 {
 	register_init_routine(&reassembly_table_init_reg_tables);
 	register_cleanup_routine(&reassembly_table_cleanup_reg_tables);
+	memory_usage_component_register(&reassembly_usage);
 }
 
 static void
@@ -142,8 +142,23 @@ typedef struct {
 	fragment_temporary_key temporary_key_func;
 	fragment_persistent_key persistent_key_func;
 	GDestroyNotify free_temporary_key_func;		/* temporary key destruction function */
+	guint64 pending_bytes;		/* fragment data added to incomplete reassemblies since they were last counted */
+	guint32 evicted;		/* incomplete reassemblies dropped to stay within the memory limit */
+	gboolean composite;		/* build reassembled data as a composite tvbuff */
 } reassembly_table;
 
+/*
+ * Statistics for a reassembly table, as returned by
+ * reassembly_table_get_stats().
+ */
+typedef struct {
+	guint32 pending;		/* reassemblies in progress */
+	guint64 pending_bytes;		/* fragment data held by them */
+	guint32 completed;		/* completed reassemblies still in the fragment table */
+	guint64 completed_bytes;	/* reassembled data held by them */
+	guint32 evicted;		/* reassemblies in progress dropped to stay within the memory limit */
+} reassembly_table_stats;
+
 /*
  * Table of functions for a reassembly table.
  */
@@ -187,6 +202,28 @@ reassembly_table_init(reassembly_table *table,
 WS_DLL_PUBLIC void
 reassembly_table_destroy(reassembly_table *table);
 
+/*
+ * Have a table build the data of completed reassemblies as a composite
+ * tvbuff of the fragments' data instead of copying the fragments into a
+ * new buffer.  This halves the memory used for large reassembled PDUs,
+ * at the cost of slower access to ranges that span fragments.
+ *
+ * Call this before reassembly_table_register() or reassembly_table_init().
+ */
+WS_DLL_PUBLIC void
+reassembly_table_set_composite(reassembly_table *table, const gboolean composite);
+
+/*
+ * Get the number of reassemblies in a table and the memory they hold.
+ *
+ * Incomplete reassemblies are dropped, oldest first, when the fragment
+ * data held by a table's incomplete reassemblies exceeds the
+ * "protocols.reassembly_memory_limit" preference (if it's non-zero),
+ * until they hold no more than three quarters of the limit.
+ */
+WS_DLL_PUBLIC void
+reassembly_table_get_stats(reassembly_table *table, reassembly_table_stats *stats);
+
 /*
  * This function adds a new fragment to the reassembly table
  * If this is the first fragment seen for this datagram, a new entry
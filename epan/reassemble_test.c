@@ -1344,6 +1344,176 @@ test_simple_fragment_add_seq_next(void)
     ASSERT(!tvb_memeql(fd_head->tvb_data,50,data+5,60));
 }
 
+/**********************************************************************************
+ *
+ * Incomplete reassemblies are dropped, oldest first, once they hold more fragment
+ * data than the memory limit allows.
+ *
+ *********************************************************************************/
+
+static void
+test_fragment_memory_limit(void)
+{
+    fragment_head *fd_head;
+    reassembly_table_stats stats;
+    guint32 id;
+
+    printf("Starting test test_fragment_memory_limit\n");
+
+    prefs.reassembly_memory_limit = 1;
+
+    /* 6000 first fragments of 200 bytes each: 1.2MB */
+    for (id = 0; id < 6000; id++) {
+        pinfo.num = id + 1;
+        fd_head=fragment_add_seq(&test_reassembly_table, tvb, 5, &pinfo, id, NULL,
+                                 0, 200, TRUE, 0);
+        ASSERT_EQ_POINTER(NULL,fd_head);
+    }
+
+    reassembly_table_get_stats(&test_reassembly_table, &stats);
+    ASSERT(stats.evicted > 0);
+    ASSERT(stats.pending_bytes <= 1024*1024);
+    ASSERT_EQ(stats.pending, g_hash_table_size(test_reassembly_table.fragment_table));
+    ASSERT(stats.pending_bytes == (guint64)stats.pending * 200);
+    ASSERT_EQ(6000, stats.pending + stats.evicted);
+    ASSERT_EQ(0, stats.completed);
+
+    /* the oldest went first */
+    fd_head=fragment_get(&test_reassembly_table, &pinfo, 0, NULL);
+    ASSERT_EQ_POINTER(NULL,fd_head);
+    fd_head=fragment_get(&test_reassembly_table, &pinfo, 5999, NULL);
+    ASSERT_NE_POINTER(NULL,fd_head);
+
+    /* and the ones that are left can still be completed */
+    pinfo.num = 6001;
+    fd_head=fragment_add_seq(&test_reassembly_table, tvb, 5, &pinfo, 5999, NULL,
+                             1, 50, FALSE, 0);
+    ASSERT_NE_POINTER(NULL,fd_head);
+    ASSERT_EQ(FD_DEFRAGMENTED|FD_BLOCKSEQUENCE|FD_DATALEN_SET,fd_head->flags);
+    ASSERT_EQ(250,tvb_captured_length(fd_head->tvb_data));
+
+    reassembly_table_get_stats(&test_reassembly_table, &stats);
+    ASSERT_EQ(1, stats.completed);
+    ASSERT(stats.completed_bytes == 250);
+
+    prefs.reassembly_memory_limit = 0;
+}
+
+
+/**********************************************************************************
+ *
+ * Composite reassembly must produce the same data, and flag the same overlaps,
+ * as reassembly by copying.
+ *
+ *********************************************************************************/
+
+/* Overlapping and conflicting fragments at byte offsets */
+static fragment_head *
+add_overlapping_fragments(void)
+{
+    fragment_head *fd_head;
+
+    pinfo.num = 1;
+    fd_head=fragment_add_check(&test_reassembly_table, tvb, 10, &pinfo, 12, NULL,
+                               0, 50, TRUE);
+    ASSERT_EQ_POINTER(NULL,fd_head);
+
+    pinfo.num = 2;
+    fd_head=fragment_add_check(&test_reassembly_table, tvb, 5, &pinfo, 12, NULL,
+                               50, 60, TRUE);
+    ASSERT_EQ_POINTER(NULL,fd_head);
+
+    pinfo.num = 3;
+    fd_head=fragment_add_check(&test_reassembly_table, tvb, 15, &pinfo, 12, NULL,
+                               30, 40, TRUE);
+    ASSERT_EQ_POINTER(NULL,fd_head);
+
+    pinfo.num = 4;
+    fd_head=fragment_add_check(&test_reassembly_table, tvb, 0, &pinfo, 12, NULL,
+                               110, 40, FALSE);
+    return fd_head;
+}
+
+/* Blocks, one of them retransmitted */
+static fragment_head *
+add_duplicate_blocks(void)
+{
+    fragment_head *fd_head;
+
+    pinfo.num = 5;
+    fd_head=fragment_add_seq_check(&test_reassembly_table, tvb, 10, &pinfo, 13, NULL,
+                                   0, 50, TRUE);
+    ASSERT_EQ_POINTER(NULL,fd_head);
+
+    pinfo.num = 6;
+    fd_head=fragment_add_seq_check(&test_reassembly_table, tvb, 5, &pinfo, 13, NULL,
+                                   1, 60, TRUE);
+    ASSERT_EQ_POINTER(NULL,fd_head);
+
+    pinfo.num = 7;
+    fd_head=fragment_add_seq_check(&test_reassembly_table, tvb, 5, &pinfo, 13, NULL,
+                                   1, 60, TRUE);
+    ASSERT_EQ_POINTER(NULL,fd_head);
+
+    pinfo.num = 8;
+    fd_head=fragment_add_seq_check(&test_reassembly_table, tvb, 20, &pinfo, 13, NULL,
+                                   2, 30, FALSE);
+    return fd_head;
+}
+
+static void
+test_composite_reassembly_work(fragment_head *(*add_fragments)(void))
+{
+    fragment_head *fd_head;
+    fragment_item *fd;
+    guint8 *copied;
+    guint copied_len, copied_flags, frag_flags[8], nfrags, i;
+
+    /* by copying */
+    fd_head = add_fragments();
+    ASSERT_NE_POINTER(NULL,fd_head);
+    ASSERT(fd_head->flags & FD_DEFRAGMENTED);
+    copied_len = tvb_captured_length(fd_head->tvb_data);
+    copied = (guint8 *)tvb_memdup(NULL, fd_head->tvb_data, 0, copied_len);
+    copied_flags = fd_head->flags;
+    for (nfrags = 0, fd = fd_head->next; fd && nfrags < 8; fd = fd->next)
+        frag_flags[nfrags++] = fd->flags;
+
+    reassembly_table_destroy(&test_reassembly_table);
+    reassembly_table_set_composite(&test_reassembly_table, TRUE);
+    reassembly_table_init(&test_reassembly_table,
+                          &addresses_reassembly_table_functions);
+
+    /* as a composite */
+    fd_head = add_fragments();
+    ASSERT_NE_POINTER(NULL,fd_head);
+    ASSERT_EQ(copied_flags,fd_head->flags);
+    ASSERT_EQ(copied_len,tvb_captured_length(fd_head->tvb_data));
+    ASSERT(!tvb_memeql(fd_head->tvb_data, 0, copied, copied_len));
+    for (i = 0, fd = fd_head->next; fd && i < 8; fd = fd->next, i++) {
+        ASSERT_EQ(frag_flags[i],fd->flags);
+        ASSERT_EQ_POINTER(NULL,fd->tvb_data);
+    }
+    ASSERT_EQ(nfrags,i);
+
+    wmem_free(NULL, copied);
+    reassembly_table_set_composite(&test_reassembly_table, FALSE);
+}
+
+static void
+test_composite_fragment_add_check(void)
+{
+    printf("Starting test test_composite_fragment_add_check\n");
+    test_composite_reassembly_work(add_overlapping_fragments);
+}
+
+static void
+test_composite_fragment_add_seq_check(void)
+{
+    printf("Starting test test_composite_fragment_add_seq_check\n");
+    test_composite_reassembly_work(add_duplicate_blocks);
+}
+
 
 #if 0
 /* XXX remove this? fragment_add_seq does not have the special case for
@@ -1547,6 +1717,9 @@ main(int argc _U_, char **argv _U_)
         test_fragment_add_seq_802_11_0,
         test_fragment_add_seq_802_11_1,
         test_simple_fragment_add_seq_next,
+        test_fragment_memory_limit,
+        test_composite_fragment_add_check,
+        test_composite_fragment_add_seq_check,
 #if 0
         test_missing_data_fragment_add_seq_next,
         test_missing_data_fragment_add_seq_next_2,
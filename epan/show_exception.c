@@ -40,6 +40,45 @@ static expert_field ei_malformed_dissector_bug = EI_INIT;
 static expert_field ei_malformed_reassembly = EI_INIT;
 static expert_field ei_malformed = EI_INIT;
 
+/* Number of exceptions shown for each protocol */
+typedef struct {
+	guint64 exceptions;
+	guint64 truncated;	/* ... of which BoundsErrors */
+} exception_counts_t;
+
+static GHashTable *exception_counts = NULL;
+
+static void
+count_exception(const char *proto_name, unsigned long exception)
+{
+	exception_counts_t *counts;
+
+	if (proto_name == NULL)
+		return;
+	if (exception_counts == NULL)
+		exception_counts = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+
+	counts = (exception_counts_t *)g_hash_table_lookup(exception_counts, proto_name);
+	if (counts == NULL) {
+		counts = g_new0(exception_counts_t, 1);
+		g_hash_table_insert(exception_counts, g_strdup(proto_name), counts);
+	}
+	counts->exceptions++;
+	if (exception == BoundsError)
+		counts->truncated++;
+}
+
+void
+show_exception_get_counts(const char *proto_name, guint64 *exceptions, guint64 *truncated)
+{
+	exception_counts_t *counts = NULL;
+
+	if (exception_counts != NULL)
+		counts = (exception_counts_t *)g_hash_table_lookup(exception_counts, proto_name);
+	*exceptions = counts ? counts->exceptions : 0;
+	*truncated = counts ? counts->truncated : 0;
+}
+
 void
 register_show_exception(void)
 {
@@ -80,6 +119,8 @@ show_exception(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
 	if (exception == ReportedBoundsError && pinfo->fragmented)
 		exception = FragmentBoundsError;
 
+	count_exception(pinfo->current_proto, exception);
+
 	switch (exception) {
 
 	case ScsiBoundsError:
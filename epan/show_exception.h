@@ -33,6 +33,15 @@ WS_DLL_PUBLIC
 void show_exception(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
     unsigned long exception, const char *exception_message);
 
+/*
+ * Get the number of exceptions shown for the protocol with the given short
+ * name, and how many of them were BoundsErrors, i.e. due to the capture's
+ * snapshot length; both are 0 if there were none.
+ */
+WS_DLL_PUBLIC
+void show_exception_get_counts(const char *proto_name, guint64 *exceptions,
+    guint64 *truncated);
+
 /*
  * Routine used to add an indication of a ReportedBoundsError exception
  * to the tree.
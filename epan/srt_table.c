@@ -79,6 +79,7 @@ free_srt_table_data(srt_stat_table *rst)
     for(i=0;i<rst->num_procs;i++){
         g_free(rst->procedures[i].procedure);
         rst->procedures[i].procedure=NULL;
+        time_hist_free(&rst->procedures[i].hist);
     }
     g_free(rst->filter_string);
     rst->filter_string=NULL;
@@ -118,6 +119,7 @@ static void reset_srt_table_data(srt_stat_table *rst)
 
     for(i=0;i<rst->num_procs;i++){
         time_stat_init(&rst->procedures[i].stats);
+        time_hist_free(&rst->procedures[i].hist);
     }
 }
 
@@ -233,6 +235,7 @@ init_srt_table(const char *name, const char *short_name, GArray *srt_array, int
     table->procedures=(srt_procedure_t *)g_malloc(sizeof(srt_procedure_t)*num_procs);
     for(i=0;i<num_procs;i++){
         time_stat_init(&table->procedures[i].stats);
+        time_hist_init(&table->procedures[i].hist);
         table->procedures[i].proc_index = 0;
         table->procedures[i].procedure = NULL;
     }
@@ -259,6 +262,7 @@ init_srt_table_row(srt_stat_table *rst, int indx, const char *procedure)
         rst->procedures=(srt_procedure_t *)g_realloc(rst->procedures, sizeof(srt_procedure_t)*(rst->num_procs));
         for(i=old_num_procs;i<rst->num_procs;i++){
             time_stat_init(&rst->procedures[i].stats);
+            time_hist_init(&rst->procedures[i].hist);
             rst->procedures[i].proc_index = i;
             rst->procedures[i].procedure=NULL;
         }
@@ -281,6 +285,7 @@ add_srt_table_data(srt_stat_table *rst, int indx, const nstime_t *req_time, pack
     nstime_delta(&delta, &t, req_time);
 
     time_stat_update(&rp->stats, &delta, pinfo);
+    time_hist_update(&rp->hist, &delta);
 }
 
 /*
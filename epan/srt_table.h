@@ -36,6 +36,7 @@ typedef struct _srt_procedure_t {
 	int  proc_index;
 	timestat_t stats;   /**< stats */
 	char *procedure;   /**< column entries */
+	time_hist_t hist;   /**< response times, for percentiles */
 } srt_procedure_t;
 
 /** Statistics table */
@@ -217,6 +217,7 @@ stats_tree_reinit(void *p)
     }
 
     st->root.children = NULL;
+    st->root.last_child = NULL;
     st->root.counter = 0;
     st->root.total = 0;
     st->root.minvalue = G_MAXINT;
@@ -447,7 +448,6 @@ new_stat_node(stats_tree *st, const gchar *name, int parent_id,
 {
 
     stat_node *node = (stat_node *)g_malloc0(sizeof(stat_node));
-    stat_node *last_chld = NULL;
 
     node->minvalue = G_MAXINT;
     node->maxvalue = G_MININT;
@@ -482,17 +482,12 @@ new_stat_node(stats_tree *st, const gchar *name, int parent_id,
 
     if (node->parent->children) {
         /* insert as last child */
-
-        for (last_chld = node->parent->children;
-             last_chld->next;
-             last_chld = last_chld->next ) ;
-
-        last_chld->next = node;
-
+        node->parent->last_child->next = node;
     } else {
         /* insert as first child */
         node->parent->children = node;
     }
+    node->parent->last_child = node;
 
     if(node->parent->hash) {
         g_hash_table_insert(node->parent->hash,node->name,node);
@@ -614,32 +609,10 @@ update_burst_calc(stat_node *node, gint value)
     }
 }
 
-/*
- * Increases by delta the counter of the node whose name is given
- * if the node does not exist yet it's created (with counter=1)
- * using parent_name as parent node.
- * with_hash=TRUE to indicate that the created node will have a parent
- */
-extern int
-stats_tree_manip_node(manip_node_mode mode, stats_tree *st, const char *name,
-              int parent_id, gboolean with_hash, gint value)
+/* applies a manip_node_mode operation to a node */
+static void
+manip_stat_node(manip_node_mode mode, stat_node *node, gint value)
 {
-    stat_node *node = NULL;
-    stat_node *parent = NULL;
-
-    g_assert( parent_id >= 0 && parent_id < (int) st->parents->len );
-
-    parent = (stat_node *)g_ptr_array_index(st->parents,parent_id);
-
-    if( parent->hash ) {
-        node = (stat_node *)g_hash_table_lookup(parent->hash,name);
-    } else {
-        node = (stat_node *)g_hash_table_lookup(st->names,name);
-    }
-
-    if ( node == NULL )
-        node = new_stat_node(st,name,parent_id,with_hash,with_hash);
-
     switch (mode) {
         case MN_INCREASE:
             node->counter += value;
@@ -667,6 +640,35 @@ stats_tree_manip_node(manip_node_mode mode, stats_tree *st, const char *name,
             node->st_flags &= ~value;
             break;
     }
+}
+
+/*
+ * Increases by delta the counter of the node whose name is given
+ * if the node does not exist yet it's created (with counter=1)
+ * using parent_name as parent node.
+ * with_hash=TRUE to indicate that the created node will have a parent
+ */
+extern int
+stats_tree_manip_node(manip_node_mode mode, stats_tree *st, const char *name,
+              int parent_id, gboolean with_hash, gint value)
+{
+    stat_node *node = NULL;
+    stat_node *parent = NULL;
+
+    g_assert( parent_id >= 0 && parent_id < (int) st->parents->len );
+
+    parent = (stat_node *)g_ptr_array_index(st->parents,parent_id);
+
+    if( parent->hash ) {
+        node = (stat_node *)g_hash_table_lookup(parent->hash,name);
+    } else {
+        node = (stat_node *)g_hash_table_lookup(st->names,name);
+    }
+
+    if ( node == NULL )
+        node = new_stat_node(st,name,parent_id,with_hash,with_hash);
+
+    manip_stat_node(mode, node, value);
 
     if (node)
         return node->id;
@@ -674,6 +676,25 @@ stats_tree_manip_node(manip_node_mode mode, stats_tree *st, const char *name,
         return -1;
 }
 
+/*
+ * Same as stats_tree_manip_node() but for a node that already exists and
+ * whose id (as returned by stats_tree_create_node() and friends) is known,
+ * which saves the name lookup on every tick.
+ */
+extern int
+stats_tree_manip_node_by_id(manip_node_mode mode, stats_tree *st, int node_id,
+              gint value)
+{
+    stat_node *node;
+
+    g_assert( node_id > 0 && node_id < (int) st->parents->len );
+
+    node = (stat_node *)g_ptr_array_index(st->parents,node_id);
+    manip_stat_node(mode, node, value);
+
+    return node_id;
+}
+
 
 extern char*
 stats_tree_get_abbr(const char *opt_arg)
@@ -206,6 +206,19 @@ WS_DLL_PUBLIC int stats_tree_manip_node(manip_node_mode mode,
                                         gboolean with_children,
                                         gint value);
 
+/*
+ * manipulates the value of an existing node by its id, as returned by
+ * stats_tree_create_node() and friends; cheaper than looking it up by
+ * name on every packet
+ */
+WS_DLL_PUBLIC int stats_tree_manip_node_by_id(manip_node_mode mode,
+                                              stats_tree *st,
+                                              int node_id,
+                                              gint value);
+
+#define tick_stat_node_by_id(st,node_id)                                \
+    (stats_tree_manip_node_by_id(MN_INCREASE,(st),(node_id),1))
+
 #define increase_stat_node(st,name,parent_id,with_children,value)       \
     (stats_tree_manip_node(MN_INCREASE,(st),(name),(parent_id),(with_children),(value)))
 
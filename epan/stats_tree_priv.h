@@ -91,6 +91,7 @@ struct _stat_node {
 	/** relatives */
 	stat_node		*parent;
 	stat_node		*children;
+	stat_node		*last_child;	/**< tail of children, for appending */
 	stat_node		*next;
 
 	/** used to check if value is within range */
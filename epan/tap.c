@@ -41,6 +41,7 @@
 #include <epan/tap.h>
 #include <wsutil/ws_printf.h> /* ws_g_warning */
 #include <wsutil/glib-compat.h>
+#include <wsutil/ws_trace.h>
 
 static gboolean tapping_is_active=FALSE;
 
@@ -100,6 +101,8 @@ typedef struct _tap_listener_t {
 	guint flags;
 	gchar *fstring;
 	dfilter_t *code;
+	guint filter_pass;	/* tap_push_pass for which filter_passed is valid */
+	gboolean filter_passed;
 	void *tapdata;
 	tap_reset_cb reset;
 	tap_packet_cb packet;
@@ -107,6 +110,11 @@ typedef struct _tap_listener_t {
 } tap_listener_t;
 static volatile tap_listener_t *tap_listener_queue=NULL;
 
+/* Bumped for every frame pushed to the listeners, so that a listener's
+   filter is only applied once per frame however many times its tap was
+   queued. */
+static guint tap_push_pass;
+
 #ifdef HAVE_PLUGINS
 
 #include <gmodule.h>
@@ -343,6 +351,35 @@ tap_queue_init(epan_dissect_t *edt)
 	tap_build_interesting (edt);
 }
 
+/* Returns whether the frame in edt passes the listener's filter, applying
+   the filter at most once per frame. Listeners registered with the same
+   filter string (several IO graph lines, say) share the result, so the
+   filter is only applied by the first of them.
+*/
+static gboolean
+tap_listener_filter_passed(volatile tap_listener_t *tl, epan_dissect_t *edt)
+{
+	volatile tap_listener_t *tl2;
+
+	if(tl->filter_pass==tap_push_pass){
+		return tl->filter_passed;
+	}
+
+	for(tl2=tap_listener_queue;tl2;tl2=tl2->next){
+		if(tl2!=tl && tl2->filter_pass==tap_push_pass && tl2->code &&
+		    strcmp(tl2->fstring, tl->fstring)==0){
+			tl->filter_passed=tl2->filter_passed;
+			break;
+		}
+	}
+	if(!tl2){
+		tl->filter_passed=dfilter_apply_edt(tl->code, edt);
+	}
+	tl->filter_pass=tap_push_pass;
+
+	return tl->filter_passed;
+}
+
 /* this function is called after a packet has been fully dissected to push the tapped
    data to all extensions that has callbacks registered.
 */
@@ -365,8 +402,17 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 		return;
 	}
 
+	WS_TRACE1(tap_push_entry, edt->pi.num);
+
+	/* zero means "never evaluated" in filter_pass, so skip it */
+	if(++tap_push_pass==0){
+		tap_push_pass=1;
+	}
+
 	/* loop over all tap listeners and call the listener callback
-	   for all packets that match the filter. */
+	   for all packets that match the filter. The filter result depends
+	   only on the frame, not on the tapped data, so it is cached in the
+	   listener for the rest of this frame. */
 	for(i=0;i<tap_packet_index;i++){
 		for(tl=tap_listener_queue;tl;tl=tl->next){
 			tp=&tap_packet_array[i];
@@ -376,7 +422,7 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 				if(tp->tap_id==tl->tap_id){
 					gboolean passed=TRUE;
 					if(tl->code){
-						passed=dfilter_apply_edt(tl->code, edt);
+						passed=tap_listener_filter_passed(tl, edt);
 					}
 					if(passed && tl->packet){
 						tl->needs_redraw|=tl->packet(tl->tapdata, tp->pinfo, edt, tp->tap_specific_data);
@@ -385,6 +431,8 @@ tap_push_tapped_queue(epan_dissect_t *edt)
             }
 		}
 	}
+
+	WS_TRACE1(tap_push_return, edt->pi.num);
 }
 
 
@@ -471,6 +519,23 @@ draw_tap_listeners(gboolean draw_all)
 	}
 }
 
+/* Redraw only the tap listener registered with tapdata */
+void
+draw_tap_listener(void *tapdata)
+{
+	volatile tap_listener_t *tl;
+
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		if(tl->tapdata==tapdata){
+			if(tl->draw){
+				tl->draw(tl->tapdata);
+			}
+			tl->needs_redraw=FALSE;
+			break;
+		}
+	}
+}
+
 /* Gets a GList of the tap names. The content of the list
    is owned by the tap table and should not be modified or freed.
    Use g_list_free() when done using the list. */
@@ -702,6 +767,25 @@ tap_listeners_require_dissection(void)
 
 }
 
+/*
+ * Return TRUE if any tap listener other than the one registered with
+ * tapdata requires dissection, FALSE otherwise.
+ */
+gboolean
+tap_listeners_require_dissection_except(void *tapdata)
+{
+	volatile tap_listener_t *tap_queue = tap_listener_queue;
+
+	while(tap_queue) {
+		if(tap_queue->tapdata != tapdata && !(tap_queue->flags & TL_IS_DISSECTOR_HELPER))
+			return TRUE;
+
+		tap_queue = tap_queue->next;
+	}
+
+	return FALSE;
+}
+
 /* Returns TRUE there is an active tap listener for the specified tap id. */
 gboolean
 have_tap_listener(int tap_id)
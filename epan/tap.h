@@ -137,6 +137,11 @@ WS_DLL_PUBLIC void reset_tap_listeners(void);
  */
 WS_DLL_PUBLIC void draw_tap_listeners(gboolean draw_all);
 
+/** Redraw the tap listener that was registered with tapdata, and none
+ * of the others.
+ */
+WS_DLL_PUBLIC void draw_tap_listener(void *tapdata);
+
 /** this function attaches the tap_listener to the named tap.
  * function returns :
  *     NULL: ok.
@@ -230,6 +235,12 @@ WS_DLL_PUBLIC void remove_tap_listener(void *tapdata);
  */
 WS_DLL_PUBLIC gboolean tap_listeners_require_dissection(void);
 
+/**
+ * Return TRUE if any tap listener other than the one registered with
+ * tapdata requires dissection, FALSE otherwise.
+ */
+WS_DLL_PUBLIC gboolean tap_listeners_require_dissection_except(void *tapdata);
+
 /** Returns TRUE there is an active tap listener for the specified tap id. */
 WS_DLL_PUBLIC gboolean have_tap_listener(int tap_id);
 
@@ -23,8 +23,14 @@
 
 #include "config.h"
 
+#include <math.h>
+
+#include <wsutil/bits_ctz.h>
+
 #include "timestats.h"
 
+#define NS_PER_S G_GUINT64_CONSTANT(1000000000)
+
 /* Initialize a timestat_t struct */
 void
 time_stat_init(timestat_t *stats)
@@ -89,6 +95,104 @@ gdouble get_average(const nstime_t *sum, guint32 num)
 	return average;
 }
 
+void
+time_hist_init(time_hist_t *hist)
+{
+	hist->num = 0;
+	hist->counts = NULL;
+}
+
+void
+time_hist_free(time_hist_t *hist)
+{
+	g_free(hist->counts);
+	time_hist_init(hist);
+}
+
+/*
+ * Values below TIME_HIST_SUB_BUCKETS ns have a bucket each; above that,
+ * [2^e, 2^(e+1)) is split into TIME_HIST_SUB_BUCKETS buckets.
+ */
+static guint
+time_hist_bucket(guint64 ns)
+{
+	guint e;
+
+	if (ns < TIME_HIST_SUB_BUCKETS)
+		return (guint)ns;
+	e = ws_ilog2(ns);
+	if (e > TIME_HIST_MAX_EXP)
+		return TIME_HIST_NUM_BUCKETS - 1;
+	return (e - TIME_HIST_SUB_BITS + 1) * TIME_HIST_SUB_BUCKETS +
+		(guint)((ns >> (e - TIME_HIST_SUB_BITS)) & (TIME_HIST_SUB_BUCKETS - 1));
+}
+
+/* The middle of a bucket, in ns */
+static gdouble
+time_hist_bucket_value(guint bucket)
+{
+	guint e, m;
+
+	if (bucket < TIME_HIST_SUB_BUCKETS)
+		return (gdouble)bucket;
+	e = bucket / TIME_HIST_SUB_BUCKETS + TIME_HIST_SUB_BITS - 1;
+	m = bucket % TIME_HIST_SUB_BUCKETS;
+	return ldexp((gdouble)(TIME_HIST_SUB_BUCKETS + m) + 0.5, (int)(e - TIME_HIST_SUB_BITS));
+}
+
+void
+time_hist_update(time_hist_t *hist, const nstime_t *delta)
+{
+	guint64 ns = 0;
+
+	/* A reply before its request says more about clocks than latency */
+	if (delta->secs > 0 || (delta->secs == 0 && delta->nsecs > 0))
+		ns = (guint64)delta->secs * NS_PER_S + (guint64)delta->nsecs;
+
+	if (hist->counts == NULL)
+		hist->counts = g_new0(guint32, TIME_HIST_NUM_BUCKETS);
+	hist->counts[time_hist_bucket(ns)]++;
+	hist->num++;
+}
+
+void
+time_hist_merge(time_hist_t *dst, const time_hist_t *src)
+{
+	guint i;
+
+	if (src->counts == NULL)
+		return;
+	if (dst->counts == NULL)
+		dst->counts = g_new0(guint32, TIME_HIST_NUM_BUCKETS);
+	for (i = 0; i < TIME_HIST_NUM_BUCKETS; i++)
+		dst->counts[i] += src->counts[i];
+	dst->num += src->num;
+}
+
+gdouble
+time_hist_percentile(const time_hist_t *hist, gdouble percentile)
+{
+	guint64 rank, seen = 0;
+	guint i;
+
+	if (hist->num == 0 || hist->counts == NULL)
+		return 0.0;
+
+	/* The smallest sample that at least percentile% of them don't exceed */
+	rank = (guint64)ceil(percentile / 100.0 * hist->num);
+	if (rank < 1)
+		rank = 1;
+	if (rank > hist->num)
+		rank = hist->num;
+
+	for (i = 0; i < TIME_HIST_NUM_BUCKETS; i++) {
+		seen += hist->counts[i];
+		if (seen >= rank)
+			return time_hist_bucket_value(i) / NS_PER_S;
+	}
+	return time_hist_bucket_value(TIME_HIST_NUM_BUCKETS - 1) / NS_PER_S;
+}
+
 /*
  * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
  *
@@ -43,6 +43,24 @@ typedef struct _timestat_t {
 	gdouble variance;
 } timestat_t;
 
+/*
+ * Histogram of time samples, from which percentiles can be read to
+ * within about 2%.  The buckets are log-linear, TIME_HIST_SUB_BUCKETS
+ * of them for each power of two of nanoseconds, so the memory used is
+ * bounded however many samples there are, and two histograms are merged
+ * by adding up their counts.  Samples of 2^43 ns (about 2.4 hours) or
+ * more all go in the last bucket.
+ */
+#define TIME_HIST_SUB_BITS	5
+#define TIME_HIST_SUB_BUCKETS	(1 << TIME_HIST_SUB_BITS)
+#define TIME_HIST_MAX_EXP	42
+#define TIME_HIST_NUM_BUCKETS	((TIME_HIST_MAX_EXP - TIME_HIST_SUB_BITS + 2) * TIME_HIST_SUB_BUCKETS)
+
+typedef struct _time_hist_t {
+	guint32 num;	 /* number of samples */
+	guint32 *counts; /* TIME_HIST_NUM_BUCKETS counts, or NULL before the first sample */
+} time_hist_t;
+
 /* functions */
 
 /* Initialize a timestat_t struct */
@@ -53,6 +71,21 @@ WS_DLL_PUBLIC void time_stat_update(timestat_t *stats, const nstime_t *delta, pa
 
 WS_DLL_PUBLIC gdouble get_average(const nstime_t *sum, guint32 num);
 
+/* Initialize a time_hist_t struct */
+WS_DLL_PUBLIC void time_hist_init(time_hist_t *hist);
+
+/* Free the counts of a time_hist_t struct and initialize it again */
+WS_DLL_PUBLIC void time_hist_free(time_hist_t *hist);
+
+/* Add a sample to a time_hist_t struct */
+WS_DLL_PUBLIC void time_hist_update(time_hist_t *hist, const nstime_t *delta);
+
+/* Add the samples of src to dst */
+WS_DLL_PUBLIC void time_hist_merge(time_hist_t *dst, const time_hist_t *src);
+
+/* The given percentile (0-100) of the samples, in seconds; 0 if there are none */
+WS_DLL_PUBLIC gdouble time_hist_percentile(const time_hist_t *hist, gdouble percentile);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -29,7 +29,10 @@
 
 #include "tvbuff.h"
 #include "exceptions.h"
+#include "charsets.h"
+#include "proto.h"
 #include "wsutil/pint.h"
+#include "wsutil/microbench.h"
 
 gboolean failed = FALSE;
 
@@ -65,6 +68,90 @@ test(tvbuff_t *tvb, const gchar* name,
 		return FALSE;
 	}
 
+	/* Check scatter-gather access and the searches before anything below
+	 * makes a composite tvb flatten itself, so the per-member code gets
+	 * used. */
+	for (i = 0; i < length; i++) {
+		tvb_segment_t	segments[16];
+		guint		num_segments, j, copied = 0;
+
+		num_segments = tvb_get_segments(tvb, i, -1, segments, 16);
+		if (num_segments > 16) {
+			printf("15: Failed TVB=%s Offset=%u %u segments\n",
+					name, i, num_segments);
+			failed = TRUE;
+			return FALSE;
+		}
+		for (j = 0; j < num_segments; j++) {
+			if (copied + segments[j].length > length - i ||
+			    memcmp(segments[j].data, &expected_data[i + copied],
+				   segments[j].length) != 0) {
+				printf("15: Failed TVB=%s Offset=%u Bad segment %u\n",
+						name, i, j);
+				failed = TRUE;
+				return FALSE;
+			}
+			copied += segments[j].length;
+		}
+		if (copied != length - i) {
+			printf("15: Failed TVB=%s Offset=%u segments cover %u bytes "
+					"instead of %u\n", name, i, copied, length - i);
+			failed = TRUE;
+			return FALSE;
+		}
+	}
+
+	for (i = 0; i < length; i++) {
+		guint8		needle = expected_data[(i * 7 + 3) % length];
+		const guint8	*expected_ptr;
+		gint		expected_offset, found;
+		guint		j;
+
+		expected_ptr = (const guint8 *)memchr(&expected_data[i], needle, length - i);
+		expected_offset = expected_ptr ? (gint)(expected_ptr - expected_data) : -1;
+		found = tvb_find_guint8(tvb, i, -1, needle);
+		if (found != expected_offset) {
+			printf("13: Failed TVB=%s Offset=%u tvb_find_guint8(0x%02x) "
+					"%d != expected %d\n",
+					name, i, needle, found, expected_offset);
+			failed = TRUE;
+			return FALSE;
+		}
+
+		/* ws_mempbrk needles are a C string, so skip NULs */
+		if (needle == 0)
+			continue;
+		{
+			ws_mempbrk_pattern	pattern;
+			gchar			needles[3];
+			guchar			found_needle = 0;
+
+			memset(&pattern, 0, sizeof(pattern));
+			needles[0] = (gchar)needle;
+			needles[1] = (gchar)(needle ^ 0x05);
+			needles[2] = '\0';
+			ws_mempbrk_compile(&pattern, needles);
+
+			expected_offset = -1;
+			for (j = i; j < length; j++) {
+				if (expected_data[j] == (guint8)needles[0] ||
+				    expected_data[j] == (guint8)needles[1]) {
+					expected_offset = j;
+					break;
+				}
+			}
+			found = tvb_ws_mempbrk_pattern_guint8(tvb, i, -1, &pattern, &found_needle);
+			if (found != expected_offset ||
+			    (found != -1 && found_needle != expected_data[found])) {
+				printf("14: Failed TVB=%s Offset=%u tvb_ws_mempbrk_pattern_guint8 "
+						"%d != expected %d\n",
+						name, i, found, expected_offset);
+				failed = TRUE;
+				return FALSE;
+			}
+		}
+	}
+
 	/* Test boundary case. A BoundsError exception should be thrown. */
 	ex_thrown = FALSE;
 	TRY {
@@ -196,6 +283,57 @@ test(tvbuff_t *tvb, const gchar* name,
 		return FALSE;
 	}
 
+	/* Check views, and that one past the end throws. */
+	for (i = 0; i + 4 <= length; i++) {
+		tvb_view_t	view;
+
+		tvb_get_view(tvb, i, length - i, &view);
+		if (view.length != length - i ||
+		    tvb_view_get_ntohs(&view, 0) != pntoh16(&expected_data[i]) ||
+		    tvb_view_get_ntohl(&view, 0) != pntoh32(&expected_data[i]) ||
+		    tvb_view_get_letohl(&view, 0) != pletoh32(&expected_data[i]) ||
+		    tvb_view_get_guint8(&view, view.length - 1) != expected_data[length - 1]) {
+			printf("16: Failed TVB=%s Offset=%u Bad view\n", name, i);
+			failed = TRUE;
+			return FALSE;
+		}
+	}
+
+	ex_thrown = FALSE;
+	TRY {
+		tvb_view_t	view;
+
+		tvb_get_view(tvb, 0, length + 1, &view);
+	}
+	CATCH(BoundsError) {
+		ex_thrown = TRUE;
+	}
+	CATCH_ALL {
+		printf("16: Caught wrong exception: %lu\n", exc->except_id.except_code);
+	}
+	ENDTRY;
+
+	if (!ex_thrown) {
+		printf("16: Failed TVB=%s No BoundsError for a view of %u bytes\n",
+				name, length + 1);
+		failed = TRUE;
+		return FALSE;
+	}
+
+	/* The non-throwing variant just says whether the bytes are there. */
+	{
+		tvb_view_t	view;
+
+		if (!tvb_try_get_view(tvb, 0, length, &view) ||
+		    view.length != length ||
+		    (length > 0 && tvb_view_get_guint8(&view, 0) != expected_data[0]) ||
+		    tvb_try_get_view(tvb, 0, length + 1, &view)) {
+			printf("17: Failed TVB=%s Bad tvb_try_get_view() of %u/%u bytes\n",
+					name, length, length + 1);
+			failed = TRUE;
+			return FALSE;
+		}
+	}
 
 	/* Check data at boundary. An exception should not be thrown. */
 	if (length >= 4) {
@@ -495,9 +633,304 @@ run_tests(void)
 	tvb_free_chain(tvb_parent);  /* should free all tvb's and associated data */
 }
 
+static void
+check_string(const char *name, guint8 *got, const char *expected)
+{
+	if (strcmp((const char *)got, expected) != 0) {
+		printf("Failed charset %s: got \"%s\", expected \"%s\"\n",
+				name, got, expected);
+		failed = TRUE;
+	} else {
+		printf("Passed charset %s\n", name);
+	}
+	g_free(got);
+}
+
+/* The conversions to UTF-8, with and without characters outside ASCII */
+static void
+run_charset_tests(void)
+{
+	static const guint8 ascii[] = "Content-Type: text/html\x80!";
+	static const guint8 latin1[] = "Caf\xe9 au lait, s'il vous pla\xeet";
+	static const guint8 utf16le[] = {
+		'H', 0, 'i', 0,
+		0x3d, 0xd8, 0x00, 0xde,		/* U+1F600 as a surrogate pair */
+		0xe9, 0x00,
+		0x00, 0xdc,			/* lone trail surrogate, dropped */
+		'!', 0 };
+	static const guint8 ucs2be[] = { 0x20, 0xac, 0x00, '5' };
+
+	check_string("ASCII only", get_ascii_string(NULL, ascii, 23),
+			"Content-Type: text/html");
+	check_string("ASCII", get_ascii_string(NULL, ascii, sizeof ascii - 1),
+			"Content-Type: text/html\xef\xbf\xbd!");
+	check_string("8859-1", get_8859_1_string(NULL, latin1, sizeof latin1 - 1),
+			"Caf\xc3\xa9 au lait, s'il vous pla\xc3\xaet");
+	check_string("UTF-16LE", get_utf_16_string(NULL, utf16le, sizeof utf16le,
+			ENC_LITTLE_ENDIAN), "Hi\xf0\x9f\x98\x80\xc3\xa9!");
+	check_string("UCS-2BE", get_ucs_2_string(NULL, ucs2be, sizeof ucs2be,
+			ENC_BIG_ENDIAN), "\xe2\x82\xac" "5");
+}
+
+#define BENCH_DATA_LEN	(1024 * 1024)
+#define BENCH_MEMBERS	64
+#define BENCH_ROUNDS	64
+
+static void
+report_rate(const char *name, GTimer *timer, guint64 bytes)
+{
+	gdouble secs = g_timer_elapsed(timer, NULL);
+
+	printf("%-40s %8.3f GB/s\n", name,
+			secs > 0 ? (gdouble)bytes / secs / 1e9 : 0.0);
+}
+
+/* Search throughput for each kernel. The needles never occur, so every
+ * search scans the whole buffer. */
+static void
+run_benchmarks(void)
+{
+	static ws_mempbrk_pattern pbrk_few, pbrk_many, pbrk_portable;
+	guint8		*data;
+	tvbuff_t	*tvb_real, *tvb_comp, *tvb_member;
+	GTimer		*timer;
+	gint		next_offset, offset;
+	int		i;
+	guint		member_len = BENCH_DATA_LEN / BENCH_MEMBERS;
+
+	data = (guint8 *)g_malloc(BENCH_DATA_LEN);
+	memset(data, 'x', BENCH_DATA_LEN);
+
+	ws_mempbrk_compile(&pbrk_few, "\r\n");
+	ws_mempbrk_compile(&pbrk_many, "\r\n\"<>;,:");
+	ws_mempbrk_compile(&pbrk_portable, "\r\n\"<>;,:@[]{}()/?=");
+
+	tvb_real = tvb_new_real_data(data, BENCH_DATA_LEN, BENCH_DATA_LEN);
+	tvb_comp = tvb_new_composite();
+	for (i = 0; i < BENCH_MEMBERS; i++) {
+		tvb_member = tvb_new_subset_length(tvb_real, i * member_len, member_len);
+		tvb_composite_append(tvb_comp, tvb_member);
+	}
+	tvb_composite_finalize(tvb_comp);
+
+	timer = g_timer_new();
+
+	g_timer_start(timer);
+	for (i = 0; i < BENCH_ROUNDS; i++)
+		tvb_find_guint8(tvb_real, 0, -1, '\r');
+	report_rate("tvb_find_guint8", timer, (guint64)BENCH_DATA_LEN * BENCH_ROUNDS);
+
+	g_timer_start(timer);
+	for (i = 0; i < BENCH_ROUNDS; i++)
+		tvb_ws_mempbrk_pattern_guint8(tvb_real, 0, -1, &pbrk_few, NULL);
+	report_rate("tvb_ws_mempbrk (2 needles)", timer, (guint64)BENCH_DATA_LEN * BENCH_ROUNDS);
+
+	g_timer_start(timer);
+	for (i = 0; i < BENCH_ROUNDS; i++)
+		tvb_ws_mempbrk_pattern_guint8(tvb_real, 0, -1, &pbrk_many, NULL);
+	report_rate("tvb_ws_mempbrk (8 needles)", timer, (guint64)BENCH_DATA_LEN * BENCH_ROUNDS);
+
+	g_timer_start(timer);
+	for (i = 0; i < BENCH_ROUNDS; i++)
+		tvb_ws_mempbrk_pattern_guint8(tvb_real, 0, -1, &pbrk_portable, NULL);
+	report_rate("tvb_ws_mempbrk (17 needles)", timer, (guint64)BENCH_DATA_LEN * BENCH_ROUNDS);
+
+	g_timer_start(timer);
+	for (i = 0; i < BENCH_ROUNDS; i++)
+		tvb_find_guint8(tvb_comp, 0, -1, '\r');
+	report_rate("tvb_find_guint8 (composite)", timer, (guint64)BENCH_DATA_LEN * BENCH_ROUNDS);
+
+	g_timer_start(timer);
+	for (i = 0; i < BENCH_ROUNDS; i++)
+		tvb_ws_mempbrk_pattern_guint8(tvb_comp, 0, -1, &pbrk_few, NULL);
+	report_rate("tvb_ws_mempbrk (composite, 2 needles)", timer, (guint64)BENCH_DATA_LEN * BENCH_ROUNDS);
+
+	/* 80-byte lines, as in a text protocol */
+	for (offset = 79; offset < BENCH_DATA_LEN; offset += 80)
+		data[offset] = '\n';
+	g_timer_start(timer);
+	for (i = 0; i < BENCH_ROUNDS; i++) {
+		for (offset = 0; offset < BENCH_DATA_LEN; offset = next_offset) {
+			tvb_find_line_end(tvb_real, offset, -1, &next_offset, FALSE);
+		}
+	}
+	report_rate("tvb_find_line_end (80-byte lines)", timer, (guint64)BENCH_DATA_LEN * BENCH_ROUNDS);
+
+	g_timer_destroy(timer);
+	tvb_free_chain(tvb_real);
+	g_free(data);
+}
+
+#define ACCESSOR_DATA_LEN	(64 * 1024)
+#define ACCESSOR_MEMBERS	16
+
+typedef struct {
+	tvbuff_t	*tvb;
+	guint		 len;
+	guint8		 buf[64];
+} accessor_bench_t;
+
+/* Keeps the compiler from dropping the reads */
+static volatile guint64 accessor_sink;
+
+static void
+bench_get_guint8(gpointer data)
+{
+	accessor_bench_t *b = (accessor_bench_t *)data;
+	guint64 sum = 0;
+	guint offset;
+
+	for (offset = 0; offset < b->len; offset++)
+		sum += tvb_get_guint8(b->tvb, offset);
+	accessor_sink += sum;
+}
+
+static void
+bench_get_ntohs(gpointer data)
+{
+	accessor_bench_t *b = (accessor_bench_t *)data;
+	guint64 sum = 0;
+	guint offset;
+
+	for (offset = 0; offset + 2 <= b->len; offset += 2)
+		sum += tvb_get_ntohs(b->tvb, offset);
+	accessor_sink += sum;
+}
+
+static void
+bench_get_ntohl(gpointer data)
+{
+	accessor_bench_t *b = (accessor_bench_t *)data;
+	guint64 sum = 0;
+	guint offset;
+
+	for (offset = 0; offset + 4 <= b->len; offset += 4)
+		sum += tvb_get_ntohl(b->tvb, offset);
+	accessor_sink += sum;
+}
+
+static void
+bench_get_letoh64(gpointer data)
+{
+	accessor_bench_t *b = (accessor_bench_t *)data;
+	guint64 sum = 0;
+	guint offset;
+
+	for (offset = 0; offset + 8 <= b->len; offset += 8)
+		sum += tvb_get_letoh64(b->tvb, offset);
+	accessor_sink += sum;
+}
+
+static void
+bench_memcpy(gpointer data)
+{
+	accessor_bench_t *b = (accessor_bench_t *)data;
+	guint offset;
+
+	for (offset = 0; offset + sizeof b->buf <= b->len; offset += sizeof b->buf)
+		tvb_memcpy(b->tvb, b->buf, offset, sizeof b->buf);
+	accessor_sink += b->buf[0];
+}
+
+/* Per-call cost of the accessors on each kind of tvb. The composite's
+ * members are 4 KiB, so only a few of the reads straddle two of them. */
+static void
+run_accessor_benchmarks(void)
+{
+	static const struct {
+		const char		*name;
+		ws_microbench_func	 func;
+		guint			 width;
+	} accessors[] = {
+		{ "tvb_get_guint8",	bench_get_guint8,	1 },
+		{ "tvb_get_ntohs",	bench_get_ntohs,	2 },
+		{ "tvb_get_ntohl",	bench_get_ntohl,	4 },
+		{ "tvb_get_letoh64",	bench_get_letoh64,	8 },
+		{ "tvb_memcpy (64 bytes)", bench_memcpy,	64 }
+	};
+	guint8		*data;
+	tvbuff_t	*tvb_real, *tvb_subset, *tvb_comp;
+	tvbuff_t	*tvbs[3];
+	const char	*tvb_names[3] = { "real", "subset", "composite" };
+	accessor_bench_t bench;
+	gchar		*name;
+	guint		 member_len = ACCESSOR_DATA_LEN / ACCESSOR_MEMBERS;
+	guint		 i, j;
+
+	data = (guint8 *)g_malloc(ACCESSOR_DATA_LEN + 1);
+	for (i = 0; i < ACCESSOR_DATA_LEN + 1; i++)
+		data[i] = (guint8)i;
+
+	tvb_real = tvb_new_real_data(data, ACCESSOR_DATA_LEN + 1, ACCESSOR_DATA_LEN + 1);
+	/* Off by one, so its reads aren't aligned */
+	tvb_subset = tvb_new_subset_length(tvb_real, 1, ACCESSOR_DATA_LEN);
+	tvb_comp = tvb_new_composite();
+	for (i = 0; i < ACCESSOR_MEMBERS; i++)
+		tvb_composite_append(tvb_comp,
+			tvb_new_subset_length(tvb_real, i * member_len, member_len));
+	tvb_composite_finalize(tvb_comp);
+
+	tvbs[0] = tvb_real;
+	tvbs[1] = tvb_subset;
+	tvbs[2] = tvb_comp;
+
+	printf("\n");
+	ws_microbench_header();
+	for (i = 0; i < G_N_ELEMENTS(accessors); i++) {
+		for (j = 0; j < G_N_ELEMENTS(tvbs); j++) {
+			bench.tvb = tvbs[j];
+			bench.len = ACCESSOR_DATA_LEN;
+			name = g_strdup_printf("%s (%s)", accessors[i].name, tvb_names[j]);
+			ws_microbench_run(name, ACCESSOR_DATA_LEN / accessors[i].width,
+					accessors[i].func, &bench);
+			g_free(name);
+		}
+	}
+
+	tvb_free(tvb_comp);
+	tvb_free_chain(tvb_real);
+	g_free(data);
+}
+
+#define SUBSET_LAYERS	10
+#define SUBSET_PACKETS	10000
+
+static void
+bench_subset_chain(gpointer data)
+{
+	guint8		*packet = (guint8 *)data;
+	tvbuff_t	*tvb, *layer;
+	int		 i, j;
+
+	/* What a dissection does with its tvbs: a subset per layer, all
+	 * freed with the frame's tvb */
+	for (i = 0; i < SUBSET_PACKETS; i++) {
+		tvb = tvb_new_real_data(packet, 1500, 1500);
+		layer = tvb;
+		for (j = 0; j < SUBSET_LAYERS; j++)
+			layer = tvb_new_subset_remaining(layer, 14);
+		tvb_free_chain(tvb);
+	}
+}
+
+/* Cost of creating and freeing the tvbs of a packet, per tvb */
+static void
+run_subset_benchmarks(void)
+{
+	guint8 *packet;
+
+	packet = (guint8 *)g_malloc0(1500);
+	printf("\n");
+	ws_microbench_header();
+	ws_microbench_run("tvb_new_subset_remaining + tvb_free_chain",
+			(guint64)SUBSET_PACKETS * (SUBSET_LAYERS + 1),
+			bench_subset_chain, packet);
+	g_free(packet);
+}
+
 /* Note: valgrind can be used to check for tvbuff memory leaks */
 int
-main(void)
+main(int argc, char **argv)
 {
 	/* For valgrind: See GLib documentation: "Running GLib Applications" */
 	g_setenv("G_DEBUG", "gc-friendly", 1);
@@ -505,6 +938,14 @@ main(void)
 
 	except_init();
 	run_tests();
+	run_charset_tests();
+	/* "tvbtest --benchmark" also reports search throughput and the
+	 * cost of the accessors and of creating tvbs */
+	if (argc > 1 && strcmp(argv[1], "--benchmark") == 0) {
+		run_benchmarks();
+		run_accessor_benchmarks();
+		run_subset_benchmarks();
+	}
 	except_deinit();
 	exit(failed?1:0);
 }
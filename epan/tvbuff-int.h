@@ -37,6 +37,8 @@ struct tvb_ops {
 	gint (*tvb_ws_mempbrk_pattern_guint8)(tvbuff_t *tvb, guint abs_offset, guint limit, const ws_mempbrk_pattern* pattern, guchar *found_needle);
 
 	tvbuff_t *(*tvb_clone)(tvbuff_t *tvb, guint abs_offset, guint abs_length);
+
+	guint (*tvb_get_segments)(tvbuff_t *tvb, guint abs_offset, guint abs_length, tvb_segment_t *segments, guint max_segments);
 };
 
 /*
@@ -76,15 +76,50 @@ ensure_contiguous(tvbuff_t *tvb, const gint offset, const gint length);
 static inline guint8 *
 tvb_get_raw_string(wmem_allocator_t *scope, tvbuff_t *tvb, const gint offset, const gint length);
 
+/*
+ * A dissection creates and frees a tvbuff for nearly every layer, and
+ * most of them are subsets of the same few sizes.  Freed tvbuffs of up
+ * to TVB_POOL_MAX_WORDS pointers are kept, linked by their next
+ * pointers, in a list for their size, and the next tvb_new() of that
+ * size takes one from there without going to the allocator.  As with
+ * the rest of epan, this assumes one thread does the dissecting.
+ */
+#define TVB_POOL_MAX_WORDS	16
+#define TVB_POOL_MAX_FREE	256
+
+static struct {
+	tvbuff_t	*free;
+	guint		 count;
+} tvb_pool[TVB_POOL_MAX_WORDS + 1];
+
+static inline guint
+tvb_pool_index(gsize size)
+{
+	return (guint)((size + sizeof(gpointer) - 1) / sizeof(gpointer));
+}
+
 tvbuff_t *
 tvb_new(const struct tvb_ops *ops)
 {
 	tvbuff_t *tvb;
 	gsize     size = ops->tvb_size;
+	guint     pool = tvb_pool_index(size);
 
 	g_assert(size >= sizeof(*tvb));
 
-	tvb = (tvbuff_t *) g_slice_alloc(size);
+	if (pool <= TVB_POOL_MAX_WORDS) {
+		tvb = tvb_pool[pool].free;
+		if (tvb != NULL) {
+			tvb_pool[pool].free = tvb->next;
+			tvb_pool[pool].count--;
+		} else {
+			/* Rounded up, as the block may be reused for any size
+			 * with the same number of words */
+			tvb = (tvbuff_t *) g_slice_alloc(pool * sizeof(gpointer));
+		}
+	} else {
+		tvb = (tvbuff_t *) g_slice_alloc(size);
+	}
 
 	tvb->next	     = NULL;
 	tvb->ops	     = ops;
@@ -103,6 +138,7 @@ static void
 tvb_free_internal(tvbuff_t *tvb)
 {
 	gsize     size;
+	guint     pool;
 
 	DISSECTOR_ASSERT(tvb);
 
@@ -110,6 +146,18 @@ tvb_free_internal(tvbuff_t *tvb)
 		tvb->ops->tvb_free(tvb);
 
 	size = tvb->ops->tvb_size;
+	pool = tvb_pool_index(size);
+
+	if (pool <= TVB_POOL_MAX_WORDS) {
+		if (tvb_pool[pool].count < TVB_POOL_MAX_FREE) {
+			tvb->next = tvb_pool[pool].free;
+			tvb_pool[pool].free = tvb;
+			tvb_pool[pool].count++;
+		} else {
+			g_slice_free1(pool * sizeof(gpointer), tvb);
+		}
+		return;
+	}
 
 	g_slice_free1(size, tvb);
 }
@@ -1897,7 +1945,7 @@ tvb_find_guint8(tvbuff_t *tvb, const gint offset, const gint maxlength, const gu
 	if (tvb->ops->tvb_find_guint8)
 		return tvb->ops->tvb_find_guint8(tvb, abs_offset, limit, needle);
 
-	return tvb_find_guint8_generic(tvb, offset, limit, needle);
+	return tvb_find_guint8_generic(tvb, abs_offset, limit, needle);
 }
 
 /* Same as tvb_find_guint8() with 16bit needle. */
@@ -3597,6 +3645,52 @@ gchar *tvb_bytes_to_str(wmem_allocator_t *allocator, tvbuff_t *tvb,
 	return bytes_to_str(allocator, ensure_contiguous(tvb, offset, len), len);
 }
 
+guint
+tvb_get_segments(tvbuff_t *tvb, const gint offset, const gint length,
+		 tvb_segment_t *segments, const guint max_segments)
+{
+	guint abs_offset = 0, abs_length = 0;
+
+	DISSECTOR_ASSERT(tvb && tvb->initialized);
+
+	check_offset_length(tvb, offset, length, &abs_offset, &abs_length);
+	if (abs_length == 0)
+		return 0;
+
+	if (!tvb->real_data && tvb->ops->tvb_get_segments)
+		return tvb->ops->tvb_get_segments(tvb, abs_offset, abs_length, segments, max_segments);
+
+	/* everything else is contiguous */
+	if (max_segments > 0) {
+		segments[0].data   = ensure_contiguous(tvb, abs_offset, abs_length);
+		segments[0].length = abs_length;
+	}
+	return 1;
+}
+
+void
+tvb_get_view(tvbuff_t *tvb, const gint offset, const gint length, tvb_view_t *view)
+{
+	DISSECTOR_ASSERT(tvb && tvb->initialized);
+	DISSECTOR_ASSERT(length >= 0);
+
+	view->data   = ensure_contiguous(tvb, offset, length);
+	view->length = (guint)length;
+}
+
+gboolean
+tvb_try_get_view(tvbuff_t *tvb, const gint offset, const gint length, tvb_view_t *view)
+{
+	int exception = 0;
+
+	DISSECTOR_ASSERT(tvb && tvb->initialized);
+	DISSECTOR_ASSERT(length >= 0);
+
+	view->data   = ensure_contiguous_no_exception(tvb, offset, length, &exception);
+	view->length = (guint)length;
+	return exception == 0;
+}
+
 /* Find a needle tvbuff within a haystack tvbuff. */
 gint
 tvb_find_tvb(tvbuff_t *haystack_tvb, tvbuff_t *needle_tvb, const gint haystack_offset)
@@ -40,6 +40,7 @@
 
 #include <wsutil/nstime.h>
 #include "wsutil/ws_mempbrk.h"
+#include "wsutil/pint.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -854,6 +855,61 @@ WS_DLL_PUBLIC const gchar *tvb_bcd_dig_to_wmem_packet_str(tvbuff_t *tvb,
     const gint offset, const gint len, const dgt_set_t *dgt,
     gboolean skip_first);
 
+/** A contiguous piece of a tvbuff's data, see tvb_get_segments(). */
+typedef struct {
+	const guint8 *data;
+	guint         length;
+} tvb_segment_t;
+
+/** Describe the 'length' bytes at 'offset' (-1 meaning to the end of the
+ * tvbuff) as a list of contiguous pieces, without copying them. This lets
+ * a dissector read data that spans the members of a composite tvbuff, such
+ * as a reassembled stream, without the tvbuff being flattened.
+ *
+ * Fills in at most 'max_segments' entries of 'segments' and returns the
+ * number of segments the range consists of; if that is more than
+ * 'max_segments', call again with a bigger array. The pointers stay valid
+ * as long as the tvbuff. Throws an exception if the range isn't there,
+ * like tvb_get_ptr(). */
+WS_DLL_PUBLIC guint tvb_get_segments(tvbuff_t *tvb, const gint offset,
+    const gint length, tvb_segment_t *segments, const guint max_segments);
+
+/** A contiguous window on a tvbuff's data whose bounds have been checked
+ * once, see tvb_get_view(). */
+typedef struct {
+	const guint8 *data;
+	guint         length;
+} tvb_view_t;
+
+/** Check that the 'length' bytes at 'offset' exist, throwing the same
+ * exception the tvb_get_ accessors would if they don't, and set up 'view'
+ * to read them with the tvb_view_get_ macros below. Meant for fixed-layout
+ * headers: one bounds check for the whole header instead of one per
+ * field. Like tvb_get_ptr(), this may copy the bytes if they span the
+ * members of a composite tvbuff; the data stays valid as long as the
+ * tvbuff. */
+WS_DLL_PUBLIC void tvb_get_view(tvbuff_t *tvb, const gint offset,
+    const gint length, tvb_view_t *view);
+
+/** Like tvb_get_view(), but returns FALSE instead of throwing an exception
+ * if the bytes don't exist, in which case 'view' must not be read. Lets
+ * code that only peeks at the data (heuristics, "is there more?" checks)
+ * test for a short packet without setting up a TRY block. */
+WS_DLL_PUBLIC gboolean tvb_try_get_view(tvbuff_t *tvb, const gint offset,
+    const gint length, tvb_view_t *view);
+
+/* Read from a view. The offsets are relative to the start of the view and
+ * are NOT checked; the caller must stay within view->length. */
+#define tvb_view_get_guint8(view, off)  ((view)->data[(off)])
+#define tvb_view_get_ntohs(view, off)   pntoh16((view)->data + (off))
+#define tvb_view_get_ntoh24(view, off)  pntoh24((view)->data + (off))
+#define tvb_view_get_ntohl(view, off)   pntoh32((view)->data + (off))
+#define tvb_view_get_ntoh64(view, off)  pntoh64((view)->data + (off))
+#define tvb_view_get_letohs(view, off)  pletoh16((view)->data + (off))
+#define tvb_view_get_letoh24(view, off) pletoh24((view)->data + (off))
+#define tvb_view_get_letohl(view, off)  pletoh32((view)->data + (off))
+#define tvb_view_get_letoh64(view, off) pletoh64((view)->data + (off))
+
 /** Locate a sub-tvbuff within another tvbuff, starting at position
  * 'haystack_offset'. Returns the index of the beginning of 'needle' within
  * 'haystack', or -1 if 'needle' is not found. The index is relative
@@ -30,12 +30,19 @@
 typedef struct {
 	GSList		*tvbs;
 
-	/* Used for quick testing to see if this
-	 * is the tvbuff that a COMPOSITE is
-	 * interested in. */
+	/* Filled in by tvb_composite_finalize(): the members in order, and
+	 * the offsets at which each one starts and ends (inclusive), so the
+	 * member holding an offset can be found by binary search. */
+	tvbuff_t	**members;
+	guint		num_members;
 	guint		*start_offsets;
 	guint		*end_offsets;
 
+	/* Copies made by composite_get_ptr() of ranges spanning members,
+	 * and their total size. */
+	GSList		*copies;
+	guint		copied_length;
+
 } tvb_comp_t;
 
 struct tvb_composite {
@@ -52,8 +59,11 @@ composite_free(tvbuff_t *tvb)
 
 	g_slist_free(composite->tvbs);
 
+	g_free(composite->members);
 	g_free(composite->start_offsets);
 	g_free(composite->end_offsets);
+	g_slist_foreach(composite->copies, (GFunc)g_free, NULL);
+	g_slist_free(composite->copies);
 	if (tvb->real_data) {
 		/*
 		 * XXX - do this with a union?
@@ -71,37 +81,48 @@ composite_offset(const tvbuff_t *tvb, const guint counter)
 	return tvb_offset_from_real_beginning_counter(member, counter);
 }
 
+/* Returns the index of the member holding abs_offset, or num_members if
+ * abs_offset is at (or past) the end. */
+static guint
+composite_member_index(const tvb_comp_t *composite, guint abs_offset)
+{
+	guint lo = 0, hi = composite->num_members, mid;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (composite->end_offsets[mid] < abs_offset)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
 static const guint8*
 composite_get_ptr(tvbuff_t *tvb, guint abs_offset, guint abs_length)
 {
 	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
-	guint	    i, num_members;
+	guint	    i;
 	tvb_comp_t *composite;
-	tvbuff_t   *member_tvb = NULL;
+	tvbuff_t   *member_tvb;
 	guint	    member_offset;
-	GSList	   *slist;
+	guint8	   *copy;
 
 	/* DISSECTOR_ASSERT(tvb->ops == &tvb_composite_ops); */
 
 	/* Maybe the range specified by offset/length
 	 * is contiguous inside one of the member tvbuffs */
 	composite = &composite_tvb->composite;
-	num_members = g_slist_length(composite->tvbs);
-
-	for (i = 0; i < num_members; i++) {
-		if (abs_offset <= composite->end_offsets[i]) {
-			slist = g_slist_nth(composite->tvbs, i);
-			member_tvb = (tvbuff_t *)slist->data;
-			break;
-		}
-	}
+	i = composite_member_index(composite, abs_offset);
 
 	/* special case */
-	if (!member_tvb) {
+	if (i == composite->num_members) {
 		DISSECTOR_ASSERT(abs_offset == tvb->length && abs_length == 0);
 		return "";
 	}
 
+	member_tvb    = composite->members[i];
 	member_offset = abs_offset - composite->start_offsets[i];
 
 	if (tvb_bytes_exist(member_tvb, member_offset, abs_length)) {
@@ -111,7 +132,18 @@ composite_get_ptr(tvbuff_t *tvb, guint abs_offset, guint abs_length)
 		DISSECTOR_ASSERT(!tvb->real_data);
 		return tvb_get_ptr(member_tvb, member_offset, abs_length);
 	}
+	else if (composite->copied_length + abs_length < tvb->length) {
+		/* Copy just the range that spans members; the pointer has to
+		 * stay valid as long as the tvb, so keep it until then. */
+		copy = (guint8 *)g_malloc(abs_length);
+		tvb_memcpy(tvb, copy, abs_offset, abs_length);
+		composite->copies = g_slist_prepend(composite->copies, copy);
+		composite->copied_length += abs_length;
+		return copy;
+	}
 	else {
+		/* We've copied about as much as the whole tvb by now, so
+		 * flatten it once and for all. */
 		/* Use a temporary variable as tvb_memcpy is also checking tvb->real_data pointer */
 		void *real_data = g_malloc(tvb->length);
 		tvb_memcpy(tvb, real_data, 0, tvb->length);
@@ -128,63 +160,126 @@ composite_memcpy(tvbuff_t *tvb, void* _target, guint abs_offset, guint abs_lengt
 	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
 	guint8 *target = (guint8 *) _target;
 
-	guint	    i, num_members;
+	guint	    i;
 	tvb_comp_t *composite;
-	tvbuff_t   *member_tvb = NULL;
 	guint	    member_offset, member_length;
-	GSList	   *slist;
 
 	/* DISSECTOR_ASSERT(tvb->ops == &tvb_composite_ops); */
 
-	/* Maybe the range specified by offset/length
-	 * is contiguous inside one of the member tvbuffs */
-	composite   = &composite_tvb->composite;
-	num_members = g_slist_length(composite->tvbs);
-
-	for (i = 0; i < num_members; i++) {
-		if (abs_offset <= composite->end_offsets[i]) {
-			slist = g_slist_nth(composite->tvbs, i);
-			member_tvb = (tvbuff_t *)slist->data;
-			break;
-		}
-	}
+	composite = &composite_tvb->composite;
+	i = composite_member_index(composite, abs_offset);
 
 	/* special case */
-	if (!member_tvb) {
+	if (i == composite->num_members) {
 		DISSECTOR_ASSERT(abs_offset == tvb->length && abs_length == 0);
 		return target;
 	}
 
-	member_offset = abs_offset - composite->start_offsets[i];
+	/* Copy the part of the range in each member in turn until we have
+	 * copied all data. */
+	while (abs_length > 0) {
+		DISSECTOR_ASSERT(i < composite->num_members);
 
-	if (tvb_bytes_exist(member_tvb, member_offset, abs_length)) {
-		DISSECTOR_ASSERT(!tvb->real_data);
-		return tvb_memcpy(member_tvb, target, member_offset, abs_length);
+		member_offset = abs_offset - composite->start_offsets[i];
+		member_length = composite->end_offsets[i] - abs_offset + 1;
+		if (member_length > abs_length)
+			member_length = abs_length;
+
+		tvb_memcpy(composite->members[i], target, member_offset, member_length);
+		target     += member_length;
+		abs_offset += member_length;
+		abs_length -= member_length;
+		i++;
 	}
-	else {
-		/* The requested data is non-contiguous inside
-		 * the member tvb. We have to memcpy() the part that's in the member tvb,
-		 * then iterate across the other member tvb's, copying their portions
-		 * until we have copied all data.
-		 */
-		member_length = tvb_captured_length_remaining(member_tvb, member_offset);
 
-		/* composite_memcpy() can't handle a member_length of zero. */
-		DISSECTOR_ASSERT(member_length > 0);
+	return _target;
+}
 
-		tvb_memcpy(member_tvb, target, member_offset, member_length);
-		abs_offset	+= member_length;
-		abs_length	-= member_length;
+/* The searches below run over each member in turn instead of going through
+ * the generic code, which would flatten the whole composite tvb first. */
+static gint
+composite_find_guint8(tvbuff_t *tvb, guint abs_offset, guint limit, guint8 needle)
+{
+	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
+	tvb_comp_t *composite = &composite_tvb->composite;
+	guint	    i, member_offset, member_length;
+	gint	    result;
+
+	for (i = composite_member_index(composite, abs_offset);
+	     i < composite->num_members && limit > 0; i++) {
+		member_offset = abs_offset - composite->start_offsets[i];
+		member_length = composite->end_offsets[i] - abs_offset + 1;
+		if (member_length > limit)
+			member_length = limit;
+
+		result = tvb_find_guint8(composite->members[i], member_offset,
+				member_length, needle);
+		if (result != -1)
+			return composite->start_offsets[i] + result;
+
+		abs_offset += member_length;
+		limit      -= member_length;
+	}
 
-		/* Recurse */
-		if (abs_length > 0) {
-			composite_memcpy(tvb, target + member_length, abs_offset, abs_length);
+	return -1;
+}
+
+static gint
+composite_pbrk_guint8(tvbuff_t *tvb, guint abs_offset, guint limit, const ws_mempbrk_pattern* pattern, guchar *found_needle)
+{
+	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
+	tvb_comp_t *composite = &composite_tvb->composite;
+	guint	    i, member_offset, member_length;
+	gint	    result;
+
+	for (i = composite_member_index(composite, abs_offset);
+	     i < composite->num_members && limit > 0; i++) {
+		member_offset = abs_offset - composite->start_offsets[i];
+		member_length = composite->end_offsets[i] - abs_offset + 1;
+		if (member_length > limit)
+			member_length = limit;
+
+		result = tvb_ws_mempbrk_pattern_guint8(composite->members[i],
+				member_offset, member_length, pattern, found_needle);
+		if (result != -1)
+			return composite->start_offsets[i] + result;
+
+		abs_offset += member_length;
+		limit      -= member_length;
+	}
+
+	return -1;
+}
+
+static guint
+composite_get_segments(tvbuff_t *tvb, guint abs_offset, guint abs_length,
+		tvb_segment_t *segments, guint max_segments)
+{
+	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
+	tvb_comp_t *composite = &composite_tvb->composite;
+	guint	    i, member_offset, member_length, count = 0;
+
+	for (i = composite_member_index(composite, abs_offset);
+	     i < composite->num_members && abs_length > 0; i++) {
+		member_offset = abs_offset - composite->start_offsets[i];
+		member_length = composite->end_offsets[i] - abs_offset + 1;
+		if (member_length > abs_length)
+			member_length = abs_length;
+
+		if (count < max_segments) {
+			count += tvb_get_segments(composite->members[i],
+					member_offset, member_length,
+					segments + count, max_segments - count);
+		} else {
+			count += tvb_get_segments(composite->members[i],
+					member_offset, member_length, NULL, 0);
 		}
 
-		return target;
+		abs_offset += member_length;
+		abs_length -= member_length;
 	}
 
-	DISSECTOR_ASSERT_NOT_REACHED();
+	return count;
 }
 
 static const struct tvb_ops tvb_composite_ops = {
@@ -194,9 +289,10 @@ static const struct tvb_ops tvb_composite_ops = {
 	composite_offset,     /* offset */
 	composite_get_ptr,    /* get_ptr */
 	composite_memcpy,     /* memcpy */
-	NULL,                 /* find_guint8 XXX */
-	NULL,                 /* pbrk_guint8 XXX */
+	composite_find_guint8, /* find_guint8 */
+	composite_pbrk_guint8, /* pbrk_guint8 */
 	NULL,                 /* clone */
+	composite_get_segments, /* get_segments */
 };
 
 /*
@@ -215,8 +311,12 @@ tvb_new_composite(void)
 	tvb_comp_t *composite = &composite_tvb->composite;
 
 	composite->tvbs		 = NULL;
+	composite->members	 = NULL;
+	composite->num_members	 = 0;
 	composite->start_offsets = NULL;
 	composite->end_offsets	 = NULL;
+	composite->copies	 = NULL;
+	composite->copied_length = 0;
 
 	return tvb;
 }
@@ -281,12 +381,15 @@ tvb_composite_finalize(tvbuff_t *tvb)
 	 */
 	DISSECTOR_ASSERT(num_members);
 
+	composite->members = g_new(tvbuff_t *, num_members);
+	composite->num_members = num_members;
 	composite->start_offsets = g_new(guint, num_members);
 	composite->end_offsets = g_new(guint, num_members);
 
 	for (slist = composite->tvbs; slist != NULL; slist = slist->next) {
 		DISSECTOR_ASSERT((guint) i < num_members);
 		member_tvb = (tvbuff_t *)slist->data;
+		composite->members[i] = member_tvb;
 		composite->start_offsets[i] = tvb->length;
 		tvb->length += member_tvb->length;
 		tvb->reported_length += member_tvb->reported_length;
@@ -64,6 +64,7 @@ static const struct tvb_ops tvb_real_ops = {
 	NULL,                 /* find_guint8 */
 	NULL,                 /* pbrk_guint8 */
 	NULL,                 /* clone */
+	NULL,                 /* get_segments */
 };
 
 tvbuff_t *
@@ -86,6 +86,14 @@ subset_pbrk_guint8(tvbuff_t *tvb, guint abs_offset, guint limit, const ws_mempbr
 	return tvb_ws_mempbrk_pattern_guint8(subset_tvb->subset.tvb, subset_tvb->subset.offset + abs_offset, limit, pattern, found_needle);
 }
 
+static guint
+subset_get_segments(tvbuff_t *tvb, guint abs_offset, guint abs_length, tvb_segment_t *segments, guint max_segments)
+{
+	struct tvb_subset *subset_tvb = (struct tvb_subset *) tvb;
+
+	return tvb_get_segments(subset_tvb->subset.tvb, subset_tvb->subset.offset + abs_offset, abs_length, segments, max_segments);
+}
+
 static tvbuff_t *
 subset_clone(tvbuff_t *tvb, guint abs_offset, guint abs_length)
 {
@@ -104,6 +112,7 @@ static const struct tvb_ops tvb_subset_ops = {
 	subset_find_guint8,   /* find_guint8 */
 	subset_pbrk_guint8,   /* pbrk_guint8 */
 	subset_clone,         /* clone */
+	subset_get_segments,  /* get_segments */
 };
 
 static tvbuff_t *
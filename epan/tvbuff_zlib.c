@@ -51,17 +51,17 @@
 tvbuff_t *
 tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 {
-	gint       err;
-	guint      bytes_out      = 0;
-	guint8    *compr;
-	guint8    *uncompr        = NULL;
-	tvbuff_t  *uncompr_tvb    = NULL;
-	z_streamp  strm;
-	Bytef     *strmbuf;
-	guint      inits_done     = 0;
-	gint       wbits          = MAX_WBITS;
-	guint8    *next;
-	guint      bufsiz;
+	gint           err;
+	guint          bytes_out      = 0;
+	const guint8  *compr;
+	guint8        *uncompr;
+	gboolean       have_output    = FALSE;
+	tvbuff_t      *uncompr_tvb    = NULL;
+	z_streamp      strm;
+	guint          inits_done     = 0;
+	gint           wbits          = MAX_WBITS;
+	const guint8  *next;
+	guint          bufsiz;
 #ifdef TVB_Z_DEBUG
 	guint      inflate_passes = 0;
 	guint      bytes_in       = tvb_captured_length_remaining(tvb, offset);
@@ -71,14 +71,16 @@ tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 		return NULL;
 	}
 
-	compr = (guint8 *)tvb_memdup(NULL, tvb, offset, comprlen);
+	/* zlib only reads the input, so it needn't be copied */
+	compr = tvb_get_ptr(tvb, offset, comprlen);
 	if (compr == NULL) {
 		return NULL;
 	}
 
 	/*
 	 * Assume that the uncompressed data is at least twice as big as
-	 * the compressed size.
+	 * the compressed size; the data is inflated straight into this
+	 * buffer, which is doubled whenever it fills up.
 	 */
 	bufsiz = tvb_captured_length_remaining(tvb, offset) * 2;
 	bufsiz = CLAMP(bufsiz, TVB_Z_MIN_BUFSIZ, TVB_Z_MAX_BUFSIZ);
@@ -93,62 +95,47 @@ tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 	strm->next_in   = next;
 	strm->avail_in  = comprlen;
 
-	strmbuf         = (Bytef *)g_malloc0(bufsiz);
-	strm->next_out  = strmbuf;
-	strm->avail_out = bufsiz;
+	uncompr         = (guint8 *)g_malloc(bufsiz);
 
 	err = inflateInit2(strm, wbits);
 	inits_done = 1;
 	if (err != Z_OK) {
 		inflateEnd(strm);
 		g_free(strm);
-		wmem_free(NULL, compr);
-		g_free(strmbuf);
+		g_free(uncompr);
 		return NULL;
 	}
 
 	while (1) {
-		memset(strmbuf, '\0', bufsiz);
-		strm->next_out  = strmbuf;
-		strm->avail_out = bufsiz;
+		if (bytes_out == bufsiz) {
+			bufsiz *= 2;
+			uncompr = (guint8 *)g_realloc(uncompr, bufsiz);
+		}
+		strm->next_out  = uncompr + bytes_out;
+		strm->avail_out = bufsiz - bytes_out;
 
 		err = inflate(strm, Z_SYNC_FLUSH);
 
 		if (err == Z_OK || err == Z_STREAM_END) {
-			guint bytes_pass = bufsiz - strm->avail_out;
+			guint bytes_pass = bufsiz - bytes_out - strm->avail_out;
 
 #ifdef TVB_Z_DEBUG
 			++inflate_passes;
 #endif
 
-			if (uncompr == NULL) {
-				/*
-				 * This is ugly workaround for bug #6480
-				 * (https://bugs.wireshark.org/bugzilla/show_bug.cgi?id=6480)
-				 *
-				 * g_memdup(..., 0) returns NULL (g_malloc(0) also)
-				 * when uncompr is NULL logic below doesn't create tvb
-				 * which is later interpreted as decompression failed.
-				 */
-				uncompr = (guint8 *)((bytes_pass || err != Z_STREAM_END) ?
-						g_memdup(strmbuf, bytes_pass) :
-						g_strdup(""));
-			} else {
-				guint8 *new_data = (guint8 *)g_malloc0(bytes_out + bytes_pass);
-
-				memcpy(new_data, uncompr, bytes_out);
-				memcpy(new_data + bytes_out, strmbuf, bytes_pass);
-
-				g_free(uncompr);
-				uncompr = new_data;
-			}
+			/*
+			 * An empty stream that ends properly is a success
+			 * too (bug #6480); anything else has to have
+			 * produced some data.
+			 */
+			if (bytes_pass != 0 || err == Z_STREAM_END)
+				have_output = TRUE;
 
 			bytes_out += bytes_pass;
 
 			if (err == Z_STREAM_END) {
 				inflateEnd(strm);
 				g_free(strm);
-				g_free(strmbuf);
 				break;
 			}
 		} else if (err == Z_BUF_ERROR) {
@@ -159,17 +146,16 @@ tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 			 */
 			inflateEnd(strm);
 			g_free(strm);
-			g_free(strmbuf);
 
-			if (uncompr != NULL) {
+			if (have_output) {
 				break;
 			} else {
-				wmem_free(NULL, compr);
+				g_free(uncompr);
 				return NULL;
 			}
 
 		} else if (err == Z_DATA_ERROR && inits_done == 1
-			&& uncompr == NULL && comprlen >= 2 &&
+			&& !have_output && comprlen >= 2 &&
 			(*compr  == 0x1f) && (*(compr + 1) == 0x8b)) {
 			/*
 			 * inflate() is supposed to handle both gzip and deflate
@@ -185,8 +171,8 @@ tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 			 * fix to make it work (setting windowBits to 31)
 			 * doesn't work with all versions of the library.
 			 */
-			Bytef *c = compr + 2;
-			Bytef  flags = 0;
+			const Bytef *c = compr + 2;
+			Bytef        flags = 0;
 
 			/* we read two bytes already (0x1f, 0x8b) and
 			   need at least Z_DEFLATED, 1 byte flags, 4
@@ -194,8 +180,7 @@ tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 			if (comprlen < 10 || *c != Z_DEFLATED) {
 				inflateEnd(strm);
 				g_free(strm);
-				wmem_free(NULL, compr);
-				g_free(strmbuf);
+				g_free(uncompr);
 				return NULL;
 			}
 
@@ -253,8 +238,7 @@ tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 			if (c - compr > comprlen) {
 				inflateEnd(strm);
 				g_free(strm);
-				wmem_free(NULL, compr);
-				g_free(strmbuf);
+				g_free(uncompr);
 				return NULL;
 			}
 			/* Drop gzip header */
@@ -268,7 +252,7 @@ tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 			inflateEnd(strm);
 			inflateInit2(strm, wbits);
 			inits_done++;
-		} else if (err == Z_DATA_ERROR && uncompr == NULL &&
+		} else if (err == Z_DATA_ERROR && !have_output &&
 			inits_done <= 3) {
 
 			/*
@@ -286,9 +270,6 @@ tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 			strm->avail_in  = comprlen;
 
 			inflateEnd(strm);
-			memset(strmbuf, '\0', bufsiz);
-			strm->next_out  = strmbuf;
-			strm->avail_out = bufsiz;
 
 			err = inflateInit2(strm, wbits);
 
@@ -296,8 +277,6 @@ tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 
 			if (err != Z_OK) {
 				g_free(strm);
-				g_free(strmbuf);
-				wmem_free(NULL, compr);
 				g_free(uncompr);
 
 				return NULL;
@@ -305,10 +284,9 @@ tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 		} else {
 			inflateEnd(strm);
 			g_free(strm);
-			g_free(strmbuf);
 
-			if (uncompr == NULL) {
-				wmem_free(NULL, compr);
+			if (!have_output) {
+				g_free(uncompr);
 				return NULL;
 			}
 
@@ -321,11 +299,11 @@ tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 	ws_debug_printf("bytes  in: %u\nbytes out: %u\n\n", bytes_in, bytes_out);
 #endif
 
-	if (uncompr != NULL) {
-		uncompr_tvb =  tvb_new_real_data((guint8*) uncompr, bytes_out, bytes_out);
-		tvb_set_free_cb(uncompr_tvb, g_free);
-	}
-	wmem_free(NULL, compr);
+	/* Give back what the last doubling didn't need */
+	if (bytes_out < bufsiz)
+		uncompr = (guint8 *)g_realloc(uncompr, bytes_out ? bytes_out : 1);
+	uncompr_tvb =  tvb_new_real_data((guint8*) uncompr, bytes_out, bytes_out);
+	tvb_set_free_cb(uncompr_tvb, g_free);
 	return uncompr_tvb;
 }
 #else
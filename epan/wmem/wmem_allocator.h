@@ -45,6 +45,7 @@ struct _wmem_allocator_t {
     void  (*free_all)(void *private_data);
     void  (*gc)(void *private_data);
     void  (*cleanup)(void *private_data);
+    gsize (*footprint)(void *private_data); /* optional, may be NULL */
 
     /* Callback List */
     struct _wmem_user_cb_container_t *callbacks;
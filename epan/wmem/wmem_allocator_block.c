@@ -21,9 +21,16 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include "config.h"
+
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
 #include <glib.h>
 
 #include "wmem_core.h"
@@ -156,6 +163,7 @@
 /* The header for an entire OS-level 'block' of memory */
 typedef struct _wmem_block_hdr_t {
     struct _wmem_block_hdr_t *prev, *next;
+    gsize size; /* of the whole block, header included */
 } wmem_block_hdr_t;
 
 /* The header for a single 'chunk' of memory as returned from alloc/realloc.
@@ -211,8 +219,56 @@ typedef struct _wmem_block_allocator_t {
     wmem_block_hdr_t   *block_list;
     wmem_block_chunk_t *master_head;
     wmem_block_chunk_t *recycler_head;
+    gsize               footprint; /* bytes of all the blocks in block_list */
+    gboolean            huge_pages; /* blocks are mapped and backed by huge pages */
 } wmem_block_allocator_t;
 
+/* HUGE PAGES
+ *
+ * An allocator that is used for every packet touches all of its 8MB
+ * blocks over and over, which takes 2048 TLB entries with 4KB pages.
+ * Where the OS has transparent huge pages, setting the environment
+ * variable WIRESHARK_WMEM_HUGE_PAGES maps the (non-jumbo) blocks
+ * directly and asks for them to be backed by huge pages.  It's off by
+ * default, as the whole of each block then becomes resident as soon as
+ * it is used.
+ */
+#if defined(HAVE_SYS_MMAN_H) && defined(MADV_HUGEPAGE) && defined(MAP_ANONYMOUS)
+#define WMEM_BLOCK_HAVE_HUGE_PAGES
+#endif
+
+static wmem_block_hdr_t *
+wmem_block_os_alloc(wmem_block_allocator_t *allocator)
+{
+#ifdef WMEM_BLOCK_HAVE_HUGE_PAGES
+    void *mem;
+
+    if (allocator->huge_pages) {
+        mem = mmap(NULL, WMEM_BLOCK_SIZE, PROT_READ|PROT_WRITE,
+                MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) {
+            g_error("wmem: failed to map %d bytes", WMEM_BLOCK_SIZE);
+        }
+        /* Only a hint; if it fails the block just has small pages */
+        (void) madvise(mem, WMEM_BLOCK_SIZE, MADV_HUGEPAGE);
+        return (wmem_block_hdr_t *)mem;
+    }
+#endif
+    return (wmem_block_hdr_t *)wmem_alloc(NULL, WMEM_BLOCK_SIZE);
+}
+
+static void
+wmem_block_os_free(wmem_block_allocator_t *allocator, wmem_block_hdr_t *block)
+{
+#ifdef WMEM_BLOCK_HAVE_HUGE_PAGES
+    if (allocator->huge_pages) {
+        munmap(block, WMEM_BLOCK_SIZE);
+        return;
+    }
+#endif
+    wmem_free(NULL, block);
+}
+
 /* DEBUG AND TEST */
 static int
 wmem_block_verify_block(wmem_block_hdr_t *block)
@@ -726,6 +782,7 @@ wmem_block_add_to_block_list(wmem_block_allocator_t *allocator,
         block->next->prev = block;
     }
     allocator->block_list = block;
+    allocator->footprint += block->size;
 }
 
 /* Remove a block from the allocator's embedded doubly-linked list of OS-level
@@ -744,6 +801,7 @@ wmem_block_remove_from_block_list(wmem_block_allocator_t *allocator,
     if (block->next) {
         block->next->prev = block->prev;
     }
+    allocator->footprint -= block->size;
 }
 
 /* Initializes a single unused chunk at the beginning of the block, and
@@ -774,7 +832,8 @@ wmem_block_new_block(wmem_block_allocator_t *allocator)
     wmem_block_hdr_t *block;
 
     /* allocate the new block and add it to the block list */
-    block = (wmem_block_hdr_t *)wmem_alloc(NULL, WMEM_BLOCK_SIZE);
+    block = wmem_block_os_alloc(allocator);
+    block->size = WMEM_BLOCK_SIZE;
     wmem_block_add_to_block_list(allocator, block);
 
     /* initialize it */
@@ -794,6 +853,7 @@ wmem_block_alloc_jumbo(wmem_block_allocator_t *allocator, const size_t size)
     block = (wmem_block_hdr_t *) wmem_alloc(NULL, size
             + WMEM_BLOCK_HEADER_SIZE
             + WMEM_CHUNK_HEADER_SIZE);
+    block->size = size + WMEM_BLOCK_HEADER_SIZE + WMEM_CHUNK_HEADER_SIZE;
 
     /* add it to the block list */
     wmem_block_add_to_block_list(allocator, block);
@@ -834,9 +894,12 @@ wmem_block_realloc_jumbo(wmem_block_allocator_t *allocator,
 
     block = WMEM_CHUNK_TO_BLOCK(chunk);
 
+    allocator->footprint -= block->size;
     block = (wmem_block_hdr_t *) wmem_realloc(NULL, block, size
             + WMEM_BLOCK_HEADER_SIZE
             + WMEM_CHUNK_HEADER_SIZE);
+    block->size = size + WMEM_BLOCK_HEADER_SIZE + WMEM_CHUNK_HEADER_SIZE;
+    allocator->footprint += block->size;
 
     if (block->next) {
         block->next->prev = block;
@@ -1052,6 +1115,7 @@ wmem_block_gc(void *private_data)
      * completely destroying unused blocks. */
     cur = allocator->block_list;
     allocator->block_list = NULL;
+    allocator->footprint  = 0;
 
     while (cur) {
         chunk = WMEM_BLOCK_TO_CHUNK(cur);
@@ -1079,7 +1143,7 @@ wmem_block_gc(void *private_data)
             else if (allocator->master_head == chunk) {
                 allocator->master_head = free_chunk->next;
             }
-            wmem_free(NULL, cur);
+            wmem_block_os_free(allocator, cur);
         }
         else {
             /* part of this block is used, so add it to the new block list */
@@ -1090,6 +1154,12 @@ wmem_block_gc(void *private_data)
     }
 }
 
+static gsize
+wmem_block_footprint(void *private_data)
+{
+    return ((wmem_block_allocator_t*) private_data)->footprint;
+}
+
 static void
 wmem_block_allocator_cleanup(void *private_data)
 {
@@ -1115,12 +1185,19 @@ wmem_block_allocator_init(wmem_allocator_t *allocator)
     allocator->free_all = &wmem_block_free_all;
     allocator->gc       = &wmem_block_gc;
     allocator->cleanup  = &wmem_block_allocator_cleanup;
+    allocator->footprint = &wmem_block_footprint;
 
     allocator->private_data = (void*) block_allocator;
 
     block_allocator->block_list    = NULL;
     block_allocator->master_head   = NULL;
     block_allocator->recycler_head = NULL;
+    block_allocator->footprint     = 0;
+#ifdef WMEM_BLOCK_HAVE_HUGE_PAGES
+    block_allocator->huge_pages    = getenv("WIRESHARK_WMEM_HUGE_PAGES") != NULL;
+#else
+    block_allocator->huge_pages    = FALSE;
+#endif
 }
 
 /*
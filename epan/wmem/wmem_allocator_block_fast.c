@@ -69,12 +69,14 @@ typedef struct {
 #define JUMBO_MAGIC 0xFFFFFFFF
 typedef struct _wmem_block_fast_jumbo {
     struct _wmem_block_fast_jumbo *prev, *next;
+    gsize size; /* of the whole block, header included */
 } wmem_block_fast_jumbo_t;
 #define WMEM_JUMBO_HEADER_SIZE WMEM_ALIGN_SIZE(sizeof(wmem_block_fast_jumbo_t))
 
 typedef struct {
     wmem_block_fast_hdr_t   *block_list;
     wmem_block_fast_jumbo_t *jumbo_list;
+    gsize                    footprint; /* bytes of all the blocks and jumbos */
 } wmem_block_fast_allocator_t;
 
 /* Creates a new block, and initializes it. */
@@ -90,6 +92,7 @@ wmem_block_fast_new_block(wmem_block_fast_allocator_t *allocator)
     block->next = allocator->block_list;
 
     allocator->block_list = block;
+    allocator->footprint += WMEM_BLOCK_SIZE;
 }
 
 /* API */
@@ -110,7 +113,12 @@ wmem_block_fast_alloc(void *private_data, const size_t size)
 
         block->next = allocator->jumbo_list;
         block->prev = NULL;
+        block->size = size + WMEM_JUMBO_HEADER_SIZE + WMEM_CHUNK_HEADER_SIZE;
+        if (block->next) {
+            block->next->prev = block;
+        }
         allocator->jumbo_list = block;
+        allocator->footprint += block->size;
 
         chunk = ((wmem_block_fast_chunk_t*)((guint8*)(block) + WMEM_JUMBO_HEADER_SIZE));
         chunk->len = JUMBO_MAGIC;
@@ -150,16 +158,19 @@ wmem_block_fast_realloc(void *private_data, void *ptr, const size_t size)
     chunk = WMEM_DATA_TO_CHUNK(ptr);
 
     if (chunk->len == JUMBO_MAGIC) {
+        wmem_block_fast_allocator_t *allocator = (wmem_block_fast_allocator_t*) private_data;
         wmem_block_fast_jumbo_t *block;
 
         block = ((wmem_block_fast_jumbo_t*)((guint8*)(chunk) - WMEM_JUMBO_HEADER_SIZE));
+        allocator->footprint -= block->size;
         block =  (wmem_block_fast_jumbo_t*)wmem_realloc(NULL, block,
                 size + WMEM_JUMBO_HEADER_SIZE + WMEM_CHUNK_HEADER_SIZE);
+        block->size = size + WMEM_JUMBO_HEADER_SIZE + WMEM_CHUNK_HEADER_SIZE;
+        allocator->footprint += block->size;
         if (block->prev) {
             block->prev->next = block;
         }
         else {
-            wmem_block_fast_allocator_t *allocator = (wmem_block_fast_allocator_t*) private_data;
             allocator->jumbo_list = block;
         }
         if (block->next) {
@@ -193,11 +204,13 @@ wmem_block_fast_free_all(void *private_data)
      * that one */
     cur = allocator->block_list;
 
+    allocator->footprint = 0;
     if (cur) {
          cur->pos = WMEM_BLOCK_HEADER_SIZE;
          nxt = cur->next;
          cur->next = NULL;
          cur = nxt;
+         allocator->footprint = WMEM_BLOCK_SIZE;
     }
 
     while (cur) {
@@ -222,6 +235,12 @@ wmem_block_fast_gc(void *private_data _U_)
     /* No-op */
 }
 
+static gsize
+wmem_block_fast_footprint(void *private_data)
+{
+    return ((wmem_block_fast_allocator_t*) private_data)->footprint;
+}
+
 static void
 wmem_block_fast_allocator_cleanup(void *private_data)
 {
@@ -249,11 +268,13 @@ wmem_block_fast_allocator_init(wmem_allocator_t *allocator)
     allocator->free_all = &wmem_block_fast_free_all;
     allocator->gc       = &wmem_block_fast_gc;
     allocator->cleanup  = &wmem_block_fast_allocator_cleanup;
+    allocator->footprint = &wmem_block_fast_footprint;
 
     allocator->private_data = (void*) block_allocator;
 
     block_allocator->block_list = NULL;
     block_allocator->jumbo_list = NULL;
+    block_allocator->footprint  = 0;
 }
 
 /*
@@ -59,6 +59,7 @@ typedef struct _wmem_strict_allocator_block_t {
 
 typedef struct _wmem_strict_allocator_t {
     wmem_strict_allocator_block_t *blocks;
+    gsize                          footprint; /* full size of all the blocks */
 } wmem_strict_allocator_t;
 
 /*
@@ -107,6 +108,7 @@ wmem_strict_alloc(void *private_data, const size_t size)
     block->next = allocator->blocks;
     block->prev = NULL;
     allocator->blocks = block;
+    allocator->footprint += WMEM_FULL_SIZE(size);
 
     return WMEM_BLOCK_TO_DATA(block);
 }
@@ -134,6 +136,7 @@ wmem_strict_free(void *private_data, void *ptr)
         allocator->blocks = block->next;
     }
 
+    allocator->footprint -= WMEM_FULL_SIZE(block->data_len);
     memset(block, WMEM_POSTFILL, WMEM_FULL_SIZE(block->data_len));
 
     wmem_free(NULL, block);
@@ -202,6 +205,12 @@ wmem_strict_gc(void *private_data _U_)
      * checking our canaries at this point? */
 }
 
+static gsize
+wmem_strict_footprint(void *private_data)
+{
+    return ((wmem_strict_allocator_t*) private_data)->footprint;
+}
+
 static void
 wmem_strict_allocator_cleanup(void *private_data)
 {
@@ -222,10 +231,12 @@ wmem_strict_allocator_init(wmem_allocator_t *allocator)
     allocator->free_all = &wmem_strict_free_all;
     allocator->gc       = &wmem_strict_gc;
     allocator->cleanup  = &wmem_strict_allocator_cleanup;
+    allocator->footprint = &wmem_strict_footprint;
 
     allocator->private_data = (void*) strict_allocator;
 
-    strict_allocator->blocks = NULL;
+    strict_allocator->blocks    = NULL;
+    strict_allocator->footprint = 0;
 }
 
 /*
@@ -0,0 +1,228 @@
+/* wmem_allocator_thread_safe.c
+ * Wireshark Memory Manager Thread-Safe Allocator
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+
+#include "wmem_core.h"
+#include "wmem_allocator.h"
+#include "wmem_allocator_thread_safe.h"
+
+/* A pool that can be used from several threads at once.
+ *
+ * Allocations are spread over a number of block allocators ("shards")
+ * according to the allocating thread, each with its own lock, so that
+ * threads allocating at the same time rarely have to wait for each
+ * other. Every chunk starts with a small header naming its shard, so it can
+ * be reallocated or freed from any thread; this is how memory is handed from
+ * one thread to another: allocate it from this pool and pass the pointer on.
+ *
+ * Per-thread scratch memory that is thrown away as a whole (like the packet
+ * pool) is better served by giving each thread its own BLOCK_FAST pool,
+ * since allocators don't share any state with each other.
+ *
+ * free_all and gc take every shard's lock in turn. As with any other pool,
+ * nothing may be using the memory they release.
+ */
+
+#define WMEM_TS_SHARDS 16
+
+/* Keep the chunks aligned the way the block allocator aligns them. */
+#define WMEM_TS_HEADER_SIZE (2 * sizeof (gsize))
+
+typedef struct _wmem_ts_shard_t {
+    GMutex           *lock;
+    wmem_allocator_t *allocator;
+} wmem_ts_shard_t;
+
+typedef struct _wmem_ts_allocator_t {
+    wmem_ts_shard_t shards[WMEM_TS_SHARDS];
+} wmem_ts_allocator_t;
+
+static guint
+wmem_ts_shard_index(void)
+{
+    /* The GThread of a thread doesn't move while the thread is running, so
+     * it makes a cheap identity to pick the shard with. */
+    guintptr self = (guintptr) g_thread_self();
+
+    return (guint) (((self >> 4) ^ (self >> 12)) % WMEM_TS_SHARDS);
+}
+
+static void *
+wmem_ts_alloc(void *private_data, const size_t size)
+{
+    wmem_ts_allocator_t *allocator = (wmem_ts_allocator_t*) private_data;
+    guint                idx;
+    wmem_ts_shard_t     *shard;
+    guint8              *chunk;
+
+    idx   = wmem_ts_shard_index();
+    shard = &allocator->shards[idx];
+
+    g_mutex_lock(shard->lock);
+    chunk = (guint8 *) wmem_alloc(shard->allocator, size + WMEM_TS_HEADER_SIZE);
+    g_mutex_unlock(shard->lock);
+
+    *(guint *) chunk = idx;
+
+    return chunk + WMEM_TS_HEADER_SIZE;
+}
+
+static void
+wmem_ts_free(void *private_data, void *ptr)
+{
+    wmem_ts_allocator_t *allocator = (wmem_ts_allocator_t*) private_data;
+    guint8              *chunk;
+    wmem_ts_shard_t     *shard;
+
+    chunk = (guint8 *) ptr - WMEM_TS_HEADER_SIZE;
+    shard = &allocator->shards[*(guint *) chunk];
+
+    g_mutex_lock(shard->lock);
+    wmem_free(shard->allocator, chunk);
+    g_mutex_unlock(shard->lock);
+}
+
+static void *
+wmem_ts_realloc(void *private_data, void *ptr, const size_t size)
+{
+    wmem_ts_allocator_t *allocator = (wmem_ts_allocator_t*) private_data;
+    guint8              *chunk;
+    wmem_ts_shard_t     *shard;
+
+    chunk = (guint8 *) ptr - WMEM_TS_HEADER_SIZE;
+    shard = &allocator->shards[*(guint *) chunk];
+
+    /* The chunk stays in the shard it was allocated from, so the header
+     * is still right afterwards. */
+    g_mutex_lock(shard->lock);
+    chunk = (guint8 *) wmem_realloc(shard->allocator, chunk, size + WMEM_TS_HEADER_SIZE);
+    g_mutex_unlock(shard->lock);
+
+    return chunk + WMEM_TS_HEADER_SIZE;
+}
+
+static void
+wmem_ts_free_all(void *private_data)
+{
+    wmem_ts_allocator_t *allocator = (wmem_ts_allocator_t*) private_data;
+    int                  i;
+
+    for (i = 0; i < WMEM_TS_SHARDS; i++) {
+        g_mutex_lock(allocator->shards[i].lock);
+        wmem_free_all(allocator->shards[i].allocator);
+        g_mutex_unlock(allocator->shards[i].lock);
+    }
+}
+
+static void
+wmem_ts_gc(void *private_data)
+{
+    wmem_ts_allocator_t *allocator = (wmem_ts_allocator_t*) private_data;
+    int                  i;
+
+    for (i = 0; i < WMEM_TS_SHARDS; i++) {
+        g_mutex_lock(allocator->shards[i].lock);
+        wmem_gc(allocator->shards[i].allocator);
+        g_mutex_unlock(allocator->shards[i].lock);
+    }
+}
+
+static gsize
+wmem_ts_footprint(void *private_data)
+{
+    wmem_ts_allocator_t *allocator = (wmem_ts_allocator_t*) private_data;
+    gsize                footprint = 0;
+    int                  i;
+
+    for (i = 0; i < WMEM_TS_SHARDS; i++) {
+        g_mutex_lock(allocator->shards[i].lock);
+        footprint += wmem_allocator_footprint(allocator->shards[i].allocator);
+        g_mutex_unlock(allocator->shards[i].lock);
+    }
+
+    return footprint;
+}
+
+static void
+wmem_ts_allocator_cleanup(void *private_data)
+{
+    wmem_ts_allocator_t *allocator = (wmem_ts_allocator_t*) private_data;
+    int                  i;
+
+    for (i = 0; i < WMEM_TS_SHARDS; i++) {
+        wmem_destroy_allocator(allocator->shards[i].allocator);
+#if GLIB_CHECK_VERSION(2,31,0)
+        g_mutex_clear(allocator->shards[i].lock);
+        g_free(allocator->shards[i].lock);
+#else
+        g_mutex_free(allocator->shards[i].lock);
+#endif
+    }
+
+    wmem_free(NULL, allocator);
+}
+
+void
+wmem_thread_safe_allocator_init(wmem_allocator_t *allocator)
+{
+    wmem_ts_allocator_t *ts_allocator;
+    int                  i;
+
+    ts_allocator = wmem_new(NULL, wmem_ts_allocator_t);
+
+    allocator->walloc   = &wmem_ts_alloc;
+    allocator->wrealloc = &wmem_ts_realloc;
+    allocator->wfree    = &wmem_ts_free;
+
+    allocator->free_all = &wmem_ts_free_all;
+    allocator->gc       = &wmem_ts_gc;
+    allocator->cleanup  = &wmem_ts_allocator_cleanup;
+    allocator->footprint = &wmem_ts_footprint;
+
+    allocator->private_data = (void*) ts_allocator;
+
+    for (i = 0; i < WMEM_TS_SHARDS; i++) {
+#if GLIB_CHECK_VERSION(2,31,0)
+        ts_allocator->shards[i].lock = g_new(GMutex, 1);
+        g_mutex_init(ts_allocator->shards[i].lock);
+#else
+        ts_allocator->shards[i].lock = g_mutex_new();
+#endif
+        ts_allocator->shards[i].allocator = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK);
+    }
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -34,6 +34,7 @@
 #include "wmem_allocator_block.h"
 #include "wmem_allocator_block_fast.h"
 #include "wmem_allocator_strict.h"
+#include "wmem_allocator_thread_safe.h"
 
 #include <wsutil/ws_printf.h> /* ws_g_warning */
 
@@ -130,6 +131,16 @@ wmem_gc(wmem_allocator_t *allocator)
     allocator->gc(allocator->private_data);
 }
 
+gsize
+wmem_allocator_footprint(wmem_allocator_t *allocator)
+{
+    if (allocator->footprint == NULL) {
+        return 0;
+    }
+
+    return allocator->footprint(allocator->private_data);
+}
+
 void
 wmem_destroy_allocator(wmem_allocator_t *allocator)
 {
@@ -145,7 +156,7 @@ wmem_allocator_new(const wmem_allocator_type_t type)
     wmem_allocator_t      *allocator;
     wmem_allocator_type_t  real_type;
 
-    if (do_override) {
+    if (do_override && type != WMEM_ALLOCATOR_THREAD_SAFE) {
         real_type = override_type;
     }
     else {
@@ -156,6 +167,7 @@ wmem_allocator_new(const wmem_allocator_type_t type)
     allocator->type      = real_type;
     allocator->callbacks = NULL;
     allocator->in_scope  = TRUE;
+    allocator->footprint = NULL;
 
     switch (real_type) {
         case WMEM_ALLOCATOR_SIMPLE:
@@ -170,6 +182,9 @@ wmem_allocator_new(const wmem_allocator_type_t type)
         case WMEM_ALLOCATOR_STRICT:
             wmem_strict_allocator_init(allocator);
             break;
+        case WMEM_ALLOCATOR_THREAD_SAFE:
+            wmem_thread_safe_allocator_init(allocator);
+            break;
         default:
             g_assert_not_reached();
             /* This is necessary to squelch MSVC errors; is there
@@ -66,11 +66,17 @@ typedef enum _wmem_allocator_type_t {
                 memory usage via things like canaries and scrubbing freed
                 memory. Valgrind is the better choice on platforms that support
                 it. */
-    WMEM_ALLOCATOR_BLOCK_FAST /**< A block allocator like WMEM_ALLOCATOR_BLOCK
+    WMEM_ALLOCATOR_BLOCK_FAST, /**< A block allocator like WMEM_ALLOCATOR_BLOCK
                 but even faster by tracking absolutely minimal metadata and
                 making 'free' a no-op. Useful only for very short-lived scopes
                 where there's no reason to free individual allocations because
                 the next free_all is always just around the corner. */
+    WMEM_ALLOCATOR_THREAD_SAFE /**< An allocator that can be used from several
+                threads at once, and whose memory can be freed by a thread other
+                than the one that allocated it. Allocations are spread over
+                several block allocators with a lock each, according to the
+                allocating thread. Never replaced by the debug override, as the
+                other allocators are not thread-safe. */
 } wmem_allocator_type_t;
 
 /** Allocate the requested amount of memory in the given pool.
@@ -188,6 +194,18 @@ WS_DLL_PUBLIC
 void
 wmem_gc(wmem_allocator_t *allocator);
 
+/** Get the number of bytes an allocator currently holds from the operating
+ * system, including the space it has free inside its blocks. This is what
+ * the pool costs the process, so it's what memory usage reports show.
+ *
+ * @param allocator The allocator to ask.
+ * @return The number of bytes, or 0 if the allocator type doesn't keep
+ * track (the simple allocator doesn't).
+ */
+WS_DLL_PUBLIC
+gsize
+wmem_allocator_footprint(wmem_allocator_t *allocator);
+
 /** Destroy the given allocator, freeing all memory allocated in it. Once this
  * function has been called, no memory allocated with the allocator is valid.
  *
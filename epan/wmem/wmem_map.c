@@ -53,6 +53,17 @@ typedef struct _wmem_map_item_t {
     struct _wmem_map_item_t *next;
 } wmem_map_item_t;
 
+/* Slot in the table of an open-addressing map (see wmem_map_new_open()).
+ * Items live inline in the table and collisions are resolved with Robin Hood
+ * linear probing, so a lookup touches a few adjacent slots instead of chasing
+ * a list of separately-allocated items. */
+typedef struct _wmem_map_slot_t {
+    const void *key;
+    void       *value;
+    guint32     hash; /* full hash, so most mismatches skip eql_func */
+    guint32     dist; /* 1 + distance from the home slot, or 0 if empty */
+} wmem_map_slot_t;
+
 struct _wmem_map_t {
     guint count; /* number of items stored */
 
@@ -64,6 +75,10 @@ struct _wmem_map_t {
 
     wmem_map_item_t **table;
 
+    /* Open-addressing maps use this instead of 'table' */
+    gboolean          open;
+    wmem_map_slot_t  *slots;
+
     GHashFunc  hash_func;
     GEqualFunc eql_func;
 
@@ -88,12 +103,26 @@ struct _wmem_map_t {
 #define HASH(MAP, KEY) \
     ((guint32)(((MAP)->hash_func(KEY) * x) >> (32 - (MAP)->capacity)))
 
+/* Open-addressing maps keep the full multiplied hash in each slot and take the
+ * home slot from its top bits, exactly as HASH does. */
+#define OPEN_HASH(MAP, KEY) ((guint32)((MAP)->hash_func(KEY) * x))
+#define OPEN_HOME(MAP, H)   ((size_t)((H) >> (32 - (MAP)->capacity)))
+#define OPEN_MASK(MAP)      (CAPACITY(MAP) - 1)
+
+/* Open-addressing maps grow when they are more than 7/8 full; Robin Hood
+ * probing keeps probe lengths short even at that load. */
+#define OPEN_OVERFULL(MAP, COUNT) ((COUNT) * 8 > CAPACITY(MAP) * 7)
+
 static void
 wmem_map_init_table(wmem_map_t *map)
 {
     map->count     = 0;
     map->capacity  = WMEM_MAP_DEFAULT_CAPACITY;
-    map->table     = wmem_alloc0_array(map->allocator, wmem_map_item_t*, CAPACITY(map));
+    if (map->open) {
+        map->slots = wmem_alloc0_array(map->allocator, wmem_map_slot_t, CAPACITY(map));
+    } else {
+        map->table = wmem_alloc0_array(map->allocator, wmem_map_item_t*, CAPACITY(map));
+    }
 }
 
 wmem_map_t *
@@ -110,6 +139,20 @@ wmem_map_new(wmem_allocator_t *allocator,
     map->allocator = allocator;
     map->count = 0;
     map->table = NULL;
+    map->open  = FALSE;
+    map->slots = NULL;
+
+    return map;
+}
+
+wmem_map_t *
+wmem_map_new_open(wmem_allocator_t *allocator,
+        GHashFunc hash_func, GEqualFunc eql_func)
+{
+    wmem_map_t *map;
+
+    map = wmem_map_new(allocator, hash_func, eql_func);
+    map->open = TRUE;
 
     return map;
 }
@@ -122,6 +165,7 @@ wmem_map_reset_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event,
 
     map->count = 0;
     map->table = NULL;
+    map->slots = NULL;
 
     if (event == WMEM_CB_DESTROY_EVENT) {
         wmem_unregister_callback(map->master, map->master_cb_id);
@@ -156,6 +200,8 @@ wmem_map_new_autoreset(wmem_allocator_t *master, wmem_allocator_t *slave,
     map->allocator = slave;
     map->count = 0;
     map->table = NULL;
+    map->open  = FALSE;
+    map->slots = NULL;
 
     map->master_cb_id = wmem_register_callback(master, wmem_map_destroy_cb, map);
     map->slave_cb_id  = wmem_register_callback(slave, wmem_map_reset_cb, map);
@@ -163,6 +209,158 @@ wmem_map_new_autoreset(wmem_allocator_t *master, wmem_allocator_t *slave,
     return map;
 }
 
+wmem_map_t *
+wmem_map_new_autoreset_open(wmem_allocator_t *master, wmem_allocator_t *slave,
+        GHashFunc hash_func, GEqualFunc eql_func)
+{
+    wmem_map_t *map;
+
+    map = wmem_map_new_autoreset(master, slave, hash_func, eql_func);
+    map->open = TRUE;
+
+    return map;
+}
+
+/* Places an item known not to be in the map yet, displacing any item that is
+ * closer to its home slot than the new one ("robbing the rich"). */
+static void
+wmem_map_open_place(wmem_map_t *map, const void *key, void *value, guint32 hash)
+{
+    wmem_map_slot_t  item, tmp, *slot;
+    size_t           mask = OPEN_MASK(map);
+    size_t           i    = OPEN_HOME(map, hash);
+
+    item.key   = key;
+    item.value = value;
+    item.hash  = hash;
+    item.dist  = 1;
+
+    for (;;) {
+        slot = &map->slots[i];
+        if (slot->dist == 0) {
+            *slot = item;
+            return;
+        }
+        if (slot->dist < item.dist) {
+            tmp   = *slot;
+            *slot = item;
+            item  = tmp;
+        }
+        i = (i + 1) & mask;
+        item.dist++;
+    }
+}
+
+static wmem_map_slot_t *
+wmem_map_open_find(wmem_map_t *map, const void *key, guint32 hash)
+{
+    wmem_map_slot_t *slot;
+    size_t           mask = OPEN_MASK(map);
+    size_t           i    = OPEN_HOME(map, hash);
+    guint32          dist = 1;
+
+    /* An item is never further from home than the items in front of it, so
+     * we can stop as soon as we pass a slot that is closer to its home than
+     * the key would be (empty slots have a distance of 0). */
+    for (slot = &map->slots[i]; slot->dist >= dist; slot = &map->slots[i]) {
+        if (slot->hash == hash && map->eql_func(key, slot->key)) {
+            return slot;
+        }
+        i = (i + 1) & mask;
+        dist++;
+    }
+
+    return NULL;
+}
+
+/* Removes the item in slot, shifting the rest of its probe run back one slot
+ * so no tombstones are needed. */
+static void
+wmem_map_open_delete(wmem_map_t *map, wmem_map_slot_t *slot)
+{
+    size_t mask = OPEN_MASK(map);
+    size_t i    = (size_t)(slot - map->slots);
+    size_t next = (i + 1) & mask;
+
+    while (map->slots[next].dist > 1) {
+        map->slots[i] = map->slots[next];
+        map->slots[i].dist--;
+        i    = next;
+        next = (next + 1) & mask;
+    }
+    map->slots[i].dist = 0;
+
+    map->count--;
+}
+
+static void
+wmem_map_open_grow(wmem_map_t *map)
+{
+    wmem_map_slot_t *old_slots;
+    size_t           old_cap, i;
+
+    old_slots = map->slots;
+    old_cap   = CAPACITY(map);
+
+    map->capacity++;
+    map->slots = wmem_alloc0_array(map->allocator, wmem_map_slot_t, CAPACITY(map));
+
+    /* the stored hashes give us the new home slots without rehashing */
+    for (i=0; i<old_cap; i++) {
+        if (old_slots[i].dist) {
+            wmem_map_open_place(map, old_slots[i].key, old_slots[i].value,
+                    old_slots[i].hash);
+        }
+    }
+
+    wmem_free(map->allocator, old_slots);
+}
+
+static void *
+wmem_map_open_insert(wmem_map_t *map, const void *key, void *value)
+{
+    wmem_map_slot_t *slot;
+    guint32          hash;
+    void            *old_val;
+
+    /* Make sure we have a table */
+    if (map->slots == NULL) {
+        wmem_map_init_table(map);
+    }
+
+    hash = OPEN_HASH(map, key);
+
+    slot = wmem_map_open_find(map, key, hash);
+    if (slot) {
+        /* replace and return old value for this key */
+        old_val     = slot->value;
+        slot->value = value;
+        return old_val;
+    }
+
+    /* increase size first if the new item would make us over-full */
+    if (OPEN_OVERFULL(map, map->count + 1)) {
+        wmem_map_open_grow(map);
+    }
+
+    wmem_map_open_place(map, key, value, hash);
+    map->count++;
+
+    /* no previous entry, return NULL */
+    return NULL;
+}
+
+static wmem_map_slot_t *
+wmem_map_open_lookup(wmem_map_t *map, const void *key)
+{
+    /* Make sure we have a table */
+    if (map->slots == NULL) {
+        return NULL;
+    }
+
+    return wmem_map_open_find(map, key, OPEN_HASH(map, key));
+}
+
 static inline void
 wmem_map_grow(wmem_map_t *map)
 {
@@ -201,6 +399,10 @@ wmem_map_insert(wmem_map_t *map, const void *key, void *value)
     wmem_map_item_t **item;
     void *old_val;
 
+    if (map->open) {
+        return wmem_map_open_insert(map, key, value);
+    }
+
     /* Make sure we have a table */
     if (map->table == NULL) {
         wmem_map_init_table(map);
@@ -243,6 +445,11 @@ wmem_map_lookup(wmem_map_t *map, const void *key)
 {
     wmem_map_item_t *item;
 
+    if (map->open) {
+        wmem_map_slot_t *slot = wmem_map_open_lookup(map, key);
+        return slot ? slot->value : NULL;
+    }
+
     /* Make sure we have a table */
     if (map->table == NULL) {
         return NULL;
@@ -268,6 +475,16 @@ wmem_map_remove(wmem_map_t *map, const void *key)
     wmem_map_item_t **item, *tmp;
     void *value;
 
+    if (map->open) {
+        wmem_map_slot_t *slot = wmem_map_open_lookup(map, key);
+        if (!slot) {
+            return NULL;
+        }
+        value = slot->value;
+        wmem_map_open_delete(map, slot);
+        return value;
+    }
+
     /* Make sure we have a table */
     if (map->table == NULL) {
         return NULL;
@@ -299,6 +516,15 @@ wmem_map_steal(wmem_map_t *map, const void *key)
 {
     wmem_map_item_t **item, *tmp;
 
+    if (map->open) {
+        wmem_map_slot_t *slot = wmem_map_open_lookup(map, key);
+        if (!slot) {
+            return FALSE;
+        }
+        wmem_map_open_delete(map, slot);
+        return TRUE;
+    }
+
     /* Make sure we have a table */
     if (map->table == NULL) {
         return FALSE;
@@ -330,6 +556,16 @@ wmem_map_get_keys(wmem_allocator_t *list_allocator, wmem_map_t *map)
     wmem_map_item_t *cur;
     wmem_list_t* list = wmem_list_new(list_allocator);
 
+    if (map->slots != NULL) {
+        capacity = CAPACITY(map);
+
+        for (i=0; i<capacity; i++) {
+            if (map->slots[i].dist) {
+                wmem_list_prepend(list, (void*)map->slots[i].key);
+            }
+        }
+    }
+
     if (map->table != NULL) {
         capacity = CAPACITY(map);
 
@@ -352,6 +588,16 @@ wmem_map_foreach(wmem_map_t *map, GHFunc foreach_func, gpointer user_data)
     wmem_map_item_t *cur;
     unsigned i;
 
+    if (map->slots != NULL) {
+        for (i = 0; i < CAPACITY(map); i++) {
+            if (map->slots[i].dist) {
+                foreach_func((gpointer)map->slots[i].key,
+                        (gpointer)map->slots[i].value, user_data);
+            }
+        }
+        return;
+    }
+
     /* Make sure we have a table */
     if (map->table == NULL) {
         return;
@@ -88,6 +88,27 @@ wmem_map_new_autoreset(wmem_allocator_t *master, wmem_allocator_t *slave,
         GHashFunc hash_func, GEqualFunc eql_func)
 G_GNUC_MALLOC;
 
+/** Like wmem_map_new(), but creates an open-addressing map. Items are stored
+ * inline in the table, using Robin Hood linear probing, instead of in
+ * separately-allocated chained items. This is faster for lookup-heavy maps
+ * with many entries, at the cost of moving items around on insertion and
+ * removal. It supports exactly the same wmem_map_* API.
+ */
+WS_DLL_PUBLIC
+wmem_map_t *
+wmem_map_new_open(wmem_allocator_t *allocator,
+        GHashFunc hash_func, GEqualFunc eql_func)
+G_GNUC_MALLOC;
+
+/** Like wmem_map_new_autoreset(), but creates an open-addressing map as
+ * described for wmem_map_new_open().
+ */
+WS_DLL_PUBLIC
+wmem_map_t *
+wmem_map_new_autoreset_open(wmem_allocator_t *master, wmem_allocator_t *slave,
+        GHashFunc hash_func, GEqualFunc eql_func)
+G_GNUC_MALLOC;
+
 /** Inserts a value into the map.
  *
  * @param map The map to insert into.
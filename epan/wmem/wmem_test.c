@@ -33,8 +33,10 @@
 #include "wmem_allocator_block_fast.h"
 #include "wmem_allocator_simple.h"
 #include "wmem_allocator_strict.h"
+#include "wmem_allocator_thread_safe.h"
 
 #include <wsutil/time_util.h>
+#include <wsutil/microbench.h>
 
 #define STRING_80               "12345678901234567890123456789012345678901234567890123456789012345678901234567890"
 #define MAX_ALLOC_SIZE          (1024*64)
@@ -55,6 +57,7 @@ wmem_allocator_force_new(const wmem_allocator_type_t type)
     allocator->type = type;
     allocator->callbacks = NULL;
     allocator->in_scope = TRUE;
+    allocator->footprint = NULL;
 
     switch (type) {
         case WMEM_ALLOCATOR_SIMPLE:
@@ -69,6 +72,9 @@ wmem_allocator_force_new(const wmem_allocator_type_t type)
         case WMEM_ALLOCATOR_STRICT:
             wmem_strict_allocator_init(allocator);
             break;
+        case WMEM_ALLOCATOR_THREAD_SAFE:
+            wmem_thread_safe_allocator_init(allocator);
+            break;
         default:
             g_assert_not_reached();
             /* This is necessary to squelch MSVC errors; is there
@@ -149,6 +155,55 @@ wmem_test_foreach_cb(const void *key _U_, void *value, void *user_data)
 
 /* ALLOCATOR TESTING FUNCTIONS (/wmem/allocator/) */
 
+#define FOOTPRINT_JUMBO_SIZE (16 * 1024 * 1024)
+
+static void
+wmem_test_allocator_footprint_type(wmem_allocator_type_t type)
+{
+    wmem_allocator_t *allocator;
+    gsize             empty, small;
+    void             *ptr;
+
+    allocator = wmem_allocator_force_new(type);
+    empty = wmem_allocator_footprint(allocator);
+
+    wmem_alloc(allocator, 64);
+    small = wmem_allocator_footprint(allocator);
+    g_assert(small > empty);
+
+    /* bigger than a block, so it gets one of its own */
+    ptr = wmem_alloc(allocator, FOOTPRINT_JUMBO_SIZE);
+    g_assert(wmem_allocator_footprint(allocator) >= small + FOOTPRINT_JUMBO_SIZE);
+    ptr = wmem_realloc(allocator, ptr, 2 * FOOTPRINT_JUMBO_SIZE);
+    g_assert(wmem_allocator_footprint(allocator) >= small + 2 * FOOTPRINT_JUMBO_SIZE);
+    ptr = wmem_realloc(allocator, ptr, FOOTPRINT_JUMBO_SIZE);
+    g_assert(wmem_allocator_footprint(allocator) < small + 2 * FOOTPRINT_JUMBO_SIZE);
+
+    /* the pool may hang on to a block for later, but not to the jumbo */
+    wmem_free_all(allocator);
+    wmem_gc(allocator);
+    g_assert(wmem_allocator_footprint(allocator) <= small);
+
+    wmem_destroy_allocator(allocator);
+}
+
+static void
+wmem_test_allocator_footprint(void)
+{
+    wmem_allocator_t *allocator;
+
+    wmem_test_allocator_footprint_type(WMEM_ALLOCATOR_BLOCK);
+    wmem_test_allocator_footprint_type(WMEM_ALLOCATOR_BLOCK_FAST);
+    wmem_test_allocator_footprint_type(WMEM_ALLOCATOR_STRICT);
+    wmem_test_allocator_footprint_type(WMEM_ALLOCATOR_THREAD_SAFE);
+
+    /* the simple allocator doesn't keep track */
+    allocator = wmem_allocator_force_new(WMEM_ALLOCATOR_SIMPLE);
+    wmem_alloc(allocator, 64);
+    g_assert(wmem_allocator_footprint(allocator) == 0);
+    wmem_destroy_allocator(allocator);
+}
+
 static void
 wmem_test_allocator_callbacks(void)
 {
@@ -380,6 +435,178 @@ wmem_test_allocator_strict(void)
     wmem_test_allocator_jumbo(WMEM_ALLOCATOR_STRICT, &wmem_strict_check_canaries);
 }
 
+static void
+wmem_test_allocator_thread_safe(void)
+{
+    wmem_test_allocator(WMEM_ALLOCATOR_THREAD_SAFE, NULL,
+            MAX_SIMULTANEOUS_ALLOCS*64);
+    wmem_test_allocator_jumbo(WMEM_ALLOCATOR_THREAD_SAFE, NULL);
+}
+
+#if GLIB_CHECK_VERSION(2,32,0)
+#define THREAD_ALLOCS 10000
+
+typedef struct {
+    wmem_allocator_t *allocator;
+    GAsyncQueue      *handoff;  /* chunks for the next thread to free */
+    GAsyncQueue      *received; /* chunks from the previous thread */
+    guint32           seed;
+} wmem_test_thread_t;
+
+/* pushed after a thread's last handed-off chunk */
+static char wmem_test_handoff_done;
+
+static gpointer
+wmem_test_thread_safe_worker(gpointer data)
+{
+    wmem_test_thread_t *thr = (wmem_test_thread_t *)data;
+    GRand              *rand = g_rand_new_with_seed(thr->seed);
+    char               *ptrs[64];
+    int                 i, j;
+    gint                size;
+
+    for (j = 0; j < 64; j++)
+        ptrs[j] = NULL;
+
+    for (i = 0; i < THREAD_ALLOCS; i++) {
+        j = g_rand_int_range(rand, 0, 64);
+        size = g_rand_int_range(rand, 1, 512);
+        if (ptrs[j] == NULL) {
+            ptrs[j] = (char *)wmem_alloc(thr->allocator, size);
+            memset(ptrs[j], j, size);
+        } else if (g_rand_boolean(rand)) {
+            ptrs[j] = (char *)wmem_realloc(thr->allocator, ptrs[j], size);
+            memset(ptrs[j], j, size);
+        } else {
+            /* hand it to another thread instead of freeing it here */
+            g_async_queue_push(thr->handoff, ptrs[j]);
+            ptrs[j] = NULL;
+        }
+    }
+    for (j = 0; j < 64; j++)
+        wmem_free(thr->allocator, ptrs[j]);
+    g_async_queue_push(thr->handoff, &wmem_test_handoff_done);
+
+    /* free what the previous thread handed us */
+    for (;;) {
+        gpointer ptr = g_async_queue_pop(thr->received);
+        if (ptr == &wmem_test_handoff_done)
+            break;
+        wmem_free(thr->allocator, ptr);
+    }
+
+    g_rand_free(rand);
+    return NULL;
+}
+
+static void
+wmem_test_allocator_thread_safe_threads(void)
+{
+#define TEST_THREADS 8
+    wmem_allocator_t   *allocator;
+    wmem_test_thread_t  thr[TEST_THREADS];
+    GThread            *threads[TEST_THREADS];
+    GAsyncQueue        *queues[TEST_THREADS];
+    int                 i;
+
+    allocator = wmem_allocator_force_new(WMEM_ALLOCATOR_THREAD_SAFE);
+
+    for (i = 0; i < TEST_THREADS; i++)
+        queues[i] = g_async_queue_new();
+    for (i = 0; i < TEST_THREADS; i++) {
+        thr[i].allocator = allocator;
+        thr[i].handoff   = queues[(i + 1) % TEST_THREADS];
+        thr[i].received  = queues[i];
+        thr[i].seed      = g_test_rand_int();
+    }
+    for (i = 0; i < TEST_THREADS; i++)
+        threads[i] = g_thread_new("wmem_test", wmem_test_thread_safe_worker, &thr[i]);
+    for (i = 0; i < TEST_THREADS; i++)
+        g_thread_join(threads[i]);
+    for (i = 0; i < TEST_THREADS; i++)
+        g_async_queue_unref(queues[i]);
+
+    wmem_free_all(allocator);
+    wmem_gc(allocator);
+    wmem_destroy_allocator(allocator);
+}
+
+#define PERF_ALLOCS (100 * 1000)
+
+typedef struct {
+    wmem_allocator_t *allocator; /* NULL means use a private block_fast pool */
+} wmem_test_perf_thread_t;
+
+static gpointer
+wmem_test_thread_perf_worker(gpointer data)
+{
+    wmem_test_perf_thread_t *thr = (wmem_test_perf_thread_t *)data;
+    wmem_allocator_t        *allocator = thr->allocator;
+    void                    *ptrs[32];
+    int                      i, j;
+
+    if (allocator == NULL)
+        allocator = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK_FAST);
+
+    /* roughly one "packet" worth of scratch allocations at a time */
+    for (i = 0; i < PERF_ALLOCS; i += 32) {
+        for (j = 0; j < 32; j++)
+            ptrs[j] = wmem_alloc(allocator, 16 + (j * 8));
+        for (j = 0; j < 32; j++)
+            wmem_free(allocator, ptrs[j]);
+    }
+
+    if (thr->allocator == NULL)
+        wmem_destroy_allocator(allocator);
+    return NULL;
+}
+
+static double
+wmem_test_thread_perf_run(wmem_allocator_t *shared, int nthreads)
+{
+    wmem_test_perf_thread_t  thr;
+    GThread                **threads = g_new(GThread *, nthreads);
+    GTimer                  *timer = g_timer_new();
+    double                   elapsed_ms;
+    int                      i;
+
+    thr.allocator = shared;
+    for (i = 0; i < nthreads; i++)
+        threads[i] = g_thread_new("wmem_perf", wmem_test_thread_perf_worker, &thr);
+    for (i = 0; i < nthreads; i++)
+        g_thread_join(threads[i]);
+    elapsed_ms = g_timer_elapsed(timer, NULL) * 1000.0;
+
+    g_timer_destroy(timer);
+    g_free(threads);
+    return elapsed_ms;
+}
+
+static void
+wmem_test_thread_perf(void)
+{
+    static const int  thread_counts[] = { 1, 8, 32 };
+    wmem_allocator_t *allocator;
+    double            ms;
+    guint             i;
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_THREAD_SAFE);
+
+    for (i = 0; i < G_N_ELEMENTS(thread_counts); i++) {
+        ms = wmem_test_thread_perf_run(NULL, thread_counts[i]);
+        g_test_minimized_result(ms,
+            "per-thread block_fast pools, %d threads: %.3f ms", thread_counts[i], ms);
+
+        ms = wmem_test_thread_perf_run(allocator, thread_counts[i]);
+        g_test_minimized_result(ms,
+            "shared thread_safe pool, %d threads: %.3f ms", thread_counts[i], ms);
+        wmem_free_all(allocator);
+    }
+
+    wmem_destroy_allocator(allocator);
+}
+#endif /* GLIB_CHECK_VERSION(2,32,0) */
+
 /* UTILITY TESTING FUNCTIONS (/wmem/utils/) */
 
 static void
@@ -876,20 +1103,27 @@ check_val_map(gpointer key _U_, gpointer val, gpointer user_data)
     g_assert(val == user_data);
 }
 
+typedef wmem_map_t *(*wmem_test_map_new_func)(wmem_allocator_t *,
+        GHashFunc, GEqualFunc);
+typedef wmem_map_t *(*wmem_test_map_new_autoreset_func)(wmem_allocator_t *,
+        wmem_allocator_t *, GHashFunc, GEqualFunc);
+
 static void
-wmem_test_map(void)
+wmem_test_map_impl(wmem_test_map_new_func map_new,
+        wmem_test_map_new_autoreset_func map_new_autoreset)
 {
     wmem_allocator_t   *allocator, *extra_allocator;
     wmem_map_t       *map;
     gchar            *str_key;
     unsigned int      i;
-    void             *ret;
+    void             *ret, *key;
+    GHashTable       *ref;
 
     allocator = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
     extra_allocator = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
 
     /* insertion, lookup and removal of simple integer keys */
-    map = wmem_map_new(allocator, g_direct_hash, g_direct_equal);
+    map = map_new(allocator, g_direct_hash, g_direct_equal);
     g_assert(map);
 
     for (i=0; i<CONTAINER_ITERS; i++) {
@@ -913,7 +1147,7 @@ wmem_test_map(void)
     wmem_free_all(allocator);
 
     /* test auto-reset functionality */
-    map = wmem_map_new_autoreset(allocator, extra_allocator, g_direct_hash, g_direct_equal);
+    map = map_new_autoreset(allocator, extra_allocator, g_direct_hash, g_direct_equal);
     g_assert(map);
     for (i=0; i<CONTAINER_ITERS; i++) {
         ret = wmem_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(777777));
@@ -929,7 +1163,7 @@ wmem_test_map(void)
     }
     wmem_free_all(allocator);
 
-    map = wmem_map_new(allocator, wmem_str_hash, g_str_equal);
+    map = map_new(allocator, wmem_str_hash, g_str_equal);
     g_assert(map);
 
     /* string keys and for-each */
@@ -941,7 +1175,7 @@ wmem_test_map(void)
     }
 
     /* test foreach */
-    map = wmem_map_new(allocator, wmem_str_hash, g_str_equal);
+    map = map_new(allocator, wmem_str_hash, g_str_equal);
     g_assert(map);
     for (i=0; i<CONTAINER_ITERS; i++) {
         str_key = wmem_test_rand_string(allocator, 1, 64);
@@ -950,17 +1184,280 @@ wmem_test_map(void)
     wmem_map_foreach(map, check_val_map, GINT_TO_POINTER(2));
 
     /* test size */
-    map = wmem_map_new(allocator, g_direct_hash, g_direct_equal);
+    map = map_new(allocator, g_direct_hash, g_direct_equal);
     g_assert(map);
     for (i=0; i<CONTAINER_ITERS; i++) {
         wmem_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(i));
     }
     g_assert(wmem_map_size(map) == CONTAINER_ITERS);
+    wmem_free_all(allocator);
+
+    /* random insertions and removals in a small key space, checked against
+     * a glib hash table, to get plenty of collisions and shuffling */
+    map = map_new(allocator, g_direct_hash, g_direct_equal);
+    g_assert(map);
+    ref = g_hash_table_new(g_direct_hash, g_direct_equal);
+    for (i=0; i<CONTAINER_ITERS*10; i++) {
+        key = GINT_TO_POINTER(g_test_rand_int_range(1, 1024));
+        if (g_test_rand_bit()) {
+            ret = wmem_map_insert(map, key, GINT_TO_POINTER(i));
+            g_assert(ret == g_hash_table_lookup(ref, key));
+            g_hash_table_insert(ref, key, GINT_TO_POINTER(i));
+        } else {
+            ret = wmem_map_remove(map, key);
+            g_assert(ret == g_hash_table_lookup(ref, key));
+            g_hash_table_remove(ref, key);
+        }
+        g_assert(wmem_map_size(map) == g_hash_table_size(ref));
+    }
+    for (i=1; i<1024; i++) {
+        key = GINT_TO_POINTER(i);
+        g_assert(wmem_map_lookup(map, key) == g_hash_table_lookup(ref, key));
+    }
+    g_hash_table_destroy(ref);
 
     wmem_destroy_allocator(extra_allocator);
     wmem_destroy_allocator(allocator);
 }
 
+static void
+wmem_test_map(void)
+{
+    wmem_test_map_impl(wmem_map_new, wmem_map_new_autoreset);
+}
+
+static void
+wmem_test_map_open(void)
+{
+    wmem_test_map_impl(wmem_map_new_open, wmem_map_new_autoreset_open);
+}
+
+static void
+wmem_test_map_perf_run(const char *name, wmem_test_map_new_func map_new,
+        guint entries)
+{
+    wmem_allocator_t *allocator;
+    wmem_map_t       *map;
+    guint             i;
+    double            start_utime, start_stime, end_utime, end_stime, utime_ms, stime_ms;
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK);
+    map = map_new(allocator, g_direct_hash, g_direct_equal);
+
+    /* insert-heavy: each key goes in once */
+    RESOURCE_USAGE_START;
+    for (i=1; i<=entries; i++) {
+        wmem_map_insert(map, GUINT_TO_POINTER(i), GUINT_TO_POINTER(i));
+    }
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "%s map, %u inserts: u %.3f ms s %.3f ms", name, entries, utime_ms, stime_ms);
+
+    /* lookup-heavy: four lookups per entry, half of them misses */
+    RESOURCE_USAGE_START;
+    for (i=1; i<=entries*4; i++) {
+        wmem_map_lookup(map, GUINT_TO_POINTER((i * 2654435761u) % (entries*2) + 1));
+    }
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "%s map, %u lookups: u %.3f ms s %.3f ms", name, entries*4, utime_ms, stime_ms);
+
+    wmem_destroy_allocator(allocator);
+}
+
+/* NOTE: You have to run "wmem_test -m perf --verbose" to see results. */
+static void
+wmem_test_map_perf(void)
+{
+    wmem_test_map_perf_run("chained", wmem_map_new, 1000*1000);
+    wmem_test_map_perf_run("open", wmem_map_new_open, 1000*1000);
+
+    /* this needs several GB of memory */
+    if (g_test_thorough()) {
+        wmem_test_map_perf_run("chained", wmem_map_new, 100*1000*1000);
+        wmem_test_map_perf_run("open", wmem_map_new_open, 100*1000*1000);
+    }
+}
+
+/* The micro-benchmarks work on structures of this many entries, small
+ * enough to stay in cache so that they time the code, not the memory. */
+#define MICROBENCH_ENTRIES 65536
+
+typedef struct {
+    wmem_allocator_t       *allocator;
+    wmem_test_map_new_func  map_new;
+    wmem_map_t             *map;
+    gboolean                btree;
+    wmem_tree_t            *tree;
+} wmem_test_microbench_t;
+
+/* Keeps the compiler from dropping the lookups */
+static volatile gpointer wmem_test_microbench_sink;
+
+/* The insert benchmarks build a new structure each time, so they include
+ * the (cheap) wmem_free_all() of the block allocator. */
+static void
+wmem_test_microbench_map_insert(gpointer data)
+{
+    wmem_test_microbench_t *b = (wmem_test_microbench_t *)data;
+    wmem_map_t             *map;
+    guint                   i;
+
+    wmem_free_all(b->allocator);
+    map = b->map_new(b->allocator, g_direct_hash, g_direct_equal);
+    for (i=1; i<=MICROBENCH_ENTRIES; i++) {
+        wmem_map_insert(map, GUINT_TO_POINTER(i), GUINT_TO_POINTER(i));
+    }
+}
+
+/* half of the lookups are misses */
+static void
+wmem_test_microbench_map_lookup(gpointer data)
+{
+    wmem_test_microbench_t *b = (wmem_test_microbench_t *)data;
+    guint                   i;
+
+    for (i=1; i<=MICROBENCH_ENTRIES; i++) {
+        wmem_test_microbench_sink = wmem_map_lookup(b->map,
+                GUINT_TO_POINTER((i * 2654435761u) % (MICROBENCH_ENTRIES*2) + 1));
+    }
+}
+
+static void
+wmem_test_microbench_tree_insert(gpointer data)
+{
+    wmem_test_microbench_t *b = (wmem_test_microbench_t *)data;
+    wmem_tree_t            *tree;
+    guint32                 i;
+
+    wmem_free_all(b->allocator);
+    tree = b->btree ? wmem_tree_new_btree(b->allocator) : wmem_tree_new(b->allocator);
+    for (i=1; i<=MICROBENCH_ENTRIES; i++) {
+        wmem_tree_insert32(tree, i, GUINT_TO_POINTER(i));
+    }
+}
+
+static void
+wmem_test_microbench_tree_lookup(gpointer data)
+{
+    wmem_test_microbench_t *b = (wmem_test_microbench_t *)data;
+    guint32                 i;
+
+    for (i=1; i<=MICROBENCH_ENTRIES; i++) {
+        wmem_test_microbench_sink = wmem_tree_lookup32(b->tree,
+                (i * 2654435761u) % (MICROBENCH_ENTRIES*2) + 1);
+    }
+}
+
+static void
+wmem_test_microbench_strbuf_append_c(gpointer data)
+{
+    wmem_test_microbench_t *b = (wmem_test_microbench_t *)data;
+    wmem_strbuf_t          *strbuf;
+    guint                   i;
+
+    wmem_free_all(b->allocator);
+    strbuf = wmem_strbuf_new(b->allocator, "");
+    for (i=0; i<MICROBENCH_ENTRIES; i++) {
+        wmem_strbuf_append_c(strbuf, 'x');
+    }
+}
+
+static void
+wmem_test_microbench_strbuf_append(gpointer data)
+{
+    wmem_test_microbench_t *b = (wmem_test_microbench_t *)data;
+    wmem_strbuf_t          *strbuf;
+    guint                   i;
+
+    wmem_free_all(b->allocator);
+    strbuf = wmem_strbuf_new(b->allocator, "");
+    for (i=0; i<MICROBENCH_ENTRIES; i++) {
+        wmem_strbuf_append(strbuf, "0123456789abcdef");
+    }
+}
+
+static void
+wmem_test_microbench_strbuf_append_printf(gpointer data)
+{
+    wmem_test_microbench_t *b = (wmem_test_microbench_t *)data;
+    wmem_strbuf_t          *strbuf;
+    guint                   i;
+
+    wmem_free_all(b->allocator);
+    strbuf = wmem_strbuf_new(b->allocator, "");
+    for (i=0; i<MICROBENCH_ENTRIES; i++) {
+        wmem_strbuf_append_printf(strbuf, "%u, ", i);
+    }
+}
+
+/* Unlike the other perf tests these report percentiles over repeated
+ * runs, so that two builds can be compared: run "wmem_test -m perf -p
+ * /wmem/datastruct/microbench" on each and diff the output. */
+static void
+wmem_test_microbench(void)
+{
+    wmem_test_microbench_t b;
+    guint                  i;
+
+    b.allocator = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK);
+
+    ws_microbench_header();
+
+    b.map_new = wmem_map_new;
+    ws_microbench_run("wmem_map_insert (chained)", MICROBENCH_ENTRIES,
+            wmem_test_microbench_map_insert, &b);
+    b.map_new = wmem_map_new_open;
+    ws_microbench_run("wmem_map_insert (open)", MICROBENCH_ENTRIES,
+            wmem_test_microbench_map_insert, &b);
+
+    wmem_free_all(b.allocator);
+    b.map = wmem_map_new(b.allocator, g_direct_hash, g_direct_equal);
+    for (i=1; i<=MICROBENCH_ENTRIES; i++) {
+        wmem_map_insert(b.map, GUINT_TO_POINTER(i), GUINT_TO_POINTER(i));
+    }
+    ws_microbench_run("wmem_map_lookup (chained)", MICROBENCH_ENTRIES,
+            wmem_test_microbench_map_lookup, &b);
+    wmem_free_all(b.allocator);
+    b.map = wmem_map_new_open(b.allocator, g_direct_hash, g_direct_equal);
+    for (i=1; i<=MICROBENCH_ENTRIES; i++) {
+        wmem_map_insert(b.map, GUINT_TO_POINTER(i), GUINT_TO_POINTER(i));
+    }
+    ws_microbench_run("wmem_map_lookup (open)", MICROBENCH_ENTRIES,
+            wmem_test_microbench_map_lookup, &b);
+
+    b.btree = FALSE;
+    ws_microbench_run("wmem_tree_insert32 (red-black)", MICROBENCH_ENTRIES,
+            wmem_test_microbench_tree_insert, &b);
+    b.btree = TRUE;
+    ws_microbench_run("wmem_tree_insert32 (btree)", MICROBENCH_ENTRIES,
+            wmem_test_microbench_tree_insert, &b);
+
+    wmem_free_all(b.allocator);
+    b.tree = wmem_tree_new(b.allocator);
+    for (i=1; i<=MICROBENCH_ENTRIES; i++) {
+        wmem_tree_insert32(b.tree, i, GUINT_TO_POINTER(i));
+    }
+    ws_microbench_run("wmem_tree_lookup32 (red-black)", MICROBENCH_ENTRIES,
+            wmem_test_microbench_tree_lookup, &b);
+    wmem_free_all(b.allocator);
+    b.tree = wmem_tree_new_btree(b.allocator);
+    for (i=1; i<=MICROBENCH_ENTRIES; i++) {
+        wmem_tree_insert32(b.tree, i, GUINT_TO_POINTER(i));
+    }
+    ws_microbench_run("wmem_tree_lookup32 (btree)", MICROBENCH_ENTRIES,
+            wmem_test_microbench_tree_lookup, &b);
+
+    ws_microbench_run("wmem_strbuf_append_c", MICROBENCH_ENTRIES,
+            wmem_test_microbench_strbuf_append_c, &b);
+    ws_microbench_run("wmem_strbuf_append (16 bytes)", MICROBENCH_ENTRIES,
+            wmem_test_microbench_strbuf_append, &b);
+    ws_microbench_run("wmem_strbuf_append_printf", MICROBENCH_ENTRIES,
+            wmem_test_microbench_strbuf_append_printf, &b);
+
+    wmem_destroy_allocator(b.allocator);
+}
+
 static void
 wmem_test_queue(void)
 {
@@ -1116,13 +1613,41 @@ wmem_test_strbuf(void)
     wmem_destroy_allocator(allocator);
 }
 
+typedef wmem_tree_t *(*wmem_test_tree_new_func)(wmem_allocator_t *);
+typedef wmem_tree_t *(*wmem_test_tree_new_autoreset_func)(wmem_allocator_t *,
+        wmem_allocator_t *);
+
+typedef struct {
+    guint32 low, high;
+    guint32 last;
+    guint   count;
+} wmem_test_tree_range_t;
+
+static gboolean
+wmem_test_tree_range_cb(const void *key, void *value, void *user_data)
+{
+    wmem_test_tree_range_t *range = (wmem_test_tree_range_t *)user_data;
+    guint32                 k = GPOINTER_TO_UINT(key);
+
+    g_assert(k >= range->low && k <= range->high);
+    g_assert(range->count == 0 || k > range->last);
+    g_assert(GPOINTER_TO_UINT(value) == k);
+
+    range->last = k;
+    range->count++;
+
+    return FALSE;
+}
+
 static void
-wmem_test_tree(void)
+wmem_test_tree_impl(wmem_test_tree_new_func tree_new,
+        wmem_test_tree_new_autoreset_func tree_new_autoreset)
 {
     wmem_allocator_t   *allocator, *extra_allocator;
     wmem_tree_t        *tree;
     guint32             i;
     int                 seen_values = 0;
+    wmem_test_tree_range_t range;
     int                 j;
     gchar              *str_key;
 #define WMEM_TREE_MAX_KEY_COUNT 8
@@ -1133,7 +1658,7 @@ wmem_test_tree(void)
     allocator       = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
     extra_allocator = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
 
-    tree = wmem_tree_new(allocator);
+    tree = tree_new(allocator);
     g_assert(tree);
     g_assert(wmem_tree_is_empty(tree));
 
@@ -1150,7 +1675,7 @@ wmem_test_tree(void)
     g_assert(wmem_tree_count(tree) == CONTAINER_ITERS);
     wmem_free_all(allocator);
 
-    tree = wmem_tree_new(allocator);
+    tree = tree_new(allocator);
     for (i=0; i<CONTAINER_ITERS; i++) {
         guint32 rand_int = g_test_rand_int();
         wmem_tree_insert32(tree, rand_int, GINT_TO_POINTER(i));
@@ -1160,7 +1685,7 @@ wmem_test_tree(void)
     wmem_free_all(allocator);
 
     /* test auto-reset functionality */
-    tree = wmem_tree_new_autoreset(allocator, extra_allocator);
+    tree = tree_new_autoreset(allocator, extra_allocator);
     for (i=0; i<CONTAINER_ITERS; i++) {
         g_assert(wmem_tree_lookup32(tree, i) == NULL);
         wmem_tree_insert32(tree, i, GINT_TO_POINTER(i));
@@ -1176,7 +1701,7 @@ wmem_test_tree(void)
     wmem_free_all(allocator);
 
     /* test array key functionality */
-    tree = wmem_tree_new(allocator);
+    tree = tree_new(allocator);
     key_count = g_random_int_range(1, WMEM_TREE_MAX_KEY_COUNT);
     for (j=0; j<key_count; j++) {
         keys[j].length = g_random_int_range(1, WMEM_TREE_MAX_KEY_LEN);
@@ -1192,7 +1717,7 @@ wmem_test_tree(void)
     }
     wmem_free_all(allocator);
 
-    tree = wmem_tree_new(allocator);
+    tree = tree_new(allocator);
     keys[0].length = 1;
     keys[0].key    = wmem_new(allocator, guint32);
     *(keys[0].key) = 0;
@@ -1214,7 +1739,7 @@ wmem_test_tree(void)
     wmem_free_all(allocator);
 
     /* test string key functionality */
-    tree = wmem_tree_new(allocator);
+    tree = tree_new(allocator);
     for (i=0; i<CONTAINER_ITERS; i++) {
         str_key = wmem_test_rand_string(allocator, 1, 64);
         wmem_tree_insert_string(tree, str_key, GINT_TO_POINTER(i), 0);
@@ -1223,7 +1748,7 @@ wmem_test_tree(void)
     }
     wmem_free_all(allocator);
 
-    tree = wmem_tree_new(allocator);
+    tree = tree_new(allocator);
     for (i=0; i<CONTAINER_ITERS; i++) {
         str_key = wmem_test_rand_string(allocator, 1, 64);
         wmem_tree_insert_string(tree, str_key, GINT_TO_POINTER(i),
@@ -1234,7 +1759,7 @@ wmem_test_tree(void)
     wmem_free_all(allocator);
 
     /* test for-each functionality */
-    tree = wmem_tree_new(allocator);
+    tree = tree_new(allocator);
     expected_user_data = GINT_TO_POINTER(g_test_rand_int());
     for (i=0; i<CONTAINER_ITERS; i++) {
         gint tmp;
@@ -1268,12 +1793,51 @@ wmem_test_tree(void)
         }
     }
     g_assert(seen_values == 10);
+    wmem_free_all(allocator);
+
+    /* test range traversal */
+    tree = tree_new(allocator);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        wmem_tree_insert32(tree, i*2, GUINT_TO_POINTER(i*2));
+    }
+    range.low   = 101;
+    range.high  = 300;
+    range.count = 0;
+    g_assert(!wmem_tree_foreach_range32(tree, range.low, range.high,
+                wmem_test_tree_range_cb, &range));
+    g_assert(range.count == 100);
+    g_assert(range.last == 300);
+
+    range.low   = 0;
+    range.high  = G_MAXUINT32;
+    range.count = 0;
+    wmem_tree_foreach_range32(tree, range.low, range.high,
+            wmem_test_tree_range_cb, &range);
+    g_assert(range.count == CONTAINER_ITERS);
+
+    range.low   = CONTAINER_ITERS*2;
+    range.count = 0;
+    wmem_tree_foreach_range32(tree, range.low, range.high,
+            wmem_test_tree_range_cb, &range);
+    g_assert(range.count == 0);
 
     wmem_destroy_allocator(extra_allocator);
     wmem_destroy_allocator(allocator);
 }
 
 
+static void
+wmem_test_tree(void)
+{
+    wmem_test_tree_impl(wmem_tree_new, wmem_tree_new_autoreset);
+}
+
+static void
+wmem_test_tree_btree(void)
+{
+    wmem_test_tree_impl(wmem_tree_new_btree, wmem_tree_new_autoreset_btree);
+}
+
 /* to be used as userdata in the callback wmem_test_itree_check_overlap_cb*/
 typedef struct wmem_test_itree_user_data {
     wmem_range_t range;
@@ -1389,7 +1953,12 @@ main(int argc, char **argv)
     g_test_add_func("/wmem/allocator/blk_fast",  wmem_test_allocator_block_fast);
     g_test_add_func("/wmem/allocator/simple",    wmem_test_allocator_simple);
     g_test_add_func("/wmem/allocator/strict",    wmem_test_allocator_strict);
+    g_test_add_func("/wmem/allocator/thread_safe", wmem_test_allocator_thread_safe);
+#if GLIB_CHECK_VERSION(2,32,0)
+    g_test_add_func("/wmem/allocator/threads",   wmem_test_allocator_thread_safe_threads);
+#endif
     g_test_add_func("/wmem/allocator/callbacks", wmem_test_allocator_callbacks);
+    g_test_add_func("/wmem/allocator/footprint", wmem_test_allocator_footprint);
 
     g_test_add_func("/wmem/utils/misc",    wmem_test_miscutls);
     g_test_add_func("/wmem/utils/strings", wmem_test_strutls);
@@ -1398,13 +1967,23 @@ main(int argc, char **argv)
         g_test_add_func("/wmem/utils/stringperf", wmem_test_stringperf);
     }
 
+    if (g_test_perf()) {
+#if GLIB_CHECK_VERSION(2,32,0)
+        g_test_add_func("/wmem/allocator/threadperf", wmem_test_thread_perf);
+#endif
+        g_test_add_func("/wmem/datastruct/mapperf", wmem_test_map_perf);
+        g_test_add_func("/wmem/datastruct/microbench", wmem_test_microbench);
+    }
+
     g_test_add_func("/wmem/datastruct/array",  wmem_test_array);
     g_test_add_func("/wmem/datastruct/list",   wmem_test_list);
     g_test_add_func("/wmem/datastruct/map",    wmem_test_map);
+    g_test_add_func("/wmem/datastruct/map_open", wmem_test_map_open);
     g_test_add_func("/wmem/datastruct/queue",  wmem_test_queue);
     g_test_add_func("/wmem/datastruct/stack",  wmem_test_stack);
     g_test_add_func("/wmem/datastruct/strbuf", wmem_test_strbuf);
     g_test_add_func("/wmem/datastruct/tree",   wmem_test_tree);
+    g_test_add_func("/wmem/datastruct/btree",  wmem_test_tree_btree);
     g_test_add_func("/wmem/datastruct/itree",  wmem_test_itree);
 
     ret = g_test_run();
@@ -56,6 +56,29 @@ typedef struct _wmem_tree_node_t wmem_tree_node_t;
 
 typedef struct _wmem_itree_node_t wmem_itree_node_t;
 
+/* B+tree nodes, used for the 32-bit keys of trees created with
+ * wmem_tree_new_btree(). Both kinds start with the same header. */
+#define WMEM_BTREE_ORDER 32 /* max keys per node */
+
+typedef struct _wmem_btree_node_t {
+    guint    count;    /* number of keys in use */
+    gboolean is_leaf;
+    guint32  keys[WMEM_BTREE_ORDER];
+} wmem_btree_node_t;
+
+typedef struct _wmem_btree_inner_t {
+    wmem_btree_node_t  header;
+    /* children[i+1] holds the keys >= keys[i] */
+    wmem_btree_node_t *children[WMEM_BTREE_ORDER + 1];
+} wmem_btree_inner_t;
+
+typedef struct _wmem_btree_leaf_t {
+    wmem_btree_node_t           header;
+    void                       *data[WMEM_BTREE_ORDER];
+    guint8                      is_subtree[WMEM_BTREE_ORDER];
+    struct _wmem_btree_leaf_t  *next; /* leaves are chained in key order */
+} wmem_btree_leaf_t;
+
 struct _wmem_tree_t {
     wmem_allocator_t *master;
     wmem_allocator_t *allocator;
@@ -63,6 +86,11 @@ struct _wmem_tree_t {
     guint             master_cb_id;
     guint             slave_cb_id;
 
+    /* B+tree trees keep their 32-bit (and array) keys here instead of
+     * under 'root'; string keys still use red-black nodes. */
+    gboolean           is_btree;
+    wmem_btree_node_t *broot;
+
     void (*post_rotation_cb)(wmem_tree_node_t *);
 };
 
@@ -206,6 +206,316 @@ rb_insert_case1(wmem_tree_t *tree, wmem_tree_node_t *node)
     }
 }
 
+#define CREATE_DATA(TRANSFORM, DATA) ((TRANSFORM) ? (TRANSFORM)(DATA) : (DATA))
+
+/* B+tree backend for 32-bit keys. Keys are never really removed from a wmem
+ * tree (removal just stores NULL data, see wmem_tree_remove32), so only
+ * insertion needs to restructure the tree. Every leaf is at the same depth,
+ * and the first key of every child but the leftmost is exactly the separator
+ * in front of it. */
+
+/* Returns the number of keys in node that are <= key */
+static guint
+btree_upper_bound(const wmem_btree_node_t *node, guint32 key)
+{
+    guint lo = 0, hi = node->count, mid;
+
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (node->keys[mid] <= key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+static wmem_btree_leaf_t *
+btree_find_leaf(const wmem_tree_t *tree, guint32 key)
+{
+    wmem_btree_node_t *node = tree->broot;
+
+    while (node && !node->is_leaf) {
+        node = ((wmem_btree_inner_t *)node)->children[btree_upper_bound(node, key)];
+    }
+
+    return (wmem_btree_leaf_t *)node;
+}
+
+static wmem_btree_leaf_t *
+btree_new_leaf(wmem_allocator_t *allocator)
+{
+    wmem_btree_leaf_t *leaf;
+
+    leaf = wmem_new(allocator, wmem_btree_leaf_t);
+    leaf->header.count   = 0;
+    leaf->header.is_leaf = TRUE;
+    leaf->next           = NULL;
+
+    return leaf;
+}
+
+static void
+btree_leaf_insert_at(wmem_btree_leaf_t *leaf, guint pos, guint32 key,
+        void *data, gboolean is_subtree)
+{
+    guint n = leaf->header.count - pos;
+
+    memmove(&leaf->header.keys[pos + 1], &leaf->header.keys[pos], n * sizeof(guint32));
+    memmove(&leaf->data[pos + 1], &leaf->data[pos], n * sizeof(void *));
+    memmove(&leaf->is_subtree[pos + 1], &leaf->is_subtree[pos], n);
+
+    leaf->header.keys[pos] = key;
+    leaf->data[pos]        = data;
+    leaf->is_subtree[pos]  = is_subtree ? 1 : 0;
+    leaf->header.count++;
+}
+
+/* Inserts a key known not to be in the subtree at node. If node had to be
+ * split, returns the new right-hand sibling and sets *split_key to its first
+ * key; otherwise returns NULL. */
+static wmem_btree_node_t *
+btree_insert_node(wmem_allocator_t *allocator, wmem_btree_node_t *node,
+        guint32 key, void *data, gboolean is_subtree, guint32 *split_key)
+{
+    wmem_btree_inner_t *inner, *right_inner;
+    wmem_btree_leaf_t  *leaf, *right_leaf;
+    wmem_btree_node_t  *child, *new_child;
+    guint32             child_key;
+    guint               pos, half, n;
+
+    pos = btree_upper_bound(node, key);
+
+    if (node->is_leaf) {
+        leaf = (wmem_btree_leaf_t *)node;
+        if (node->count < WMEM_BTREE_ORDER) {
+            btree_leaf_insert_at(leaf, pos, key, data, is_subtree);
+            return NULL;
+        }
+
+        /* split the full leaf in half, then insert into the right half */
+        half = WMEM_BTREE_ORDER / 2;
+        right_leaf = btree_new_leaf(allocator);
+        n = WMEM_BTREE_ORDER - half;
+        memcpy(right_leaf->header.keys, &node->keys[half], n * sizeof(guint32));
+        memcpy(right_leaf->data, &leaf->data[half], n * sizeof(void *));
+        memcpy(right_leaf->is_subtree, &leaf->is_subtree[half], n);
+        right_leaf->header.count = n;
+        node->count = half;
+
+        right_leaf->next = leaf->next;
+        leaf->next       = right_leaf;
+
+        if (pos <= half) {
+            btree_leaf_insert_at(leaf, pos, key, data, is_subtree);
+        } else {
+            btree_leaf_insert_at(right_leaf, pos - half, key, data, is_subtree);
+        }
+
+        *split_key = right_leaf->header.keys[0];
+        return (wmem_btree_node_t *)right_leaf;
+    }
+
+    inner = (wmem_btree_inner_t *)node;
+    child = inner->children[pos];
+    new_child = btree_insert_node(allocator, child, key, data, is_subtree,
+            &child_key);
+    if (!new_child) {
+        return NULL;
+    }
+
+    if (node->count < WMEM_BTREE_ORDER) {
+        n = node->count - pos;
+        memmove(&node->keys[pos + 1], &node->keys[pos], n * sizeof(guint32));
+        memmove(&inner->children[pos + 2], &inner->children[pos + 1],
+                n * sizeof(wmem_btree_node_t *));
+        node->keys[pos]          = child_key;
+        inner->children[pos + 1] = new_child;
+        node->count++;
+        return NULL;
+    }
+
+    /* Split the full inner node. Conceptually it now has ORDER+1 keys; the
+     * middle one moves up to the parent and the rest are shared out. */
+    {
+        guint32            keys[WMEM_BTREE_ORDER + 1];
+        wmem_btree_node_t *children[WMEM_BTREE_ORDER + 2];
+        guint              mid = (WMEM_BTREE_ORDER + 1) / 2;
+
+        memcpy(keys, node->keys, pos * sizeof(guint32));
+        keys[pos] = child_key;
+        memcpy(&keys[pos + 1], &node->keys[pos],
+                (WMEM_BTREE_ORDER - pos) * sizeof(guint32));
+
+        memcpy(children, inner->children, (pos + 1) * sizeof(wmem_btree_node_t *));
+        children[pos + 1] = new_child;
+        memcpy(&children[pos + 2], &inner->children[pos + 1],
+                (WMEM_BTREE_ORDER - pos) * sizeof(wmem_btree_node_t *));
+
+        right_inner = wmem_new(allocator, wmem_btree_inner_t);
+        right_inner->header.is_leaf = FALSE;
+        right_inner->header.count   = WMEM_BTREE_ORDER - mid;
+        memcpy(right_inner->header.keys, &keys[mid + 1],
+                right_inner->header.count * sizeof(guint32));
+        memcpy(right_inner->children, &children[mid + 1],
+                (right_inner->header.count + 1) * sizeof(wmem_btree_node_t *));
+
+        node->count = mid;
+        memcpy(node->keys, keys, mid * sizeof(guint32));
+        memcpy(inner->children, children, (mid + 1) * sizeof(wmem_btree_node_t *));
+
+        *split_key = keys[mid];
+    }
+
+    return (wmem_btree_node_t *)right_inner;
+}
+
+static void *
+btree_lookup_or_insert32(wmem_tree_t *tree, guint32 key,
+        void*(*func)(void*), void* data, gboolean is_subtree, gboolean replace)
+{
+    wmem_btree_leaf_t  *leaf;
+    wmem_btree_inner_t *root;
+    wmem_btree_node_t  *sibling;
+    guint32             split_key;
+    guint               pos;
+    void               *new_data;
+
+    if (!tree->broot) {
+        tree->broot = (wmem_btree_node_t *)btree_new_leaf(tree->allocator);
+    }
+
+    leaf = btree_find_leaf(tree, key);
+    pos  = btree_upper_bound(&leaf->header, key);
+    if (pos > 0 && leaf->header.keys[pos - 1] == key) {
+        /* this key already exists, so just return the data pointer */
+        if (replace) {
+            leaf->data[pos - 1] = CREATE_DATA(func, data);
+        }
+        return leaf->data[pos - 1];
+    }
+
+    new_data = CREATE_DATA(func, data);
+    sibling  = btree_insert_node(tree->allocator, tree->broot, key, new_data,
+            is_subtree, &split_key);
+    if (sibling) {
+        /* the root was split, so grow the tree by one level */
+        root = wmem_new(tree->allocator, wmem_btree_inner_t);
+        root->header.is_leaf = FALSE;
+        root->header.count   = 1;
+        root->header.keys[0] = split_key;
+        root->children[0]    = tree->broot;
+        root->children[1]    = sibling;
+        tree->broot = (wmem_btree_node_t *)root;
+    }
+
+    return new_data;
+}
+
+static void *
+btree_lookup32(wmem_tree_t *tree, guint32 key)
+{
+    wmem_btree_leaf_t *leaf = btree_find_leaf(tree, key);
+    guint              pos;
+
+    if (!leaf) {
+        return NULL;
+    }
+
+    pos = btree_upper_bound(&leaf->header, key);
+    if (pos > 0 && leaf->header.keys[pos - 1] == key) {
+        return leaf->data[pos - 1];
+    }
+
+    return NULL;
+}
+
+static void *
+btree_lookup32_le(wmem_tree_t *tree, guint32 key)
+{
+    wmem_btree_leaf_t *leaf = btree_find_leaf(tree, key);
+    guint              pos;
+
+    if (!leaf) {
+        return NULL;
+    }
+
+    /* Because every separator is the first key of the child after it, the
+     * leaf we land in always holds the largest key <= key, unless it is the
+     * leftmost leaf and every key in the tree is bigger. */
+    pos = btree_upper_bound(&leaf->header, key);
+    if (pos == 0) {
+        return NULL;
+    }
+
+    return leaf->data[pos - 1];
+}
+
+static gboolean
+btree_foreach_range(wmem_tree_t *tree, guint32 low, guint32 high,
+        wmem_foreach_func callback, void *user_data)
+{
+    wmem_btree_leaf_t *leaf = btree_find_leaf(tree, low);
+    guint              i;
+
+    if (!leaf) {
+        return FALSE;
+    }
+
+    /* start at the first key >= low */
+    i = btree_upper_bound(&leaf->header, low);
+    if (i > 0 && leaf->header.keys[i - 1] == low) {
+        i--;
+    }
+
+    for (; leaf; leaf = leaf->next, i = 0) {
+        for (; i < leaf->header.count; i++) {
+            if (leaf->header.keys[i] > high) {
+                return FALSE;
+            }
+            if (leaf->is_subtree[i]) {
+                if (wmem_tree_foreach((wmem_tree_t *)leaf->data[i],
+                            callback, user_data)) {
+                    return TRUE;
+                }
+            } else if (callback(GUINT_TO_POINTER(leaf->header.keys[i]),
+                        leaf->data[i], user_data)) {
+                return TRUE;
+            }
+        }
+    }
+
+    return FALSE;
+}
+
+static void
+btree_free_node(wmem_allocator_t *allocator, wmem_btree_node_t *node,
+        gboolean free_keys, gboolean free_values)
+{
+    wmem_btree_leaf_t *leaf;
+    guint              i;
+
+    if (node->is_leaf) {
+        leaf = (wmem_btree_leaf_t *)node;
+        for (i = 0; i < node->count; i++) {
+            if (leaf->is_subtree[i]) {
+                wmem_tree_destroy((wmem_tree_t *)leaf->data[i], free_keys, free_values);
+            } else if (free_values) {
+                wmem_free(allocator, leaf->data[i]);
+            }
+        }
+    } else {
+        for (i = 0; i <= node->count; i++) {
+            btree_free_node(allocator, ((wmem_btree_inner_t *)node)->children[i],
+                    free_keys, free_values);
+        }
+    }
+
+    wmem_free(allocator, node);
+}
+
 wmem_tree_t *
 wmem_tree_new(wmem_allocator_t *allocator)
 {
@@ -224,7 +534,8 @@ wmem_tree_reset_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event,
 {
     wmem_tree_t *tree = (wmem_tree_t *)user_data;
 
-    tree->root = NULL;
+    tree->root  = NULL;
+    tree->broot = NULL;
 
     if (event == WMEM_CB_DESTROY_EVENT) {
         wmem_unregister_callback(tree->master, tree->master_cb_id);
@@ -262,6 +573,28 @@ wmem_tree_new_autoreset(wmem_allocator_t *master, wmem_allocator_t *slave)
     return tree;
 }
 
+wmem_tree_t *
+wmem_tree_new_btree(wmem_allocator_t *allocator)
+{
+    wmem_tree_t *tree;
+
+    tree = wmem_tree_new(allocator);
+    tree->is_btree = TRUE;
+
+    return tree;
+}
+
+wmem_tree_t *
+wmem_tree_new_autoreset_btree(wmem_allocator_t *master, wmem_allocator_t *slave)
+{
+    wmem_tree_t *tree;
+
+    tree = wmem_tree_new_autoreset(master, slave);
+    tree->is_btree = TRUE;
+
+    return tree;
+}
+
 static void
 free_tree_node(wmem_allocator_t *allocator, wmem_tree_node_t* node, gboolean free_keys, gboolean free_values)
 {
@@ -296,6 +629,10 @@ void
 wmem_tree_destroy(wmem_tree_t *tree, gboolean free_keys, gboolean free_values)
 {
     free_tree_node(tree->allocator, tree->root, free_keys, free_values);
+    if (tree->broot) {
+        /* 32-bit keys aren't pointers, so free_keys doesn't apply to them */
+        btree_free_node(tree->allocator, tree->broot, FALSE, free_values);
+    }
     wmem_unregister_callback(tree->master, tree->master_cb_id);
     wmem_unregister_callback(tree->allocator, tree->slave_cb_id);
     wmem_free(tree->master, tree);
@@ -304,7 +641,7 @@ wmem_tree_destroy(wmem_tree_t *tree, gboolean free_keys, gboolean free_values)
 gboolean
 wmem_tree_is_empty(wmem_tree_t *tree)
 {
-    return tree->root == NULL;
+    return tree->root == NULL && tree->broot == NULL;
 }
 
 static gboolean
@@ -350,9 +687,6 @@ create_node(wmem_allocator_t *allocator, wmem_tree_node_t *parent, const void *k
     return node;
 }
 
-#define CREATE_DATA(TRANSFORM, DATA) ((TRANSFORM) ? (TRANSFORM)(DATA) : (DATA))
-
-
 /**
  * return inserted node
  */
@@ -419,7 +753,13 @@ static void *
 lookup_or_insert32(wmem_tree_t *tree, guint32 key,
         void*(*func)(void*), void* data, gboolean is_subtree, gboolean replace)
 {
-    wmem_tree_node_t *node = lookup_or_insert32_node(tree, key, func, data, is_subtree, replace);
+    wmem_tree_node_t *node;
+
+    if (tree->is_btree) {
+        return btree_lookup_or_insert32(tree, key, func, data, is_subtree, replace);
+    }
+
+    node = lookup_or_insert32_node(tree, key, func, data, is_subtree, replace);
     return node->data;
 }
 
@@ -513,6 +853,10 @@ wmem_tree_lookup32(wmem_tree_t *tree, guint32 key)
 {
     wmem_tree_node_t *node = tree->root;
 
+    if (tree->is_btree) {
+        return btree_lookup32(tree, key);
+    }
+
     while (node) {
         if (key == GPOINTER_TO_UINT(node->key)) {
             return node->data;
@@ -533,6 +877,10 @@ wmem_tree_lookup32_le(wmem_tree_t *tree, guint32 key)
 {
     wmem_tree_node_t *node = tree->root;
 
+    if (tree->is_btree) {
+        return btree_lookup32_le(tree, key);
+    }
+
     while (node) {
         if (key == GPOINTER_TO_UINT(node->key)) {
             return node->data;
@@ -646,7 +994,12 @@ wmem_tree_remove_string(wmem_tree_t* tree, const gchar* k, guint32 flags)
 static void *
 create_sub_tree(void* d)
 {
-    return wmem_tree_new(((wmem_tree_t *)d)->allocator);
+    wmem_tree_t *tree = (wmem_tree_t *)d;
+
+    if (tree->is_btree) {
+        return wmem_tree_new_btree(tree->allocator);
+    }
+    return wmem_tree_new(tree->allocator);
 }
 
 void
@@ -762,12 +1115,78 @@ gboolean
 wmem_tree_foreach(wmem_tree_t* tree, wmem_foreach_func callback,
         void *user_data)
 {
+    if (tree->broot) {
+        if (btree_foreach_range(tree, 0, G_MAXUINT32, callback, user_data)) {
+            return TRUE;
+        }
+    }
+
     if(!tree->root)
         return FALSE;
 
     return wmem_tree_foreach_nodes(tree->root, callback, user_data);
 }
 
+static gboolean
+wmem_tree_foreach_range32_nodes(wmem_tree_node_t* node, guint32 low,
+        guint32 high, wmem_foreach_func callback, void *user_data)
+{
+    guint32  key;
+    gboolean stop_traverse = FALSE;
+
+    if (!node) {
+        return FALSE;
+    }
+
+    key = GPOINTER_TO_UINT(node->key);
+
+    /* only go left if there can be keys >= low there, and similarly right */
+    if (key > low) {
+        if (wmem_tree_foreach_range32_nodes(node->left, low, high,
+                    callback, user_data)) {
+            return TRUE;
+        }
+    }
+
+    if (key >= low && key <= high) {
+        if (node->is_subtree) {
+            stop_traverse = wmem_tree_foreach((wmem_tree_t *)node->data,
+                    callback, user_data);
+        } else if (!node->is_removed) {
+            stop_traverse = callback(node->key, node->data, user_data);
+        }
+        if (stop_traverse) {
+            return TRUE;
+        }
+    }
+
+    if (key < high) {
+        return wmem_tree_foreach_range32_nodes(node->right, low, high,
+                callback, user_data);
+    }
+
+    return FALSE;
+}
+
+gboolean
+wmem_tree_foreach_range32(wmem_tree_t* tree, guint32 low, guint32 high,
+        wmem_foreach_func callback, void *user_data)
+{
+    if (low > high) {
+        return FALSE;
+    }
+
+    if (tree->is_btree) {
+        if (!tree->broot) {
+            return FALSE;
+        }
+        return btree_foreach_range(tree, low, high, callback, user_data);
+    }
+
+    return wmem_tree_foreach_range32_nodes(tree->root, low, high,
+            callback, user_data);
+}
+
 static void wmem_print_subtree(wmem_tree_t *tree, guint32 level, wmem_printer_func key_printer, wmem_printer_func data_printer);
 
 static void
@@ -778,6 +1197,37 @@ wmem_print_indent(guint32 level) {
     }
 }
 
+static void
+wmem_btree_print_leaves(wmem_tree_t *tree, guint32 level,
+    wmem_printer_func key_printer, wmem_printer_func data_printer)
+{
+    wmem_btree_leaf_t *leaf = btree_find_leaf(tree, 0);
+    guint              i;
+
+    for (; leaf; leaf = leaf->next) {
+        wmem_print_indent(level);
+        ws_debug_printf("LEAF:%p count:%u next:%p\n",
+                (void *)leaf, leaf->header.count, (void *)leaf->next);
+        for (i = 0; i < leaf->header.count; i++) {
+            wmem_print_indent(level+1);
+            ws_debug_printf("key:%u %s:%p\n", leaf->header.keys[i],
+                    leaf->is_subtree[i]?"tree":"data", leaf->data[i]);
+            if (key_printer) {
+                wmem_print_indent(level+1);
+                key_printer(GUINT_TO_POINTER(leaf->header.keys[i]));
+                ws_debug_printf("\n");
+            }
+            if (data_printer && !leaf->is_subtree[i]) {
+                wmem_print_indent(level+1);
+                data_printer(leaf->data[i]);
+                ws_debug_printf("\n");
+            }
+            if (leaf->is_subtree[i])
+                wmem_print_subtree((wmem_tree_t *)leaf->data[i], level+2, key_printer, data_printer);
+        }
+    }
+}
+
 static void
 wmem_tree_print_nodes(const char *prefix, wmem_tree_node_t *node, guint32 level,
     wmem_printer_func key_printer, wmem_printer_func data_printer)
@@ -826,6 +1276,9 @@ wmem_print_subtree(wmem_tree_t *tree, guint32 level, wmem_printer_func key_print
     if (tree->root) {
         wmem_tree_print_nodes("Root-", tree->root, level, key_printer, data_printer);
     }
+    if (tree->broot) {
+        wmem_btree_print_leaves(tree, level, key_printer, data_printer);
+    }
 }
 
 void
@@ -42,6 +42,10 @@ extern "C" {
  *    time for lookups, compared to linked lists that are O(n). This means
  *    red/black trees scale very well when many objects are being stored.
  *
+ *    Trees created with wmem_tree_new_btree() keep their 32-bit and array
+ *    keys in a B+tree with wide nodes instead, which needs far fewer pointer
+ *    dereferences per lookup in large trees. Both kinds share the API below.
+ *
  *    @{
  */
 
@@ -72,6 +76,22 @@ wmem_tree_t *
 wmem_tree_new_autoreset(wmem_allocator_t *master, wmem_allocator_t *slave)
 G_GNUC_MALLOC;
 
+/** Like wmem_tree_new(), but 32-bit and array keys are stored in a B+tree.
+ * This is a better fit for trees with many entries that are looked up often,
+ * such as per-segment state of long TCP streams. String keys are still
+ * stored in red/black nodes. */
+WS_DLL_PUBLIC
+wmem_tree_t *
+wmem_tree_new_btree(wmem_allocator_t *allocator)
+G_GNUC_MALLOC;
+
+/** Like wmem_tree_new_autoreset(), but with the B+tree backend described for
+ * wmem_tree_new_btree(). */
+WS_DLL_PUBLIC
+wmem_tree_t *
+wmem_tree_new_autoreset_btree(wmem_allocator_t *master, wmem_allocator_t *slave)
+G_GNUC_MALLOC;
+
 /** Cleanup memory used by tree.  Intended for NULL scope allocated trees */
 WS_DLL_PUBLIC
 void
@@ -237,6 +257,16 @@ gboolean
 wmem_tree_foreach(wmem_tree_t* tree, wmem_foreach_func callback,
         void *user_data);
 
+/** Like wmem_tree_foreach(), but only visits the guint32 keys from low to high
+ * (inclusive), in ascending order. For array keys the range applies to the
+ * first key; every entry below a matching first key is visited. Returns TRUE
+ * if the traversal was ended prematurely by the callback.
+ */
+WS_DLL_PUBLIC
+gboolean
+wmem_tree_foreach_range32(wmem_tree_t* tree, guint32 low, guint32 high,
+        wmem_foreach_func callback, void *user_data);
+
 
 /* Accepts callbacks to print the key and/or data (both printers can be null) */
 void
@@ -30,6 +30,7 @@
 #include "init_wslua.h"
 #include <epan/dissectors/packet-frame.h>
 #include <math.h>
+#include <stdio.h>
 #include <epan/expert.h>
 #include <epan/ex-opt.h>
 #include <wsutil/privileges.h>
@@ -137,6 +138,90 @@ static expert_field ei_lua_proto_deprecated_error   = EI_INIT;
 
 dissector_handle_t lua_data_handle;
 
+/* Time spent in each Lua dissector, kept if WIRESHARK_LUA_PROFILE is set */
+typedef struct _wslua_profile_entry {
+    gchar   *name;
+    guint64  calls;
+    gdouble  seconds;
+} wslua_profile_entry;
+
+static GHashTable *lua_profile = NULL;
+static GTimer *lua_profile_timer = NULL;
+
+static gdouble wslua_profile_start(void) {
+    return lua_profile ? g_timer_elapsed(lua_profile_timer, NULL) : 0.0;
+}
+
+static void wslua_profile_stop(const gchar *name, gdouble started) {
+    wslua_profile_entry *entry;
+
+    if (!lua_profile)
+        return;
+
+    if (!name)
+        name = "(unknown)";
+
+    entry = (wslua_profile_entry *)g_hash_table_lookup(lua_profile, name);
+    if (!entry) {
+        entry = g_new0(wslua_profile_entry, 1);
+        entry->name = g_strdup(name);
+        g_hash_table_insert(lua_profile, entry->name, entry);
+    }
+    entry->calls++;
+    entry->seconds += g_timer_elapsed(lua_profile_timer, NULL) - started;
+}
+
+static void wslua_profile_entry_free(gpointer data) {
+    wslua_profile_entry *entry = (wslua_profile_entry *)data;
+
+    g_free(entry->name);
+    g_free(entry);
+}
+
+static gint wslua_profile_entry_cmp(gconstpointer a, gconstpointer b) {
+    const wslua_profile_entry *ea = (const wslua_profile_entry *)a;
+    const wslua_profile_entry *eb = (const wslua_profile_entry *)b;
+
+    if (ea->seconds > eb->seconds) return -1;
+    if (ea->seconds < eb->seconds) return 1;
+    return g_strcmp0(ea->name, eb->name);
+}
+
+static void wslua_profile_init(void) {
+    if (lua_profile || !g_getenv("WIRESHARK_LUA_PROFILE"))
+        return;
+
+    lua_profile = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, wslua_profile_entry_free);
+    lua_profile_timer = g_timer_new();
+}
+
+/* Print the time spent in each dissector (including any dissectors it
+ * called) to stderr and forget about it. */
+static void wslua_profile_report(void) {
+    GList *entries, *e;
+
+    if (!lua_profile)
+        return;
+
+    entries = g_list_sort(g_hash_table_get_values(lua_profile), wslua_profile_entry_cmp);
+    if (entries) {
+        fprintf(stderr, "Lua dissector profile:\n");
+        fprintf(stderr, "%-32s %12s %12s %12s\n", "Dissector", "Calls", "Seconds", "usec/call");
+        for (e = entries; e; e = g_list_next(e)) {
+            wslua_profile_entry *entry = (wslua_profile_entry *)e->data;
+            fprintf(stderr, "%-32s %12" G_GINT64_MODIFIER "u %12.6f %12.2f\n",
+                    entry->name, entry->calls, entry->seconds,
+                    entry->seconds * 1000000.0 / (gdouble)entry->calls);
+        }
+    }
+    g_list_free(entries);
+
+    g_hash_table_destroy(lua_profile);
+    lua_profile = NULL;
+    g_timer_destroy(lua_profile_timer);
+    lua_profile_timer = NULL;
+}
+
 static gboolean
 lua_pinfo_end(wmem_allocator_t *allocator _U_, wmem_cb_event_t event _U_,
         void *user_data _U_)
@@ -170,6 +255,9 @@ int dissect_lua(tvbuff_t* tvb, packet_info* pinfo, proto_tree* tree, void* data
     tvbuff_t *saved_lua_tvb = lua_tvb;
     packet_info *saved_lua_pinfo = lua_pinfo;
     struct _wslua_treeitem *saved_lua_tree = lua_tree;
+    const gchar *proto_name = pinfo->current_proto;
+    gdouble profile_start;
+    int error;
     lua_pinfo = pinfo;
     lua_tvb = tvb;
 
@@ -195,7 +283,11 @@ int dissect_lua(tvbuff_t* tvb, packet_info* pinfo, proto_tree* tree, void* data
         lua_tree = push_TreeItem(L, tree, proto_tree_add_item(tree, hf_wslua_fake, tvb, 0, 0, ENC_NA));
         PROTO_ITEM_SET_HIDDEN(lua_tree->item);
 
-        if  ( lua_pcall(L,3,1,0) ) {
+        profile_start = wslua_profile_start();
+        error = lua_pcall(L,3,1,0);
+        wslua_profile_stop(proto_name, profile_start);
+
+        if  ( error ) {
             proto_tree_add_expert_format(tree, pinfo, &ei_lua_error, tvb, 0, 0, "Lua Error: %s", lua_tostring(L,-1));
         } else {
 
@@ -234,6 +326,9 @@ gboolean heur_dissect_lua(tvbuff_t* tvb, packet_info* pinfo, proto_tree* tree, v
     tvbuff_t *saved_lua_tvb = lua_tvb;
     packet_info *saved_lua_pinfo = lua_pinfo;
     struct _wslua_treeitem *saved_lua_tree = lua_tree;
+    gchar proto_name[64];
+    gdouble profile_start;
+    int error;
     lua_tvb = tvb;
     lua_pinfo = pinfo;
 
@@ -289,12 +384,19 @@ gboolean heur_dissect_lua(tvbuff_t* tvb, packet_info* pinfo, proto_tree* tree, v
         return FALSE;
     }
 
+    if (lua_profile)
+        g_snprintf(proto_name, sizeof(proto_name), "%s (heuristic)", pinfo->current_proto);
+
     push_Tvb(L,tvb);
     push_Pinfo(L,pinfo);
     lua_tree = push_TreeItem(L, tree, proto_tree_add_item(tree, hf_wslua_fake, tvb, 0, 0, ENC_NA));
     PROTO_ITEM_SET_HIDDEN(lua_tree->item);
 
-    if  ( lua_pcall(L,3,1,0) ) {
+    profile_start = wslua_profile_start();
+    error = lua_pcall(L,3,1,0);
+    wslua_profile_stop(proto_name, profile_start);
+
+    if  ( error ) {
         proto_tree_add_expert_format(tree, pinfo, &ei_lua_error, tvb, 0, 0,
                 "Lua Error: error calling %s heuristic dissector: %s", pinfo->current_proto, lua_tostring(L,-1));
         lua_settop(L,0);
@@ -413,6 +515,107 @@ static const char *getF(lua_State *LS _U_, void *ud, size_t *size)
     return (*size>0) ? buff : NULL;
 }
 
+/*
+ * Compiled scripts are kept in the "luacache" directory of the personal
+ * configuration directory, so that they needn't be parsed again on the
+ * next start.  Each cache file starts with a header naming the script,
+ * its size and its modification time; if the script doesn't match
+ * those any more, or Lua doesn't take the bytecode (a different Lua
+ * version, say), the script itself is loaded and the cache rewritten.
+ */
+#define LUA_CACHE_DIR   "luacache"
+#define LUA_CACHE_MAGIC "WSLUAC01"
+
+typedef struct {
+    char    magic[8];
+    guint32 path_len;   /* followed by the script path, then the bytecode */
+    guint32 pad;
+    gint64  size;
+    gint64  mtime;
+} lua_cache_header_t;
+
+static gchar *lua_cache_path(const gchar *filename) {
+    gchar *dir = get_persconffile_path(LUA_CACHE_DIR, FALSE);
+    gchar *base = g_path_get_basename(filename);
+    gchar *path = g_strdup_printf("%s" G_DIR_SEPARATOR_S "%08x-%s.luac", dir, g_str_hash(filename), base);
+
+    g_free(base);
+    g_free(dir);
+    return path;
+}
+
+static void lua_cache_header_init(lua_cache_header_t *hdr, const gchar *filename, const ws_statb64 *st) {
+    memset(hdr, 0, sizeof *hdr);
+    memcpy(hdr->magic, LUA_CACHE_MAGIC, sizeof hdr->magic);
+    hdr->path_len = (guint32)strlen(filename);
+    hdr->size = (gint64)st->st_size;
+    hdr->mtime = (gint64)st->st_mtime;
+}
+
+/* Open the cache file of filename, positioned at the bytecode, if it's up to date */
+static FILE *lua_cache_open(const gchar *filename, const ws_statb64 *st) {
+    lua_cache_header_t expected, hdr;
+    gchar *path = lua_cache_path(filename);
+    gchar *cached_name;
+    FILE *cache = ws_fopen(path, "rb");
+    gboolean ok;
+
+    g_free(path);
+    if (!cache)
+        return NULL;
+
+    lua_cache_header_init(&expected, filename, st);
+    ok = fread(&hdr, sizeof hdr, 1, cache) == 1 &&
+         memcmp(&hdr, &expected, sizeof hdr) == 0;
+    if (ok) {
+        cached_name = (gchar *)g_malloc(hdr.path_len);
+        ok = fread(cached_name, 1, hdr.path_len, cache) == hdr.path_len &&
+             memcmp(cached_name, filename, hdr.path_len) == 0;
+        g_free(cached_name);
+    }
+    if (!ok) {
+        fclose(cache);
+        return NULL;
+    }
+    return cache;
+}
+
+static int lua_cache_writer(lua_State *LS _U_, const void *p, size_t sz, void *ud) {
+    return fwrite(p, 1, sz, (FILE *)ud) == sz ? 0 : 1;
+}
+
+/* Write the function at the top of the stack, compiled from filename, to its cache file */
+static void lua_cache_store(const gchar *filename, const ws_statb64 *st) {
+    lua_cache_header_t hdr;
+    gchar *dir = get_persconffile_path(LUA_CACHE_DIR, FALSE);
+    gchar *path = lua_cache_path(filename);
+    gchar *tmp_path = g_strdup_printf("%s.tmp", path);
+    FILE *cache;
+    gboolean ok;
+
+    ws_mkdir(dir, 0755);
+    g_free(dir);
+
+    if ((cache = ws_fopen(tmp_path, "wb")) != NULL) {
+        lua_cache_header_init(&hdr, filename, st);
+        ok = fwrite(&hdr, sizeof hdr, 1, cache) == 1 &&
+             fwrite(filename, 1, hdr.path_len, cache) == hdr.path_len &&
+#if LUA_VERSION_NUM >= 503
+             lua_dump(L, lua_cache_writer, cache, 0) == 0;
+#else
+             lua_dump(L, lua_cache_writer, cache) == 0;
+#endif
+        if (fclose(cache) == 0 && ok) {
+            ws_unlink(path);
+            ok = ws_rename(tmp_path, path) == 0;
+        }
+        if (!ok)
+            ws_unlink(tmp_path);
+    }
+    g_free(tmp_path);
+    g_free(path);
+}
+
 static int lua_main_error_handler(lua_State* LS) {
     const gchar* error =  lua_tostring(LS,1);
     report_failure("Lua: Error during loading:\n %s",error);
@@ -524,7 +727,10 @@ static void set_file_environment(const gchar* filename, const gchar* dirname) {
  */
 static gboolean lua_load_script(const gchar* filename, const gchar* dirname, const int file_count) {
     FILE* file;
-    int error;
+    FILE* cache = NULL;
+    ws_statb64 st;
+    gboolean use_cache;
+    int error = -1;
     int numargs = 0;
 
     if (! ( file = ws_fopen(filename,"r")) ) {
@@ -536,11 +742,28 @@ static gboolean lua_load_script(const gchar* filename, const gchar* dirname, con
 
     lua_pushcfunction(L,lua_main_error_handler);
 
+    /* Root shouldn't run bytecode from a file it may not have written */
+    use_cache = !started_with_special_privs() && ws_stat64(filename, &st) == 0;
+    if (use_cache && (cache = lua_cache_open(filename, &st)) != NULL) {
 #if LUA_VERSION_NUM >= 502
-    error = lua_load(L,getF,file,filename,NULL);
+        error = lua_load(L,getF,cache,filename,"b");
 #else
-    error = lua_load(L,getF,file,filename);
+        error = lua_load(L,getF,cache,filename);
 #endif
+        fclose(cache);
+        if (error)
+            lua_pop(L,1); /* pop the error message; load the script itself */
+    }
+
+    if (error) {
+#if LUA_VERSION_NUM >= 502
+        error = lua_load(L,getF,file,filename,NULL);
+#else
+        error = lua_load(L,getF,file,filename);
+#endif
+        if (error == 0 && use_cache)
+            lua_cache_store(filename, &st);
+    }
 
     switch (error) {
         case 0: /* LUA_OK */
@@ -959,6 +1182,9 @@ void wslua_init(register_cb cb, gpointer client_data) {
     }
     lua_pop(L,1);  /* pop the getglobal result */
 
+    /* time each Lua dissector if asked to */
+    wslua_profile_init();
+
     /* load global scripts */
     lua_load_global_plugins(cb, client_data, FALSE);
 
@@ -1050,6 +1276,8 @@ void wslua_reload_plugins (register_cb cb, gpointer client_data) {
 }
 
 void wslua_cleanup(void) {
+    wslua_profile_report();
+
     /* cleanup lua */
     if (L) {
         lua_close(L);
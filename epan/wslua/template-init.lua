@@ -148,6 +148,82 @@ USER_DIR = Dir.personal_config_path()
 datafile_path = Dir.global_config_path
 persconffile_path = Dir.personal_config_path
 
+-- When running under LuaJIT, tvb_view(tvbrange) returns a bounds-checked
+-- view of the bytes of a TvbRange that reads them through the FFI instead
+-- of calling into Wireshark, e.g.:
+--     local v = tvb_view(tvb(0, 8))
+--     local len, id = v:uint16(0), v:uint32(2)
+-- Offsets are relative to the start of the range, and the view is only
+-- valid while the dissector that got the Tvb is running.
+-- since 2.5.0
+if type(jit) == "table" then
+    local ok, ffi = pcall(require, "ffi")
+    if ok then
+        local u8ptr = ffi.typeof("const uint8_t *")
+        local view = {}
+        view.__index = view
+
+        local function check(v, offset, size)
+            if offset < 0 or offset + size > v.len then
+                error("offset out of bounds", 3)
+            end
+        end
+
+        function view:uint8(offset)
+            check(self, offset, 1)
+            return self.ptr[offset]
+        end
+
+        function view:uint16(offset)
+            check(self, offset, 2)
+            local p = self.ptr + offset
+            return p[0] * 0x100 + p[1]
+        end
+
+        function view:le_uint16(offset)
+            check(self, offset, 2)
+            local p = self.ptr + offset
+            return p[1] * 0x100 + p[0]
+        end
+
+        function view:uint24(offset)
+            check(self, offset, 3)
+            local p = self.ptr + offset
+            return p[0] * 0x10000 + p[1] * 0x100 + p[2]
+        end
+
+        function view:le_uint24(offset)
+            check(self, offset, 3)
+            local p = self.ptr + offset
+            return p[2] * 0x10000 + p[1] * 0x100 + p[0]
+        end
+
+        function view:uint32(offset)
+            check(self, offset, 4)
+            local p = self.ptr + offset
+            return p[0] * 0x1000000 + p[1] * 0x10000 + p[2] * 0x100 + p[3]
+        end
+
+        function view:le_uint32(offset)
+            check(self, offset, 4)
+            local p = self.ptr + offset
+            return p[3] * 0x1000000 + p[2] * 0x10000 + p[1] * 0x100 + p[0]
+        end
+
+        function view:raw(offset, length)
+            offset = offset or 0
+            length = length or self.len - offset
+            check(self, offset, length)
+            return ffi.string(self.ptr + offset, length)
+        end
+
+        function tvb_view(tvbrange)
+            local ptr, len = tvbrange:pointer()
+            return setmetatable({ ptr = ffi.cast(u8ptr, ptr), len = len }, view)
+        end
+    end
+end
+
 
 dofile(DATA_DIR.."console.lua")
 --dofile(DATA_DIR.."dtd_gen.lua")
@@ -679,6 +679,19 @@ extern int wslua_reg_attributes(lua_State *L, const wslua_attribute_table *t, gb
     } \
 }
 
+/* Same as CLEAR_OUTSTANDING, for classes whose objects are allocated with g_slice_new() */
+#define CLEAR_OUTSTANDING_SLICE(C, marker, marker_val) void clear_outstanding_##C(void) { \
+    while (outstanding_##C->len) { \
+        C p = (C)g_ptr_array_remove_index_fast(outstanding_##C,0); \
+        if (p) { \
+            if (p->marker != marker_val) \
+                p->marker = marker_val; \
+            else \
+                g_slice_free1(sizeof(*p), p); \
+        } \
+    } \
+}
+
 #define WSLUA_CLASS_DECLARE(C) \
 extern C to##C(lua_State* L, int idx); \
 extern C check##C(lua_State* L, int idx); \
@@ -351,7 +351,7 @@ WSLUA_METHOD ByteArray_tvb (lua_State *L) {
 
     data = (guint8 *)g_memdup(ba->data, ba->len);
 
-    tvb = (Tvb)g_malloc(sizeof(struct _wslua_tvb));
+    tvb = g_slice_new(struct _wslua_tvb);
     tvb->ws_tvb = tvb_new_child_real_data(lua_tvb, data, ba->len,ba->len);
     tvb->expired = FALSE;
     tvb->need_free = FALSE;
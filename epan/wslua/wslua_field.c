@@ -46,14 +46,14 @@ WSLUA_CLASS_DEFINE(FieldInfo,FAIL_ON_NULL_OR_EXPIRED("FieldInfo"));
 static GPtrArray* outstanding_FieldInfo = NULL;
 
 FieldInfo* push_FieldInfo(lua_State* L, field_info* f) {
-    FieldInfo fi = (FieldInfo) g_malloc(sizeof(struct _wslua_field_info));
+    FieldInfo fi = g_slice_new(struct _wslua_field_info);
     fi->ws_fi = f;
     fi->expired = FALSE;
     g_ptr_array_add(outstanding_FieldInfo,fi);
     return pushFieldInfo(L,fi);
 }
 
-CLEAR_OUTSTANDING(FieldInfo,expired,TRUE)
+CLEAR_OUTSTANDING_SLICE(FieldInfo,expired,TRUE)
 
 /* WSLUA_ATTRIBUTE FieldInfo_len RO The length of this field. */
 WSLUA_METAMETHOD FieldInfo__len(lua_State* L) {
@@ -77,91 +77,77 @@ WSLUA_METAMETHOD FieldInfo__unm(lua_State* L) {
     return 1;
 }
 
-/* WSLUA_ATTRIBUTE FieldInfo_value RO The value of this field. */
-WSLUA_METAMETHOD FieldInfo__call(lua_State* L) {
-    /*
-       Obtain the Value of the field.
-
-       Previous to 1.11.4, this function retrieved the value for most field types,
-       but for `ftypes.UINT_BYTES` it retrieved the `ByteArray` of the field's entire `TvbRange`.
-       In other words, it returned a `ByteArray` that included the leading length byte(s),
-       instead of just the *value* bytes. That was a bug, and has been changed in 1.11.4.
-       Furthermore, it retrieved an `ftypes.GUID` as a `ByteArray`, which is also incorrect.
-
-       If you wish to still get a `ByteArray` of the `TvbRange`, use `FieldInfo:get_range()`
-       to get the `TvbRange`, and then use `Tvb:bytes()` to convert it to a `ByteArray`.
-       */
-    FieldInfo fi = checkFieldInfo(L,1);
-
-    switch(fi->ws_fi->hfinfo->type) {
+/* Pushes the value of a field onto the stack, returning how many values were pushed. */
+static int push_FieldInfo_value(lua_State* L, field_info* f) {
+    switch(f->hfinfo->type) {
         case FT_BOOLEAN:
-                lua_pushboolean(L,(int)fvalue_get_uinteger64(&(fi->ws_fi->value)));
+                lua_pushboolean(L,(int)fvalue_get_uinteger64(&(f->value)));
                 return 1;
         case FT_UINT8:
         case FT_UINT16:
         case FT_UINT24:
         case FT_UINT32:
         case FT_FRAMENUM:
-                lua_pushnumber(L,(lua_Number)(fvalue_get_uinteger(&(fi->ws_fi->value))));
+                lua_pushnumber(L,(lua_Number)(fvalue_get_uinteger(&(f->value))));
                 return 1;
         case FT_INT8:
         case FT_INT16:
         case FT_INT24:
         case FT_INT32:
-                lua_pushnumber(L,(lua_Number)(fvalue_get_sinteger(&(fi->ws_fi->value))));
+                lua_pushnumber(L,(lua_Number)(fvalue_get_sinteger(&(f->value))));
                 return 1;
         case FT_FLOAT:
         case FT_DOUBLE:
-                lua_pushnumber(L,(lua_Number)(fvalue_get_floating(&(fi->ws_fi->value))));
+                lua_pushnumber(L,(lua_Number)(fvalue_get_floating(&(f->value))));
                 return 1;
         case FT_INT64: {
-                pushInt64(L,(Int64)(fvalue_get_sinteger64(&(fi->ws_fi->value))));
+                pushInt64(L,(Int64)(fvalue_get_sinteger64(&(f->value))));
                 return 1;
             }
         case FT_UINT64: {
-                pushUInt64(L,fvalue_get_uinteger64(&(fi->ws_fi->value)));
+                pushUInt64(L,fvalue_get_uinteger64(&(f->value)));
                 return 1;
             }
         case FT_ETHER: {
                 Address eth = (Address)g_malloc(sizeof(address));
-                alloc_address_tvb(NULL,eth,AT_ETHER,fi->ws_fi->length,fi->ws_fi->ds_tvb,fi->ws_fi->start);
+                alloc_address_tvb(NULL,eth,AT_ETHER,f->length,f->ds_tvb,f->start);
                 pushAddress(L,eth);
                 return 1;
             }
         case FT_IPv4:{
                 Address ipv4 = (Address)g_malloc(sizeof(address));
-                alloc_address_tvb(NULL,ipv4,AT_IPv4,fi->ws_fi->length,fi->ws_fi->ds_tvb,fi->ws_fi->start);
+                alloc_address_tvb(NULL,ipv4,AT_IPv4,f->length,f->ds_tvb,f->start);
                 pushAddress(L,ipv4);
                 return 1;
             }
         case FT_IPv6: {
                 Address ipv6 = (Address)g_malloc(sizeof(address));
-                alloc_address_tvb(NULL,ipv6,AT_IPv6,fi->ws_fi->length,fi->ws_fi->ds_tvb,fi->ws_fi->start);
+                alloc_address_tvb(NULL,ipv6,AT_IPv6,f->length,f->ds_tvb,f->start);
                 pushAddress(L,ipv6);
                 return 1;
             }
         case FT_FCWWN: {
                 Address fcwwn = (Address)g_malloc(sizeof(address));
-                alloc_address_tvb(NULL,fcwwn,AT_FCWWN,fi->ws_fi->length,fi->ws_fi->ds_tvb,fi->ws_fi->start);
+                alloc_address_tvb(NULL,fcwwn,AT_FCWWN,f->length,f->ds_tvb,f->start);
                 pushAddress(L,fcwwn);
                 return 1;
             }
         case FT_IPXNET:{
                 Address ipx = (Address)g_malloc(sizeof(address));
-                alloc_address_tvb(NULL,ipx,AT_IPX,fi->ws_fi->length,fi->ws_fi->ds_tvb,fi->ws_fi->start);
+                alloc_address_tvb(NULL,ipx,AT_IPX,f->length,f->ds_tvb,f->start);
                 pushAddress(L,ipx);
                 return 1;
             }
         case FT_ABSOLUTE_TIME:
         case FT_RELATIVE_TIME: {
                 NSTime nstime = (NSTime)g_malloc(sizeof(nstime_t));
-                *nstime = *(NSTime)fvalue_get(&(fi->ws_fi->value));
+                *nstime = *(NSTime)fvalue_get(&(f->value));
                 pushNSTime(L,nstime);
                 return 1;
             }
         case FT_STRING:
         case FT_STRINGZ: {
-                gchar* repr = fvalue_to_string_repr(NULL, &fi->ws_fi->value,FTREPR_DISPLAY,BASE_NONE);
+                gchar* repr = fvalue_to_string_repr(NULL, &f->value,FTREPR_DISPLAY,BASE_NONE);
                 if (repr)
                 {
                     lua_pushstring(L, repr);
@@ -174,10 +160,10 @@ WSLUA_METAMETHOD FieldInfo__call(lua_State* L) {
                 return 1;
             }
         case FT_NONE:
-                if (fi->ws_fi->length > 0 && fi->ws_fi->rep) {
+                if (f->length > 0 && f->rep) {
                     /* it has a length, but calling fvalue_get() on an FT_NONE asserts,
                        so get the label instead (it's a FT_NONE, so a label is what it basically is) */
-                    lua_pushstring(L, fi->ws_fi->rep->representation);
+                    lua_pushstring(L, f->rep->representation);
                     return 1;
                 }
                 return 0;
@@ -188,15 +174,15 @@ WSLUA_METAMETHOD FieldInfo__call(lua_State* L) {
         case FT_OID:
             {
                 ByteArray ba = g_byte_array_new();
-                g_byte_array_append(ba, (const guint8 *) fvalue_get(&fi->ws_fi->value),
-                                    fvalue_length(&fi->ws_fi->value));
+                g_byte_array_append(ba, (const guint8 *) fvalue_get(&f->value),
+                                    fvalue_length(&f->value));
                 pushByteArray(L,ba);
                 return 1;
             }
         case FT_PROTOCOL:
             {
                 ByteArray ba = g_byte_array_new();
-                tvbuff_t* tvb = (tvbuff_t *) fvalue_get(&fi->ws_fi->value);
+                tvbuff_t* tvb = (tvbuff_t *) fvalue_get(&f->value);
                 g_byte_array_append(ba, (const guint8 *)tvb_memdup(wmem_packet_scope(), tvb, 0,
                                             tvb_captured_length(tvb)), tvb_captured_length(tvb));
                 pushByteArray(L,ba);
@@ -210,6 +196,25 @@ WSLUA_METAMETHOD FieldInfo__call(lua_State* L) {
     }
 }
 
+/* WSLUA_ATTRIBUTE FieldInfo_value RO The value of this field. */
+WSLUA_METAMETHOD FieldInfo__call(lua_State* L) {
+    /*
+       Obtain the Value of the field.
+
+       Previous to 1.11.4, this function retrieved the value for most field types,
+       but for `ftypes.UINT_BYTES` it retrieved the `ByteArray` of the field's entire `TvbRange`.
+       In other words, it returned a `ByteArray` that included the leading length byte(s),
+       instead of just the *value* bytes. That was a bug, and has been changed in 1.11.4.
+       Furthermore, it retrieved an `ftypes.GUID` as a `ByteArray`, which is also incorrect.
+
+       If you wish to still get a `ByteArray` of the `TvbRange`, use `FieldInfo:get_range()`
+       to get the `TvbRange`, and then use `Tvb:bytes()` to convert it to a `ByteArray`.
+       */
+    FieldInfo fi = checkFieldInfo(L,1);
+
+    return push_FieldInfo_value(L, fi->ws_fi);
+}
+
 /* WSLUA_ATTRIBUTE FieldInfo_label RO The string representing this field. */
 WSLUA_METAMETHOD FieldInfo__tostring(lua_State* L) {
     /* The string representation of the field. */
@@ -444,7 +449,7 @@ static int FieldInfo__gc(lua_State* L) {
         fi->expired = TRUE;
     else
         /* do NOT free fi->ws_fi */
-        g_free(fi);
+        g_slice_free(struct _wslua_field_info, fi);
 
     return 0;
 }
@@ -765,6 +770,46 @@ WSLUA_METAMETHOD Field__call (lua_State* L) {
     WSLUA_RETURN(items_found); /* All the values of this field */
 }
 
+WSLUA_METHOD Field_values(lua_State* L) {
+    /* Obtain the values of every occurrence of this field in the current packet as an array
+       table, in the order `Field()` would return them. Unlike `Field()` this doesn't create a
+       `FieldInfo` for each occurrence, so it's the cheaper choice when only the values are needed.
+       Occurrences without a value (e.g. an `ftypes.NONE` field with no label) are left out.
+
+       @since 2.5.0
+     */
+    Field f = checkField(L,1);
+    header_field_info* in = *f;
+    int n = 0;
+
+    if (! in) {
+        luaL_error(L,"invalid field");
+        return 0;
+    }
+
+    if (! lua_pinfo ) {
+        WSLUA_ERROR(Field_values,"Fields cannot be used outside dissectors or taps");
+        return 0;
+    }
+
+    lua_newtable(L);
+
+    while (in) {
+        GPtrArray* found = proto_get_finfo_ptr_array(lua_tree->tree, in->id);
+        guint i;
+        if (found) {
+            for (i=0; i<found->len; i++) {
+                if (push_FieldInfo_value(L, (field_info *) g_ptr_array_index(found,i)) > 0) {
+                    lua_rawseti(L, -2, ++n);
+                }
+            }
+        }
+        in = (in->same_name_prev_id != -1) ? proto_registrar_get_nth(in->same_name_prev_id) : NULL;
+    }
+
+    WSLUA_RETURN(1); /* The array table of values */
+}
+
 WSLUA_METAMETHOD Field__tostring(lua_State* L) {
     /* Obtain a string with the field filter name. */
     Field f = checkField(L,1);
@@ -793,6 +838,7 @@ WSLUA_ATTRIBUTES Field_attributes[] = {
 WSLUA_METHODS Field_methods[] = {
     WSLUA_CLASS_FNREG(Field,new),
     WSLUA_CLASS_FNREG(Field,list),
+    WSLUA_CLASS_FNREG(Field,values),
     { NULL, NULL }
 };
 
@@ -40,7 +40,7 @@ static GPtrArray* outstanding_TreeItem = NULL;
 
 /* pushing a TreeItem with a NULL item or subtree is completely valid for this function */
 TreeItem push_TreeItem(lua_State *L, proto_tree *tree, proto_item *item) {
-    TreeItem ti = (struct _wslua_treeitem *)g_malloc(sizeof(struct _wslua_treeitem));
+    TreeItem ti = g_slice_new(struct _wslua_treeitem);
 
     ti->tree = tree;
     ti->item = item;
@@ -54,7 +54,7 @@ TreeItem push_TreeItem(lua_State *L, proto_tree *tree, proto_item *item) {
 /* creates the TreeItem but does NOT push it into Lua */
 TreeItem create_TreeItem(proto_tree* tree, proto_item* item)
 {
-    TreeItem tree_item = (TreeItem)g_malloc(sizeof(struct _wslua_treeitem));
+    TreeItem tree_item = g_slice_new(struct _wslua_treeitem);
     tree_item->tree = tree;
     tree_item->item = item;
     tree_item->expired = FALSE;
@@ -62,7 +62,7 @@ TreeItem create_TreeItem(proto_tree* tree, proto_item* item)
     return tree_item;
 }
 
-CLEAR_OUTSTANDING(TreeItem, expired, TRUE)
+CLEAR_OUTSTANDING_SLICE(TreeItem, expired, TRUE)
 
 WSLUA_CLASS_DEFINE(TreeItem,FAIL_ON_NULL_OR_EXPIRED("TreeItem"));
 /* ++TreeItem++s represent information in the packet-details pane of
@@ -926,7 +926,7 @@ static int TreeItem__gc(lua_State* L) {
     if (!ti->expired)
         ti->expired = TRUE;
     else
-        g_free(ti);
+        g_slice_free(struct _wslua_treeitem, ti);
     return 0;
 }
 
@@ -92,7 +92,7 @@ static void free_Tvb(Tvb tvb) {
     } else {
         if (tvb->need_free)
             tvb_free(tvb->ws_tvb);
-        g_free(tvb);
+        g_slice_free(struct _wslua_tvb, tvb);
     }
 }
 
@@ -105,7 +105,7 @@ void clear_outstanding_Tvb(void) {
 
 /* this is used to push Tvbs that just point to pre-existing C-code Tvbs */
 Tvb* push_Tvb(lua_State* L, tvbuff_t* ws_tvb) {
-    Tvb tvb = (Tvb)g_malloc(sizeof(struct _wslua_tvb));
+    Tvb tvb = g_slice_new(struct _wslua_tvb);
     tvb->ws_tvb = ws_tvb;
     tvb->expired = FALSE;
     tvb->need_free = FALSE;
@@ -346,7 +346,7 @@ static void free_TvbRange(TvbRange tvbr) {
         tvbr->tvb->expired = TRUE;
     } else {
         free_Tvb(tvbr->tvb);
-        g_free(tvbr);
+        g_slice_free(struct _wslua_tvbrange, tvbr);
     }
 }
 
@@ -377,8 +377,8 @@ gboolean push_TvbRange(lua_State* L, tvbuff_t* ws_tvb, int offset, int len) {
         return FALSE;
     }
 
-    tvbr = (TvbRange)g_malloc(sizeof(struct _wslua_tvbrange));
-    tvbr->tvb = (Tvb)g_malloc(sizeof(struct _wslua_tvb));
+    tvbr = g_slice_new(struct _wslua_tvbrange);
+    tvbr->tvb = g_slice_new(struct _wslua_tvb);
     tvbr->tvb->ws_tvb = ws_tvb;
     tvbr->tvb->expired = FALSE;
     tvbr->tvb->need_free = FALSE;
@@ -404,7 +404,7 @@ WSLUA_METHOD TvbRange_tvb(lua_State *L) {
     }
 
     if (tvb_offset_exists(tvbr->tvb->ws_tvb,  tvbr->offset + tvbr->len -1 )) {
-        tvb = (Tvb)g_malloc(sizeof(struct _wslua_tvb));
+        tvb = g_slice_new(struct _wslua_tvb);
         tvb->expired = FALSE;
         tvb->need_free = FALSE;
         tvb->ws_tvb = tvb_new_subset_length_caplen(tvbr->tvb->ws_tvb,tvbr->offset,tvbr->len, tvbr->len);
@@ -1359,6 +1359,38 @@ WSLUA_METHOD TvbRange_raw(lua_State* L) {
     WSLUA_RETURN(1); /* A Lua string of the binary bytes in the `TvbRange`. */
 }
 
+WSLUA_METHOD TvbRange_pointer(lua_State* L) {
+    /* Obtain a light userdata pointing at the bytes of a `TvbRange`, and its length.
+
+       This is meant for the LuaJIT FFI, which can cast the pointer to read the bytes directly;
+       `tvb_view()` (defined in init.lua when running under LuaJIT) wraps it in a bounds-checked
+       byte view. The pointer is only valid while the dissector or listener that got the `Tvb`
+       is running, just like the `Tvb` itself.
+
+       @since 2.5.0
+     */
+    TvbRange tvbr = checkTvbRange(L,1);
+
+    if (!tvbr || !tvbr->tvb) return 0;
+    if (tvbr->tvb->expired) {
+        luaL_error(L,"expired tvb");
+        return 0;
+    }
+
+    /* tvb_get_ptr() would throw for a zero-length range at the very end of the Tvb */
+    if (tvbr->len == 0) {
+        lua_pushnil(L);
+    } else {
+        /* Lua has no const light userdata; the FFI side casts it back to const */
+DIAG_OFF(cast-qual)
+        lua_pushlightuserdata(L, (void *)tvb_get_ptr(tvbr->tvb->ws_tvb, tvbr->offset, tvbr->len));
+DIAG_ON(cast-qual)
+    }
+    lua_pushinteger(L, tvbr->len);
+
+    WSLUA_RETURN(2); /* The pointer (nil if the range is empty) and the length of the `TvbRange`. */
+}
+
 WSLUA_METAMETHOD TvbRange__eq(lua_State* L) {
     /* Checks whether the two `TvbRange` contents are equal.
 
@@ -1443,6 +1475,7 @@ WSLUA_METHODS TvbRange_methods[] = {
     WSLUA_CLASS_FNREG(TvbRange,ustringz),
     WSLUA_CLASS_FNREG(TvbRange,uncompress),
     WSLUA_CLASS_FNREG(TvbRange,raw),
+    WSLUA_CLASS_FNREG(TvbRange,pointer),
     { NULL, NULL }
 };
 
@@ -49,6 +49,8 @@
 #include <epan/epan_dissect.h>
 #include <epan/tap.h>
 #include <epan/dissectors/packet-ber.h>
+#include <epan/dissectors/packet-frame.h>
+#include <epan/protocol_index.h>
 #include <epan/timestamp.h>
 #include <epan/dfilter/dfilter-macro.h>
 #include <epan/strutil.h>
@@ -64,6 +66,7 @@
 #include "ui/simple_dialog.h"
 #include "ui/main_statusbar.h"
 #include "ui/progress_dlg.h"
+#include "ui/proto_hier_stats.h"
 #include "ui/ws_ui_util.h"
 
 /* Needed for addrinfo */
@@ -96,7 +99,7 @@ gboolean auto_scroll_live; /* GTK+ only? */
 #endif
 
 static int read_packet(capture_file *cf, dfilter_t *dfcode, epan_dissect_t *edt,
-    column_info *cinfo, gint64 offset);
+    column_info *cinfo, struct wtap_pkthdr *phdr, const guint8 *buf, gint64 offset);
 
 static void rescan_packets(capture_file *cf, const char *action, const char *action_item, gboolean redissect);
 
@@ -107,7 +110,7 @@ typedef enum {
 } match_result;
 static match_result match_protocol_tree(capture_file *cf, frame_data *fdata,
     void *criterion);
-static void match_subtree_text(proto_node *node, gpointer data);
+static gboolean match_subtree_text(proto_node *node, match_data *mdata);
 static match_result match_summary_line(capture_file *cf, frame_data *fdata,
     void *criterion);
 static match_result match_narrow_and_wide(capture_file *cf, frame_data *fdata,
@@ -134,6 +137,9 @@ static const char *cf_get_user_packet_comment(capture_file *cf, const frame_data
 
 static void cf_rename_failure_alert_box(const char *filename, int err);
 static void ref_time_packets(capture_file *cf);
+static void ref_time_packets_from(capture_file *cf, frame_data *first);
+static void edt_cache_flush(capture_file *cf);
+static void edt_cache_free(capture_file *cf);
 
 /* Seconds spent processing packets between pushing UI updates. */
 #define PROGBAR_UPDATE_INTERVAL 0.150
@@ -141,6 +147,13 @@ static void ref_time_packets(capture_file *cf);
 /* Show the progress bar after this many seconds. */
 #define PROGBAR_SHOW_DELAY 0.5
 
+/*
+ * Seconds cf_continue_tail() may spend processing packets before it
+ * defers the rest to a later call, so that a live capture that comes in
+ * faster than we can dissect it doesn't lock up the UI.
+ */
+#define TAIL_TIME_BUDGET 0.150
+
 /*
  * We could probably use g_signal_...() instead of the callbacks below but that
  * would require linking our CLI programs to libgobject and creating an object
@@ -263,6 +276,17 @@ ws_get_frame_ts(void *data, guint32 frame_num)
   return NULL;
 }
 
+static const nstime_t *
+ws_get_frame_shift_offset(void *data, guint32 frame_num)
+{
+  capture_file *cf = (capture_file *) data;
+
+  if (cf->frames)
+    return frame_data_sequence_get_shift_offset(cf->frames, frame_num);
+
+  return NULL;
+}
+
 static const char *
 ws_get_user_comment(void *data, const frame_data *fd)
 {
@@ -271,6 +295,98 @@ ws_get_user_comment(void *data, const frame_data *fd)
   return cf_get_user_packet_comment(cf, fd);
 }
 
+#if GLIB_CHECK_VERSION(2,36,0)
+/*
+ * Read-ahead for the first pass over a file.
+ *
+ * Dissection has to happen on the main thread and in frame order, as the
+ * dissectors keep per-capture state (conversations, reassembly, TCP
+ * analysis) that depends on it.  Reading and decoding the records
+ * (decompression, block parsing, byte swapping) doesn't, so a reader
+ * thread does that into a fixed set of record slots.  Filled slots are
+ * handed to the main thread, in file order, through one queue and handed
+ * back through another, which bounds the amount of memory used.
+ *
+ * While the reader thread is running it holds wth_mtx around its calls
+ * into libwiretap; anything on the main thread that looks at the
+ * wiretap state (interface descriptions) must hold it as well.  Name
+ * resolution records are collected by the reader and applied by the
+ * main thread just before the record that followed them is dissected,
+ * so that name resolution happens in the same order as it would if we
+ * read the file on the main thread.
+ */
+#define READ_AHEAD_SLOTS 256
+
+typedef struct {
+  gboolean  is_ipv6;
+  guint     ipv4_addr;
+  guint8    ipv6_addr[16];
+  gchar    *name;
+} read_ahead_name_t;
+
+typedef struct {
+  struct wtap_pkthdr  phdr;
+  Buffer              buf;
+  gint64              data_offset;
+  gint64              file_pos;
+  GSList             *names;      /* read_ahead_name_t, in file order */
+  gboolean            done;       /* no more records; err says why */
+  int                 err;
+  gchar              *err_info;
+} read_ahead_slot_t;
+
+typedef struct {
+  wtap               *wth;
+  GThread            *thread;
+  GAsyncQueue        *filled_q;
+  GAsyncQueue        *free_q;
+  GMutex              wth_mtx;
+  volatile gint       stop;
+  GSList             *pending_names;  /* reader thread only */
+  read_ahead_slot_t  *cur;            /* main thread only */
+  gboolean            done;           /* main thread only */
+  read_ahead_slot_t   slots[READ_AHEAD_SLOTS];
+} read_ahead_t;
+
+/* The read-ahead of the file being read, if any. */
+static read_ahead_t *cur_read_ahead;
+
+/*
+ * The interface descriptions can change while the read-ahead thread is
+ * reading the file, so look them up with the wiretap state locked.
+ */
+static const char *
+ws_get_interface_name(void *data, guint32 interface_id)
+{
+  const char *name;
+
+  if (cur_read_ahead == NULL)
+    return cap_file_get_interface_name(data, interface_id);
+
+  g_mutex_lock(&cur_read_ahead->wth_mtx);
+  name = cap_file_get_interface_name(data, interface_id);
+  g_mutex_unlock(&cur_read_ahead->wth_mtx);
+  return name;
+}
+
+static const char *
+ws_get_interface_description(void *data, guint32 interface_id)
+{
+  const char *description;
+
+  if (cur_read_ahead == NULL)
+    return cap_file_get_interface_description(data, interface_id);
+
+  g_mutex_lock(&cur_read_ahead->wth_mtx);
+  description = cap_file_get_interface_description(data, interface_id);
+  g_mutex_unlock(&cur_read_ahead->wth_mtx);
+  return description;
+}
+#else
+#define ws_get_interface_name         cap_file_get_interface_name
+#define ws_get_interface_description  cap_file_get_interface_description
+#endif
+
 static epan_t *
 ws_epan_new(capture_file *cf)
 {
@@ -278,25 +394,22 @@ ws_epan_new(capture_file *cf)
 
   epan->data = cf;
   epan->get_frame_ts = ws_get_frame_ts;
-  epan->get_interface_name = cap_file_get_interface_name;
-  epan->get_interface_description = cap_file_get_interface_description;
+  epan->get_frame_shift_offset = ws_get_frame_shift_offset;
+  epan->get_interface_name = ws_get_interface_name;
+  epan->get_interface_description = ws_get_interface_description;
   epan->get_user_comment = ws_get_user_comment;
 
   return epan;
 }
 
-cf_status_t
-cf_open(capture_file *cf, const char *fname, unsigned int type, gboolean is_tempfile, int *err)
+/*
+ * Close whatever capture file we had open, and fill in the information
+ * for the newly-opened wth.
+ */
+static void
+cf_open_wth(capture_file *cf, wtap *wth, const char *fname, unsigned int type,
+            gboolean is_tempfile)
 {
-  wtap  *wth;
-  gchar *err_info;
-
-  wth = wtap_open_offline(fname, type, err, &err_info, TRUE);
-  if (wth == NULL)
-    goto fail;
-
-  /* The open succeeded.  Close whatever capture file we had open,
-     and fill in the information for this file. */
   cf_close(cf);
 
   /* Initialize the packet header. */
@@ -339,6 +452,10 @@ cf_open(capture_file *cf, const char *fname, unsigned int type, gboolean is_temp
   cf->marked_count = 0;
   cf->ignored_count = 0;
   cf->ref_time_count = 0;
+  memset(&cf->all_totals, 0, sizeof cf->all_totals);
+  memset(&cf->filtered_totals, 0, sizeof cf->filtered_totals);
+  memset(&cf->marked_totals, 0, sizeof cf->marked_totals);
+  cf->marked_times_stale = FALSE;
   cf->drops_known = FALSE;
   cf->drops     = 0;
   cf->snap      = wtap_snapshot_length(cf->wth);
@@ -346,6 +463,13 @@ cf_open(capture_file *cf, const char *fname, unsigned int type, gboolean is_temp
   /* Allocate a frame_data_sequence for the frames in this file */
   cf->frames = new_frame_data_sequence();
 
+  /* Count the protocol hierarchy as the frames are read in. */
+  cf->ph_stats = ph_stats_new_empty();
+
+  /* Note which protocols each frame has, to rule frames out when
+     filtering. */
+  cf->protocol_index = protocol_index_new();
+
   nstime_set_zero(&cf->elapsed_time);
   cf->ref = NULL;
   cf->prev_dis = NULL;
@@ -362,7 +486,21 @@ cf_open(capture_file *cf, const char *fname, unsigned int type, gboolean is_temp
 
   wtap_set_cb_new_ipv4(cf->wth, add_ipv4_name);
   wtap_set_cb_new_ipv6(cf->wth, (wtap_new_ipv6_callback_t) add_ipv6_name);
+}
+
+cf_status_t
+cf_open(capture_file *cf, const char *fname, unsigned int type, gboolean is_tempfile, int *err)
+{
+  wtap  *wth;
+  gchar *err_info;
 
+  wth = wtap_open_offline(fname, type, err, &err_info, TRUE);
+  if (wth == NULL)
+    goto fail;
+
+  /* The open succeeded.  Close whatever capture file we had open,
+     and fill in the information for this file. */
+  cf_open_wth(cf, wth, fname, type, is_tempfile);
   return CF_OK;
 
 fail:
@@ -370,6 +508,39 @@ fail:
   return CF_ERROR;
 }
 
+cf_status_t
+cf_open_files(capture_file *cf, int in_file_count, char *const *in_filenames,
+              gboolean do_append, int *err)
+{
+  wtap  *wth;
+  gchar *err_info;
+  guint  err_fileno;
+  int    i;
+
+  wth = merge_open_virtual((const char *const *) in_filenames, in_file_count,
+                           do_append, IDB_MERGE_MODE_ALL_SAME, err, &err_info,
+                           &err_fileno);
+  if (wth == NULL) {
+    cfile_open_failure_alert_box(in_filenames[err_fileno], *err, err_info);
+    return CF_ERROR;
+  }
+
+  cf_open_wth(cf, wth, in_filenames[0], WTAP_TYPE_AUTO, FALSE);
+
+  /* Remember the files, so that we can open them again on a reload. */
+  cf->merged_filenames = g_new(gchar *, in_file_count + 1);
+  for (i = 0; i < in_file_count; i++)
+    cf->merged_filenames[i] = g_strdup(in_filenames[i]);
+  cf->merged_filenames[in_file_count] = NULL;
+  cf->merged_append = do_append;
+
+  /* The merged packets aren't in any one file, so saving them means
+     writing them out. */
+  cf->unsaved_changes = TRUE;
+
+  return CF_OK;
+}
+
 /*
  * Add an encapsulation type to cf->linktypes.
  */
@@ -414,6 +585,8 @@ cf_close(capture_file *cf)
     g_free(cf->filename);
     cf->filename = NULL;
   }
+  g_strfreev(cf->merged_filenames);
+  cf->merged_filenames = NULL;
   /* ...which means we have no changes to that file to save. */
   cf->unsaved_changes = FALSE;
 
@@ -432,6 +605,12 @@ cf_close(capture_file *cf)
     free_frame_data_sequence(cf->frames);
     cf->frames = NULL;
   }
+  if (cf->ph_stats != NULL) {
+    ph_stats_free(cf->ph_stats);
+    cf->ph_stats = NULL;
+  }
+  protocol_index_free(cf->protocol_index);
+  cf->protocol_index = NULL;
 #ifdef WANT_PACKET_EDITOR
   if (cf->edited_frames) {
     g_tree_destroy(cf->edited_frames);
@@ -443,6 +622,7 @@ cf_close(capture_file *cf)
     cf->frames_user_comments = NULL;
   }
   cf_unselect_packet(cf);   /* nothing to select */
+  edt_cache_free(cf);
   cf->first_displayed = 0;
   cf->last_displayed = 0;
 
@@ -527,6 +707,372 @@ calc_progbar_val(capture_file *cf, gint64 size, gint64 file_pos, gchar *status_s
   return progbar_val;
 }
 
+#if GLIB_CHECK_VERSION(2,36,0)
+static void
+read_ahead_new_ipv4(const guint addr, const gchar *name)
+{
+  read_ahead_name_t *ra_name = g_new0(read_ahead_name_t, 1);
+
+  ra_name->ipv4_addr = addr;
+  ra_name->name = g_strdup(name);
+  cur_read_ahead->pending_names = g_slist_prepend(cur_read_ahead->pending_names, ra_name);
+}
+
+static void
+read_ahead_new_ipv6(const void *addrp, const gchar *name)
+{
+  read_ahead_name_t *ra_name = g_new0(read_ahead_name_t, 1);
+
+  ra_name->is_ipv6 = TRUE;
+  memcpy(ra_name->ipv6_addr, addrp, sizeof ra_name->ipv6_addr);
+  ra_name->name = g_strdup(name);
+  cur_read_ahead->pending_names = g_slist_prepend(cur_read_ahead->pending_names, ra_name);
+}
+
+static void
+read_ahead_apply_names(read_ahead_slot_t *slot)
+{
+  GSList *l;
+
+  for (l = slot->names; l != NULL; l = g_slist_next(l)) {
+    read_ahead_name_t *ra_name = (read_ahead_name_t *)l->data;
+
+    if (ra_name->is_ipv6)
+      add_ipv6_name((const struct e_in6_addr *)ra_name->ipv6_addr, ra_name->name);
+    else
+      add_ipv4_name(ra_name->ipv4_addr, ra_name->name);
+    g_free(ra_name->name);
+    g_free(ra_name);
+  }
+  g_slist_free(slot->names);
+  slot->names = NULL;
+}
+
+static gpointer
+read_ahead_thread(gpointer data)
+{
+  read_ahead_t       *ra = (read_ahead_t *)data;
+  read_ahead_slot_t  *slot;
+  struct wtap_pkthdr *phdr;
+
+  for (;;) {
+    slot = (read_ahead_slot_t *)g_async_queue_pop(ra->free_q);
+
+    if (g_atomic_int_get(&ra->stop)) {
+      slot->done = TRUE;
+      slot->err = 0;
+      slot->err_info = NULL;
+      g_async_queue_push(ra->filled_q, slot);
+      break;
+    }
+
+    g_mutex_lock(&ra->wth_mtx);
+    slot->done = !wtap_read(ra->wth, &slot->err, &slot->err_info, &slot->data_offset);
+    if (!slot->done) {
+      phdr = wtap_phdr(ra->wth);
+
+      /*
+       * Copy the header; the file-type-specific data isn't used
+       * outside libwiretap, so we don't copy it, and the comment
+       * belongs to libwiretap, so we make our own copy of it.
+       */
+      slot->phdr = *phdr;
+      slot->phdr.opt_comment = g_strdup(phdr->opt_comment);
+      memset(&slot->phdr.ft_specific_data, 0, sizeof slot->phdr.ft_specific_data);
+
+      ws_buffer_clean(&slot->buf);
+      ws_buffer_append(&slot->buf, wtap_buf_ptr(ra->wth), phdr->caplen);
+      slot->file_pos = wtap_read_so_far(ra->wth);
+    }
+    g_mutex_unlock(&ra->wth_mtx);
+
+    slot->names = g_slist_reverse(ra->pending_names);
+    ra->pending_names = NULL;
+    g_async_queue_push(ra->filled_q, slot);
+    if (slot->done)
+      break;
+  }
+  return NULL;
+}
+
+/*
+ * Start reading ahead in cf->wth.  Returns NULL if it's not worth doing,
+ * in which case the caller should read the file itself.
+ */
+static read_ahead_t *
+read_ahead_start(capture_file *cf)
+{
+  read_ahead_t *ra;
+  int           i;
+
+  if (g_get_num_processors() < 2)
+    return NULL;
+
+  ra = g_new0(read_ahead_t, 1);
+  ra->wth = cf->wth;
+  ra->filled_q = g_async_queue_new();
+  ra->free_q = g_async_queue_new();
+  g_mutex_init(&ra->wth_mtx);
+  for (i = 0; i < READ_AHEAD_SLOTS; i++) {
+    ws_buffer_init(&ra->slots[i].buf, 1500);
+    g_async_queue_push(ra->free_q, &ra->slots[i]);
+  }
+
+  cur_read_ahead = ra;
+  wtap_set_cb_new_ipv4(cf->wth, read_ahead_new_ipv4);
+  wtap_set_cb_new_ipv6(cf->wth, read_ahead_new_ipv6);
+
+  ra->thread = g_thread_new("Read ahead", read_ahead_thread, ra);
+  return ra;
+}
+
+/*
+ * Return the next record from the read-ahead, or FALSE with *err and
+ * *err_info set if there are no more.  The record stays valid until the
+ * next call.
+ */
+static gboolean
+read_ahead_next(read_ahead_t *ra, struct wtap_pkthdr **phdr, const guint8 **buf,
+                gint64 *data_offset, gint64 *file_pos, int *err, gchar **err_info)
+{
+  read_ahead_slot_t *slot;
+
+  if (ra->cur != NULL) {
+    g_free(ra->cur->phdr.opt_comment);
+    ra->cur->phdr.opt_comment = NULL;
+    g_async_queue_push(ra->free_q, ra->cur);
+    ra->cur = NULL;
+  }
+  if (ra->done) {
+    *err = 0;
+    *err_info = NULL;
+    return FALSE;
+  }
+
+  slot = (read_ahead_slot_t *)g_async_queue_pop(ra->filled_q);
+  read_ahead_apply_names(slot);
+  if (slot->done) {
+    ra->done = TRUE;
+    *err = slot->err;
+    *err_info = slot->err_info;
+    return FALSE;
+  }
+
+  ra->cur = slot;
+  *phdr = &slot->phdr;
+  *buf = ws_buffer_start_ptr(&slot->buf);
+  *data_offset = slot->data_offset;
+  *file_pos = slot->file_pos;
+  return TRUE;
+}
+
+/* Stop the reader thread if it's still running and clean up. */
+static void
+read_ahead_finish(capture_file *cf, read_ahead_t *ra)
+{
+  read_ahead_slot_t *slot;
+  int                i;
+
+  if (!ra->done) {
+    g_atomic_int_set(&ra->stop, 1);
+    if (ra->cur != NULL) {
+      g_free(ra->cur->phdr.opt_comment);
+      ra->cur->phdr.opt_comment = NULL;
+      g_async_queue_push(ra->free_q, ra->cur);
+      ra->cur = NULL;
+    }
+    do {
+      slot = (read_ahead_slot_t *)g_async_queue_pop(ra->filled_q);
+      read_ahead_apply_names(slot);
+      if (slot->done) {
+        g_free(slot->err_info);
+        break;
+      }
+      g_free(slot->phdr.opt_comment);
+      slot->phdr.opt_comment = NULL;
+      g_async_queue_push(ra->free_q, slot);
+    } while (TRUE);
+  }
+  g_thread_join(ra->thread);
+
+  wtap_set_cb_new_ipv4(cf->wth, add_ipv4_name);
+  wtap_set_cb_new_ipv6(cf->wth, (wtap_new_ipv6_callback_t) add_ipv6_name);
+  cur_read_ahead = NULL;
+
+  for (i = 0; i < READ_AHEAD_SLOTS; i++) {
+    g_free(ra->slots[i].phdr.opt_comment);
+    ws_buffer_free(&ra->slots[i].buf);
+  }
+  g_async_queue_unref(ra->filled_q);
+  g_async_queue_unref(ra->free_q);
+  g_mutex_clear(&ra->wth_mtx);
+  g_free(ra);
+}
+
+/*
+ * Reading records back for rescan_packets() can also go on in another
+ * thread while the main thread dissects; that thread has its own
+ * wiretap handle for the file, so nothing is shared with the main
+ * thread but the queues.  The main thread asks for frames, in order,
+ * a fixed number ahead of the one it's dissecting.
+ *
+ * The private handle knows only the interfaces described before the
+ * first record, so a record it can't read is read again on the main
+ * thread, which also reports any error.
+ */
+#define RESCAN_READ_AHEAD_SLOTS 64
+
+typedef struct {
+  frame_data         *fdata;      /* NULL tells the thread to stop */
+  struct wtap_pkthdr  phdr;
+  Buffer              buf;
+  gboolean            ok;
+} rescan_read_ahead_slot_t;
+
+typedef struct {
+  wtap                     *wth;
+  GThread                  *thread;
+  GAsyncQueue              *todo_q;
+  GAsyncQueue              *done_q;
+  guint32                   next_framenum;  /* next frame to ask for */
+  guint                     next_slot;      /* next free slot */
+  guint                     pending;        /* slots asked for */
+  rescan_read_ahead_slot_t  stop_slot;
+  rescan_read_ahead_slot_t  slots[RESCAN_READ_AHEAD_SLOTS];
+} rescan_read_ahead_t;
+
+static gpointer
+rescan_read_ahead_thread(gpointer data)
+{
+  rescan_read_ahead_t      *rra = (rescan_read_ahead_t *)data;
+  rescan_read_ahead_slot_t *slot;
+  int                       err;
+  gchar                    *err_info;
+
+  for (;;) {
+    slot = (rescan_read_ahead_slot_t *)g_async_queue_pop(rra->todo_q);
+    if (slot->fdata == NULL)
+      break;
+
+    /* Edited packets have no file offset; leave them to the main thread. */
+    slot->ok = slot->fdata->file_off != -1 &&
+      wtap_seek_read(rra->wth, slot->fdata->file_off, &slot->phdr,
+                     &slot->buf, &err, &err_info);
+    if (!slot->ok)
+      g_free(err_info);
+    g_async_queue_push(rra->done_q, slot);
+  }
+  return NULL;
+}
+
+/* Ask for more frames, up to the number of slots we have. */
+static void
+rescan_read_ahead_fill(capture_file *cf, rescan_read_ahead_t *rra)
+{
+  rescan_read_ahead_slot_t *slot;
+
+  while (rra->pending < RESCAN_READ_AHEAD_SLOTS &&
+         rra->next_framenum <= cf->count) {
+    slot = &rra->slots[rra->next_slot];
+    rra->next_slot = (rra->next_slot + 1) % RESCAN_READ_AHEAD_SLOTS;
+    slot->fdata = frame_data_sequence_find(cf->frames, rra->next_framenum);
+    rra->next_framenum++;
+    rra->pending++;
+    g_async_queue_push(rra->todo_q, slot);
+  }
+}
+
+/*
+ * Start reading cf's records from frame 1 on in another thread.
+ * Returns NULL if it's not worth doing or the file can't be opened
+ * a second time, in which case the caller should read the records
+ * itself.
+ */
+static rescan_read_ahead_t *
+rescan_read_ahead_start(capture_file *cf)
+{
+  rescan_read_ahead_t *rra;
+  wtap                *wth;
+  int                  err;
+  gchar               *err_info;
+  int                  i;
+
+  if (g_get_num_processors() < 2 || cf->filename == NULL)
+    return NULL;
+
+  wth = wtap_open_offline(cf->filename, cf->open_type, &err, &err_info, TRUE);
+  if (wth == NULL) {
+    g_free(err_info);
+    return NULL;
+  }
+
+  rra = g_new0(rescan_read_ahead_t, 1);
+  rra->wth = wth;
+  rra->todo_q = g_async_queue_new();
+  rra->done_q = g_async_queue_new();
+  rra->next_framenum = 1;
+  for (i = 0; i < RESCAN_READ_AHEAD_SLOTS; i++) {
+    wtap_phdr_init(&rra->slots[i].phdr);
+    ws_buffer_init(&rra->slots[i].buf, 1500);
+  }
+  rescan_read_ahead_fill(cf, rra);
+
+  rra->thread = g_thread_new("Rescan read ahead", rescan_read_ahead_thread, rra);
+  return rra;
+}
+
+/*
+ * Return the record for fdata, which must be the next frame in order.
+ * The record stays valid until the next call.
+ */
+static gboolean
+rescan_read_ahead_next(capture_file *cf, rescan_read_ahead_t *rra,
+                       frame_data *fdata, struct wtap_pkthdr **phdr,
+                       const guint8 **buf)
+{
+  rescan_read_ahead_slot_t *slot;
+
+  /* The slot we handed out last time is free again. */
+  rescan_read_ahead_fill(cf, rra);
+  g_assert(rra->pending > 0);
+
+  slot = (rescan_read_ahead_slot_t *)g_async_queue_pop(rra->done_q);
+  rra->pending--;
+  g_assert(slot->fdata == fdata);
+
+  if (!slot->ok) {
+    if (!cf_read_record(cf, fdata))
+      return FALSE;
+    *phdr = &cf->phdr;
+    *buf = ws_buffer_start_ptr(&cf->buf);
+    return TRUE;
+  }
+  *phdr = &slot->phdr;
+  *buf = ws_buffer_start_ptr(&slot->buf);
+  return TRUE;
+}
+
+/* Stop the reader thread and clean up. */
+static void
+rescan_read_ahead_finish(rescan_read_ahead_t *rra)
+{
+  int i;
+
+  rra->stop_slot.fdata = NULL;
+  g_async_queue_push(rra->todo_q, &rra->stop_slot);
+  g_thread_join(rra->thread);
+
+  wtap_close(rra->wth);
+  for (i = 0; i < RESCAN_READ_AHEAD_SLOTS; i++) {
+    wtap_phdr_cleanup(&rra->slots[i].phdr);
+    ws_buffer_free(&rra->slots[i].buf);
+  }
+  g_async_queue_unref(rra->todo_q);
+  g_async_queue_unref(rra->done_q);
+  g_free(rra);
+}
+#endif /* GLIB_CHECK_VERSION(2,36,0) */
+
 cf_read_status_t
 cf_read(capture_file *cf, gboolean reloading)
 {
@@ -542,6 +1088,9 @@ cf_read(capture_file *cf, gboolean reloading)
   guint                tap_flags;
   gboolean             compiled;
   volatile gboolean    is_read_aborted = FALSE;
+#if GLIB_CHECK_VERSION(2,36,0)
+  read_ahead_t        *volatile read_ahead;
+#endif
 
   /* Compile the current display filter.
    * We assume this will not fail since cf->dfilter is only set in
@@ -591,12 +1140,18 @@ cf_read(capture_file *cf, gboolean reloading)
 
   epan_dissect_init(&edt, cf->epan, create_proto_tree, FALSE);
 
+#if GLIB_CHECK_VERSION(2,36,0)
+  read_ahead = read_ahead_start(cf);
+#endif
+
   TRY {
     int     count             = 0;
 
     gint64  size;
     gint64  file_pos;
     gint64  data_offset;
+    struct wtap_pkthdr *phdr;
+    const guint8 *buf;
 
     float   progbar_val;
     gchar   status_str[100];
@@ -611,10 +1166,24 @@ cf_read(capture_file *cf, gboolean reloading)
 
     g_timer_start(prog_timer);
 
-    while ((wtap_read(cf->wth, &err, &err_info, &data_offset))) {
+    for (;;) {
+#if GLIB_CHECK_VERSION(2,36,0)
+      if (read_ahead != NULL) {
+        if (!read_ahead_next(read_ahead, &phdr, &buf, &data_offset, &file_pos,
+                             &err, &err_info))
+          break;
+      } else
+#endif
+      {
+        if (!wtap_read(cf->wth, &err, &err_info, &data_offset))
+          break;
+        phdr = wtap_phdr(cf->wth);
+        buf = wtap_buf_ptr(cf->wth);
+        file_pos = wtap_read_so_far(cf->wth);
+      }
+
       if (size >= 0) {
         count++;
-        file_pos = wtap_read_so_far(cf->wth);
 
         /* Create the progress bar if necessary. */
         if (progress_is_slow(progbar, prog_timer, size, file_pos)) {
@@ -660,7 +1229,7 @@ cf_read(capture_file *cf, gboolean reloading)
            hours even on fast machines) just to see that it was the wrong file. */
         break;
       }
-      read_packet(cf, dfcode, &edt, cinfo, data_offset);
+      read_packet(cf, dfcode, &edt, cinfo, phdr, buf, data_offset);
     }
   }
   CATCH(OutOfMemoryError) {
@@ -677,6 +1246,11 @@ cf_read(capture_file *cf, gboolean reloading)
   }
   ENDTRY;
 
+#if GLIB_CHECK_VERSION(2,36,0)
+  if (read_ahead != NULL)
+    read_ahead_finish(cf, read_ahead);
+#endif
+
   /* Free the display name */
   g_free(name_ptr);
 
@@ -756,7 +1330,8 @@ cf_read(capture_file *cf, gboolean reloading)
 
 #ifdef HAVE_LIBPCAP
 cf_read_status_t
-cf_continue_tail(capture_file *cf, volatile int to_read, int *err)
+cf_continue_tail(capture_file *cf, volatile int to_read, int *to_read_deferred,
+                 int *err)
 {
   gchar            *err_info;
   volatile int      newly_displayed_packets = 0;
@@ -765,6 +1340,8 @@ cf_continue_tail(capture_file *cf, volatile int to_read, int *err)
   gboolean          create_proto_tree;
   guint             tap_flags;
   gboolean          compiled;
+  GTimer           *tail_timer;
+  volatile gboolean out_of_time = FALSE;
 
   /* Compile the current display filter.
    * We assume this will not fail since cf->dfilter is only set in
@@ -802,6 +1379,7 @@ cf_continue_tail(capture_file *cf, volatile int to_read, int *err)
   /*g_log(NULL, G_LOG_LEVEL_MESSAGE, "cf_continue_tail: %u new: %u", cf->count, to_read);*/
 
   epan_dissect_init(&edt, cf->epan, create_proto_tree, FALSE);
+  tail_timer = g_timer_new();
 
   TRY {
     gint64 data_offset = 0;
@@ -821,10 +1399,18 @@ cf_continue_tail(capture_file *cf, volatile int to_read, int *err)
            aren't any packets left to read) exit. */
         break;
       }
-      if (read_packet(cf, dfcode, &edt, (column_info *) cinfo, data_offset) != -1) {
+      if (read_packet(cf, dfcode, &edt, (column_info *) cinfo,
+                      wtap_phdr(cf->wth), wtap_buf_ptr(cf->wth), data_offset) != -1) {
         newly_displayed_packets++;
       }
       to_read--;
+      /* Leave the rest for later if we're falling behind; checking the
+         clock on every packet would cost more than it's worth. */
+      if ((to_read & 0x3f) == 0 && to_read != 0 &&
+          g_timer_elapsed(tail_timer, NULL) > TAIL_TIME_BUDGET) {
+        out_of_time = TRUE;
+        break;
+      }
     }
   }
   CATCH(OutOfMemoryError) {
@@ -842,6 +1428,12 @@ cf_continue_tail(capture_file *cf, volatile int to_read, int *err)
   }
   ENDTRY;
 
+  g_timer_destroy(tail_timer);
+
+  /* If we stopped early because of a read error or EOF, whatever is left
+     will be read when the child tells us about more packets. */
+  *to_read_deferred = out_of_time ? to_read : 0;
+
   /* Update the file encapsulation; it might have changed based on the
      packets we've read. */
   cf->lnk_t = wtap_file_encap(cf->wth);
@@ -955,7 +1547,8 @@ cf_finish_tail(capture_file *cf, int *err)
          aren't any packets left to read) exit. */
       break;
     }
-    read_packet(cf, dfcode, &edt, cinfo, data_offset);
+    read_packet(cf, dfcode, &edt, cinfo, wtap_phdr(cf->wth),
+                wtap_buf_ptr(cf->wth), data_offset);
   }
 
   /* Cleanup and release all dfilter resources */
@@ -1117,6 +1710,7 @@ add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
     struct wtap_pkthdr *phdr, const guint8 *buf, gboolean add_to_packet_list)
 {
   gint            row               = -1;
+  gboolean        first_pass        = !fdata->flags.visited;
 
   frame_data_set_before_dissect(fdata, &cf->elapsed_time,
                                 &cf->ref, cf->prev_dis);
@@ -1135,7 +1729,7 @@ add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
   }
 #endif
 
-  if (!fdata->flags.visited) {
+  if (first_pass) {
     /* This is the first pass, so prime the epan_dissect_t with the
        hfids postdissectors want on the first pass. */
     prime_epan_dissect_with_postdissector_wanted_hfids(edt);
@@ -1144,6 +1738,16 @@ add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
   /* Dissect the frame. */
   epan_dissect_run_with_taps(edt, cf->cd_t, phdr, frame_tvbuff_new(fdata, buf), fdata, cinfo);
 
+  /* The layers are there whether or not we built a tree, so the
+     protocol hierarchy dialog doesn't have to dissect everything again. */
+  if (first_pass && cf->ph_stats != NULL)
+    ph_stats_add_layers(cf->ph_stats, fdata, edt->pi.layers);
+
+  /* Only a tree tells which protocols were added; frames without one
+     just can't be ruled out later. */
+  if (first_pass && cf->protocol_index != NULL && edt->tree != NULL)
+    protocol_index_add_frame(cf->protocol_index, fdata->num, edt->tree);
+
   /* If we don't have a display filter, set "passed_dfilter" to 1. */
   if (dfcode != NULL) {
     fdata->flags.passed_dfilter = dfilter_apply_edt(dfcode, edt) ? 1 : 0;
@@ -1153,13 +1757,15 @@ add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
        * (potentially not displayed) frames.  Find those frames and mark them
        * as depended upon.
        */
-      g_slist_foreach(edt->pi.dependent_frames, find_and_mark_frame_depended_upon, cf->frames);
+      frame_data_sequence_mark_depended_upon(cf->frames, edt->pi.dependent_frames);
     }
   } else
     fdata->flags.passed_dfilter = 1;
 
   if (fdata->flags.passed_dfilter || fdata->flags.ref_time)
     cf->displayed_count++;
+  if (fdata->flags.passed_dfilter)
+    cf_frame_totals_add(&cf->filtered_totals, fdata);
 
   if (add_to_packet_list) {
     /* We fill the needed columns from new_packet_list */
@@ -1187,10 +1793,9 @@ add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
 /* returns the row of the new packet in the packet list or -1 if not displayed */
 static int
 read_packet(capture_file *cf, dfilter_t *dfcode, epan_dissect_t *edt,
-            column_info *cinfo, gint64 offset)
+            column_info *cinfo, struct wtap_pkthdr *phdr, const guint8 *buf,
+            gint64 offset)
 {
-  struct wtap_pkthdr *phdr = wtap_phdr(cf->wth);
-  const guint8 *buf = wtap_buf_ptr(cf->wth);
   frame_data    fdlocal;
   guint32       framenum;
   frame_data   *fdata;
@@ -1226,6 +1831,7 @@ read_packet(capture_file *cf, dfilter_t *dfcode, epan_dissect_t *edt,
     fdata = frame_data_sequence_add(cf->frames, &fdlocal);
 
     cf->count++;
+    cf_frame_totals_add(&cf->all_totals, fdata);
     if (phdr->opt_comment != NULL)
       cf->packet_comment_count++;
     cf->f_datalen = offset + fdlocal.cap_len;
@@ -1428,6 +2034,13 @@ cf_merge_files_to_tempfile(gpointer pd_window, char **out_filenamep,
     return CF_OK;
 }
 
+void
+cf_set_filter_frames(capture_file *cf, const guint32 *frames, guint32 count)
+{
+  cf->filter_frames = frames;
+  cf->filter_frames_count = frames ? count : 0;
+}
+
 cf_status_t
 cf_filter_packets(capture_file *cf, gchar *dftext, gboolean force)
 {
@@ -1499,6 +2112,14 @@ void
 cf_reftime_packets(capture_file *cf)
 {
   ref_time_packets(cf);
+  cf_invalidate_dissections(cf);
+}
+
+void
+cf_reftime_frame_changed(capture_file *cf, frame_data *frame)
+{
+  ref_time_packets_from(cf, frame);
+  cf_invalidate_dissections(cf);
 }
 
 void
@@ -1581,6 +2202,16 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
   gboolean    add_to_packet_list = FALSE;
   gboolean    compiled;
   guint32     frames_count;
+  gboolean    metadata_only;
+  const guint32 *filter_frames;
+  guint32    *index_frames;
+  guint32     filter_frames_left;
+  struct wtap_pkthdr metadata_phdr;
+  struct wtap_pkthdr *phdr;
+  const guint8 *buf;
+#if GLIB_CHECK_VERSION(2,36,0)
+  rescan_read_ahead_t *read_ahead = NULL;
+#endif
 
   /* Compile the current display filter.
    * We assume this will not fail since cf->dfilter is only set in
@@ -1637,7 +2268,19 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
        want to dissect those before their time. */
     cf->redissecting = TRUE;
 
+    /* Every frame gets a new first pass, so count the protocol
+       hierarchy again. */
+    if (cf->ph_stats != NULL) {
+      ph_stats_free(cf->ph_stats);
+      cf->ph_stats = ph_stats_new_empty();
+    }
+    if (cf->protocol_index != NULL) {
+      protocol_index_free(cf->protocol_index);
+      cf->protocol_index = protocol_index_new();
+    }
+
     /* 'reset' dissection session */
+    edt_cache_flush(cf);
     epan_free(cf->epan);
     if (cf->edt && cf->edt->pi.fd) {
       /* All pointers in "per frame proto data" for the currently selected
@@ -1666,6 +2309,7 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
 
   /* We currently don't display any packets */
   cf->displayed_count = 0;
+  memset(&cf->filtered_totals, 0, sizeof cf->filtered_totals);
 
   /* Iterate through the list of frames.  Call a routine for each frame
      to check whether it should be displayed and, if so, add it to
@@ -1699,6 +2343,55 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
 
   frames_count = cf->count;
 
+  /*
+   * If the filter only looks at frame metadata such as frame.len or
+   * frame.time, and nothing else needs the dissection, frames that have
+   * already been visited don't have to be read or handed to anything
+   * past the frame dissector.  Frames they depend upon aren't marked
+   * then, as finding those would take the full dissection.
+   */
+  metadata_only = !redissect && cinfo == NULL &&
+    frame_dfilter_is_metadata_only(dfcode) &&
+    !tap_listeners_require_dissection();
+
+  /*
+   * If we've been told which frames can match the filter, the others
+   * get the same treatment; they can't pass once only the frame
+   * dissector has looked at them.  There are few enough of the
+   * remaining ones that reading them ahead isn't worth it.
+   */
+  filter_frames = NULL;
+  filter_frames_left = 0;
+  if (!redissect && !metadata_only && cinfo == NULL && dfcode != NULL &&
+      cf->filter_frames != NULL) {
+    filter_frames = cf->filter_frames;
+    filter_frames_left = cf->filter_frames_count;
+  }
+  cf_set_filter_frames(cf, NULL, 0);
+
+  /*
+   * Otherwise, frames that lack a protocol the filter requires ("dns",
+   * or "http && ...") needn't be dissected past the frame dissector
+   * either, if nothing else wants them dissected.
+   */
+  index_frames = NULL;
+  if (filter_frames == NULL && !redissect && !metadata_only && cinfo == NULL &&
+      dfcode != NULL && cf->protocol_index != NULL &&
+      !tap_listeners_require_dissection()) {
+    index_frames = protocol_index_filter_frames(cf->protocol_index, dfcode,
+                                                frames_count, &filter_frames_left);
+    filter_frames = index_frames;
+  }
+
+  if (metadata_only || filter_frames != NULL) {
+    wtap_phdr_init(&metadata_phdr);
+    metadata_phdr.rec_type = REC_TYPE_PACKET;
+  }
+#if GLIB_CHECK_VERSION(2,36,0)
+  else
+    read_ahead = rescan_read_ahead_start(cf);
+#endif
+
   epan_dissect_init(&edt, cf->epan, create_proto_tree, FALSE);
 
   for (framenum = 1; framenum <= frames_count; framenum++) {
@@ -1767,8 +2460,31 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
     /* Frame dependencies from the previous dissection/filtering are no longer valid. */
     fdata->flags.dependent_of_displayed = 0;
 
-    if (!cf_read_record(cf, fdata))
-      break; /* error reading the frame */
+    while (filter_frames_left > 0 && *filter_frames < framenum) {
+      filter_frames++;
+      filter_frames_left--;
+    }
+
+    if ((metadata_only || (filter_frames != NULL &&
+                           (filter_frames_left == 0 || *filter_frames != framenum))) &&
+        fdata->flags.visited) {
+      /* Nothing past the frame dissector looks at the data. */
+      phdr = &metadata_phdr;
+      buf = NULL;
+    } else {
+#if GLIB_CHECK_VERSION(2,36,0)
+      if (read_ahead != NULL) {
+        if (!rescan_read_ahead_next(cf, read_ahead, fdata, &phdr, &buf))
+          break; /* error reading the frame */
+      } else
+#endif
+      {
+        if (!cf_read_record(cf, fdata))
+          break; /* error reading the frame */
+        phdr = &cf->phdr;
+        buf = ws_buffer_start_ptr(&cf->buf);
+      }
+    }
 
     /* If the previous frame is displayed, and we haven't yet seen the
        selected frame, remember that frame - it's the closest one we've
@@ -1778,9 +2494,9 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
       preceding_frame = prev_frame;
     }
 
+    epan_dissect_set_metadata_only(&edt, phdr == &metadata_phdr);
     add_packet_to_packet_list(fdata, cf, &edt, dfcode,
-                                    cinfo, &cf->phdr,
-                                    ws_buffer_start_ptr(&cf->buf),
+                                    cinfo, phdr, buf,
                                     add_to_packet_list);
 
     /* If this frame is displayed, and this is the first frame we've
@@ -1804,6 +2520,13 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
   }
 
   epan_dissect_cleanup(&edt);
+  if (metadata_only || filter_frames != NULL)
+    wtap_phdr_cleanup(&metadata_phdr);
+  g_free(index_frames);
+#if GLIB_CHECK_VERSION(2,36,0)
+  if (read_ahead != NULL)
+    rescan_read_ahead_finish(read_ahead);
+#endif
 
   /* We are done redissecting the packet list. */
   cf->redissecting = FALSE;
@@ -1988,14 +2711,79 @@ ref_time_packets(capture_file *cf)
   }
 }
 
+/*
+ * Redo what ref_time_packets() does for the frames whose reference
+ * frame or cumulative byte count can depend on the reference time flag
+ * of first: those from first up to the next time reference frame after
+ * it.  That frame starts over from itself, as do all after it, and the
+ * previous displayed frames don't depend on time references at all.
+ */
+static void
+ref_time_packets_from(capture_file *cf, frame_data *first)
+{
+  guint32     framenum;
+  frame_data *fdata, *prev, *ref;
+  guint32     cum_bytes;
+  nstime_t    rel_ts;
+
+  /* Pick up where the last pass was at the frame before first */
+  if (first->num == 1) {
+    ref = NULL;
+    cum_bytes = 0;
+  } else {
+    prev = frame_data_sequence_find(cf->frames, first->num - 1);
+    ref = prev->frame_ref_num ? frame_data_sequence_find(cf->frames, prev->frame_ref_num) : prev;
+    if (prev->flags.passed_dfilter || prev->flags.ref_time)
+      cum_bytes = prev->cum_bytes;
+    else
+      cum_bytes = prev->cum_bytes - prev->pkt_len;
+  }
+
+  for (framenum = first->num; framenum <= cf->count; framenum++) {
+    fdata = frame_data_sequence_find(cf->frames, framenum);
+    if (fdata != first && fdata->flags.ref_time)
+      return;
+
+    fdata->cum_bytes = cum_bytes + fdata->pkt_len;
+
+    if (ref == NULL || fdata->flags.ref_time)
+      ref = fdata;
+
+    fdata->frame_ref_num = (fdata != ref) ? ref->num : 0;
+    nstime_delta(&rel_ts, &fdata->abs_ts, &ref->abs_ts);
+    if ((gint32)cf->elapsed_time.secs < rel_ts.secs
+        || ((gint32)cf->elapsed_time.secs == rel_ts.secs && (gint32)cf->elapsed_time.nsecs < rel_ts.nsecs)) {
+        cf->elapsed_time = rel_ts;
+    }
+
+    if (fdata->flags.ref_time) {
+      cum_bytes = fdata->pkt_len;
+      fdata->cum_bytes = cum_bytes;
+    } else if (fdata->flags.passed_dfilter) {
+      cum_bytes += fdata->pkt_len;
+    }
+  }
+
+  /* No time reference frame after first; we've reached the end state */
+  cf->ref = ref;
+  cf->cum_bytes = cum_bytes;
+}
+
 typedef enum {
   PSP_FINISHED,
   PSP_STOPPED,
   PSP_FAILED
 } psp_return_t;
 
+/*
+ * Process the records in range, or, if frames isn't NULL, the
+ * frames_count frames it lists in ascending order.  If read_records
+ * is FALSE the records aren't read, and the callback is handed NULL
+ * for the header and data.
+ */
 static psp_return_t
-process_specified_records(capture_file *cf, packet_range_t *range,
+process_records(capture_file *cf, packet_range_t *range,
+    const guint32 *frames, guint32 frames_count, gboolean read_records,
     const char *string1, const char *string2, gboolean terminate_is_stop,
     gboolean (*callback)(capture_file *, frame_data *,
                          struct wtap_pkthdr *, const guint8 *, void *),
@@ -2003,6 +2791,7 @@ process_specified_records(capture_file *cf, packet_range_t *range,
     gboolean show_progress_bar)
 {
   guint32          framenum;
+  guint32          records_count, i;
   frame_data      *fdata;
   Buffer           buf;
   psp_return_t     ret     = PSP_FINISHED;
@@ -2031,9 +2820,14 @@ process_specified_records(capture_file *cf, packet_range_t *range,
   if (range != NULL)
     packet_range_process_init(range);
 
+  records_count = frames != NULL ? frames_count : cf->count;
+
   /* Iterate through all the packets, printing the packets that
      were selected by the current display filter.  */
-  for (framenum = 1; framenum <= cf->count; framenum++) {
+  for (i = 0; i < records_count; i++) {
+    framenum = frames != NULL ? frames[i] : i + 1;
+    if (framenum == 0 || framenum > cf->count)
+      continue;
     fdata = frame_data_sequence_find(cf->frames, framenum);
 
     /* Create the progress bar if necessary.
@@ -2058,11 +2852,11 @@ process_specified_records(capture_file *cf, packet_range_t *range,
       /* let's not divide by zero. I should never be started
        * with count == 0, so let's assert that
        */
-      g_assert(cf->count > 0);
-      progbar_val = (gfloat) progbar_count / cf->count;
+      g_assert(records_count > 0);
+      progbar_val = (gfloat) progbar_count / records_count;
 
       g_snprintf(progbar_status_str, sizeof(progbar_status_str),
-                  "%4u of %u packets", progbar_count, cf->count);
+                  "%4u of %u packets", progbar_count, records_count);
       update_progress_dlg(progbar, progbar_val, progbar_status_str);
 
       g_timer_start(prog_timer);
@@ -2090,6 +2884,15 @@ process_specified_records(capture_file *cf, packet_range_t *range,
       }
     }
 
+    if (!read_records) {
+      /* The callback gets at the record itself */
+      if (!callback(cf, fdata, NULL, NULL, callback_args)) {
+        ret = PSP_FAILED;
+        break;
+      }
+      continue;
+    }
+
     /* Get the packet */
     if (!cf_read_record_r(cf, fdata, &phdr, &buf)) {
       /* Attempt to get the packet failed. */
@@ -2116,6 +2919,19 @@ process_specified_records(capture_file *cf, packet_range_t *range,
   return ret;
 }
 
+static psp_return_t
+process_specified_records(capture_file *cf, packet_range_t *range,
+    const char *string1, const char *string2, gboolean terminate_is_stop,
+    gboolean (*callback)(capture_file *, frame_data *,
+                         struct wtap_pkthdr *, const guint8 *, void *),
+    void *callback_args,
+    gboolean show_progress_bar)
+{
+  return process_records(cf, range, NULL, 0, TRUE, string1, string2,
+                         terminate_is_stop, callback, callback_args,
+                         show_progress_bar);
+}
+
 typedef struct {
   epan_dissect_t edt;
   column_info *cinfo;
@@ -2136,6 +2952,12 @@ retap_packet(capture_file *cf, frame_data *fdata,
 
 cf_read_status_t
 cf_retap_packets(capture_file *cf)
+{
+  return cf_retap_frames(cf, NULL, 0);
+}
+
+cf_read_status_t
+cf_retap_frames(capture_file *cf, const guint32 *frames, guint32 count)
 {
   packet_range_t        range;
   retap_callback_args_t callback_args;
@@ -2170,6 +2992,16 @@ cf_retap_packets(capture_file *cf)
   /* Reset the tap listeners. */
   reset_tap_listeners();
 
+  /*
+   * If no listener is left that gathers statistics (they've all been
+   * removed, or the remaining ones only help dissectors do their work),
+   * there's nothing to recalculate, so don't redissect the whole file.
+   */
+  if (!tap_listeners_require_dissection()) {
+    cf_callback_invoke(cf_cb_file_retap_finished, cf);
+    return CF_READ_OK;
+  }
+
   epan_dissect_init(&callback_args.edt, cf->epan, create_proto_tree, FALSE);
 
   /* Iterate through the list of packets, dissecting all packets and
@@ -2177,9 +3009,14 @@ cf_retap_packets(capture_file *cf)
   packet_range_init(&range, cf);
   packet_range_process_init(&range);
 
-  ret = process_specified_records(cf, &range, "Recalculating statistics on",
-                                  "all packets", TRUE, retap_packet,
-                                  &callback_args, TRUE);
+  if (frames != NULL)
+    ret = process_records(cf, NULL, frames, count, TRUE,
+                          "Recalculating statistics on", "selected packets",
+                          TRUE, retap_packet, &callback_args, TRUE);
+  else
+    ret = process_specified_records(cf, &range, "Recalculating statistics on",
+                                    "all packets", TRUE, retap_packet,
+                                    &callback_args, TRUE);
 
   epan_dissect_cleanup(&callback_args.edt);
 
@@ -2923,14 +3760,38 @@ cf_write_json_packets(capture_file *cf, print_args_t *print_args)
 gboolean
 cf_find_packet_protocol_tree(capture_file *cf, const char *string,
                              search_direction dir)
+{
+  return cf_find_packet_protocol_fields(cf, string, -1, dir);
+}
+
+gboolean
+cf_find_packet_protocol_fields(capture_file *cf, const char *string,
+                               int proto_id, search_direction dir)
 {
   match_data mdata;
 
   mdata.string = string;
   mdata.string_len = strlen(string);
+  mdata.proto_id = proto_id;
   return find_packet(cf, match_protocol_tree, &mdata, dir);
 }
 
+/* Search the top-level items of tree, or only those of mdata->proto_id */
+static gboolean
+match_tree_text(proto_tree *tree, match_data *mdata)
+{
+  proto_node *node;
+
+  for (node = tree->first_child; node != NULL; node = node->next) {
+    if (mdata->proto_id >= 0 && PNODE_FINFO(node) != NULL &&
+        PNODE_FINFO(node)->hfinfo->id != mdata->proto_id)
+      continue;
+    if (match_subtree_text(node, mdata))
+      return TRUE;
+  }
+  return FALSE;
+}
+
 gboolean
 cf_find_string_protocol_tree(capture_file *cf, proto_tree *tree,  match_data *mdata)
 {
@@ -2938,8 +3799,9 @@ cf_find_string_protocol_tree(capture_file *cf, proto_tree *tree,  match_data *md
   mdata->string = convert_string_case(cf->sfilter, cf->case_type);
   mdata->string_len = strlen(mdata->string);
   mdata->cf = cf;
+  mdata->proto_id = -1;
   /* Iterate through all the nodes looking for matching text */
-  proto_tree_children_foreach(tree, match_subtree_text, mdata);
+  match_tree_text(tree, mdata);
   return mdata->frame_matched ? MR_MATCHED : MR_NOTMATCHED;
 }
 
@@ -2949,6 +3811,11 @@ match_protocol_tree(capture_file *cf, frame_data *fdata, void *criterion)
   match_data     *mdata = (match_data *)criterion;
   epan_dissect_t  edt;
 
+  /* A frame without the protocol has nothing to search */
+  if (mdata->proto_id >= 0 && cf->protocol_index != NULL &&
+      !protocol_index_frame_may_have(cf->protocol_index, fdata->num, mdata->proto_id))
+    return MR_NOTMATCHED;
+
   /* Load the frame's data. */
   if (!cf_read_record(cf, fdata)) {
     /* Attempt to get the packet failed. */
@@ -2963,37 +3830,55 @@ match_protocol_tree(capture_file *cf, frame_data *fdata, void *criterion)
   /* Iterate through all the nodes, seeing if they have text that matches. */
   mdata->cf = cf;
   mdata->frame_matched = FALSE;
-  proto_tree_children_foreach(edt.tree, match_subtree_text, mdata);
+  match_tree_text(edt.tree, mdata);
   epan_dissect_cleanup(&edt);
   return mdata->frame_matched ? MR_MATCHED : MR_NOTMATCHED;
 }
 
-static void
-match_subtree_text(proto_node *node, gpointer data)
+/* Does label contain string, which is upper case if nocase is set? */
+static gboolean
+label_contains(const gchar *label, const gchar *string, size_t string_len,
+               gboolean nocase)
+{
+  const gchar *p;
+  size_t       i;
+
+  if (string_len == 0)
+    return FALSE;
+  if (!nocase)
+    return strstr(label, string) != NULL;
+
+  for (p = label; *p != '\0'; p++) {
+    if (g_ascii_toupper(*p) != string[0])
+      continue;
+    for (i = 1; i < string_len && p[i] != '\0'; i++) {
+      if (g_ascii_toupper(p[i]) != string[i])
+        break;
+    }
+    if (i == string_len)
+      return TRUE;
+    if (p[i] == '\0')
+      break;
+  }
+  return FALSE;
+}
+
+/* Returns TRUE, with mdata->finfo set, at the first item that matches */
+static gboolean
+match_subtree_text(proto_node *node, match_data *mdata)
 {
-  match_data   *mdata      = (match_data *) data;
-  const gchar  *string     = mdata->string;
-  size_t        string_len = mdata->string_len;
   capture_file *cf         = mdata->cf;
   field_info   *fi         = PNODE_FINFO(node);
   gchar         label_str[ITEM_LABEL_LENGTH];
   gchar        *label_ptr;
-  size_t        label_len;
-  guint32       i;
-  guint8        c_char;
-  size_t        c_match    = 0;
+  proto_node   *child;
 
   /* dissection with an invisible proto tree? */
   g_assert(fi);
 
-  if (mdata->frame_matched) {
-    /* We already had a match; don't bother doing any more work. */
-    return;
-  }
-
   /* Don't match invisible entries. */
   if (PROTO_ITEM_IS_HIDDEN(node))
-    return;
+    return FALSE;
 
   /* was a free format label produced? */
   if (fi->rep) {
@@ -3004,35 +3889,19 @@ match_subtree_text(proto_node *node, gpointer data)
     proto_item_fill_label(fi, label_str);
   }
 
-  if (cf->regex) {
-    if (g_regex_match(cf->regex, label_ptr, (GRegexMatchFlags) 0, NULL)) {
-      mdata->frame_matched = TRUE;
-      mdata->finfo = fi;
-      return;
-    }
-  } else {
-    /* Does that label match? */
-    label_len = strlen(label_ptr);
-    for (i = 0; i < label_len; i++) {
-      c_char = label_ptr[i];
-      if (cf->case_type)
-        c_char = g_ascii_toupper(c_char);
-      if (c_char == string[c_match]) {
-        c_match++;
-        if (c_match == string_len) {
-          /* No need to look further; we have a match */
-          mdata->frame_matched = TRUE;
-          mdata->finfo = fi;
-          return;
-        }
-      } else
-        c_match = 0;
-    }
+  if (cf->regex ? g_regex_match(cf->regex, label_ptr, (GRegexMatchFlags) 0, NULL) :
+      label_contains(label_ptr, mdata->string, mdata->string_len, cf->case_type)) {
+    mdata->frame_matched = TRUE;
+    mdata->finfo = fi;
+    return TRUE;
   }
 
-  /* Recurse into the subtree, if it exists */
-  if (node->first_child != NULL)
-    proto_tree_children_foreach(node, match_subtree_text, mdata);
+  /* Recurse into the subtree, if it exists, stopping at the first match */
+  for (child = node->first_child; child != NULL; child = child->next) {
+    if (match_subtree_text(child, mdata))
+      return TRUE;
+  }
+  return FALSE;
 }
 
 gboolean
@@ -3122,6 +3991,57 @@ typedef struct {
  * significantly better.
  */
 
+/*
+ * Find the first occurrence of an upper case needle in haystack, ignoring
+ * the (ASCII) case of the haystack; the candidates for the first character
+ * are found with memchr().
+ */
+static const guint8 *
+find_bytes_nocase(const guint8 *haystack, size_t haystack_len,
+                  const guint8 *needle, size_t needle_len)
+{
+  const guint8 *last_possible;
+  const guint8 *begin;
+  const guint8 *next_upper;
+  const guint8 *next_lower;
+  guint8        lower = g_ascii_tolower(needle[0]);
+  size_t        i;
+
+  if (needle_len == 0 || needle_len > haystack_len)
+    return NULL;
+
+  last_possible = haystack + haystack_len - needle_len;
+  next_upper = haystack;
+  next_lower = (lower != needle[0]) ? haystack : NULL;
+  begin = haystack;
+
+  while (begin <= last_possible) {
+    /* Next place starting with either case of the first character */
+    if (next_upper != NULL && next_upper < begin)
+      next_upper = (const guint8 *)memchr(begin, needle[0], last_possible - begin + 1);
+    if (next_lower != NULL && next_lower < begin)
+      next_lower = (const guint8 *)memchr(begin, lower, last_possible - begin + 1);
+
+    if (next_upper == NULL && next_lower == NULL)
+      break;
+    if (next_upper == NULL || (next_lower != NULL && next_lower < next_upper))
+      begin = next_lower;
+    else
+      begin = next_upper;
+
+    for (i = 0; i < needle_len; i++) {
+      if (g_ascii_toupper(begin[i]) != needle[i])
+        break;
+    }
+    if (i == needle_len)
+      return begin;
+
+    begin++;
+  }
+
+  return NULL;
+}
+
 gboolean
 cf_find_packet_data(capture_file *cf, const guint8 *string, size_t string_size,
                     search_direction dir)
@@ -3213,10 +4133,7 @@ match_narrow(capture_file *cf, frame_data *fdata, void *criterion)
   const guint8 *ascii_text = info->data;
   size_t        textlen    = info->data_len;
   match_result  result;
-  guint32       buf_len;
-  guint32       i;
-  guint8        c_char;
-  size_t        c_match    = 0;
+  const guint8 *found;
 
   /* Load the frame's data. */
   if (!cf_read_record(cf, fdata)) {
@@ -3225,29 +4142,16 @@ match_narrow(capture_file *cf, frame_data *fdata, void *criterion)
   }
 
   result = MR_NOTMATCHED;
-  buf_len = fdata->cap_len;
   pd = ws_buffer_start_ptr(&cf->buf);
-  i = 0;
-  while (i < buf_len) {
-    c_char = pd[i];
-    if (cf->case_type)
-      c_char = g_ascii_toupper(c_char);
-    if (c_char == ascii_text[c_match]) {
-      c_match += 1;
-      if (c_match == textlen) {
-        result = MR_MATCHED;
-        cf->search_pos = i; /* Save the position of the last character
-                               for highlighting the field. */
-        cf->search_len = (guint32)textlen;
-        break;
-      }
-    }
-    else {
-      g_assert(i>=c_match);
-      i -= (guint32)c_match;
-      c_match = 0;
-    }
-    i += 1;
+  if (cf->case_type)
+    found = find_bytes_nocase(pd, fdata->cap_len, ascii_text, textlen);
+  else
+    found = epan_memmem(pd, fdata->cap_len, ascii_text, (guint)textlen);
+  if (found != NULL) {
+    result = MR_MATCHED;
+    cf->search_pos = (guint32)(found - pd + textlen - 1); /* Save the position of the last character
+                                                             for highlighting the field. */
+    cf->search_len = (guint32)textlen;
   }
 
   return result;
@@ -3308,10 +4212,8 @@ match_binary(capture_file *cf, frame_data *fdata, void *criterion)
   const guint8 *binary_data = info->data;
   size_t        datalen     = info->data_len;
   match_result  result;
-  guint32       buf_len;
   guint8       *pd;
-  guint32       i;
-  size_t        c_match     = 0;
+  const guint8 *found;
 
   /* Load the frame's data. */
   if (!cf_read_record(cf, fdata)) {
@@ -3320,26 +4222,13 @@ match_binary(capture_file *cf, frame_data *fdata, void *criterion)
   }
 
   result = MR_NOTMATCHED;
-  buf_len = fdata->cap_len;
   pd = ws_buffer_start_ptr(&cf->buf);
-  i = 0;
-  while (i < buf_len) {
-    if (pd[i] == binary_data[c_match]) {
-      c_match += 1;
-      if (c_match == datalen) {
-        result = MR_MATCHED;
-        cf->search_pos = i; /* Save the position of the last character
-                               for highlighting the field. */
-        cf->search_len = (guint32)datalen;
-        break;
-      }
-    }
-    else {
-      g_assert(i>=c_match);
-      i -= (guint32)c_match;
-      c_match = 0;
-    }
-    i += 1;
+  found = epan_memmem(pd, fdata->cap_len, binary_data, (guint)datalen);
+  if (found != NULL) {
+    result = MR_MATCHED;
+    cf->search_pos = (guint32)(found - pd + datalen - 1); /* Save the position of the last character
+                                                             for highlighting the field. */
+    cf->search_len = (guint32)datalen;
   }
   return result;
 }
@@ -3673,12 +4562,203 @@ cf_goto_framenum(capture_file *cf)
   return FALSE;
 }
 
+/*
+ * Dissections of recently selected (or prefetched) packets, so that
+ * moving back and forth between packets doesn't dissect them over and
+ * over again.  Each entry has its own copy of the record, as that's what
+ * the tvbuffs of its dissection point into.
+ *
+ * The dissection of the selected packet is not in the entries array;
+ * it goes back into it when another packet is selected.  Anything that
+ * changes how a packet dissects bumps the generation, which makes the
+ * entries from before useless.
+ */
+#define EDT_CACHE_SIZE 8
+
+typedef struct {
+  guint32             framenum;
+  guint               generation;
+  guint               last_used;
+  epan_dissect_t     *edt;
+  struct wtap_pkthdr  phdr;
+  Buffer              buf;
+} cached_edt_t;
+
+struct _edt_cache {
+  cached_edt_t *selected;                 /* the entry cf->edt belongs to */
+  cached_edt_t *entries[EDT_CACHE_SIZE];  /* NULL if unused */
+  guint         generation;
+  guint         clock;
+};
+
+static void
+cached_edt_free(cached_edt_t *entry)
+{
+  epan_dissect_free(entry->edt);
+  wtap_phdr_cleanup(&entry->phdr);
+  ws_buffer_free(&entry->buf);
+  g_free(entry);
+}
+
+static struct _edt_cache *
+edt_cache_get(capture_file *cf)
+{
+  if (cf->edt_cache == NULL)
+    cf->edt_cache = g_new0(struct _edt_cache, 1);
+  return cf->edt_cache;
+}
+
+/* Read and dissect a frame into a new entry. */
+static cached_edt_t *
+edt_cache_dissect(capture_file *cf, frame_data *fdata)
+{
+  cached_edt_t *entry;
+
+  entry = g_new0(cached_edt_t, 1);
+  entry->framenum = fdata->num;
+  entry->generation = edt_cache_get(cf)->generation;
+  wtap_phdr_init(&entry->phdr);
+  ws_buffer_init(&entry->buf, 1500);
+
+  if (!cf_read_record_r(cf, fdata, &entry->phdr, &entry->buf)) {
+    wtap_phdr_cleanup(&entry->phdr);
+    ws_buffer_free(&entry->buf);
+    g_free(entry);
+    return NULL;
+  }
+
+  /* Create the logical protocol tree. */
+  /* We don't need the columns here. */
+  entry->edt = epan_dissect_new(cf->epan, TRUE, TRUE);
+
+  tap_build_interesting(entry->edt);
+  epan_dissect_run(entry->edt, cf->cd_t, &entry->phdr,
+                   frame_tvbuff_new_buffer(fdata, &entry->buf), fdata, NULL);
+  return entry;
+}
+
+/* Find the entry for a frame, if it's still good. */
+static int
+edt_cache_find(struct _edt_cache *cache, guint32 framenum)
+{
+  int i;
+
+  for (i = 0; i < EDT_CACHE_SIZE; i++) {
+    if (cache->entries[i] != NULL && cache->entries[i]->framenum == framenum) {
+      if (cache->entries[i]->generation == cache->generation)
+        return i;
+      cached_edt_free(cache->entries[i]);
+      cache->entries[i] = NULL;
+    }
+  }
+  return -1;
+}
+
+/* Put an entry into the cache, pushing out the least recently used one. */
+static void
+edt_cache_put(struct _edt_cache *cache, cached_edt_t *entry)
+{
+  int i, slot = 0;
+
+  if (entry->generation != cache->generation || edt_cache_find(cache, entry->framenum) != -1) {
+    cached_edt_free(entry);
+    return;
+  }
+
+  for (i = 0; i < EDT_CACHE_SIZE; i++) {
+    if (cache->entries[i] == NULL) {
+      slot = i;
+      break;
+    }
+    if (cache->entries[i]->last_used < cache->entries[slot]->last_used)
+      slot = i;
+  }
+  if (cache->entries[slot] != NULL)
+    cached_edt_free(cache->entries[slot]);
+
+  entry->last_used = ++cache->clock;
+  cache->entries[slot] = entry;
+}
+
+/* Throw away all cached dissections but that of the selected packet. */
+static void
+edt_cache_flush(capture_file *cf)
+{
+  struct _edt_cache *cache = cf->edt_cache;
+  int i;
+
+  if (cache == NULL)
+    return;
+
+  for (i = 0; i < EDT_CACHE_SIZE; i++) {
+    if (cache->entries[i] != NULL) {
+      cached_edt_free(cache->entries[i]);
+      cache->entries[i] = NULL;
+    }
+  }
+  cache->generation++;
+}
+
+/* Free the cache; nothing may be selected. */
+static void
+edt_cache_free(capture_file *cf)
+{
+  if (cf->edt_cache == NULL)
+    return;
+
+  g_assert(cf->edt_cache->selected == NULL);
+  edt_cache_flush(cf);
+  g_free(cf->edt_cache);
+  cf->edt_cache = NULL;
+}
+
+void
+cf_invalidate_dissections(capture_file *cf)
+{
+  if (cf->edt_cache != NULL)
+    cf->edt_cache->generation++;
+}
+
+void
+cf_prefetch_packet(capture_file *cf, int row)
+{
+  struct _edt_cache *cache;
+  cached_edt_t      *entry;
+  frame_data        *fdata;
+  int                i;
+
+  /* Only once the packets have been dissected in order; before that
+     dissecting one out of turn would mess up the dissectors' state. */
+  if (cf->state != FILE_READ_DONE || cf->redissecting)
+    return;
+
+  fdata = packet_list_get_row_data(row);
+  if (fdata == NULL)
+    return;
+
+  cache = edt_cache_get(cf);
+  if (cache->selected != NULL && cache->selected->framenum == fdata->num)
+    return;
+
+  i = edt_cache_find(cache, fdata->num);
+  if (i != -1) {
+    cache->entries[i]->last_used = ++cache->clock;
+    return;
+  }
+
+  entry = edt_cache_dissect(cf, fdata);
+  if (entry != NULL)
+    edt_cache_put(cache, entry);
+}
+
 /* Select the packet on a given row. */
 void
 cf_select_packet(capture_file *cf, int row)
 {
-  epan_dissect_t *old_edt;
-  frame_data     *fdata;
+  struct _edt_cache *cache;
+  cached_edt_t      *old_entry, *entry;
+  frame_data        *fdata;
+  int                i;
 
   /* Get the frame data struct pointer for this frame */
   fdata = packet_list_get_row_data(row);
@@ -3696,21 +4776,30 @@ cf_select_packet(capture_file *cf, int row)
   cf->current_frame = fdata;
   cf->current_row = row;
 
-  old_edt = cf->edt;
-  /* Create the logical protocol tree. */
-  /* We don't need the columns here. */
-  cf->edt = epan_dissect_new(cf->epan, TRUE, TRUE);
-
-  tap_build_interesting(cf->edt);
-  epan_dissect_run(cf->edt, cf->cd_t, &cf->phdr, frame_tvbuff_new_buffer(cf->current_frame, &cf->buf),
-                   cf->current_frame, NULL);
+  /* Reuse an earlier dissection of the frame if we have one. */
+  cache = edt_cache_get(cf);
+  old_entry = cache->selected;
+  if (old_entry != NULL && old_entry->framenum == fdata->num &&
+      old_entry->generation == cache->generation) {
+    entry = old_entry;
+    old_entry = NULL;
+  } else if ((i = edt_cache_find(cache, fdata->num)) != -1) {
+    entry = cache->entries[i];
+    cache->entries[i] = NULL;
+  } else {
+    entry = edt_cache_dissect(cf, fdata);
+    if (entry == NULL)
+      return;
+  }
+  cache->selected = entry;
+  cf->edt = entry->edt;
 
   dfilter_macro_build_ftv_cache(cf->edt->tree);
 
   cf_callback_invoke(cf_cb_packet_selected, cf);
 
-  if (old_edt != NULL)
-    epan_dissect_free(old_edt);
+  if (old_entry != NULL)
+    edt_cache_put(cache, old_entry);
 
 }
 
@@ -3718,9 +4807,11 @@ cf_select_packet(capture_file *cf, int row)
 void
 cf_unselect_packet(capture_file *cf)
 {
-  epan_dissect_t *old_edt = cf->edt;
+  cached_edt_t *old_entry = cf->edt_cache ? cf->edt_cache->selected : NULL;
 
   cf->edt = NULL;
+  if (old_entry != NULL)
+    cf->edt_cache->selected = NULL;
 
   /* No packet is selected. */
   cf->current_frame = NULL;
@@ -3731,9 +4822,9 @@ cf_unselect_packet(capture_file *cf)
   /* No protocol tree means no selected field. */
   cf_unselect_field(cf);
 
-  /* Destroy the epan_dissect_t for the unselected packet. */
-  if (old_edt != NULL)
-    epan_dissect_free(old_edt);
+  /* Keep the dissection of the unselected packet around. */
+  if (old_entry != NULL)
+    edt_cache_put(cf->edt_cache, old_entry);
 }
 
 /* Unset the selected protocol tree field, if any. */
@@ -3745,6 +4836,26 @@ cf_unselect_field(capture_file *cf)
   cf_callback_invoke(cf_cb_field_unselected, cf);
 }
 
+void
+cf_frame_totals_add(frame_totals_t *totals, const frame_data *fdata)
+{
+  /* The time span starts at the first time-stamped frame, or at the
+     first frame if none has a time stamp. */
+  if (totals->count == 0 || (fdata->flags.has_ts && totals->count_ts == 0)) {
+    totals->start = fdata->abs_ts;
+    totals->stop = fdata->abs_ts;
+  }
+  totals->count++;
+  totals->bytes += fdata->pkt_len;
+  if (fdata->flags.has_ts) {
+    totals->count_ts++;
+    if (nstime_cmp(&fdata->abs_ts, &totals->start) < 0)
+      totals->start = fdata->abs_ts;
+    if (nstime_cmp(&fdata->abs_ts, &totals->stop) > 0)
+      totals->stop = fdata->abs_ts;
+  }
+}
+
 /*
  * Mark a particular frame.
  */
@@ -3753,8 +4864,10 @@ cf_mark_frame(capture_file *cf, frame_data *frame)
 {
   if (! frame->flags.marked) {
     frame->flags.marked = TRUE;
+    cf_invalidate_dissections(cf);
     if (cf->count > cf->marked_count)
       cf->marked_count++;
+    cf_frame_totals_add(&cf->marked_totals, frame);
   }
 }
 
@@ -3766,8 +4879,20 @@ cf_unmark_frame(capture_file *cf, frame_data *frame)
 {
   if (frame->flags.marked) {
     frame->flags.marked = FALSE;
+    cf_invalidate_dissections(cf);
     if (cf->marked_count > 0)
       cf->marked_count--;
+    /* The counts can be taken back, but not the time span */
+    if (cf->marked_totals.count > 0) {
+      cf->marked_totals.count--;
+      cf->marked_totals.bytes -= frame->pkt_len;
+      if (frame->flags.has_ts) {
+        cf->marked_totals.count_ts--;
+        if (nstime_cmp(&frame->abs_ts, &cf->marked_totals.start) == 0 ||
+            nstime_cmp(&frame->abs_ts, &cf->marked_totals.stop) == 0)
+          cf->marked_times_stale = TRUE;
+      }
+    }
   }
 }
 
@@ -3779,6 +4904,7 @@ cf_ignore_frame(capture_file *cf, frame_data *frame)
 {
   if (! frame->flags.ignored) {
     frame->flags.ignored = TRUE;
+    cf_invalidate_dissections(cf);
     if (cf->count > cf->ignored_count)
       cf->ignored_count++;
   }
@@ -3792,6 +4918,7 @@ cf_unignore_frame(capture_file *cf, frame_data *frame)
 {
   if (frame->flags.ignored) {
     frame->flags.ignored = FALSE;
+    cf_invalidate_dissections(cf);
     if (cf->ignored_count > 0)
       cf->ignored_count--;
   }
@@ -3884,7 +5011,7 @@ cf_get_packet_comment(capture_file *cf, const frame_data *fd)
     if (!cf_read_record_r(cf, fd, &phdr, &buf))
       { /* XXX, what we can do here? */ }
 
-    comment = phdr.opt_comment;
+    comment = g_strdup(phdr.opt_comment);
     wtap_phdr_cleanup(&phdr);
     ws_buffer_free(&buf);
     return comment;
@@ -3925,6 +5052,7 @@ cf_set_user_packet_comment(capture_file *cf, frame_data *fd, const gchar *new_co
     cf->packet_comment_count++;
 
   fd->flags.has_user_comment = TRUE;
+  cf_invalidate_dissections(cf);
 
   if (!cf->frames_user_comments)
     cf->frames_user_comments = g_tree_new_full(frame_cmp, NULL, NULL, g_free);
@@ -4094,6 +5222,173 @@ save_record(capture_file *cf, frame_data *fdata,
   return TRUE;
 }
 
+/*
+ * Exporting packets from a libpcap file to the same format needn't
+ * read and rewrite each record; we can copy the file header and then
+ * the byte ranges of the records, which are contiguous for runs of
+ * exported packets.  Only the formats known to have 16-byte record
+ * headers qualify, and only if nothing in the file has been changed.
+ */
+#define RAW_COPY_PCAP_FILE_HDR_LEN  24
+#define RAW_COPY_PCAP_REC_HDR_LEN   16
+#define RAW_COPY_BUFSIZE            (1024 * 1024)
+
+typedef struct {
+  int          in_fd;
+  int          out_fd;
+  const char  *fname;
+  int          file_type;
+  gboolean     byte_swapped;
+  gint64       run_start;   /* offset of the pending run of records */
+  gint64       run_end;     /* and of the byte after it */
+  guint8      *buf;
+} raw_copy_args_t;
+
+static gboolean
+can_copy_raw_records(capture_file *cf, guint save_format, gboolean compressed)
+{
+  if (save_format != (guint)cf->cd_t || compressed || cf->iscompressed)
+    return FALSE;
+  if (cf->cd_t != WTAP_FILE_TYPE_SUBTYPE_PCAP &&
+      cf->cd_t != WTAP_FILE_TYPE_SUBTYPE_PCAP_NSEC)
+    return FALSE;
+  return !cf->unsaved_changes;
+}
+
+/* Read exactly len bytes at offset; returns 0 or an errno */
+static int
+raw_copy_read(int fd, gint64 offset, guint8 *buf, size_t len)
+{
+  ssize_t bytes_read;
+
+  if (ws_lseek64(fd, offset, SEEK_SET) == -1)
+    return errno;
+  while (len != 0) {
+    bytes_read = ws_read(fd, buf, (unsigned int)len);
+    if (bytes_read < 0)
+      return errno;
+    if (bytes_read == 0)
+      return WTAP_ERR_SHORT_READ;
+    buf += bytes_read;
+    len -= bytes_read;
+  }
+  return 0;
+}
+
+/* Copy the pending run of records; returns 0 or an errno */
+static int
+raw_copy_flush(raw_copy_args_t *args)
+{
+  gint64  remaining = args->run_end - args->run_start;
+  size_t  len;
+  ssize_t nwritten;
+  int     err;
+
+  while (remaining != 0) {
+    len = remaining < RAW_COPY_BUFSIZE ? (size_t)remaining : RAW_COPY_BUFSIZE;
+    err = raw_copy_read(args->in_fd, args->run_end - remaining, args->buf, len);
+    if (err != 0)
+      return err;
+    nwritten = ws_write(args->out_fd, args->buf, (unsigned int)len);
+    if (nwritten < (ssize_t)len)
+      return nwritten < 0 ? errno : WTAP_ERR_SHORT_WRITE;
+    remaining -= len;
+  }
+  args->run_start = args->run_end;
+  return 0;
+}
+
+static gboolean
+copy_raw_record(capture_file *cf, frame_data *fdata,
+                struct wtap_pkthdr *phdr _U_, const guint8 *pd _U_,
+                void *argsp)
+{
+  raw_copy_args_t *args = (raw_copy_args_t *)argsp;
+  guint8           rec_hdr[RAW_COPY_PCAP_REC_HDR_LEN];
+  guint32          caplen;
+  int              err;
+
+  /* The record header tells how many bytes follow it in the file */
+  err = raw_copy_read(args->in_fd, fdata->file_off, rec_hdr, sizeof rec_hdr);
+  if (err != 0) {
+    cfile_read_failure_alert_box(cf->filename, err, NULL);
+    return FALSE;
+  }
+  memcpy(&caplen, &rec_hdr[8], sizeof caplen);
+  if (args->byte_swapped)
+    caplen = GUINT32_SWAP_LE_BE(caplen);
+
+  if (fdata->file_off != args->run_end) {
+    err = raw_copy_flush(args);
+    if (err != 0) {
+      cfile_write_failure_alert_box(NULL, args->fname, err, NULL, fdata->num,
+                                    args->file_type);
+      return FALSE;
+    }
+    args->run_start = fdata->file_off;
+  }
+  args->run_end = fdata->file_off + RAW_COPY_PCAP_REC_HDR_LEN + caplen;
+  return TRUE;
+}
+
+/*
+ * Write the records in range of cf to out_fname, which is reported as
+ * fname; only to be used if can_copy_raw_records() allowed it.
+ */
+static psp_return_t
+copy_raw_records(capture_file *cf, const char *out_fname, const char *fname,
+                 packet_range_t *range, guint save_format)
+{
+  raw_copy_args_t  args;
+  guint32          magic;
+  psp_return_t     ret;
+  int              err;
+
+  args.in_fd = ws_open(cf->filename, O_RDONLY|O_BINARY, 0000);
+  if (args.in_fd == -1) {
+    cfile_read_failure_alert_box(cf->filename, errno, NULL);
+    return PSP_FAILED;
+  }
+  args.out_fd = ws_open(out_fname, O_WRONLY|O_CREAT|O_TRUNC|O_BINARY, 0644);
+  if (args.out_fd == -1) {
+    cfile_dump_open_failure_alert_box(fname, errno, save_format);
+    ws_close(args.in_fd);
+    return PSP_FAILED;
+  }
+  args.fname = fname;
+  args.file_type = save_format;
+  args.buf = (guint8 *)g_malloc(RAW_COPY_BUFSIZE);
+
+  /* Start with the file header as the pending run */
+  args.run_start = 0;
+  args.run_end = RAW_COPY_PCAP_FILE_HDR_LEN;
+  err = raw_copy_read(args.in_fd, 0, (guint8 *)&magic, sizeof magic);
+  if (err != 0) {
+    cfile_read_failure_alert_box(cf->filename, err, NULL);
+    ret = PSP_FAILED;
+  } else {
+    args.byte_swapped = magic != 0xa1b2c3d4 && magic != 0xa1b23c4d;
+    ret = process_records(cf, range, NULL, 0, FALSE, "Writing",
+                          "specified records", TRUE, copy_raw_record, &args,
+                          TRUE);
+  }
+  if (ret == PSP_FINISHED) {
+    err = raw_copy_flush(&args);
+    if (err != 0) {
+      cfile_write_failure_alert_box(NULL, fname, err, NULL, 0, save_format);
+      ret = PSP_FAILED;
+    }
+  }
+
+  g_free(args.buf);
+  ws_close(args.in_fd);
+  if (ws_close(args.out_fd) != 0 && ret == PSP_FINISHED) {
+    cfile_close_failure_alert_box(fname, errno);
+    ret = PSP_FAILED;
+  }
+  return ret;
+}
+
 /*
  * Can this capture file be written out in any format using Wiretap
  * rather than by copying the raw data?
@@ -4244,6 +5539,10 @@ rescan_file(capture_file *cf, const char *fname, gboolean is_tempfile)
      in any case. */
   cf->filename = g_strdup(fname);
 
+  /* It's one file now, even if it was several before it was saved. */
+  g_strfreev(cf->merged_filenames);
+  cf->merged_filenames = NULL;
+
   /* Indicate whether it's a permanent or temporary file. */
   cf->is_tempfile = is_tempfile;
 
@@ -4725,6 +6024,29 @@ cf_export_specified_packets(capture_file *cf, const char *fname,
      written, don't special-case the operation - read each packet
      and then write it out if it's one of the specified ones. */
 
+  if (can_copy_raw_records(cf, save_format, compressed)) {
+    /* As below, a file that exists is replaced by a new one */
+    if (file_exists(fname))
+      fname_new = g_strdup_printf("%s~", fname);
+    switch (copy_raw_records(cf, fname_new != NULL ? fname_new : fname, fname,
+                             range, save_format)) {
+
+    case PSP_FINISHED:
+      goto written;
+
+    case PSP_STOPPED:
+      if (fname_new != NULL) {
+        ws_unlink(fname_new);
+        g_free(fname_new);
+      }
+      cf_callback_invoke(cf_cb_file_export_specified_packets_stopped, NULL);
+      return CF_WRITE_ABORTED;
+
+    case PSP_FAILED:
+      goto fail;
+    }
+  }
+
   /* XXX: what free's this shb_hdr? */
   shb_hdrs = wtap_file_get_shb_for_new_file(cf->wth);
   idb_inf = wtap_file_get_idb_info(cf->wth);
@@ -4802,6 +6124,7 @@ cf_export_specified_packets(capture_file *cf, const char *fname,
     goto fail;
   }
 
+written:
   if (fname_new != NULL) {
     /* We wrote out to fname_new, and should rename it on top of
        fname; fname is now closed, so that should be possible even
@@ -4873,7 +6196,9 @@ cf_rename_failure_alert_box(const char *filename, int err)
 void
 cf_reload(capture_file *cf) {
   gchar    *filename;
+  gchar   **merged_filenames;
   gboolean  is_tempfile;
+  cf_status_t status;
   int       err;
 
   /* If the file could be opened, "cf_open()" calls "cf_close()"
@@ -4887,9 +6212,15 @@ cf_reload(capture_file *cf) {
      Also, "cf_close()" will free "cf->filename", so we must make
      a copy of it first. */
   filename = g_strdup(cf->filename);
+  merged_filenames = g_strdupv(cf->merged_filenames);
   is_tempfile = cf->is_tempfile;
   cf->is_tempfile = FALSE;
-  if (cf_open(cf, filename, cf->open_type, is_tempfile, &err) == CF_OK) {
+  if (merged_filenames != NULL)
+    status = cf_open_files(cf, g_strv_length(merged_filenames), merged_filenames,
+                           cf->merged_append, &err);
+  else
+    status = cf_open(cf, filename, cf->open_type, is_tempfile, &err);
+  if (status == CF_OK) {
     switch (cf_read(cf, TRUE)) {
 
     case CF_READ_OK:
@@ -4905,6 +6236,7 @@ cf_reload(capture_file *cf) {
          string and return (without changing the last containing
          directory). */
       g_free(filename);
+      g_strfreev(merged_filenames);
       return;
     }
   } else {
@@ -4919,6 +6251,7 @@ cf_reload(capture_file *cf) {
   /* "cf_open()" made a copy of the file name we handed it, so
      we should free up our copy. */
   g_free(filename);
+  g_strfreev(merged_filenames);
 }
 
 /*
@@ -97,6 +97,7 @@ typedef struct {
     capture_file  *cf;
     gboolean       frame_matched;
     field_info    *finfo;
+    int            proto_id;      /* only search this protocol's items, or -1 */
 } match_data;
 
 /**
@@ -135,6 +136,20 @@ cf_callback_remove(cf_callback_t func, gpointer user_data);
  */
 cf_status_t cf_open(capture_file *cf, const char *fname, unsigned int type, gboolean is_tempfile, int *err);
 
+/**
+ * Open two or more capture files as one, without merging them into a
+ * temporary file first.  The packets are read from the files themselves.
+ *
+ * @param cf the capture file to be opened
+ * @param in_file_count the number of files to open
+ * @param in_filenames array of filenames
+ * @param do_append FALSE to merge chronologically, TRUE simply append
+ * @param err error code
+ * @return one of cf_status_t
+ */
+cf_status_t cf_open_files(capture_file *cf, int in_file_count, char *const *in_filenames,
+                          gboolean do_append, int *err);
+
 /**
  * Close a capture file.
  *
@@ -186,12 +201,18 @@ gboolean cf_read_record(capture_file *cf, frame_data *fdata);
 /**
  * Read packets from the "end" of a capture file.
  *
+ * If processing the packets takes too long, we stop early so that the UI
+ * stays responsive, and the caller should call us again for the rest.
+ *
  * @param cf the capture file to be read from
  * @param to_read the number of packets to read
+ * @param to_read_deferred set to the number of packets we left unread
+ * because we ran out of time
  * @param err the error code, if an error had occurred
  * @return one of cf_read_status_t
  */
-cf_read_status_t cf_continue_tail(capture_file *cf, volatile int to_read, int *err);
+cf_read_status_t cf_continue_tail(capture_file *cf, volatile int to_read,
+                                  int *to_read_deferred, int *err);
 
 /**
  * Fake reading packets from the "end" of a capture file.
@@ -383,6 +404,20 @@ void cf_set_rfcode(capture_file *cf, dfilter_t *rfcode);
  */
 cf_status_t cf_filter_packets(capture_file *cf, gchar *dfilter, gboolean force);
 
+/**
+ * Tell the next cf_filter_packets() that only the given frames can
+ * match its filter, e.g. the frames of a stream being followed. Frames
+ * outside the set that have already been dissected are neither read
+ * nor dissected again, so none of the tap listeners will see them.
+ * The frames must stay valid until the filter has been applied;
+ * passing NULL scans every frame again.
+ *
+ * @param cf the capture file
+ * @param frames the frame numbers, in ascending order
+ * @param count the number of frames
+ */
+void cf_set_filter_frames(capture_file *cf, const guint32 *frames, guint32 count);
+
 /**
  * At least one "Refence Time" flag has changed, rescan all packets.
  *
@@ -390,6 +425,15 @@ cf_status_t cf_filter_packets(capture_file *cf, gchar *dfilter, gboolean force);
  */
 void cf_reftime_packets(capture_file *cf);
 
+/**
+ * The "Reference Time" flag of one frame has changed; update the frames
+ * it can affect, which are those up to the next time reference frame.
+ *
+ * @param cf the capture file
+ * @param frame the frame whose flag changed
+ */
+void cf_reftime_frame_changed(capture_file *cf, frame_data *frame);
+
 /**
  * Return the time it took to load the file (in msec).
  */
@@ -410,6 +454,18 @@ void cf_redissect_packets(capture_file *cf);
  */
 cf_read_status_t cf_retap_packets(capture_file *cf);
 
+/**
+ * Run the taps on the given frames only, e.g. the frames of one stream
+ * from get_tcp_stream_frames(). The tap listeners are reset first, so
+ * this is only right when none of them cares about the other frames.
+ *
+ * @param cf the capture file
+ * @param frames the frame numbers, in ascending order; NULL retaps all packets
+ * @param count the number of frames
+ * @return one of cf_read_status_t
+ */
+cf_read_status_t cf_retap_frames(capture_file *cf, const guint32 *frames, guint32 count);
+
 /**
  * Adjust timestamp precision if auto is selected.
  *
@@ -509,6 +565,20 @@ cf_print_status_t cf_write_json_packets(capture_file *cf, print_args_t *print_ar
 gboolean cf_find_packet_protocol_tree(capture_file *cf, const char *string,
                                       search_direction dir);
 
+/**
+ * Find packet with an item of a given protocol that contains a specified
+ * text string.  Frames the protocol index knows to lack the protocol are
+ * skipped without being read or dissected.
+ *
+ * @param cf the capture file
+ * @param string the string to find
+ * @param proto_id the protocol whose items to search, or -1 for all
+ * @param dir direction in which to search
+ * @return TRUE if a packet was found, FALSE otherwise
+ */
+gboolean cf_find_packet_protocol_fields(capture_file *cf, const char *string,
+                                        int proto_id, search_direction dir);
+
 /**
  * Find field with a label that contains text string cfile->sfilter.
  *
@@ -611,6 +681,23 @@ gboolean cf_goto_framenum(capture_file *cf);
  */
 void cf_select_packet(capture_file *cf, int row);
 
+/**
+ * Dissect the packet in the given row ahead of time, so that selecting
+ * it later is quick.
+ *
+ * @param cf the capture file
+ * @param row the row to prefetch
+ */
+void cf_prefetch_packet(capture_file *cf, int row);
+
+/**
+ * Forget the dissections kept around for selecting packets again, as
+ * something that changes how the packets dissect has changed.
+ *
+ * @param cf the capture file
+ */
+void cf_invalidate_dissections(capture_file *cf);
+
 /**
  * Unselect all packets, if any.
  *
@@ -625,6 +712,14 @@ void cf_unselect_packet(capture_file *cf);
  */
 void cf_unselect_field(capture_file *cf);
 
+/**
+ * Add a frame to a set of running totals.
+ *
+ * @param totals the totals, all zero for an empty set
+ * @param fdata the frame to add
+ */
+void cf_frame_totals_add(frame_totals_t *totals, const frame_data *fdata);
+
 /**
  * Mark a particular frame in a particular capture.
  *
@@ -33,10 +33,23 @@
 
 #include "wiretap/wtap-int.h" /* for ->random_fh */
 
+/*
+ * Packet data read back from the file for the frame tvbuffs that don't
+ * have it, shared by all the tvbuffs for the same record (the top-level
+ * one, its clones, and any other tvbuff created for that frame while
+ * they are alive) so that the record is read only once.
+ */
+typedef struct {
+	guint refcount;
+	wtap *wth;           /**< Wiretap session */
+	gint64 file_off;     /**< File offset, key in frame_buffers */
+	Buffer buf;          /**< Packet data */
+} frame_buffer_t;
+
 struct tvb_frame {
 	struct tvbuff tvb;
 
-	Buffer *buf;         /* Packet data */
+	frame_buffer_t *fbuf; /* Packet data, if read */
 
 	wtap *wth;           /**< Wiretap session */
 	gint64 file_off;     /**< File offset */
@@ -45,19 +58,19 @@ struct tvb_frame {
 };
 
 static gboolean
-frame_read(struct tvb_frame *frame_tvb, struct wtap_pkthdr *phdr, Buffer *buf)
+frame_read(wtap *wth, gint64 file_off, struct wtap_pkthdr *phdr, Buffer *buf)
 {
 	int    err;
 	gchar *err_info;
 
 	/* sanity check, capture file was closed? */
-	if (cfile.wth != frame_tvb->wth)
+	if (cfile.wth != wth)
 		return FALSE;
 
 	/* XXX, what if phdr->caplen isn't equal to
 	 * frame_tvb->tvb.length + frame_tvb->offset?
 	 */
-	if (!wtap_seek_read(frame_tvb->wth, frame_tvb->file_off, phdr, buf, &err, &err_info)) {
+	if (!wtap_seek_read(wth, file_off, phdr, buf, &err, &err_info)) {
 		/* XXX - report error! */
 		switch (err) {
 			case WTAP_ERR_BAD_FILE:
@@ -69,33 +82,78 @@ frame_read(struct tvb_frame *frame_tvb, struct wtap_pkthdr *phdr, Buffer *buf)
 	return TRUE;
 }
 
+/* The frame buffers in use, by file offset */
+static GHashTable *frame_buffers = NULL;
+
+/* Unused frame buffers, kept with their memory for reuse */
+#define FRAME_BUFFER_CACHE_MAX 64
 static GPtrArray *buffer_cache = NULL;
 
-static void
-frame_cache(struct tvb_frame *frame_tvb)
+static frame_buffer_t *
+frame_buffer_get(wtap *wth, gint64 file_off, guint length)
 {
+	frame_buffer_t *fbuf;
 	struct wtap_pkthdr phdr; /* Packet header */
 
+	if (G_UNLIKELY(!frame_buffers)) {
+		frame_buffers = g_hash_table_new(g_int64_hash, g_int64_equal);
+		buffer_cache = g_ptr_array_sized_new(FRAME_BUFFER_CACHE_MAX);
+	}
+
+	fbuf = (frame_buffer_t *) g_hash_table_lookup(frame_buffers, &file_off);
+	if (fbuf != NULL && fbuf->wth == wth) {
+		fbuf->refcount++;
+		return fbuf;
+	}
+
+	if (buffer_cache->len > 0) {
+		fbuf = (frame_buffer_t *) g_ptr_array_remove_index(buffer_cache, buffer_cache->len - 1);
+		ws_buffer_clean(&fbuf->buf);
+	} else {
+		fbuf = g_new(frame_buffer_t, 1);
+		ws_buffer_init(&fbuf->buf, length);
+	}
+	fbuf->refcount = 1;
+	fbuf->wth = wth;
+	fbuf->file_off = file_off;
+
 	wtap_phdr_init(&phdr);
+	if (!frame_read(wth, file_off, &phdr, &fbuf->buf)) {
+		/* TODO: THROW(???); */
+	} else if (!g_hash_table_lookup(frame_buffers, &fbuf->file_off)) {
+		/* Only share what we could read. */
+		g_hash_table_insert(frame_buffers, &fbuf->file_off, fbuf);
+	}
+	wtap_phdr_cleanup(&phdr);
 
-	if (frame_tvb->buf == NULL) {
-		if G_UNLIKELY(!buffer_cache) buffer_cache = g_ptr_array_sized_new(1024);
+	return fbuf;
+}
 
-		if (buffer_cache->len > 0) {
-			frame_tvb->buf = (struct Buffer *) g_ptr_array_remove_index(buffer_cache, buffer_cache->len - 1);
-		} else {
-			frame_tvb->buf = (struct Buffer *) g_malloc(sizeof(struct Buffer));
-		}
+static void
+frame_buffer_unref(frame_buffer_t *fbuf)
+{
+	if (--fbuf->refcount > 0)
+		return;
 
-		ws_buffer_init(frame_tvb->buf, frame_tvb->tvb.length + frame_tvb->offset);
+	if (g_hash_table_lookup(frame_buffers, &fbuf->file_off) == fbuf)
+		g_hash_table_remove(frame_buffers, &fbuf->file_off);
 
-		if (!frame_read(frame_tvb, &phdr, frame_tvb->buf))
-			{ /* TODO: THROW(???); */ }
+	if (buffer_cache->len < FRAME_BUFFER_CACHE_MAX) {
+		g_ptr_array_add(buffer_cache, fbuf);
+	} else {
+		ws_buffer_free(&fbuf->buf);
+		g_free(fbuf);
 	}
+}
 
-	frame_tvb->tvb.real_data = ws_buffer_start_ptr(frame_tvb->buf) + frame_tvb->offset;
+static void
+frame_cache(struct tvb_frame *frame_tvb)
+{
+	if (frame_tvb->fbuf == NULL)
+		frame_tvb->fbuf = frame_buffer_get(frame_tvb->wth, frame_tvb->file_off,
+						   frame_tvb->tvb.length + frame_tvb->offset);
 
-	wtap_phdr_cleanup(&phdr);
+	frame_tvb->tvb.real_data = ws_buffer_start_ptr(&frame_tvb->fbuf->buf) + frame_tvb->offset;
 }
 
 static void
@@ -103,10 +161,8 @@ frame_free(tvbuff_t *tvb)
 {
 	struct tvb_frame *frame_tvb = (struct tvb_frame *) tvb;
 
-	if (frame_tvb->buf) {
-		ws_buffer_free(frame_tvb->buf);
-		g_ptr_array_add(buffer_cache, frame_tvb->buf);
-	}
+	if (frame_tvb->fbuf)
+		frame_buffer_unref(frame_tvb->fbuf);
 }
 
 static const guint8 *
@@ -173,6 +229,7 @@ static const struct tvb_ops tvb_frame_ops = {
 	frame_find_guint8,    /* find_guint8 */
 	frame_pbrk_guint8,    /* pbrk_guint8 */
 	frame_clone,          /* clone */
+	NULL,                 /* get_segments */
 };
 
 /* based on tvb_new_real_data() */
@@ -231,7 +288,7 @@ frame_tvbuff_new(const frame_data *fd, const guint8 *buf)
 	} else
 		frame_tvb->wth = NULL;
 
-	frame_tvb->buf = NULL;
+	frame_tvb->fbuf = NULL;
 
 	return tvb;
 }
@@ -274,7 +331,11 @@ frame_clone(tvbuff_t *tvb, guint abs_offset, guint abs_length)
 	cloned_frame_tvb->wth = frame_tvb->wth;
 	cloned_frame_tvb->file_off = frame_tvb->file_off;
 	cloned_frame_tvb->offset = abs_offset;
-	cloned_frame_tvb->buf = NULL;
+
+	/* Share the data if we've already read it. */
+	cloned_frame_tvb->fbuf = frame_tvb->fbuf;
+	if (cloned_frame_tvb->fbuf)
+		cloned_frame_tvb->fbuf->refcount++;
 
 	return cloned_tvb;
 }
@@ -336,7 +397,7 @@ file_tvbuff_new(const frame_data *fd, const guint8 *buf)
 	} else
 		frame_tvb->wth = NULL;
 
-	frame_tvb->buf = NULL;
+	frame_tvb->fbuf = NULL;
 
 	return tvb;
 }
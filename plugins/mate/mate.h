@@ -118,6 +118,11 @@ typedef struct _mate_cfg_pdu {
 	avpl_match_mode criterium_match_mode;
 	accept_mode_t criterium_accept_mode;
 	AVPL* criterium;
+
+	/* profiling, kept while the debug level is 1 or more */
+	guint64 prof_pdus; /* pdus extracted */
+	double prof_extract_time; /* seconds spent extracting them */
+	double prof_match_time; /* seconds spent assigning them to gops and gogs */
 } mate_cfg_pdu;
 
 
@@ -157,6 +162,10 @@ typedef struct _mate_cfg_gop {
 
 	GHashTable* gop_index;
 	GHashTable* gog_index;
+
+	/* profiling, kept while the debug level is 1 or more */
+	guint64 prof_gops; /* times one of its gops was grouped */
+	double prof_group_time; /* seconds spent grouping them into gogs */
 } mate_cfg_gop;
 
 
@@ -270,6 +279,7 @@ typedef struct _mate_runtime_data {
 
 	GHashTable* frames; /* k=frame.num v=pdus */
 
+	GTimer* prof_timer; /* NULL unless profiling */
 } mate_runtime_data;
 
 typedef struct _mate_pdu mate_pdu;
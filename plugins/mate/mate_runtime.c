@@ -130,6 +130,37 @@ static void destroy_gogs_in_cfg(gpointer k _U_, gpointer v, gpointer p _U_) {
 	c->last_id = 0;
 }
 
+/* where the time went since the runtime was last initialized */
+static void report_gop_profile(gpointer k _U_, gpointer v, gpointer p _U_) {
+	mate_cfg_gop* c = (mate_cfg_gop *)v;
+
+	if (c->prof_gops)
+		dbg_print(dbg, 1, dbg_facility, "profile: Gop %s: grouped %" G_GINT64_MODIFIER "u times in %.6fs",
+			  c->name, c->prof_gops, c->prof_group_time);
+
+	c->prof_gops = 0;
+	c->prof_group_time = 0.0;
+}
+
+static void report_mate_profile(mate_config* mc) {
+	mate_cfg_pdu* c;
+	guint i;
+
+	for (i = 0; i < mc->pducfglist->len; i++) {
+		c = (mate_cfg_pdu *)g_ptr_array_index(mc->pducfglist,i);
+
+		if (c->prof_pdus)
+			dbg_print(dbg, 1, dbg_facility, "profile: Pdu %s: %" G_GINT64_MODIFIER "u pdus extracted in %.6fs, assigned in %.6fs",
+				  c->name, c->prof_pdus, c->prof_extract_time, c->prof_match_time);
+
+		c->prof_pdus = 0;
+		c->prof_extract_time = 0.0;
+		c->prof_match_time = 0.0;
+	}
+
+	g_hash_table_foreach(mc->gopcfgs,report_gop_profile,NULL);
+}
+
 void initialize_mate_runtime(mate_config* mc) {
 
 	dbg_print (dbg,5,dbg_facility,"initialize_mate: entering");
@@ -137,7 +168,11 @@ void initialize_mate_runtime(mate_config* mc) {
 	if (mc) {
 		if (rd == NULL ) {
 			rd = (mate_runtime_data *)g_malloc(sizeof(mate_runtime_data));
+			rd->prof_timer = NULL;
 		} else {
+			if (rd->prof_timer)
+				report_mate_profile(mc);
+
 			g_hash_table_foreach(mc->pducfgs,destroy_pdus_in_cfg,NULL);
 			g_hash_table_foreach(mc->gopcfgs,destroy_gops_in_cfg,NULL);
 			g_hash_table_foreach(mc->gogcfgs,destroy_gogs_in_cfg,NULL);
@@ -160,6 +195,10 @@ void initialize_mate_runtime(mate_config* mc) {
 		dbg = &(mc->dbg_lvl);
 		dbg_facility = mc->dbg_facility;
 
+		/* time each Pdu and Gop when debugging */
+		if (mc->dbg_lvl > 0 && ! rd->prof_timer)
+			rd->prof_timer = g_timer_new();
+
 		dbg_print(dbg, 1, dbg_facility, "starting mate");
 
 	} else {
@@ -477,6 +516,7 @@ static void analyze_pdu(mate_config* mc, mate_pdu* pdu) {
 	void* cookie = NULL;
 	AVPL* gogkey_match = NULL;
 	gchar* gogkey_str = NULL;
+	double prof_start = 0.0;
 
 	dbg_print (dbg_gop,1,dbg_facility,"analyze_pdu: %s",pdu->cfg->name);
 
@@ -641,12 +681,19 @@ static void analyze_pdu(mate_config* mc, mate_pdu* pdu) {
 
 		gop->last_n = gop->avpl->len;
 
+		if (rd->prof_timer) prof_start = g_timer_elapsed(rd->prof_timer,NULL);
+
 		if (gop->gog) {
 			reanalyze_gop(mc, gop);
 		} else {
 			analyze_gop(mc, gop);
 		}
 
+		if (rd->prof_timer) {
+			cfg->prof_gops++;
+			cfg->prof_group_time += g_timer_elapsed(rd->prof_timer,NULL) - prof_start;
+		}
+
 	} else {
 		dbg_print (dbg_gop,4,dbg_facility,"analyze_pdu: no match for this pdu");
 
@@ -838,6 +885,7 @@ extern void mate_analyze_frame(mate_config *mc, packet_info *pinfo, proto_tree*
 	field_info* proto;
 	guint i,j;
 	AVPL* criterium_match;
+	double prof_start = 0.0;
 
 	mate_pdu* pdu = NULL;
 	mate_pdu* last = NULL;
@@ -861,8 +909,16 @@ extern void mate_analyze_frame(mate_config *mc, packet_info *pinfo, proto_tree*
 					dbg_print (dbg_pdu,3,dbg_facility,"mate_analyze_frame: found matching proto, extracting: %s",cfg->name);
 
 					proto = (field_info*) g_ptr_array_index(protos,j);
+
+					if (rd->prof_timer) prof_start = g_timer_elapsed(rd->prof_timer,NULL);
+
 					pdu = new_pdu(cfg, pinfo->num, proto, tree);
 
+					if (rd->prof_timer) {
+						cfg->prof_pdus++;
+						cfg->prof_extract_time += g_timer_elapsed(rd->prof_timer,NULL) - prof_start;
+					}
+
 					if (cfg->criterium) {
 						criterium_match = new_avpl_from_match(cfg->criterium_match_mode,"",pdu->avpl,cfg->criterium,FALSE);
 
@@ -881,8 +937,12 @@ extern void mate_analyze_frame(mate_config *mc, packet_info *pinfo, proto_tree*
 						}
 					}
 
+					if (rd->prof_timer) prof_start = g_timer_elapsed(rd->prof_timer,NULL);
+
 					analyze_pdu(mc, pdu);
 
+					if (rd->prof_timer) cfg->prof_match_time += g_timer_elapsed(rd->prof_timer,NULL) - prof_start;
+
 					if ( ! pdu->gop && cfg->drop_unassigned) {
 						delete_avpl(pdu->avpl,TRUE);
 						g_slice_free(mate_max_size,(mate_max_size*)pdu);
@@ -65,6 +65,10 @@ extern mate_cfg_pdu* new_pducfg(mate_config* mc, gchar* name) {
 	cfg->criterium_match_mode = AVPL_NO_MATCH;
 	cfg->criterium_accept_mode = ACCEPT_MODE;
 
+	cfg->prof_pdus = 0;
+	cfg->prof_extract_time = 0.0;
+	cfg->prof_match_time = 0.0;
+
 	g_ptr_array_add(mc->pducfglist,(gpointer) cfg);
 	g_hash_table_insert(mc->pducfgs,(gpointer) cfg->name,(gpointer) cfg);
 
@@ -103,6 +107,9 @@ extern mate_cfg_gop* new_gopcfg(mate_config* mc, gchar* name) {
 	cfg->gop_index = g_hash_table_new(g_str_hash,g_str_equal);
 	cfg->gog_index = g_hash_table_new(g_str_hash,g_str_equal);
 
+	cfg->prof_gops = 0;
+	cfg->prof_group_time = 0.0;
+
 	g_hash_table_insert(mc->gopcfgs,(gpointer) cfg->name, (gpointer) cfg);
 
 	return cfg;
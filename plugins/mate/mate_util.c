@@ -234,6 +234,11 @@ typedef union _any_avp_type {
 
 static SCS_collection* avp_strings = NULL;
 
+/* AVP names and values all come from avp_strings, so equal strings are
+ * the same pointer and a comparison only has to look at the characters
+ * to find out the order of two different ones. */
+#define avp_strcmp(a,b) ((a) == (b) ? 0 : strcmp((a),(b)))
+
 #ifdef _AVP_DEBUGGING
 static FILE* dbg_fp = NULL;
 
@@ -482,10 +487,10 @@ extern gboolean insert_avp(AVPL* avpl, AVP* avp) {
 
 	/* get to the insertion point */
 	for (c=avpl->null.next; c->avp; c = c->next) {
-		int name_diff = strcmp(avp->n, c->avp->n);
+		int name_diff = avp_strcmp(avp->n, c->avp->n);
 
 		if (name_diff == 0) {
-			int value_diff = strcmp(avp->v, c->avp->v);
+			int value_diff = avp_strcmp(avp->v, c->avp->v);
 
 			if (value_diff < 0) {
 				break;
@@ -753,13 +758,15 @@ extern AVP* get_next_avp(AVPL* avpl, void** cookie) {
 gchar* avpl_to_str(AVPL* avpl) {
 	AVPN* c;
 	GString* s = g_string_new("");
-	gchar* avp_s;
 	gchar* r;
 
+	/* this builds every Gop and Gog key, so don't format each avp apart */
 	for(c=avpl->null.next; c->avp; c = c->next) {
-		avp_s = avp_to_str(c->avp);
-		g_string_append_printf(s," %s;",avp_s);
-		g_free(avp_s);
+		g_string_append_c(s,' ');
+		g_string_append(s,c->avp->n);
+		g_string_append_c(s,c->avp->o);
+		g_string_append(s,c->avp->v);
+		g_string_append_c(s,';');
 	}
 
 	r = g_string_free(s,FALSE);
@@ -808,7 +815,7 @@ extern void merge_avpl(AVPL* dst, AVPL* src, gboolean copy_avps) {
 
 	while (cs->avp && cd->avp) {
 
-		int name_diff = strcmp(cd->avp->n, cs->avp->n);
+		int name_diff = avp_strcmp(cd->avp->n, cs->avp->n);
 
 		if (name_diff < 0) {
 			// dest < source, advance dest to find a better place to insert
@@ -819,7 +826,7 @@ extern void merge_avpl(AVPL* dst, AVPL* src, gboolean copy_avps) {
 			cs = cs->next;
 		} else {
 			// attribute names are equal. Ignore duplicate values but ensure that other values are sorted.
-			int value_diff = strcmp(cd->avp->v, cs->avp->v);
+			int value_diff = avp_strcmp(cd->avp->v, cs->avp->v);
 
 			if (value_diff < 0) {
 				// dest < source, do not insert it yet
@@ -1009,7 +1016,7 @@ extern AVPL* new_avpl_loose_match(const gchar* name,
 	cs = src->null.next;
 	co = op->null.next;
 	while (cs->avp && co->avp) {
-		int name_diff = strcmp(co->avp->n, cs->avp->n);
+		int name_diff = avp_strcmp(co->avp->n, cs->avp->n);
 
 		if (name_diff < 0) {
 			// op < source, op is not matching
@@ -1070,7 +1077,7 @@ extern AVPL* new_avpl_pairs_match(const gchar* name, AVPL* src, AVPL* op, gboole
 	cs = src->null.next;
 	co = op->null.next;
 	while (cs->avp && co->avp) {
-		int name_diff = strcmp(co->avp->n, cs->avp->n);
+		int name_diff = avp_strcmp(co->avp->n, cs->avp->n);
 		const gchar *failed_match = NULL;
 
 		if (name_diff < 0) {
@@ -121,9 +121,17 @@ guint32 rrpd_suffix = 0;
 #endif
 
 /*
-    The rrpd_list holds information about all of the APDU Request-Response Pairs seen in the trace.
+    The rrpd_streams map holds information about the APDU Request-Response Pairs seen in the trace.  The key
+    is the ip_proto:stream_no pair (see rrpd_stream_key) and the value is a list of the RRPDs for that stream
+    in the order they were created, so matching a packet only has to look at the RRPDs of its own stream.
+
+    An RRPD whose last packet is more than RRPD_EXPIRY_SECS older than the start of a new RRPD on the same
+    stream is dropped from its list (but not freed, as output_rrpd still points to it), so that the lists
+    of long-lived streams in day-long captures don't keep growing.
  */
-static wmem_list_t *rrpd_list = NULL;
+static wmem_map_t *rrpd_streams = NULL;
+
+#define RRPD_EXPIRY_SECS 300
 
 /*
     output_rrpd is a hash of pointers to RRPDs on the rrpd_list.  The index is the frame number.  This hash is
@@ -139,7 +147,7 @@ static wmem_map_t *output_rrpd;
     TCP Reassembly enabled.  Once we receive a header packet for an APDU we migrate the entry from this array to the
     main rrpd_list.
  */
-static wmem_list_t *temp_rsp_rrpd_list = NULL;  /* Reuse these for speed and efficient memory use - issue a warning if we run out */
+static wmem_map_t *temp_rsp_rrpd_list = NULL;  /* At most one entry per ip_proto:stream_no, keyed like rrpd_streams */
 
 static gint ett_transum = -1;
 static gint ett_transum_header = -1;
@@ -229,10 +237,50 @@ static void update_output_rrpd(RRPD *in_rrpd)
         wmem_map_insert(output_rrpd, GUINT_TO_POINTER(in_rrpd->rsp_last_frame), in_rrpd);
 }
 
+static guint64 rrpd_stream_key(RRPD *in_rrpd)
+{
+    return ((guint64)in_rrpd->ip_proto << 32) | in_rrpd->stream_no;
+}
+
+/* Return the list of RRPDs for the stream of in_rrpd, optionally creating it */
+static wmem_list_t *get_rrpd_stream_list(RRPD *in_rrpd, gboolean create)
+{
+    guint64 key = rrpd_stream_key(in_rrpd);
+    wmem_list_t *stream_list = (wmem_list_t*)wmem_map_lookup(rrpd_streams, &key);
+
+    if (stream_list == NULL && create)
+    {
+        stream_list = wmem_list_new(wmem_file_scope());
+        wmem_map_insert(rrpd_streams, wmem_memdup(wmem_file_scope(), &key, sizeof(key)), stream_list);
+    }
+
+    return stream_list;
+}
+
+/* Drop the RRPDs that have been idle for too long from the front of a stream's list */
+static void expire_rrpd_stream_list(wmem_list_t *stream_list, nstime_t *now)
+{
+    wmem_list_frame_t *i;
+    RRPD *rrpd;
+    nstime_t *last;
+
+    while ((i = wmem_list_head(stream_list)) != NULL)
+    {
+        rrpd = (RRPD*)wmem_list_frame_data(i);
+
+        last = nstime_cmp(&rrpd->rsp_last_rtime, &rrpd->req_last_rtime) > 0 ? &rrpd->rsp_last_rtime : &rrpd->req_last_rtime;
+        if (nstime_to_sec(now) - nstime_to_sec(last) <= RRPD_EXPIRY_SECS)
+            break;
+
+        wmem_list_remove_frame(stream_list, i);
+    }
+}
+
 /* Return the index of the RRPD that has been appended */
 static RRPD* append_to_rrpd_list(RRPD *in_rrpd)
 {
     RRPD *next_rrpd = (RRPD*)wmem_memdup(wmem_file_scope(), in_rrpd, sizeof(RRPD));
+    wmem_list_t *stream_list;
 
     if (preferences.reassembly)
     {
@@ -251,13 +299,15 @@ static RRPD* append_to_rrpd_list(RRPD *in_rrpd)
 
     update_output_rrpd(next_rrpd);
 
-    wmem_list_append(rrpd_list, next_rrpd);
+    stream_list = get_rrpd_stream_list(next_rrpd, TRUE);
+    expire_rrpd_stream_list(stream_list, &next_rrpd->req_first_rtime);
+    wmem_list_append(stream_list, next_rrpd);
 
     return next_rrpd;
 }
 
 /*
-This function finds the latest entry in the rrpd_list that matches the
+This function finds the latest entry in the rrpd_streams lists that matches the
 ip_proto, stream_no, session_id, msg_id and suffix values.
 
 An input state value of 0 means that we don't care about state.
@@ -268,37 +318,30 @@ static RRPD *find_latest_rrpd(RRPD *in_rrpd, int state)
 {
     RRPD *rrpd_index = NULL, *rrpd;
     wmem_list_frame_t* i;
+    wmem_list_t *stream_list = get_rrpd_stream_list(in_rrpd, FALSE);
+
+    if (stream_list == NULL)
+        return NULL;
 
-    for (i = wmem_list_tail(rrpd_list); i != NULL; i = wmem_list_frame_prev(i))
+    for (i = wmem_list_tail(stream_list); i != NULL; i = wmem_list_frame_prev(i))
     {
         rrpd = (RRPD*)wmem_list_frame_data(i);
-        if (rrpd->ip_proto == in_rrpd->ip_proto && rrpd->stream_no == in_rrpd->stream_no)
+        /* every entry on the list is for this ip_proto and stream_no */
+        if (in_rrpd->decode_based)
         {
-            if (in_rrpd->decode_based)
+            /* If this is decode-based and we are checking for entries in RRPD_STATE_1 we need to match on ip_proto and stream_no alone. */
+            if (state == RRPD_STATE_1)
             {
-                /* If this is decode-based and we are checking for entries in RRPD_STATE_1 we need to match on ip_proto and stream_no alone. */
-                if (state == RRPD_STATE_1)
-                {
-                    if (rrpd->session_id == 0 && rrpd->msg_id == 0 && rrpd->suffix == 1)
-                    {
-                        rrpd_index = rrpd;
-                        break;
-                    }
-                }
-
-                /* if this stream is decode_based we need to take into account the session_id, msg_id and suffix */
-                if (rrpd->session_id == in_rrpd->session_id && rrpd->msg_id == in_rrpd->msg_id && rrpd->suffix == in_rrpd->suffix)
+                if (rrpd->session_id == 0 && rrpd->msg_id == 0 && rrpd->suffix == 1)
                 {
-                    if (state == RRPD_STATE_DONT_CARE || rrpd->state == state)
-                    {
-                        rrpd_index = rrpd;
-                        break;
-                    }
+                    rrpd_index = rrpd;
+                    break;
                 }
             }
-            else
+
+            /* if this stream is decode_based we need to take into account the session_id, msg_id and suffix */
+            if (rrpd->session_id == in_rrpd->session_id && rrpd->msg_id == in_rrpd->msg_id && rrpd->suffix == in_rrpd->suffix)
             {
-                /* if this stream is not decode_based we don't need to take into account the session_id, msg_id and suffix */
                 if (state == RRPD_STATE_DONT_CARE || rrpd->state == state)
                 {
                     rrpd_index = rrpd;
@@ -306,6 +349,15 @@ static RRPD *find_latest_rrpd(RRPD *in_rrpd, int state)
                 }
             }
         }
+        else
+        {
+            /* if this stream is not decode_based we don't need to take into account the session_id, msg_id and suffix */
+            if (state == RRPD_STATE_DONT_CARE || rrpd->state == state)
+            {
+                rrpd_index = rrpd;
+                break;
+            }
+        }
     }
     return rrpd_index;
 }
@@ -545,25 +597,18 @@ static void update_rrpd_list_entry_req(RRPD *in_rrpd)
 static RRPD* insert_into_temp_rsp_rrpd_list(RRPD *in_rrpd)
 {
     RRPD *rrpd = (RRPD*)wmem_memdup(wmem_file_scope(), in_rrpd, sizeof(RRPD));
+    guint64 key = rrpd_stream_key(in_rrpd);
 
-    wmem_list_append(temp_rsp_rrpd_list, rrpd);
+    wmem_map_insert(temp_rsp_rrpd_list, wmem_memdup(wmem_file_scope(), &key, sizeof(key)), rrpd);
 
     return rrpd;
 }
 
 static RRPD* find_temp_rsp_rrpd(RRPD *in_rrpd)
 {
-    wmem_list_frame_t *i;
-    RRPD* rrpd;
+    guint64 key = rrpd_stream_key(in_rrpd);
 
-    for (i = wmem_list_head(temp_rsp_rrpd_list); i; i = wmem_list_frame_next(i))
-    {
-        rrpd = (RRPD*)wmem_list_frame_data(i);
-        if (rrpd->ip_proto == in_rrpd->ip_proto && rrpd->stream_no == in_rrpd->stream_no)
-            return rrpd;
-    }
-
-    return NULL;
+    return (RRPD*)wmem_map_lookup(temp_rsp_rrpd_list, &key);
 }
 
 static void update_temp_rsp_rrpd(RRPD *temp_list, RRPD *in_rrpd)
@@ -577,7 +622,10 @@ static void migrate_temp_rsp_rrpd(RRPD *main_list, RRPD *temp_list)
 {
     update_rrpd_list_entry(main_list, temp_list);
 
-    wmem_list_remove(temp_rsp_rrpd_list, temp_list);
+    {
+        guint64 key = rrpd_stream_key(temp_list);
+        wmem_map_remove(temp_rsp_rrpd_list, &key);
+    }
 
     /* Update the state to 7 or 8 based on reassembly */
     if (preferences.reassembly)
@@ -698,8 +746,8 @@ static void init_globals(void)
 
     /* Create and initialise some dynamic memory areas */
     detected_tcp_svc = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
-    rrpd_list = wmem_list_new(wmem_file_scope());
-    temp_rsp_rrpd_list = wmem_list_new(wmem_file_scope());
+    rrpd_streams = wmem_map_new(wmem_file_scope(), g_int64_hash, g_int64_equal);
+    temp_rsp_rrpd_list = wmem_map_new(wmem_file_scope(), g_int64_hash, g_int64_equal);
 
     /* Indicate what fields we're interested in. */
     GArray *wanted_fields = g_array_sized_new(FALSE, FALSE, (guint)sizeof(int), HF_INTEREST_END_OF_LIST);
@@ -1499,6 +1499,7 @@ raw_epan_new(capture_file *cf)
 
     epan->data = cf;
     epan->get_frame_ts = raw_get_frame_ts;
+    epan->get_frame_shift_offset = NULL;
     epan->get_interface_name = cap_file_get_interface_name;
     epan->get_interface_description = cap_file_get_interface_description;
     epan->get_user_comment = NULL;
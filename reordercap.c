@@ -33,11 +33,13 @@
 #endif
 
 #include <wiretap/wtap.h>
+#include <wiretap/merge.h>
 
 #ifndef HAVE_GETOPT_LONG
 #include "wsutil/wsgetopt.h"
 #endif
 
+#include <wsutil/clopts_common.h>
 #include <wsutil/cmdarg_err.h>
 #include <wsutil/crash_info.h>
 #include <wsutil/filesystem.h>
@@ -67,6 +69,8 @@ print_usage(FILE *output)
     fprintf(output, "\n");
     fprintf(output, "Options:\n");
     fprintf(output, "  -n        don't write to output file if the input file is ordered.\n");
+    fprintf(output, "  -m <MB>   sort in runs of at most <MB> megabytes of frames, kept in\n");
+    fprintf(output, "            temporary files and merged, instead of rereading the input.\n");
     fprintf(output, "  -h        display this help and exit.\n");
 }
 
@@ -148,6 +152,324 @@ frames_compare(gconstpointer a, gconstpointer b)
     return nstime_cmp(time1, time2);
 }
 
+/*
+ * External sort.
+ *
+ * Rather than remembering where every frame is and rereading them in
+ * order, which needs the whole index in memory and reads the input all
+ * over the place, frames are read once into a heap holding at most
+ * memory_budget bytes of them.  Whenever the heap is full its earliest
+ * frame is written to the current run, a temporary file; a frame read
+ * later that is earlier than the last one written can't go into the
+ * current run and is held for the next one.  The runs are then merged,
+ * reading each of them sequentially.
+ *
+ * A file that is already in order, or whose frames are never further
+ * out of place than fits in the budget, comes out as a single run.
+ */
+typedef struct HeldFrame_t {
+    guint               run;
+    guint               num;
+    nstime_t            frame_time;
+    struct wtap_pkthdr  phdr;
+    guint8             *data;
+} HeldFrame_t;
+
+typedef struct ExternalSort_t {
+    wtap        *wth;
+    const char  *infile;
+    GPtrArray   *heap;          /* HeldFrame_t *s, earliest first */
+    gsize        held_bytes;
+    GPtrArray   *run_names;
+    wtap_dumper *run_pdh;       /* run being written, or NULL */
+    guint        run;
+    nstime_t     last_time;     /* time of the last frame in the run */
+} ExternalSort_t;
+
+static gboolean
+held_frame_is_before(const HeldFrame_t *frame1, const HeldFrame_t *frame2)
+{
+    int cmp;
+
+    if (frame1->run != frame2->run)
+        return frame1->run < frame2->run;
+    cmp = nstime_cmp(&frame1->frame_time, &frame2->frame_time);
+    if (cmp != 0)
+        return cmp < 0;
+    /* Keep frames with the same time stamp in file order */
+    return frame1->num < frame2->num;
+}
+
+static void
+held_frame_push(GPtrArray *heap, HeldFrame_t *frame)
+{
+    guint i, parent;
+
+    g_ptr_array_add(heap, frame);
+    for (i = heap->len - 1; i > 0; i = parent) {
+        parent = (i - 1) / 2;
+        if (!held_frame_is_before(frame, (HeldFrame_t *)heap->pdata[parent]))
+            break;
+        heap->pdata[i] = heap->pdata[parent];
+    }
+    heap->pdata[i] = frame;
+}
+
+static HeldFrame_t *
+held_frame_pop(GPtrArray *heap)
+{
+    HeldFrame_t *top, *last;
+    guint i, child;
+
+    top = (HeldFrame_t *)heap->pdata[0];
+    last = (HeldFrame_t *)g_ptr_array_remove_index(heap, heap->len - 1);
+    if (heap->len == 0)
+        return top;
+
+    for (i = 0; (child = 2 * i + 1) < heap->len; i = child) {
+        if (child + 1 < heap->len &&
+            held_frame_is_before((HeldFrame_t *)heap->pdata[child + 1],
+                                 (HeldFrame_t *)heap->pdata[child]))
+            child++;
+        if (!held_frame_is_before((HeldFrame_t *)heap->pdata[child], last))
+            break;
+        heap->pdata[i] = heap->pdata[child];
+    }
+    heap->pdata[i] = last;
+    return top;
+}
+
+static void
+run_close(ExternalSort_t *sort)
+{
+    int err;
+    const char *run_name;
+
+    run_name = (const char *)sort->run_names->pdata[sort->run_names->len - 1];
+    if (!wtap_dump_close(sort->run_pdh, &err)) {
+        cfile_close_failure_message(run_name, err);
+        exit(1);
+    }
+    sort->run_pdh = NULL;
+}
+
+/* Write the earliest held frame to its run, starting the run if need be */
+static void
+run_write_frame(ExternalSort_t *sort)
+{
+    HeldFrame_t *frame;
+    int    err;
+    gchar  *err_info;
+    char   *run_name;
+    wtapng_iface_descriptions_t *idb_inf;
+    GArray *shb_hdrs;
+    GArray *nrb_hdrs;
+
+    frame = held_frame_pop(sort->heap);
+
+    if (sort->run_pdh == NULL || frame->run != sort->run) {
+        if (sort->run_pdh != NULL)
+            run_close(sort);
+
+        shb_hdrs = wtap_file_get_shb_for_new_file(sort->wth);
+        idb_inf = wtap_file_get_idb_info(sort->wth);
+        nrb_hdrs = wtap_file_get_nrb_for_new_file(sort->wth);
+        sort->run_pdh = wtap_dump_open_tempfile_ng(&run_name, "reordercap",
+                                                   wtap_file_type_subtype(sort->wth),
+                                                   wtap_file_encap(sort->wth),
+                                                   wtap_snapshot_length(sort->wth),
+                                                   FALSE, shb_hdrs, idb_inf,
+                                                   nrb_hdrs, &err);
+        g_free(idb_inf);
+        wtap_block_array_free(shb_hdrs);
+        wtap_block_array_free(nrb_hdrs);
+        if (sort->run_pdh == NULL) {
+            cfile_dump_open_failure_message("reordercap",
+                                            run_name ? run_name : "temporary file",
+                                            err, wtap_file_type_subtype(sort->wth));
+            exit(1);
+        }
+        /* The name is in a buffer that gets reused for later temporary files */
+        g_ptr_array_add(sort->run_names, g_strdup(run_name));
+        sort->run = frame->run;
+        DEBUG_PRINT("Starting run %u in %s\n", sort->run, run_name);
+    }
+
+    frame->phdr.ts = frame->frame_time;
+    if (!wtap_dump(sort->run_pdh, &frame->phdr, frame->data, &err, &err_info)) {
+        cfile_write_failure_message("reordercap", sort->infile,
+                                    (const char *)sort->run_names->pdata[sort->run_names->len - 1],
+                                    err, err_info, frame->num,
+                                    wtap_file_type_subtype(sort->wth));
+        exit(1);
+    }
+    sort->last_time = frame->frame_time;
+
+    sort->held_bytes -= sizeof(HeldFrame_t) + frame->phdr.caplen;
+    g_free(frame->phdr.opt_comment);
+    ws_buffer_free(&frame->phdr.ft_specific_data);
+    g_free(frame->data);
+    g_free(frame);
+}
+
+static int
+reorder_external(wtap *wth, const char *infile, const char *outfile,
+                 gsize memory_budget, gboolean write_output_regardless)
+{
+    ExternalSort_t sort;
+    int err;
+    gchar *err_info;
+    gint64 data_offset;
+    const struct wtap_pkthdr *phdr;
+    guint frame_count = 0;
+    guint wrong_order_count = 0;
+    nstime_t prev_time;
+    const char **in_filenames;
+    guint err_fileno;
+    guint32 err_framenum;
+    merge_result status;
+    guint i;
+    int ret = EXIT_SUCCESS;
+
+    sort.wth = wth;
+    sort.infile = infile;
+    sort.heap = g_ptr_array_new();
+    sort.held_bytes = 0;
+    sort.run_names = g_ptr_array_new_with_free_func(g_free);
+    sort.run_pdh = NULL;
+    sort.run = 0;
+    nstime_set_zero(&sort.last_time);
+
+    /* Read each frame from infile, writing out runs as the heap fills */
+    while (wtap_read(wth, &err, &err_info, &data_offset)) {
+        HeldFrame_t *frame;
+
+        phdr = wtap_phdr(wth);
+
+        frame = g_new(HeldFrame_t, 1);
+        frame->num = ++frame_count;
+        if (phdr->presence_flags & WTAP_HAS_TS) {
+            frame->frame_time = phdr->ts;
+        } else {
+            nstime_set_unset(&frame->frame_time);
+        }
+        frame->phdr = *phdr;
+        frame->phdr.opt_comment = g_strdup(phdr->opt_comment);
+        ws_buffer_init(&frame->phdr.ft_specific_data, 0);
+        frame->data = (guint8 *)g_memdup(wtap_buf_ptr(wth), phdr->caplen);
+
+        if (frame_count > 1 && nstime_cmp(&frame->frame_time, &prev_time) < 0) {
+            wrong_order_count++;
+        }
+        prev_time = frame->frame_time;
+
+        /* Too early for the current run; it will have to go in the next one */
+        frame->run = sort.run;
+        if (sort.run_pdh != NULL && nstime_cmp(&frame->frame_time, &sort.last_time) < 0) {
+            frame->run++;
+        }
+
+        held_frame_push(sort.heap, frame);
+        sort.held_bytes += sizeof(HeldFrame_t) + phdr->caplen;
+        while (sort.held_bytes > memory_budget) {
+            run_write_frame(&sort);
+        }
+    }
+    if (err != 0) {
+      /* Print a message noting that the read failed somewhere along the line. */
+      cfile_read_failure_message("reordercap", infile, err, err_info);
+    }
+
+    while (sort.heap->len > 0) {
+        run_write_frame(&sort);
+    }
+    if (sort.run_pdh != NULL) {
+        run_close(&sort);
+    }
+    g_ptr_array_free(sort.heap, TRUE);
+
+    printf("%u frames, %u out of order\n", frame_count, wrong_order_count);
+    DEBUG_PRINT("%u runs\n", sort.run_names->len);
+
+    if (!write_output_regardless && (wrong_order_count == 0)) {
+        printf("Not writing output file because input file is already in order.\n");
+    } else if (sort.run_names->len > 0) {
+        /*
+         * merge_files() puts the later of two files first when their
+         * frames have the same time stamp, so hand it the runs last
+         * first to keep such frames in file order.
+         */
+        in_filenames = g_new(const char *, sort.run_names->len);
+        for (i = 0; i < sort.run_names->len; i++) {
+            in_filenames[i] = (const char *)sort.run_names->pdata[sort.run_names->len - 1 - i];
+        }
+
+        if (strcmp(outfile, "-") == 0) {
+            status = merge_files_to_stdout(wtap_file_type_subtype(wth),
+                                           in_filenames, sort.run_names->len,
+                                           FALSE, IDB_MERGE_MODE_ALL_SAME,
+                                           wtap_snapshot_length(wth), "reordercap",
+                                           NULL, &err, &err_info, &err_fileno,
+                                           &err_framenum);
+        } else {
+            status = merge_files(outfile, wtap_file_type_subtype(wth),
+                                 in_filenames, sort.run_names->len,
+                                 FALSE, IDB_MERGE_MODE_ALL_SAME,
+                                 wtap_snapshot_length(wth), "reordercap",
+                                 NULL, &err, &err_info, &err_fileno,
+                                 &err_framenum);
+        }
+
+        switch (status) {
+            case MERGE_OK:
+                break;
+
+            case MERGE_ERR_CANT_OPEN_INFILE:
+                cfile_open_failure_message("reordercap", in_filenames[err_fileno],
+                                           err, err_info);
+                ret = OUTPUT_FILE_ERROR;
+                break;
+
+            case MERGE_ERR_CANT_OPEN_OUTFILE:
+                cfile_dump_open_failure_message("reordercap", outfile, err,
+                                                wtap_file_type_subtype(wth));
+                ret = OUTPUT_FILE_ERROR;
+                break;
+
+            case MERGE_ERR_CANT_READ_INFILE:
+                cfile_read_failure_message("reordercap", in_filenames[err_fileno],
+                                           err, err_info);
+                ret = OUTPUT_FILE_ERROR;
+                break;
+
+            case MERGE_ERR_CANT_WRITE_OUTFILE:
+                cfile_write_failure_message("reordercap", infile, outfile, err,
+                                            err_info, err_framenum,
+                                            wtap_file_type_subtype(wth));
+                ret = OUTPUT_FILE_ERROR;
+                break;
+
+            case MERGE_ERR_CANT_CLOSE_OUTFILE:
+                cfile_close_failure_message(outfile, err);
+                ret = OUTPUT_FILE_ERROR;
+                break;
+
+            default:
+                fprintf(stderr, "reordercap: Unknown merge_files error %d\n", status);
+                ret = OUTPUT_FILE_ERROR;
+                break;
+        }
+        g_free(in_filenames);
+    }
+
+    for (i = 0; i < sort.run_names->len; i++) {
+        ws_unlink((const char *)sort.run_names->pdata[i]);
+    }
+    g_ptr_array_free(sort.run_names, TRUE);
+
+    return ret;
+}
+
 /*
  * General errors and warnings are reported with an console message
  * in reordercap.
@@ -189,6 +511,7 @@ main(int argc, char *argv[])
     const struct wtap_pkthdr *phdr;
     guint wrong_order_count = 0;
     gboolean write_output_regardless = TRUE;
+    gsize memory_budget = 0;
     guint i;
     GArray                      *shb_hdrs = NULL;
     wtapng_iface_descriptions_t *idb_inf = NULL;
@@ -263,8 +586,11 @@ main(int argc, char *argv[])
 #endif
 
     /* Process the options first */
-    while ((opt = getopt_long(argc, argv, "hnv", long_options, NULL)) != -1) {
+    while ((opt = getopt_long(argc, argv, "hm:nv", long_options, NULL)) != -1) {
         switch (opt) {
+            case 'm':
+                memory_budget = (gsize)get_positive_int(optarg, "memory budget") * 1024 * 1024;
+                break;
             case 'n':
                 write_output_regardless = FALSE;
                 break;
@@ -312,6 +638,13 @@ main(int argc, char *argv[])
     }
     DEBUG_PRINT("file_type_subtype is %d\n", wtap_file_type_subtype(wth));
 
+    if (memory_budget > 0) {
+        ret = reorder_external(wth, infile, outfile, memory_budget,
+                               write_output_regardless);
+        wtap_close(wth);
+        goto clean_exit;
+    }
+
     shb_hdrs = wtap_file_get_shb_for_new_file(wth);
     idb_inf = wtap_file_get_idb_info(wth);
     nrb_hdrs = wtap_file_get_nrb_for_new_file(wth);
@@ -56,6 +56,10 @@
 #include "ringbuffer.h"
 #include <wsutil/file_util.h>
 
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
 
 /* Ringbuffer file structure */
 typedef struct _rb_file {
@@ -74,10 +78,134 @@ typedef struct _ringbuf_data {
   int           fd;                  /* Current ringbuffer file descriptor */
   FILE         *pdh;
   gboolean      group_read_access;   /* TRUE if files need to be opened with group read access */
+
+#ifdef HAVE_ZLIB
+  gboolean      compress;            /* TRUE if closed files are gzipped */
+  GAsyncQueue  *compress_queue;      /* Names of closed files waiting to be gzipped */
+  GThread      *compress_thread;
+#endif
 } ringbuf_data;
 
 static ringbuf_data rb_data;
 
+#ifdef HAVE_ZLIB
+/* Queued to tell the compression thread that no more files are coming */
+static gchar compress_queue_end[] = "";
+
+#define COMPRESS_SUFFIX ".gz"
+
+/*
+ * gzip a closed ringbuffer file to <name>.gz and remove the original.
+ * If anything goes wrong the original is kept and the partial .gz removed.
+ */
+static void
+ringbuf_compress_file(const gchar *name)
+{
+  gchar   *gz_name;
+  FILE    *in;
+  int      gz_fd;
+  gzFile   gz;
+  guint8   buf[65536];
+  size_t   len;
+  gboolean ok = TRUE;
+
+  in = ws_fopen(name, "rb");
+  if (in == NULL) {
+    /* already rotated away */
+    return;
+  }
+
+  gz_name = g_strconcat(name, COMPRESS_SUFFIX, NULL);
+  gz_fd = ws_open(gz_name, O_WRONLY|O_BINARY|O_TRUNC|O_CREAT,
+                  rb_data.group_read_access ? 0640 : 0600);
+  if (gz_fd == -1) {
+    fclose(in);
+    g_free(gz_name);
+    return;
+  }
+  gz = gzdopen(gz_fd, "wb");
+  if (gz == NULL) {
+    ws_close(gz_fd);
+    fclose(in);
+    ws_unlink(gz_name);
+    g_free(gz_name);
+    return;
+  }
+
+  while ((len = fread(buf, 1, sizeof buf, in)) != 0) {
+    if (gzwrite(gz, buf, (unsigned)len) != (int)len) {
+      ok = FALSE;
+      break;
+    }
+  }
+  if (ferror(in))
+    ok = FALSE;
+  fclose(in);
+  if (gzclose(gz) != Z_OK)
+    ok = FALSE;
+
+  if (ok) {
+    ws_unlink(name);
+  } else {
+    ws_unlink(gz_name);
+  }
+  g_free(gz_name);
+}
+
+/*
+ * Compresses closed files off the capture thread, so that switching files
+ * never waits for deflate.
+ */
+static gpointer
+ringbuf_compress_thread_func(gpointer data _U_)
+{
+  gchar *name;
+
+  for (;;) {
+    name = (gchar *)g_async_queue_pop(rb_data.compress_queue);
+    if (name == compress_queue_end)
+      break;
+    ringbuf_compress_file(name);
+    g_free(name);
+  }
+  return NULL;
+}
+
+/*
+ * Wait for the compression thread to finish the files it has been given.
+ */
+static void
+ringbuf_compress_finish(void)
+{
+  if (rb_data.compress_thread != NULL) {
+    g_async_queue_push(rb_data.compress_queue, compress_queue_end);
+    g_thread_join(rb_data.compress_thread);
+    rb_data.compress_thread = NULL;
+  }
+  if (rb_data.compress_queue != NULL) {
+    g_async_queue_unref(rb_data.compress_queue);
+    rb_data.compress_queue = NULL;
+  }
+}
+
+/*
+ * Remove a ringbuffer file, or the result of compressing it.
+ */
+static void
+ringbuf_unlink_file(const gchar *name)
+{
+  ws_unlink(name);
+  if (rb_data.compress) {
+    gchar *gz_name = g_strconcat(name, COMPRESS_SUFFIX, NULL);
+
+    ws_unlink(gz_name);
+    g_free(gz_name);
+  }
+}
+#else
+#define ringbuf_unlink_file(name) ws_unlink(name)
+#endif
+
 
 /*
  * create the next filename and open a new binary file with that name
@@ -92,7 +220,7 @@ static int ringbuf_open_file(rb_file *rfile, int *err)
   if (rfile->name != NULL) {
     if (rb_data.unlimited == FALSE) {
       /* remove old file (if any, so ignore error) */
-      ws_unlink(rfile->name);
+      ringbuf_unlink_file(rfile->name);
     }
     g_free(rfile->name);
   }
@@ -131,7 +259,8 @@ static int ringbuf_open_file(rb_file *rfile, int *err)
  * Initialize the ringbuffer data structures
  */
 int
-ringbuf_init(const char *capfile_name, guint num_files, gboolean group_read_access)
+ringbuf_init(const char *capfile_name, guint num_files, gboolean group_read_access,
+             gboolean compress _U_)
 {
   unsigned int i;
   char        *pfx, *last_pathsep;
@@ -145,6 +274,11 @@ ringbuf_init(const char *capfile_name, guint num_files, gboolean group_read_acce
   rb_data.fd = -1;
   rb_data.pdh = NULL;
   rb_data.group_read_access = group_read_access;
+#ifdef HAVE_ZLIB
+  rb_data.compress = compress;
+  rb_data.compress_queue = NULL;
+  rb_data.compress_thread = NULL;
+#endif
 
   /* just to be sure ... */
   if (num_files <= RINGBUFFER_MAX_NUM_FILES) {
@@ -211,6 +345,17 @@ ringbuf_init(const char *capfile_name, guint num_files, gboolean group_read_acce
     return -1;
   }
 
+#ifdef HAVE_ZLIB
+  if (rb_data.compress) {
+    rb_data.compress_queue = g_async_queue_new();
+#if GLIB_CHECK_VERSION(2,31,0)
+    rb_data.compress_thread = g_thread_new("Ringbuffer compress", ringbuf_compress_thread_func, NULL);
+#else
+    rb_data.compress_thread = g_thread_create(ringbuf_compress_thread_func, NULL, TRUE, NULL);
+#endif
+  }
+#endif
+
   return rb_data.fd;
 }
 
@@ -259,6 +404,13 @@ ringbuf_switch_file(FILE **pdh, gchar **save_file, int *save_file_fd, int *err)
   rb_data.pdh = NULL;
   rb_data.fd  = -1;
 
+#ifdef HAVE_ZLIB
+  if (rb_data.compress_thread != NULL) {
+    g_async_queue_push(rb_data.compress_queue,
+                       g_strdup(rb_data.files[rb_data.curr_file_num % rb_data.num_files].name));
+  }
+#endif
+
   /* get the next file number and open it */
 
   rb_data.curr_file_num++ /* = next_file_num*/;
@@ -302,6 +454,12 @@ ringbuf_libpcap_dump_close(gchar **save_file, int *err)
     rb_data.fd  = -1;
   }
 
+#ifdef HAVE_ZLIB
+  /* The last file is left as it is, for whoever reads the capture next;
+     just wait until the earlier ones have been compressed. */
+  ringbuf_compress_finish();
+#endif
+
   /* set the save file name to the current file */
   *save_file = rb_data.files[rb_data.curr_file_num % rb_data.num_files].name;
   return ret_val;
@@ -315,6 +473,10 @@ ringbuf_free(void)
 {
   unsigned int i;
 
+#ifdef HAVE_ZLIB
+  ringbuf_compress_finish();
+#endif
+
   if (rb_data.files != NULL) {
     for (i=0; i < rb_data.num_files; i++) {
       if (rb_data.files[i].name != NULL) {
@@ -357,10 +519,14 @@ ringbuf_error_cleanup(void)
     rb_data.fd = -1;
   }
 
+#ifdef HAVE_ZLIB
+  ringbuf_compress_finish();
+#endif
+
   if (rb_data.files != NULL) {
     for (i=0; i < rb_data.num_files; i++) {
       if (rb_data.files[i].name != NULL) {
-        ws_unlink(rb_data.files[i].name);
+        ringbuf_unlink_file(rb_data.files[i].name);
       }
     }
   }
@@ -64,6 +64,7 @@
 #include "ui/failure_message.h"
 #include "register.h"
 #include <epan/epan_dissect.h>
+#include <epan/expert.h>
 #include <epan/tap.h>
 
 #include <codecs/codecs.h>
@@ -87,6 +88,7 @@ static const frame_data *ref;
 static frame_data ref_frame;
 static frame_data *prev_dis;
 static frame_data *prev_cap;
+static gboolean preloaded = FALSE;  /* cfile was loaded by the daemon, before any session */
 
 static void failure_warning_message(const char *msg_format, va_list ap);
 static void open_failure_message(const char *filename, int err,
@@ -223,6 +225,9 @@ main(int argc, char *argv[])
   /* Build the column format array */
   build_column_format_array(&cfile.cinfo, prefs_p->num_cols, TRUE);
 
+  /* Collect the expert infos while loading, so they can be served without a retap. */
+  expert_set_index_enabled(TRUE);
+
   ret = sharkd_loop();
 clean_exit:
   col_cleanup(&cfile.cinfo);
@@ -265,6 +270,7 @@ sharkd_epan_new(capture_file *cf)
 
   epan->data = cf;
   epan->get_frame_ts = sharkd_get_frame_ts;
+  epan->get_frame_shift_offset = NULL;
   epan->get_interface_name = cap_file_get_interface_name;
   epan->get_interface_description = cap_file_get_interface_description;
   epan->get_user_comment = NULL;
@@ -339,7 +345,7 @@ process_packet(capture_file *cf, epan_dissect_t *edt,
      */
     if (edt && cf->dfcode) {
       if (dfilter_apply_edt(cf->dfcode, edt)) {
-        g_slist_foreach(edt->pi.dependent_frames, find_and_mark_frame_depended_upon, cf->frames);
+        frame_data_sequence_mark_depended_upon(cf->frames, edt->pi.dependent_frames);
       }
     }
 
@@ -538,6 +544,7 @@ failure_message_cont(const char *msg_format, va_list ap)
 cf_status_t
 sharkd_cf_open(const char *fname, unsigned int type, gboolean is_tempfile, int *err)
 {
+  preloaded = FALSE;
   return cf_open(&cfile, fname, type, is_tempfile, err);
 }
 
@@ -547,6 +554,52 @@ sharkd_load_cap_file(void)
   return load_cap_file(&cfile, 0, 0);
 }
 
+/*
+ * Load a capture file before any session is started, so that the
+ * sessions forked afterwards share the frames and the dissection state
+ * of the first pass instead of each loading the file again.
+ */
+int
+sharkd_preload_cap_file(const char *fname)
+{
+  int err = 0;
+
+  if (sharkd_cf_open(fname, WTAP_TYPE_AUTO, FALSE, &err) != CF_OK)
+    return err ? err : -1;
+
+  err = load_cap_file(&cfile, 0, 0);
+  preloaded = (err == 0);
+  return err;
+}
+
+/* Is fname the file that was loaded before the session started? */
+gboolean
+sharkd_cf_is_preloaded(const char *fname)
+{
+  return preloaded && cfile.filename && !strcmp(cfile.filename, fname);
+}
+
+/*
+ * Give a session forked from the daemon its own handle to the preloaded
+ * file; an inherited one shares its file offset with every other
+ * session.
+ */
+int
+sharkd_reopen_preloaded_cap_file(void)
+{
+  int err = 0;
+
+  if (!preloaded)
+    return 0;
+
+  if (!wtap_fdreopen(cfile.wth, cfile.filename, &err))
+  {
+    preloaded = FALSE;
+    return err ? err : -1;
+  }
+  return 0;
+}
+
 int
 sharkd_dissect_request(unsigned int framenum, void (*cb)(epan_dissect_t *, proto_tree *, struct epan_column_info *, const GSList *, void *), int dissect_bytes, int dissect_columns, int dissect_tree, void *data)
 {
@@ -654,26 +707,35 @@ sharkd_dissect_columns(int framenum, column_info *cinfo, gboolean dissect_color)
   return 0;
 }
 
-int
-sharkd_retap(void)
-{
-  guint32          framenum;
-  frame_data      *fdata;
-  Buffer           buf;
+/*
+ * A retap can be done a slice of frames at a time, so that a session
+ * can serve other requests while a long one runs: sharkd_retap_begin(),
+ * sharkd_retap_step() until it returns FALSE, then sharkd_retap_end().
+ * Tap listeners must not be added or reset between the calls.
+ */
+static struct {
+  gboolean       active;
+  guint32        framenum;      /* next frame to dissect */
+  Buffer         buf;
   struct wtap_pkthdr phdr;
-  int err;
-  char *err_info = NULL;
+  epan_dissect_t edt;
+  column_info   *cinfo;
+} retap;
 
+void
+sharkd_retap_begin(void)
+{
   guint         tap_flags;
   gboolean      create_proto_tree;
-  epan_dissect_t edt;
-  column_info   *cinfo;
+
+  if (retap.active)
+    sharkd_retap_end();
 
   /* Get the union of the flags for all tap listeners. */
   tap_flags = union_of_tap_listener_flags();
 
   /* If any tap listeners require the columns, construct them. */
-  cinfo = (tap_flags & TL_REQUIRES_COLUMNS) ? &cfile.cinfo : NULL;
+  retap.cinfo = (tap_flags & TL_REQUIRES_COLUMNS) ? &cfile.cinfo : NULL;
 
   /*
    * Determine whether we need to create a protocol tree.
@@ -686,25 +748,69 @@ sharkd_retap(void)
   create_proto_tree =
     (have_filtering_tap_listeners() || (tap_flags & TL_REQUIRES_PROTO_TREE));
 
-  wtap_phdr_init(&phdr);
-  ws_buffer_init(&buf, 1500);
-  epan_dissect_init(&edt, cfile.epan, create_proto_tree, FALSE);
+  wtap_phdr_init(&retap.phdr);
+  ws_buffer_init(&retap.buf, 1500);
+  epan_dissect_init(&retap.edt, cfile.epan, create_proto_tree, FALSE);
 
   reset_tap_listeners();
 
-  for (framenum = 1; framenum <= cfile.count; framenum++) {
-    fdata = frame_data_sequence_find(cfile.frames, framenum);
+  retap.framenum = 1;
+  retap.active = TRUE;
+}
 
-    if (!wtap_seek_read(cfile.wth, fdata->file_off, &phdr, &buf, &err, &err_info))
+/* Dissect up to max_frames more frames; returns FALSE when there are no more */
+gboolean
+sharkd_retap_step(guint32 max_frames)
+{
+  frame_data      *fdata;
+  int err;
+  char *err_info = NULL;
+
+  if (!retap.active)
+    return FALSE;
+
+  for (; max_frames != 0 && retap.framenum <= cfile.count; max_frames--, retap.framenum++) {
+    fdata = frame_data_sequence_find(cfile.frames, retap.framenum);
+
+    if (!wtap_seek_read(cfile.wth, fdata->file_off, &retap.phdr, &retap.buf, &err, &err_info)) {
+      g_free(err_info);
+      retap.framenum = cfile.count + 1;
       break;
+    }
 
-    epan_dissect_run_with_taps(&edt, cfile.cd_t, &phdr, frame_tvbuff_new(fdata, ws_buffer_start_ptr(&buf)), fdata, cinfo);
-    epan_dissect_reset(&edt);
+    epan_dissect_run_with_taps(&retap.edt, cfile.cd_t, &retap.phdr, frame_tvbuff_new(fdata, ws_buffer_start_ptr(&retap.buf)), fdata, retap.cinfo);
+    epan_dissect_reset(&retap.edt);
   }
 
-  wtap_phdr_cleanup(&phdr);
-  ws_buffer_free(&buf);
-  epan_dissect_cleanup(&edt);
+  return retap.framenum <= cfile.count;
+}
+
+/* The number of frames dissected so far */
+guint32
+sharkd_retap_position(void)
+{
+  return retap.active ? retap.framenum - 1 : 0;
+}
+
+void
+sharkd_retap_end(void)
+{
+  if (!retap.active)
+    return;
+
+  wtap_phdr_cleanup(&retap.phdr);
+  ws_buffer_free(&retap.buf);
+  epan_dissect_cleanup(&retap.edt);
+  retap.active = FALSE;
+}
+
+int
+sharkd_retap(void)
+{
+  sharkd_retap_begin();
+  while (sharkd_retap_step(G_MAXUINT32))
+    ;
+  sharkd_retap_end();
 
   draw_tap_listeners(TRUE);
 
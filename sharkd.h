@@ -30,7 +30,14 @@
 /* sharkd.c */
 cf_status_t sharkd_cf_open(const char *fname, unsigned int type, gboolean is_tempfile, int *err);
 int sharkd_load_cap_file(void);
+int sharkd_preload_cap_file(const char *fname);
+gboolean sharkd_cf_is_preloaded(const char *fname);
+int sharkd_reopen_preloaded_cap_file(void);
 int sharkd_retap(void);
+void sharkd_retap_begin(void);
+gboolean sharkd_retap_step(guint32 max_frames);
+guint32 sharkd_retap_position(void);
+void sharkd_retap_end(void);
 int sharkd_filter(const char *dftext, guint8 **result);
 int sharkd_dissect_columns(int framenum, column_info *cinfo, gboolean dissect_color);
 int sharkd_dissect_request(unsigned int framenum, void (*cb)(epan_dissect_t *, proto_tree *, struct epan_column_info *, const GSList *, void *), int dissect_bytes, int dissect_columns, int dissect_tree, void *data);
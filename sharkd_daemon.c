@@ -65,6 +65,7 @@
 
 static int _use_stdinout = 0;
 static socket_handle_t _server_fd = INVALID_SOCKET;
+static const char *_preload_file = NULL;
 
 static socket_handle_t
 socket_init(char *path)
@@ -180,9 +181,12 @@ sharkd_init(int argc, char **argv)
 #endif
 	socket_handle_t fd;
 
-	if (argc != 2)
+	if (argc != 2 && argc != 3)
 	{
-		fprintf(stderr, "Usage: %s <-|socket>\n", argv[0]);
+		fprintf(stderr, "Usage: %s <-|socket> [<capture file>]\n", argv[0]);
+		fprintf(stderr, "\n");
+		fprintf(stderr, "If a capture file is given, it is loaded once, before any session is\n");
+		fprintf(stderr, "started, and shared by all the sessions that load it.\n");
 		fprintf(stderr, "\n");
 
 		fprintf(stderr, "<socket> examples:\n");
@@ -200,6 +204,9 @@ sharkd_init(int argc, char **argv)
 	signal(SIGCHLD, SIG_IGN);
 #endif
 
+	if (argc == 3)
+		_preload_file = argv[2];
+
 	if (!strcmp(argv[1], "-"))
 	{
 		_use_stdinout = 1;
@@ -234,6 +241,19 @@ sharkd_init(int argc, char **argv)
 int
 sharkd_loop(void)
 {
+	if (_preload_file)
+	{
+		int err;
+
+		fprintf(stderr, "preloading %s\n", _preload_file);
+		err = sharkd_preload_cap_file(_preload_file);
+		if (err != 0)
+		{
+			fprintf(stderr, "cannot preload %s (%d)\n", _preload_file, err);
+			return 1;
+		}
+	}
+
 	if (_use_stdinout)
 	{
 		return sharkd_session_main();
@@ -269,6 +289,14 @@ sharkd_loop(void)
 			dup2(fd, 1);
 			close(fd);
 
+			/* the frames and dissection state of the preloaded file are
+			 * shared with the daemon copy-on-write, but not its file offset */
+			if (sharkd_reopen_preloaded_cap_file() != 0)
+			{
+				fprintf(stderr, "cannot reopen %s\n", _preload_file);
+				exit(1);
+			}
+
 			exit(sharkd_session_main());
 		}
 
@@ -288,7 +316,16 @@ sharkd_loop(void)
 		si.hStdError = GetStdHandle(STD_ERROR_HANDLE);
 
 		exename = g_strdup_printf("%s\\%s", get_progfile_dir(), "sharkd.exe");
-		commandline = g_utf8_to_utf16("sharkd.exe -", -1, NULL, NULL, NULL);
+		/* there's no fork(), so every session loads the file itself */
+		if (_preload_file)
+		{
+			char *cmd = g_strdup_printf("sharkd.exe - \"%s\"", _preload_file);
+
+			commandline = g_utf8_to_utf16(cmd, -1, NULL, NULL, NULL);
+			g_free(cmd);
+		}
+		else
+			commandline = g_utf8_to_utf16("sharkd.exe -", -1, NULL, NULL, NULL);
 
 		if (!CreateProcess(utf_8to16(exename), commandline, NULL, NULL, TRUE, 0, NULL, NULL, &si, &pi))
 		{
@@ -40,6 +40,7 @@
 #include <epan/prefs.h>
 #include <epan/prefs-int.h>
 #include <epan/uat-int.h>
+#include <epan/app_mem_usage.h>
 #include <wiretap/wtap.h>
 
 #include <epan/column.h>
@@ -80,6 +81,11 @@
 
 #include <wsutil/glib-compat.h>
 #include <wsutil/strtoi.h>
+#include <wsutil/file_util.h>
+
+#ifndef _WIN32
+#include <poll.h>
+#endif
 
 #include "sharkd.h"
 
@@ -184,6 +190,127 @@ struct filter_item
 
 static struct filter_item *filter_list = NULL;
 
+/*
+ * Filter results can also be kept in a cache directory given with the
+ * load request, so that a session started later on the same file (e.g.
+ * after a restart of the backend, or by another sharkd) doesn't have to
+ * dissect every frame again for a filter it has seen before.
+ *
+ * A cache file is named after a hash of the capture file name, size and
+ * modification time and the filter text; it holds a magic, the number
+ * of frames, and the filter bitmap.
+ */
+#define SHARKD_FILTER_CACHE_MAGIC "SHKDFLT1"
+
+static char *filter_cache_dir = NULL;
+
+static void
+sharkd_session_filter_clear(void)
+{
+	while (filter_list)
+	{
+		struct filter_item *l = filter_list;
+
+		filter_list = l->next;
+		g_free(l->filter);
+		g_free(l->filtered);
+		g_free(l);
+	}
+}
+
+static char *
+sharkd_session_filter_cache_path(const char *filter)
+{
+	ws_statb64 st;
+	char *key;
+	char *name;
+	char *path;
+
+	if (!filter_cache_dir || !cfile.filename || ws_stat64(cfile.filename, &st) != 0)
+		return NULL;
+
+	key = g_strdup_printf("%s\n%" G_GINT64_MODIFIER "d\n%" G_GINT64_MODIFIER "d\n%s",
+	                      cfile.filename, (gint64) st.st_size, (gint64) st.st_mtime, filter);
+	name = g_compute_checksum_for_string(G_CHECKSUM_SHA256, key, -1);
+	path = g_strdup_printf("%s" G_DIR_SEPARATOR_S "%s.filter", filter_cache_dir, name);
+
+	g_free(name);
+	g_free(key);
+	return path;
+}
+
+static guint8 *
+sharkd_session_filter_cache_load(const char *filter)
+{
+	const size_t len = 2 + (cfile.count / 8);
+	char *path;
+	FILE *fp;
+	char magic[8];
+	guint32 frames;
+	guint8 *filtered;
+
+	path = sharkd_session_filter_cache_path(filter);
+	if (!path)
+		return NULL;
+
+	fp = ws_fopen(path, "rb");
+	g_free(path);
+	if (!fp)
+		return NULL;
+
+	filtered = (guint8 *) g_malloc(len);
+
+	if (fread(magic, sizeof(magic), 1, fp) != 1 || memcmp(magic, SHARKD_FILTER_CACHE_MAGIC, sizeof(magic)) ||
+	    fread(&frames, sizeof(frames), 1, fp) != 1 || frames != cfile.count ||
+	    fread(filtered, len, 1, fp) != 1)
+	{
+		g_free(filtered);
+		filtered = NULL;
+	}
+
+	fclose(fp);
+	return filtered;
+}
+
+static void
+sharkd_session_filter_cache_save(const char *filter, const guint8 *filtered)
+{
+	const size_t len = 2 + (cfile.count / 8);
+	const guint32 frames = cfile.count;
+	char *path;
+	char *tmp_path;
+	int fd;
+	gboolean ok;
+
+	path = sharkd_session_filter_cache_path(filter);
+	if (!path)
+		return;
+
+	/* write it under another name first, other sessions may be reading it */
+	tmp_path = g_strdup_printf("%s.XXXXXX", path);
+	fd = g_mkstemp(tmp_path);
+	if (fd == -1)
+	{
+		fprintf(stderr, "filter cache: cannot create %s: %s\n", tmp_path, g_strerror(errno));
+		g_free(tmp_path);
+		g_free(path);
+		return;
+	}
+
+	ok = (ws_write(fd, SHARKD_FILTER_CACHE_MAGIC, 8) == 8 &&
+	      ws_write(fd, &frames, sizeof(frames)) == sizeof(frames) &&
+	      ws_write(fd, filtered, (unsigned int) len) == (int) len);
+
+	if (ws_close(fd) != 0)
+		ok = FALSE;
+
+	if (!ok || ws_rename(tmp_path, path) != 0)
+		ws_unlink(tmp_path);
+
+	g_free(tmp_path);
+	g_free(path);
+}
+
 static const guint8 *
 sharkd_session_filter_data(const char *filter)
 {
@@ -198,10 +325,16 @@ sharkd_session_filter_data(const char *filter)
 	{
 		guint8 *filtered = NULL;
 
-		int ret = sharkd_filter(filter, &filtered);
+		filtered = sharkd_session_filter_cache_load(filter);
+		if (!filtered)
+		{
+			int ret = sharkd_filter(filter, &filtered);
 
-		if (ret == -1)
-			return NULL;
+			if (ret == -1)
+				return NULL;
+
+			sharkd_session_filter_cache_save(filter, filtered);
+		}
 
 		l = (struct filter_item *) g_malloc(sizeof(struct filter_item));
 		l->filter = g_strdup(filter);
@@ -550,13 +683,17 @@ sharkd_session_process_info(void)
 	printf("}\n");
 }
 
+static void sharkd_session_columns_cache_clear(void);
+static void sharkd_session_tap_jobs_clear(void);
+
 /**
  * sharkd_session_process_load()
  *
  * Process load request
  *
  * Input:
- *   (m) file - file to be loaded
+ *   (m) file  - file to be loaded
+ *   (o) cache - directory where filter results for the file are kept, and looked for
  *
  * Output object with attributes:
  *   (m) err - error code
@@ -565,6 +702,7 @@ static void
 sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
 {
 	const char *tok_file = json_find_attr(buf, tokens, count, "file");
+	const char *tok_cache = json_find_attr(buf, tokens, count, "cache");
 	int err = 0;
 
 	fprintf(stderr, "load: filename=%s\n", tok_file);
@@ -572,6 +710,20 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
 	if (!tok_file)
 		return;
 
+	g_free(filter_cache_dir);
+	filter_cache_dir = (tok_cache && tok_cache[0]) ? g_strdup(tok_cache) : NULL;
+
+	/* already loaded by the daemon, and shared with the other sessions */
+	if (sharkd_cf_is_preloaded(tok_file))
+	{
+		printf("{\"err\":0}\n");
+		return;
+	}
+
+	sharkd_session_columns_cache_clear();
+	sharkd_session_tap_jobs_clear();
+	sharkd_session_filter_clear();
+
 	if (sharkd_cf_open(tok_file, WTAP_TYPE_AUTO, FALSE, &err) != CF_OK)
 	{
 		printf("{\"err\":%d}\n", err);
@@ -602,10 +754,17 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
  *   (m) duration - time difference between time of first frame, and last loaded frame
  *   (o) filename - capture filename
  *   (o) filesize - capture filesize
+ *   (m) memory   - memory usage, array of objects with attributes:
+ *                  'name'  - program total, subsystem or wmem pool
+ *                  'bytes' - bytes used
  */
 static void
 sharkd_session_process_status(void)
 {
+	const char *mem_name;
+	gsize mem_bytes;
+	guint i;
+
 	printf("{\"frames\":%u", cfile.count);
 
 	printf(",\"duration\":%.9f", nstime_to_sec(&cfile.elapsed_time));
@@ -627,9 +786,74 @@ sharkd_session_process_status(void)
 			printf(",\"filesize\":%" G_GINT64_FORMAT, file_size);
 	}
 
+	printf(",\"memory\":[");
+	for (i = 0; (mem_name = memory_usage_get(i, &mem_bytes)) != NULL; i++)
+	{
+		printf("%s{\"name\":", i ? "," : "");
+		json_puts_string(mem_name);
+		printf(",\"bytes\":%" G_GSIZE_FORMAT "}", mem_bytes);
+	}
+	printf("]");
+
 	printf("}\n");
 }
 
+static gboolean sharkd_profiling = FALSE;
+
+static void
+sharkd_session_process_profile_cb(int proto_id, const dissector_profile_t *profile, gpointer user_data)
+{
+	int *pi = (int *) user_data;
+
+	printf("%s{", (*pi) ? "," : "");
+		printf("\"proto\":");
+		json_puts_string(proto_get_protocol_short_name(find_protocol_by_id(proto_id)));
+		printf(",\"calls\":%" G_GUINT64_FORMAT, profile->calls);
+		printf(",\"exceptions\":%" G_GUINT64_FORMAT, profile->exceptions);
+		printf(",\"total_us\":%" G_GUINT64_FORMAT, profile->total_us);
+		printf(",\"self_us\":%" G_GUINT64_FORMAT, profile->self_us);
+	printf("}");
+
+	*pi = *pi + 1;
+}
+
+/**
+ * sharkd_session_process_profile()
+ *
+ * Process profile request
+ *
+ * Input:
+ *   (o) enable - 1 to start profiling the dissectors (forgetting what was measured before), 0 to stop
+ *
+ * Output object with attributes:
+ *   (m) enabled   - if the dissectors are being profiled
+ *   (m) protocols - array of what was measured for each protocol whose dissectors were called, with attributes:
+ *                  (m) proto      - protocol short name
+ *                  (m) calls      - calls to its dissectors
+ *                  (m) exceptions - calls ending with an exception
+ *                  (m) total_us   - microseconds spent in the calls
+ *                  (m) self_us    - microseconds spent in the calls, less those in the dissectors of other protocols
+ */
+static void
+sharkd_session_process_profile(char *buf, const jsmntok_t *tokens, int count)
+{
+	const char *tok_enable = json_find_attr(buf, tokens, count, "enable");
+	int i = 0;
+
+	if (tok_enable)
+	{
+		sharkd_profiling = (*tok_enable == '1');
+		if (sharkd_profiling)
+			dissector_profile_reset();
+		dissector_set_profiling(sharkd_profiling);
+	}
+
+	printf("{\"enabled\":%s", sharkd_profiling ? "true" : "false");
+	printf(",\"protocols\":[");
+	dissector_profile_foreach(sharkd_session_process_profile_cb, &i);
+	printf("]}\n");
+}
+
 struct sharkd_analyse_data
 {
 	GHashTable *protocols_set;
@@ -784,6 +1008,197 @@ sharkd_session_create_columns(column_info *cinfo, const char *buf, const jsmntok
 	return cinfo;
 }
 
+/*
+ * Cache of the column strings of the frames sent by "frames" requests,
+ * one per set of requested columns, so that paging back and forth over
+ * the same frames doesn't dissect them again.  Each frame's columns are
+ * kept as one run of '\0'-terminated strings in a string chunk.
+ */
+#define SHARKD_COLUMNS_CACHE_SETS  4        /* column sets to keep */
+#define SHARKD_COLUMNS_CACHE_ROWS  262144   /* frames to keep per column set */
+
+struct columns_cache_item
+{
+	struct columns_cache_item *next;
+
+	char *columns;          /* the column0..N values, '\n'-separated; "" for the default columns */
+	column_info user_cinfo;
+	column_info *cinfo;
+	GStringChunk *strings;
+	GPtrArray *rows;        /* indexed by frame number */
+	guint num_rows;
+};
+
+static struct columns_cache_item *columns_cache = NULL;
+
+/* Set up by a "frames" request, carried out once its reply is sent */
+static struct
+{
+	struct columns_cache_item *item;
+	const guint8 *filter_data;
+	guint32 framenum;
+	guint32 count;
+} columns_prefetch;
+
+static void
+sharkd_session_columns_cache_free(struct columns_cache_item *item)
+{
+	if (item->cinfo != &cfile.cinfo)
+		col_cleanup(item->cinfo);
+	g_string_chunk_free(item->strings);
+	g_ptr_array_free(item->rows, TRUE);
+	g_free(item->columns);
+	g_free(item);
+}
+
+/* Drop everything cached, as the columns of the frames may have changed */
+static void
+sharkd_session_columns_cache_clear(void)
+{
+	struct columns_cache_item *item;
+
+	while ((item = columns_cache))
+	{
+		columns_cache = item->next;
+		sharkd_session_columns_cache_free(item);
+	}
+	columns_prefetch.item = NULL;
+}
+
+static struct columns_cache_item *
+sharkd_session_columns_cache_get(const char *buf, const jsmntok_t *tokens, int count)
+{
+	struct columns_cache_item *item, **pitem;
+	GString *columns;
+	int i, n;
+
+	columns = g_string_new(NULL);
+	for (i = 0; i < 32; i++)
+	{
+		const char *tok_column;
+		char tok_column_name[64];
+
+		ws_snprintf(tok_column_name, sizeof(tok_column_name), "column%d", i);
+		tok_column = json_find_attr(buf, tokens, count, tok_column_name);
+		if (tok_column == NULL)
+			break;
+
+		g_string_append(columns, tok_column);
+		g_string_append_c(columns, '\n');
+	}
+
+	/* move it to the front if we have it, and drop the least recently used set if full */
+	n = 0;
+	for (pitem = &columns_cache; (item = *pitem); pitem = &item->next)
+	{
+		if (!strcmp(item->columns, columns->str))
+		{
+			*pitem = item->next;
+			item->next = columns_cache;
+			columns_cache = item;
+			g_string_free(columns, TRUE);
+			return item;
+		}
+
+		if (++n == SHARKD_COLUMNS_CACHE_SETS)
+		{
+			if (columns_prefetch.item == item)
+				columns_prefetch.item = NULL;
+			*pitem = NULL;
+			sharkd_session_columns_cache_free(item);
+			break;
+		}
+	}
+
+	item = g_new0(struct columns_cache_item, 1);
+	item->cinfo = &cfile.cinfo;
+	if (columns->len)
+	{
+		item->cinfo = sharkd_session_create_columns(&item->user_cinfo, buf, tokens, count);
+		if (!item->cinfo)
+		{
+			g_free(item);
+			g_string_free(columns, TRUE);
+			return NULL;
+		}
+	}
+	item->columns = g_string_free(columns, FALSE);
+	item->strings = g_string_chunk_new(64 * 1024);
+	item->rows = g_ptr_array_new();
+
+	item->next = columns_cache;
+	columns_cache = item;
+	return item;
+}
+
+/*
+ * Get the column strings of a frame, from the cache or by dissecting it.
+ * They're good until the next call.
+ */
+static const char *
+sharkd_session_columns_cache_row(struct columns_cache_item *item, guint32 framenum, frame_data *fdata)
+{
+	static GString *row = NULL;
+	column_info *cinfo = item->cinfo;
+	const char *cached;
+	int col, ret;
+
+	if (framenum < item->rows->len && (cached = (const char *) g_ptr_array_index(item->rows, framenum)))
+		return cached;
+
+	if (!row)
+		row = g_string_new(NULL);
+
+	ret = sharkd_dissect_columns(framenum, cinfo, (fdata->color_filter == NULL));
+
+	g_string_truncate(row, 0);
+	for (col = 0; col < cinfo->num_cols; ++col)
+		g_string_append_len(row, cinfo->columns[col].col_data, strlen(cinfo->columns[col].col_data) + 1);
+
+	/* no caching of what might be stale columns */
+	if (ret == -1)
+		return row->str;
+
+	if (item->num_rows == SHARKD_COLUMNS_CACHE_ROWS)
+	{
+		g_string_chunk_clear(item->strings);
+		g_ptr_array_set_size(item->rows, 0);
+		item->num_rows = 0;
+	}
+
+	if (item->rows->len <= framenum)
+		g_ptr_array_set_size(item->rows, cfile.count + 1);
+	cached = g_string_chunk_insert_len(item->strings, row->str, row->len);
+	g_ptr_array_index(item->rows, framenum) = (gpointer) cached;
+	item->num_rows++;
+
+	return cached;
+}
+
+/* Fill the cache with the frames after those of the last "frames" request */
+static void
+sharkd_session_columns_prefetch(void)
+{
+	struct columns_cache_item *item = columns_prefetch.item;
+	guint32 framenum;
+
+	if (!item)
+		return;
+	columns_prefetch.item = NULL;
+
+	for (framenum = columns_prefetch.framenum; framenum <= cfile.count && columns_prefetch.count; framenum++)
+	{
+		frame_data *fdata;
+
+		if (columns_prefetch.filter_data && !(columns_prefetch.filter_data[framenum / 8] & (1 << (framenum % 8))))
+			continue;
+
+		fdata = frame_data_sequence_find(cfile.frames, framenum);
+		sharkd_session_columns_cache_row(item, framenum, fdata);
+		columns_prefetch.count--;
+	}
+}
+
 /**
  * sharkd_session_process_frames()
  *
@@ -795,6 +1210,10 @@ sharkd_session_create_columns(column_info *cinfo, const char *buf, const jsmntok
  *   (o) filter - filter to be used
  *   (o) skip=N   - skip N frames
  *   (o) limit=N  - show only N frames
+ *   (o) prefetch=N - after replying, dissect the next N frames (the next page) into the cache
+ *
+ * The column strings of the frames are cached for each set of columns, so
+ * requesting the same frames again doesn't dissect them again.
  *
  * Output array of frames with attributes:
  *   (m) c   - array of column data
@@ -809,9 +1228,9 @@ static void
 sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int count)
 {
 	const char *tok_filter = json_find_attr(buf, tokens, count, "filter");
-	const char *tok_column = json_find_attr(buf, tokens, count, "column0");
 	const char *tok_skip   = json_find_attr(buf, tokens, count, "skip");
 	const char *tok_limit  = json_find_attr(buf, tokens, count, "limit");
+	const char *tok_prefetch = json_find_attr(buf, tokens, count, "prefetch");
 
 	const guint8 *filter_data = NULL;
 
@@ -821,17 +1240,15 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
 	guint32 framenum;
 	guint32 skip;
 	guint32 limit;
+	guint32 prefetch;
 
-	column_info *cinfo = &cfile.cinfo;
-	column_info user_cinfo;
+	struct columns_cache_item *item;
+	column_info *cinfo;
 
-	if (tok_column)
-	{
-		memset(&user_cinfo, 0, sizeof(user_cinfo));
-		cinfo = sharkd_session_create_columns(&user_cinfo, buf, tokens, count);
-		if (!cinfo)
-			return;
-	}
+	item = sharkd_session_columns_cache_get(buf, tokens, count);
+	if (!item)
+		return;
+	cinfo = item->cinfo;
 
 	if (tok_filter)
 	{
@@ -854,6 +1271,13 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
 			return;
 	}
 
+	prefetch = 0;
+	if (tok_prefetch)
+	{
+		if (!ws_strtou32(tok_prefetch, NULL, &prefetch))
+			return;
+	}
+
 	printf("[");
 	for (framenum = 1; framenum <= cfile.count; framenum++)
 	{
@@ -868,19 +1292,20 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
 			continue;
 		}
 
-		sharkd_dissect_columns(framenum, cinfo, (fdata->color_filter == NULL));
-
-		printf("%s{\"c\":[", frame_sepa);
-		for (col = 0; col < cinfo->num_cols; ++col)
 		{
-			const col_item_t *col_item = &cinfo->columns[col];
+			const char *col_data = sharkd_session_columns_cache_row(item, framenum, fdata);
 
-			if (col)
-				printf(",");
+			printf("%s{\"c\":[", frame_sepa);
+			for (col = 0; col < cinfo->num_cols; ++col)
+			{
+				if (col)
+					printf(",");
 
-			json_puts_string(col_item->col_data);
+				json_puts_string(col_data);
+				col_data += strlen(col_data) + 1;
+			}
+			printf("],\"num\":%u", framenum);
 		}
-		printf("],\"num\":%u", framenum);
 
 		if (fdata->flags.has_phdr_comment)
 			printf(",\"ct\":true");
@@ -905,8 +1330,13 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
 	}
 	printf("]\n");
 
-	if (cinfo != &cfile.cinfo)
-		col_cleanup(cinfo);
+	if (prefetch)
+	{
+		columns_prefetch.item = item;
+		columns_prefetch.filter_data = filter_data;
+		columns_prefetch.framenum = framenum + 1;
+		columns_prefetch.count = prefetch;
+	}
 }
 
 static void
@@ -1018,6 +1448,36 @@ struct sharkd_expert_tap
  *                  (m) m - expert message
  *                  (o) p - protocol
  */
+static void
+sharkd_session_print_expert_detail(const expert_info_t *ei, const char *sepa)
+{
+	const char *tmp;
+
+	printf("%s{", sepa);
+
+	printf("\"f\":%u,", ei->packet_num);
+
+	tmp = try_val_to_str(ei->severity, expert_severity_vals);
+	if (tmp)
+		printf("\"s\":\"%s\",", tmp);
+
+	tmp = try_val_to_str(ei->group, expert_group_vals);
+	if (tmp)
+		printf("\"g\":\"%s\",", tmp);
+
+	printf("\"m\":");
+	json_puts_string(ei->summary);
+	printf(",");
+
+	if (ei->protocol)
+	{
+		printf("\"p\":");
+		json_puts_string(ei->protocol);
+	}
+
+	printf("}");
+}
+
 static void
 sharkd_session_process_tap_expert_cb(void *tapdata)
 {
@@ -1030,37 +1490,46 @@ sharkd_session_process_tap_expert_cb(void *tapdata)
 	printf(",\"details\":[");
 	for (list = etd->details; list; list = list->next)
 	{
-		expert_info_t *ei = (expert_info_t *) list->data;
-		const char *tmp;
-
-		printf("%s{", sepa);
-
-		printf("\"f\":%u,", ei->packet_num);
+		sharkd_session_print_expert_detail((const expert_info_t *) list->data, sepa);
+		sepa = ",";
+	}
+	printf("]");
 
-		tmp = try_val_to_str(ei->severity, expert_severity_vals);
-		if (tmp)
-			printf("\"s\":\"%s\",", tmp);
+	printf("},");
+}
 
-		tmp = try_val_to_str(ei->group, expert_group_vals);
-		if (tmp)
-			printf("\"g\":\"%s\",", tmp);
+/*
+ * A request for just the expert infos can be answered from the index
+ * kept while loading the file, without retapping; returns FALSE if not.
+ */
+static gboolean
+sharkd_session_process_tap_expert_index(char *buf, const jsmntok_t *tokens, int count)
+{
+	const char *tok_tap = json_find_attr(buf, tokens, count, "tap0");
+	const expert_info_t *index;
+	const char *sepa = "";
+	guint index_count, i;
 
-		printf("\"m\":");
-		json_puts_string(ei->summary);
-		printf(",");
+	if (!tok_tap || strcmp(tok_tap, "expert") != 0 || json_find_attr(buf, tokens, count, "tap1"))
+		return FALSE;
 
-		if (ei->protocol)
-		{
-			printf("\"p\":");
-			json_puts_string(ei->protocol);
-		}
+	index = expert_get_index(&index_count);
+	if (!index)
+		return FALSE;
 
-		printf("}");
+	printf("{\"taps\":[");
+	printf("{\"tap\":\"%s\",\"type\":\"%s\"", "expert", "expert");
+	printf(",\"details\":[");
+	/* the tap lists them last to first */
+	for (i = index_count; i > 0; i--)
+	{
+		sharkd_session_print_expert_detail(&index[i - 1], sepa);
 		sepa = ",";
 	}
-	printf("]");
+	printf("]},");
+	printf("null],\"err\":0}\n");
 
-	printf("},");
+	return TRUE;
 }
 
 static gboolean
@@ -1894,6 +2363,9 @@ sharkd_session_free_tap_rtd_cb(void *arg)
  *                            (m) min - minimum SRT time
  *                            (m) max - maximum SRT time
  *                            (m) tot - total SRT time
+ *                            (m) p50 - median SRT time
+ *                            (m) p99 - 99th percentile SRT time
+ *                            (m) p999 - 99.9th percentile SRT time
  */
 static void
 sharkd_session_process_tap_srt_cb(void *arg)
@@ -1962,6 +2434,9 @@ sharkd_session_process_tap_srt_cb(void *arg)
 			printf(",\"min\":%.9f", nstime_to_sec(&proc->stats.min));
 			printf(",\"max\":%.9f", nstime_to_sec(&proc->stats.max));
 			printf(",\"tot\":%.9f", nstime_to_sec(&proc->stats.tot));
+			printf(",\"p50\":%.9f", time_hist_percentile(&proc->hist, 50.0));
+			printf(",\"p99\":%.9f", time_hist_percentile(&proc->hist, 99.0));
+			printf(",\"p999\":%.9f", time_hist_percentile(&proc->hist, 99.9));
 
 			printf("}");
 			sepa = ",";
@@ -2157,45 +2632,13 @@ sharkd_session_process_tap_rtp_cb(void *arg)
 	printf("]},");
 }
 
-/**
- * sharkd_session_process_tap()
- *
- * Process tap request
- *
- * Input:
- *   (m) tap0         - First tap request
- *   (o) tap1...tap15 - Other tap requests
- *
- * Output object with attributes:
- *   (m) taps  - array of object with attributes:
- *                  (m) tap  - tap name
- *                  (m) type - tap output type
- *                  ...
- *                  for type:stats see sharkd_session_process_tap_stats_cb()
- *                  for type:nstat see sharkd_session_process_tap_nstat_cb()
- *                  for type:conv see sharkd_session_process_tap_conv_cb()
- *                  for type:host see sharkd_session_process_tap_conv_cb()
- *                  for type:rtp-streams see sharkd_session_process_tap_rtp_cb()
- *                  for type:rtp-analyse see sharkd_session_process_tap_rtp_analyse_cb()
- *                  for type:eo see sharkd_session_process_tap_eo_cb()
- *                  for type:expert see sharkd_session_process_tap_expert_cb()
- *                  for type:rtd see sharkd_session_process_tap_rtd_cb()
- *                  for type:srt see sharkd_session_process_tap_srt_cb()
- *                  for type:flow see sharkd_session_process_tap_flow_cb()
- *
- *   (m) err   - error code
- */
-static void
-sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
+/* Register the listeners of the tap0..tap15 requests; returns how many were registered */
+static int
+sharkd_session_register_taps(char *buf, const jsmntok_t *tokens, int count, void **taps_data, GFreeFunc *taps_free, rtpstream_tapinfo_t *rtp_tapinfo)
 {
-	void *taps_data[16];
-	GFreeFunc taps_free[16];
 	int taps_count = 0;
 	int i;
 
-	rtpstream_tapinfo_t rtp_tapinfo =
-		{NULL, NULL, NULL, NULL, 0, NULL, 0, TAP_ANALYSE, NULL, NULL, NULL, FALSE};
-
 	for (i = 0; i < 16; i++)
 	{
 		char tapbuf[32];
@@ -2446,9 +2889,9 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
 		}
 		else if (!strcmp(tok_tap, "rtp-streams"))
 		{
-			tap_error = register_tap_listener("rtp", &rtp_tapinfo, tap_filter, 0, rtpstream_reset_cb, rtpstream_packet, sharkd_session_process_tap_rtp_cb);
+			tap_error = register_tap_listener("rtp", rtp_tapinfo, tap_filter, 0, rtpstream_reset_cb, rtpstream_packet, sharkd_session_process_tap_rtp_cb);
 
-			tap_data = &rtp_tapinfo;
+			tap_data = rtp_tapinfo;
 			tap_free = rtpstream_reset_cb;
 		}
 		else if (!strncmp(tok_tap, "rtp-analyse:", 12))
@@ -2491,6 +2934,363 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
 		taps_count++;
 	}
 
+	return taps_count;
+}
+
+/*
+ * Tap jobs.
+ *
+ * A "tap" request with "async" set returns a job id at once; its taps
+ * are run a slice of frames at a time, between requests, while the
+ * session has no request waiting.  All queued jobs are started together
+ * and share one pass over the frames.  "tapjob" reports the progress of
+ * a job, and its results, once or (with "partial") while it runs;
+ * "tapcancel" drops it.
+ *
+ * The listeners of finished jobs stay registered until the results are
+ * collected, so a new pass only starts once no finished job is waiting
+ * to be collected.  Requests that retap on their own (synchronous
+ * "tap", "follow", rtp "download") are refused with EBUSY while any job
+ * has listeners registered, as they would reset and feed them.
+ */
+#define SHARKD_TAP_JOB_SLICE 10000   /* frames dissected between checks for requests */
+
+enum sharkd_tap_job_state
+{
+	SHARKD_TAP_JOB_QUEUED,
+	SHARKD_TAP_JOB_RUNNING,
+	SHARKD_TAP_JOB_DONE
+};
+
+struct sharkd_tap_job
+{
+	struct sharkd_tap_job *next;
+
+	guint id;
+	enum sharkd_tap_job_state state;
+
+	/* copy of the request; the tap listeners point into it */
+	char *buf;
+	jsmntok_t *tokens;
+	int count;
+
+	void *taps_data[16];
+	GFreeFunc taps_free[16];
+	int taps_count;
+	rtpstream_tapinfo_t rtp_tapinfo;
+};
+
+static struct sharkd_tap_job *tap_jobs = NULL;
+static guint tap_jobs_next_id = 1;
+
+static gboolean
+sharkd_session_tap_jobs_busy(void)
+{
+	struct sharkd_tap_job *job;
+
+	for (job = tap_jobs; job; job = job->next)
+	{
+		if (job->state != SHARKD_TAP_JOB_QUEUED)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static void
+sharkd_session_tap_job_submit(char *buf, const jsmntok_t *tokens, int count)
+{
+	static const rtpstream_tapinfo_t rtp_tapinfo_init =
+		{NULL, NULL, NULL, NULL, 0, NULL, 0, TAP_ANALYSE, NULL, NULL, NULL, FALSE};
+
+	struct sharkd_tap_job *job, **pjob;
+
+	job = g_new0(struct sharkd_tap_job, 1);
+	job->id = tap_jobs_next_id++;
+	job->state = SHARKD_TAP_JOB_QUEUED;
+	job->buf = (char *) g_memdup(buf, tokens[0].end + 1);
+	job->tokens = (jsmntok_t *) g_memdup(tokens, count * sizeof(jsmntok_t));
+	job->count = count;
+	job->rtp_tapinfo = rtp_tapinfo_init;
+
+	/* keep them in the order they were submitted */
+	for (pjob = &tap_jobs; *pjob; pjob = &(*pjob)->next)
+		;
+	*pjob = job;
+
+	printf("{\"job\":%u,\"err\":0}\n", job->id);
+}
+
+static void
+sharkd_session_tap_job_free(struct sharkd_tap_job *job)
+{
+	struct sharkd_tap_job **pjob;
+	int i;
+
+	for (pjob = &tap_jobs; *pjob; pjob = &(*pjob)->next)
+	{
+		if (*pjob == job)
+		{
+			*pjob = job->next;
+			break;
+		}
+	}
+
+	for (i = 0; i < job->taps_count; i++)
+	{
+		if (job->taps_data[i])
+			remove_tap_listener(job->taps_data[i]);
+
+		if (job->taps_free[i])
+			job->taps_free[i](job->taps_data[i]);
+	}
+
+	g_free(job->buf);
+	g_free(job->tokens);
+	g_free(job);
+
+	/* was it the last one the pass was for? */
+	if (!sharkd_session_tap_jobs_busy())
+		sharkd_retap_end();
+}
+
+/* Drop all the jobs, e.g. when another file is loaded */
+static void
+sharkd_session_tap_jobs_clear(void)
+{
+	while (tap_jobs)
+		sharkd_session_tap_job_free(tap_jobs);
+}
+
+/* Returns TRUE if there's more work for the jobs to do */
+static gboolean
+sharkd_session_tap_jobs_step(void)
+{
+	struct sharkd_tap_job *job;
+	gboolean running = FALSE, queued = FALSE;
+
+	for (job = tap_jobs; job; job = job->next)
+	{
+		if (job->state == SHARKD_TAP_JOB_RUNNING)
+			running = TRUE;
+		else if (job->state == SHARKD_TAP_JOB_QUEUED)
+			queued = TRUE;
+		else
+			return FALSE;   /* wait for the results to be collected */
+	}
+
+	if (!running)
+	{
+		if (!queued)
+			return FALSE;
+
+		/* start everything that's queued in one pass */
+		for (job = tap_jobs; job; job = job->next)
+		{
+			job->taps_count = sharkd_session_register_taps(job->buf, job->tokens, job->count, job->taps_data, job->taps_free, &job->rtp_tapinfo);
+			job->state = SHARKD_TAP_JOB_RUNNING;
+		}
+		sharkd_retap_begin();
+	}
+
+	if (sharkd_retap_step(SHARKD_TAP_JOB_SLICE))
+		return TRUE;
+
+	sharkd_retap_end();
+	for (job = tap_jobs; job; job = job->next)
+		job->state = SHARKD_TAP_JOB_DONE;
+	return FALSE;
+}
+
+static struct sharkd_tap_job *
+sharkd_session_tap_job_find(const char *tok_job)
+{
+	struct sharkd_tap_job *job;
+	guint32 id;
+
+	if (!tok_job || !ws_strtou32(tok_job, NULL, &id))
+		return NULL;
+
+	for (job = tap_jobs; job; job = job->next)
+	{
+		if (job->id == id)
+			return job;
+	}
+	return NULL;
+}
+
+/**
+ * sharkd_session_process_tapjob()
+ *
+ * Process tapjob request
+ *
+ * Input:
+ *   (m) job     - job id, from an async tap request
+ *   (o) partial - if set, return the results so far of a running job
+ *
+ * Output object with attributes:
+ *   (m) job    - job id
+ *   (m) state  - "queued", "running" or "done"
+ *   (m) frames - frames the job has seen so far
+ *   (m) total  - frames in the file
+ *   (o) taps   - when done, or with partial while running; as for the tap request.
+ *                Once a done job's taps are returned, the job is gone.
+ *   (m) err    - error code; ENOENT if there's no such job
+ */
+static void
+sharkd_session_process_tapjob(char *buf, const jsmntok_t *tokens, int count)
+{
+	const char *tok_job = json_find_attr(buf, tokens, count, "job");
+	const char *tok_partial = json_find_attr(buf, tokens, count, "partial");
+	struct sharkd_tap_job *job;
+	const char *state;
+	guint32 frames;
+	int i;
+
+	job = sharkd_session_tap_job_find(tok_job);
+	if (!job)
+	{
+		printf("{\"err\":%d}\n", ENOENT);
+		return;
+	}
+
+	switch (job->state)
+	{
+		case SHARKD_TAP_JOB_QUEUED:
+			state = "queued";
+			frames = 0;
+			break;
+		case SHARKD_TAP_JOB_RUNNING:
+			state = "running";
+			frames = sharkd_retap_position();
+			break;
+		default:
+			state = "done";
+			frames = cfile.count;
+			break;
+	}
+
+	printf("{\"job\":%u,\"state\":\"%s\",\"frames\":%u,\"total\":%u", job->id, state, frames, cfile.count);
+
+	if (job->state == SHARKD_TAP_JOB_DONE || (job->state == SHARKD_TAP_JOB_RUNNING && tok_partial))
+	{
+		printf(",\"taps\":[");
+		for (i = 0; i < job->taps_count; i++)
+			draw_tap_listener(job->taps_data[i]);
+		printf("null]");
+	}
+
+	printf(",\"err\":0}\n");
+
+	if (job->state == SHARKD_TAP_JOB_DONE)
+		sharkd_session_tap_job_free(job);
+}
+
+/**
+ * sharkd_session_process_tapcancel()
+ *
+ * Process tapcancel request
+ *
+ * Input:
+ *   (m) job - job id
+ *
+ * Output object with attributes:
+ *   (m) err - error code; ENOENT if there's no such job
+ */
+static void
+sharkd_session_process_tapcancel(char *buf, const jsmntok_t *tokens, int count)
+{
+	const char *tok_job = json_find_attr(buf, tokens, count, "job");
+	struct sharkd_tap_job *job;
+
+	job = sharkd_session_tap_job_find(tok_job);
+	if (!job)
+	{
+		printf("{\"err\":%d}\n", ENOENT);
+		return;
+	}
+
+	sharkd_session_tap_job_free(job);
+	printf("{\"err\":0}\n");
+}
+
+/* Is there a request waiting to be read? */
+static gboolean
+sharkd_session_input_pending(void)
+{
+#ifndef _WIN32
+	struct pollfd pfd;
+
+	pfd.fd = fileno(stdin);
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+
+	return (poll(&pfd, 1, 0) != 0);
+#else
+	/* XXX - no cheap check for a pipe; jobs run to completion before the next request */
+	return FALSE;
+#endif
+}
+
+/**
+ * sharkd_session_process_tap()
+ *
+ * Process tap request
+ *
+ * Input:
+ *   (m) tap0         - First tap request
+ *   (o) tap1...tap15 - Other tap requests
+ *   (o) async        - if set, queue the request as a tap job, see sharkd_session_process_tapjob()
+ *
+ * Output object with attributes:
+ *   (o) job   - with async, the id of the job; no taps are returned
+ *   (m) taps  - array of object with attributes:
+ *                  (m) tap  - tap name
+ *                  (m) type - tap output type
+ *                  ...
+ *                  for type:stats see sharkd_session_process_tap_stats_cb()
+ *                  for type:nstat see sharkd_session_process_tap_nstat_cb()
+ *                  for type:conv see sharkd_session_process_tap_conv_cb()
+ *                  for type:host see sharkd_session_process_tap_conv_cb()
+ *                  for type:rtp-streams see sharkd_session_process_tap_rtp_cb()
+ *                  for type:rtp-analyse see sharkd_session_process_tap_rtp_analyse_cb()
+ *                  for type:eo see sharkd_session_process_tap_eo_cb()
+ *                  for type:expert see sharkd_session_process_tap_expert_cb()
+ *                  for type:rtd see sharkd_session_process_tap_rtd_cb()
+ *                  for type:srt see sharkd_session_process_tap_srt_cb()
+ *                  for type:flow see sharkd_session_process_tap_flow_cb()
+ *
+ *   (m) err   - error code; EBUSY if tap jobs are running
+ */
+static void
+sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
+{
+	const char *tok_async = json_find_attr(buf, tokens, count, "async");
+
+	void *taps_data[16];
+	GFreeFunc taps_free[16];
+	int taps_count = 0;
+	int i;
+
+	rtpstream_tapinfo_t rtp_tapinfo =
+		{NULL, NULL, NULL, NULL, 0, NULL, 0, TAP_ANALYSE, NULL, NULL, NULL, FALSE};
+
+	if (tok_async)
+	{
+		sharkd_session_tap_job_submit(buf, tokens, count);
+		return;
+	}
+
+	if (sharkd_session_process_tap_expert_index(buf, tokens, count))
+		return;
+
+	if (sharkd_session_tap_jobs_busy())
+	{
+		printf("{\"err\":%d}\n", EBUSY);
+		return;
+	}
+
+	taps_count = sharkd_session_register_taps(buf, tokens, count, taps_data, taps_free, &rtp_tapinfo);
+
 	fprintf(stderr, "sharkd_session_process_tap() count=%d\n", taps_count);
 	if (taps_count == 0)
 		return;
@@ -2555,6 +3355,12 @@ sharkd_session_process_follow(char *buf, const jsmntok_t *tokens, int count)
 		return;
 	}
 
+	if (sharkd_session_tap_jobs_busy())
+	{
+		printf("{\"err\":%d}\n", EBUSY);
+		return;
+	}
+
 	/* follow_reset_stream ? */
 	follow_info = g_new0(follow_info_t, 1);
 	/* gui_data, filter_out_filter not set, but not used by dissector */
@@ -3157,6 +3963,54 @@ sharkd_session_process_complete_pref_option_cb(pref_t *pref, gpointer d)
 	return 0; /* continue */
 }
 
+struct sharkd_session_process_complete_field_data
+{
+	int with_dot;
+	const char *sepa;
+};
+
+static void
+sharkd_session_process_complete_field_cb(gpointer d, gpointer user_data)
+{
+	header_field_info *hfinfo = (header_field_info *) d;
+	struct sharkd_session_process_complete_field_data *data = (struct sharkd_session_process_complete_field_data *) user_data;
+
+	if (hfinfo->parent == -1)
+	{
+		printf("%s{", data->sepa);
+		{
+			printf("\"f\":");
+			json_puts_string(hfinfo->abbrev);
+			printf(",\"t\":%d", FT_PROTOCOL);
+			printf(",\"n\":");
+			json_puts_string(hfinfo->name);
+		}
+		printf("}");
+		data->sepa = ",";
+		return;
+	}
+
+	/* fields only once past the protocol name */
+	if (!data->with_dot)
+		return;
+
+	printf("%s{", data->sepa);
+	{
+		printf("\"f\":");
+		json_puts_string(hfinfo->abbrev);
+
+		/* XXX, skip displaying name, if there are multiple (to not confuse user) */
+		if (hfinfo->same_name_next == NULL)
+		{
+			printf(",\"t\":%d", hfinfo->type);
+			printf(",\"n\":");
+			json_puts_string(hfinfo->name);
+		}
+	}
+	printf("}");
+	data->sepa = ",";
+}
+
 /**
  * sharkd_session_process_complete()
  *
@@ -3185,72 +4039,13 @@ sharkd_session_process_complete(char *buf, const jsmntok_t *tokens, int count)
 	printf("{\"err\":0");
 	if (tok_field != NULL && tok_field[0])
 	{
-		const size_t filter_length = strlen(tok_field);
-		const int filter_with_dot = !!strchr(tok_field, '.');
+		struct sharkd_session_process_complete_field_data data;
 
-		void *proto_cookie;
-		void *field_cookie;
-		int proto_id;
-		const char *sepa = "";
+		data.with_dot = !!strchr(tok_field, '.');
+		data.sepa = "";
 
 		printf(",\"field\":[");
-
-		for (proto_id = proto_get_first_protocol(&proto_cookie); proto_id != -1; proto_id = proto_get_next_protocol(&proto_cookie))
-		{
-			protocol_t *protocol = find_protocol_by_id(proto_id);
-			const char *protocol_filter;
-			const char *protocol_name;
-			header_field_info *hfinfo;
-
-			if (!proto_is_protocol_enabled(protocol))
-				continue;
-
-			protocol_name   = proto_get_protocol_long_name(protocol);
-			protocol_filter = proto_get_protocol_filter_name(proto_id);
-
-			if (strlen(protocol_filter) >= filter_length && !g_ascii_strncasecmp(tok_field, protocol_filter, filter_length))
-			{
-				printf("%s{", sepa);
-				{
-					printf("\"f\":");
-					json_puts_string(protocol_filter);
-					printf(",\"t\":%d", FT_PROTOCOL);
-					printf(",\"n\":");
-					json_puts_string(protocol_name);
-				}
-				printf("}");
-				sepa = ",";
-			}
-
-			if (!filter_with_dot)
-				continue;
-
-			for (hfinfo = proto_get_first_protocol_field(proto_id, &field_cookie); hfinfo != NULL; hfinfo = proto_get_next_protocol_field(proto_id, &field_cookie))
-			{
-				if (hfinfo->same_name_prev_id != -1) /* ignore duplicate names */
-					continue;
-
-				if (strlen(hfinfo->abbrev) >= filter_length && !g_ascii_strncasecmp(tok_field, hfinfo->abbrev, filter_length))
-				{
-					printf("%s{", sepa);
-					{
-						printf("\"f\":");
-						json_puts_string(hfinfo->abbrev);
-
-						/* XXX, skip displaying name, if there are multiple (to not confuse user) */
-						if (hfinfo->same_name_next == NULL)
-						{
-							printf(",\"t\":%d", hfinfo->type);
-							printf(",\"n\":");
-							json_puts_string(hfinfo->name);
-						}
-					}
-					printf("}");
-					sepa = ",";
-				}
-			}
-		}
-
+		proto_registrar_foreach_prefix(tok_field, sharkd_session_process_complete_field_cb, &data);
 		printf("]");
 	}
 
@@ -3319,6 +4114,12 @@ sharkd_session_process_setconf(char *buf, const jsmntok_t *tokens, int count)
 	ws_snprintf(pref, sizeof(pref), "%s:%s", tok_name, tok_value);
 
 	ret = prefs_set_pref(pref, &errmsg);
+	/* the preference may change what the columns show, and what the filters match */
+	sharkd_session_columns_cache_clear();
+	sharkd_session_filter_clear();
+	/* the persisted results were made with the preferences from the profile */
+	g_free(filter_cache_dir);
+	filter_cache_dir = NULL;
 	printf("{\"err\":%d", ret);
 	if (errmsg)
 	{
@@ -3805,6 +4606,12 @@ sharkd_session_process_download(char *buf, const jsmntok_t *tokens, int count)
 		struct sharkd_download_rtp rtp_req;
 		GString *tap_error;
 
+		if (sharkd_session_tap_jobs_busy())
+		{
+			printf("{\"err\":%d}\n", EBUSY);
+			return;
+		}
+
 		memset(&rtp_req, 0, sizeof(rtp_req));
 		if (!sharkd_rtp_match_init(&rtp_req.rtp, tok_token + 4))
 		{
@@ -3905,6 +4712,8 @@ sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
 			sharkd_session_process_load(buf, tokens, count);
 		else if (!strcmp(tok_req, "status"))
 			sharkd_session_process_status();
+		else if (!strcmp(tok_req, "profile"))
+			sharkd_session_process_profile(buf, tokens, count);
 		else if (!strcmp(tok_req, "analyse"))
 			sharkd_session_process_analyse();
 		else if (!strcmp(tok_req, "info"))
@@ -3917,6 +4726,10 @@ sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
 			sharkd_session_process_frames(buf, tokens, count);
 		else if (!strcmp(tok_req, "tap"))
 			sharkd_session_process_tap(buf, tokens, count);
+		else if (!strcmp(tok_req, "tapjob"))
+			sharkd_session_process_tapjob(buf, tokens, count);
+		else if (!strcmp(tok_req, "tapcancel"))
+			sharkd_session_process_tapcancel(buf, tokens, count);
 		else if (!strcmp(tok_req, "follow"))
 			sharkd_session_process_follow(buf, tokens, count);
 		else if (!strcmp(tok_req, "intervals"))
@@ -3952,6 +4765,9 @@ sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
 		 * which is what you get if you request line buffering.
 		 */
 		fflush(stdout);
+
+		/* now that the reply is out, get ahead on the next "frames" request */
+		sharkd_session_columns_prefetch();
 	}
 }
 
@@ -3964,11 +4780,23 @@ sharkd_session_main(void)
 
 	fprintf(stderr, "Hello in child.\n");
 
-	while (fgets(buf, sizeof(buf), stdin))
+#ifndef _WIN32
+	/* no requests hidden in the stdio buffer while tap jobs check for input */
+	setvbuf(stdin, NULL, _IONBF, 0);
+#endif
+
+	for (;;)
 	{
 		/* every command is line seperated JSON */
 		int ret;
 
+		/* run the tap jobs until there's a request */
+		while (!sharkd_session_input_pending() && sharkd_session_tap_jobs_step())
+			;
+
+		if (!fgets(buf, sizeof(buf), stdin))
+			break;
+
 		ret = wsjsmn_parse(buf, NULL, 0);
 		if (ret < 0)
 		{
@@ -22,86 +22,21 @@
 
 #include <config.h>
 
+#include <string.h>
+
 #include <wiretap/pcap-encap.h>
 #include <wiretap/wtap_opttypes.h>
 #include <wiretap/pcapng.h>
 
 #include <epan/packet.h>
 #include "cfile.h"
+#include "file.h"
 #include "summary.h"
 
-static void
-tally_frame_data(frame_data *cur_frame, summary_tally *sum_tally)
-{
-  double cur_time;
-
-  sum_tally->bytes += cur_frame->pkt_len;
-  if (cur_frame->flags.passed_dfilter){
-    sum_tally->filtered_count++;
-    sum_tally->filtered_bytes += cur_frame->pkt_len;
-  }
-  if (cur_frame->flags.marked){
-    sum_tally->marked_count++;
-    sum_tally->marked_bytes += cur_frame->pkt_len;
-  }
-  if (cur_frame->flags.ignored){
-    sum_tally->ignored_count++;
-  }
-
-  if (cur_frame->flags.has_ts) {
-    /* This packet has a time stamp. */
-    cur_time = nstime_to_sec(&cur_frame->abs_ts);
-
-    sum_tally->packet_count_ts++;
-    if (cur_time < sum_tally->start_time) {
-      sum_tally->start_time = cur_time;
-    }
-    if (cur_time > sum_tally->stop_time){
-      sum_tally->stop_time = cur_time;
-    }
-    if (cur_frame->flags.passed_dfilter){
-      sum_tally->filtered_count_ts++;
-      /*
-       * If we've seen one filtered packet, this is the first
-       * one.
-       */
-      if (sum_tally->filtered_count == 1){
-        sum_tally->filtered_start= cur_time;
-        sum_tally->filtered_stop = cur_time;
-      } else {
-        if (cur_time < sum_tally->filtered_start) {
-          sum_tally->filtered_start = cur_time;
-        }
-        if (cur_time > sum_tally->filtered_stop) {
-          sum_tally->filtered_stop = cur_time;
-        }
-      }
-    }
-    if (cur_frame->flags.marked){
-      sum_tally->marked_count_ts++;
-      /*
-       * If we've seen one marked packet, this is the first
-       * one.
-       */
-      if (sum_tally->marked_count == 1){
-        sum_tally->marked_start= cur_time;
-        sum_tally->marked_stop = cur_time;
-      } else {
-        if (cur_time < sum_tally->marked_start) {
-          sum_tally->marked_start = cur_time;
-        }
-        if (cur_time > sum_tally->marked_stop) {
-          sum_tally->marked_stop = cur_time;
-        }
-      }
-    }
-  }
-}
-
 void
 summary_fill_in(capture_file *cf, summary_tally *st)
 {
-  frame_data    *first_frame, *cur_frame;
+  frame_data    *cur_frame;
   guint32        framenum;
   iface_options iface;
   guint i;
@@ -113,34 +48,37 @@ summary_fill_in(capture_file *cf, summary_tally *st)
   char* if_string;
   wtapng_if_descr_filter_t* if_filter;
 
-  st->packet_count_ts = 0;
-  st->start_time = 0;
-  st->stop_time = 0;
-  st->bytes = 0;
-  st->filtered_count = 0;
-  st->filtered_count_ts = 0;
-  st->filtered_start = 0;
-  st->filtered_stop = 0;
-  st->filtered_bytes = 0;
-  st->marked_count = 0;
-  st->marked_count_ts = 0;
-  st->marked_start = 0;
-  st->marked_stop = 0;
-  st->marked_bytes = 0;
-  st->ignored_count = 0;
-
-  /* initialize the tally */
-  if (cf->count != 0) {
-    first_frame = frame_data_sequence_find(cf->frames, 1);
-    st->start_time = nstime_to_sec(&first_frame->abs_ts);
-    st->stop_time = nstime_to_sec(&first_frame->abs_ts);
-
+  /*
+   * The totals are kept up to date as frames are read, filtered and
+   * marked; only unmarking can leave the time span of the marked
+   * frames to be worked out again.
+   */
+  if (cf->marked_times_stale) {
+    memset(&cf->marked_totals, 0, sizeof cf->marked_totals);
     for (framenum = 1; framenum <= cf->count; framenum++) {
       cur_frame = frame_data_sequence_find(cf->frames, framenum);
-      tally_frame_data(cur_frame, st);
+      if (cur_frame->flags.marked)
+        cf_frame_totals_add(&cf->marked_totals, cur_frame);
     }
+    cf->marked_times_stale = FALSE;
   }
 
+  st->packet_count_ts = cf->all_totals.count_ts;
+  st->start_time = nstime_to_sec(&cf->all_totals.start);
+  st->stop_time = nstime_to_sec(&cf->all_totals.stop);
+  st->bytes = cf->all_totals.bytes;
+  st->filtered_count = cf->filtered_totals.count;
+  st->filtered_count_ts = cf->filtered_totals.count_ts;
+  st->filtered_start = nstime_to_sec(&cf->filtered_totals.start);
+  st->filtered_stop = nstime_to_sec(&cf->filtered_totals.stop);
+  st->filtered_bytes = cf->filtered_totals.bytes;
+  st->marked_count = cf->marked_totals.count;
+  st->marked_count_ts = cf->marked_totals.count_ts;
+  st->marked_start = nstime_to_sec(&cf->marked_totals.start);
+  st->marked_stop = nstime_to_sec(&cf->marked_totals.stop);
+  st->marked_bytes = cf->marked_totals.bytes;
+  st->ignored_count = cf->ignored_count;
+
   st->filename = cf->filename;
   st->file_length = cf->f_datalen;
   st->file_type = cf->cd_t;
@@ -400,6 +400,9 @@ static hdr_data_chunk_t HDR_DATA_CHUNK = {0, 0, 0, 0, 0, 0, 0};
 
 static char tempbuf[64];
 
+/* Size of the input and output stdio buffers */
+#define IO_BUFFER_SIZE  (1024 * 1024)
+
 /*----------------------------------------------------------------------
  * Stuff for writing a PCap file
  */
@@ -431,18 +434,23 @@ parse_num(const char *str, int offset, guint32* num)
     return EXIT_SUCCESS;
 }
 
+/* Value of a character the scanner has matched as a hex digit */
+#define HEX_DIGIT_VALUE(c) ((c) <= '9' ? (c) - '0' : ((c) | 0x20) - 'a' + 10)
+
 /*----------------------------------------------------------------------
  * Write this byte into current packet
  */
 static int
 write_byte(const char *str)
 {
-    guint32 num;
-
-    if (parse_num(str, FALSE, &num) != EXIT_SUCCESS)
+    if (str == NULL) {
+        fprintf(stderr, "FATAL ERROR: str is NULL\n");
         return EXIT_FAILURE;
+    }
 
-    packet_buf[curr_offset] = (guint8) num;
+    /* The scanner only passes bytes as exactly two hex digits */
+    packet_buf[curr_offset] = (guint8) ((HEX_DIGIT_VALUE(str[0]) << 4) |
+                                        HEX_DIGIT_VALUE(str[1]));
     curr_offset++;
     if (curr_offset - header_length >= max_offset) /* packet full */
         if (start_new_packet(TRUE) != EXIT_SUCCESS)
@@ -1889,6 +1897,13 @@ main(int argc, char *argv[])
     assert(input_file  != NULL);
     assert(output_file != NULL);
 
+    /*
+     * Hex dumps are several times the size of the capture; read and
+     * write in large blocks rather than stdio's default few KB.
+     */
+    setvbuf(input_file, NULL, _IOFBF, IO_BUFFER_SIZE);
+    setvbuf(output_file, NULL, _IOFBF, IO_BUFFER_SIZE);
+
     if (write_file_header() != EXIT_SUCCESS) {
         ret = EXIT_FAILURE;
         goto clean_exit;
@@ -1071,6 +1071,7 @@ tfshark_epan_new(capture_file *cf)
 
   epan->data = cf;
   epan->get_frame_ts = tfshark_get_frame_ts;
+  epan->get_frame_shift_offset = NULL;
   epan->get_interface_name = no_interface_name;
   epan->get_user_comment = NULL;
 
@@ -1133,7 +1134,7 @@ process_packet_first_pass(capture_file *cf, epan_dissect_t *edt,
      * epan hasn't been initialized.
      */
     if (edt) {
-      g_slist_foreach(edt->pi.dependent_frames, find_and_mark_frame_depended_upon, cf->frames);
+      frame_data_sequence_mark_depended_upon(cf->frames, edt->pi.dependent_frames);
     }
 
     cf->count++;
@@ -0,0 +1,593 @@
+/* dissect-bench.c
+ *
+ * Measure dissection throughput over a set of captures in fixed
+ * scenarios, for tracking performance across releases
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Every capture is read into memory first, so only dissection is timed.
+ * Each scenario is run over all the packets of a capture the given
+ * number of times, in a fresh epan session each time, and one line of
+ * JSON is printed per capture and scenario:
+ *
+ *   {"file":"http.pcap","scenario":"tree","iterations":5,"packets":1000,
+ *    "best_s":0.012,"mean_s":0.013,"packets_per_s":83333.3,
+ *    "ns_per_packet":12000.0,"tree_nodes_per_packet":42.1,"peak_rss_kb":51200}
+ *
+ * The times and rates come from the fastest iteration.  peak_rss_kb is
+ * the peak of the whole process so far, so run one scenario per process
+ * to compare it between scenarios.  tree_nodes_per_packet counts the
+ * proto_nodes allocated for each packet's tree, the bulk of what
+ * dissection allocates; use an external heap profiler for an exact
+ * count of allocations.
+ */
+
+#include <config.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#ifndef _WIN32
+#include <sys/time.h>
+#include <sys/resource.h>
+#endif
+
+#ifdef HAVE_GETOPT_H
+#include <getopt.h>
+#endif
+
+#ifndef HAVE_GETOPT_LONG
+#include "wsutil/wsgetopt.h"
+#endif
+
+#include <glib.h>
+
+#include <epan/epan-int.h>
+#include <epan/epan.h>
+
+#include <wsutil/cmdarg_err.h>
+#include <wsutil/filesystem.h>
+#include <wsutil/glib-compat.h>
+#include <wsutil/privileges.h>
+#include <wsutil/report_message.h>
+#include <wsutil/ws_printf.h>
+
+#include <wiretap/wtap.h>
+
+#include <epan/timestamp.h>
+#include <epan/prefs.h>
+#include <epan/column.h>
+#include <epan/print.h>
+#include <epan/epan_dissect.h>
+#include <epan/dfilter/dfilter.h>
+
+#include "ui/failure_message.h"
+
+#ifdef HAVE_PLUGINS
+#include <wsutil/plugins.h>
+#endif
+
+#ifdef _WIN32
+#define NULL_DEVICE "NUL"
+#else
+#define NULL_DEVICE "/dev/null"
+#endif
+
+#define DEFAULT_ITERATIONS	5
+#define DEFAULT_FILTER		"tcp.port == 80 || udp.port == 53"
+
+typedef enum {
+	SCENARIO_NO_TREE,	/* what tshark does with no options */
+	SCENARIO_TREE,		/* an invisible tree, as for taps */
+	SCENARIO_FILTER,	/* -Y filter */
+	SCENARIO_FIELDS,	/* -T fields -e ... */
+	SCENARIO_JSON,		/* -T json */
+	SCENARIO_TWO_PASS	/* -2: no tree, then a tree over visited frames */
+} scenario_e;
+
+static const struct {
+	const char	*name;
+	scenario_e	 scenario;
+} scenarios[] = {
+	{ "notree",	SCENARIO_NO_TREE },
+	{ "tree",	SCENARIO_TREE },
+	{ "filter",	SCENARIO_FILTER },
+	{ "fields",	SCENARIO_FIELDS },
+	{ "json",	SCENARIO_JSON },
+	{ "twopass",	SCENARIO_TWO_PASS }
+};
+
+#define N_SCENARIOS	G_N_ELEMENTS(scenarios)
+
+static const char *default_fields[] = {
+	"frame.number", "ip.src", "ip.dst", "tcp.srcport", "tcp.dstport", "udp.srcport", "udp.dstport"
+};
+
+/* A packet of a capture, as read */
+typedef struct {
+	struct wtap_pkthdr	 phdr;
+	guint8			*data;
+} bench_packet_t;
+
+typedef struct {
+	const char	*filename;
+	int		 file_type_subtype;
+	GArray		*packets;	/* bench_packet_t */
+	frame_data	*frames;	/* for the pass being run */
+} bench_capture_t;
+
+static const char *filter_text = DEFAULT_FILTER;
+static dfilter_t *filter_code;
+static output_fields_t *output_fields;
+static FILE *null_fh;
+
+static void
+failure_warning_message(const char *msg_format, va_list ap)
+{
+	fprintf(stderr, "dissect-bench: ");
+	vfprintf(stderr, msg_format, ap);
+	fprintf(stderr, "\n");
+}
+
+static void
+open_failure_message(const char *filename, int err, gboolean for_writing)
+{
+	fprintf(stderr, "dissect-bench: ");
+	fprintf(stderr, file_open_error_message(err, for_writing), filename);
+	fprintf(stderr, "\n");
+}
+
+static void
+read_failure_message(const char *filename, int err)
+{
+	cmdarg_err("An error occurred while reading from the file \"%s\": %s.", filename, g_strerror(err));
+}
+
+static void
+write_failure_message(const char *filename, int err)
+{
+	cmdarg_err("An error occurred while writing to the file \"%s\": %s.", filename, g_strerror(err));
+}
+
+static void
+failure_message_cont(const char *msg_format, va_list ap)
+{
+	vfprintf(stderr, msg_format, ap);
+	fprintf(stderr, "\n");
+}
+
+static const nstime_t *
+bench_get_frame_ts(void *data, guint32 frame_num)
+{
+	bench_capture_t *capture = (bench_capture_t *)data;
+
+	if (capture->frames == NULL || frame_num == 0 || frame_num > capture->packets->len)
+		return NULL;
+	return &capture->frames[frame_num - 1].abs_ts;
+}
+
+static epan_t *
+bench_epan_new(bench_capture_t *capture)
+{
+	epan_t *epan = epan_new();
+
+	epan->data = capture;
+	epan->get_frame_ts = bench_get_frame_ts;
+	epan->get_frame_shift_offset = NULL;
+	epan->get_interface_name = NULL;
+	epan->get_interface_description = NULL;
+	epan->get_user_comment = NULL;
+
+	return epan;
+}
+
+static bench_capture_t *
+bench_capture_load(const char *filename)
+{
+	bench_capture_t	*capture;
+	bench_packet_t	 packet;
+	wtap		*wth;
+	int		 err;
+	gchar		*err_info = NULL;
+	gint64		 data_offset;
+
+	wth = wtap_open_offline(filename, WTAP_TYPE_AUTO, &err, &err_info, FALSE);
+	if (wth == NULL) {
+		cfile_open_failure_message("dissect-bench", filename, err, err_info);
+		return NULL;
+	}
+
+	capture = g_new0(bench_capture_t, 1);
+	capture->filename = filename;
+	capture->file_type_subtype = wtap_file_type_subtype(wth);
+	capture->packets = g_array_new(FALSE, FALSE, sizeof(bench_packet_t));
+
+	while (wtap_read(wth, &err, &err_info, &data_offset)) {
+		packet.phdr = *wtap_phdr(wth);
+		/* Only the header fields and pseudo-header are kept */
+		packet.phdr.opt_comment = NULL;
+		memset(&packet.phdr.ft_specific_data, 0, sizeof packet.phdr.ft_specific_data);
+		packet.data = (guint8 *)g_memdup(wtap_buf_ptr(wth), packet.phdr.caplen);
+		g_array_append_val(capture->packets, packet);
+	}
+	if (err != 0)
+		cfile_read_failure_message("dissect-bench", filename, err, err_info);
+
+	wtap_close(wth);
+	return capture;
+}
+
+static void
+bench_capture_free(bench_capture_t *capture)
+{
+	guint i;
+
+	for (i = 0; i < capture->packets->len; i++)
+		g_free(g_array_index(capture->packets, bench_packet_t, i).data);
+	g_array_free(capture->packets, TRUE);
+	g_free(capture);
+}
+
+/* Dissect every packet once into edt; returns the tree nodes allocated */
+static guint64
+bench_pass(bench_capture_t *capture, epan_dissect_t *edt, scenario_e scenario, gboolean first_pass)
+{
+	bench_packet_t	*packet;
+	frame_data	*fdata;
+	const frame_data *ref = NULL;
+	frame_data	*prev_dis = NULL;
+	nstime_t	 elapsed_time;
+	guint32		 cum_bytes = 0;
+	guint64		 nodes = 0;
+	guint		 i;
+
+	nstime_set_zero(&elapsed_time);
+
+	for (i = 0; i < capture->packets->len; i++) {
+		packet = &g_array_index(capture->packets, bench_packet_t, i);
+		fdata = &capture->frames[i];
+
+		if (first_pass)
+			frame_data_init(fdata, i + 1, &packet->phdr, 0, cum_bytes);
+		frame_data_set_before_dissect(fdata, &elapsed_time, &ref, prev_dis);
+
+		if (scenario == SCENARIO_FILTER)
+			epan_dissect_prime_with_dfilter(edt, filter_code);
+		else if (scenario == SCENARIO_FIELDS)
+			output_fields_prime_edt(output_fields, edt);
+
+		epan_dissect_run(edt, capture->file_type_subtype, &packet->phdr,
+			tvb_new_real_data(packet->data, packet->phdr.caplen, packet->phdr.caplen),
+			fdata, NULL);
+
+		switch (scenario) {
+			case SCENARIO_FILTER:
+				if (dfilter_apply_edt(filter_code, edt))
+					frame_data_set_after_dissect(fdata, &cum_bytes);
+				break;
+			case SCENARIO_FIELDS:
+				write_fields_proto_tree(output_fields, edt, NULL, null_fh);
+				frame_data_set_after_dissect(fdata, &cum_bytes);
+				break;
+			case SCENARIO_JSON:
+				write_json_proto_tree(NULL, print_dissections_expanded, FALSE, NULL, PF_NONE,
+					edt, proto_node_group_children_by_unique, null_fh);
+				frame_data_set_after_dissect(fdata, &cum_bytes);
+				break;
+			default:
+				frame_data_set_after_dissect(fdata, &cum_bytes);
+				break;
+		}
+		prev_dis = fdata;
+
+		nodes += proto_tree_get_nodes_allocated(edt->tree);
+		epan_dissect_reset(edt);
+	}
+
+	return nodes;
+}
+
+/* Run the scenario over the capture once; returns the seconds taken */
+static double
+bench_run(bench_capture_t *capture, scenario_e scenario, guint64 *nodes)
+{
+	epan_t		*epan;
+	epan_dissect_t	*edt;
+	gint64		 start, end;
+	guint		 i;
+
+	capture->frames = g_new0(frame_data, capture->packets->len);
+	epan = bench_epan_new(capture);
+
+	start = g_get_monotonic_time();
+	switch (scenario) {
+		case SCENARIO_NO_TREE:
+			edt = epan_dissect_new(epan, FALSE, FALSE);
+			*nodes = bench_pass(capture, edt, scenario, TRUE);
+			break;
+		case SCENARIO_JSON:
+			edt = epan_dissect_new(epan, TRUE, TRUE);
+			*nodes = bench_pass(capture, edt, scenario, TRUE);
+			break;
+		case SCENARIO_TWO_PASS:
+			edt = epan_dissect_new(epan, FALSE, FALSE);
+			bench_pass(capture, edt, SCENARIO_NO_TREE, TRUE);
+			epan_dissect_free(edt);
+			edt = epan_dissect_new(epan, TRUE, FALSE);
+			*nodes = bench_pass(capture, edt, scenario, FALSE);
+			break;
+		default:
+			edt = epan_dissect_new(epan, TRUE, FALSE);
+			*nodes = bench_pass(capture, edt, scenario, TRUE);
+			break;
+	}
+	epan_dissect_free(edt);
+	end = g_get_monotonic_time();
+
+	epan_free(epan);
+	for (i = 0; i < capture->packets->len; i++)
+		frame_data_destroy(&capture->frames[i]);
+	g_free(capture->frames);
+	capture->frames = NULL;
+
+	return (double)(end - start) / 1000000.0;
+}
+
+static long
+bench_peak_rss_kb(void)
+{
+#ifndef _WIN32
+	struct rusage usage;
+
+	if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+		return usage.ru_maxrss / 1024;	/* bytes */
+#else
+		return usage.ru_maxrss;		/* kilobytes */
+#endif
+	}
+#endif
+	return -1;
+}
+
+static void
+bench_report(bench_capture_t *capture, guint s, guint iterations)
+{
+	double		 seconds, best = 0.0, total = 0.0;
+	guint64		 nodes = 0;
+	guint		 i;
+	guint		 packets = capture->packets->len;
+	char		*basename;
+
+	for (i = 0; i < iterations; i++) {
+		seconds = bench_run(capture, scenarios[s].scenario, &nodes);
+		if (i == 0 || seconds < best)
+			best = seconds;
+		total += seconds;
+	}
+
+	basename = g_path_get_basename(capture->filename);
+	printf("{\"file\":\"%s\",\"scenario\":\"%s\",\"iterations\":%u,\"packets\":%u"
+	       ",\"best_s\":%.6f,\"mean_s\":%.6f,\"packets_per_s\":%.1f,\"ns_per_packet\":%.1f"
+	       ",\"tree_nodes_per_packet\":%.1f,\"peak_rss_kb\":%ld}\n",
+	       basename, scenarios[s].name, iterations, packets,
+	       best, total / iterations,
+	       best > 0.0 ? packets / best : 0.0,
+	       packets ? best * 1e9 / packets : 0.0,
+	       packets ? (double)nodes / packets : 0.0,
+	       bench_peak_rss_kb());
+	fflush(stdout);
+	g_free(basename);
+}
+
+static void
+print_usage(FILE *output)
+{
+	guint s;
+
+	fprintf(output, "\n");
+	fprintf(output, "Usage: dissect-bench [options] <infile> ...\n");
+	fprintf(output, "\n");
+	fprintf(output, "  -n <iterations>          times to run each scenario (default %d)\n", DEFAULT_ITERATIONS);
+	fprintf(output, "  -s <scenario>[,...]      scenarios to run (default all):");
+	for (s = 0; s < N_SCENARIOS; s++)
+		fprintf(output, " %s", scenarios[s].name);
+	fprintf(output, "\n");
+	fprintf(output, "  -Y <display filter>      filter for the \"filter\" scenario\n");
+	fprintf(output, "                           (default \"%s\")\n", DEFAULT_FILTER);
+	fprintf(output, "  -e <field>               field for the \"fields\" scenario; repeat for more\n");
+	fprintf(output, "  -h                       display this help and exit\n");
+}
+
+static int
+bench_init(int argc _U_, char **argv)
+{
+	char	*init_progfile_dir_error;
+	e_prefs	*prefs_p;
+
+	cmdarg_err_init(failure_warning_message, failure_message_cont);
+
+	init_process_policies();
+	relinquish_special_privs_perm();
+
+	init_progfile_dir_error = init_progfile_dir(argv[0], bench_init);
+	if (init_progfile_dir_error != NULL) {
+		fprintf(stderr, "dissect-bench: Can't get pathname of dissect-bench program: %s.\n", init_progfile_dir_error);
+		g_free(init_progfile_dir_error);
+	}
+
+	init_report_message(failure_warning_message, failure_warning_message,
+	     open_failure_message, read_failure_message, write_failure_message);
+
+	timestamp_set_type(TS_RELATIVE);
+	timestamp_set_precision(TS_PREC_AUTO);
+	timestamp_set_seconds_type(TS_SECONDS_DEFAULT);
+
+	wtap_init();
+
+#ifdef HAVE_PLUGINS
+	epan_register_plugin_types();
+	scan_plugins(REPORT_LOAD_FAILURE);
+	register_all_wiretap_modules();
+#endif
+
+	if (!epan_init(register_all_protocols, register_all_protocol_handoffs, NULL, NULL))
+		return 2;
+
+	prefs_p = epan_load_settings();
+	(void)prefs_p;
+	prefs_apply_all();
+
+	return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+	guint		 iterations = DEFAULT_ITERATIONS;
+	gboolean	 run[N_SCENARIOS];
+	gboolean	 scenario_given = FALSE;
+	GPtrArray	*fields;
+	gchar		**names;
+	gchar		*err_msg;
+	bench_capture_t	*capture;
+	int		 opt, i, ret;
+	guint		 s, j;
+
+	fields = g_ptr_array_new();
+	for (s = 0; s < N_SCENARIOS; s++)
+		run[s] = TRUE;
+
+	while ((opt = getopt(argc, argv, "e:hn:s:Y:")) != -1) {
+		switch (opt) {
+			case 'e':
+				g_ptr_array_add(fields, optarg);
+				break;
+			case 'h':
+				print_usage(stdout);
+				return 0;
+			case 'n':
+				iterations = (guint)strtoul(optarg, NULL, 10);
+				if (iterations == 0) {
+					fprintf(stderr, "dissect-bench: \"%s\" isn't a valid iteration count\n", optarg);
+					return 1;
+				}
+				break;
+			case 's':
+				if (!scenario_given) {
+					for (s = 0; s < N_SCENARIOS; s++)
+						run[s] = FALSE;
+					scenario_given = TRUE;
+				}
+				names = g_strsplit(optarg, ",", -1);
+				for (i = 0; names[i] != NULL; i++) {
+					for (s = 0; s < N_SCENARIOS; s++) {
+						if (strcmp(names[i], scenarios[s].name) == 0)
+							break;
+					}
+					if (s == N_SCENARIOS) {
+						fprintf(stderr, "dissect-bench: \"%s\" isn't a scenario\n", names[i]);
+						g_strfreev(names);
+						return 1;
+					}
+					run[s] = TRUE;
+				}
+				g_strfreev(names);
+				break;
+			case 'Y':
+				filter_text = optarg;
+				break;
+			default:
+				print_usage(stderr);
+				return 1;
+		}
+	}
+	if (optind >= argc) {
+		print_usage(stderr);
+		return 1;
+	}
+
+	ret = bench_init(argc, argv);
+	if (ret != 0)
+		return ret;
+
+	if (!dfilter_compile(filter_text, &filter_code, &err_msg)) {
+		cmdarg_err("%s", err_msg);
+		g_free(err_msg);
+		return 1;
+	}
+
+	output_fields = output_fields_new();
+	if (fields->len == 0) {
+		for (j = 0; j < G_N_ELEMENTS(default_fields); j++)
+			output_fields_add(output_fields, default_fields[j]);
+	} else {
+		for (j = 0; j < fields->len; j++)
+			output_fields_add(output_fields, (const gchar *)g_ptr_array_index(fields, j));
+	}
+
+	null_fh = fopen(NULL_DEVICE, "w");
+	if (null_fh == NULL) {
+		fprintf(stderr, "dissect-bench: Can't open %s: %s\n", NULL_DEVICE, g_strerror(errno));
+		return 2;
+	}
+
+	for (i = optind; i < argc; i++) {
+		capture = bench_capture_load(argv[i]);
+		if (capture == NULL) {
+			ret = 2;
+			continue;
+		}
+		for (s = 0; s < N_SCENARIOS; s++) {
+			if (run[s])
+				bench_report(capture, s, iterations);
+		}
+		bench_capture_free(capture);
+	}
+
+	fclose(null_fh);
+	output_fields_free(output_fields);
+	dfilter_free(filter_code);
+	g_ptr_array_free(fields, TRUE);
+	epan_cleanup();
+	wtap_cleanup();
+	free_progdirs();
+#ifdef HAVE_PLUGINS
+	plugins_cleanup();
+#endif
+
+	return ret;
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -27,6 +27,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <limits.h>
+#include <errno.h>
 
 #include <glib.h>
 
@@ -36,8 +37,10 @@
 #include <wsutil/cmdarg_err.h>
 #include <wsutil/crash_info.h>
 #include <wsutil/filesystem.h>
+#include <wsutil/file_util.h>
 #include <wsutil/privileges.h>
 #include <wsutil/report_message.h>
+#include <wsutil/glib-compat.h>
 #include <version_info.h>
 
 #include <wiretap/wtap.h>
@@ -54,10 +57,27 @@
 
 #define EPAN_INIT_FAIL 2
 
+/* Capture file state is thrown away after this many inputs by default */
+#define FUZZ_RESET_INTERVAL 1000
+
 static column_info fuzz_cinfo;
 static epan_t *fuzz_epan;
 static epan_dissect_t *fuzz_edt;
 
+/*
+ * The session is kept from one input to the next, as setting it up means
+ * calling the init routines of every protocol. The inputs are dissected
+ * as frames of a single capture file, so to keep state from piling up
+ * it's started afresh every FUZZSHARK_RESET_INTERVAL inputs (0 never does).
+ * With FUZZSHARK_STATS_INTERVAL set, the dissectors are profiled and the
+ * calls per second of each protocol are reported every that many inputs.
+ */
+static guint fuzz_reset_interval = FUZZ_RESET_INTERVAL;
+static guint fuzz_stats_interval = 0;
+static guint32 fuzz_framenum = 0;
+static guint64 fuzz_inputs = 0;
+static gint64 fuzz_stats_start;
+
 /*
  * General errors and warnings are reported with an console message
  * in oss-fuzzshark.
@@ -123,6 +143,8 @@ fuzzshark_epan_new(void)
 	epan_t *epan = epan_new();
 
 	epan->get_frame_ts = fuzzshark_get_frame_ts;
+
+	epan->get_frame_shift_offset = NULL;
 	epan->get_interface_name = NULL;
 	epan->get_interface_description = NULL;
 	epan->get_user_comment = NULL;
@@ -130,6 +152,49 @@ fuzzshark_epan_new(void)
 	return epan;
 }
 
+static guint
+fuzzshark_getenv_uint(const char *name, guint def)
+{
+	const char *value = g_getenv(name);
+
+	if (value == NULL || *value == '\0')
+		return def;
+	return (guint) strtoul(value, NULL, 10);
+}
+
+static void
+fuzzshark_reset_session(void)
+{
+	epan_dissect_free(fuzz_edt);
+	epan_free(fuzz_epan);
+
+	fuzz_epan = fuzzshark_epan_new();
+	fuzz_edt = epan_dissect_new(fuzz_epan, TRUE, FALSE);
+	fuzz_framenum = 0;
+}
+
+static void
+fuzzshark_report_protocol(int proto_id, const dissector_profile_t *profile, gpointer user_data)
+{
+	double secs = *(double *) user_data;
+
+	fprintf(stderr, "oss-fuzzshark:   %-24s %12" G_GINT64_MODIFIER "u calls %10.0f calls/s %10.2f us/call\n",
+		proto_get_protocol_short_name(find_protocol_by_id(proto_id)),
+		profile->calls,
+		secs > 0 ? (double) profile->calls / secs : 0.0,
+		(double) profile->self_us / (double) profile->calls);
+}
+
+static void
+fuzzshark_report_stats(void)
+{
+	double secs = (double) (g_get_monotonic_time() - fuzz_stats_start) / 1e6;
+
+	fprintf(stderr, "oss-fuzzshark: %" G_GINT64_MODIFIER "u inputs, %.0f exec/s\n",
+		fuzz_inputs, secs > 0 ? (double) fuzz_inputs / secs : 0.0);
+	dissector_profile_foreach(fuzzshark_report_protocol, &secs);
+}
+
 static int
 fuzz_init(int argc _U_, char **argv)
 {
@@ -258,6 +323,14 @@ fuzz_init(int argc _U_, char **argv)
 	register_postdissector(fuzz_handle);
 #endif
 
+	fuzz_reset_interval = fuzzshark_getenv_uint("FUZZSHARK_RESET_INTERVAL", FUZZ_RESET_INTERVAL);
+	fuzz_stats_interval = fuzzshark_getenv_uint("FUZZSHARK_STATS_INTERVAL", 0);
+	if (fuzz_stats_interval != 0) {
+		/* self time is what's left to the protocol's own code */
+		dissector_set_profiling(TRUE);
+		fuzz_stats_start = g_get_monotonic_time();
+	}
+
 	fuzz_epan = fuzzshark_epan_new();
 	fuzz_edt = epan_dissect_new(fuzz_epan, TRUE, FALSE);
 
@@ -275,8 +348,7 @@ clean_exit:
 int
 LLVMFuzzerTestOneInput(guint8 *buf, size_t real_len)
 {
-	static guint32 framenum = 0;
-	epan_dissect_t *edt = fuzz_edt;
+	epan_dissect_t *edt;
 
 	guint32 len = (guint32) real_len;
 
@@ -293,12 +365,20 @@ LLVMFuzzerTestOneInput(guint8 *buf, size_t real_len)
 	whdr.pkt_encap = G_MAXINT16;
 	whdr.presence_flags = WTAP_HAS_TS | WTAP_HAS_CAP_LEN; /* most common flags... */
 
-	frame_data_init(&fdlocal, ++framenum, &whdr, /* offset */ 0, /* cum_bytes */ 0);
+	if (fuzz_reset_interval != 0 && fuzz_framenum >= fuzz_reset_interval)
+		fuzzshark_reset_session();
+	edt = fuzz_edt;
+
+	frame_data_init(&fdlocal, ++fuzz_framenum, &whdr, /* offset */ 0, /* cum_bytes */ 0);
 	/* frame_data_set_before_dissect() not needed */
 	epan_dissect_run(edt, WTAP_FILE_TYPE_SUBTYPE_UNKNOWN, &whdr, tvb_new_real_data(buf, len, len), &fdlocal, NULL /* &fuzz_cinfo */);
 	frame_data_destroy(&fdlocal);
 
 	epan_dissect_reset(edt);
+
+	fuzz_inputs++;
+	if (fuzz_stats_interval != 0 && fuzz_inputs % fuzz_stats_interval == 0)
+		fuzzshark_report_stats();
 	return 0;
 }
 
@@ -318,6 +398,57 @@ LLVMFuzzerInitialize(int *argc, char ***argv)
 	return 0;
 }
 
+#ifdef FUZZ_STANDALONE
+/*
+ * Without a fuzzing engine to provide main(), run the inputs named on the
+ * command line, or else the one on the standard input. Built with
+ * afl-clang-fast, the standard input is read over and over in AFL's
+ * persistent mode, so the process (and the session) outlives the input.
+ */
+#define FUZZ_MAX_LEN 65535
+
+static guint8 fuzz_buf[FUZZ_MAX_LEN];
+
+static void
+fuzzshark_run_file(FILE *fp)
+{
+	size_t len = fread(fuzz_buf, 1, sizeof(fuzz_buf), fp);
+
+	LLVMFuzzerTestOneInput(fuzz_buf, len);
+}
+
+int
+main(int argc, char **argv)
+{
+	FILE *fp;
+	int i;
+
+	LLVMFuzzerInitialize(&argc, &argv);
+
+	if (argc > 1) {
+		for (i = 1; i < argc; i++) {
+			if ((fp = ws_fopen(argv[i], "rb")) == NULL) {
+				fprintf(stderr, "oss-fuzzshark: can't open %s: %s\n", argv[i], g_strerror(errno));
+				continue;
+			}
+			fuzzshark_run_file(fp);
+			fclose(fp);
+		}
+	} else {
+#ifdef __AFL_LOOP
+		while (__AFL_LOOP(1000))
+			fuzzshark_run_file(stdin);
+#else
+		fuzzshark_run_file(stdin);
+#endif
+	}
+
+	if (fuzz_stats_interval != 0)
+		fuzzshark_report_stats();
+	return 0;
+}
+#endif /* FUZZ_STANDALONE */
+
 /*
  * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
  *
@@ -82,6 +82,7 @@
 #include <epan/decode_as.h>
 #include <epan/print.h>
 #include <epan/addr_resolv.h>
+#include <epan/ipproto.h>
 #ifdef HAVE_LIBPCAP
 #include "ui/capture_ui_utils.h"
 #endif
@@ -111,6 +112,7 @@
 #include <epan/exported_pdu.h>
 
 #include "capture_opts.h"
+#include "tshark_fork_server.h"
 
 #include "caputils/capture-pcap-util.h"
 
@@ -129,6 +131,7 @@
 #include <epan/funnel.h>
 
 #include <wsutil/str_util.h>
+#include <wsutil/pint.h>
 #include <wsutil/utf8_entities.h>
 
 #ifdef HAVE_EXTCAP
@@ -158,6 +161,8 @@
  */
 #define LONGOPT_COLOR (65536+1000)
 #define LONGOPT_NO_DUPLICATE_KEYS (65536+1001)
+#define LONGOPT_READ_AHEAD (65536+1002)
+#define LONGOPT_SHARD (65536+1003)
 
 #if 0
 #define tshark_debug(...) g_warning(__VA_ARGS__)
@@ -186,7 +191,8 @@ typedef enum {
   WRITE_FIELDS, /* User defined list of fields */
   WRITE_JSON,   /* JSON */
   WRITE_JSON_RAW,   /* JSON only raw hex */
-  WRITE_EK      /* JSON bulk insert to Elasticsearch */
+  WRITE_EK,     /* JSON bulk insert to Elasticsearch */
+  WRITE_COLUMNAR /* User defined list of fields, as typed binary columns */
   /* Add CSV and the like here */
 } output_action_e;
 
@@ -200,6 +206,7 @@ static gboolean line_buffered;
 static gboolean really_quiet = FALSE;
 static gchar* delimiter_char = " ";
 static gboolean dissect_color = FALSE;
+static gboolean fields_on_demand = FALSE; /* TRUE if only the -e fields have to be dissected */
 
 static print_format_e print_format = PR_FMT_TEXT;
 static print_stream_t *print_stream = NULL;
@@ -209,6 +216,9 @@ static gchar **protocolfilter = NULL;
 static pf_flags protocolfilter_flags = PF_NONE;
 
 static gboolean no_duplicate_keys = FALSE;
+static gboolean read_ahead = FALSE;       /* TRUE if a thread reads packets ahead of dissection */
+static guint shard_index = 0;             /* with --shard, which flows this process dissects */
+static guint shard_count = 1;
 static proto_node_children_grouper_func node_children_grouper = proto_node_group_children_by_unique;
 
 /* The line separator used between packets, changeable via the -S option */
@@ -416,15 +426,15 @@ print_usage(FILE *output)
   fprintf(output, "  -P                       print packet summary even when writing to a file\n");
   fprintf(output, "  -S <separator>           the line separator to print between packets\n");
   fprintf(output, "  -x                       add output of hex and ASCII dump (Packet Bytes)\n");
-  fprintf(output, "  -T pdml|ps|psml|json|jsonraw|ek|tabs|text|fields|?\n");
+  fprintf(output, "  -T pdml|ps|psml|json|jsonraw|ek|tabs|text|fields|columnar|?\n");
   fprintf(output, "                           format of text output (def: text)\n");
   fprintf(output, "  -j <protocolfilter>      protocols layers filter if -T ek|pdml|json selected\n");
   fprintf(output, "                           (e.g. \"ip ip.flags text\", filter does not expand child\n");
   fprintf(output, "                           nodes, unless child is specified also in the filter)\n");
   fprintf(output, "  -J <protocolfilter>      top level protocol filter if -T ek|pdml|json selected\n");
   fprintf(output, "                           (e.g. \"http tcp\", filter which expands all child nodes)\n");
-  fprintf(output, "  -e <field>               field to print if -Tfields selected (e.g. tcp.port,\n");
-  fprintf(output, "                           _ws.col.Info)\n");
+  fprintf(output, "  -e <field>               field to print if -Tfields or -Tcolumnar selected\n");
+  fprintf(output, "                           (e.g. tcp.port, _ws.col.Info)\n");
   fprintf(output, "                           this option can be repeated to print multiple fields\n");
   fprintf(output, "  -E<fieldsoption>=<value> set options for output when -Tfields selected:\n");
   fprintf(output, "     bom=y|n               print a UTF-8 BOM\n");
@@ -456,7 +466,12 @@ print_usage(FILE *output)
   fprintf(output, "                           (Note that attributes are nonstandard)\n");
   fprintf(output, "  --no-duplicate-keys      If -T json is specified, merge duplicate keys in an object\n");
   fprintf(output, "                           into a single key with as value a json array containing all\n");
-  fprintf(output, "                           values");
+  fprintf(output, "                           values\n");
+  fprintf(output, "  --read-ahead             read the capture file on a separate thread while\n");
+  fprintf(output, "                           packets are being dissected\n");
+  fprintf(output, "  --shard <index>/<count>  only dissect the TCP, UDP and SCTP flows that hash\n");
+  fprintf(output, "                           to shard <index> (1..<count>); shard 1 also\n");
+  fprintf(output, "                           dissects all other packets");
 
   fprintf(output, "\n");
   fprintf(output, "Miscellaneous:\n");
@@ -467,6 +482,12 @@ print_usage(FILE *output)
   fprintf(output, "  -G [report]              dump one of several available reports and exit\n");
   fprintf(output, "                           default report=\"fields\"\n");
   fprintf(output, "                           use \"-G ?\" for more help\n");
+#ifndef _WIN32
+  fprintf(output, "  --fork-server <socket>   initialize, then run --fork-client requests\n");
+  fprintf(output, "                           received on <socket> in forked workers\n");
+  fprintf(output, "  --fork-client <socket> [options]\n");
+  fprintf(output, "                           run tshark [options] in a --fork-server worker\n");
+#endif
 #ifdef __linux__
   fprintf(output, "\n");
   fprintf(output, "WARNING: dumpcap will enable kernel BPF JIT compiler if available.\n");
@@ -664,6 +685,70 @@ about_folders(void)
 
 }
 
+/*
+ * Process the options that have to be looked at before libwireshark is
+ * initialized. If it already is, as in a fork server worker, -X options
+ * can no longer take effect, so they are rejected.
+ */
+static gboolean
+process_early_options(int argc, char *argv[], const char *optstring,
+                      const struct option *long_options, gchar **output_only,
+                      gboolean epan_initialized)
+{
+  int opt;
+
+  /* Start from the first argument even if getopt_long() was used before. */
+#ifdef HAVE_OPTRESET
+  optreset = 1;
+  optind = 1;
+#else
+  optind = 0;
+#endif
+  opterr = 0;
+
+  while ((opt = getopt_long(argc, argv, optstring, long_options, NULL)) != -1) {
+    switch (opt) {
+    case 'C':        /* Configuration Profile */
+      if (profile_exists (optarg, FALSE)) {
+        set_profile_name (optarg);
+      } else {
+        cmdarg_err("Configuration Profile \"%s\" does not exist", optarg);
+        return FALSE;
+      }
+      break;
+    case 'P':        /* Print packet summary info even when writing to a file */
+      print_packet_info = TRUE;
+      print_summary = TRUE;
+      break;
+    case 'O':        /* Only output these protocols */
+      g_free(*output_only);
+      *output_only = g_strdup(optarg);
+      /* FALLTHROUGH */
+    case 'V':        /* Verbose */
+      print_details = TRUE;
+      print_packet_info = TRUE;
+      break;
+    case 'x':        /* Print packet data in hex (and ASCII) */
+      print_hex = TRUE;
+      /*  The user asked for hex output, so let's ensure they get it,
+       *  even if they're writing to a file.
+       */
+      print_packet_info = TRUE;
+      break;
+    case 'X':
+      if (epan_initialized) {
+        cmdarg_err("-X can't be used with a fork server; give it to \"tshark --fork-server\" instead.");
+        return FALSE;
+      }
+      ex_opt_add(optarg);
+      break;
+    default:
+      break;
+    }
+  }
+  return TRUE;
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -680,6 +765,8 @@ main(int argc, char *argv[])
     {"export-objects", required_argument, NULL, LONGOPT_EXPORT_OBJECTS},
     {"color", no_argument, NULL, LONGOPT_COLOR},
     {"no-duplicate-keys", no_argument, NULL, LONGOPT_NO_DUPLICATE_KEYS},
+    {"read-ahead", no_argument, NULL, LONGOPT_READ_AHEAD},
+    {"shard", required_argument, NULL, LONGOPT_SHARD},
     {0, 0, 0, 0 }
   };
   gboolean             arg_error = FALSE;
@@ -754,6 +841,12 @@ main(int argc, char *argv[])
 
   cmdarg_err_init(failure_warning_message, failure_message_cont);
 
+#ifndef _WIN32
+  /* Run the rest of the command line in a worker of a "tshark --fork-server". */
+  if (argc >= 3 && strcmp(argv[1], "--fork-client") == 0)
+    return tshark_fork_client(argv[2], argc - 3, argv + 3);
+#endif
+
 #ifdef _WIN32
   arg_list_utf_16to8(argc, argv);
   create_app_running_mutex();
@@ -833,43 +926,9 @@ main(int argc, char *argv[])
    * arguments we can't handle until after initializing libwireshark,
    * and then process them after initializing libwireshark?
    */
-  opterr = 0;
-
-  while ((opt = getopt_long(argc, argv, optstring, long_options, NULL)) != -1) {
-    switch (opt) {
-    case 'C':        /* Configuration Profile */
-      if (profile_exists (optarg, FALSE)) {
-        set_profile_name (optarg);
-      } else {
-        cmdarg_err("Configuration Profile \"%s\" does not exist", optarg);
-        exit_status = INVALID_OPTION;
-        goto clean_exit;
-      }
-      break;
-    case 'P':        /* Print packet summary info even when writing to a file */
-      print_packet_info = TRUE;
-      print_summary = TRUE;
-      break;
-    case 'O':        /* Only output these protocols */
-      output_only = g_strdup(optarg);
-      /* FALLTHROUGH */
-    case 'V':        /* Verbose */
-      print_details = TRUE;
-      print_packet_info = TRUE;
-      break;
-    case 'x':        /* Print packet data in hex (and ASCII) */
-      print_hex = TRUE;
-      /*  The user asked for hex output, so let's ensure they get it,
-       *  even if they're writing to a file.
-       */
-      print_packet_info = TRUE;
-      break;
-    case 'X':
-      ex_opt_add(optarg);
-      break;
-    default:
-      break;
-    }
+  if (!process_early_options(argc, argv, optstring, long_options, &output_only, FALSE)) {
+    exit_status = INVALID_OPTION;
+    goto clean_exit;
   }
 
 /** Send All g_log messages to our own handler **/
@@ -955,6 +1014,23 @@ main(int argc, char *argv[])
   rtd_table_iterate_tables(register_rtd_tables, NULL);
   new_stat_tap_iterate_tables(register_simple_stat_tables, NULL);
 
+#ifndef _WIN32
+  /* "tshark --fork-server <socket>" stops here, with libwireshark and the
+     taps initialized, and forks a worker for every "tshark --fork-client"
+     request. The worker carries on from here with the client's arguments,
+     as if they had been given on its command line. */
+  if (argc == 3 && strcmp(argv[1], "--fork-server") == 0) {
+    if (!tshark_fork_server(argv[2], &argc, &argv)) {
+      exit_status = INIT_FAILED;
+      goto clean_exit;
+    }
+    if (!process_early_options(argc, argv, optstring, long_options, &output_only, TRUE)) {
+      exit_status = INVALID_OPTION;
+      goto clean_exit;
+    }
+  }
+#endif
+
   /* If invoked with the "-G" flag, we dump out information based on
      the argument to the "-G" flag; if no argument is specified,
      for backwards compatibility we dump out a glossary of display
@@ -1320,11 +1396,17 @@ main(int argc, char *argv[])
         output_action = WRITE_JSON_RAW;
         print_details = TRUE;   /* Need details */
         print_summary = FALSE;  /* Don't allow summary */
+      } else if (strcmp(optarg, "columnar") == 0) {
+        output_action = WRITE_COLUMNAR;
+        print_details = TRUE;   /* Need full tree info */
+        print_summary = FALSE;  /* Don't allow summary */
       }
       else {
         cmdarg_err("Invalid -T parameter \"%s\"; it must be one of:", optarg);                   /* x */
         cmdarg_err_cont("\t\"fields\"  The values of fields specified with the -e option, in a form\n"
                         "\t          specified by the -E option.\n"
+                        "\t\"columnar\" The values of fields specified with the -e option, as\n"
+                        "\t          batches of typed binary columns.\n"
                         "\t\"pdml\"    Packet Details Markup Language, an XML-based format for the\n"
                         "\t          details of a decoded packet. This information is equivalent to\n"
                         "\t          the packet details printed with the -V flag.\n"
@@ -1456,6 +1538,30 @@ main(int argc, char *argv[])
       no_duplicate_keys = TRUE;
       node_children_grouper = proto_node_group_children_by_json_key;
       break;
+    case LONGOPT_READ_AHEAD:
+      read_ahead = TRUE;
+      break;
+    case LONGOPT_SHARD:
+    {
+      char *p;
+
+      p = strchr(optarg, '/');
+      if (p == NULL) {
+        cmdarg_err("--shard must be given as <index>/<count>");
+        exit_status = INVALID_OPTION;
+        goto clean_exit;
+      }
+      *p = '\0';
+      shard_index = get_nonzero_guint32(optarg, "shard index") - 1;
+      shard_count = get_nonzero_guint32(p + 1, "shard count");
+      *p = '/';
+      if (shard_index >= shard_count) {
+        cmdarg_err("The shard index must be between 1 and the shard count");
+        exit_status = INVALID_OPTION;
+        goto clean_exit;
+      }
+      break;
+    }
     default:
     case '?':        /* Bad flag - print usage message */
       switch(optopt) {
@@ -1486,16 +1592,28 @@ main(int argc, char *argv[])
     goto clean_exit;
   }
 
+  if (shard_count > 1 && perform_two_pass_analysis) {
+    cmdarg_err("--shard can't be used with -2");
+    exit_status = INVALID_OPTION;
+    goto clean_exit;
+  }
+
   /* If we specified output fields, but not the output field type... */
-  if ((WRITE_FIELDS != output_action && WRITE_XML != output_action && WRITE_JSON != output_action && WRITE_EK != output_action) && 0 != output_fields_num_fields(output_fields)) {
+  if ((WRITE_FIELDS != output_action && WRITE_COLUMNAR != output_action && WRITE_XML != output_action && WRITE_JSON != output_action && WRITE_EK != output_action) && 0 != output_fields_num_fields(output_fields)) {
         cmdarg_err("Output fields were specified with \"-e\", "
-            "but \"-Tek, -Tfields, -Tjson or -Tpdml\" was not specified.");
+            "but \"-Tcolumnar, -Tek, -Tfields, -Tjson or -Tpdml\" was not specified.");
         exit_status = INVALID_OPTION;
         goto clean_exit;
   } else if (WRITE_FIELDS == output_action && 0 == output_fields_num_fields(output_fields)) {
         cmdarg_err("\"-Tfields\" was specified, but no fields were "
                     "specified with \"-e\".");
 
+        exit_status = INVALID_OPTION;
+        goto clean_exit;
+  } else if (WRITE_COLUMNAR == output_action && 0 == output_fields_num_fields(output_fields)) {
+        cmdarg_err("\"-Tcolumnar\" was specified, but no fields were "
+                    "specified with \"-e\".");
+
         exit_status = INVALID_OPTION;
         goto clean_exit;
   }
@@ -2029,6 +2147,18 @@ main(int argc, char *argv[])
       tap_listeners_require_dissection() || dissect_color;
   tshark_debug("tshark: do_dissection = %s", do_dissection ? "TRUE" : "FALSE");
 
+  /* If all we print are plain -e fields, nothing needs the labels of a
+     visible protocol tree; an invisible tree primed with the fields, and
+     with field demand on so that dissectors may skip the bodies of
+     protocols nobody references, is good enough.  Taps and coloring
+     rules may want other fields, so don't do that when either is used. */
+  fields_on_demand = print_packet_info &&
+      (output_action == WRITE_FIELDS || output_action == WRITE_COLUMNAR) &&
+      !output_fields_need_visible_tree(output_fields) &&
+      !output_fields_has_cols(output_fields) &&
+      !tap_listeners_require_dissection() && !pdu_export_arg && !dissect_color;
+  tshark_debug("tshark: fields_on_demand = %s", fields_on_demand ? "TRUE" : "FALSE");
+
   if (cf_name) {
     tshark_debug("tshark: Opening capture file: %s", cf_name);
     /*
@@ -2372,6 +2502,331 @@ tshark_get_frame_ts(void *data, guint32 frame_num)
   return NULL;
 }
 
+/*
+ * Reading ahead.
+ *
+ * With --read-ahead, a thread reads packets from the capture file into
+ * a fixed set of records while the main thread dissects and prints the
+ * ones already read, so that the time spent reading and decompressing
+ * the file overlaps with dissection.  Only the reading is moved off the
+ * main thread; dissection still happens on the main thread, one packet
+ * at a time and in file order, so the output is the same as without
+ * --read-ahead.
+ *
+ * The reading thread holds read_ahead_wth_mtx while it reads, since a
+ * read can add interfaces to the wtap; the main thread takes it when
+ * it looks up an interface.  Names from name resolution blocks are
+ * passed along with the packet that follows them, and added on the
+ * main thread before that packet is dissected.
+ *
+ * When capturing, the file dumpcap is writing only has as many packets
+ * as it has told us about, so the reading thread only reads packets it
+ * has been granted by capture_input_new_packets(); while that function
+ * dissects a batch, the thread reads the rest of the batch.  The batch
+ * sizes and how many packets were queued are reported at the end of the
+ * capture, to show how far behind dumpcap we fell.
+ */
+#if GLIB_CHECK_VERSION(2,36,0)
+#define USE_READ_AHEAD
+/* How many packets may be read ahead of the one being dissected */
+#define READ_AHEAD_RECORDS 1024
+
+typedef struct {
+  gboolean  is_ipv6;
+  guint     ipv4_addr;
+  struct e_in6_addr ipv6_addr;
+  gchar    *name;
+} read_ahead_name_t;
+
+typedef struct {
+  gboolean  end;                /* no more packets; err and err_info say why */
+  int       err;
+  gchar    *err_info;
+  gint64    data_offset;
+  struct wtap_pkthdr phdr;
+  Buffer    buf;
+  GSList   *names;              /* read_ahead_name_t's to add before this packet */
+} read_ahead_rec_t;
+
+static gboolean read_ahead_active = FALSE;
+static GMutex read_ahead_wth_mtx;
+static GThread *read_ahead_thread;
+static GAsyncQueue *read_ahead_free;    /* records available to the reader */
+static GAsyncQueue *read_ahead_full;    /* records waiting to be dissected */
+static read_ahead_rec_t *read_ahead_recs;
+static read_ahead_rec_t *read_ahead_current;
+static gint read_ahead_stop;
+static GSList *read_ahead_names;        /* only used by the reading thread */
+static gboolean read_ahead_live;        /* only read packets we were told about */
+static GAsyncQueue *read_ahead_grants;  /* packet counts the reader may read */
+static guint read_ahead_batches;        /* statistics for a live capture */
+static guint read_ahead_max_batch;
+static guint read_ahead_max_queued;
+
+static void
+read_ahead_new_ipv4(const guint addr, const gchar *name)
+{
+  read_ahead_name_t *entry = g_new(read_ahead_name_t, 1);
+
+  entry->is_ipv6 = FALSE;
+  entry->ipv4_addr = addr;
+  entry->name = g_strdup(name);
+  read_ahead_names = g_slist_prepend(read_ahead_names, entry);
+}
+
+static void
+read_ahead_new_ipv6(const void *addrp, const gchar *name)
+{
+  read_ahead_name_t *entry = g_new(read_ahead_name_t, 1);
+
+  entry->is_ipv6 = TRUE;
+  memcpy(&entry->ipv6_addr, addrp, sizeof entry->ipv6_addr);
+  entry->name = g_strdup(name);
+  read_ahead_names = g_slist_prepend(read_ahead_names, entry);
+}
+
+static gpointer
+read_ahead_thread_func(gpointer data)
+{
+  capture_file     *cf = (capture_file *)data;
+  read_ahead_rec_t *rec;
+  gboolean          ret;
+  int               err = 0;
+  gchar            *err_info = NULL;
+  gint64            data_offset;
+  struct wtap_pkthdr *phdr;
+  Buffer            ft_specific_data;
+  gint              granted = 0;
+
+  for (;;) {
+    rec = (read_ahead_rec_t *)g_async_queue_pop(read_ahead_free);
+
+    if (read_ahead_live) {
+      while (granted == 0 && !g_atomic_int_get(&read_ahead_stop))
+        granted = GPOINTER_TO_INT(g_async_queue_pop(read_ahead_grants));
+      granted--;
+    }
+
+    if (g_atomic_int_get(&read_ahead_stop)) {
+      ret = FALSE;
+      err = 0;
+    } else {
+      g_mutex_lock(&read_ahead_wth_mtx);
+      if (read_ahead_live)
+        wtap_cleareof(cf->wth);
+      ret = wtap_read(cf->wth, &err, &err_info, &data_offset);
+      g_mutex_unlock(&read_ahead_wth_mtx);
+    }
+
+    rec->names = g_slist_reverse(read_ahead_names);
+    read_ahead_names = NULL;
+
+    if (!ret) {
+      rec->end = TRUE;
+      rec->err = err;
+      rec->err_info = err_info;
+      g_async_queue_push(read_ahead_full, rec);
+      return NULL;
+    }
+
+    /* The comment and file-type specific data belong to the wtap */
+    phdr = wtap_phdr(cf->wth);
+    rec->data_offset = data_offset;
+    g_free(rec->phdr.opt_comment);
+    ft_specific_data = rec->phdr.ft_specific_data;
+    rec->phdr = *phdr;
+    rec->phdr.opt_comment = g_strdup(phdr->opt_comment);
+    rec->phdr.ft_specific_data = ft_specific_data;
+    ws_buffer_clean(&rec->phdr.ft_specific_data);
+    ws_buffer_append_buffer(&rec->phdr.ft_specific_data, &phdr->ft_specific_data);
+    ws_buffer_assure_space(&rec->buf, phdr->caplen);
+    memcpy(ws_buffer_start_ptr(&rec->buf), wtap_buf_ptr(cf->wth), phdr->caplen);
+    g_async_queue_push(read_ahead_full, rec);
+  }
+}
+
+static void
+read_ahead_start(capture_file *cf, gboolean live)
+{
+  int i;
+
+  read_ahead_free = g_async_queue_new();
+  read_ahead_full = g_async_queue_new();
+  read_ahead_grants = g_async_queue_new();
+  read_ahead_live = live;
+  read_ahead_recs = g_new0(read_ahead_rec_t, READ_AHEAD_RECORDS);
+  for (i = 0; i < READ_AHEAD_RECORDS; i++) {
+    wtap_phdr_init(&read_ahead_recs[i].phdr);
+    ws_buffer_init(&read_ahead_recs[i].buf, 1500);
+    g_async_queue_push(read_ahead_free, &read_ahead_recs[i]);
+  }
+  read_ahead_current = NULL;
+  read_ahead_stop = 0;
+  read_ahead_names = NULL;
+
+  wtap_set_cb_new_ipv4(cf->wth, read_ahead_new_ipv4);
+  wtap_set_cb_new_ipv6(cf->wth, read_ahead_new_ipv6);
+
+  read_ahead_active = TRUE;
+  read_ahead_thread = g_thread_new("read-ahead", read_ahead_thread_func, cf);
+}
+
+static void
+read_ahead_release(read_ahead_rec_t *rec)
+{
+  GSList            *l;
+  read_ahead_name_t *entry;
+
+  for (l = rec->names; l != NULL; l = l->next) {
+    entry = (read_ahead_name_t *)l->data;
+    g_free(entry->name);
+    g_free(entry);
+  }
+  g_slist_free(rec->names);
+  rec->names = NULL;
+  g_async_queue_push(read_ahead_free, rec);
+}
+
+/* Stop the reading thread, if it's still reading, and wait for it to finish */
+static void
+read_ahead_finish(capture_file *cf)
+{
+  read_ahead_rec_t *rec;
+  int i;
+
+  g_atomic_int_set(&read_ahead_stop, 1);
+  /* Wake the reader if it's waiting to be told about more packets */
+  if (read_ahead_live)
+    g_async_queue_push(read_ahead_grants, GINT_TO_POINTER(1));
+  rec = read_ahead_current;
+  while (rec == NULL || !rec->end) {
+    if (rec != NULL)
+      read_ahead_release(rec);
+    rec = (read_ahead_rec_t *)g_async_queue_pop(read_ahead_full);
+  }
+  g_thread_join(read_ahead_thread);
+  g_free(rec->err_info);
+  read_ahead_release(rec);
+  read_ahead_active = FALSE;
+
+  wtap_set_cb_new_ipv4(cf->wth, add_ipv4_name);
+  wtap_set_cb_new_ipv6(cf->wth, (wtap_new_ipv6_callback_t) add_ipv6_name);
+
+  for (i = 0; i < READ_AHEAD_RECORDS; i++) {
+    g_free(read_ahead_recs[i].phdr.opt_comment);
+    wtap_phdr_cleanup(&read_ahead_recs[i].phdr);
+    ws_buffer_free(&read_ahead_recs[i].buf);
+  }
+  g_free(read_ahead_recs);
+  read_ahead_recs = NULL;
+  read_ahead_current = NULL;
+  g_async_queue_unref(read_ahead_free);
+  g_async_queue_unref(read_ahead_full);
+  g_async_queue_unref(read_ahead_grants);
+}
+
+#ifdef HAVE_LIBPCAP
+/* Let the reader read the next to_read packets of a live capture */
+static void
+read_ahead_grant(int to_read)
+{
+  if (to_read <= 0)
+    return;
+  read_ahead_batches++;
+  if ((guint)to_read > read_ahead_max_batch)
+    read_ahead_max_batch = to_read;
+  g_async_queue_push(read_ahead_grants, GINT_TO_POINTER(to_read));
+}
+#endif
+#endif
+
+/*
+ * Read the next packet, either from the file or, if reading ahead,
+ * from the reading thread.  The header and data are good until the
+ * next call.
+ */
+static gboolean
+tshark_read(capture_file *cf, int *err, gchar **err_info, gint64 *data_offset,
+            struct wtap_pkthdr **phdr, const guchar **pd)
+{
+#ifdef USE_READ_AHEAD
+  if (read_ahead_active) {
+    read_ahead_rec_t  *rec;
+    read_ahead_name_t *entry;
+    GSList            *l;
+
+    if (read_ahead_current != NULL)
+      read_ahead_release(read_ahead_current);
+    rec = (read_ahead_rec_t *)g_async_queue_pop(read_ahead_full);
+    read_ahead_current = rec;
+    if (read_ahead_live) {
+      gint queued = g_async_queue_length(read_ahead_full);
+
+      if (queued > 0 && (guint)queued > read_ahead_max_queued)
+        read_ahead_max_queued = queued;
+    }
+
+    for (l = rec->names; l != NULL; l = l->next) {
+      entry = (read_ahead_name_t *)l->data;
+      if (entry->is_ipv6)
+        add_ipv6_name(&entry->ipv6_addr, entry->name);
+      else
+        add_ipv4_name(entry->ipv4_addr, entry->name);
+    }
+
+    if (rec->end) {
+      *err = rec->err;
+      *err_info = rec->err_info;
+      rec->err_info = NULL;
+      return FALSE;
+    }
+    *data_offset = rec->data_offset;
+    *phdr = &rec->phdr;
+    *pd = ws_buffer_start_ptr(&rec->buf);
+    return TRUE;
+  }
+#endif
+  if (!wtap_read(cf->wth, err, err_info, data_offset))
+    return FALSE;
+  *phdr = wtap_phdr(cf->wth);
+  *pd = wtap_buf_ptr(cf->wth);
+  return TRUE;
+}
+
+static const char *
+tshark_get_interface_name(void *data, guint32 interface_id)
+{
+  const char *name;
+
+#ifdef USE_READ_AHEAD
+  if (read_ahead_active) {
+    g_mutex_lock(&read_ahead_wth_mtx);
+    name = cap_file_get_interface_name(data, interface_id);
+    g_mutex_unlock(&read_ahead_wth_mtx);
+    return name;
+  }
+#endif
+  name = cap_file_get_interface_name(data, interface_id);
+  return name;
+}
+
+static const char *
+tshark_get_interface_description(void *data, guint32 interface_id)
+{
+  const char *description;
+
+#ifdef USE_READ_AHEAD
+  if (read_ahead_active) {
+    g_mutex_lock(&read_ahead_wth_mtx);
+    description = cap_file_get_interface_description(data, interface_id);
+    g_mutex_unlock(&read_ahead_wth_mtx);
+    return description;
+  }
+#endif
+  description = cap_file_get_interface_description(data, interface_id);
+  return description;
+}
+
 static epan_t *
 tshark_epan_new(capture_file *cf)
 {
@@ -2379,8 +2834,9 @@ tshark_epan_new(capture_file *cf)
 
   epan->data = cf;
   epan->get_frame_ts = tshark_get_frame_ts;
-  epan->get_interface_name = cap_file_get_interface_name;
-  epan->get_interface_description = cap_file_get_interface_description;
+  epan->get_frame_shift_offset = NULL;
+  epan->get_interface_name = tshark_get_interface_name;
+  epan->get_interface_description = tshark_get_interface_description;
   epan->get_user_comment = NULL;
 
   return epan;
@@ -2588,6 +3044,10 @@ capture_input_new_file(capture_session *cap_session, gchar *new_file)
     /* we start a new capture file, close the old one (if we had one before) */
     if (cf->state != FILE_CLOSED) {
       if (cf->wth != NULL) {
+#ifdef USE_READ_AHEAD
+        if (read_ahead_active)
+          read_ahead_finish(cf);
+#endif
         wtap_close(cf->wth);
         cf->wth = NULL;
       }
@@ -2638,6 +3098,8 @@ capture_input_new_packets(capture_session *cap_session, int to_read)
   int           err;
   gchar        *err_info;
   gint64        data_offset;
+  struct wtap_pkthdr *phdr = NULL;
+  const guchar *pd = NULL;
   capture_file *cf = (capture_file *)cap_session->cf;
   gboolean      filtering_tap_listeners;
   guint         tap_flags;
@@ -2690,21 +3152,36 @@ capture_input_new_packets(capture_session *cap_session, int to_read)
        printing packet details, which is true if we're printing stuff
        ("print_packet_info" is true) and we're in verbose mode
        ("packet_details" is true). */
-    edt = epan_dissect_new(cf->epan, create_proto_tree, print_packet_info && print_details);
+    edt = epan_dissect_new(cf->epan, create_proto_tree, print_packet_info && print_details && !fields_on_demand);
+    epan_dissect_set_field_demand(edt, fields_on_demand);
+
+#ifdef USE_READ_AHEAD
+    if (read_ahead && cf->wth) {
+      if (!read_ahead_active)
+        read_ahead_start(cf, TRUE);
+      read_ahead_grant(to_read);
+    }
+#endif
 
     while (to_read-- && cf->wth) {
-      wtap_cleareof(cf->wth);
-      ret = wtap_read(cf->wth, &err, &err_info, &data_offset);
-      reset_epan_mem(cf, edt, create_proto_tree, print_packet_info && print_details);
+#ifdef USE_READ_AHEAD
+      if (!read_ahead_active)
+#endif
+        wtap_cleareof(cf->wth);
+      ret = tshark_read(cf, &err, &err_info, &data_offset, &phdr, &pd);
+      reset_epan_mem(cf, edt, create_proto_tree, print_packet_info && print_details && !fields_on_demand);
       if (ret == FALSE) {
         /* read from file failed, tell the capture child to stop */
+#ifdef USE_READ_AHEAD
+        if (read_ahead_active)
+          read_ahead_finish(cf);
+#endif
         sync_pipe_stop(cap_session);
         wtap_close(cf->wth);
         cf->wth = NULL;
       } else {
-        ret = process_packet_single_pass(cf, edt, data_offset,
-                                         wtap_phdr(cf->wth),
-                                         wtap_buf_ptr(cf->wth), tap_flags);
+        ret = process_packet_single_pass(cf, edt, data_offset, phdr, pd,
+                                         tap_flags);
       }
       if (ret != FALSE) {
         /* packet successfully read and gone through the "Read Filter" */
@@ -2808,7 +3285,20 @@ capture_input_closed(capture_session *cap_session, gchar *msg)
 
   report_counts();
 
+#ifdef USE_READ_AHEAD
+  if (read_ahead_batches != 0 && !really_quiet) {
+    fprintf(stderr, "Read ahead: %u batch%s, largest %u packet%s, at most %u packet%s queued\n",
+            read_ahead_batches, plurality(read_ahead_batches, "", "es"),
+            read_ahead_max_batch, plurality(read_ahead_max_batch, "", "s"),
+            read_ahead_max_queued, plurality(read_ahead_max_queued, "", "s"));
+  }
+#endif
+
   if (cf != NULL && cf->wth != NULL) {
+#ifdef USE_READ_AHEAD
+    if (read_ahead_active)
+      read_ahead_finish(cf);
+#endif
     wtap_close(cf->wth);
     if (cf->is_tempfile) {
       ws_unlink(cf->filename);
@@ -2873,6 +3363,82 @@ capture_cleanup(int signum _U_)
 #endif /* _WIN32 */
 #endif /* HAVE_LIBPCAP */
 
+/*
+ * With -2 and a display filter, the first pass notes which frames the
+ * filter could match on the second pass, so that the second pass only
+ * has to dissect those frames and the frames they depend on.  A frame
+ * could match if the filter matched it on the first pass, or if it has
+ * any of the protocols the filter refers to; a frame that has none of
+ * them can't match unless the filter matches a frame with nothing in it,
+ * in which case every frame is dissected again.  Taps see every frame,
+ * so this isn't done if there are any.
+ */
+static GArray   *second_pass_protocols = NULL;  /* NULL if not noting frames */
+static GByteArray *second_pass_frames = NULL;   /* non-zero if frame n+1 could match */
+
+static void
+second_pass_frames_init(capture_file *cf)
+{
+  epan_dissect_t *edt;
+  gboolean        matches_empty;
+
+  if (cf->dfcode == NULL || tap_listeners_require_dissection())
+    return;
+
+  edt = epan_dissect_new(cf->epan, TRUE, FALSE);
+  matches_empty = dfilter_apply_edt(cf->dfcode, edt);
+  epan_dissect_free(edt);
+  if (matches_empty)
+    return;
+
+  second_pass_protocols = dfilter_referenced_protocols(cf->dfcode);
+  second_pass_frames = g_byte_array_new();
+}
+
+static void
+second_pass_frames_cleanup(void)
+{
+  if (second_pass_protocols != NULL) {
+    g_array_free(second_pass_protocols, TRUE);
+    second_pass_protocols = NULL;
+  }
+  if (second_pass_frames != NULL) {
+    g_byte_array_free(second_pass_frames, TRUE);
+    second_pass_frames = NULL;
+  }
+}
+
+static void
+second_pass_mark_frames(const GArray *dependent_frames)
+{
+  const frame_range_t *range;
+  guint32              last;
+  guint                i;
+
+  if (dependent_frames == NULL)
+    return;
+  for (i = 0; i < dependent_frames->len; i++) {
+    range = &g_array_index(dependent_frames, frame_range_t, i);
+    last = MIN(range->last, second_pass_frames->len);
+    if (range->first != 0 && range->first <= last)
+      memset(&second_pass_frames->data[range->first - 1], 1, last - range->first + 1);
+  }
+}
+
+static gboolean
+second_pass_has_protocol(epan_dissect_t *edt)
+{
+  guint      i;
+  GPtrArray *finfos;
+
+  for (i = 0; i < second_pass_protocols->len; i++) {
+    finfos = proto_get_finfo_ptr_array(edt->tree, g_array_index(second_pass_protocols, int, i));
+    if (finfos != NULL && g_ptr_array_len(finfos) > 0)
+      return TRUE;
+  }
+  return FALSE;
+}
+
 static gboolean
 process_packet_first_pass(capture_file *cf, epan_dissect_t *edt,
                           gint64 offset, struct wtap_pkthdr *whdr,
@@ -2912,6 +3478,13 @@ process_packet_first_pass(capture_file *cf, epan_dissect_t *edt,
     if (cf->dfcode)
       epan_dissect_prime_with_dfilter(edt, cf->dfcode);
 
+    if (second_pass_protocols != NULL) {
+      guint i;
+
+      for (i = 0; i < second_pass_protocols->len; i++)
+        epan_dissect_prime_with_hfid(edt, g_array_index(second_pass_protocols, int, i));
+    }
+
     /* This is the first pass, so prime the epan_dissect_t with the
        hfids postdissectors want on the first pass. */
     prime_epan_dissect_with_postdissector_wanted_hfids(edt);
@@ -2941,8 +3514,19 @@ process_packet_first_pass(capture_file *cf, epan_dissect_t *edt,
      * if a display filter was given and it matches this packet.
      */
     if (edt && cf->dfcode) {
+      guint8 could_match;
+
       if (dfilter_apply_edt(cf->dfcode, edt)) {
-        g_slist_foreach(edt->pi.dependent_frames, find_and_mark_frame_depended_upon, cf->frames);
+        frame_data_sequence_mark_depended_upon(cf->frames, edt->pi.dependent_frames);
+        could_match = 1;
+      } else {
+        could_match = second_pass_frames != NULL && second_pass_has_protocol(edt);
+      }
+      if (second_pass_frames != NULL) {
+        g_byte_array_append(second_pass_frames, &could_match, 1);
+        /* The frames this one depends on have to be dissected with it */
+        if (could_match)
+          second_pass_mark_frames(edt->pi.dependent_frames);
       }
     }
 
@@ -2990,6 +3574,10 @@ process_packet_second_pass(capture_file *cf, epan_dissect_t *edt,
 
     col_custom_prime_edt(edt, &cf->cinfo);
 
+    /* We're only going to print the -e fields; make sure they're there. */
+    if (fields_on_demand)
+      output_fields_prime_edt(output_fields, edt);
+
     /* We only need the columns if either
          1) some tap needs the columns
        or
@@ -3068,6 +3656,8 @@ process_cap_file(capture_file *cf, char *save_file, int out_file_type,
   GArray                      *nrb_hdrs = NULL;
   struct wtap_pkthdr phdr;
   Buffer       buf;
+  struct wtap_pkthdr *rec_phdr;
+  const guchar *rec_pd;
   epan_dissect_t *edt = NULL;
   char                        *shb_user_appl;
 
@@ -3184,6 +3774,10 @@ process_cap_file(capture_file *cf, char *save_file, int out_file_type,
       /* We're not going to display the protocol tree on this pass,
          so it's not going to be "visible". */
       edt = epan_dissect_new(cf->epan, create_proto_tree, FALSE);
+
+      second_pass_frames_init(cf);
+      tshark_debug("tshark: second pass only dissects frames that could match = %s",
+                   second_pass_frames != NULL ? "TRUE" : "FALSE");
     }
 
     tshark_debug("tshark: reading records for first pass");
@@ -3262,11 +3856,24 @@ process_cap_file(capture_file *cf, char *save_file, int out_file_type,
          printing packet details, which is true if we're printing stuff
          ("print_packet_info" is true) and we're in verbose mode
          ("packet_details" is true). */
-      edt = epan_dissect_new(cf->epan, create_proto_tree, print_packet_info && print_details);
+      edt = epan_dissect_new(cf->epan, create_proto_tree, print_packet_info && print_details && !fields_on_demand);
+      epan_dissect_set_field_demand(edt, fields_on_demand);
     }
 
     for (framenum = 1; err == 0 && framenum <= cf->count; framenum++) {
       fdata = frame_data_sequence_find(cf->frames, framenum);
+      if (second_pass_frames != NULL && !second_pass_frames->data[framenum - 1]) {
+        /* The display filter can't match this frame, and no frame that
+           could match depends on it; only keep the times right. */
+        frame_data_set_before_dissect(fdata, &cf->elapsed_time,
+                                      &ref, prev_dis);
+        if (ref == fdata) {
+          ref_frame = *fdata;
+          ref = &ref_frame;
+        }
+        prev_cap = fdata;
+        continue;
+      }
       if (wtap_seek_read(cf->wth, fdata->file_off, &phdr, &buf, &err,
                          &err_info)) {
         tshark_debug("tshark: invoking process_packet_second_pass() for frame #%d", framenum);
@@ -3303,6 +3910,7 @@ process_cap_file(capture_file *cf, char *save_file, int out_file_type,
     }
 
     ws_buffer_free(&buf);
+    second_pass_frames_cleanup();
 
     tshark_debug("tshark: done with second pass");
   }
@@ -3344,24 +3952,32 @@ process_cap_file(capture_file *cf, char *save_file, int out_file_type,
          printing packet details, which is true if we're printing stuff
          ("print_packet_info" is true) and we're in verbose mode
          ("packet_details" is true). */
-      edt = epan_dissect_new(cf->epan, create_proto_tree, print_packet_info && print_details);
+      edt = epan_dissect_new(cf->epan, create_proto_tree, print_packet_info && print_details && !fields_on_demand);
+      epan_dissect_set_field_demand(edt, fields_on_demand);
     }
 
-    while (wtap_read(cf->wth, &err, &err_info, &data_offset)) {
+#ifdef USE_READ_AHEAD
+    if (read_ahead) {
+      tshark_debug("tshark: reading ahead on a separate thread");
+      read_ahead_start(cf, FALSE);
+    }
+#endif
+
+    while (tshark_read(cf, &err, &err_info, &data_offset, &rec_phdr, &rec_pd)) {
       framenum++;
 
       tshark_debug("tshark: processing packet #%d", framenum);
 
-      reset_epan_mem(cf, edt, create_proto_tree, print_packet_info && print_details);
+      reset_epan_mem(cf, edt, create_proto_tree, print_packet_info && print_details && !fields_on_demand);
 
-      if (process_packet_single_pass(cf, edt, data_offset, wtap_phdr(cf->wth),
-                                     wtap_buf_ptr(cf->wth), tap_flags)) {
+      if (process_packet_single_pass(cf, edt, data_offset, rec_phdr,
+                                     rec_pd, tap_flags)) {
         /* Either there's no read filtering or this packet passed the
            filter, so, if we're writing to a capture file, write
            this packet out. */
         if (pdh != NULL) {
           tshark_debug("tshark: writing packet #%d to outfile", framenum);
-          if (!wtap_dump(pdh, wtap_phdr(cf->wth), wtap_buf_ptr(cf->wth), &err, &err_info)) {
+          if (!wtap_dump(pdh, rec_phdr, rec_pd, &err, &err_info)) {
             /* Error writing to a capture file */
             tshark_debug("tshark: error writing to a capture file (%d)", err);
             cfile_write_failure_message("TShark", cf->filename, save_file,
@@ -3386,6 +4002,11 @@ process_cap_file(capture_file *cf, char *save_file, int out_file_type,
       }
     }
 
+#ifdef USE_READ_AHEAD
+    if (read_ahead_active)
+      read_ahead_finish(cf);
+#endif
+
     if (edt) {
       epan_dissect_free(edt);
       edt = NULL;
@@ -3463,6 +4084,158 @@ out:
   return success;
 }
 
+/*
+ * Sharding.
+ *
+ * With --shard, a light parse of the link, network and transport headers
+ * finds the flow of each packet, and only the flows that hash to this
+ * shard are dissected; the other packets are only counted, so that frame
+ * numbers, times and byte counts match an unsharded run.  The hash puts
+ * both directions of a flow in the same shard, so that per-flow state
+ * such as TCP analysis and reassembly is the same as when dissecting all
+ * packets.  Running one tshark per shard and merging the output on the
+ * frame number gives the output of a single tshark.
+ *
+ * Packets that aren't TCP, UDP or SCTP over IPv4 or IPv6, or whose
+ * headers we can't parse, all go to the first shard.
+ */
+#define SHARD_ETHERTYPE_IPv4    0x0800
+#define SHARD_ETHERTYPE_IPv6    0x86dd
+#define SHARD_ETHERTYPE_VLAN    0x8100
+#define SHARD_ETHERTYPE_QINQ    0x88a8
+
+static guint32
+shard_hash_bytes(guint32 hash, const guint8 *p, guint len)
+{
+  /* FNV-1a */
+  while (len-- != 0) {
+    hash ^= *p++;
+    hash *= 16777619U;
+  }
+  return hash;
+}
+
+/* Hash the two ends of a flow so that both directions hash the same */
+static guint32
+shard_hash_flow(const guint8 *src, const guint8 *dst, guint addr_len,
+                guint8 ip_proto, const guint8 *ports)
+{
+  guint32 hash = 2166136261U;
+  int     cmp;
+
+  cmp = memcmp(src, dst, addr_len);
+  if (cmp == 0)
+    cmp = memcmp(ports, ports + 2, 2);
+  if (cmp > 0) {
+    hash = shard_hash_bytes(hash, dst, addr_len);
+    hash = shard_hash_bytes(hash, ports + 2, 2);
+    hash = shard_hash_bytes(hash, src, addr_len);
+    hash = shard_hash_bytes(hash, ports, 2);
+  } else {
+    hash = shard_hash_bytes(hash, src, addr_len);
+    hash = shard_hash_bytes(hash, ports, 2);
+    hash = shard_hash_bytes(hash, dst, addr_len);
+    hash = shard_hash_bytes(hash, ports + 2, 2);
+  }
+  return shard_hash_bytes(hash, &ip_proto, 1);
+}
+
+/* Returns the shard a packet belongs to */
+static guint
+shard_of_packet(const struct wtap_pkthdr *whdr, const guchar *pd)
+{
+  guint          len = whdr->caplen;
+  guint          off = 0;
+  guint16        ethertype;
+  guint8         version;
+  guint8         ip_proto;
+  guint          hdr_len;
+  const guint8  *src, *dst;
+  guint          addr_len;
+  int            vlans;
+
+  if (whdr->rec_type != REC_TYPE_PACKET)
+    return 0;
+
+  switch (whdr->pkt_encap) {
+
+  case WTAP_ENCAP_ETHERNET:
+    if (len < 14)
+      return 0;
+    ethertype = pntoh16(pd + 12);
+    off = 14;
+    for (vlans = 0; vlans < 2 &&
+         (ethertype == SHARD_ETHERTYPE_VLAN || ethertype == SHARD_ETHERTYPE_QINQ); vlans++) {
+      if (len < off + 4)
+        return 0;
+      ethertype = pntoh16(pd + off + 2);
+      off += 4;
+    }
+    if (ethertype != SHARD_ETHERTYPE_IPv4 && ethertype != SHARD_ETHERTYPE_IPv6)
+      return 0;
+    break;
+
+  case WTAP_ENCAP_SLL:
+    if (len < 16)
+      return 0;
+    ethertype = pntoh16(pd + 14);
+    if (ethertype != SHARD_ETHERTYPE_IPv4 && ethertype != SHARD_ETHERTYPE_IPv6)
+      return 0;
+    off = 16;
+    break;
+
+  case WTAP_ENCAP_RAW_IP:
+  case WTAP_ENCAP_RAW_IP4:
+  case WTAP_ENCAP_RAW_IP6:
+    break;
+
+  default:
+    return 0;
+  }
+
+  if (len < off + 1)
+    return 0;
+  version = pd[off] >> 4;
+  if (version == 4) {
+    if (len < off + 20)
+      return 0;
+    hdr_len = (pd[off] & 0x0f) * 4;
+    /* Fragments other than the first have no ports; keep them all together */
+    if (hdr_len < 20 || (pntoh16(pd + off + 6) & 0x3fff) != 0)
+      return 0;
+    ip_proto = pd[off + 9];
+    src = pd + off + 12;
+    dst = pd + off + 16;
+    addr_len = 4;
+    off += hdr_len;
+  } else if (version == 6) {
+    if (len < off + 40)
+      return 0;
+    ip_proto = pd[off + 6];
+    src = pd + off + 8;
+    dst = pd + off + 24;
+    addr_len = 16;
+    off += 40;
+    /* Skip the extension headers that can come before the transport header */
+    while (ip_proto == IP_PROTO_HOPOPTS || ip_proto == IP_PROTO_ROUTING ||
+           ip_proto == IP_PROTO_DSTOPTS) {
+      if (len < off + 2)
+        return 0;
+      ip_proto = pd[off];
+      off += (pd[off + 1] + 1) * 8;
+    }
+  } else {
+    return 0;
+  }
+
+  if (ip_proto != IP_PROTO_TCP && ip_proto != IP_PROTO_UDP && ip_proto != IP_PROTO_SCTP)
+    return 0;
+  if (len < off + 4)
+    return 0;
+
+  return shard_hash_flow(src, dst, addr_len, ip_proto, pd + off) % shard_count;
+}
+
 static gboolean
 process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, gint64 offset,
                            struct wtap_pkthdr *whdr, const guchar *pd,
@@ -3482,6 +4255,22 @@ process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, gint64 offset,
 
   frame_data_init(&fdata, cf->count, whdr, offset, cum_bytes);
 
+  if (shard_count > 1 && shard_of_packet(whdr, pd) != shard_index) {
+    /* Another shard dissects this packet; keep the times and the byte
+       count the same as if we had. */
+    frame_data_set_before_dissect(&fdata, &cf->elapsed_time,
+                                  &ref, prev_dis);
+    if (ref == &fdata) {
+      ref_frame = fdata;
+      ref = &ref_frame;
+    }
+    if (!cf->dfcode)
+      frame_data_set_after_dissect(&fdata, &cum_bytes);
+    prev_cap_frame = fdata;
+    prev_cap = &prev_cap_frame;
+    return FALSE;
+  }
+
   /* If we're going to print packet information, or we're going to
      run a read filter, or we're going to process taps, set up to
      do a dissection and do so.  (This is the one and only pass
@@ -3504,6 +4293,10 @@ process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, gint64 offset,
 
     col_custom_prime_edt(edt, &cf->cinfo);
 
+    /* We're only going to print the -e fields; make sure they're there. */
+    if (fields_on_demand)
+      output_fields_prime_edt(output_fields, edt);
+
     /* We only need the columns if either
          1) some tap needs the columns
        or
@@ -3591,6 +4384,10 @@ write_preamble(capture_file *cf)
     write_fields_preamble(output_fields, stdout);
     return !ferror(stdout);
 
+  case WRITE_COLUMNAR:
+    write_columnar_preamble(output_fields, stdout);
+    return !ferror(stdout);
+
   case WRITE_JSON:
   case WRITE_JSON_RAW:
     write_json_preamble(stdout);
@@ -3944,6 +4741,15 @@ print_packet(capture_file *cf, epan_dissect_t *edt)
     }
     break;
 
+  case WRITE_COLUMNAR:
+    if (print_summary)
+      g_assert_not_reached();
+    if (print_details) {
+      write_columnar_proto_tree(output_fields, edt, &cf->cinfo, stdout);
+      return !ferror(stdout);
+    }
+    break;
+
   case WRITE_JSON:
     if (print_summary)
       g_assert_not_reached();
@@ -4004,6 +4810,10 @@ write_finale(void)
     write_fields_finale(output_fields, stdout);
     return !ferror(stdout);
 
+  case WRITE_COLUMNAR:
+    write_columnar_finale(output_fields, stdout);
+    return !ferror(stdout);
+
   case WRITE_JSON:
   case WRITE_JSON_RAW:
     write_json_finale(stdout);
@@ -4156,6 +4966,7 @@ static void reset_epan_mem(capture_file *cf,epan_dissect_t *edt, gboolean tree,
 
   cf->epan = tshark_epan_new(cf);
   epan_dissect_init(edt, cf->epan, tree, visual);
+  epan_dissect_set_field_demand(edt, fields_on_demand);
   cf->count = 0;
 }
 
@@ -0,0 +1,391 @@
+/* tshark_fork_server.c
+ * Run TShark invocations in children forked from one initialized process
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Most of the time of a TShark run on a small file goes into initializing
+ * libwireshark: registering the dissectors, loading plugins and so on.
+ * "tshark --fork-server <socket>" does that once and then waits for
+ * requests from "tshark --fork-client <socket> <arguments>". Like sharkd,
+ * it forks for every request, so each worker starts from the freshly
+ * initialized state; the worker then carries on with the client's
+ * arguments, working directory and standard input, output and error, so
+ * its output is exactly what "tshark <arguments>" would have produced.
+ *
+ * A request is a fork_request_hdr_t, sent together with the client's
+ * descriptors 0, 1 and 2, followed by the NUL-terminated working directory
+ * and arguments. The reply is the worker's exit status as an int.
+ */
+
+#include <config.h>
+
+#ifndef _WIN32
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include <glib.h>
+
+#include "tshark_fork_server.h"
+
+/* Exit status of the client if the server couldn't run the request. */
+#define FORK_CLIENT_FAILED      2
+
+/* Upper bound on the size of the strings in a request. */
+#define FORK_REQUEST_MAX_LEN    (1024 * 1024)
+
+#define FORK_REQUEST_FDS        3
+
+typedef struct {
+  guint32 argc;     /* number of arguments after the working directory */
+  guint32 len;      /* length of all the strings, including their NULs */
+} fork_request_hdr_t;
+
+static gboolean
+write_all(int fd, const void *buf, size_t len)
+{
+  const char *p = (const char *)buf;
+
+  while (len > 0) {
+    ssize_t n = write(fd, p, len);
+
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return FALSE;
+    p += n;
+    len -= (size_t)n;
+  }
+  return TRUE;
+}
+
+static gboolean
+read_all(int fd, void *buf, size_t len)
+{
+  char *p = (char *)buf;
+
+  while (len > 0) {
+    ssize_t n = read(fd, p, len);
+
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return FALSE;
+    p += n;
+    len -= (size_t)n;
+  }
+  return TRUE;
+}
+
+static gboolean
+fork_socket_address(const char *path, struct sockaddr_un *s_un)
+{
+  if (strlen(path) >= sizeof(s_un->sun_path)) {
+    fprintf(stderr, "tshark: Socket path \"%s\" is too long\n", path);
+    return FALSE;
+  }
+  memset(s_un, 0, sizeof(*s_un));
+  s_un->sun_family = AF_UNIX;
+  g_strlcpy(s_un->sun_path, path, sizeof(s_un->sun_path));
+  return TRUE;
+}
+
+int
+tshark_fork_client(const char *path, int argc, char *argv[])
+{
+  struct sockaddr_un s_un;
+  fork_request_hdr_t hdr;
+  struct msghdr msg;
+  struct iovec iov;
+  struct cmsghdr *cmsg;
+  union {
+    struct cmsghdr hdr;
+    char buf[CMSG_SPACE(FORK_REQUEST_FDS * sizeof(int))];
+  } control;
+  int fds[FORK_REQUEST_FDS] = { 0, 1, 2 };
+  GByteArray *payload;
+  gchar *cwd;
+  int fd, i, status;
+
+  if (!fork_socket_address(path, &s_un))
+    return FORK_CLIENT_FAILED;
+
+  fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0 || connect(fd, (struct sockaddr *)&s_un, sizeof(s_un)) < 0) {
+    fprintf(stderr, "tshark: Can't connect to the fork server on \"%s\": %s\n",
+            path, g_strerror(errno));
+    if (fd >= 0)
+      close(fd);
+    return FORK_CLIENT_FAILED;
+  }
+
+  payload = g_byte_array_new();
+  cwd = g_get_current_dir();
+  g_byte_array_append(payload, (const guint8 *)cwd, (guint)strlen(cwd) + 1);
+  g_free(cwd);
+  for (i = 0; i < argc; i++)
+    g_byte_array_append(payload, (const guint8 *)argv[i], (guint)strlen(argv[i]) + 1);
+
+  hdr.argc = (guint32)argc;
+  hdr.len = payload->len;
+
+  memset(&msg, 0, sizeof(msg));
+  memset(&control, 0, sizeof(control));
+  iov.iov_base = &hdr;
+  iov.iov_len = sizeof(hdr);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof(control.buf);
+  cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+  memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+  if (sendmsg(fd, &msg, 0) != (ssize_t)sizeof(hdr) ||
+      !write_all(fd, payload->data, payload->len)) {
+    fprintf(stderr, "tshark: Can't send the request to the fork server: %s\n",
+            g_strerror(errno));
+    g_byte_array_free(payload, TRUE);
+    close(fd);
+    return FORK_CLIENT_FAILED;
+  }
+  g_byte_array_free(payload, TRUE);
+
+  /* The worker writes straight to our descriptors; just wait for it. */
+  if (!read_all(fd, &status, sizeof(status))) {
+    fprintf(stderr, "tshark: The fork server closed the connection\n");
+    status = FORK_CLIENT_FAILED;
+  }
+  close(fd);
+  return status;
+}
+
+/*
+ * Read a request from the client. On success the descriptors are in fds,
+ * and *strings holds hdr->len bytes of NUL-terminated strings.
+ */
+static gboolean
+fork_server_read_request(int conn, fork_request_hdr_t *hdr, int fds[FORK_REQUEST_FDS],
+                         gchar **strings)
+{
+  struct msghdr msg;
+  struct iovec iov;
+  struct cmsghdr *cmsg;
+  union {
+    struct cmsghdr hdr;
+    char buf[CMSG_SPACE(FORK_REQUEST_FDS * sizeof(int))];
+  } control;
+  gboolean have_fds = FALSE;
+  guint32 i, nstrings;
+  ssize_t n;
+
+  memset(&msg, 0, sizeof(msg));
+  iov.iov_base = hdr;
+  iov.iov_len = sizeof(*hdr);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof(control.buf);
+
+  do {
+    n = recvmsg(conn, &msg, 0);
+  } while (n < 0 && errno == EINTR);
+  if (n != (ssize_t)sizeof(*hdr))
+    return FALSE;
+
+  for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+        cmsg->cmsg_len == CMSG_LEN(FORK_REQUEST_FDS * sizeof(int))) {
+      memcpy(fds, CMSG_DATA(cmsg), FORK_REQUEST_FDS * sizeof(int));
+      have_fds = TRUE;
+    }
+  }
+  if (!have_fds)
+    return FALSE;
+
+  if (hdr->len == 0 || hdr->len > FORK_REQUEST_MAX_LEN)
+    return FALSE;
+  *strings = (gchar *)g_malloc(hdr->len);
+  if (!read_all(conn, *strings, hdr->len) || (*strings)[hdr->len - 1] != '\0')
+    return FALSE;
+
+  /* The working directory followed by exactly argc arguments. */
+  for (i = 0, nstrings = 0; i < hdr->len; i++) {
+    if ((*strings)[i] == '\0')
+      nstrings++;
+  }
+  return nstrings == hdr->argc + 1;
+}
+
+/*
+ * Handle one connection, in a child of the server. The worker that runs the
+ * request is forked from here so that this process can wait for it and
+ * report its exit status to the client; it returns TRUE in the worker and
+ * never returns otherwise.
+ */
+static gboolean
+fork_server_session(int conn, int *argc_p, char ***argv_p)
+{
+  fork_request_hdr_t hdr;
+  int fds[FORK_REQUEST_FDS] = { -1, -1, -1 };
+  gchar *strings = NULL;
+  pid_t worker;
+  int i, wstatus, status;
+
+  /* We want to wait for our own worker. */
+  signal(SIGCHLD, SIG_DFL);
+
+  if (!fork_server_read_request(conn, &hdr, fds, &strings))
+    _exit(1);
+
+  worker = fork();
+  if (worker == 0) {
+    char **argv;
+    gchar *p;
+
+    for (i = 0; i < FORK_REQUEST_FDS; i++) {
+      dup2(fds[i], i);
+      if (fds[i] > 2)
+        close(fds[i]);
+    }
+    close(conn);
+
+    if (chdir(strings) != 0) {
+      fprintf(stderr, "tshark: Can't change to directory \"%s\": %s\n",
+              strings, g_strerror(errno));
+      _exit(FORK_CLIENT_FAILED);
+    }
+
+    argv = g_new(char *, hdr.argc + 2);
+    argv[0] = (*argv_p)[0];
+    p = strings + strlen(strings) + 1;
+    for (i = 1; i <= (int)hdr.argc; i++) {
+      argv[i] = p;
+      p += strlen(p) + 1;
+    }
+    argv[hdr.argc + 1] = NULL;
+
+    *argc_p = (int)hdr.argc + 1;
+    *argv_p = argv;
+    return TRUE;
+  }
+
+  for (i = 0; i < FORK_REQUEST_FDS; i++)
+    close(fds[i]);
+
+  if (worker < 0) {
+    status = FORK_CLIENT_FAILED;
+  } else {
+    while (waitpid(worker, &wstatus, 0) < 0) {
+      if (errno != EINTR) {
+        wstatus = 0;
+        break;
+      }
+    }
+    if (WIFEXITED(wstatus))
+      status = WEXITSTATUS(wstatus);
+    else if (WIFSIGNALED(wstatus))
+      status = 128 + WTERMSIG(wstatus);
+    else
+      status = FORK_CLIENT_FAILED;
+  }
+
+  write_all(conn, &status, sizeof(status));
+  close(conn);
+  _exit(0);
+}
+
+gboolean
+tshark_fork_server(const char *path, int *argc_p, char ***argv_p)
+{
+  struct sockaddr_un s_un;
+  int fd, conn;
+  pid_t pid;
+
+  if (!fork_socket_address(path, &s_un))
+    return FALSE;
+
+  fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    fprintf(stderr, "tshark: Can't create socket: %s\n", g_strerror(errno));
+    return FALSE;
+  }
+
+  /* Remove a socket left behind by an earlier server. */
+  unlink(path);
+  if (bind(fd, (struct sockaddr *)&s_un, sizeof(s_un)) < 0 || listen(fd, SOMAXCONN) < 0) {
+    fprintf(stderr, "tshark: Can't listen on \"%s\": %s\n", path, g_strerror(errno));
+    close(fd);
+    return FALSE;
+  }
+
+  /* Session processes are reaped automatically. */
+  signal(SIGCHLD, SIG_IGN);
+
+  for (;;) {
+    conn = accept(fd, NULL, NULL);
+    if (conn < 0) {
+      if (errno == EINTR)
+        continue;
+      fprintf(stderr, "tshark: Can't accept a connection: %s\n", g_strerror(errno));
+      close(fd);
+      return FALSE;
+    }
+
+    /* Don't let the children inherit anything still buffered. */
+    fflush(NULL);
+
+    pid = fork();
+    if (pid == 0) {
+      close(fd);
+      return fork_server_session(conn, argc_p, argv_p);
+    }
+    if (pid < 0)
+      fprintf(stderr, "tshark: Can't fork(): %s\n", g_strerror(errno));
+    close(conn);
+  }
+}
+
+#endif /* _WIN32 */
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 2
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=2 tabstop=8 expandtab:
+ * :indentSize=2:tabSize=8:noTabs=true:
+ */
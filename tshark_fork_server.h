@@ -0,0 +1,71 @@
+/* tshark_fork_server.h
+ * Run TShark invocations in children forked from one initialized process
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __TSHARK_FORK_SERVER_H__
+#define __TSHARK_FORK_SERVER_H__
+
+#include <glib.h>
+
+#ifndef _WIN32
+
+/**
+ * Send the working directory, the standard file descriptors and the
+ * arguments to the fork server listening on the UNIX socket path, and
+ * wait for the worker to finish.
+ *
+ * @param path The socket the server listens on.
+ * @param argc Number of TShark arguments, not counting the program name.
+ * @param argv The TShark arguments.
+ * @return The worker's exit status, or 2 if the request failed.
+ */
+int tshark_fork_client(const char *path, int argc, char *argv[]);
+
+/**
+ * Listen on the UNIX socket path and fork a worker for each client
+ * request. This only returns in a worker, after it has switched to the
+ * client's working directory and standard file descriptors, or if the
+ * socket can't be set up.
+ *
+ * @param path The socket to listen on.
+ * @param argc_p Replaced with the client's argument count in a worker.
+ * @param argv_p Replaced with the client's arguments in a worker, with the
+ * program name of the server kept as argv[0].
+ * @return TRUE in a worker, FALSE if the server couldn't be started.
+ */
+gboolean tshark_fork_server(const char *path, int *argc_p, char ***argv_p);
+
+#endif /* _WIN32 */
+
+#endif /* __TSHARK_FORK_SERVER_H__ */
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 2
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=2 tabstop=8 expandtab:
+ * :indentSize=2:tabSize=8:noTabs=true:
+ */
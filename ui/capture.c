@@ -133,6 +133,7 @@ capture_start(capture_options *capture_opts, capture_session *cap_session, info_
 
   cap_session->state = CAPTURE_PREPARING;
   cap_session->count = 0;
+  cap_session->count_pending = 0;
   g_log(LOG_DOMAIN_CAPTURE, G_LOG_LEVEL_MESSAGE, "Capture Start ...");
   source = get_iface_list_string(capture_opts, IFLIST_SHOW_FILTER);
   cf_set_tempfile_source((capture_file *)cap_session->cf, source->str);
@@ -312,6 +313,7 @@ capture_input_new_file(capture_session *cap_session, gchar *new_file)
             capture_callback_invoke(capture_cb_capture_update_finished, cap_session);
             cf_finish_tail((capture_file *)cap_session->cf, &err);
             cf_close((capture_file *)cap_session->cf);
+            cap_session->count_pending = 0;
         } else {
             capture_callback_invoke(capture_cb_capture_fixed_finished, cap_session);
         }
@@ -361,18 +363,23 @@ capture_input_new_file(capture_session *cap_session, gchar *new_file)
 }
 
 
-/* capture child tells us we have new packets to read */
+/* capture child tells us we have new packets to read; to_read may be 0
+   if we are only catching up with packets we put off reading earlier */
 void
 capture_input_new_packets(capture_session *cap_session, int to_read)
 {
   capture_options *capture_opts = cap_session->capture_opts;
   int  err;
+  int  deferred;
 
   g_assert(capture_opts->save_file);
 
   if(capture_opts->real_time_mode) {
-    /* Read from the capture file the number of records the child told us it added. */
-    switch (cf_continue_tail((capture_file *)cap_session->cf, to_read, &err)) {
+    /* Read from the capture file the number of records the child told us it
+       added, plus whatever we didn't get to last time. */
+    switch (cf_continue_tail((capture_file *)cap_session->cf,
+                             to_read + (int)cap_session->count_pending,
+                             &deferred, &err)) {
 
     case CF_READ_OK:
     case CF_READ_ERROR:
@@ -381,7 +388,8 @@ capture_input_new_packets(capture_session *cap_session, int to_read)
          file.
 
          XXX - abort on a read error? */
-         capture_callback_invoke(capture_cb_capture_update_continue, cap_session);
+      cap_session->count_pending = deferred;
+      capture_callback_invoke(capture_cb_capture_update_continue, cap_session);
       break;
 
     case CF_READ_ABORTED:
@@ -591,6 +599,7 @@ capture_input_closed(capture_session *cap_session, gchar *msg)
     capture_info_close(cap_session->cap_data_info);
 
   cap_session->state = CAPTURE_STOPPED;
+  cap_session->count_pending = 0;
 
   /* if we couldn't open a capture file, there's nothing more for us to do */
   if(capture_opts->save_file == NULL) {
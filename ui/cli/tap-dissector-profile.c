@@ -0,0 +1,150 @@
+/* tap-dissector-profile.c
+ * Report the time spent in the dissectors of each protocol, how often
+ * they were called and how many of those calls ended with an exception
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <glib.h>
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+
+void register_tap_listener_dissector_profile(void);
+
+typedef struct {
+	int			proto_id;
+	dissector_profile_t	profile;
+} profile_row_t;
+
+static void
+dissector_profile_collect(int proto_id, const dissector_profile_t *profile, gpointer user_data)
+{
+	GArray		*rows = (GArray *)user_data;
+	profile_row_t	 row;
+
+	row.proto_id = proto_id;
+	row.profile = *profile;
+	g_array_append_val(rows, row);
+}
+
+/* Most time spent in the protocol's own code first */
+static gint
+dissector_profile_compare(gconstpointer a, gconstpointer b)
+{
+	const profile_row_t *row_a = (const profile_row_t *)a;
+	const profile_row_t *row_b = (const profile_row_t *)b;
+
+	if (row_a->profile.self_us != row_b->profile.self_us)
+		return row_a->profile.self_us > row_b->profile.self_us ? -1 : 1;
+	return row_a->proto_id - row_b->proto_id;
+}
+
+static void
+dissector_profile_draw(void *tapdata _U_)
+{
+	GArray		*rows;
+	profile_row_t	*row;
+	guint64		 self_total = 0;
+	guint		 i;
+
+	rows = g_array_new(FALSE, FALSE, sizeof(profile_row_t));
+	dissector_profile_foreach(dissector_profile_collect, rows);
+	g_array_sort(rows, dissector_profile_compare);
+
+	for (i = 0; i < rows->len; i++)
+		self_total += g_array_index(rows, profile_row_t, i).profile.self_us;
+
+	printf("\n");
+	printf("===================================================================\n");
+	printf("Dissector Profile\n");
+	printf("%-24s %12s %10s %12s %12s %7s %10s\n", "Protocol", "Calls", "Exceptions",
+	       "Total (ms)", "Self (ms)", "Self", "us/Call");
+	for (i = 0; i < rows->len; i++) {
+		row = &g_array_index(rows, profile_row_t, i);
+		printf("%-24s %12" G_GINT64_MODIFIER "u %10" G_GINT64_MODIFIER "u %12.3f %12.3f %6.2f%% %10.3f\n",
+		       proto_get_protocol_short_name(find_protocol_by_id(row->proto_id)),
+		       row->profile.calls, row->profile.exceptions,
+		       (double)row->profile.total_us / 1000.0,
+		       (double)row->profile.self_us / 1000.0,
+		       self_total ? 100.0 * (double)row->profile.self_us / (double)self_total : 0.0,
+		       (double)row->profile.total_us / (double)row->profile.calls);
+	}
+	printf("===================================================================\n");
+
+	g_array_free(rows, TRUE);
+}
+
+static void
+dissector_profile_init(const char *opt_arg _U_, void *userdata _U_)
+{
+	GString	*error_string;
+
+	/* As with dissector_tables, the figures are kept by epan itself */
+	dissector_set_profiling(TRUE);
+	error_string = register_tap_listener(
+		"frame",
+		NULL,
+		NULL,
+		TL_REQUIRES_NOTHING,
+		NULL,
+		NULL,
+		dissector_profile_draw);
+	if (error_string) {
+		/* error, we failed to attach to the tap. clean up */
+		fprintf(stderr, "tshark: Couldn't register dissector,profile tap: %s\n",
+				error_string->str);
+		g_string_free(error_string, TRUE);
+		exit(1);
+	}
+}
+
+static stat_tap_ui dissector_profile_ui = {
+	REGISTER_STAT_GROUP_GENERIC,
+	NULL,
+	"dissector,profile",
+	dissector_profile_init,
+	0,
+	NULL
+};
+
+void
+register_tap_listener_dissector_profile(void)
+{
+	register_stat_tap_ui(&dissector_profile_ui, NULL);
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -0,0 +1,170 @@
+/* tap-dissector-tables.c
+ * Report how often each uint dissector table was consulted while
+ * dissecting and how often a dissector was found, and how often each
+ * heuristic dissector was tried, accepted a packet and how long it took,
+ * and how many exceptions were shown for each protocol.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+#include <epan/show_exception.h>
+
+void register_tap_listener_dissector_tables(void);
+
+static void
+dissector_tables_print_table(const gchar *table_name, const gchar *ui_name, gpointer user_data _U_)
+{
+	guint64 lookups, hits;
+
+	dissector_table_get_lookup_stats(table_name, &lookups, &hits);
+	if (lookups == 0)
+		return;
+
+	printf("%-32s %12" G_GINT64_MODIFIER "u %12" G_GINT64_MODIFIER "u %6.2f%%  %s\n",
+	       table_name, lookups, hits, 100.0 * (double)hits / (double)lookups,
+	       ui_name);
+}
+
+static void
+dissector_tables_print_heur(const gchar *table_name _U_, heur_dtbl_entry_t *entry, gpointer user_data _U_)
+{
+	if (entry->tries == 0)
+		return;
+
+	printf("%-32s %12" G_GINT64_MODIFIER "u %12" G_GINT64_MODIFIER "u %6.2f%% %10.0f  %s\n",
+	       entry->short_name, entry->tries, entry->hits,
+	       100.0 * (double)entry->hits / (double)entry->tries,
+	       1000.0 * (double)entry->time_us / (double)entry->tries,
+	       entry->list_name);
+}
+
+static void
+dissector_tables_print_heur_table(const char *table_name, struct heur_dissector_list *table _U_, gpointer user_data)
+{
+	heur_dissector_table_foreach(table_name, dissector_tables_print_heur, user_data);
+}
+
+static void
+dissector_tables_print_exceptions(void)
+{
+	void	*cookie;
+	int	 proto_id;
+	const char *short_name;
+	guint64	 exceptions, truncated;
+
+	for (proto_id = proto_get_first_protocol(&cookie); proto_id != -1;
+	     proto_id = proto_get_next_protocol(&cookie)) {
+		short_name = proto_get_protocol_short_name(find_protocol_by_id(proto_id));
+		show_exception_get_counts(short_name, &exceptions, &truncated);
+		if (exceptions == 0)
+			continue;
+
+		printf("%-32s %12" G_GINT64_MODIFIER "u %12" G_GINT64_MODIFIER "u\n",
+		       short_name, exceptions, truncated);
+	}
+}
+
+static void
+dissector_tables_draw(void *tapdata _U_)
+{
+	printf("\n");
+	printf("===================================================================\n");
+	printf("Dissector Table Lookups\n");
+	printf("%-32s %12s %12s %7s  %s\n", "Table", "Lookups", "Hits", "Hit", "Description");
+	dissector_all_tables_foreach_table(dissector_tables_print_table, NULL,
+					   (GCompareFunc)strcmp);
+	printf("\n");
+	printf("Heuristic Dissectors\n");
+	printf("%-32s %12s %12s %7s %10s  %s\n", "Heuristic", "Tries", "Hits", "Hit", "ns/Try", "List");
+	dissector_all_heur_tables_foreach_table(dissector_tables_print_heur_table, NULL,
+						(GCompareFunc)strcmp);
+	printf("\n");
+	printf("Exceptions\n");
+	printf("%-32s %12s %12s\n", "Protocol", "Exceptions", "Truncated");
+	dissector_tables_print_exceptions();
+	printf("===================================================================\n");
+}
+
+static void
+dissector_tables_init(const char *opt_arg _U_, void *userdata _U_)
+{
+	GString	*error_string;
+
+	/*
+	 * The counts are kept by the tables themselves; we only need a
+	 * listener so that we get to print them once dissection is done.
+	 * Timing the heuristics costs a clock read per call, so it's only
+	 * done when asked for.
+	 */
+	heur_dissector_set_timing(TRUE);
+	error_string = register_tap_listener(
+		"frame",
+		NULL,
+		NULL,
+		TL_REQUIRES_NOTHING,
+		NULL,
+		NULL,
+		dissector_tables_draw);
+	if (error_string) {
+		/* error, we failed to attach to the tap. clean up */
+		fprintf(stderr, "tshark: Couldn't register dissector_tables tap: %s\n",
+				error_string->str);
+		g_string_free(error_string, TRUE);
+		exit(1);
+	}
+}
+
+static stat_tap_ui dissector_tables_ui = {
+	REGISTER_STAT_GROUP_GENERIC,
+	NULL,
+	"dissector_tables",
+	dissector_tables_init,
+	0,
+	NULL
+};
+
+void
+register_tap_listener_dissector_tables(void)
+{
+	register_stat_tap_ui(&dissector_tables_ui, NULL);
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -41,19 +41,13 @@
  * removed to accomodate tshark
  */
 static gboolean
-local_eo_save_entry(const gchar *save_as_filename, export_object_entry_t *entry)
+local_eo_write_entry(int to_fd, export_object_entry_t *entry)
 {
-    int to_fd;
     gint64 bytes_left;
     int bytes_to_write;
     ssize_t bytes_written;
     guint8 *ptr;
 
-    to_fd = ws_open(save_as_filename, O_WRONLY | O_CREAT | O_EXCL | O_BINARY, 0644);
-    if(to_fd == -1) { /* An error occurred */
-        return FALSE;
-    }
-
     /*
      * The third argument to _write() on Windows is an unsigned int,
      * so, on Windows, that's the size of the third argument to
@@ -90,10 +84,26 @@ local_eo_save_entry(const gchar *save_as_filename, export_object_entry_t *entry)
 }
 
 typedef struct _export_object_list_gui_t {
-    GSList *entries;
+    GPtrArray *entries;     /* Entries that may still change, saved by eo_draw */
     register_eo_t* eo;
+    gchar *save_in_path;
+    gint failed;            /* Number of objects that couldn't be saved */
+#if GLIB_CHECK_VERSION(2,36,0)
+    GThreadPool *writers;   /* Writes out the objects that are complete */
+#endif
 } export_object_list_gui_t;
 
+typedef struct _eo_write_job_t {
+    int to_fd;
+    export_object_entry_t *entry;
+} eo_write_job_t;
+
+/*
+ * Don't queue more objects than this for the writers; past it the
+ * dissection waits for the disk by writing objects itself.
+ */
+#define EO_MAX_QUEUED_WRITES 64
+
 static GHashTable* eo_opts = NULL;
 
 static gboolean
@@ -145,19 +155,105 @@ gboolean eo_tap_opt_add(const char *option_string)
     return FALSE;
 }
 
+/* Create a file with a name that's not in use yet for an object */
+static int
+eo_create_file(const gchar *save_in_path, export_object_entry_t *entry)
+{
+    GString *safe_filename = NULL;
+    gchar *save_as_fullpath = NULL;
+    int count = 0;
+    int to_fd;
+
+    do {
+        g_free(save_as_fullpath);
+        if (entry->filename) {
+            safe_filename = eo_massage_str(entry->filename,
+                EXPORT_OBJECT_MAXFILELEN - strlen(save_in_path), count);
+        } else {
+            char generic_name[EXPORT_OBJECT_MAXFILELEN+1];
+            const char *ext;
+            ext = eo_ct2ext(entry->content_type);
+            g_snprintf(generic_name, sizeof(generic_name),
+                "object%u%s%s", entry->pkt_num, ext ? "." : "", ext ? ext : "");
+            safe_filename = eo_massage_str(generic_name,
+                EXPORT_OBJECT_MAXFILELEN - strlen(save_in_path), count);
+        }
+        save_as_fullpath = g_build_filename(save_in_path, safe_filename->str, NULL);
+        g_string_free(safe_filename, TRUE);
+    } while (g_file_test(save_as_fullpath, G_FILE_TEST_EXISTS) && ++count < 1000);
+
+    to_fd = ws_open(save_as_fullpath, O_WRONLY | O_CREAT | O_EXCL | O_BINARY, 0644);
+    g_free(save_as_fullpath);
+    return to_fd;
+}
+
+#if GLIB_CHECK_VERSION(2,36,0)
+static void
+eo_write_job(gpointer data, gpointer user_data)
+{
+    eo_write_job_t *job = (eo_write_job_t *)data;
+    export_object_list_gui_t *object_list = (export_object_list_gui_t*)user_data;
+
+    if (!local_eo_write_entry(job->to_fd, job->entry))
+        g_atomic_int_inc(&object_list->failed);
+    eo_free_entry(job->entry);
+    g_free(job);
+}
+#endif
+
+/*
+ * Save an object and free it. The name is picked here, so that it
+ * doesn't depend on the order in which the writers get to the objects.
+ */
+static void
+eo_save_and_free_entry(export_object_list_gui_t *object_list, export_object_entry_t *entry)
+{
+    int to_fd;
+
+    if (strlen(object_list->save_in_path) >= EXPORT_OBJECT_MAXFILELEN ||
+        (to_fd = eo_create_file(object_list->save_in_path, entry)) == -1) {
+        g_atomic_int_inc(&object_list->failed);
+        eo_free_entry(entry);
+        return;
+    }
+
+#if GLIB_CHECK_VERSION(2,36,0)
+    if (object_list->writers &&
+        g_thread_pool_unprocessed(object_list->writers) < EO_MAX_QUEUED_WRITES) {
+        eo_write_job_t *job = g_new(eo_write_job_t, 1);
+
+        job->to_fd = to_fd;
+        job->entry = entry;
+        if (g_thread_pool_push(object_list->writers, job, NULL))
+            return;
+        g_free(job);
+    }
+#endif
+
+    if (!local_eo_write_entry(to_fd, entry))
+        g_atomic_int_inc(&object_list->failed);
+    eo_free_entry(entry);
+}
+
 static void
 object_list_add_entry(void *gui_data, export_object_entry_t *entry)
 {
     export_object_list_gui_t *object_list = (export_object_list_gui_t*)gui_data;
 
-    object_list->entries = g_slist_append(object_list->entries, entry);
+    /* Only the entries that may still change have to be kept around. */
+    if (get_eo_updates_entries(object_list->eo))
+        g_ptr_array_add(object_list->entries, entry);
+    else
+        eo_save_and_free_entry(object_list, entry);
 }
 
 static export_object_entry_t*
 object_list_get_entry(void *gui_data, int row) {
     export_object_list_gui_t *object_list = (export_object_list_gui_t*)gui_data;
 
-    return (export_object_entry_t *)g_slist_nth_data(object_list->entries, row);
+    if (row < 0 || (guint)row >= object_list->entries->len)
+        return NULL;
+    return (export_object_entry_t *)g_ptr_array_index(object_list->entries, row);
 }
 
 /* This is just for writing Exported Objects to a file */
@@ -166,65 +262,32 @@ eo_draw(void *tapdata)
 {
     export_object_list_t *tap_object = (export_object_list_t *)tapdata;
     export_object_list_gui_t *object_list = (export_object_list_gui_t*)tap_object->gui_data;
-    GSList *slist = object_list->entries;
-    export_object_entry_t *entry;
-    gboolean all_saved = TRUE;
-    gchar* save_in_path = (gchar*)g_hash_table_lookup(eo_opts, proto_get_protocol_filter_name(get_eo_proto_id(object_list->eo)));
-    GString *safe_filename = NULL;
-    gchar *save_as_fullpath = NULL;
-    int count = 0;
+    guint i;
 
-    if (!g_file_test(save_in_path, G_FILE_TEST_IS_DIR)) {
-        /* If the destination directory (or its parents) do not exist, create them. */
-        if (g_mkdir_with_parents(save_in_path, 0755) == -1) {
-            fprintf(stderr, "Failed to create export objects output directory \"%s\": %s\n",
-                    save_in_path, g_strerror(errno));
-            return;
-        }
+    for (i = 0; i < object_list->entries->len; i++) {
+        eo_save_and_free_entry(object_list,
+            (export_object_entry_t *)g_ptr_array_index(object_list->entries, i));
     }
+    g_ptr_array_set_size(object_list->entries, 0);
 
-    if ((strlen(save_in_path) < EXPORT_OBJECT_MAXFILELEN)) {
-        while (slist) {
-            entry = (export_object_entry_t *)slist->data;
-            do {
-                g_free(save_as_fullpath);
-                if (entry->filename) {
-                    safe_filename = eo_massage_str(entry->filename,
-                        EXPORT_OBJECT_MAXFILELEN - strlen(save_in_path), count);
-                } else {
-                    char generic_name[EXPORT_OBJECT_MAXFILELEN+1];
-                    const char *ext;
-                    ext = eo_ct2ext(entry->content_type);
-                    g_snprintf(generic_name, sizeof(generic_name),
-                        "object%u%s%s", entry->pkt_num, ext ? "." : "", ext ? ext : "");
-                    safe_filename = eo_massage_str(generic_name,
-                        EXPORT_OBJECT_MAXFILELEN - strlen(save_in_path), count);
-                }
-                save_as_fullpath = g_build_filename(save_in_path, safe_filename->str, NULL);
-                g_string_free(safe_filename, TRUE);
-            } while (g_file_test(save_as_fullpath, G_FILE_TEST_EXISTS) && ++count < 1000);
-            count = 0;
-            if (!local_eo_save_entry(save_as_fullpath, entry))
-                all_saved = FALSE;
-            g_free(save_as_fullpath);
-            save_as_fullpath = NULL;
-            slist = slist->next;
-        }
-    }
-    else
-    {
-        all_saved = FALSE;
+#if GLIB_CHECK_VERSION(2,36,0)
+    /* Wait for the objects that are still being written. */
+    if (object_list->writers) {
+        g_thread_pool_free(object_list->writers, FALSE, TRUE);
+        object_list->writers = NULL;
     }
+#endif
 
-    if (!all_saved)
+    if (g_atomic_int_get(&object_list->failed) != 0)
         fprintf(stderr, "Export objects (%s): Some files could not be saved.\n",
                     proto_get_protocol_filter_name(get_eo_proto_id(object_list->eo)));
 }
 
 static void
-exportobject_handler(gpointer key, gpointer value _U_, gpointer user_data _U_)
+exportobject_handler(gpointer key, gpointer value, gpointer user_data _U_)
 {
     GString *error_msg;
+    gchar *save_in_path;
     export_object_list_t *tap_data;
     export_object_list_gui_t *object_list;
     register_eo_t* eo;
@@ -236,6 +299,16 @@ exportobject_handler(gpointer key, gpointer value _U_, gpointer user_data _U_)
         return;
     }
 
+    save_in_path = (gchar*)value;
+    if (!g_file_test(save_in_path, G_FILE_TEST_IS_DIR)) {
+        /* If the destination directory (or its parents) do not exist, create them. */
+        if (g_mkdir_with_parents(save_in_path, 0755) == -1) {
+            fprintf(stderr, "Failed to create export objects output directory \"%s\": %s\n",
+                    save_in_path, g_strerror(errno));
+            return;
+        }
+    }
+
     tap_data = g_new0(export_object_list_t,1);
     object_list = g_new0(export_object_list_gui_t,1);
 
@@ -244,6 +317,12 @@ exportobject_handler(gpointer key, gpointer value _U_, gpointer user_data _U_)
     tap_data->gui_data = (void*)object_list;
 
     object_list->eo = eo;
+    object_list->entries = g_ptr_array_new();
+    object_list->save_in_path = save_in_path;
+#if GLIB_CHECK_VERSION(2,36,0)
+    object_list->writers = g_thread_pool_new(eo_write_job, object_list,
+                                             g_get_num_processors(), FALSE, NULL);
+#endif
 
     /* Data will be gathered via a tap callback */
     error_msg = register_tap_listener(get_eo_tap_listener_name(eo), tap_data, NULL, 0,
@@ -252,6 +331,11 @@ exportobject_handler(gpointer key, gpointer value _U_, gpointer user_data _U_)
     if (error_msg) {
         fprintf(stderr, "tshark: Can't register %s tap: %s\n", (const char*)key, error_msg->str);
         g_string_free(error_msg, TRUE);
+#if GLIB_CHECK_VERSION(2,36,0)
+        if (object_list->writers)
+            g_thread_pool_free(object_list->writers, TRUE, TRUE);
+#endif
+        g_ptr_array_free(object_list->entries, TRUE);
         g_free(tap_data);
         g_free(object_list);
         return;
@@ -64,28 +64,48 @@ typedef struct _io_stat_t {
     guint64 interval;     /* The user-specified time interval (us) */
     guint invl_prec;      /* Decimal precision of the time interval (1=10s, 2=100s etc) */
     int num_cols;         /* The number of columns of stats in the table */
-    struct _io_stat_item_t *items;  /* Each item is a single cell in the table */
+    struct _io_stat_item_t *items;  /* Each item is a column of the table */
     time_t start_time;    /* Time of first frame matching the filter */
     const char **filters; /* 'io,stat' cmd strings (e.g., "AVG(smb.time)smb.time") */
     guint64 *max_vals;    /* The max value sans the decimal or nsecs portion in each stat column */
     guint32 *max_frame;   /* The max frame number displayed in each stat column */
 } io_stat_t;
 
-typedef struct _io_stat_item_t {
-    io_stat_t *parent;
-    struct _io_stat_item_t *next;
-    struct _io_stat_item_t *prev;
-    guint64 start_time;   /* Time since start of capture (us)*/
-    int calc_type;        /* The statistic type */
-    int colnum;           /* Column number of this stat (0 to n) */
-    int hf_index;
+/* A single cell in the table */
+typedef struct _io_stat_cell_t {
     guint32 frames;
     guint32 num;          /* The sample size of a given statistic (only needed for AVG) */
     guint64 counter;      /* The accumulated data for the calculation of that statistic */
     gfloat float_counter;
     gdouble double_counter;
+} io_stat_cell_t;
+
+typedef struct _io_stat_item_t {
+    io_stat_t *parent;
+    io_stat_cell_t *cells; /* One per interval, indexed by interval number */
+    guint num_cells;      /* The intervals up to the last one with a frame */
+    guint cells_size;     /* The number of cells allocated */
+    int calc_type;        /* The statistic type */
+    int colnum;           /* Column number of this stat (0 to n) */
+    int hf_index;
 } io_stat_item_t;
 
+/* Get the cell of interval invl of column mit, adding cells up to it */
+static io_stat_cell_t *
+iostat_cell(io_stat_item_t *mit, guint invl)
+{
+    if (invl >= mit->num_cells) {
+        if (invl >= mit->cells_size) {
+            while (invl >= mit->cells_size)
+                mit->cells_size *= 2;
+            mit->cells = (io_stat_cell_t *)g_realloc(mit->cells, sizeof(io_stat_cell_t) * mit->cells_size);
+        }
+        memset(&mit->cells[mit->num_cells], 0, sizeof(io_stat_cell_t) * (invl + 1 - mit->num_cells));
+        mit->num_cells = invl + 1;
+    }
+    return &mit->cells[invl];
+}
+
 #define NANOSECS_PER_SEC G_GUINT64_CONSTANT(1000000000)
 
 static guint64 last_relative_time;
@@ -95,8 +115,9 @@ iostat_packet(void *arg, packet_info *pinfo, epan_dissect_t *edt, const void *du
 {
     io_stat_t *parent;
     io_stat_item_t *mit;
-    io_stat_item_t *it;
-    guint64 relative_time, rt;
+    io_stat_cell_t *it;
+    guint invl;
+    guint64 relative_time;
     nstime_t *new_time;
     GPtrArray *gp;
     guint i;
@@ -119,53 +140,32 @@ iostat_packet(void *arg, packet_info *pinfo, epan_dissect_t *edt, const void *du
         mit->parent->start_time = pinfo->abs_ts.secs - pinfo->rel_ts.secs;
     }
 
-    /* The prev item is always the last interval in which we saw packets. */
-    it = mit->prev;
-
-    /* If we have moved into a new interval (row), create a new io_stat_item_t struct for every interval
-    *  between the last struct and this one. If an item was not found in a previous interval, an empty
-    *  struct will be created for it. */
-    rt = relative_time;
-    while (rt >= it->start_time + parent->interval) {
-        it->next = (io_stat_item_t *)g_malloc(sizeof(io_stat_item_t));
-        it->next->prev = it;
-        it->next->next = NULL;
-        it = it->next;
-        mit->prev = it;
-
-        it->start_time = it->prev->start_time + parent->interval;
-        it->frames = 0;
-        it->counter = 0;
-        it->float_counter = 0;
-        it->double_counter = 0;
-        it->num = 0;
-        it->calc_type = it->prev->calc_type;
-        it->hf_index = it->prev->hf_index;
-        it->colnum = it->prev->colnum;
-    }
+    /* Intervals between the last one with a frame and this one get empty cells. */
+    invl = (guint)(relative_time / parent->interval);
+    it = iostat_cell(mit, invl);
 
     /* Store info in the current structure */
     it->frames++;
 
-    switch (it->calc_type) {
+    switch (mit->calc_type) {
     case CALC_TYPE_FRAMES:
     case CALC_TYPE_BYTES:
     case CALC_TYPE_FRAMES_AND_BYTES:
         it->counter += pinfo->fd->pkt_len;
         break;
     case CALC_TYPE_COUNT:
-        gp = proto_get_finfo_ptr_array(edt->tree, it->hf_index);
+        gp = proto_get_finfo_ptr_array(edt->tree, mit->hf_index);
         if (gp) {
             it->counter += gp->len;
         }
         break;
     case CALC_TYPE_SUM:
-        gp = proto_get_finfo_ptr_array(edt->tree, it->hf_index);
+        gp = proto_get_finfo_ptr_array(edt->tree, mit->hf_index);
         if (gp) {
             guint64 val;
 
             for (i=0; i<gp->len; i++) {
-                switch (proto_registrar_get_ftype(it->hf_index)) {
+                switch (proto_registrar_get_ftype(mit->hf_index)) {
                 case FT_UINT8:
                 case FT_UINT16:
                 case FT_UINT24:
@@ -214,13 +214,13 @@ iostat_packet(void *arg, packet_info *pinfo, epan_dissect_t *edt, const void *du
         }
         break;
     case CALC_TYPE_MIN:
-        gp = proto_get_finfo_ptr_array(edt->tree, it->hf_index);
+        gp = proto_get_finfo_ptr_array(edt->tree, mit->hf_index);
         if (gp) {
             guint64 val;
             gfloat float_val;
             gdouble double_val;
 
-            ftype = proto_registrar_get_ftype(it->hf_index);
+            ftype = proto_registrar_get_ftype(mit->hf_index);
             for (i=0; i<gp->len; i++) {
                 switch (ftype) {
                 case FT_UINT8:
@@ -290,13 +290,13 @@ iostat_packet(void *arg, packet_info *pinfo, epan_dissect_t *edt, const void *du
         }
         break;
     case CALC_TYPE_MAX:
-        gp = proto_get_finfo_ptr_array(edt->tree, it->hf_index);
+        gp = proto_get_finfo_ptr_array(edt->tree, mit->hf_index);
         if (gp) {
             guint64 val;
             gfloat float_val;
             gdouble double_val;
 
-            ftype = proto_registrar_get_ftype(it->hf_index);
+            ftype = proto_registrar_get_ftype(mit->hf_index);
             for (i=0; i<gp->len; i++) {
                 switch (ftype) {
                 case FT_UINT8:
@@ -359,11 +359,11 @@ iostat_packet(void *arg, packet_info *pinfo, epan_dissect_t *edt, const void *du
         }
         break;
     case CALC_TYPE_AVG:
-        gp = proto_get_finfo_ptr_array(edt->tree, it->hf_index);
+        gp = proto_get_finfo_ptr_array(edt->tree, mit->hf_index);
         if (gp) {
             guint64 val;
 
-            ftype = proto_registrar_get_ftype(it->hf_index);
+            ftype = proto_registrar_get_ftype(mit->hf_index);
             for (i=0; i<gp->len; i++) {
                 it->num++;
                 switch (ftype) {
@@ -418,9 +418,9 @@ iostat_packet(void *arg, packet_info *pinfo, epan_dissect_t *edt, const void *du
         }
         break;
     case CALC_TYPE_LOAD:
-        gp = proto_get_finfo_ptr_array(edt->tree, it->hf_index);
+        gp = proto_get_finfo_ptr_array(edt->tree, mit->hf_index);
         if (gp) {
-            ftype = proto_registrar_get_ftype(it->hf_index);
+            ftype = proto_registrar_get_ftype(mit->hf_index);
             if (ftype != FT_RELATIVE_TIME) {
                 fprintf(stderr,
                     "\ntshark: LOAD() is only supported for relative-time fields such as smb.time\n");
@@ -429,22 +429,22 @@ iostat_packet(void *arg, packet_info *pinfo, epan_dissect_t *edt, const void *du
             for (i=0; i<gp->len; i++) {
                 guint64 val;
                 int tival;
-                io_stat_item_t *pit;
+                guint pinvl;
 
                 new_time = (nstime_t *)fvalue_get(&((field_info *)gp->pdata[i])->value);
                 val = ((guint64)new_time->secs*G_GUINT64_CONSTANT(1000000)) + (guint64)(new_time->nsecs/1000);
                 tival = (int)(val % parent->interval);
                 it->counter += tival;
                 val -= tival;
-                pit = it->prev;
-                while (val > 0) {
+                /* The rest goes to the preceding intervals, back to the first */
+                for (pinvl = invl; val > 0 && pinvl > 0; ) {
+                    pinvl--;
                     if (val < (guint64)parent->interval) {
-                        pit->counter += val;
+                        mit->cells[pinvl].counter += val;
                         break;
                     }
-                    pit->counter += parent->interval;
+                    mit->cells[pinvl].counter += parent->interval;
                     val -= parent->interval;
-                    pit = pit->prev;
                 }
             }
         }
@@ -456,65 +456,65 @@ iostat_packet(void *arg, packet_info *pinfo, epan_dissect_t *edt, const void *du
     *  calc the average, round it to the next second and store the seconds. For all other calc types
     *  of RELATIVE_TIME fields, store the counters without modification.
     *  fields. */
-    switch (it->calc_type) {
+    switch (mit->calc_type) {
         case CALC_TYPE_FRAMES:
         case CALC_TYPE_FRAMES_AND_BYTES:
-            parent->max_frame[it->colnum] =
-                MAX(parent->max_frame[it->colnum], it->frames);
-            if (it->calc_type == CALC_TYPE_FRAMES_AND_BYTES)
-                parent->max_vals[it->colnum] =
-                    MAX(parent->max_vals[it->colnum], it->counter);
+            parent->max_frame[mit->colnum] =
+                MAX(parent->max_frame[mit->colnum], it->frames);
+            if (mit->calc_type == CALC_TYPE_FRAMES_AND_BYTES)
+                parent->max_vals[mit->colnum] =
+                    MAX(parent->max_vals[mit->colnum], it->counter);
             break;
         case CALC_TYPE_BYTES:
         case CALC_TYPE_COUNT:
         case CALC_TYPE_LOAD:
-            parent->max_vals[it->colnum] = MAX(parent->max_vals[it->colnum], it->counter);
+            parent->max_vals[mit->colnum] = MAX(parent->max_vals[mit->colnum], it->counter);
             break;
         case CALC_TYPE_SUM:
         case CALC_TYPE_MIN:
         case CALC_TYPE_MAX:
-            ftype = proto_registrar_get_ftype(it->hf_index);
+            ftype = proto_registrar_get_ftype(mit->hf_index);
             switch (ftype) {
                 case FT_FLOAT:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], (guint64)(it->float_counter+0.5));
+                    parent->max_vals[mit->colnum] =
+                        MAX(parent->max_vals[mit->colnum], (guint64)(it->float_counter+0.5));
                     break;
                 case FT_DOUBLE:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], (guint64)(it->double_counter+0.5));
+                    parent->max_vals[mit->colnum] =
+                        MAX(parent->max_vals[mit->colnum], (guint64)(it->double_counter+0.5));
                     break;
                 case FT_RELATIVE_TIME:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], it->counter);
+                    parent->max_vals[mit->colnum] =
+                        MAX(parent->max_vals[mit->colnum], it->counter);
                     break;
                 default:
                     /* UINT16-64 and INT8-64 */
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], it->counter);
+                    parent->max_vals[mit->colnum] =
+                        MAX(parent->max_vals[mit->colnum], it->counter);
                     break;
             }
             break;
         case CALC_TYPE_AVG:
             if (it->num == 0) /* avoid division by zero */
                break;
-            ftype = proto_registrar_get_ftype(it->hf_index);
+            ftype = proto_registrar_get_ftype(mit->hf_index);
             switch (ftype) {
                 case FT_FLOAT:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], (guint64)it->float_counter/it->num);
+                    parent->max_vals[mit->colnum] =
+                        MAX(parent->max_vals[mit->colnum], (guint64)it->float_counter/it->num);
                     break;
                 case FT_DOUBLE:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], (guint64)it->double_counter/it->num);
+                    parent->max_vals[mit->colnum] =
+                        MAX(parent->max_vals[mit->colnum], (guint64)it->double_counter/it->num);
                     break;
                 case FT_RELATIVE_TIME:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], ((it->counter/(guint64)it->num) + G_GUINT64_CONSTANT(500000000)) / NANOSECS_PER_SEC);
+                    parent->max_vals[mit->colnum] =
+                        MAX(parent->max_vals[mit->colnum], ((it->counter/(guint64)it->num) + G_GUINT64_CONSTANT(500000000)) / NANOSECS_PER_SEC);
                     break;
                 default:
                     /* UINT16-64 and INT8-64 */
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], it->counter/it->num);
+                    parent->max_vals[mit->colnum] =
+                        MAX(parent->max_vals[mit->colnum], it->counter/it->num);
                     break;
             }
     }
@@ -574,7 +574,8 @@ iostat_draw(void *arg)
     char *spaces, *spaces_s, *filler_s = NULL, **fmts, *fmt = NULL;
     const char *filter;
     static gchar dur_mag_s[3], invl_prec_s[3], fr_mag_s[3], val_mag_s[3], *invl_fmt, *full_fmt;
-    io_stat_item_t *mit, **stat_cols, *item, **item_in_column;
+    io_stat_item_t *mit, **stat_cols, *item;
+    io_stat_cell_t *cell;
     gboolean last_row = FALSE;
     io_stat_t *iot;
     column_width *col_w;
@@ -984,12 +985,6 @@ iostat_draw(void *arg)
         num_rows = (int)(duration/interval) + ((int)(duration%interval) > 0 ? 1 : 0);
     }
 
-    /* Load item_in_column with the first item in each column */
-    item_in_column = (io_stat_item_t **)g_malloc(sizeof(io_stat_item_t *) * num_cols);
-    for (j=0; j<num_cols; j++) {
-        item_in_column[j] = stat_cols[j];
-    }
-
     /* Display the table values
     *
     * The outer loop is for time interval rows and the inner loop is for stat column items.*/
@@ -1121,19 +1116,20 @@ iostat_draw(void *arg)
         /* Display stat values in each column for this row */
         for (j=0; j<num_cols; j++) {
             fmt = fmts[j];
-            item = item_in_column[j];
+            item = stat_cols[j];
+            cell = (guint)i < item->num_cells ? &item->cells[i] : NULL;
 
-            if (item) {
+            if (cell) {
                 switch (item->calc_type) {
                 case CALC_TYPE_FRAMES:
-                    printf(fmt, item->frames);
+                    printf(fmt, cell->frames);
                     break;
                 case CALC_TYPE_BYTES:
                 case CALC_TYPE_COUNT:
-                    printf(fmt, item->counter);
+                    printf(fmt, cell->counter);
                     break;
                 case CALC_TYPE_FRAMES_AND_BYTES:
-                    printf(fmt, item->frames, item->counter);
+                    printf(fmt, cell->frames, cell->counter);
                     break;
 
                 case CALC_TYPE_SUM:
@@ -1142,43 +1138,43 @@ iostat_draw(void *arg)
                     ftype = proto_registrar_get_ftype(stat_cols[j]->hf_index);
                     switch (ftype) {
                     case FT_FLOAT:
-                        printf(fmt, item->float_counter);
+                        printf(fmt, cell->float_counter);
                         break;
                     case FT_DOUBLE:
-                        printf(fmt, item->double_counter);
+                        printf(fmt, cell->double_counter);
                         break;
                     case FT_RELATIVE_TIME:
-                        item->counter = (item->counter + G_GUINT64_CONSTANT(500)) / G_GUINT64_CONSTANT(1000);
+                        cell->counter = (cell->counter + G_GUINT64_CONSTANT(500)) / G_GUINT64_CONSTANT(1000);
                         printf(fmt,
-                               (int)(item->counter/G_GUINT64_CONSTANT(1000000)),
-                               (int)(item->counter%G_GUINT64_CONSTANT(1000000)));
+                               (int)(cell->counter/G_GUINT64_CONSTANT(1000000)),
+                               (int)(cell->counter%G_GUINT64_CONSTANT(1000000)));
                         break;
                     default:
-                        printf(fmt, item->counter);
+                        printf(fmt, cell->counter);
                         break;
                     }
                     break;
 
                 case CALC_TYPE_AVG:
-                    num = item->num;
+                    num = cell->num;
                     if (num == 0)
                         num = 1;
                     ftype = proto_registrar_get_ftype(stat_cols[j]->hf_index);
                     switch (ftype) {
                     case FT_FLOAT:
-                        printf(fmt, item->float_counter/num);
+                        printf(fmt, cell->float_counter/num);
                         break;
                     case FT_DOUBLE:
-                        printf(fmt, item->double_counter/num);
+                        printf(fmt, cell->double_counter/num);
                         break;
                     case FT_RELATIVE_TIME:
-                        item->counter = ((item->counter / (guint64)num) + G_GUINT64_CONSTANT(500)) / G_GUINT64_CONSTANT(1000);
+                        cell->counter = ((cell->counter / (guint64)num) + G_GUINT64_CONSTANT(500)) / G_GUINT64_CONSTANT(1000);
                         printf(fmt,
-                               (int)(item->counter/G_GUINT64_CONSTANT(1000000)),
-                               (int)(item->counter%G_GUINT64_CONSTANT(1000000)));
+                               (int)(cell->counter/G_GUINT64_CONSTANT(1000000)),
+                               (int)(cell->counter%G_GUINT64_CONSTANT(1000000)));
                         break;
                     default:
-                        printf(fmt, item->counter / (guint64)num);
+                        printf(fmt, cell->counter / (guint64)num);
                         break;
                     }
                     break;
@@ -1189,26 +1185,23 @@ iostat_draw(void *arg)
                     case FT_RELATIVE_TIME:
                         if (!last_row) {
                             printf(fmt,
-                                (int) (item->counter/interval),
-                                   (int)((item->counter%interval)*G_GUINT64_CONSTANT(1000000) / interval));
+                                (int) (cell->counter/interval),
+                                   (int)((cell->counter%interval)*G_GUINT64_CONSTANT(1000000) / interval));
                         } else {
                             printf(fmt,
-                                   (int) (item->counter/(invl_end-t)),
-                                   (int)((item->counter%(invl_end-t))*G_GUINT64_CONSTANT(1000000) / (invl_end-t)));
+                                   (int) (cell->counter/(invl_end-t)),
+                                   (int)((cell->counter%(invl_end-t))*G_GUINT64_CONSTANT(1000000) / (invl_end-t)));
                         }
                         break;
                     }
                     break;
                 }
 
-                if (last_row) {
-                    g_free(fmt);
-                } else {
-                    item_in_column[j] = item_in_column[j]->next;
-                }
             } else {
                 printf(fmt, (guint64)0, (guint64)0);
             }
+            if (last_row)
+                g_free(fmt);
         }
         if (filler_s)
             printf("%s|", filler_s);
@@ -1220,6 +1213,8 @@ iostat_draw(void *arg)
         printf("=");
     }
     printf("\n");
+    for (j=0; j<num_cols; j++)
+        g_free(iot->items[j].cells);
     g_free(iot->items);
     g_free(iot->max_vals);
     g_free(iot->max_frame);
@@ -1230,7 +1225,6 @@ iostat_draw(void *arg)
     g_free(fmts);
     g_free(spaces);
     g_free(stat_cols);
-    g_free(item_in_column);
 }
 
 
@@ -1245,14 +1239,13 @@ register_io_tap(io_stat_t *io, int i, const char *filter)
     char *field;
     header_field_info *hfi;
 
-    io->items[i].prev       = &io->items[i];
-    io->items[i].next       = NULL;
     io->items[i].parent     = io;
-    io->items[i].start_time = 0;
+    io->items[i].cells_size = 1024;
+    io->items[i].cells      = (io_stat_cell_t *)g_malloc(sizeof(io_stat_cell_t) * io->items[i].cells_size);
+    io->items[i].num_cells  = 0;
     io->items[i].calc_type  = CALC_TYPE_FRAMES_AND_BYTES;
-    io->items[i].frames     = 0;
-    io->items[i].counter    = 0;
-    io->items[i].num        = 0;
+    /* The first interval is shown even if no frame falls in it */
+    iostat_cell(&io->items[i], 0);
 
     io->filters[i] = filter;
     flt = filter;
@@ -134,8 +134,14 @@ typedef struct mac_lte_stat_t {
     guint16 number_of_rntis;
 
     mac_lte_ep_t  *ep_list;
+    mac_lte_ep_t  *ep_tail;
+
+    /* ep_list entries by MAC_LTE_EP_KEY(rnti, ueid) */
+    GHashTable    *ep_table;
 } mac_lte_stat_t;
 
+#define MAC_LTE_EP_KEY(rnti, ueid) GUINT_TO_POINTER(((guint)(rnti) << 16) | (ueid))
+
 
 /* Reset the statistics window */
 static void
@@ -153,11 +159,14 @@ mac_lte_stat_reset(void *phs)
     /* Zero common stats */
     memset(&(mac_lte_stat->common_stats), 0, sizeof(mac_lte_common_stats));
 
+    g_hash_table_remove_all(mac_lte_stat->ep_table);
+
     if (!list) {
         return;
     }
 
     mac_lte_stat->ep_list = NULL;
+    mac_lte_stat->ep_tail = NULL;
 }
 
 
@@ -225,7 +234,7 @@ mac_lte_stat_packet(void *phs, packet_info *pinfo, epan_dissect_t *edt _U_,
 {
     /* Get reference to stat window instance */
     mac_lte_stat_t *hs = (mac_lte_stat_t *)phs;
-    mac_lte_ep_t *tmp = NULL, *te = NULL;
+    mac_lte_ep_t *te = NULL;
     int i;
 
     /* Cast tap info struct */
@@ -283,30 +292,23 @@ mac_lte_stat_packet(void *phs, packet_info *pinfo, epan_dissect_t *edt _U_,
         hs->ep_list = alloc_mac_lte_ep(si, pinfo);
         /* Make it the first/only entry */
         te = hs->ep_list;
+        hs->ep_tail = te;
+        g_hash_table_insert(hs->ep_table, MAC_LTE_EP_KEY(si->rnti, si->ueid), te);
 
         /* Update counts of unique ueids & rntis */
         update_ueid_rnti_counts(si->rnti, si->ueid, hs);
     } else {
-        /* Look among existing rows for this RNTI */
-        for (tmp = hs->ep_list;(tmp != NULL); tmp = tmp->next) {
-            /* Match only by RNTI and UEId together */
-            if ((tmp->stats.rnti == si->rnti) &&
-                (tmp->stats.ueid == si->ueid)) {
-                te = tmp;
-                break;
-            }
-        }
+        /* Look among existing rows for this RNTI and UEId together */
+        te = (mac_lte_ep_t *)g_hash_table_lookup(hs->ep_table, MAC_LTE_EP_KEY(si->rnti, si->ueid));
 
         /* Not found among existing, so create a new one anyway */
         if (te == NULL) {
             if ((te = alloc_mac_lte_ep(si, pinfo))) {
                 /* Add new item to end of list */
-                mac_lte_ep_t *p = hs->ep_list;
-                while (p->next) {
-                    p = p->next;
-                }
-                p->next = te;
+                hs->ep_tail->next = te;
+                hs->ep_tail = te;
                 te->next = NULL;
+                g_hash_table_insert(hs->ep_table, MAC_LTE_EP_KEY(si->rnti, si->ueid), te);
 
                 /* Update counts of unique ueids & rntis */
                 update_ueid_rnti_counts(si->rnti, si->ueid, hs);
@@ -532,6 +534,7 @@ static void mac_lte_stat_init(const char *opt_arg, void *userdata _U_)
     /* Create struct */
     hs = g_new0(mac_lte_stat_t, 1);
     hs->ep_list = NULL;
+    hs->ep_table = g_hash_table_new(g_direct_hash, g_direct_equal);
 
     error_string = register_tap_listener("mac-lte", hs,
                                          filter, 0,
@@ -540,6 +543,7 @@ static void mac_lte_stat_init(const char *opt_arg, void *userdata _U_)
                                          mac_lte_stat_draw);
     if (error_string) {
         g_string_free(error_string, TRUE);
+        g_hash_table_destroy(hs->ep_table);
         g_free(hs);
         exit(1);
     }
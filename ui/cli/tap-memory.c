@@ -0,0 +1,105 @@
+/* tap-memory.c
+ * Report the memory used by the program and by each subsystem or pool
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <glib.h>
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+#include <epan/app_mem_usage.h>
+
+void register_tap_listener_memory(void);
+
+static void
+memory_draw(void *tapdata _U_)
+{
+	const char	*name;
+	gsize		 value;
+	guint		 i;
+
+	printf("\n");
+	printf("===================================================================\n");
+	printf("Memory Usage\n");
+	printf("%-32s %16s %12s\n", "Component", "Bytes", "MiB");
+	for (i = 0; (name = memory_usage_get(i, &value)) != NULL; i++) {
+		printf("%-32s %16" G_GSIZE_FORMAT " %12.1f\n", name, value,
+		       (double)value / (1024.0 * 1024.0));
+	}
+	printf("===================================================================\n");
+}
+
+static void
+memory_init(const char *opt_arg _U_, void *userdata _U_)
+{
+	GString	*error_string;
+
+	/* The figures are read once dissection is done, so this shows what's
+	 * still held at the end of the run */
+	error_string = register_tap_listener(
+		"frame",
+		NULL,
+		NULL,
+		TL_REQUIRES_NOTHING,
+		NULL,
+		NULL,
+		memory_draw);
+	if (error_string) {
+		/* error, we failed to attach to the tap. clean up */
+		fprintf(stderr, "tshark: Couldn't register memory tap: %s\n",
+				error_string->str);
+		g_string_free(error_string, TRUE);
+		exit(1);
+	}
+}
+
+static stat_tap_ui memory_ui = {
+	REGISTER_STAT_GROUP_GENERIC,
+	NULL,
+	"memory",
+	memory_init,
+	0,
+	NULL
+};
+
+void
+register_tap_listener_memory(void)
+{
+	register_stat_tap_ui(&memory_ui, NULL);
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
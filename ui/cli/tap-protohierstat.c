@@ -34,6 +34,8 @@
 
 void register_tap_listener_protohierstat(void);
 
+static int ethertype_proto_id = -1;
+
 typedef struct _phs_t {
 	struct _phs_t *sibling;
 	struct _phs_t *child;
@@ -64,30 +66,35 @@ new_phs_t(phs_t *parent)
 
 
 static int
-protohierstat_packet(void *prs, packet_info *pinfo, epan_dissect_t *edt, const void *dummy _U_)
+protohierstat_packet(void *prs, packet_info *pinfo, epan_dissect_t *edt _U_, const void *dummy _U_)
 {
 	phs_t *rs = (phs_t *)prs;
 	phs_t *tmprs;
-	proto_node *node;
-	field_info *fi;
+	wmem_list_frame_t *layer;
+	header_field_info *hfinfo;
+	int proto_id;
 
-	if (!edt) {
-		return 0;
-	}
-	if (!edt->tree) {
-		return 0;
-	}
-	if (!edt->tree->first_child) {
-		return 0;
+	if (ethertype_proto_id == -1) {
+		ethertype_proto_id = proto_get_id_by_filter_name("ethertype");
 	}
 
-	for (node=edt->tree->first_child; node; node=node->next) {
-		fi = PNODE_FINFO(node);
+	/*
+	 * The protocol layers are recorded whether or not a tree was
+	 * built, so we don't need one to know what the frame contained.
+	 */
+	for (layer=wmem_list_head(pinfo->layers); layer; layer=wmem_list_frame_next(layer)) {
+		proto_id = GPOINTER_TO_INT(wmem_list_frame_data(layer));
+
+		/* Ethertype only hands the payload on; it has no tree item. */
+		if (proto_id == ethertype_proto_id) {
+			continue;
+		}
+		hfinfo = proto_registrar_get_nth(proto_id);
 
 		/* first time we saw a protocol at this leaf */
 		if (rs->protocol == -1) {
-			rs->protocol = fi->hfinfo->id;
-			rs->proto_name = fi->hfinfo->abbrev;
+			rs->protocol = proto_id;
+			rs->proto_name = hfinfo->abbrev;
 			rs->frames = 1;
 			rs->bytes = pinfo->fd->pkt_len;
 			rs->child = new_phs_t(rs);
@@ -97,7 +104,7 @@ protohierstat_packet(void *prs, packet_info *pinfo, epan_dissect_t *edt, const v
 
 		/* find this protocol in the list of siblings */
 		for (tmprs=rs; tmprs; tmprs=tmprs->sibling) {
-			if (tmprs->protocol == fi->hfinfo->id) {
+			if (tmprs->protocol == proto_id) {
 				break;
 			}
 		}
@@ -108,8 +115,8 @@ protohierstat_packet(void *prs, packet_info *pinfo, epan_dissect_t *edt, const v
 				;
 			tmprs->sibling = new_phs_t(rs->parent);
 			rs = tmprs->sibling;
-			rs->protocol = fi->hfinfo->id;
-			rs->proto_name = fi->hfinfo->abbrev;
+			rs->protocol = proto_id;
+			rs->proto_name = hfinfo->abbrev;
 		} else {
 			rs = tmprs;
 		}
@@ -186,7 +193,7 @@ protohierstat_init(const char *opt_arg, void *userdata _U_)
 	rs = new_phs_t(NULL);
 	rs->filter = g_strdup(filter);
 
-	error_string = register_tap_listener("frame", rs, filter, TL_REQUIRES_PROTO_TREE, NULL, protohierstat_packet, protohierstat_draw);
+	error_string = register_tap_listener("frame", rs, filter, TL_REQUIRES_NOTHING, NULL, protohierstat_packet, protohierstat_draw);
 	if (error_string) {
 		/* error, we failed to attach to the tap. clean up */
 		g_free(rs->filter);
@@ -100,6 +100,11 @@ typedef struct rlc_lte_ep {
 /* Used to keep track of all RLC LTE statistics */
 typedef struct rlc_lte_stat_t {
     rlc_lte_ep_t  *ep_list;
+    rlc_lte_ep_t  *ep_tail;
+
+    /* ep_list entries by ueid */
+    GHashTable    *ep_table;
+
     guint32       total_frames;
 
     /* Common stats */
@@ -117,12 +122,14 @@ rlc_lte_stat_reset(void *phs)
 
     rlc_lte_stat->total_frames = 0;
     memset(&rlc_lte_stat->common_stats, 0, sizeof(rlc_lte_common_stats));
+    g_hash_table_remove_all(rlc_lte_stat->ep_table);
 
     if (!list) {
         return;
     }
 
     rlc_lte_stat->ep_list = NULL;
+    rlc_lte_stat->ep_tail = NULL;
 }
 
 
@@ -169,7 +176,7 @@ rlc_lte_stat_packet(void *phs, packet_info *pinfo, epan_dissect_t *edt _U_,
 {
     /* Get reference to stats struct */
     rlc_lte_stat_t *hs = (rlc_lte_stat_t *)phs;
-    rlc_lte_ep_t *tmp = NULL, *te = NULL;
+    rlc_lte_ep_t *te = NULL;
 
     /* Cast tap info struct */
     const struct rlc_lte_tap_info *si = (const struct rlc_lte_tap_info *)phi;
@@ -205,25 +212,20 @@ rlc_lte_stat_packet(void *phs, packet_info *pinfo, epan_dissect_t *edt _U_,
         hs->ep_list = alloc_rlc_lte_ep(si, pinfo);
         /* Make it the first/only entry */
         te = hs->ep_list;
+        hs->ep_tail = te;
+        g_hash_table_insert(hs->ep_table, GUINT_TO_POINTER(si->ueid), te);
     } else {
         /* Look among existing rows for this UEId */
-        for (tmp = hs->ep_list; (tmp != NULL); tmp = tmp->next) {
-            if (tmp->stats.ueid == si->ueid) {
-                te = tmp;
-                break;
-            }
-        }
+        te = (rlc_lte_ep_t *)g_hash_table_lookup(hs->ep_table, GUINT_TO_POINTER(si->ueid));
 
         /* Not found among existing, so create a new one anyway */
         if (te == NULL) {
             if ((te = alloc_rlc_lte_ep(si, pinfo))) {
                 /* Add new item to end of list */
-                rlc_lte_ep_t *p = hs->ep_list;
-                while (p->next) {
-                    p = p->next;
-                }
-                p->next = te;
+                hs->ep_tail->next = te;
+                hs->ep_tail = te;
                 te->next = NULL;
+                g_hash_table_insert(hs->ep_table, GUINT_TO_POINTER(si->ueid), te);
             }
         }
     }
@@ -380,6 +382,7 @@ static void rlc_lte_stat_init(const char *opt_arg, void *userdata _U_)
     /* Create top-level struct */
     hs = g_new0(rlc_lte_stat_t, 1);
     hs->ep_list = NULL;
+    hs->ep_table = g_hash_table_new(g_direct_hash, g_direct_equal);
 
 
     /**********************************************/
@@ -393,6 +396,7 @@ static void rlc_lte_stat_init(const char *opt_arg, void *userdata _U_)
                                          rlc_lte_stat_draw);
     if (error_string) {
         g_string_free(error_string, TRUE);
+        g_hash_table_destroy(hs->ep_table);
         g_free(hs);
         exit(1);
     }
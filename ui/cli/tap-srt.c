@@ -48,7 +48,7 @@ draw_srt_table_data(srt_stat_table *rst, gboolean draw_footer)
 
 	if (rst->num_procs > 0) {
 		printf("Filter: %s\n", rst->filter_string ? rst->filter_string : "");
-		printf("Index  %-22s Calls    Min SRT    Max SRT    Avg SRT    Sum SRT\n", (rst->proc_column_name != NULL) ? rst->proc_column_name : "Procedure");
+		printf("Index  %-22s Calls    Min SRT    Max SRT    Avg SRT    Sum SRT    p50 SRT    p99 SRT  p99.9 SRT\n", (rst->proc_column_name != NULL) ? rst->proc_column_name : "Procedure");
 	}
 	for(i=0;i<rst->num_procs;i++){
 		/* ignore procedures with no calls (they don't have rows) */
@@ -64,13 +64,16 @@ draw_srt_table_data(srt_stat_table *rst, gboolean draw_footer)
 		sum = (td + 500) / 1000;
 		td = ((td / rst->procedures[i].stats.num) + 500) / 1000;
 
-		printf("%5d  %-22s %6u %3d.%06d %3d.%06d %3d.%06d %3d.%06d\n",
+		printf("%5d  %-22s %6u %3d.%06d %3d.%06d %3d.%06d %3d.%06d %10.6f %10.6f %10.6f\n",
 		       i, rst->procedures[i].procedure,
 		       rst->procedures[i].stats.num,
 		       (int)rst->procedures[i].stats.min.secs, (rst->procedures[i].stats.min.nsecs+500)/1000,
 		       (int)rst->procedures[i].stats.max.secs, (rst->procedures[i].stats.max.nsecs+500)/1000,
 		       (int)(td/1000000), (int)(td%1000000),
-		       (int)(sum/1000000), (int)(sum%1000000)
+		       (int)(sum/1000000), (int)(sum%1000000),
+		       time_hist_percentile(&rst->procedures[i].hist, 50.0),
+		       time_hist_percentile(&rst->procedures[i].hist, 99.0),
+		       time_hist_percentile(&rst->procedures[i].hist, 99.9)
 		);
 	}
 
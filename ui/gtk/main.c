@@ -695,7 +695,7 @@ set_frame_reftime(gboolean set, frame_data *frame, gint row) {
         frame->flags.ref_time=0;
         cfile.ref_time_count--;
     }
-    cf_reftime_packets(&cfile);
+    cf_reftime_frame_changed(&cfile, frame);
     if (!frame->flags.ref_time && !frame->flags.passed_dfilter) {
         packet_list_freeze();
         cfile.displayed_count--;
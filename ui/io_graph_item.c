@@ -46,6 +46,95 @@ int get_io_graph_index(packet_info *pinfo, int interval) {
     return (int) ((time_delta.secs*1000 + time_delta.nsecs/1000000) / interval);
 }
 
+/* Fold src into dst, keeping dst's min/max unless src has a more extreme
+ * value. Both are for consecutive intervals, src after dst. */
+static void
+merge_io_graph_item(io_graph_item_t *dst, const io_graph_item_t *src, int item_unit)
+{
+    gboolean new_max, new_min;
+
+    if (src->frames == 0) {
+        return;
+    }
+
+    if (dst->first_frame_in_invl == 0) {
+        dst->first_frame_in_invl = src->first_frame_in_invl;
+    }
+    dst->last_frame_in_invl = src->last_frame_in_invl;
+
+    if (src->fields > 0) {
+        if (dst->fields == 0) {
+            dst->int_max = src->int_max;
+            dst->int_min = src->int_min;
+            dst->float_max = src->float_max;
+            dst->float_min = src->float_min;
+            dst->double_max = src->double_max;
+            dst->double_min = src->double_min;
+            dst->time_max = src->time_max;
+            dst->time_min = src->time_min;
+            dst->extreme_frame_in_invl = src->extreme_frame_in_invl;
+        } else {
+            /* Only one of the value kinds is in use for a given field, so
+             * whichever of them moved decides the extreme frame. */
+            new_max = (src->int_max > dst->int_max) ||
+                      (src->float_max > dst->float_max) ||
+                      (src->double_max > dst->double_max) ||
+                      (nstime_cmp(&src->time_max, &dst->time_max) > 0);
+            new_min = (src->int_min < dst->int_min) ||
+                      (src->float_min < dst->float_min) ||
+                      (src->double_min < dst->double_min) ||
+                      (nstime_cmp(&src->time_min, &dst->time_min) < 0);
+
+            if (src->int_max > dst->int_max) dst->int_max = src->int_max;
+            if (src->int_min < dst->int_min) dst->int_min = src->int_min;
+            if (src->float_max > dst->float_max) dst->float_max = src->float_max;
+            if (src->float_min < dst->float_min) dst->float_min = src->float_min;
+            if (src->double_max > dst->double_max) dst->double_max = src->double_max;
+            if (src->double_min < dst->double_min) dst->double_min = src->double_min;
+            if (nstime_cmp(&src->time_max, &dst->time_max) > 0) dst->time_max = src->time_max;
+            if (nstime_cmp(&src->time_min, &dst->time_min) < 0) dst->time_min = src->time_min;
+
+            if ((item_unit == IOG_ITEM_UNIT_CALC_MAX && new_max) ||
+                (item_unit == IOG_ITEM_UNIT_CALC_MIN && new_min)) {
+                dst->extreme_frame_in_invl = src->extreme_frame_in_invl;
+            }
+        }
+    }
+
+    dst->frames += src->frames;
+    dst->bytes += src->bytes;
+    dst->fields += src->fields;
+    dst->int_tot += src->int_tot;
+    dst->float_tot += src->float_tot;
+    dst->double_tot += src->double_tot;
+    nstime_add(&dst->time_tot, &src->time_tot);
+}
+
+gsize merge_io_graph_items(io_graph_item_t *items, gsize count, guint factor, int item_unit)
+{
+    gsize i, merged;
+
+    if (factor < 2 || count == 0) {
+        return count;
+    }
+
+    g_assert(item_unit != IOG_ITEM_UNIT_CALC_LOAD);
+
+    merged = (count + factor - 1) / factor;
+    for (i = 0; i < count; i++) {
+        if (i % factor == 0) {
+            if (i > 0) {
+                items[i / factor] = items[i];
+            }
+        } else {
+            merge_io_graph_item(&items[i / factor], &items[i], item_unit);
+        }
+    }
+    reset_io_graph_items(&items[merged], count - merged);
+
+    return merged;
+}
+
 GString *check_field_unit(const char *field_name, int *hf_index, io_graph_item_unit_t item_unit)
 {
     GString *err_str = NULL;
@@ -113,6 +113,24 @@ reset_io_graph_items(io_graph_item_t *items, gsize count) {
  */
 int get_io_graph_index(packet_info *pinfo, int interval);
 
+/** Merge io_graph_item_t intervals into coarser ones
+ *
+ * Combines each run of factor consecutive items into one, so that items
+ * collected with an interval of I can be reused for an interval of
+ * factor * I without retapping. The result is written to the front of
+ * the array and the items it frees up are reset.
+ *
+ * This can't be used for IOG_ITEM_UNIT_CALC_LOAD, which spreads each value
+ * over the intervals it spans and so depends on the interval itself.
+ *
+ * @param items [in,out] Array containing the items to merge.
+ * @param count [in] The number of items in use in the array.
+ * @param factor [in] The number of items to merge into one.
+ * @param item_unit [in] The type of unit that was calculated. From IOG_ITEM_UNITS.
+ * @return The number of items in use after merging.
+ */
+gsize merge_io_graph_items(io_graph_item_t *items, gsize count, guint factor, int item_unit);
+
 /** Check field and item unit compatibility
  *
  * @param field_name [in] Header field name to check
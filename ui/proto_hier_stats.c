@@ -38,6 +38,7 @@
 #define STAT_NODE_HFINFO(n)  (STAT_NODE_STATS(n)->hfinfo)
 
 static int pc_proto_id = -1;
+static int ethertype_proto_id = -1;
 
 static GNode*
 find_stat_node(GNode *parent_stat_node, header_field_info *needle_hfinfo)
@@ -158,6 +159,80 @@ process_tree(proto_tree *protocol_tree, ph_stats_t* ps)
 	process_node(ptree_node, ps->stats_tree, ps);
 }
 
+void
+ph_stats_add_layers(ph_stats_t *ps, frame_data *frame, wmem_list_t *layers)
+{
+	wmem_list_frame_t	*layer;
+	GNode			*stat_node;
+	ph_stats_node_t		*stats = NULL;
+	int			proto_id;
+
+	if (ethertype_proto_id == -1)
+		ethertype_proto_id = proto_get_id_by_filter_name("ethertype");
+
+	stat_node = ps->stats_tree;
+	for (layer = wmem_list_head(layers); layer; layer = wmem_list_frame_next(layer)) {
+		proto_id = GPOINTER_TO_INT(wmem_list_frame_data(layer));
+
+		/* Ethertype only hands the payload on and never adds a tree
+		 * item, so leave it out to match the tree-based hierarchy. */
+		if (proto_id == ethertype_proto_id)
+			continue;
+
+		stat_node = find_stat_node(stat_node, proto_registrar_get_nth(proto_id));
+		stats = STAT_NODE_STATS(stat_node);
+		stats->num_pkts_total++;
+		stats->num_bytes_total += frame->pkt_len;
+	}
+
+	if (stats) {
+		stats->num_pkts_last++;
+		stats->num_bytes_last += frame->pkt_len;
+	}
+
+	if (frame->flags.has_ts) {
+		double cur_time = nstime_to_sec(&frame->abs_ts);
+		if (ps->tot_packets == 0 || cur_time < ps->first_time)
+			ps->first_time = cur_time;
+		if (ps->tot_packets == 0 || cur_time > ps->last_time)
+			ps->last_time = cur_time;
+	}
+
+	ps->tot_packets++;
+	ps->tot_bytes += frame->pkt_len;
+}
+
+static gpointer
+stat_node_copy(gconstpointer src, gpointer data _U_)
+{
+	return g_memdup(src, sizeof(ph_stats_node_t));
+}
+
+static ph_stats_t*
+ph_stats_copy(const ph_stats_t *src)
+{
+	ph_stats_t	*ps;
+
+	ps = g_new(ph_stats_t, 1);
+	*ps = *src;
+	ps->stats_tree = g_node_copy_deep(src->stats_tree, stat_node_copy, NULL);
+	return ps;
+}
+
+ph_stats_t*
+ph_stats_new_empty(void)
+{
+	ph_stats_t	*ps;
+
+	ps = g_new(ph_stats_t, 1);
+	ps->tot_packets = 0;
+	ps->tot_bytes = 0;
+	ps->stats_tree = g_node_new(NULL);
+	ps->first_time = 0.0;
+	ps->last_time = 0.0;
+	return ps;
+}
+
 static gboolean
 process_record(capture_file *cf, frame_data *frame, column_info *cinfo, ph_stats_t* ps)
 {
@@ -217,15 +292,17 @@ ph_stats_new(capture_file *cf)
 
 	if (!cf) return NULL;
 
+	/* Every frame is displayed and all of them were counted on their
+	   first pass (nothing has been ignored since), so there's no need
+	   to go through them again. */
+	if (cf->ph_stats && cf->dfcode == NULL && cf->ignored_count == 0 &&
+	    cf->ph_stats->tot_packets == cf->count)
+		return ph_stats_copy(cf->ph_stats);
+
 	pc_proto_id = proto_registrar_get_id_byname("pkt_comment");
 
 	/* Initialize the data */
-	ps = g_new(ph_stats_t, 1);
-	ps->tot_packets = 0;
-	ps->tot_bytes = 0;
-	ps->stats_tree = g_node_new(NULL);
-	ps->first_time = 0.0;
-	ps->last_time = 0.0;
+	ps = ph_stats_new_empty();
 
 	/* Update the progress bar when it gets to this value. */
 	progbar_nextstep = 0;
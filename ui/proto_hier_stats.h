@@ -31,6 +31,8 @@ extern "C" {
  */
 
 #include <epan/proto.h>
+#include <epan/frame_data.h>
+#include <epan/wmem/wmem.h>
 
 typedef struct {
 	header_field_info	*hfinfo;
@@ -41,7 +43,7 @@ typedef struct {
 } ph_stats_node_t;
 
 
-typedef struct {
+typedef struct _ph_stats_t {
 	guint	tot_packets;
 	guint	tot_bytes;
 	GNode	*stats_tree;
@@ -50,8 +52,28 @@ typedef struct {
 } ph_stats_t;
 
 struct _capture_file;
+
+/** Compute protocol hierarchy statistics for the displayed frames.
+ *
+ * If no display filter is applied and the statistics gathered while the
+ * file was read are complete, those are copied instead of retapping the
+ * capture with a protocol tree.
+ */
 ph_stats_t *ph_stats_new(struct _capture_file *cf);
 
+/** Create empty protocol hierarchy statistics, to be filled in by
+ * ph_stats_add_layers() as frames are dissected.
+ */
+ph_stats_t *ph_stats_new_empty(void);
+
+/** Count a frame in the statistics from the protocol layers recorded
+ * while it was dissected (pinfo->layers).
+ *
+ * Byte counts use the frame length for every layer, as "tshark -z io,phs"
+ * does, rather than the length of each protocol's tree item.
+ */
+void ph_stats_add_layers(ph_stats_t *ps, frame_data *frame, wmem_list_t *layers);
+
 void ph_stats_free(ph_stats_t *ps);
 
 #ifdef __cplusplus
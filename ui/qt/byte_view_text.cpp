@@ -38,6 +38,7 @@
 #include <QMouseEvent>
 #include <QPainter>
 #include <QScrollBar>
+#include <QVarLengthArray>
 
 // To do:
 // - Add recent settings and context menu items to show/hide the offset,
@@ -73,7 +74,8 @@ ByteViewText::ByteViewText(QWidget *parent, tvbuff_t *tvb, proto_tree *tree, QTr
     one_em_(0),
     font_width_(0),
     line_spacing_(0),
-    margin_(0)
+    margin_(0),
+    field_index_built_(false)
 {
     QAction *action;
 
@@ -353,7 +355,12 @@ void ByteViewText::drawOffsetLine(QPainter &painter, const guint offset, const i
     }
     guint tvb_len = tvb_captured_length(tvb_);
     guint max_pos = qMin(offset + row_width_, tvb_len);
-    const guint8 *pd = tvb_get_ptr(tvb_, 0, -1);
+
+    // Copy just this row. Asking for a pointer to the whole buffer would
+    // flatten reassembled (composite) data in its entirety.
+    QVarLengthArray<guint8, 16> row_data(max_pos - offset);
+    tvb_memcpy(tvb_, row_data.data(), offset, max_pos - offset);
+    const guint8 *pd = row_data.constData() - offset;
 
     static const guchar hexchars[16] = {
         '0', '1', '2', '3', '4', '5', '6', '7',
@@ -605,7 +612,86 @@ field_info *ByteViewText::fieldAtPixel(QPoint &pos)
     if (byte < 0) {
         return NULL;
     }
-    return proto_find_field_from_offset(proto_tree_, byte, tvb_);
+
+    // proto_find_field_from_offset walks the entire tree, which adds up
+    // quickly while hovering over large packets.
+    if (!field_index_built_) {
+        buildFieldIndex();
+    }
+    QMap<guint, QPair<guint, field_info *> >::const_iterator it = field_index_.upperBound(byte);
+    if (it == field_index_.constBegin()) {
+        return NULL;
+    }
+    --it;
+    if ((guint) byte < it.value().first) {
+        return it.value().second;
+    }
+    return NULL;
+}
+
+typedef QMap<guint, QPair<guint, field_info *> > FieldIndex;
+
+struct field_index_data {
+    FieldIndex *index;
+    tvbuff_t *tvb;
+};
+
+// Lay each field over the ones before it, which leaves every byte with
+// the last matching field in pre-order, as proto_find_field_from_offset
+// would find it.
+static gboolean
+add_field_to_index(proto_node *node, gpointer data)
+{
+    field_info *fi = PNODE_FINFO(node);
+    struct field_index_data *fid = (struct field_index_data *) data;
+
+    if (!fi || PROTO_ITEM_IS_HIDDEN(node) || PROTO_ITEM_IS_GENERATED(node) || !fi->ds_tvb || fi->ds_tvb != fid->tvb
+            || fi->start < 0 || fi->length <= 0) {
+        return FALSE;
+    }
+
+    FieldIndex *index = fid->index;
+    guint start = (guint) fi->start;
+    guint end = start + (guint) fi->length;
+
+    FieldIndex::iterator it = index->lowerBound(start);
+    if (it != index->begin()) {
+        FieldIndex::iterator prev = it - 1;
+        if (prev.value().first > start) {
+            it = prev;
+        }
+    }
+    while (it != index->end() && it.key() < end) {
+        guint seg_start = it.key();
+        QPair<guint, field_info *> seg = it.value();
+
+        it = index->erase(it);
+        if (seg_start < start) {
+            index->insert(seg_start, qMakePair(start, seg.second));
+        }
+        if (seg.first > end) {
+            index->insert(end, seg);
+            break;
+        }
+    }
+    index->insert(start, qMakePair(end, fi));
+
+    return FALSE;
+}
+
+void ByteViewText::buildFieldIndex()
+{
+    struct field_index_data fid;
+
+    field_index_.clear();
+    field_index_built_ = true;
+    if (!proto_tree_ || !tvb_) {
+        return;
+    }
+
+    fid.index = &field_index_;
+    fid.tvb = tvb_;
+    proto_tree_traverse_pre_order(proto_tree_, add_field_to_index, &fid);
 }
 
 void ByteViewText::setHexDisplayFormat(QAction *action)
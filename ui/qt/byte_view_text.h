@@ -91,6 +91,7 @@ private:
     void updateScrollbars();
     int byteOffsetAtPixel(QPoint &pos);
     field_info *fieldAtPixel(QPoint &pos);
+    void buildFieldIndex();
 
     static const int separator_interval_;
     tvbuff_t *tvb_;
@@ -133,6 +134,12 @@ private:
     // Data selection
     QMap<int,int> x_pos_to_column_;
 
+    // Non-overlapping byte ranges of tvb_, keyed by start offset, each with
+    // its end offset and the field that proto_find_field_from_offset would
+    // return for it. Built the first time it's needed.
+    QMap<guint, QPair<guint, field_info *> > field_index_;
+    bool field_index_built_;
+
 private slots:
     void setHexDisplayFormat(QAction *action);
     void setCharacterEncoding(QAction *action);
@@ -779,15 +779,23 @@ void ConversationTreeWidget::updateItems() {
     }
     addTopLevelItems(new_items);
 
-    for (int i = 0; i < topLevelItemCount(); i++) {
-        ConversationTreeWidgetItem *ctwi = dynamic_cast<ConversationTreeWidgetItem *>(topLevelItem(i));
+    // Only conversations that saw packets since the last draw can move the
+    // start / stop bounds. Walk the tap's array rather than the tree items
+    // so that we don't pay for a dynamic_cast per conversation per draw.
+    for (guint i = 0; i < hash_.conv_array->len; i++) {
+        conv_item_t *conv_item = &g_array_index(hash_.conv_array, conv_item_t, i);
+
+        if (!conv_item->modified) {
+            continue;
+        }
+        conv_item->modified = FALSE;
 
-        double item_rel_start = nstime_to_sec(&(ctwi->convItem()->start_time));
+        double item_rel_start = nstime_to_sec(&(conv_item->start_time));
         if (item_rel_start < min_rel_start_time_) {
             min_rel_start_time_ = item_rel_start;
         }
 
-        double item_rel_stop = nstime_to_sec(&(ctwi->convItem()->stop_time));
+        double item_rel_stop = nstime_to_sec(&(conv_item->stop_time));
         if (item_rel_stop > max_rel_stop_time_) {
             max_rel_stop_time_ = item_rel_stop;
         }
@@ -24,6 +24,7 @@
 
 #include "epan/decode_as.h"
 #include "epan/epan_dissect.h"
+#include "epan/packet.h"
 
 #include "ui/decode_as_utils.h"
 #include "ui/simple_dialog.h"
@@ -152,8 +153,12 @@ void DecodeAsDialog::on_copyToolButton_clicked()
 
 void DecodeAsDialog::applyChanges()
 {
-    model_->applyChanges();
-    wsApp->queueAppSignal(WiresharkApplication::PacketDissectionChanged);
+    // Frames only need dissecting again if they looked up something that
+    // changed.
+    bool tables_only = model_->applyChanges();
+    if (!tables_only || dissector_table_lookups_changed()) {
+        wsApp->queueAppSignal(WiresharkApplication::PacketDissectionChanged);
+    }
 }
 
 void DecodeAsDialog::on_buttonBox_clicked(QAbstractButton *button)
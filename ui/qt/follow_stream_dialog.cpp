@@ -39,6 +39,7 @@
 #include <wsutil/utf8_entities.h>
 
 #include "wsutil/file_util.h"
+#include "wsutil/tempfile.h"
 #include "wsutil/str_util.h"
 #include "version_info.h"
 
@@ -393,8 +394,14 @@ void FollowStreamDialog::resetStream()
 
     filter_out_filter_.clear();
     text_pos_to_packet_.clear();
+    if (follow_info_.spill) {
+        ws_close(follow_info_.spill_fd);
+        follow_info_.spill = FALSE;
+        follow_info_.spill_size = 0;
+    }
     if (!data_out_filename_.isEmpty()) {
         ws_unlink(data_out_filename_.toUtf8().constData());
+        data_out_filename_.clear();
     }
     for (cur = follow_info_.payload; cur; cur = g_list_next(cur)) {
         follow_record = (follow_record_t *)cur->data;
@@ -426,6 +433,7 @@ void FollowStreamDialog::resetStream()
     }
 
     follow_info_.payload = NULL;
+    follow_info_.payload_last = NULL;
     follow_info_.client_port = 0;
 }
 
@@ -831,6 +839,17 @@ bool FollowStreamDialog::follow(QString previous_filter, bool use_stream_index,
 
     follow_reset_stream(&follow_info_);
 
+    /* Keep the payload in a temporary file rather than in memory, so
+       that large streams don't have to fit. */
+    char *spill_name = NULL;
+    int spill_fd = create_tempfile(&spill_name, "wireshark_follow", NULL);
+    if (spill_fd != -1) {
+        data_out_filename_ = spill_name;
+        follow_info_.spill = TRUE;
+        follow_info_.spill_fd = spill_fd;
+        follow_info_.spill_size = 0;
+    }
+
     /* Create a new filter that matches all packets in the TCP stream,
         and set the display filter entry accordingly */
     if (use_stream_index) {
@@ -898,9 +917,31 @@ bool FollowStreamDialog::follow(QString previous_filter, bool use_stream_index,
     beginRetapPackets();
     updateWidgets(true);
 
+    /* If the filter is the stream index filter, only the frames the
+       dissector has seen for that stream can match it. */
+    if (!tap_listeners_require_dissection_except(&follow_info_) &&
+            follow_filter == gchar_free_to_qstring(get_follow_index_func(follower_)(stream_num))) {
+        const guint32 *stream_frames = NULL;
+        guint32 stream_frame_count = 0;
+
+        switch (follow_type_)
+        {
+        case FOLLOW_TCP:
+        case FOLLOW_SSL:
+        case FOLLOW_HTTP:
+            stream_frames = get_tcp_stream_frames(stream_num, &stream_frame_count);
+            break;
+        case FOLLOW_UDP:
+            stream_frames = get_udp_stream_frames(stream_num, &stream_frame_count);
+            break;
+        }
+        cf_set_filter_frames(cap_file_.capFile(), stream_frames, stream_frame_count);
+    }
+
     /* Run the display filter so it goes in effect - even if it's the
        same as the previous display filter. */
     emit updateFilter(follow_filter, TRUE);
+    cf_set_filter_frames(cap_file_.capFile(), NULL, 0);
 
     removeTapListeners();
 
@@ -992,6 +1033,9 @@ FollowStreamDialog::readFollowStream()
     GList* cur;
     frs_return_t frs_return;
     follow_record_t *follow_record;
+    GByteArray *spill_buf = g_byte_array_new();
+    const guint8 *data;
+    guint32 data_len;
     QElapsedTimer elapsed_timer;
 
     elapsed_timer.start();
@@ -1015,18 +1059,24 @@ FollowStreamDialog::readFollowStream()
 
         QByteArray buffer;
         if (!skip) {
+            data = follow_record_get_data(&follow_info_, follow_record, spill_buf, &data_len);
+            if (data == NULL) {
+                g_byte_array_free(spill_buf, TRUE);
+                return FRS_READ_ERROR;
+            }
             // We want a deep copy.
             buffer.clear();
-            buffer.append((const char *) follow_record->data->data,
-                                     follow_record->data->len);
+            buffer.append((const char *) data, data_len);
             frs_return = showBuffer(
                         buffer.data(),
-                        follow_record->data->len,
+                        data_len,
                         follow_record->is_server,
                         follow_record->packet_num,
                         global_pos);
-            if(frs_return == FRS_PRINT_ERROR)
+            if(frs_return == FRS_PRINT_ERROR) {
+                g_byte_array_free(spill_buf, TRUE);
                 return frs_return;
+            }
             if (elapsed_timer.elapsed() > info_update_freq_) {
                 fillHintLabel(ui->teStreamContent->textCursor().position());
                 wsApp->processEvents();
@@ -1035,6 +1085,7 @@ FollowStreamDialog::readFollowStream()
         }
     }
 
+    g_byte_array_free(spill_buf, TRUE);
     return FRS_OK;
 }
 
@@ -405,6 +405,7 @@ IOGraphDialog::IOGraphDialog(QWidget &parent, CaptureFile &cf) :
     connect(iop, SIGNAL(mousePress(QMouseEvent*)), this, SLOT(graphClicked(QMouseEvent*)));
     connect(iop, SIGNAL(mouseMove(QMouseEvent*)), this, SLOT(mouseMoved(QMouseEvent*)));
     connect(iop, SIGNAL(mouseRelease(QMouseEvent*)), this, SLOT(mouseReleased(QMouseEvent*)));
+    connect(iop, SIGNAL(beforeReplot()), this, SLOT(plotBeforeReplot()));
     disconnect(ui->buttonBox, SIGNAL(accepted()), this, SLOT(accept()));
 }
 
@@ -1058,6 +1059,10 @@ void IOGraphDialog::resetAxes()
 
     double pixel_pad = 10.0; // per side
 
+    // Autoscale against all of the data, not just what's in view.
+    foreach (IOGraph *iog, ioGraphs_) {
+        iog->decimateGraphData(-QCPRange::maxRange, QCPRange::maxRange, iop->xAxis->axisRect()->width());
+    }
     iop->rescaleAxes(true);
 
     double axis_pixels = iop->xAxis->axisRect()->width();
@@ -1070,6 +1075,15 @@ void IOGraphDialog::resetAxes()
     iop->replot();
 }
 
+void IOGraphDialog::plotBeforeReplot()
+{
+    QCustomPlot *iop = ui->ioPlot;
+
+    foreach (IOGraph *iog, ioGraphs_) {
+        iog->decimateGraphData(iop->xAxis->range().lower, iop->xAxis->range().upper, iop->xAxis->axisRect()->width());
+    }
+}
+
 void IOGraphDialog::updateStatistics()
 {
     if (!isVisible()) return;
@@ -1158,14 +1172,19 @@ void IOGraphDialog::on_intervalComboBox_currentIndexChanged(int)
 {
     int interval = ui->intervalComboBox->itemData(ui->intervalComboBox->currentIndex()).toInt();
     bool need_retap = false;
+    bool need_recalc = false;
 
     if (uat_model_ != NULL) {
         for (int row = 0; row < uat_model_->rowCount(); row++) {
             IOGraph *iog = ioGraphs_[row];
             if (iog) {
-                iog->setInterval(interval);
+                bool rebucketed = iog->setInterval(interval);
                 if (iog->visible()) {
-                    need_retap = true;
+                    if (rebucketed) {
+                        need_recalc = true;
+                    } else {
+                        need_retap = true;
+                    }
                 }
             }
         }
@@ -1173,6 +1192,8 @@ void IOGraphDialog::on_intervalComboBox_currentIndexChanged(int)
 
     if (need_retap) {
         scheduleRetap(true);
+    } else if (need_recalc) {
+        scheduleRecalc(true);
     }
 
     updateLegend();
@@ -1496,7 +1517,11 @@ IOGraph::IOGraph(QCustomPlot *parent) :
     bars_(NULL),
     val_units_(IOG_ITEM_UNIT_FIRST),
     hf_index_(-1),
-    cur_idx_(-1)
+    interval_(0),
+    cur_idx_(-1),
+    decimated_lower_(0.0),
+    decimated_upper_(0.0),
+    decimated_columns_(0)
 {
     Q_ASSERT(parent_ != NULL);
     graph_ = parent_->addGraph(parent_->xAxis, parent_->yAxis);
@@ -1652,6 +1677,7 @@ void IOGraph::setPlotStyle(int style)
         break;
     }
     setValueUnits(val_units_);
+    decimated_columns_ = 0;
 
     if (graph_) {
         graph_->setLineStyle(QCPGraph::lsNone);
@@ -1755,11 +1781,10 @@ bool IOGraph::removeFromLegend()
 
 double IOGraph::startOffset()
 {
-    if (graph_ && graph_->keyAxis()->tickLabelType() == QCPAxis::ltDateTime && graph_->data()->size() > 0) {
-        return graph_->data()->keys()[0];
-    }
-    if (bars_ && bars_->keyAxis()->tickLabelType() == QCPAxis::ltDateTime && bars_->data()->size() > 0) {
-        return bars_->data()->keys()[0];
+    QCPAbstractPlottable *plottable = graph_ ? (QCPAbstractPlottable *) graph_ : (QCPAbstractPlottable *) bars_;
+
+    if (plottable && plottable->keyAxis()->tickLabelType() == QCPAxis::ltDateTime && !series_.isEmpty()) {
+        return series_.keys().first();
     }
     return 0.0;
 }
@@ -1783,6 +1808,8 @@ void IOGraph::clearAllData()
 {
     cur_idx_ = -1;
     reset_io_graph_items(items_, max_io_items_);
+    series_.clear();
+    decimated_columns_ = 0;
     if (graph_) {
         graph_->clearData();
     }
@@ -1799,6 +1826,7 @@ void IOGraph::recalcGraphData(capture_file *cap_file, bool enable_scaling)
     unsigned int mavg_to_remove = 0, mavg_to_add = 0;
     double mavg_cumulated = 0;
     QCPAxis *x_axis = NULL;
+    QVector<double> keys, values;
 
     if (graph_) {
         graph_->clearData();
@@ -1809,6 +1837,9 @@ void IOGraph::recalcGraphData(capture_file *cap_file, bool enable_scaling)
         x_axis = bars_->keyAxis();
     }
 
+    keys.reserve(cur_idx_ + 1);
+    values.reserve(cur_idx_ + 1);
+
     if (moving_avg_period_ > 0 && cur_idx_ >= 0) {
         /* "Warm-up phase" - calculate average on some data not displayed;
          * just to make sure average on leftmost and rightmost displayed
@@ -1864,26 +1895,24 @@ void IOGraph::recalcGraphData(capture_file *cap_file, bool enable_scaling)
             }
         }
 
-        if (graph_) {
-            graph_->addData(ts, val);
-        }
-        if (bars_) {
-            bars_->addData(ts, val);
-        }
+        keys.append(ts);
+        values.append(val);
 //        qDebug() << "=rgd i" << i << ts << val;
     }
 
     // attempt to rescale time values to specific units
     if (enable_scaling) {
-        calculateScaledValueUnit();
+        calculateScaledValueUnit(values);
     } else {
         scaled_value_unit_.clear();
     }
+    series_.setData(keys, values);
+    decimated_columns_ = 0;
 
     emit requestReplot();
 }
 
-void IOGraph::calculateScaledValueUnit()
+void IOGraph::calculateScaledValueUnit(QVector<double> &values)
 {
     // Reset unit and recalculate if needed.
     scaled_value_unit_.clear();
@@ -1907,12 +1936,7 @@ void IOGraph::calculateScaledValueUnit()
 
     if (proto_registrar_get_ftype(hf_index_) == FT_RELATIVE_TIME) {
         // find maximum absolute value and scale accordingly
-        double maxValue = 0;
-        if (graph_) {
-            maxValue = maxValueFromGraphData(*graph_->data());
-        } else if (bars_) {
-            maxValue = maxValueFromGraphData(*bars_->data());
-        }
+        double maxValue = maxValueFromGraphData(values);
         // If the maximum value is zero, then either we have no data or
         // everything is zero, do not scale the unit in this case.
         if (maxValue == 0) {
@@ -1932,38 +1956,56 @@ void IOGraph::calculateScaledValueUnit()
             value_multiplier = 1000000;
         }
 
-        if (graph_) {
-            scaleGraphData(*graph_->data(), value_multiplier);
-        } else if (bars_) {
-            scaleGraphData(*bars_->data(), value_multiplier);
-        }
+        scaleGraphData(values, value_multiplier);
     }
 }
 
-template<class DataMap>
-double IOGraph::maxValueFromGraphData(const DataMap &map)
+double IOGraph::maxValueFromGraphData(const QVector<double> &values)
 {
     double maxValue = 0;
-    typename DataMap::const_iterator it = map.constBegin();
-    while (it != map.constEnd()) {
-        maxValue = MAX(fabs((*it).value), maxValue);
-        ++it;
+    for (int i = 0; i < values.size(); i++) {
+        maxValue = MAX(fabs(values[i]), maxValue);
     }
     return maxValue;
 }
 
-template<class DataMap>
-void IOGraph::scaleGraphData(DataMap &map, int scalar)
+void IOGraph::scaleGraphData(QVector<double> &values, int scalar)
 {
     if (scalar != 1) {
-        typename DataMap::iterator it = map.begin();
-        while (it != map.end()) {
-            (*it).value *= scalar;
-            ++it;
+        for (int i = 0; i < values.size(); i++) {
+            values[i] *= scalar;
         }
     }
 }
 
+// Hand our plottable the points between lower and upper, decimated to
+// the lowest and highest value per column.
+void IOGraph::decimateGraphData(double lower, double upper, int columns)
+{
+    QVector<double> keys, values, spans;
+
+    // Stacked bars are matched up by key, so bars are only culled to the
+    // visible range.
+    if (bars_) {
+        columns = max_io_items_;
+    }
+    columns = qMax(columns, 1);
+    if (lower == decimated_lower_ && upper == decimated_upper_ && columns == decimated_columns_) {
+        return;
+    }
+
+    series_.decimate(lower, upper, columns, keys, values, spans);
+    if (graph_) {
+        graph_->setData(keys, values);
+    }
+    if (bars_) {
+        bars_->setData(keys, values);
+    }
+    decimated_lower_ = lower;
+    decimated_upper_ = upper;
+    decimated_columns_ = columns;
+}
+
 void IOGraph::captureFileClosing()
 {
     remove_tap_listener(this);
@@ -1976,9 +2018,24 @@ void IOGraph::reloadValueUnitField()
     }
 }
 
-void IOGraph::setInterval(int interval)
+// Returns true if the data we already have is still good for the new
+// interval, i.e. it can be rebucketed without retapping.
+bool IOGraph::setInterval(int interval)
 {
+    bool rebucketed = false;
+
+    if (interval_ > 0 && interval > interval_ && interval % interval_ == 0
+            && val_units_ != IOG_ITEM_UNIT_CALC_LOAD
+            && cur_idx_ >= 0 && cur_idx_ < max_io_items_ - 1) {
+        // cur_idx_ is pinned to the last item when packets fell off the
+        // end, in which case we have to retap to get them back.
+        gsize count = merge_io_graph_items(items_, cur_idx_ + 1, interval / interval_, val_units_);
+        cur_idx_ = (int) count - 1;
+        rebucketed = true;
+    }
+
     interval_ = interval;
+    return rebucketed;
 }
 
 // Get the value at the given interval (idx) for the current value unit.
@@ -34,6 +34,7 @@
 
 #include <ui/qt/models/uat_model.h>
 #include <ui/qt/models/uat_delegate.h>
+#include <ui/qt/utils/graph_series.h>
 
 #include <QIcon>
 #include <QMenu>
@@ -75,7 +76,7 @@ public:
     const QString valueUnitField() { return vu_field_; }
     void setValueUnitField(const QString &vu_field);
     unsigned int movingAveragePeriod() { return moving_avg_period_; }
-    void setInterval(int interval);
+    bool setInterval(int interval);
     bool addToLegend();
     bool removeFromLegend();
     QCPGraph *graph() { return graph_; }
@@ -87,6 +88,7 @@ public:
     QString scaledValueUnit() const { return scaled_value_unit_; }
 
     void clearAllData();
+    void decimateGraphData(double lower, double upper, int columns);
 
     unsigned int moving_avg_period_;
 
@@ -106,9 +108,9 @@ private:
     static gboolean tapPacket(void *iog_ptr, packet_info *pinfo, epan_dissect_t *edt, const void *data);
     static void tapDraw(void *iog_ptr);
 
-    void calculateScaledValueUnit();
-    template<class DataMap> double maxValueFromGraphData(const DataMap &map);
-    template<class DataMap> void scaleGraphData(DataMap &map, int scalar);
+    void calculateScaledValueUnit(QVector<double> &values);
+    double maxValueFromGraphData(const QVector<double> &values);
+    void scaleGraphData(QVector<double> &values, int scalar);
 
     QCustomPlot *parent_;
     QString config_err_;
@@ -129,6 +131,12 @@ private:
     // much as is feasible.
     io_graph_item_t items_[max_io_items_];
     int cur_idx_;
+
+    // What we plot. Only the visible part is handed to graph_ or bars_.
+    GraphSeries series_;
+    double decimated_lower_;
+    double decimated_upper_;
+    int decimated_columns_;
 };
 
 namespace Ui {
@@ -214,6 +222,7 @@ private slots:
     void graphClicked(QMouseEvent *event);
     void mouseMoved(QMouseEvent *event);
     void mouseReleased(QMouseEvent *event);
+    void plotBeforeReplot();
 
     void resetAxes();
     void updateStatistics(void);
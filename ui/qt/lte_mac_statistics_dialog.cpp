@@ -676,9 +676,16 @@ void LteMacStatisticsDialog::tapReset(void *ws_dlg_ptr)
     if (!ws_dlg) return;
 
     ws_dlg->statsTreeWidget()->clear();
+    ws_dlg->ue_items_.clear();
     ws_dlg->clearCommonStats();
 }
 
+// The fields MacUETreeWidgetItem::isMatch() compares.
+quint64 LteMacStatisticsDialog::ueKey(const mac_lte_tap_info *mlt_info)
+{
+    return ((quint64)mlt_info->rntiType << 32) | ((quint64)mlt_info->rnti << 16) | mlt_info->ueid;
+}
+
 //---------------------------------------------------------------------------------------
 // Process tap info from a new packet.
 gboolean LteMacStatisticsDialog::tapPacket(void *ws_dlg_ptr, struct _packet_info *, epan_dissect *, const void *mac_lte_tap_info_ptr)
@@ -699,21 +706,7 @@ gboolean LteMacStatisticsDialog::tapPacket(void *ws_dlg_ptr, struct _packet_info
     }
 
     // Look for an existing UE to match this tap info.
-    MacUETreeWidgetItem *mac_ue_ti = NULL;
-    for (int i = 0; i < ws_dlg->statsTreeWidget()->topLevelItemCount(); i++) {
-        QTreeWidgetItem *ti = ws_dlg->statsTreeWidget()->topLevelItem(i);
-        // Make sure we're looking at a UE entry
-        if (ti->type() != mac_whole_ue_row_type_) {
-            continue;
-        }
-
-        // See if current item matches tap.
-        MacUETreeWidgetItem *cur_muds_ti = static_cast<MacUETreeWidgetItem*>(ti);
-        if (cur_muds_ti->isMatch(mlt_info)) {
-            mac_ue_ti = cur_muds_ti;
-            break;
-        }
-    }
+    MacUETreeWidgetItem *mac_ue_ti = ws_dlg->ue_items_.value(ueKey(mlt_info), NULL);
 
     // If don't find matching UE, create a new one.
     if (!mac_ue_ti) {
@@ -721,6 +714,7 @@ gboolean LteMacStatisticsDialog::tapPacket(void *ws_dlg_ptr, struct _packet_info
         for (int col = 0; col < ws_dlg->statsTreeWidget()->columnCount(); col++) {
             mac_ue_ti->setTextAlignment(col, ws_dlg->statsTreeWidget()->headerItem()->textAlignment(col));
         }
+        ws_dlg->ue_items_.insert(ueKey(mlt_info), mac_ue_ti);
     }
 
     // Update the UE item with info from tap!
@@ -26,6 +26,7 @@
 
 #include <QLabel>
 #include <QCheckBox>
+#include <QHash>
 
 
 // Common channel stats
@@ -45,6 +46,8 @@ typedef struct mac_lte_common_stats {
 } mac_lte_common_stats;
 
 
+class MacUETreeWidgetItem;
+
 class LteMacStatisticsDialog : public TapParameterDialog
 {
     Q_OBJECT
@@ -61,6 +64,10 @@ private:
     QCheckBox *showSRFilterCheckBox_;
     QCheckBox *showRACHFilterCheckBox_;
 
+    // UE items by ueKey(), so that packets don't have to search the tree.
+    QHash<quint64, MacUETreeWidgetItem *> ue_items_;
+    static quint64 ueKey(const struct mac_lte_tap_info *mlt_info);
+
     // Callbacks for register_tap_listener
     static void tapReset(void *ws_dlg_ptr);
     static gboolean tapPacket(void *ws_dlg_ptr, struct _packet_info *, struct epan_dissect *, const void *mac_lte_tap_info_ptr);
@@ -749,6 +749,7 @@ void LteRlcStatisticsDialog::tapReset(void *ws_dlg_ptr)
 
     // Clears/deletes all UEs.
     ws_dlg->statsTreeWidget()->clear();
+    ws_dlg->ue_items_.clear();
     ws_dlg->packet_count_ = 0;
 }
 
@@ -764,18 +765,8 @@ gboolean LteRlcStatisticsDialog::tapPacket(void *ws_dlg_ptr, struct _packet_info
 
     ws_dlg->incFrameCount();
 
-    // Look for this UE (linear search...).
-    RlcUeTreeWidgetItem *ue_ti = NULL;
-    for (int i = 0; i < ws_dlg->statsTreeWidget()->topLevelItemCount(); i++) {
-        QTreeWidgetItem *ti = ws_dlg->statsTreeWidget()->topLevelItem(i);
-        if (ti->type() != rlc_ue_row_type_) continue;
-        RlcUeTreeWidgetItem *cur_ru_ti = static_cast<RlcUeTreeWidgetItem*>(ti);
-
-        if (cur_ru_ti->isMatch(rlt_info)) {
-            ue_ti = cur_ru_ti;
-            break;
-        }
-    }
+    // Look for this UE.
+    RlcUeTreeWidgetItem *ue_ti = ws_dlg->ue_items_.value(rlt_info->ueid, NULL);
 
     if (!ue_ti) {
         // Existing UE wasn't found so create a new one.
@@ -783,6 +774,7 @@ gboolean LteRlcStatisticsDialog::tapPacket(void *ws_dlg_ptr, struct _packet_info
         for (int col = 0; col < ws_dlg->statsTreeWidget()->columnCount(); col++) {
             ue_ti->setTextAlignment(col, ws_dlg->statsTreeWidget()->headerItem()->textAlignment(col));
         }
+        ws_dlg->ue_items_.insert(rlt_info->ueid, ue_ti);
     }
 
     // Update the UE from the information in the tap structure.
@@ -25,6 +25,9 @@
 #include "tap_parameter_dialog.h"
 
 #include <QCheckBox>
+#include <QHash>
+
+class RlcUeTreeWidgetItem;
 
 class LteRlcStatisticsDialog : public TapParameterDialog
 {
@@ -56,6 +59,9 @@ private:
     CaptureFile &cf_;
     int packet_count_;
 
+    // UE items by ueid, so that PDUs don't have to search the tree.
+    QHash<guint16, RlcUeTreeWidgetItem *> ue_items_;
+
     // Callbacks for register_tap_listener
     static void tapReset(void *ws_dlg_ptr);
     static gboolean tapPacket(void *ws_dlg_ptr, struct _packet_info *, struct epan_dissect *, const void *rlc_lte_tap_info_ptr);
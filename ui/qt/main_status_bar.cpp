@@ -107,7 +107,8 @@ MainStatusBar::MainStatusBar(QWidget *parent) :
     ready_msg_(tr("Ready to load file")),
     #endif
     cs_fixed_(false),
-    cs_count_(0)
+    cs_count_(0),
+    cs_pending_(0)
 {
     QSplitter *splitter = new QSplitter(this);
     QWidget *info_progress = new QWidget(this);
@@ -463,6 +464,12 @@ void MainStatusBar::showCaptureStatistics()
                               .arg(cap_file_->ignored_count)
                               .arg((100.0*cap_file_->ignored_count)/cap_file_->count, 0, 'f', 1));
         }
+        if(cs_pending_ > 0) {
+            // We're dissecting more slowly than we're capturing.
+            packets_str.append(QString(tr(" %1 Behind: %2"))
+                              .arg(UTF8_MIDDLE_DOT)
+                              .arg(cs_pending_));
+        }
         if(prefs.gui_qt_show_file_load_time && !cap_file_->is_tempfile) {
             /* Loading an existing file */
             gulong computed_elapsed = cf_get_computed_elapsed(cap_file_);
@@ -494,6 +501,7 @@ void MainStatusBar::updateCaptureStatistics(capture_session *cap_session)
     } else {
         cs_count_ = 0;
     }
+    cs_pending_ = cap_session ? cap_session->count_pending : 0;
 #endif // HAVE_LIBPCAP
 
     showCaptureStatistics();
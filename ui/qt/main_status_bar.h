@@ -69,6 +69,7 @@ private:
     // Capture statistics
     bool cs_fixed_;
     guint32 cs_count_;
+    guint32 cs_pending_;
 
     void showCaptureStatistics();
 
@@ -511,6 +511,8 @@ MainWindow::MainWindow(QWidget *parent) :
             this, SLOT(captureCaptureFailed(capture_session *)));
     connect(&capture_file_, SIGNAL(captureCaptureUpdateContinue(capture_session*)),
             main_ui_->statusBar, SLOT(updateCaptureStatistics(capture_session*)));
+    connect(&capture_file_, SIGNAL(captureCaptureUpdateContinue(capture_session*)),
+            this, SLOT(captureCaptureUpdateContinue(capture_session*)));
 
     connect(&capture_file_, SIGNAL(captureCaptureUpdateStarted(capture_session *)),
             wsApp, SLOT(captureStarted()));
@@ -1038,23 +1040,35 @@ void MainWindow::dropEvent(QDropEvent *event)
         return;
     }
 
+    QString before_what(tr(" before opening another file"));
+    if (!testCaptureFileClose(before_what)) {
+        return;
+    }
+
     char **in_filenames = (char **)g_malloc(sizeof(char*) * local_files.size());
-    char *tmpname = NULL;
+    int err;
 
     for (int i = 0; i < local_files.size(); i++) {
         in_filenames[i] = (char *) local_files.at(i).constData();
     }
 
-    /* merge the files in chronological order */
-    if (cf_merge_files_to_tempfile(this, &tmpname, local_files.size(),
-                                   in_filenames, WTAP_FILE_TYPE_SUBTYPE_PCAPNG,
-                                   FALSE) == CF_OK) {
-        /* Merge succeeded; close the currently-open file and try
-           to open the merged capture file. */
-        openCaptureFile(tmpname, QString(), WTAP_TYPE_AUTO, TRUE);
+    /* open the files as one, merged in chronological order, reading the
+       packets from the files themselves rather than merging them to a
+       temporary file first */
+    CaptureFile::globalCapFile()->window = this;
+    if (cf_open_files(CaptureFile::globalCapFile(), local_files.size(),
+                      in_filenames, FALSE, &err) == CF_OK) {
+        if (cf_read(CaptureFile::globalCapFile(), FALSE) == CF_READ_ABORTED) {
+            /* The user bailed out of reading the files; they have been
+               closed. */
+            capture_file_.setCapFile(NULL);
+        } else {
+            main_ui_->statusBar->showExpert();
+        }
+    } else {
+        CaptureFile::globalCapFile()->window = NULL;
     }
 
-    g_free(tmpname);
     g_free(in_filenames);
 
 }
@@ -284,6 +284,8 @@ public slots:
 
     void captureCapturePrepared(capture_session *);
     void captureCaptureUpdateStarted(capture_session *);
+    void captureCaptureUpdateContinue(capture_session *session);
+    void continueCaptureTail();
     void captureCaptureUpdateFinished(capture_session *);
     void captureCaptureFixedStarted(capture_session *);
     void captureCaptureFixedFinished(capture_session *cap_session);
@@ -45,6 +45,7 @@ DIAG_ON(frame-larger-than=)
 
 #ifdef HAVE_LIBPCAP
 #include "ui/capture.h"
+#include <capchild/capture_sync.h>
 #endif
 
 #include "ui/commandline.h"
@@ -174,6 +175,7 @@ DIAG_ON(frame-larger-than=)
 #include <QMetaObject>
 #include <QToolBar>
 #include <QDesktopServices>
+#include <QTimer>
 #include <QUrl>
 
 // XXX You must uncomment QT_WINEXTRAS_LIB lines in CMakeList.txt and
@@ -686,6 +688,25 @@ void MainWindow::captureCaptureUpdateStarted(capture_session *session) {
     Q_UNUSED(session)
 #endif // HAVE_LIBPCAP
 }
+void MainWindow::captureCaptureUpdateContinue(capture_session *session) {
+#ifdef HAVE_LIBPCAP
+    // If cf_continue_tail() ran out of time, handle any pending UI events
+    // and then carry on reading, instead of waiting for the child to tell
+    // us about more packets.
+    if (session->count_pending > 0) {
+        QTimer::singleShot(0, this, SLOT(continueCaptureTail()));
+    }
+#else
+    Q_UNUSED(session)
+#endif // HAVE_LIBPCAP
+}
+void MainWindow::continueCaptureTail() {
+#ifdef HAVE_LIBPCAP
+    if (cap_session_.state == CAPTURE_RUNNING && cap_session_.count_pending > 0) {
+        capture_input_new_packets(&cap_session_, 0);
+    }
+#endif // HAVE_LIBPCAP
+}
 void MainWindow::captureCaptureUpdateFinished(capture_session *) {
 #ifdef HAVE_LIBPCAP
 
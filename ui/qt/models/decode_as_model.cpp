@@ -554,12 +554,13 @@ void DecodeAsModel::gatherChangedEntries(const gchar *table_name,
     }
 }
 
-void DecodeAsModel::applyChanges()
+bool DecodeAsModel::applyChanges()
 {
     dissector_table_t sub_dissectors;
     module_t *module;
     pref_t* pref_value;
     dissector_handle_t handle;
+    bool tables_only = true;
     // Reset all dissector tables, then apply all rules from model.
 
     // We can't call g_hash_table_removed from g_hash_table_foreach, which
@@ -630,6 +631,9 @@ void DecodeAsModel::applyChanges()
                 }
 
                 if ((item->current_proto_ == DECODE_AS_NONE) || !item->dissector_handle_) {
+                    if (decode_as_entry->reset_value != decode_as_default_reset) {
+                        tables_only = false;
+                    }
                     decode_as_entry->reset_value(decode_as_entry->table_name, selector_value);
                     sub_dissectors = find_dissector_table(decode_as_entry->table_name);
 
@@ -646,6 +650,9 @@ void DecodeAsModel::applyChanges()
                     }
                     break;
                 } else {
+                    if (decode_as_entry->change_value != decode_as_default_change) {
+                        tables_only = false;
+                    }
                     decode_as_entry->change_value(decode_as_entry->table_name, selector_value, &item->dissector_handle_, (char *) item->current_proto_.toUtf8().constData());
                     sub_dissectors = find_dissector_table(decode_as_entry->table_name);
 
@@ -663,6 +670,8 @@ void DecodeAsModel::applyChanges()
             }
         }
     }
+
+    return tables_only;
 }
 
 /* * Editor modelines
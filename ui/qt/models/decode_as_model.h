@@ -86,7 +86,9 @@ public:
 
     static QString entryString(const gchar *table_name, gpointer value);
 
-    void applyChanges();
+    // Returns false if a protocol's own Decode As functions made some of
+    // the changes, which dissector_table_lookups_changed() can't see.
+    bool applyChanges();
 
 protected:
     static void buildChangedList(const gchar *table_name, ftenum_t selector_type,
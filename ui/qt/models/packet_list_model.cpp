@@ -58,7 +58,10 @@ PacketListModel::PacketListModel(QObject *parent, capture_file *cf) :
     number_to_row_(QVector<int>()),
     max_row_height_(0),
     max_line_count_(1),
-    idle_dissection_row_(0)
+    idle_dissection_row_(0),
+    viewport_first_(-1),
+    viewport_last_(-1),
+    scroll_direction_(0)
 {
     setCaptureFile(cf);
     PacketListRecord::clearStringPool();
@@ -147,6 +150,8 @@ void PacketListModel::clear() {
     max_row_height_ = 0;
     max_line_count_ = 1;
     idle_dissection_row_ = 0;
+    viewport_first_ = viewport_last_ = -1;
+    scroll_direction_ = 0;
 }
 
 void PacketListModel::resetColumns()
@@ -241,7 +246,7 @@ void PacketListModel::toggleFrameRefTime(const QModelIndex &rt_index)
         fdata->flags.ref_time=1;
         cap_file_->ref_time_count++;
     }
-    cf_reftime_packets(cap_file_);
+    cf_reftime_frame_changed(cap_file_, fdata);
     if (!fdata->flags.ref_time && !fdata->flags.passed_dfilter) {
         cap_file_->displayed_count--;
     }
@@ -316,11 +321,27 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
     gboolean stop_flag = FALSE;
     QString col_title = get_column_title(column);
 
+    // Build the sort keys once, so that comparisons don't have to look up
+    // column strings or parse numbers. The keys keep their own copy of the
+    // text, as the records may drop theirs.
+    sort_column_is_numeric_ = isNumericColumn(sort_column_);
+    QVector<SortKey> keys(physical_rows_.count());
+
     busy_timer_.start();
     emit pushProgressStatus(tr("Dissecting"), true, true, &stop_flag);
     int row_num = 0;
     foreach (PacketListRecord *row, physical_rows_) {
-        row->columnString(sort_cap_file_, column);
+        SortKey &key = keys[row_num];
+
+        key.record = row;
+        key.num = 0.0;
+        key.num_ok = false;
+        if (text_sort_column_ >= 0) {
+            key.text = row->columnString(sort_cap_file_, column);
+            if (sort_column_is_numeric_) {
+                key.num = parseNumericColumn(key.text, &key.num_ok);
+            }
+        }
         row_num++;
         if (busy_timer_.elapsed() > busy_timeout_) {
             if (stop_flag) {
@@ -336,16 +357,16 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
     }
     emit popProgressStatus();
 
-    // XXX Use updateProgress instead. We'd have to switch from std::sort to
-    // something we can interrupt.
-    if (!col_title.isEmpty()) {
-        QString busy_msg = tr("Sorting \"%1\"").arg(col_title);
-        emit pushBusyStatus(busy_msg);
-    }
-
+    QString busy_msg = tr("Sorting \"%1\"").arg(col_title);
+    emit pushProgressStatus(busy_msg, true, true, &stop_flag);
     busy_timer_.restart();
-    sort_column_is_numeric_ = isNumericColumn(sort_column_);
-    std::sort(physical_rows_.begin(), physical_rows_.end(), recordLessThan);
+    bool sorted = sortKeys(keys, &stop_flag);
+    emit popProgressStatus();
+    if (!sorted) return;
+
+    for (int i = 0; i < keys.count(); i++) {
+        physical_rows_[i] = keys[i].record;
+    }
 
     beginResetModel();
     visible_rows_.resize(0);
@@ -363,10 +384,6 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
     }
     endResetModel();
 
-    if (!col_title.isEmpty()) {
-        emit popBusyStatus();
-    }
-
     if (cap_file_->current_frame) {
         emit goToPacket(cap_file_->current_frame->num);
     }
@@ -414,57 +431,43 @@ bool PacketListModel::isNumericColumn(int column)
     return true;
 }
 
-bool PacketListModel::recordLessThan(PacketListRecord *r1, PacketListRecord *r2)
+bool PacketListModel::sortKeyLessThan(const SortKey &k1, const SortKey &k2)
 {
     int cmp_val = 0;
+    frame_data *fd1 = k1.record->frameData();
+    frame_data *fd2 = k2.record->frameData();
 
     // Wherein we try to cram the logic of packet_list_compare_records,
     // _packet_list_compare_records, and packet_list_compare_custom from
     // gtk/packet_list_store.c into one function
 
-    if (busy_timer_.elapsed() > busy_timeout_) {
-        // What's the least amount of processing that we can do which will draw
-        // the busy indicator?
-        wsApp->processEvents(QEventLoop::ExcludeUserInputEvents | QEventLoop::ExcludeSocketNotifiers, 1);
-        busy_timer_.restart();
-    }
     if (sort_column_ < 0) {
         // No column.
-        cmp_val = frame_data_compare(sort_cap_file_->epan, r1->frameData(), r2->frameData(), COL_NUMBER);
+        cmp_val = frame_data_compare(sort_cap_file_->epan, fd1, fd2, COL_NUMBER);
     } else if (text_sort_column_ < 0) {
         // Column comes directly from frame data
-        cmp_val = frame_data_compare(sort_cap_file_->epan, r1->frameData(), r2->frameData(), sort_cap_file_->cinfo.columns[sort_column_].col_fmt);
+        cmp_val = frame_data_compare(sort_cap_file_->epan, fd1, fd2, sort_cap_file_->cinfo.columns[sort_column_].col_fmt);
     } else  {
-        if (r1->columnString(sort_cap_file_, sort_column_).constData() == r2->columnString(sort_cap_file_, sort_column_).constData()) {
+        if (k1.text.constData() == k2.text.constData()) {
             cmp_val = 0;
-        } else if (sort_cap_file_->cinfo.columns[sort_column_].col_fmt == COL_CUSTOM) {
-            // Column comes from custom data
-            if (sort_column_is_numeric_) {
-                // Attempt to convert to numbers.
-                // XXX This is slow. Can we avoid doing this?
-                bool ok_r1, ok_r2;
-                double num_r1 = parseNumericColumn(r1->columnString(sort_cap_file_, sort_column_), &ok_r1);
-                double num_r2 = parseNumericColumn(r2->columnString(sort_cap_file_, sort_column_), &ok_r2);
-
-                if (!ok_r1 && !ok_r2) {
-                    cmp_val = 0;
-                } else if (!ok_r1 || (ok_r2 && num_r1 < num_r2)) {
-                    // either r1 is invalid (and sort it before others) or both
-                    // r1 and r2 are valid (sort normally)
-                    cmp_val = -1;
-                } else if (!ok_r2 || (ok_r1 && num_r1 > num_r2)) {
-                    cmp_val = 1;
-                }
-            } else {
-                cmp_val = strcmp(r1->columnString(sort_cap_file_, sort_column_).constData(), r2->columnString(sort_cap_file_, sort_column_).constData());
+        } else if (sort_cap_file_->cinfo.columns[sort_column_].col_fmt == COL_CUSTOM && sort_column_is_numeric_) {
+            // Column comes from custom data, parsed when the keys were built.
+            if (!k1.num_ok && !k2.num_ok) {
+                cmp_val = 0;
+            } else if (!k1.num_ok || (k2.num_ok && k1.num < k2.num)) {
+                // either k1 is invalid (and sort it before others) or both
+                // k1 and k2 are valid (sort normally)
+                cmp_val = -1;
+            } else if (!k2.num_ok || (k1.num_ok && k1.num > k2.num)) {
+                cmp_val = 1;
             }
         } else {
-            cmp_val = strcmp(r1->columnString(sort_cap_file_, sort_column_).constData(), r2->columnString(sort_cap_file_, sort_column_).constData());
+            cmp_val = strcmp(k1.text.constData(), k2.text.constData());
         }
 
         if (cmp_val == 0) {
             // All else being equal, compare column numbers.
-            cmp_val = frame_data_compare(sort_cap_file_->epan, r1->frameData(), r2->frameData(), COL_NUMBER);
+            cmp_val = frame_data_compare(sort_cap_file_->epan, fd1, fd2, COL_NUMBER);
         }
     }
 
@@ -475,13 +478,71 @@ bool PacketListModel::recordLessThan(PacketListRecord *r1, PacketListRecord *r2)
     }
 }
 
+// Bottom-up merge sort, so that we can report progress and stop between
+// merges, which std::sort doesn't let us do. Runs of sort_run_len_ keys are
+// sorted with std::sort first. Returns false if the user stopped the sort,
+// in which case keys is left in some unspecified order.
+const int sort_run_len_ = 1024;
+bool PacketListModel::sortKeys(QVector<SortKey> &keys, gboolean *stop_flag)
+{
+    int count = keys.count();
+    QVector<SortKey> merged(count);
+    QVector<SortKey> *src = &keys;
+    QVector<SortKey> *dst = &merged;
+    qint64 work_total = count;
+    qint64 work_done = 0;
+
+    for (int width = sort_run_len_; width < count; width *= 2) {
+        work_total += count;
+    }
+
+    for (int start = 0; start < count; start += sort_run_len_) {
+        int end = qMin(start + sort_run_len_, count);
+        std::sort(keys.begin() + start, keys.begin() + end, sortKeyLessThan);
+        work_done += end - start;
+        if (!sortProgress(work_done, work_total, stop_flag)) return false;
+    }
+
+    for (int width = sort_run_len_; width < count; width *= 2) {
+        for (int start = 0; start < count; start += 2 * width) {
+            int mid = qMin(start + width, count);
+            int end = qMin(start + 2 * width, count);
+            std::merge(src->constBegin() + start, src->constBegin() + mid,
+                       src->constBegin() + mid, src->constBegin() + end,
+                       dst->begin() + start, sortKeyLessThan);
+            work_done += end - start;
+            if (!sortProgress(work_done, work_total, stop_flag)) return false;
+        }
+        qSwap(src, dst);
+    }
+
+    if (src != &keys) {
+        keys = *src;
+    }
+    return true;
+}
+
+bool PacketListModel::sortProgress(qint64 work_done, qint64 work_total, gboolean *stop_flag)
+{
+    if (busy_timer_.elapsed() > busy_timeout_) {
+        if (*stop_flag) {
+            return false;
+        }
+        emit updateProgressStatus((int) (work_done * 100 / work_total));
+        // What's the least amount of processing that we can do which will draw
+        // the progress indicator?
+        wsApp->processEvents(QEventLoop::AllEvents, 1);
+        busy_timer_.restart();
+    }
+    return true;
+}
+
 // Parses a field as a double. Handle values with suffixes ("12ms"), negative
 // values ("-1.23") and fields with multiple occurrences ("1,2"). Marks values
 // that do not contain any numeric value ("Unknown") as invalid.
-double PacketListModel::parseNumericColumn(const QString &val, bool *ok)
+double PacketListModel::parseNumericColumn(const QByteArray &val, bool *ok)
 {
-    QByteArray ba = val.toUtf8();
-    const char *strval = ba.constData();
+    const char *strval = val.constData();
     gchar *end = NULL;
     double num = g_ascii_strtod(strval, &end);
     *ok = strval != end;
@@ -659,6 +720,8 @@ void PacketListModel::dissectIdle(bool reset)
 
     idle_dissection_timer_->restart();
 
+    colorizeViewport();
+
     int first = idle_dissection_row_;
     while (idle_dissection_timer_->elapsed() < idle_dissection_interval_
            && idle_dissection_row_ < physical_rows_.count()) {
@@ -726,6 +789,49 @@ void PacketListModel::ensureRowColorized(int row)
     }
 }
 
+// Tell the idle dissection which rows are on screen, so that it can do
+// those first.
+void PacketListModel::setViewportRows(int first, int last)
+{
+    if (viewport_first_ >= 0 && first != viewport_first_) {
+        scroll_direction_ = first > viewport_first_ ? 1 : -1;
+    }
+    viewport_first_ = first;
+    viewport_last_ = last;
+}
+
+// Colorize the rows on screen and the page we're scrolling towards, so
+// that jumping into a large file doesn't show uncolored rows until the
+// idle dissection gets there in row order.
+void PacketListModel::colorizeViewport()
+{
+    if (viewport_first_ < 0 || viewport_last_ < viewport_first_) return;
+
+    int page = viewport_last_ - viewport_first_ + 1;
+    int first = viewport_first_;
+    int last = viewport_last_;
+    if (scroll_direction_ > 0) {
+        last += page;
+    } else if (scroll_direction_ < 0) {
+        first -= page;
+    }
+    first = qMax(first, 0);
+    last = qMin(last, visible_rows_.count() - 1);
+
+    int changed_first = -1, changed_last = -1;
+    for (int row = first; row <= last && idle_dissection_timer_->elapsed() < idle_dissection_interval_; row++) {
+        if (visible_rows_[row]->colorized()) continue;
+
+        ensureRowColorized(row);
+        if (changed_first < 0) changed_first = row;
+        changed_last = row;
+    }
+
+    if (changed_first >= 0) {
+        emit dataChanged(index(changed_first, 0), index(changed_last, columnCount() - 1));
+    }
+}
+
 int PacketListModel::visibleIndexOf(frame_data *fdata) const
 {
     int row = 0;
@@ -63,6 +63,7 @@ public:
     gint appendPacket(frame_data *fdata);
     frame_data *getRowFdata(int row);
     void ensureRowColorized(int row);
+    void setViewportRows(int first, int last);
     int visibleIndexOf(frame_data *fdata) const;
     void resetColumns();
     void resetColorized();
@@ -110,11 +111,25 @@ private:
     static int text_sort_column_;
     static Qt::SortOrder sort_order_;
     static capture_file *sort_cap_file_;
-    static bool recordLessThan(PacketListRecord *r1, PacketListRecord *r2);
-    static double parseNumericColumn(const QString &val, bool *ok);
+    // Precomputed sort key for a record.
+    struct SortKey {
+        PacketListRecord *record;
+        QByteArray text;
+        double num;
+        bool num_ok;
+    };
+    static bool sortKeyLessThan(const SortKey &k1, const SortKey &k2);
+    static double parseNumericColumn(const QByteArray &val, bool *ok);
+    bool sortKeys(QVector<SortKey> &keys, gboolean *stop_flag);
+    bool sortProgress(qint64 work_done, qint64 work_total, gboolean *stop_flag);
 
     QElapsedTimer *idle_dissection_timer_;
     int idle_dissection_row_;
+    int viewport_first_;
+    int viewport_last_;
+    int scroll_direction_;
+
+    void colorizeViewport();
 
     bool isNumericColumn(int column);
 
@@ -55,7 +55,8 @@ PacketListRecord::PacketListRecord(frame_data *frameData) :
     line_count_changed_(false),
     data_ver_(0),
     colorized_(false),
-    conv_(NULL)
+    conv_(NULL),
+    string_gen_(0)
 {
 }
 
@@ -65,7 +66,7 @@ void *PacketListRecord::operator new(size_t size)
 }
 
 // We might want to return a const char * instead. This would keep us from
-// creating excessive QByteArrays, e.g. in PacketListModel::recordLessThan.
+// creating excessive QByteArrays, e.g. in PacketListModel::sort.
 const QByteArray PacketListRecord::columnString(capture_file *cap_file, int column, bool colorized)
 {
     // packet_list_store.c:packet_list_get_value
@@ -78,6 +79,8 @@ const QByteArray PacketListRecord::columnString(capture_file *cap_file, int colu
     bool dissect_color = colorized && !colorized_;
     if (!col_text_ || column >= col_text_->size() || !col_text_->at(column) || data_ver_ != col_data_ver_ || dissect_color) {
         dissect(cap_file, dissect_color);
+    } else {
+        keepColumnStrings();
     }
 
     return col_text_->value(column, QByteArray());
@@ -208,10 +211,79 @@ void PacketListRecord::dissect(capture_file *cap_file, bool dissect_color)
 
 // This assumes only one packet list. We might want to move this to
 // PacketListModel (or replace this with a wmem allocator).
-struct _GStringChunk *PacketListRecord::string_pool_ = g_string_chunk_new(1 * 1024 * 1024);
+//
+// Column strings are kept in two generations of string pools, so that
+// memory doesn't keep growing as the user scrolls through a large file.
+// Rows are added to the current generation as they're dissected. Once it
+// holds max_pool_rows_ rows, the older generation is thrown away along
+// with the column text of its rows, which are dissected again if they're
+// shown, and the current generation becomes the older one. Rows of the
+// older generation that are used again are copied to the current one, so
+// that the rows around the viewport stay cached.
+const int max_pool_rows_ = 128 * 1024;
+struct _GStringChunk *PacketListRecord::string_pool_[2] = {
+    g_string_chunk_new(1 * 1024 * 1024),
+    g_string_chunk_new(1 * 1024 * 1024)
+};
+QVector<PacketListRecord *> PacketListRecord::pool_rows_[2];
+unsigned PacketListRecord::string_pool_gen_ = 2; // New records have 0.
+
 void PacketListRecord::clearStringPool()
 {
-    g_string_chunk_clear(string_pool_);
+    for (int i = 0; i < 2; i++) {
+        g_string_chunk_clear(string_pool_[i]);
+        pool_rows_[i].clear();
+    }
+    // Neither generation matches any existing record.
+    string_pool_gen_ += 2;
+    col_data_ver_++;
+}
+
+void PacketListRecord::rotateStringPools()
+{
+    int old_pool = (string_pool_gen_ - 1) & 1;
+
+    foreach (PacketListRecord *record, pool_rows_[old_pool]) {
+        // Skip the ones that were moved to the current generation.
+        if (record->string_gen_ == string_pool_gen_ - 1 && record->col_text_) {
+            record->col_text_->clear();
+        }
+    }
+    pool_rows_[old_pool].clear();
+    g_string_chunk_clear(string_pool_[old_pool]);
+
+    // The emptied pool is the current one now.
+    string_pool_gen_++;
+}
+
+// Called after col_text_ has been filled from the current pool.
+void PacketListRecord::addToStringPool()
+{
+    if (string_gen_ == string_pool_gen_) {
+        return;
+    }
+
+    string_gen_ = string_pool_gen_;
+    pool_rows_[string_pool_gen_ & 1] << this;
+    if (pool_rows_[string_pool_gen_ & 1].count() >= max_pool_rows_) {
+        rotateStringPools();
+    }
+}
+
+// Move our column strings to the current pool if they're in the older one.
+void PacketListRecord::keepColumnStrings()
+{
+    if (!col_text_ || string_gen_ == string_pool_gen_) {
+        return;
+    }
+
+    for (int column = 0; column < col_text_->size(); ++column) {
+        const char *col_str = col_text_->at(column);
+        if (col_str) {
+            (*col_text_)[column] = g_string_chunk_insert_const(string_pool_[string_pool_gen_ & 1], col_str);
+        }
+    }
+    addToStringPool();
 }
 
 //#define MINIMIZE_STRING_COPYING 1
@@ -307,7 +379,7 @@ void PacketListRecord::cacheColumnStrings(column_info *cinfo)
         // https://git.gnome.org/browse/glib/tree/glib/gstringchunk.c
         // We might be better off adding the equivalent functionality to
         // wmem_tree.
-        col_text_->append(g_string_chunk_insert_const(string_pool_, col_str));
+        col_text_->append(g_string_chunk_insert_const(string_pool_[string_pool_gen_ & 1], col_str));
         for (int i = 0; col_str[i]; i++) {
             if (col_str[i] == '\n') col_lines++;
         }
@@ -317,6 +389,8 @@ void PacketListRecord::cacheColumnStrings(column_info *cinfo)
         }
 #endif // MINIMIZE_STRING_COPYING
     }
+
+    addToStringPool();
 }
 
 /*
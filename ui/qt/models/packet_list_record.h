@@ -34,6 +34,7 @@
 #include <QByteArray>
 #include <QList>
 #include <QVariant>
+#include <QVector>
 
 struct conversation;
 struct _GStringChunk;
@@ -83,10 +84,18 @@ private:
     /** Conversation. Used by RelatedPacketDelegate */
     struct conversation *conv_;
 
+    /** String pool generation holding col_text_ */
+    unsigned string_gen_;
+
     void dissect(capture_file *cap_file, bool dissect_color = false);
     void cacheColumnStrings(column_info *cinfo);
+    void keepColumnStrings();
+    void addToStringPool();
+    static void rotateStringPools();
 
-    static struct _GStringChunk *string_pool_;
+    static struct _GStringChunk *string_pool_[2];
+    static QVector<PacketListRecord *> pool_rows_[2];
+    static unsigned string_pool_gen_;
 
 };
 
@@ -71,6 +71,7 @@
 #include <QScrollBar>
 #include <QTabWidget>
 #include <QTextEdit>
+#include <QTimer>
 #include <QTimerEvent>
 #include <QTreeWidget>
 
@@ -446,6 +447,7 @@ PacketList::PacketList(QWidget *parent) :
             this, SLOT(sectionMoved(int,int,int)));
 
     connect(verticalScrollBar(), SIGNAL(actionTriggered(int)), this, SLOT(vScrollBarActionTriggered(int)));
+    connect(verticalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(vScrollBarValueChanged()));
 
     connect(&proto_prefs_menu_, SIGNAL(showProtocolPreferences(QString)),
             this, SIGNAL(showProtocolPreferences(QString)));
@@ -564,6 +566,21 @@ void PacketList::selectionChanged (const QItemSelection & selected, const QItemS
     } else if (!cap_file_->search_in_progress && proto_tree_) {
         proto_tree_->restoreSelectedField();
     }
+
+    // Dissect the neighbouring packets once we're idle so that moving
+    // to them with the arrow keys doesn't have to wait for it.
+    QTimer::singleShot(0, this, SLOT(prefetchNeighbours()));
+}
+
+void PacketList::prefetchNeighbours()
+{
+    if (!cap_file_ || !cap_file_->current_frame) return;
+
+    int row = currentIndex().row();
+    if (row < 0) return;
+
+    cf_prefetch_packet(cap_file_, row + 1);
+    cf_prefetch_packet(cap_file_, row - 1);
 }
 
 void PacketList::contextMenuEvent(QContextMenuEvent *event)
@@ -755,6 +772,7 @@ void PacketList::drawCurrentPacket()
 void PacketList::redrawVisiblePackets() {
     update();
     header()->update();
+    if (cap_file_) cf_invalidate_dissections(cap_file_);
     drawCurrentPacket();
 }
 
@@ -927,6 +945,7 @@ void PacketList::setVerticalAutoScroll(bool enabled)
 void PacketList::captureFileReadFinished()
 {
     packet_list_model_->flushVisibleRows();
+    vScrollBarValueChanged();
     packet_list_model_->dissectIdle(true);
 }
 
@@ -1610,6 +1629,18 @@ void PacketList::vScrollBarActionTriggered(int)
     scrollViewChanged(tail_at_end_);
 }
 
+// Let the idle dissection know which rows are on screen.
+void PacketList::vScrollBarValueChanged()
+{
+    QModelIndex first_idx = indexAt(viewport()->rect().topLeft());
+    if (!first_idx.isValid()) return;
+
+    QModelIndex last_idx = indexAt(viewport()->rect().bottomLeft());
+    int last = last_idx.isValid() ? last_idx.row() : packet_list_model_->rowCount() - 1;
+
+    packet_list_model_->setViewportRows(first_idx.row(), last);
+}
+
 void PacketList::scrollViewChanged(bool at_end)
 {
     if (capture_in_progress_ && prefs.capture_auto_scroll) {
@@ -1724,10 +1755,17 @@ void PacketList::drawFarOverlay()
     int pl_rows = packet_list_model_->rowCount();
     QImage overlay(o_width, o_height, QImage::Format_ARGB32_Premultiplied);
     bool have_marked_image = false;
+    // The capture file counts the frames we draw ticks for, so we can
+    // skip the rows entirely when there are none and stop as soon as
+    // we've seen them all instead of walking millions of rows.
+    guint32 marked_left = cap_file_->marked_count;
+    guint32 ignored_left = cap_file_->ignored_count;
+    guint32 ref_time_left = cap_file_->ref_time_count;
 
     // If only there were references from popular culture about getting into
     // some sort of groove.
-    if (!overlay.isNull() && recent.packet_list_colorize && pl_rows > 0) {
+    if (!overlay.isNull() && recent.packet_list_colorize && pl_rows > 0 &&
+            marked_left + ignored_left + ref_time_left > 0) {
 
         QPainter painter(&overlay);
 
@@ -1739,10 +1777,13 @@ void PacketList::drawFarOverlay()
         tick_color.setAlphaF(0.3);
         painter.setPen(tick_color);
 
-        for (int row = 0; row < pl_rows; row++) {
+        for (int row = 0; row < pl_rows && marked_left + ignored_left + ref_time_left > 0; row++) {
 
             frame_data *fdata = packet_list_model_->getRowFdata(row);
             if (fdata->flags.marked || fdata->flags.ref_time || fdata->flags.ignored) {
+                if (fdata->flags.marked && marked_left > 0) marked_left--;
+                if (fdata->flags.ignored && ignored_left > 0) ignored_left--;
+                if (fdata->flags.ref_time && ref_time_left > 0) ref_time_left--;
                 int new_line = row * o_height / pl_rows;
                 int tick_width = o_width / 3;
                 // Marked or ignored: left side, time refs: right side.
@@ -191,8 +191,10 @@ private slots:
     void updateRowHeights(const QModelIndex &ih_index);
     void copySummary();
     void vScrollBarActionTriggered(int);
+    void vScrollBarValueChanged();
     void drawFarOverlay();
     void drawNearOverlay();
+    void prefetchNeighbours();
 };
 
 #endif // PACKET_LIST_H
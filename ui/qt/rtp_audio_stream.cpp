@@ -38,6 +38,8 @@
 
 #include <wsutil/nstime.h>
 
+#include <algorithm>
+
 #include <QAudioFormat>
 #include <QAudioOutput>
 #include <QDir>
@@ -47,8 +49,8 @@
 // To do:
 // - Only allow one rtp_stream_info_t per RtpAudioStream?
 
-static spx_int16_t default_audio_sample_rate_ = 8000;
-static const spx_int16_t visual_sample_rate_ = 1000;
+// Visual samples per second. They're taken in low, high pairs.
+static const unsigned visual_sample_rate_ = 1000;
 
 RtpAudioStream::RtpAudioStream(QObject *parent, _rtp_stream_info *rtp_stream) :
     QObject(parent),
@@ -71,11 +73,6 @@ RtpAudioStream::RtpAudioStream(QObject *parent, _rtp_stream_info *rtp_stream) :
     dst_port_ = rtp_stream->dest_port;
     ssrc_ = rtp_stream->ssrc;
 
-    // We keep visual samples in memory. Make fewer of them.
-    visual_resampler_ = speex_resampler_init(1, default_audio_sample_rate_,
-                                                visual_sample_rate_, SPEEX_RESAMPLER_QUALITY_MIN, NULL);
-    speex_resampler_skip_zeros(visual_resampler_);
-
     QString tempname = QString("%1/wireshark_rtp_stream").arg(QDir::tempPath());
     tempfile_ = new QTemporaryFile(tempname, this);
     tempfile_->open();
@@ -93,7 +90,6 @@ RtpAudioStream::~RtpAudioStream()
     }
     g_hash_table_destroy(decoders_hash_);
     if (audio_resampler_) speex_resampler_destroy (audio_resampler_);
-    speex_resampler_destroy (visual_resampler_);
 }
 
 bool RtpAudioStream::isMatch(const _rtp_stream_info *rtp_stream) const
@@ -159,6 +155,8 @@ void RtpAudioStream::reset(double start_rel_time)
     audio_out_rate_ = 0;
     max_sample_val_ = 1;
     packet_timestamps_.clear();
+    packet_frames_.clear();
+    visual_timestamps_.clear();
     visual_samples_.clear();
     out_of_seq_timestamps_.clear();
     jitter_drop_timestamps_.clear();
@@ -166,9 +164,6 @@ void RtpAudioStream::reset(double start_rel_time)
     if (audio_resampler_) {
         speex_resampler_reset_mem(audio_resampler_);
     }
-    if (visual_resampler_) {
-        speex_resampler_reset_mem(visual_resampler_);
-    }
     tempfile_->seek(0);
 }
 
@@ -186,7 +181,7 @@ void RtpAudioStream::decode()
 
     gsize resample_buff_len = 0x1000;
     SAMPLE *resample_buff = (SAMPLE *) g_malloc(resample_buff_len);
-    spx_uint32_t cur_in_rate = 0, visual_out_rate = 0;
+    spx_uint32_t cur_in_rate = 0;
     char *write_buff = NULL;
     qint64 write_bytes = 0;
     unsigned channels = 0;
@@ -208,7 +203,6 @@ void RtpAudioStream::decode()
         rtp_packet_t *rtp_packet = rtp_packets_[cur_packet];
 
         stop_rel_time_ = start_rel_time_ + rtp_packet->arrive_offset;
-        speex_resampler_get_rate(visual_resampler_, &cur_in_rate, &visual_out_rate);
 
         QString payload_name;
         if (rtp_packet->info->info_payload_type_str) {
@@ -365,7 +359,6 @@ void RtpAudioStream::decode()
                 // Adjust rates if needed.
                 if (sample_rate != cur_in_rate) {
                     speex_resampler_set_rate(audio_resampler_, sample_rate, audio_out_rate);
-                    speex_resampler_set_rate(visual_resampler_, sample_rate, visual_out_rate);
                     RTP_STREAM_DEBUG("Changed input rate from %u to %u Hz. Out is %u.", cur_in_rate, sample_rate, audio_out_rate_);
                 }
             }
@@ -386,20 +379,7 @@ void RtpAudioStream::decode()
         tempfile_->write(write_buff, write_bytes);
 
         // Collect our visual samples.
-        spx_uint32_t in_len = (spx_uint32_t)rtp_packet->info->info_payload_len;
-        spx_uint32_t out_len = (visual_out_rate * in_len / sample_rate) + (visual_out_rate % sample_rate != 0);
-        if (out_len * sample_bytes_ > resample_buff_len) {
-            while ((out_len * sample_bytes_ > resample_buff_len))
-                resample_buff_len *= 2;
-            resample_buff = (SAMPLE *) g_realloc(resample_buff, resample_buff_len);
-        }
-
-        speex_resampler_process_int(visual_resampler_, 0, decode_buff, &in_len, resample_buff, &out_len);
-        for (unsigned i = 0; i < out_len; i++) {
-            packet_timestamps_[stop_rel_time_ + (double) i / visual_out_rate] = rtp_packet->frame_num;
-            if (qAbs(resample_buff[i]) > max_sample_val_) max_sample_val_ = qAbs(resample_buff[i]);
-            visual_samples_.append(resample_buff[i]);
-        }
+        addVisualSamples(decode_buff, decoded_bytes / sample_bytes_, sample_rate, rtp_packet->frame_num);
 
         // Finally, write the resampled audio to our temp file and clean up.
         g_free(decode_buff);
@@ -407,6 +387,39 @@ void RtpAudioStream::decode()
     g_free(resample_buff);
 }
 
+// Reduce the decoded samples to the lowest and highest sample of each
+// block. Unlike resampling this keeps the peaks, and it's much cheaper.
+void RtpAudioStream::addVisualSamples(const qint16 *samples, size_t count, unsigned sample_rate, quint32 frame_num)
+{
+    if (count < 1 || sample_rate < 1) return;
+
+    size_t block_len = qMax<size_t>(1, sample_rate * 2 / visual_sample_rate_);
+    int max_val = max_sample_val_;
+
+    packet_timestamps_.append(stop_rel_time_);
+    packet_frames_.append(frame_num);
+
+    for (size_t block = 0; block < count; block += block_len) {
+        size_t end = qMin(block + block_len, count);
+        size_t low = block, high = block;
+
+        for (size_t i = block + 1; i < end; i++) {
+            if (samples[i] < samples[low]) low = i;
+            if (samples[i] > samples[high]) high = i;
+        }
+        size_t first = qMin(low, high);
+        size_t last = qMax(low, high);
+        visual_timestamps_.append(stop_rel_time_ + (double) first / sample_rate);
+        visual_samples_.append(samples[first]);
+        if (last != first) {
+            visual_timestamps_.append(stop_rel_time_ + (double) last / sample_rate);
+            visual_samples_.append(samples[last]);
+        }
+        max_val = qMax(max_val, qMax(qAbs((int) samples[low]), qAbs((int) samples[high])));
+    }
+    max_sample_val_ = qMin(max_val, (int) G_MAXINT16);
+}
+
 const QStringList RtpAudioStream::payloadNames() const
 {
     QStringList payload_names = payload_names_.toList();
@@ -416,12 +429,12 @@ const QStringList RtpAudioStream::payloadNames() const
 
 const QVector<double> RtpAudioStream::visualTimestamps(bool relative)
 {
-    QVector<double> ts_keys = packet_timestamps_.keys().toVector();
-    if (relative) return ts_keys;
+    if (relative) return visual_timestamps_;
 
     QVector<double> adj_timestamps;
-    for (int i = 0; i < ts_keys.size(); i++) {
-        adj_timestamps.append(ts_keys[i] + start_abs_offset_);
+    adj_timestamps.reserve(visual_timestamps_.size());
+    for (int i = 0; i < visual_timestamps_.size(); i++) {
+        adj_timestamps.append(visual_timestamps_[i] + start_abs_offset_);
     }
     return adj_timestamps;
 }
@@ -436,6 +449,7 @@ const QVector<double> RtpAudioStream::visualSamples(int y_offset)
 {
     QVector<double> adj_samples;
     double scaled_offset = y_offset * stack_offset_;
+    adj_samples.reserve(visual_samples_.size());
     for (int i = 0; i < visual_samples_.size(); i++) {
         adj_samples.append(((double)visual_samples_[i] * G_MAXINT16 / max_sample_val_) + scaled_offset);
     }
@@ -528,12 +542,15 @@ const QVector<double> RtpAudioStream::insertedSilenceSamples(int y_offset)
 
 quint32 RtpAudioStream::nearestPacket(double timestamp, bool is_relative)
 {
-    if (packet_timestamps_.keys().count() < 1) return 0;
+    if (packet_timestamps_.isEmpty()) return 0;
 
     if (!is_relative) timestamp -= start_abs_offset_;
-    QMap<double, quint32>::const_iterator it = packet_timestamps_.lowerBound(timestamp);
-    if (it == packet_timestamps_.end()) return 0;
-    return it.value();
+    if (timestamp > visual_timestamps_.last()) return 0;
+
+    // The packet that was playing at timestamp.
+    int idx = int(std::upper_bound(packet_timestamps_.constBegin(), packet_timestamps_.constEnd(), timestamp)
+                  - packet_timestamps_.constBegin());
+    return packet_frames_[qMax(idx - 1, 0)];
 }
 
 QAudio::State RtpAudioStream::outputState() const
@@ -633,8 +650,11 @@ void RtpAudioStream::writeSilence(int samples)
     tempfile_->write(silence_buff, silence_bytes);
     g_free(silence_buff);
 
-    QVector<qint16> visual_fill(samples * visual_sample_rate_ / audio_out_rate_, 0);
-    visual_samples_ += visual_fill;
+    // Drop the waveform to zero across the gap.
+    if (!visual_timestamps_.isEmpty()) {
+        visual_timestamps_.append(visual_timestamps_.last() + 1.0 / visual_sample_rate_);
+        visual_samples_.append(0);
+    }
 }
 
 void RtpAudioStream::outputStateChanged(QAudio::State new_state)
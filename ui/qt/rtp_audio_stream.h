@@ -32,7 +32,6 @@
 
 #include <QAudio>
 #include <QColor>
-#include <QMap>
 #include <QObject>
 #include <QSet>
 #include <QVector>
@@ -170,9 +169,10 @@ private:
     quint32 audio_out_rate_;
     QSet<QString> payload_names_;
     struct SpeexResamplerState_ *audio_resampler_;
-    struct SpeexResamplerState_ *visual_resampler_;
     QAudioOutput *audio_output_;
-    QMap<double, quint32> packet_timestamps_;
+    QVector<double> packet_timestamps_;
+    QVector<quint32> packet_frames_;
+    QVector<double> visual_timestamps_;
     QVector<qint16> visual_samples_;
     QVector<double> out_of_seq_timestamps_;
     QVector<double> jitter_drop_timestamps_;
@@ -185,6 +185,7 @@ private:
     TimingMode timing_mode_;
 
     void writeSilence(int samples);
+    void addVisualSamples(const qint16 *samples, size_t count, unsigned sample_rate, quint32 frame_num);
     const QString formatDescription(const QAudioFormat & format);
     QString currentOutputDevice();
 
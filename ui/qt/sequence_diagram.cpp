@@ -27,6 +27,8 @@
 #include <ui/qt/utils/color_utils.h>
 #include <ui/qt/utils/qt_ui_utils.h>
 
+#include <math.h>
+
 #include <QFont>
 #include <QFontMetrics>
 #include <QPalette>
@@ -60,7 +62,7 @@ SequenceDiagram::SequenceDiagram(QCPAxis *keyAxis, QCPAxis *valueAxis, QCPAxis *
     selected_packet_(0),
     selected_key_(-1.0)
 {
-    data_ = new WSCPSeqDataMap();
+    data_ = new WSCPSeqDataVector();
     // xaxis (value): Address
     // yaxis (key): Time
     // yaxis2 (comment): Extra info ("Comment" in GTK+)
@@ -96,6 +98,9 @@ SequenceDiagram::SequenceDiagram(QCPAxis *keyAxis, QCPAxis *valueAxis, QCPAxis *
 
 //    setTickVectorLabels
     //    valueAxis->setTickLabelRotation(30);
+
+    // Time and comment labels are only made for the rows in view.
+    connect(key_axis_, SIGNAL(rangeChanged(QCPRange)), this, SLOT(keyRangeChanged()));
 }
 
 SequenceDiagram::~SequenceDiagram()
@@ -106,41 +111,31 @@ SequenceDiagram::~SequenceDiagram()
 int SequenceDiagram::adjacentPacket(bool next)
 {
     int adjacent_packet = -1;
-    WSCPSeqDataMap::const_iterator it;
+    int size = data_->size();
 
-    if (data_->size() < 1) return adjacent_packet;
+    if (size < 1) return adjacent_packet;
 
     if (selected_packet_ < 1) {
-        if (next) {
-            it = data_->constBegin();
-        } else {
-            it = data_->constEnd();
-            --it;
-        }
-        selected_key_ = it.value().key;
-        return it.value().value->frame_number;
+        const WSCPSeqData &seq_data = next ? data_->first() : data_->last();
+        selected_key_ = seq_data.key;
+        return seq_data.value->frame_number;
     }
 
     if (next) {
-        for (it = data_->constBegin(); it != data_->constEnd(); ++it) {
-            if (it.value().value->frame_number == selected_packet_) {
-                ++it;
-                if (it != data_->constEnd()) {
-                    adjacent_packet = it.value().value->frame_number;
-                    selected_key_ = it.value().key;
+        for (int key = 0; key < size; key++) {
+            if (data_->at(key).value->frame_number == selected_packet_) {
+                if (key + 1 < size) {
+                    adjacent_packet = data_->at(key + 1).value->frame_number;
+                    selected_key_ = key + 1;
                 }
                 break;
             }
         }
     } else {
-        it = data_->constEnd();
-        --it;
-        while (it != data_->constBegin()) {
-            guint32 prev_frame = it.value().value->frame_number;
-            --it;
-            if (prev_frame == selected_packet_) {
-                adjacent_packet = it.value().value->frame_number;
-                selected_key_ = it.value().key;
+        for (int key = size - 1; key > 0; key--) {
+            if (data_->at(key).value->frame_number == selected_packet_) {
+                adjacent_packet = data_->at(key - 1).value->frame_number;
+                selected_key_ = key - 1;
                 break;
             }
         }
@@ -155,28 +150,15 @@ void SequenceDiagram::setData(_seq_analysis_info *sainfo)
     sainfo_ = sainfo;
     if (!sainfo) return;
 
-    double cur_key = 0.0;
-    QVector<double> key_ticks, val_ticks;
-    QVector<QString> key_labels, val_labels, com_labels;
-    QFontMetrics com_fm(comment_axis_->tickLabelFont());
-    int elide_w = com_fm.height() * max_comment_em_width_;
+    QVector<double> val_ticks;
+    QVector<QString> val_labels;
     char* addr_str;
 
+    data_->reserve(g_queue_get_length(sainfo->items));
     for (GList *cur = g_queue_peek_nth_link(sainfo->items, 0); cur; cur = g_list_next(cur)) {
         seq_analysis_item_t *sai = (seq_analysis_item_t *) cur->data;
         if (sai->display) {
-            WSCPSeqData new_data;
-
-            new_data.key = cur_key;
-            new_data.value = sai;
-            data_->insertMulti(new_data.key, new_data);
-
-            key_ticks.append(cur_key);
-            key_labels.append(sai->time_str);
-
-            com_labels.append(com_fm.elidedText(sai->comment, Qt::ElideRight, elide_w));
-
-            cur_key++;
+            data_->append(WSCPSeqData(data_->size(), sai));
         }
     }
 
@@ -190,10 +172,32 @@ void SequenceDiagram::setData(_seq_analysis_info *sainfo)
 
         wmem_free(NULL, addr_str);
     }
-    keyAxis()->setTickVector(key_ticks);
-    keyAxis()->setTickVectorLabels(key_labels);
     valueAxis()->setTickVector(val_ticks);
     valueAxis()->setTickVectorLabels(val_labels);
+    keyRangeChanged();
+}
+
+// Make the time and comment labels for the rows in view, so that we don't
+// have to make (and the axes don't have to go through) millions of them.
+void SequenceDiagram::keyRangeChanged()
+{
+    QVector<double> key_ticks;
+    QVector<QString> key_labels, com_labels;
+    QFontMetrics com_fm(comment_axis_->tickLabelFont());
+    int elide_w = com_fm.height() * max_comment_em_width_;
+    int first_key = qMax(0, (int) floor(key_axis_->range().lower));
+    int last_key = qMin(data_->size() - 1, (int) ceil(key_axis_->range().upper));
+
+    for (int key = first_key; key <= last_key; key++) {
+        seq_analysis_item_t *sai = data_->at(key).value;
+
+        key_ticks.append(key);
+        key_labels.append(sai->time_str);
+        com_labels.append(com_fm.elidedText(sai->comment, Qt::ElideRight, elide_w));
+    }
+
+    keyAxis()->setTickVector(key_ticks);
+    keyAxis()->setTickVectorLabels(key_labels);
     comment_axis_->setTickVector(key_ticks);
     comment_axis_->setTickVectorLabels(com_labels);
 }
@@ -203,6 +207,12 @@ void SequenceDiagram::setSelectedPacket(int selected_packet)
     selected_key_ = -1;
     if (selected_packet > 0) {
         selected_packet_ = selected_packet;
+        for (int key = 0; key < data_->size(); key++) {
+            if (data_->at(key).value->frame_number == selected_packet_) {
+                selected_key_ = key;
+                break;
+            }
+        }
     } else {
         selected_packet_ = 0;
     }
@@ -211,10 +221,10 @@ void SequenceDiagram::setSelectedPacket(int selected_packet)
 
 _seq_analysis_item *SequenceDiagram::itemForPosY(int ypos)
 {
-    double key_pos = qRound(key_axis_->pixelToCoord(ypos));
+    int key_pos = qRound(key_axis_->pixelToCoord(ypos));
 
     if (key_pos >= 0 && key_pos < data_->size()) {
-        return data_->value(key_pos).value;
+        return data_->at(key_pos).value;
     }
     return NULL;
 }
@@ -251,17 +261,18 @@ void SequenceDiagram::draw(QCPPainter *painter)
     painter->restore();
     fg_pen = mainPen();
 
-    WSCPSeqDataMap::const_iterator it;
-    for (it = data_->constBegin(); it != data_->constEnd(); ++it) {
-        double cur_key = it.key();
-        seq_analysis_item_t *sai = it.value().value;
+    // Only the rows in view (and the half rows at the edges).
+    int first_key = qMax(0, (int) floor(key_axis_->range().lower - 0.5));
+    int last_key = qMin(data_->size() - 1, (int) ceil(key_axis_->range().upper + 0.5));
+    for (int key = first_key; key <= last_key; key++) {
+        double cur_key = key;
+        seq_analysis_item_t *sai = data_->at(key).value;
         QColor bg_color;
 
         if (sai->frame_number == selected_packet_) {
             QPalette sel_pal;
             fg_pen.setColor(sel_pal.color(QPalette::HighlightedText));
             bg_color = sel_pal.color(QPalette::Highlight);
-            selected_key_ = cur_key;
         } else if (sai->has_color_filter) {
             fg_pen.setColor(QColor().fromRgb(sai->fg_color));
             bg_color = QColor().fromRgb(sai->bg_color);
@@ -367,18 +378,11 @@ QCPRange SequenceDiagram::getKeyRange(bool &validRange, QCPAbstractPlottable::Si
     QCPRange range;
     bool valid = false;
 
-    WSCPSeqDataMap::const_iterator it = data_->constBegin();
-    while (it != data_->constEnd()) {
-        double cur_key = it.key();
-        if (!valid) {
-            range.lower = range.upper = cur_key;
-            valid = true;
-        } else if (cur_key < range.lower) {
-            range.lower = cur_key;
-        } else if (cur_key > range.upper) {
-            range.upper = cur_key;
-        }
-        ++it;
+    // Keys are the row numbers.
+    if (!data_->isEmpty()) {
+        range.lower = 0;
+        range.upper = data_->size() - 1;
+        valid = true;
     }
     validRange = valid;
     return range;
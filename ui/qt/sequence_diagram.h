@@ -29,7 +29,7 @@
 #include <epan/address.h>
 
 #include <QObject>
-#include <QMultiMap>
+#include <QVector>
 #include <ui/qt/widgets/qcustomplot.h>
 
 struct _seq_analysis_info;
@@ -45,7 +45,8 @@ public:
   struct _seq_analysis_item *value;
 };
 
-typedef QMap<double, WSCPSeqData> WSCPSeqDataMap;
+// Indexed by key, which is the item's row in the diagram.
+typedef QVector<WSCPSeqData> WSCPSeqDataVector;
 
 class SequenceDiagram : public QCPAbstractPlottable
 {
@@ -73,6 +74,9 @@ public:
 public slots:
     void setSelectedPacket(int selected_packet);
 
+private slots:
+    void keyRangeChanged();
+
 protected:
     virtual void draw(QCPPainter *painter);
     virtual void drawLegendIcon(QCPPainter *painter, const QRectF &rect) const;
@@ -83,7 +87,7 @@ private:
     QCPAxis *key_axis_;
     QCPAxis *value_axis_;
     QCPAxis *comment_axis_;
-    WSCPSeqDataMap *data_;
+    WSCPSeqDataVector *data_;
     struct _seq_analysis_info *sainfo_;
     guint32 selected_packet_;
     double selected_key_;
@@ -83,6 +83,13 @@ enum {
     srt_row_type_
 };
 
+// Percentile columns, after the ones shared with GTK+
+enum {
+    srt_column_p50_ = NUM_SRT_COLUMNS,
+    srt_column_p99_,
+    srt_column_p999_
+};
+
 class SrtRowTreeWidgetItem : public QTreeWidgetItem
 {
 public:
@@ -101,6 +108,9 @@ public:
         setText(SRT_COLUMN_MAX, QString::number(nstime_to_sec(&procedure_->stats.max), 'f', 6));
         setText(SRT_COLUMN_AVG, QString::number(get_average(&procedure_->stats.tot, procedure_->stats.num) / 1000.0, 'f', 6));
         setText(SRT_COLUMN_SUM, QString::number(nstime_to_sec(&procedure_->stats.tot), 'f', 6));
+        setText(srt_column_p50_, QString::number(time_hist_percentile(&procedure_->hist, 50.0), 'f', 6));
+        setText(srt_column_p99_, QString::number(time_hist_percentile(&procedure_->hist, 99.0), 'f', 6));
+        setText(srt_column_p999_, QString::number(time_hist_percentile(&procedure_->hist, 99.9), 'f', 6));
 
         for (int col = 0; col < columnCount(); col++) {
             if (col == SRT_COLUMN_PROCEDURE) continue;
@@ -132,6 +142,12 @@ public:
         }
         case SRT_COLUMN_SUM:
             return nstime_cmp(&procedure_->stats.tot, &other_row->procedure_->stats.tot) < 0;
+        case srt_column_p50_:
+            return time_hist_percentile(&procedure_->hist, 50.0) < time_hist_percentile(&other_row->procedure_->hist, 50.0);
+        case srt_column_p99_:
+            return time_hist_percentile(&procedure_->hist, 99.0) < time_hist_percentile(&other_row->procedure_->hist, 99.0);
+        case srt_column_p999_:
+            return time_hist_percentile(&procedure_->hist, 99.9) < time_hist_percentile(&other_row->procedure_->hist, 99.9);
         default:
             break;
         }
@@ -142,7 +158,10 @@ public:
         return QList<QVariant>() << QString(procedure_->procedure) << procedure_->proc_index << procedure_->stats.num
                                  << nstime_to_sec(&procedure_->stats.min) << nstime_to_sec(&procedure_->stats.max)
                                  << get_average(&procedure_->stats.tot, procedure_->stats.num) / 1000.0
-                                 << nstime_to_sec(&procedure_->stats.tot);
+                                 << nstime_to_sec(&procedure_->stats.tot)
+                                 << time_hist_percentile(&procedure_->hist, 50.0)
+                                 << time_hist_percentile(&procedure_->hist, 99.0)
+                                 << time_hist_percentile(&procedure_->hist, 99.9);
     }
 private:
     const srt_procedure_t *procedure_;
@@ -192,6 +211,7 @@ ServiceResponseTimeDialog::ServiceResponseTimeDialog(QWidget &parent, CaptureFil
     for (int col = 0; col < NUM_SRT_COLUMNS; col++) {
         header_labels.push_back(service_response_time_get_column_name(col));
     }
+    header_labels << tr("p50 SRT (s)") << tr("p99 SRT (s)") << tr("p99.9 SRT (s)");
     statsTreeWidget()->setColumnCount(header_labels.count());
     statsTreeWidget()->setHeaderLabels(header_labels);
 
@@ -78,6 +78,10 @@ const double pkt_point_size_ = 3.0;
 // in zoom mode.
 const int min_zoom_pixels_ = 20;
 
+// Hand QCustomPlot at least this many min/max columns per graph, even if
+// the plot is narrower than that (e.g. before it's first shown).
+const int min_decimation_columns_ = 256;
+
 const QString average_throughput_label_ = QObject::tr("Average Throughput (bits/s)");
 const QString round_trip_time_ms_label_ = QObject::tr("Round Trip Time (ms)");
 const QString segment_length_label_ = QObject::tr("Segment Length (B)");
@@ -107,6 +111,7 @@ TCPStreamDialog::TCPStreamDialog(QWidget *parent, capture_file *cf, tcp_graph_ty
     mouse_drags_(true),
     rubber_band_(NULL),
     graph_updater_(this),
+    decimated_columns_(0),
     num_dsegs_(-1),
     num_acks_(-1),
     num_sack_ranges_(-1),
@@ -315,6 +320,7 @@ TCPStreamDialog::TCPStreamDialog(QWidget *parent, capture_file *cf, tcp_graph_ty
     connect(sp, SIGNAL(axisClick(QCPAxis*,QCPAxis::SelectablePart,QMouseEvent*)),
             this, SLOT(axisClicked(QCPAxis*,QCPAxis::SelectablePart,QMouseEvent*)));
     connect(sp->yAxis, SIGNAL(rangeChanged(QCPRange)), this, SLOT(transformYRange(QCPRange)));
+    connect(sp, SIGNAL(beforeReplot()), this, SLOT(plotBeforeReplot()));
     disconnect(ui->buttonBox, SIGNAL(accepted()), this, SLOT(accept()));
     this->setResult(QDialog::Accepted);
 }
@@ -488,6 +494,7 @@ void TCPStreamDialog::fillGraph(bool reset_axes, bool set_focus)
     tracer_->setGraph(NULL);
 
     // base_graph_ is always visible.
+    graph_series_.clear();
     for (int i = 0; i < sp->graphCount(); i++) {
         sp->graph(i)->clearData();
         sp->graph(i)->setVisible(i == 0 ? true : false);
@@ -705,6 +712,8 @@ void TCPStreamDialog::resetAxes()
     y_axis_xfrm_.reset();
     double pixel_pad = 10.0; // per side
 
+    // Autoscale against all of the data, not just what's in view.
+    decimateGraphs(true);
     sp->rescaleAxes(true);
 //    tput_graph_->rescaleValueAxis(false, true);
 //    base_graph_->rescaleAxes(false, true);
@@ -749,7 +758,7 @@ void TCPStreamDialog::fillStevens()
         rel_time.append(ts - ts_offset_);
         seq.append(seg->th_seq - seq_offset_);
     }
-    base_graph_->setData(rel_time, seq);
+    setGraphData(base_graph_, rel_time, seq);
 }
 
 void TCPStreamDialog::fillTcptrace()
@@ -827,12 +836,12 @@ void TCPStreamDialog::fillTcptrace()
             rwin.append(ackno + seg->th_win);
         }
     }
-    base_graph_->setData(pkt_time, pkt_seqnums);
-    seg_graph_->setDataValueError(sb_time, sb_center, sb_span);
-    ack_graph_->setData(ackrwin_time, ack);
-    sack_graph_->setDataValueError(sack_time, sack_center, sack_span);
-    sack2_graph_->setDataValueError(sack2_time, sack2_center, sack2_span);
-    rwin_graph_->setData(ackrwin_time, rwin);
+    setGraphData(base_graph_, pkt_time, pkt_seqnums);
+    setGraphDataValueError(seg_graph_, sb_time, sb_center, sb_span);
+    setGraphData(ack_graph_, ackrwin_time, ack);
+    setGraphDataValueError(sack_graph_, sack_time, sack_center, sack_span);
+    setGraphDataValueError(sack2_graph_, sack2_time, sack2_center, sack2_span);
+    setGraphData(rwin_graph_, ackrwin_time, rwin);
 }
 
 // If the current implementation of incorporating SACKs in goodput calc
@@ -1254,9 +1263,9 @@ void TCPStreamDialog::fillThroughput()
             r_Xput_times.append(ts);
         }
     }
-    base_graph_->setData(seg_rel_times, seg_lens);
-    tput_graph_->setData(tput_times, tputs);
-    goodput_graph_->setData(gput_times, gputs);
+    setGraphData(base_graph_, seg_rel_times, seg_lens);
+    setGraphData(tput_graph_, tput_times, tputs);
+    setGraphData(goodput_graph_, gput_times, gputs);
 }
 
 // rtt_selectively_ack_range:
@@ -1454,7 +1463,7 @@ void TCPStreamDialog::fillRoundTripTime()
     }
     // it's possible there's still unacked segs - so be sure to free list!
     rtt_destroy_unack_list(&unack_list);
-    base_graph_->setData(x_vals, rtt);
+    setGraphData(base_graph_, x_vals, rtt);
 }
 
 void TCPStreamDialog::fillWindowScale()
@@ -1507,8 +1516,8 @@ void TCPStreamDialog::fillWindowScale()
             }
         }
     }
-    base_graph_->setData(cwnd_time, cwnd_size);
-    rwin_graph_->setData(rel_time, win_size);
+    setGraphData(base_graph_, cwnd_time, cwnd_size);
+    setGraphData(rwin_graph_, rel_time, win_size);
     sp->yAxis->setLabel(window_size_label_);
 }
 
@@ -1582,6 +1591,45 @@ QRectF TCPStreamDialog::getZoomRanges(QRect zoom_rect)
     return zoom_ranges;
 }
 
+void TCPStreamDialog::setGraphData(QCPGraph *graph, const QVector<double> &keys, const QVector<double> &values)
+{
+    setGraphDataValueError(graph, keys, values, QVector<double>());
+}
+
+void TCPStreamDialog::setGraphDataValueError(QCPGraph *graph, const QVector<double> &keys, const QVector<double> &values, const QVector<double> &spans)
+{
+    graph_series_[graph].setData(keys, values, spans);
+    // Force decimateGraphs to hand it to the graph.
+    decimated_columns_ = 0;
+}
+
+void TCPStreamDialog::decimateGraphs(bool full_range)
+{
+    QCustomPlot *sp = ui->streamPlot;
+    QCPRange range = sp->xAxis->range();
+    int columns = qMax(sp->xAxis->axisRect()->width(), min_decimation_columns_);
+
+    if (full_range) {
+        range = QCPRange(-QCPRange::maxRange, QCPRange::maxRange);
+    } else if (range == decimated_range_ && columns == decimated_columns_) {
+        return;
+    }
+
+    QMap<QCPGraph *, GraphSeries>::const_iterator it;
+    for (it = graph_series_.constBegin(); it != graph_series_.constEnd(); ++it) {
+        QVector<double> keys, values, spans;
+
+        it.value().decimate(range.lower, range.upper, columns, keys, values, spans);
+        if (it.value().hasSpans()) {
+            it.key()->setDataValueError(keys, values, spans);
+        } else {
+            it.key()->setData(keys, values);
+        }
+    }
+    decimated_range_ = range;
+    decimated_columns_ = columns;
+}
+
 void TCPStreamDialog::graphClicked(QMouseEvent *event)
 {
     QCustomPlot *sp = ui->streamPlot;
@@ -1764,6 +1812,11 @@ void TCPStreamDialog::transformYRange(const QCPRange &y_range1)
     sp->yAxis2->setRangeLower(yp2.y1());
 }
 
+void TCPStreamDialog::plotBeforeReplot()
+{
+    decimateGraphs();
+}
+
 void TCPStreamDialog::on_buttonBox_accepted()
 {
     QString file_name, extension;
@@ -32,6 +32,7 @@
 
 #include "ui/tap-tcp-stream.h"
 
+#include <ui/qt/utils/graph_series.h>
 #include <ui/qt/widgets/qcustomplot.h>
 #include <QDialog>
 #include <QMenu>
@@ -110,6 +111,12 @@ private:
     friend class GraphUpdater;
     GraphUpdater graph_updater_;
 
+    // Full resolution data behind each graph. Only the visible part is
+    // handed to QCustomPlot, decimated.
+    QMap<QCPGraph *, GraphSeries> graph_series_;
+    QCPRange decimated_range_;
+    int decimated_columns_;
+
     int num_dsegs_;
     int num_acks_;
     int num_sack_ranges_;
@@ -133,6 +140,9 @@ private:
     bool compareHeaders(struct segment *seg);
     void toggleTracerStyle(bool force_default = false);
     QRectF getZoomRanges(QRect zoom_rect);
+    void setGraphData(QCPGraph *graph, const QVector<double> &keys, const QVector<double> &values);
+    void setGraphDataValueError(QCPGraph *graph, const QVector<double> &keys, const QVector<double> &values, const QVector<double> &spans);
+    void decimateGraphs(bool full_range = false);
 
 private slots:
     void graphClicked(QMouseEvent *event);
@@ -140,6 +150,7 @@ private slots:
     void mouseMoved(QMouseEvent *event);
     void mouseReleased(QMouseEvent *event);
     void transformYRange(const QCPRange &y_range1);
+    void plotBeforeReplot();
     void on_buttonBox_accepted();
     void on_graphTypeComboBox_currentIndexChanged(int index);
     void on_resetButton_clicked();
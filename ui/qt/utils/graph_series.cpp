@@ -0,0 +1,179 @@
+/* graph_series.cpp
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <ui/qt/utils/graph_series.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include <QPair>
+
+void GraphSeries::setData(const QVector<double> &keys, const QVector<double> &values, const QVector<double> &spans)
+{
+    int count = qMin(keys.size(), values.size());
+    bool sorted = true;
+
+    keys_ = keys.mid(0, count);
+    values_ = values.mid(0, count);
+    spans_ = spans.isEmpty() ? QVector<double>() : spans.mid(0, count);
+
+    for (int i = 1; i < count && sorted; i++) {
+        if (keys_[i] < keys_[i - 1]) sorted = false;
+    }
+
+    if (!sorted) {
+        std::vector<std::pair<double, int> > order;
+        order.reserve(count);
+        for (int i = 0; i < count; i++) {
+            order.push_back(std::make_pair(keys[i], i));
+        }
+        std::sort(order.begin(), order.end());
+        for (int i = 0; i < count; i++) {
+            keys_[i] = order[i].first;
+            values_[i] = values[order[i].second];
+            if (!spans_.isEmpty()) spans_[i] = spans[order[i].second];
+        }
+    }
+
+    // Each level pairs up the points or blocks below it.
+    min_idx_.clear();
+    max_idx_.clear();
+    int below = count;
+    while (below > 1) {
+        int blocks = (below + 1) / 2;
+        QVector<int> mins(blocks), maxs(blocks);
+
+        for (int blk = 0; blk < blocks; blk++) {
+            int left = blk * 2;
+            int right = qMin(left + 1, below - 1);
+            int l_min = left, r_min = right, l_max = left, r_max = right;
+
+            if (!min_idx_.isEmpty()) {
+                l_min = min_idx_.last()[left];
+                r_min = min_idx_.last()[right];
+                l_max = max_idx_.last()[left];
+                r_max = max_idx_.last()[right];
+            }
+            mins[blk] = low(r_min) < low(l_min) ? r_min : l_min;
+            maxs[blk] = high(r_max) > high(l_max) ? r_max : l_max;
+        }
+        min_idx_.append(mins);
+        max_idx_.append(maxs);
+        below = blocks;
+    }
+}
+
+void GraphSeries::clear()
+{
+    keys_.clear();
+    values_.clear();
+    spans_.clear();
+    min_idx_.clear();
+    max_idx_.clear();
+}
+
+void GraphSeries::decimate(double lower, double upper, int columns, QVector<double> &keys, QVector<double> &values, QVector<double> &spans) const
+{
+    int count = keys_.size();
+
+    keys.clear();
+    values.clear();
+    spans.clear();
+    if (count < 1 || columns < 1) return;
+
+    // Include the points just outside the range so that lines run off
+    // the edges of the plot.
+    int first = int(std::lower_bound(keys_.constBegin(), keys_.constEnd(), lower) - keys_.constBegin());
+    int last = int(std::upper_bound(keys_.constBegin(), keys_.constEnd(), upper) - keys_.constBegin());
+    first = qMax(first - 1, 0);
+    last = qMin(last, count - 1);
+    int span = last - first + 1;
+
+    if (span <= columns * 2) {
+        keys = keys_.mid(first, span);
+        values = values_.mid(first, span);
+        if (!spans_.isEmpty()) spans = spans_.mid(first, span);
+        return;
+    }
+
+    // Use the coarsest level whose blocks still fit in a column.
+    int level = -1;
+    while (level + 1 < min_idx_.size() && (2 << (level + 1)) <= span / columns) {
+        level++;
+    }
+    int block_size = 2 << level;
+    if (level < 0) block_size = 1;
+
+    QVector<QPair<int, int> > picks;
+    double key_lo = keys_[first];
+    double key_range = keys_[last] - key_lo;
+    int col = -1;
+    for (int blk = first / block_size; blk <= last / block_size; blk++) {
+        int b_min = level < 0 ? blk : min_idx_[level][blk];
+        int b_max = level < 0 ? blk : max_idx_[level][blk];
+        int b_col = 0;
+
+        if (key_range > 0) {
+            b_col = qMax(0, int((keys_[blk * block_size] - key_lo) * columns / key_range));
+        }
+        if (b_col != col) {
+            picks.append(qMakePair(b_min, b_max));
+            col = b_col;
+        } else {
+            if (low(b_min) < low(picks.last().first)) picks.last().first = b_min;
+            if (high(b_max) > high(picks.last().second)) picks.last().second = b_max;
+        }
+    }
+
+    for (int i = 0; i < picks.size(); i++) {
+        int p_min = picks[i].first;
+        int p_max = picks[i].second;
+
+        if (spans_.isEmpty()) {
+            keys.append(keys_[qMin(p_min, p_max)]);
+            values.append(values_[qMin(p_min, p_max)]);
+            if (p_min != p_max) {
+                keys.append(keys_[qMax(p_min, p_max)]);
+                values.append(values_[qMax(p_min, p_max)]);
+            }
+        } else {
+            double lo = low(p_min);
+            double hi = high(p_max);
+            keys.append(keys_[qMin(p_min, p_max)]);
+            values.append((lo + hi) / 2.0);
+            spans.append((hi - lo) / 2.0);
+        }
+    }
+}
+
+/*
+ * Editor modelines
+ *
+ * Local Variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * ex: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,88 @@
+/* graph_series.h
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef GRAPH_SERIES_H
+#define GRAPH_SERIES_H
+
+#include <QVector>
+
+/**
+ * @brief Full resolution data for a graph plus min/max pyramids, so that
+ * a plot only has to be handed a decimated copy of its visible key range.
+ */
+class GraphSeries
+{
+public:
+    GraphSeries() {}
+
+    /**
+     * @brief Set the data, sorting it by key if needed.
+     * @param keys Keys, usually time.
+     * @param values Values, or error bar centers.
+     * @param spans Error bar half heights, or empty for none.
+     */
+    void setData(const QVector<double> &keys, const QVector<double> &values, const QVector<double> &spans = QVector<double>());
+    void clear();
+    bool isEmpty() const { return keys_.isEmpty(); }
+    bool hasSpans() const { return !spans_.isEmpty(); }
+    const QVector<double> &keys() const { return keys_; }
+
+    /**
+     * @brief Fetch the points between lower and upper. If there are more
+     * than two per column, fetch the lowest and highest point of each column
+     * instead. Those are real points unless the series has spans, in which
+     * case each column gets one bar covering all of its own.
+     * @param lower Lowest key of interest.
+     * @param upper Highest key of interest.
+     * @param columns Number of columns, usually the plot width in pixels.
+     * @param keys [out] Keys.
+     * @param values [out] Values.
+     * @param spans [out] Spans, if hasSpans().
+     */
+    void decimate(double lower, double upper, int columns, QVector<double> &keys, QVector<double> &values, QVector<double> &spans) const;
+
+private:
+    QVector<double> keys_;
+    QVector<double> values_;
+    QVector<double> spans_;
+    // Level n holds the indexes of the lowest and highest points in
+    // each block of 2^(n+1) points.
+    QVector<QVector<int> > min_idx_;
+    QVector<QVector<int> > max_idx_;
+
+    double low(int idx) const { return spans_.isEmpty() ? values_[idx] : values_[idx] - spans_[idx]; }
+    double high(int idx) const { return spans_.isEmpty() ? values_[idx] : values_[idx] + spans_[idx]; }
+};
+
+#endif // GRAPH_SERIES_H
+
+/*
+ * Editor modelines
+ *
+ * Local Variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * ex: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
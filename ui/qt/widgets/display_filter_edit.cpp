@@ -361,6 +361,24 @@ void DisplayFilterEdit::updateBookmarkMenu()
 // - Popup does not appear when text is selected.
 // - Recent and saved display filters in popup when editing first word.
 
+struct CompletionFieldData {
+    const char *field_word;
+    bool with_dot;
+    QStringList *field_list;
+};
+
+static void completionFieldCallback(gpointer data, gpointer user_data)
+{
+    header_field_info *hfinfo = (header_field_info *) data;
+    CompletionFieldData *field_data = (CompletionFieldData *) user_data;
+
+    // Add fields only if we're past the protocol name.
+    if (hfinfo->parent != -1 && !field_data->with_dot) return;
+
+    // Don't complete the current word.
+    if (strcmp(hfinfo->abbrev, field_data->field_word)) *field_data->field_list << hfinfo->abbrev;
+}
+
 // ui/gtk/filter_autocomplete.c:build_autocompletion_list
 void DisplayFilterEdit::buildCompletionList(const QString &field_word)
 {
@@ -408,33 +426,10 @@ void DisplayFilterEdit::buildCompletionList(const QString &field_word)
     completion_model_->setStringList(complex_list);
     completer()->setCompletionPrefix(field_word);
 
-    void *proto_cookie;
     QStringList field_list;
-    int field_dots = field_word.count('.'); // Some protocol names (_ws.expert) contain periods.
-    for (int proto_id = proto_get_first_protocol(&proto_cookie); proto_id != -1; proto_id = proto_get_next_protocol(&proto_cookie)) {
-        protocol_t *protocol = find_protocol_by_id(proto_id);
-        if (!proto_is_protocol_enabled(protocol)) continue;
-
-        // Don't complete the current word.
-        const QString pfname = proto_get_protocol_filter_name(proto_id);
-        if (field_word.compare(pfname)) field_list << pfname;
-
-        // Add fields only if we're past the protocol name and only for the
-        // current protocol.
-        if (field_dots > pfname.count('.')) {
-            void *field_cookie;
-            const QByteArray fw_ba = field_word.toUtf8(); // or toLatin1 or toStdString?
-            const char *fw_utf8 = fw_ba.constData();
-            gsize fw_len = (gsize) strlen(fw_utf8);
-            for (header_field_info *hfinfo = proto_get_first_protocol_field(proto_id, &field_cookie); hfinfo; hfinfo = proto_get_next_protocol_field(proto_id, &field_cookie)) {
-                if (hfinfo->same_name_prev_id != -1) continue; // Ignore duplicate names.
-
-                if (!g_ascii_strncasecmp(fw_utf8, hfinfo->abbrev, fw_len)) {
-                    if ((gsize) strlen(hfinfo->abbrev) != fw_len) field_list << hfinfo->abbrev;
-                }
-            }
-        }
-    }
+    const QByteArray fw_ba = field_word.toUtf8(); // or toLatin1 or toStdString?
+    CompletionFieldData field_data = { fw_ba.constData(), field_word.contains('.'), &field_list };
+    proto_registrar_foreach_prefix(fw_ba.constData(), completionFieldCallback, &field_data);
     field_list.sort();
 
     completion_model_->setStringList(complex_list + field_list);
@@ -265,7 +265,7 @@ void WirelessTimeline::captureFileReadStarted(capture_file *cf)
 void WirelessTimeline::captureFileReadFinished()
 {
     /* All frames must be included in packet list */
-    if (cfile.count == 0 || g_hash_table_size(radio_packet_list) != cfile.count)
+    if (cfile.count == 0 || radio_packet_count != cfile.count)
         return;
 
     /* check that all frames have start and end tsf time and are reasonable time order.
@@ -339,6 +339,8 @@ WirelessTimeline::WirelessTimeline(QWidget *parent) : QWidget(parent)
     setMouseTracking(true);
 
     radio_packet_list = NULL;
+    radio_end_tsf = NULL;
+    radio_packet_count = 0;
     connect(wsApp, SIGNAL(appInitialized()), this, SLOT(appInitialized()));
 }
 
@@ -353,11 +355,14 @@ void WirelessTimeline::tap_timeline_reset(void* tapdata)
 
     if (timeline->radio_packet_list != NULL)
     {
-        g_hash_table_destroy(timeline->radio_packet_list);
+        g_ptr_array_free(timeline->radio_packet_list, TRUE);
+        g_array_free(timeline->radio_end_tsf, TRUE);
     }
     timeline->hide();
 
-    timeline->radio_packet_list = g_hash_table_new(g_direct_hash, g_direct_equal);
+    timeline->radio_packet_list = g_ptr_array_new();
+    timeline->radio_end_tsf = g_array_new(FALSE, TRUE, sizeof(guint64));
+    timeline->radio_packet_count = 0;
 }
 
 gboolean WirelessTimeline::tap_timeline_packet(void *tapdata, packet_info* pinfo, epan_dissect_t* edt _U_, const void *data)
@@ -365,14 +370,23 @@ gboolean WirelessTimeline::tap_timeline_packet(void *tapdata, packet_info* pinfo
     WirelessTimeline* timeline = (WirelessTimeline*)tapdata;
     struct wlan_radio *wlan_radio_info = (struct wlan_radio *)data;
 
-    /* Save the radio information in our own (GUI) hashtable */
-    g_hash_table_insert(timeline->radio_packet_list, GUINT_TO_POINTER(pinfo->num), wlan_radio_info);
+    /* Save the radio information in our own (GUI) per-frame arrays */
+    if (timeline->radio_packet_list->len <= pinfo->num) {
+        g_ptr_array_set_size(timeline->radio_packet_list, pinfo->num + 1);
+        g_array_set_size(timeline->radio_end_tsf, pinfo->num + 1);
+    }
+    if (g_ptr_array_index(timeline->radio_packet_list, pinfo->num) == NULL)
+        timeline->radio_packet_count++;
+    g_ptr_array_index(timeline->radio_packet_list, pinfo->num) = wlan_radio_info;
+    g_array_index(timeline->radio_end_tsf, guint64, pinfo->num) = wlan_radio_info->end_tsf;
     return FALSE;
 }
 
 struct wlan_radio* WirelessTimeline::get_wlan_radio(guint32 packet_num)
 {
-    return (struct wlan_radio*)g_hash_table_lookup(radio_packet_list, GUINT_TO_POINTER(packet_num));
+    if (radio_packet_list == NULL || packet_num >= radio_packet_list->len)
+        return NULL;
+    return (struct wlan_radio*)g_ptr_array_index(radio_packet_list, packet_num);
 }
 
 void WirelessTimeline::doToolTip(struct wlan_radio *wr, QPoint pos, int x)
@@ -465,8 +479,9 @@ int WirelessTimeline::find_packet_tsf(guint64 tsf)
     guint32 min_count = 1;
     guint32 max_count = cfile.count-1;
 
-    guint64 min_tsf = get_wlan_radio(min_count)->end_tsf;
-    guint64 max_tsf = get_wlan_radio(max_count)->end_tsf;
+    const guint64 *end_tsfs = (const guint64 *)(void *)radio_end_tsf->data;
+    guint64 min_tsf = end_tsfs[min_count];
+    guint64 max_tsf = end_tsfs[max_count];
 
     for (;;) {
         if (tsf >= max_tsf)
@@ -479,7 +494,7 @@ int WirelessTimeline::find_packet_tsf(guint64 tsf)
         if (middle == min_count)
             return middle+1;
 
-        guint64 middle_tsf = get_wlan_radio(middle)->end_tsf;
+        guint64 middle_tsf = end_tsfs[middle];
 
         if (tsf >= middle_tsf) {
             min_count = middle;
@@ -535,12 +550,13 @@ WirelessTimeline::paintEvent(QPaintEvent *qpe)
 
     QGraphicsScene qs;
     for (packet = find_packet_tsf(start_tsf + left/zoom - RENDER_EARLY); packet <= cfile.count; packet++) {
-        frame_data *fdata = frame_data_sequence_find(cfile.frames, packet);
-        struct wlan_radio *ri = get_wlan_radio(fdata->num);
+        struct wlan_radio *ri = get_wlan_radio(packet);
         float x, width, red, green, blue;
 
         if (ri == NULL) continue;
 
+        frame_data *fdata = frame_data_sequence_find(cfile.frames, packet);
+
         gint8 rssi = ri->aggregate ? ri->aggregate->rssi : ri->rssi;
         guint height = (rssi+100)/2;
         gint end_nav;
@@ -104,7 +104,11 @@ protected:
     struct wlan_radio *first, *last;
     capture_file *capfile;
 
-    GHashTable* radio_packet_list;
+    /* Indexed by frame number, so that lookups while painting are O(1)
+     * and the end times searched by find_packet_tsf are contiguous */
+    GPtrArray* radio_packet_list;
+    GArray* radio_end_tsf;
+    guint radio_packet_count;
 };
 
 #endif // WIRELESS_TIMELINE_H
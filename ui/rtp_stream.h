@@ -109,6 +109,8 @@ struct _rtpstream_tapinfo {
     rtp_stream_info_t *filter_stream_rev; /**< used as filter in some tap modes */
     FILE              *save_file;
     gboolean           is_registered; /**< if the tap listener is currently registered or not */
+    GHashTable        *strinfo_hash; /**< index of strinfo_list by addresses, ports and SSRC */
+    GList             *strinfo_tail; /**< last element of strinfo_list */
 };
 
 #if 0
@@ -77,6 +77,25 @@ static gint rtp_stream_info_cmp(gconstpointer aa, gconstpointer bb)
 		return 1;
 }
 
+/* GHashFunc for rtp_stream_info_cmp() */
+static guint rtp_stream_info_hash(gconstpointer key)
+{
+	const struct _rtp_stream_info* info = (const struct _rtp_stream_info*)key;
+	guint hash_val;
+
+	hash_val = info->ssrc;
+	hash_val = add_address_to_hash(hash_val, &info->src_addr);
+	hash_val = add_address_to_hash(hash_val, &info->dest_addr);
+	hash_val ^= (info->src_port << 16) | info->dest_port;
+
+	return hash_val;
+}
+
+static gboolean rtp_stream_info_equal(gconstpointer a, gconstpointer b)
+{
+	return rtp_stream_info_cmp(a, b) == 0;
+}
+
 
 /****************************************************************************/
 /* when there is a [re]reading of packet's */
@@ -94,6 +113,11 @@ void rtpstream_reset(rtpstream_tapinfo_t *tapinfo)
 		}
 		g_list_free(tapinfo->strinfo_list);
 		tapinfo->strinfo_list = NULL;
+		tapinfo->strinfo_tail = NULL;
+		if (tapinfo->strinfo_hash) {
+			g_hash_table_destroy(tapinfo->strinfo_hash);
+			tapinfo->strinfo_hash = NULL;
+		}
 		tapinfo->nstreams = 0;
 		tapinfo->npackets = 0;
 	}
@@ -203,33 +227,26 @@ int rtpstream_packet(void *arg, packet_info *pinfo, epan_dissect_t *edt _U_, con
 	const struct _rtp_info *rtpinfo = (const struct _rtp_info *)arg2;
 	rtp_stream_info_t new_stream_info;
 	rtp_stream_info_t *stream_info = NULL;
-	GList* list;
 	rtpdump_info_t rtpdump_info;
 
 	struct _rtp_conversation_info *p_conv_data = NULL;
 
-	/* gather infos on the stream this packet is part of */
+	/* gather infos on the stream this packet is part of; the addresses
+	   and payload type name are only copied if it's a new stream */
 	memset(&new_stream_info, 0, sizeof(rtp_stream_info_t));
-	copy_address(&(new_stream_info.src_addr), &(pinfo->src));
+	copy_address_shallow(&(new_stream_info.src_addr), &(pinfo->src));
 	new_stream_info.src_port = pinfo->srcport;
-	copy_address(&(new_stream_info.dest_addr), &(pinfo->dst));
+	copy_address_shallow(&(new_stream_info.dest_addr), &(pinfo->dst));
 	new_stream_info.dest_port = pinfo->destport;
 	new_stream_info.ssrc = rtpinfo->info_sync_src;
 	new_stream_info.payload_type = rtpinfo->info_payload_type;
-	new_stream_info.payload_type_name = g_strdup(rtpinfo->info_payload_type_str);
 
 	if (tapinfo->mode == TAP_ANALYSE) {
 		/* check whether we already have a stream with these parameters in the list */
-		list = g_list_first(tapinfo->strinfo_list);
-		while (list)
-		{
-			if (rtp_stream_info_cmp(&new_stream_info, (rtp_stream_info_t*)(list->data))==0)
-			{
-				stream_info = (rtp_stream_info_t*)(list->data);  /*found!*/
-				break;
-			}
-			list = g_list_next(list);
+		if (!tapinfo->strinfo_hash) {
+			tapinfo->strinfo_hash = g_hash_table_new(rtp_stream_info_hash, rtp_stream_info_equal);
 		}
+		stream_info = (rtp_stream_info_t *)g_hash_table_lookup(tapinfo->strinfo_hash, &new_stream_info);
 
 		/* not in the list? then create a new entry */
 		if (!stream_info) {
@@ -249,7 +266,17 @@ int rtpstream_packet(void *arg, packet_info *pinfo, epan_dissect_t *edt _U_, con
 
 			stream_info = g_new(rtp_stream_info_t,1);
 			*stream_info = new_stream_info;  /* memberwise copy of struct */
-			tapinfo->strinfo_list = g_list_append(tapinfo->strinfo_list, stream_info);
+			copy_address(&(stream_info->src_addr), &(pinfo->src));
+			copy_address(&(stream_info->dest_addr), &(pinfo->dst));
+			stream_info->payload_type_name = g_strdup(rtpinfo->info_payload_type_str);
+			/* append at the tail we keep rather than walking the list */
+			if (tapinfo->strinfo_tail) {
+				tapinfo->strinfo_tail = g_list_append(tapinfo->strinfo_tail, stream_info)->next;
+			} else {
+				tapinfo->strinfo_list = g_list_append(NULL, stream_info);
+				tapinfo->strinfo_tail = tapinfo->strinfo_list;
+			}
+			g_hash_table_insert(tapinfo->strinfo_hash, stream_info, stream_info);
 		}
 
 		/* get RTP stats for the packet */
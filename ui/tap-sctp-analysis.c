@@ -48,6 +48,8 @@
 #define ASSOC_NOT_FOUND                    10
 
 static sctp_allassocs_info_t sctp_tapinfo_struct = {0, NULL, FALSE, NULL};
+/* The members of sctp_tapinfo_struct.assoc_info_list by assoc_id */
+static GHashTable *assoc_info_by_id = NULL;
 
 static void
 free_first(gpointer data, gpointer user_data _U_)
@@ -162,6 +164,8 @@ reset(void *arg)
 	g_list_free(tapdata->assoc_info_list);
 	tapdata->sum_tvbs = 0;
 	tapdata->assoc_info_list = NULL;
+	if (assoc_info_by_id != NULL)
+		g_hash_table_remove_all(assoc_info_by_id);
 }
 
 
@@ -219,23 +223,10 @@ calc_checksum(const struct _sctp_info *check_data, sctp_assoc_info_t *data)
 static sctp_assoc_info_t *
 find_assoc(sctp_tmp_info_t *needle)
 {
-	sctp_allassocs_info_t *assoc_info;
-	sctp_assoc_info_t *info = NULL;
-	GList* list;
-
-	assoc_info = &sctp_tapinfo_struct;
-	if ((list = g_list_last(assoc_info->assoc_info_list))!=NULL)
-	{
-		while (list)
-		{
-			info = (sctp_assoc_info_t*)(list->data);
-			if (needle->assoc_id == info->assoc_id)
-				return info;
+	if (assoc_info_by_id == NULL)
+		return NULL;
 
-			list = g_list_previous(list);
-		}
-	}
-	return NULL;
+	return (sctp_assoc_info_t *)g_hash_table_lookup(assoc_info_by_id, GUINT_TO_POINTER(needle->assoc_id));
 }
 
 static sctp_assoc_info_t *
@@ -762,6 +753,9 @@ packet(void *tapdata _U_, packet_info *pinfo, epan_dissect_t *edt _U_, const voi
 				if (sackchunk == TRUE)
 					info->sack2 = g_list_prepend(info->sack2, sack);
 				sctp_tapinfo_struct.assoc_info_list = g_list_append(sctp_tapinfo_struct.assoc_info_list, info);
+				if (assoc_info_by_id == NULL)
+					assoc_info_by_id = g_hash_table_new(g_direct_hash, g_direct_equal);
+				g_hash_table_insert(assoc_info_by_id, GUINT_TO_POINTER(info->assoc_id), info);
 			}
 			else
 			{
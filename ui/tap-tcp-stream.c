@@ -44,7 +44,7 @@ typedef struct _tcp_scan_t {
     struct segment         *current;
     int                     direction;
     struct tcp_graph       *tg;
-    struct segment         *last;
+    GArray                 *segments;   /* struct segment, linked once the scan is done */
 } tcp_scan_t;
 
 
@@ -74,7 +74,10 @@ tapall_tcpip_packet(void *pct, packet_info *pinfo, epan_dissect_t *edt _U_, cons
                         ts->direction)
         && tg->stream == tcphdr->th_stream)
     {
-        struct segment *segment = (struct segment *)g_malloc(sizeof(struct segment));
+        struct segment *segment;
+
+        g_array_set_size(ts->segments, ts->segments->len + 1);
+        segment = &g_array_index(ts->segments, struct segment, ts->segments->len - 1);
         segment->next      = NULL;
         segment->num       = pinfo->num;
         segment->rel_secs  = (guint32)pinfo->rel_ts.secs;
@@ -99,13 +102,6 @@ tapall_tcpip_packet(void *pct, packet_info *pinfo, epan_dissect_t *edt _U_, cons
             memcpy(&segment->sack_left_edge, &tcphdr->sack_left_edge, sizeof(segment->sack_left_edge));
             memcpy(&segment->sack_right_edge, &tcphdr->sack_right_edge, sizeof(segment->sack_right_edge));
         }
-
-        if (ts->tg->segments) {
-            ts->last->next = segment;
-        } else {
-            ts->tg->segments = segment;
-        }
-        ts->last = segment;
     }
 
     return FALSE;
@@ -118,6 +114,8 @@ graph_segment_list_get(capture_file *cf, struct tcp_graph *tg, gboolean stream_k
     struct segment current;
     GString    *error_string;
     tcp_scan_t  ts;
+    const guint32 *frames;
+    guint32     frames_count, i;
 
     g_log(NULL, G_LOG_LEVEL_DEBUG, "graph_segment_list_get()");
 
@@ -148,7 +146,7 @@ graph_segment_list_get(capture_file *cf, struct tcp_graph *tg, gboolean stream_k
      */
     ts.current = &current;
     ts.tg      = tg;
-    ts.last    = NULL;
+    ts.segments = g_array_new(FALSE, FALSE, sizeof(struct segment));
     error_string = register_tap_listener("tcp", &ts, "tcp", 0, NULL, tapall_tcpip_packet, NULL);
     if (error_string) {
         fprintf(stderr, "wireshark: Couldn't register tcp_graph tap: %s\n",
@@ -156,20 +154,40 @@ graph_segment_list_get(capture_file *cf, struct tcp_graph *tg, gboolean stream_k
         g_string_free(error_string, TRUE);
         exit(1);   /* XXX: fix this */
     }
-    cf_retap_packets(cf);
+    /*
+     * TCP knows which frames carry the stream, so if nobody else is
+     * listening only those need to be dissected again.
+     */
+    frames = NULL;
+    frames_count = 0;
+    if (!tap_listeners_require_dissection_except(&ts)) {
+        frames = get_tcp_stream_frames(tg->stream, &frames_count);
+    }
+    if (frames != NULL) {
+        cf_retap_frames(cf, frames, frames_count);
+    } else {
+        cf_retap_packets(cf);
+    }
     remove_tap_listener(&ts);
+
+    /* The segments are in one block, so they can be linked now */
+    for (i = 1; i < ts.segments->len; i++) {
+        g_array_index(ts.segments, struct segment, i - 1).next =
+            &g_array_index(ts.segments, struct segment, i);
+    }
+    if (ts.segments->len > 0) {
+        tg->segments = (struct segment *)g_array_free(ts.segments, FALSE);
+    } else {
+        g_array_free(ts.segments, TRUE);
+        tg->segments = NULL;
+    }
 }
 
 void
 graph_segment_list_free(struct tcp_graph *tg)
 {
-    struct segment *segment;
-
-    while (tg->segments) {
-        segment = tg->segments->next;
-        g_free(tg->segments);
-        tg->segments = segment;
-    }
+    /* graph_segment_list_get() allocates them in one block */
+    g_free(tg->segments);
     tg->segments = NULL;
 }
 
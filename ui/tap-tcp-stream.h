@@ -73,7 +73,7 @@ struct tcp_graph {
     guint16          dst_port;
     guint32          stream;
     /* Should this be a map or tree instead? */
-    struct segment  *segments;
+    struct segment  *segments;  /* linked, but allocated as one array by graph_segment_list_get() */
 };
 
 /** Fill in the segment list for a TCP graph
@@ -295,9 +295,11 @@ voip_calls_reset_all_taps(voip_calls_tapinfo_t *tapinfo)
         list = g_list_next(list);
     }
     g_queue_clear(tapinfo->callsinfos);
-    /* free the SIP_HASH */
+    /* free the SIP_HASH and H225_HASH */
     if(NULL!=tapinfo->callsinfo_hashtable[SIP_HASH])
         g_hash_table_remove_all (tapinfo->callsinfo_hashtable[SIP_HASH]);
+    if(NULL!=tapinfo->callsinfo_hashtable[H225_HASH])
+        g_hash_table_remove_all (tapinfo->callsinfo_hashtable[H225_HASH]);
 
     /* free the strinfo data items first */
     list = g_list_first(tapinfo->rtp_stream_list);
@@ -310,6 +312,8 @@ voip_calls_reset_all_taps(voip_calls_tapinfo_t *tapinfo)
     }
     g_list_free(tapinfo->rtp_stream_list);
     tapinfo->rtp_stream_list = NULL;
+    if (tapinfo->rtp_stream_hashtable)
+        g_hash_table_remove_all(tapinfo->rtp_stream_hashtable);
 
     if (tapinfo->h245_labels) {
         memset(tapinfo->h245_labels, 0, sizeof(h245_labels_t));
@@ -577,6 +581,8 @@ rtp_reset(void *tap_offset_ptr)
     }
     g_list_free(tapinfo->rtp_stream_list);
     tapinfo->rtp_stream_list = NULL;
+    if (tapinfo->rtp_stream_hashtable)
+        g_hash_table_remove_all(tapinfo->rtp_stream_hashtable);
     tapinfo->nrtp_streams = 0;
 
     if (tapinfo->tap_reset) {
@@ -586,6 +592,26 @@ rtp_reset(void *tap_offset_ptr)
     return;
 }
 
+/****************************************************************************/
+/* rtp_stream_hashtable is keyed by the setup frame and SSRC of its streams */
+static guint
+rtp_stream_setup_hash(gconstpointer key)
+{
+    const rtp_stream_info_t *strinfo = (const rtp_stream_info_t *)key;
+
+    return strinfo->setup_frame_number ^ strinfo->ssrc;
+}
+
+static gboolean
+rtp_stream_setup_equal(gconstpointer a, gconstpointer b)
+{
+    const rtp_stream_info_t *strinfo_a = (const rtp_stream_info_t *)a;
+    const rtp_stream_info_t *strinfo_b = (const rtp_stream_info_t *)b;
+
+    return strinfo_a->setup_frame_number == strinfo_b->setup_frame_number
+        && strinfo_a->ssrc == strinfo_b->ssrc;
+}
+
 /****************************************************************************/
 /* whenever a RTP packet is seen by the tap listener */
 static gboolean
@@ -594,7 +620,7 @@ rtp_packet(void *tap_offset_ptr, packet_info *pinfo, epan_dissect_t *edt, void c
     voip_calls_tapinfo_t *tapinfo = tap_id_to_base(tap_offset_ptr, tap_id_offset_rtp_);
     rtp_stream_info_t    *tmp_listinfo;
     rtp_stream_info_t    *strinfo = NULL;
-    GList                *list;
+    rtp_stream_info_t     key;
     struct _rtp_conversation_info *p_conv_data = NULL;
 
     const struct _rtp_info *rtp_info = (const struct _rtp_info *)rtp_info_ptr;
@@ -608,13 +634,16 @@ rtp_packet(void *tap_offset_ptr, packet_info *pinfo, epan_dissect_t *edt, void c
         tapinfo->tap_packet(tapinfo, pinfo, edt, rtp_info_ptr);
     }
 
-    /* check whether we already have a RTP stream with this setup frame and ssrc in the list */
-    list = g_list_first(tapinfo->rtp_stream_list);
-    while (list)
-    {
-        tmp_listinfo=(rtp_stream_info_t *)list->data;
-        if ( (tmp_listinfo->setup_frame_number == rtp_info->info_setup_frame_num)
-                && (tmp_listinfo->ssrc == rtp_info->info_sync_src) && (tmp_listinfo->end_stream == FALSE)) {
+    /* check whether we already have a RTP stream with this setup frame and ssrc in the list;
+       there is at most one that hasn't ended, and that's the one in the hash */
+    if (!tapinfo->rtp_stream_hashtable) {
+        tapinfo->rtp_stream_hashtable = g_hash_table_new(rtp_stream_setup_hash, rtp_stream_setup_equal);
+    }
+    key.setup_frame_number = rtp_info->info_setup_frame_num;
+    key.ssrc = rtp_info->info_sync_src;
+    tmp_listinfo = (rtp_stream_info_t *)g_hash_table_lookup(tapinfo->rtp_stream_hashtable, &key);
+    if (tmp_listinfo) {
+        if (tmp_listinfo->end_stream == FALSE) {
             /* if the payload type has changed, we mark the stream as finished to create a new one
                this is to show multiple payload changes in the Graph for example for DTMF RFC2833 */
             if ( tmp_listinfo->payload_type != rtp_info->info_payload_type ) {
@@ -628,11 +657,9 @@ rtp_packet(void *tap_offset_ptr, packet_info *pinfo, epan_dissect_t *edt, void c
             /* if ed137_info has changed, create new stream */
                 tmp_listinfo->end_stream = TRUE;
             } else {
-                strinfo = (rtp_stream_info_t*)(list->data);
-                break;
+                strinfo = tmp_listinfo;
             }
         }
-        list = g_list_next(list);
     }
 
     /* if this is a duplicated RTP Event End, just return */
@@ -673,6 +700,8 @@ rtp_packet(void *tap_offset_ptr, packet_info *pinfo, epan_dissect_t *edt, void c
             strinfo->ed137_info = NULL;
         }
         tapinfo->rtp_stream_list = g_list_prepend(tapinfo->rtp_stream_list, strinfo);
+        /* any stream it replaces in the hash has ended */
+        g_hash_table_replace(tapinfo->rtp_stream_hashtable, strinfo, strinfo);
     }
 
     /* Add the info to the existing RTP stream */
@@ -1922,6 +1951,26 @@ free_h225_info(gpointer p) {
 
     g_free(p);
 }
+/****************************************************************************/
+/* the H225_HASH is keyed by the GUID_LEN bytes of the h323_calls_info_t guid */
+static guint
+h225_guid_hash(gconstpointer key)
+{
+    const guint8 *p = (const guint8 *)key;
+    guint32 hash = 0;
+    int i;
+
+    for (i = 0; i < GUID_LEN; i++)
+        hash = (hash << 5) - hash + p[i];
+    return hash;
+}
+
+static gboolean
+h225_guid_equal(gconstpointer a, gconstpointer b)
+{
+    return memcmp(a, b, GUID_LEN) == 0;
+}
+
 /****************************************************************************/
 /* whenever a H225 packet is seen by the tap listener */
 static gboolean
@@ -1964,21 +2013,10 @@ h225_calls_packet(void *tap_offset_ptr, packet_info *pinfo, epan_dissect_t *edt,
             }
             list = g_list_next (list);
         }
-    } else {
-        /* check whether we already have a call with this guid in the list */
-        list = g_queue_peek_nth_link(tapinfo->callsinfos, 0);
-        while (list)
-        {
-            tmp_listinfo=(voip_calls_info_t *)list->data;
-            if (tmp_listinfo->protocol == VOIP_H323) {
-                tmp_h323info = (h323_calls_info_t *)tmp_listinfo->prot_info;
-                g_assert(tmp_h323info != NULL);
-                if ( (memcmp(tmp_h323info->guid, &guid_allzero, GUID_LEN) != 0) && (memcmp(tmp_h323info->guid, &pi->guid,GUID_LEN)==0) ) {
-                    callsinfo = (voip_calls_info_t*)(list->data);
-                    break;
-                }
-            }
-            list = g_list_next (list);
+    } else if (memcmp(&pi->guid, &guid_allzero, GUID_LEN) != 0) {
+        /* check whether we already have a call with this guid in the H225_HASH */
+        if (tapinfo->callsinfo_hashtable[H225_HASH]) {
+            callsinfo = (voip_calls_info_t *)g_hash_table_lookup(tapinfo->callsinfo_hashtable[H225_HASH], &pi->guid);
         }
     }
 
@@ -2018,6 +2056,17 @@ h225_calls_packet(void *tap_offset_ptr, packet_info *pinfo, epan_dissect_t *edt,
         callsinfo->npackets = 0;
 
         g_queue_push_tail(tapinfo->callsinfos, callsinfo);
+
+        /* insert the call information in the H225_HASH; if a LCF/LRJ gave us a
+           second call with the same guid, keep finding the first one */
+        if (memcmp(tmp_h323info->guid, &guid_allzero, GUID_LEN) != 0) {
+            if (NULL == tapinfo->callsinfo_hashtable[H225_HASH]) {
+                tapinfo->callsinfo_hashtable[H225_HASH] = g_hash_table_new(h225_guid_hash, h225_guid_equal);
+            }
+            if (!g_hash_table_lookup(tapinfo->callsinfo_hashtable[H225_HASH], tmp_h323info->guid)) {
+                g_hash_table_insert(tapinfo->callsinfo_hashtable[H225_HASH], tmp_h323info->guid, callsinfo);
+            }
+        }
     }
 
     tapinfo->h225_frame_num = pinfo->num;
@@ -75,7 +75,9 @@ typedef enum _voip_protocol {
 } voip_protocol;
 
 typedef enum _hash_indexes {
-    SIP_HASH=0
+    SIP_HASH=0,
+    H225_HASH,
+    NUM_HASH_INDEXES
 } hash_indexes;
 
 extern const char *voip_protocol_name[];
@@ -189,7 +191,7 @@ typedef struct _voip_calls_tapinfo {
     void                 *tap_data; /**< data for tap callbacks */
     int                   ncalls; /**< number of call */
     GQueue*               callsinfos; /**< queue with all calls (voip_calls_info_t) */
-    GHashTable*           callsinfo_hashtable[1]; /**< array of hashes per voip protocol (voip_calls_info_t); currently only the one for SIP is used */
+    GHashTable*           callsinfo_hashtable[NUM_HASH_INDEXES]; /**< array of hashes per voip protocol (voip_calls_info_t); SIP by call id and H.225 by GUID */
     int                   npackets; /**< total number of packets of all calls */
     voip_calls_info_t    *filter_calls_fwd; /**< used as filter in some tap modes */
     int                   start_packets;
@@ -224,6 +226,7 @@ typedef struct _voip_calls_tapinfo {
     gint32                actrace_direction;
     flow_show_options     fs_option;
     guint32               redraw;
+    GHashTable*           rtp_stream_hashtable; /**< rtp_stream_list streams which haven't ended, by setup frame and SSRC */
 } voip_calls_tapinfo_t;
 
 #if 0
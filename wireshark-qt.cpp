@@ -637,6 +637,8 @@ int main(int argc, char *qt_argv[])
         ret_val = INIT_FAILED;
         goto clean_exit;
     }
+    /* So that Decode As changes needn't always redissect */
+    dissector_set_lookup_tracking(TRUE);
 #ifdef DEBUG_STARTUP_TIME
     /* epan_init resets the preferences */
     prefs.console_log_level = DEBUG_STARTUP_TIME_LOGLEVEL;
@@ -273,6 +273,8 @@ erf_t *erf_priv_create(void)
   erf_priv = (erf_t*) g_malloc(sizeof(erf_t));
   erf_priv->anchor_map = g_hash_table_new_full(erf_anchor_mapping_hash, erf_anchor_mapping_equal, erf_anchor_mapping_destroy, NULL);
   erf_priv->if_map = g_hash_table_new_full(erf_if_mapping_hash, erf_if_mapping_equal, erf_if_mapping_destroy, NULL);
+  erf_priv->if_map_cache_host_id = ERF_META_HOST_ID_IMPLICIT;
+  memset(erf_priv->if_map_cache, 0, sizeof(erf_priv->if_map_cache));
   erf_priv->implicit_host_id = ERF_META_HOST_ID_IMPLICIT;
   erf_priv->capture_gentime = 0;
   erf_priv->host_gentime = 0;
@@ -2157,15 +2159,30 @@ int erf_populate_interface_from_header(erf_t *erf_priv, wtap *wth, union wtap_ps
 static struct erf_if_mapping* erf_find_interface_mapping(erf_t *erf_priv, guint64 host_id, guint8 source_id)
 {
   struct erf_if_mapping if_map_lookup;
+  struct erf_if_mapping* if_map;
 
   /* XXX: erf_priv should never be NULL here */
   if (!erf_priv)
     return NULL;
 
+  if (host_id == erf_priv->if_map_cache_host_id && erf_priv->if_map_cache[source_id])
+    return erf_priv->if_map_cache[source_id];
+
   if_map_lookup.host_id = host_id;
   if_map_lookup.source_id = source_id;
 
-  return (struct erf_if_mapping*) g_hash_table_lookup(erf_priv->if_map, &if_map_lookup);
+  if_map = (struct erf_if_mapping*) g_hash_table_lookup(erf_priv->if_map, &if_map_lookup);
+
+  if (if_map) {
+    /* Cache the mappings of the Host ID we saw last */
+    if (host_id != erf_priv->if_map_cache_host_id) {
+      memset(erf_priv->if_map_cache, 0, sizeof(erf_priv->if_map_cache));
+      erf_priv->if_map_cache_host_id = host_id;
+    }
+    erf_priv->if_map_cache[source_id] = if_map;
+  }
+
+  return if_map;
 }
 
 static void erf_set_interface_descr(wtap_block_t block, guint option_id, guint64 host_id, guint8 source_id, guint8 if_num, const gchar *descr)
@@ -2313,6 +2330,9 @@ static int erf_update_implicit_host_id(erf_t *erf_priv, wtap *wth, guint64 impli
 
   erf_priv->implicit_host_id = implicit_host_id;
 
+  /* The implicit mappings are about to change Host ID */
+  memset(erf_priv->if_map_cache, 0, sizeof(erf_priv->if_map_cache));
+
   /*
    * We need to update the descriptions of all the interfaces with no Host
    * ID to the correct Host ID.
@@ -348,8 +348,16 @@ union erf_subhdr {
   struct erf_eth_hdr eth_hdr;
 };
 
+struct erf_if_mapping;
+
 typedef struct {
   GHashTable* if_map;
+  /*
+   * The if_map entries for one Host ID, indexed by Source ID, so that
+   * the mapping for most records is found without hashing.
+   */
+  guint64 if_map_cache_host_id;
+  struct erf_if_mapping* if_map_cache[256];
   GHashTable* anchor_map;
   guint64 implicit_host_id;
   guint64 capture_gentime;
@@ -1105,6 +1105,12 @@ fail:
 	return NULL;
 
 success:
+	/*
+	 * The open routines are done looking around in the file, so
+	 * if it's compressed, start decompressing it ahead of the reads.
+	 */
+	file_set_read_ahead(wth->fh);
+
 	wth->frame_buffer = (struct Buffer *)g_malloc(sizeof(struct Buffer));
 	ws_buffer_init(wth->frame_buffer, 1500);
 
@@ -1163,6 +1169,13 @@ wtap_fdreopen(wtap *wth, const char *filename, int *err)
 		return FALSE;
 	}
 
+	/*
+	 * A wtap reading other wtaps, such as a virtual merge of
+	 * several files, has no descriptor of its own to reopen.
+	 */
+	if (wth->random_fh == NULL)
+		return TRUE;
+
 	/* First, make sure the file is valid */
 	if (ws_stat64(filename, &statb) < 0) {
 		*err = errno;
@@ -2621,6 +2634,31 @@ gboolean wtap_dump_get_needs_reload(wtap_dumper *wdh) {
         return wdh->needs_reload;
 }
 
+/*
+ * Size of the stdio buffer of uncompressed files opened by name.  The
+ * default of a few KB means a write() every couple of records, which
+ * is much of the time editcap takes to split or convert a big file.
+ * Files opened from a descriptor keep the default, as that's how we
+ * write to pipes where records shouldn't sit in a buffer.
+ */
+#define WTAP_DUMP_WRITE_BUF_SIZE	(256 * 1024)
+
+static FILE *
+wtap_dump_file_fopen(wtap_dumper *wdh, const char *filename)
+{
+	FILE *fh;
+
+	fh = ws_fopen(filename, "wb");
+	if (fh != NULL) {
+		wdh->write_buf = (char *)g_malloc(WTAP_DUMP_WRITE_BUF_SIZE);
+		if (setvbuf(fh, wdh->write_buf, _IOFBF, WTAP_DUMP_WRITE_BUF_SIZE) != 0) {
+			g_free(wdh->write_buf);
+			wdh->write_buf = NULL;
+		}
+	}
+	return fh;
+}
+
 /* internally open a file for writing (compressed or not) */
 #ifdef HAVE_ZLIB
 static WFILE_T
@@ -2629,14 +2667,14 @@ wtap_dump_file_open(wtap_dumper *wdh, const char *filename)
 	if(wdh->compressed) {
 		return gzwfile_open(filename);
 	} else {
-		return ws_fopen(filename, "wb");
+		return wtap_dump_file_fopen(wdh, filename);
 	}
 }
 #else
 static WFILE_T
-wtap_dump_file_open(wtap_dumper *wdh _U_, const char *filename)
+wtap_dump_file_open(wtap_dumper *wdh, const char *filename)
 {
-	return ws_fopen(filename, "wb");
+	return wtap_dump_file_fopen(wdh, filename);
 }
 #endif
 
@@ -2699,12 +2737,20 @@ wtap_dump_file_write(wtap_dumper *wdh, const void *buf, size_t bufsize, int *err
 static int
 wtap_dump_file_close(wtap_dumper *wdh)
 {
+	int ret;
+
 #ifdef HAVE_ZLIB
 	if(wdh->compressed)
 		return gzwfile_close((GZWFILE_T)wdh->fh);
 	else
 #endif
-		return fclose((FILE *)wdh->fh);
+	{
+		ret = fclose((FILE *)wdh->fh);
+		/* The buffer mustn't go before the stream that uses it */
+		g_free(wdh->write_buf);
+		wdh->write_buf = NULL;
+		return ret;
+	}
 }
 
 gint64
@@ -46,12 +46,33 @@
 #include "wtap-int.h"
 #include "file_wrappers.h"
 #include <wsutil/file_util.h>
+#include <wsutil/pint.h>
 
 #ifdef HAVE_ZLIB
 #define ZLIB_CONST
 #include <zlib.h>
 #endif /* HAVE_ZLIB */
 
+#ifdef HAVE_LZ4
+#include <lz4.h>
+#if LZ4_VERSION_NUMBER >= 10301
+#include <lz4frame.h>
+#define USE_LZ4
+#endif /* LZ4_VERSION_NUMBER >= 10301 */
+#endif /* HAVE_LZ4 */
+
+/*
+ * On machines with more than one processor, the sequential stream of a
+ * compressed file is decompressed by a separate thread, ahead of the
+ * code parsing the records in it; see file_set_read_ahead().
+ */
+#if GLIB_CHECK_VERSION(2,36,0) && (defined(HAVE_ZLIB) || defined(USE_LZ4))
+#define USE_READ_AHEAD
+#define HAS_READ_AHEAD(state) ((state)->read_ahead != NULL)
+#else
+#define HAS_READ_AHEAD(state) FALSE
+#endif
+
 /*
  * See RFC 1952 for a description of the gzip file format.
  *
@@ -60,6 +81,11 @@
  *      XZ format: http://tukaani.org/xz/
  *
  *      Bzip2 format: http://bzip.org/
+ *
+ * We also read the LZ4 frame format, as written by the lz4 command
+ * line tool, which decompresses several times faster than gzip:
+ *
+ *      https://github.com/lz4/lz4/blob/dev/doc/lz4_Frame_format.md
  */
 
 /*
@@ -71,6 +97,9 @@
 const char *compressed_file_extension_table[] = {
 #ifdef HAVE_ZLIB
     "gz",
+#endif
+#ifdef USE_LZ4
+    "lz4",
 #endif
     NULL
 };
@@ -78,13 +107,24 @@ const char *compressed_file_extension_table[] = {
 /* #define GZBUFSIZE 8192 */
 #define GZBUFSIZE 4096
 
+/*
+ * Minimum buffer size for regular files.  Reading a large capture file
+ * st_blksize bytes at a time costs a system call every few packets;
+ * we don't do this for pipes, as raw_read() waits until it has filled
+ * the buffer.
+ */
+#define REGULAR_FILE_BUFSIZE 65536
+
 /* values for wtap_reader compression */
 typedef enum {
     UNKNOWN,       /* unknown - look for a gzip header */
     UNCOMPRESSED,  /* uncompressed - copy input directly */
 #ifdef HAVE_ZLIB
     ZLIB,          /* decompress a zlib stream */
-    GZIP_AFTER_HEADER
+    GZIP_AFTER_HEADER,
+#endif
+#ifdef USE_LZ4
+    LZ4,           /* decompress an LZ4 frame */
 #endif
 } compression_t;
 
@@ -116,10 +156,17 @@ struct wtap_reader {
     /* zlib inflate stream */
     z_stream strm;             /* stream structure in-place (not a pointer) */
     gboolean dont_check_crc;   /* TRUE if we aren't supposed to check the CRC */
+#endif
+#ifdef USE_LZ4
+    LZ4F_decompressionContext_t lz4_ctx;
 #endif
     /* fast seeking */
     GPtrArray *fast_seek;
     void *fast_seek_cur;
+    gint64 fast_seek_span;     /* uncompressed bytes between zlib seek points */
+#ifdef USE_READ_AHEAD
+    struct read_ahead *read_ahead; /* decompression thread, if any */
+#endif
 };
 
 static int     /* gz_load */
@@ -185,6 +232,7 @@ struct zlib_cur_seek_point {
     unsigned int have;
 };
 
+/* Default for fast_seek_span */
 #define SPAN G_GINT64_CONSTANT(1048576)
 static struct fast_seek_point *
 fast_seek_find(FILE_T file, gint64 pos)
@@ -392,7 +440,7 @@ zlib_fast_seek_add(FILE_T file, struct zlib_cur_seek_point *point, int bits, gin
      *      Inserting value in middle of sorted array is expensive, so we want to add only in the end.
      *      It's not big deal, cause first-read don't usually invoke seeking
      */
-    if (item->out + SPAN < out_pos) {
+    if (item->out + file->fast_seek_span < out_pos) {
         struct fast_seek_point *val = g_new(struct fast_seek_point,1);
         val->in = in_pos;
         val->out = out_pos;
@@ -560,9 +608,79 @@ DIAG_ON(cast-qual)
 }
 #endif
 
+#ifdef USE_LZ4
+static void
+lz4_read(FILE_T state, unsigned char *buf, unsigned int count)
+{
+    unsigned int have = 0;
+    size_t out_len, in_len, ret;
+
+    /* fill output buffer up to end of frame or error */
+    while (have < count) {
+        if (state->avail_in == 0 && fill_in_buffer(state) == -1)
+            break;
+        if (state->avail_in == 0) {
+            /* EOF */
+            state->err = WTAP_ERR_SHORT_READ;
+            state->err_info = NULL;
+            break;
+        }
+
+        out_len = count - have;
+        in_len = state->avail_in;
+        ret = LZ4F_decompress(state->lz4_ctx, buf + have, &out_len,
+                              state->next_in, &in_len, NULL);
+        state->next_in += in_len;
+        state->avail_in -= (guint)in_len;
+        have += (unsigned int)out_len;
+        if (LZ4F_isError(ret)) {
+            state->err = WTAP_ERR_DECOMPRESS;
+            state->err_info = LZ4F_getErrorName(ret);
+            break;
+        }
+        if (ret == 0) {
+            /* end of frame; there may be another one after it */
+            state->compression = UNKNOWN;
+            break;
+        }
+    }
+
+    state->next = buf;
+    state->have = have;
+}
+
+/* Is there an LZ4 frame, with the magic number 0x184D2204, next? */
+static int
+lz4_check_magic(FILE_T state, gboolean *is_lz4)
+{
+    static const unsigned char lz4_magic[4] = { 0x04, 0x22, 0x4D, 0x18 };
+
+    *is_lz4 = FALSE;
+    if (state->avail_in < sizeof lz4_magic && !state->eof) {
+        guint got;
+
+        /* The magic number straddles a buffer boundary; get the rest */
+        memmove(state->in, state->next_in, state->avail_in);
+        if (raw_read(state, state->in + state->avail_in,
+                     state->size - state->avail_in, &got) == -1)
+            return -1;
+        state->avail_in += got;
+        state->next_in = state->in;
+    }
+    if (state->avail_in >= sizeof lz4_magic &&
+        memcmp(state->next_in, lz4_magic, sizeof lz4_magic) == 0)
+        *is_lz4 = TRUE;
+    return 0;
+}
+#endif
+
 static int
 gz_head(FILE_T state)
 {
+#ifdef USE_LZ4
+    gboolean is_lz4;
+#endif
+
     /* get some data in the input buffer */
     if (state->avail_in == 0) {
         if (fill_in_buffer(state) == -1)
@@ -571,6 +689,28 @@ gz_head(FILE_T state)
             return 0;
     }
 
+#ifdef USE_LZ4
+    if (lz4_check_magic(state, &is_lz4) == -1)
+        return -1;
+    if (is_lz4) {
+        /*
+         * Start over with a fresh context; the old one may be in the
+         * middle of a frame if we've sought back to the beginning.
+         */
+        LZ4F_freeDecompressionContext(state->lz4_ctx);
+        if (LZ4F_isError(LZ4F_createDecompressionContext(&state->lz4_ctx, LZ4F_VERSION))) {
+            state->lz4_ctx = NULL;
+            state->err = ENOMEM;
+            state->err_info = NULL;
+            return -1;
+        }
+        /* LZ4F_decompress() reads the frame header itself */
+        state->compression = LZ4;
+        state->is_compressed = TRUE;
+        return 0;
+    }
+#endif
+
     /* look for the gzip magic header bytes 31 and 139 */
 #ifdef HAVE_ZLIB
     if (state->next_in[0] == 31) {
@@ -691,9 +831,295 @@ gz_head(FILE_T state)
     return 0;
 }
 
+#ifdef USE_READ_AHEAD
+/*
+ * Read-ahead.
+ *
+ * Inflating a gzipped capture costs several times as much as reading
+ * it, and it's done on the same thread that parses the records.  For
+ * the sequential stream we can instead hand the decompression to a
+ * thread of its own, reading through a second wtap_reader ("inner")
+ * that shares our file descriptor, and passing the output back to us
+ * in a small ring of buffers of the same size as our output buffer.
+ * Taking one swaps it with our output buffer, so everything else in
+ * here still sees the data at state->out.
+ *
+ * Seek points found by the thread are passed back with the data and
+ * added to the shared fast seek array from our side, so that that array
+ * is only ever touched from the thread that owns the wtap.
+ */
+#define READ_AHEAD_CHUNKS 16
+
+typedef struct {
+    unsigned char *data;
+    guint len;                 /* 0 if the thread stopped here */
+    int err;                   /* why it stopped, or 0 at EOF */
+    const char *err_info;
+    gint64 raw_pos;            /* inner->raw_pos after this data */
+    GPtrArray *points;         /* fast seek points found, or NULL */
+} read_ahead_chunk;
+
+struct read_ahead {
+    FILE_T inner;              /* the thread's reader */
+    GThread *thread;
+    gboolean running;
+    GAsyncQueue *full;         /* chunks of data for us */
+    GAsyncQueue *empty;        /* chunks for the thread to fill */
+    guint chunk_size;          /* which is the size of our output buffer */
+    read_ahead_chunk chunks[READ_AHEAD_CHUNKS];
+    /*
+     * The thread's fast seek points.  They start with a copy of the
+     * last point we knew about when it was started, so that it
+     * doesn't add points we already have.
+     */
+    GPtrArray *points;
+    guint points_known;
+    struct fast_seek_point last_point;
+};
+
+/* Queued to tell the thread to stop. */
+static read_ahead_chunk read_ahead_stop_chunk;
+
+static void
+read_ahead_take_points(struct read_ahead *ra, read_ahead_chunk *chunk)
+{
+    GPtrArray *points = ra->inner->fast_seek;
+    guint i;
+
+    chunk->points = NULL;
+    if (points == NULL || points->len <= ra->points_known)
+        return;
+
+    chunk->points = g_ptr_array_sized_new(points->len - ra->points_known);
+    for (i = ra->points_known; i < points->len; i++)
+        g_ptr_array_add(chunk->points, points->pdata[i]);
+    memcpy(&ra->last_point, points->pdata[points->len - 1], sizeof ra->last_point);
+    g_ptr_array_set_size(points, 0);
+    g_ptr_array_add(points, &ra->last_point);
+    ra->points_known = 1;
+}
+
+static void
+read_ahead_give_points(FILE_T state, read_ahead_chunk *chunk)
+{
+    struct fast_seek_point *item, *last;
+    guint i;
+
+    if (chunk->points == NULL)
+        return;
+
+    for (i = 0; i < chunk->points->len; i++) {
+        item = (struct fast_seek_point *)chunk->points->pdata[i];
+        last = NULL;
+        if (state->fast_seek != NULL && state->fast_seek->len != 0)
+            last = (struct fast_seek_point *)state->fast_seek->pdata[state->fast_seek->len - 1];
+        if (state->fast_seek != NULL && (last == NULL || last->out < item->out))
+            g_ptr_array_add(state->fast_seek, item);
+        else
+            g_free(item);
+    }
+    g_ptr_array_free(chunk->points, TRUE);
+    chunk->points = NULL;
+}
+
+static gpointer
+read_ahead_thread(gpointer data)
+{
+    struct read_ahead *ra = (struct read_ahead *)data;
+    FILE_T inner = ra->inner;
+    read_ahead_chunk *chunk;
+    int n;
+
+    for (;;) {
+        chunk = (read_ahead_chunk *)g_async_queue_pop(ra->empty);
+        if (chunk == &read_ahead_stop_chunk)
+            break;
+
+        n = file_read(chunk->data, ra->chunk_size, inner);
+        chunk->len = n > 0 ? (guint)n : 0;
+        chunk->err = n < 0 ? inner->err : 0;
+        chunk->err_info = n < 0 ? inner->err_info : NULL;
+        chunk->raw_pos = inner->raw_pos;
+        read_ahead_take_points(ra, chunk);
+        g_async_queue_push(ra->full, chunk);
+        if (n <= 0)
+            break;
+    }
+    return NULL;
+}
+
+/*
+ * Stop the thread and throw away what it has read ahead; it is
+ * restarted where we are by the next read_ahead_fill().
+ */
+static void
+read_ahead_stop(FILE_T state)
+{
+    struct read_ahead *ra = state->read_ahead;
+    read_ahead_chunk *chunk;
+    gint n;
+
+    if (!ra->running)
+        return;
+
+    g_async_queue_push(ra->empty, &read_ahead_stop_chunk);
+    g_thread_join(ra->thread);
+    ra->thread = NULL;
+    ra->running = FALSE;
+
+    while ((chunk = (read_ahead_chunk *)g_async_queue_try_pop(ra->full)) != NULL) {
+        read_ahead_give_points(state, chunk);
+        g_async_queue_push(ra->empty, chunk);
+    }
+    /* If it stopped on its own, our stop request is still queued. */
+    for (n = g_async_queue_length(ra->empty); n > 0; n--) {
+        chunk = (read_ahead_chunk *)g_async_queue_pop(ra->empty);
+        if (chunk != &read_ahead_stop_chunk)
+            g_async_queue_push(ra->empty, chunk);
+    }
+}
+
+/* Start the thread reading at pos, which is where we'll next read. */
+static int
+read_ahead_start(FILE_T state, gint64 pos, int *err)
+{
+    struct read_ahead *ra = state->read_ahead;
+    FILE_T inner = ra->inner;
+    guint i;
+
+    /* file_fdclose() and file_fdreopen() change our descriptor. */
+    if (inner->fd != state->fd) {
+        inner->fd = state->fd;
+        if (ws_lseek64(inner->fd, inner->raw_pos, SEEK_SET) == -1) {
+            *err = errno;
+            return -1;
+        }
+    }
+
+    /*
+     * Seek with the shared seek points, as we're the only one
+     * using the inner reader at the moment.
+     */
+    file_clearerr(inner);
+    inner->fast_seek = state->fast_seek;
+    if (file_seek(inner, pos, SEEK_SET, err) == -1) {
+        inner->fast_seek = ra->points;
+        return -1;
+    }
+
+    if (ra->points != NULL) {
+        for (i = ra->points_known; i < ra->points->len; i++)
+            g_free(ra->points->pdata[i]);
+        g_ptr_array_set_size(ra->points, 0);
+        ra->points_known = 0;
+        if (state->fast_seek != NULL && state->fast_seek->len != 0) {
+            memcpy(&ra->last_point, state->fast_seek->pdata[state->fast_seek->len - 1],
+                   sizeof ra->last_point);
+            g_ptr_array_add(ra->points, &ra->last_point);
+            ra->points_known = 1;
+        }
+    }
+    inner->fast_seek = ra->points;
+
+    ra->thread = g_thread_new("file read-ahead", read_ahead_thread, ra);
+    ra->running = TRUE;
+    return 0;
+}
+
+static int
+read_ahead_fill(FILE_T state)
+{
+    struct read_ahead *ra = state->read_ahead;
+    read_ahead_chunk *chunk;
+    unsigned char *buf;
+    int err;
+
+    if (!ra->running && read_ahead_start(state, state->pos, &err) == -1) {
+        state->err = err;
+        state->err_info = NULL;
+        return -1;
+    }
+
+    chunk = (read_ahead_chunk *)g_async_queue_pop(ra->full);
+    read_ahead_give_points(state, chunk);
+    state->raw_pos = chunk->raw_pos;
+    if (chunk->len == 0) {
+        /*
+         * End of file, or an error; the thread has exited.  If
+         * somebody clears the EOF and reads again, it's restarted.
+         */
+        state->err = chunk->err;
+        state->err_info = chunk->err_info;
+        state->eof = TRUE;
+        state->avail_in = 0;
+        state->have = 0;
+        g_async_queue_push(ra->empty, chunk);
+        read_ahead_stop(state);
+        return 0;
+    }
+
+    buf = state->out;
+    state->out = chunk->data;
+    chunk->data = buf;
+    state->next = state->out;
+    state->have = chunk->len;
+    g_async_queue_push(ra->empty, chunk);
+    return 0;
+}
+
+static gint64
+read_ahead_seek(FILE_T state, gint64 pos, int *err)
+{
+    if (pos < 0) {                    /* before start of file! */
+        *err = EINVAL;
+        return -1;
+    }
+    read_ahead_stop(state);
+    state->have = 0;
+    state->next = state->out;
+    state->eof = FALSE;
+    state->seek_pending = FALSE;
+    state->err = 0;
+    state->err_info = NULL;
+    state->avail_in = 0;
+    state->pos = pos;
+    if (read_ahead_start(state, pos, err) == -1)
+        return -1;
+    return pos;
+}
+
+static void
+read_ahead_free(FILE_T state)
+{
+    struct read_ahead *ra = state->read_ahead;
+    guint i;
+
+    read_ahead_stop(state);
+    for (i = 0; i < READ_AHEAD_CHUNKS; i++)
+        g_free(ra->chunks[i].data);
+    g_async_queue_unref(ra->full);
+    g_async_queue_unref(ra->empty);
+    if (ra->points != NULL) {
+        for (i = ra->points_known; i < ra->points->len; i++)
+            g_free(ra->points->pdata[i]);
+        g_ptr_array_free(ra->points, TRUE);
+    }
+    /* The descriptor is ours, not the inner reader's. */
+    ra->inner->fd = -1;
+    ra->inner->fast_seek = NULL;
+    file_close(ra->inner);
+    g_free(ra);
+    state->read_ahead = NULL;
+}
+#endif /* USE_READ_AHEAD */
+
 static int /* gz_make */
 fill_out_buffer(FILE_T state)
 {
+#ifdef USE_READ_AHEAD
+    if (state->read_ahead != NULL)
+        return read_ahead_fill(state);
+#endif
     if (state->compression == UNKNOWN) {           /* look for gzip header */
         if (gz_head(state) == -1)
             return -1;
@@ -709,6 +1135,11 @@ fill_out_buffer(FILE_T state)
     else if (state->compression == ZLIB) {      /* decompress */
         zlib_read(state, state->out, state->size << 1);
     }
+#endif
+#ifdef USE_LZ4
+    else if (state->compression == LZ4) {       /* decompress */
+        lz4_read(state, state->out, state->size << 1);
+    }
 #endif
     return 0;
 }
@@ -782,6 +1213,10 @@ file_fdopen(int fd)
 
     state->fast_seek_cur = NULL;
     state->fast_seek = NULL;
+    state->fast_seek_span = SPAN;
+#ifdef USE_READ_AHEAD
+    state->read_ahead = NULL;
+#endif
 
     /* open the file with the appropriate mode (or just use fd) */
     state->fd = fd;
@@ -809,6 +1244,8 @@ file_fdopen(int fd)
         if (st.st_blksize <= G_MAXINT)
             want = (int)st.st_blksize;
         /* XXX, verify result? */
+        if (S_ISREG(st.st_mode) && want < REGULAR_FILE_BUFSIZE)
+            want = REGULAR_FILE_BUFSIZE;
     }
 #endif
 
@@ -841,6 +1278,18 @@ file_fdopen(int fd)
 
     /* for now, assume we should check the crc */
     state->dont_check_crc = FALSE;
+#endif
+#ifdef USE_LZ4
+    if (LZ4F_isError(LZ4F_createDecompressionContext(&state->lz4_ctx, LZ4F_VERSION))) {
+#ifdef HAVE_ZLIB
+        inflateEnd(&(state->strm));
+#endif
+        g_free(state->out);
+        g_free(state->in);
+        g_free(state);
+        errno = ENOMEM;
+        return NULL;
+    }
 #endif
     /* return stream */
     return state;
@@ -904,6 +1353,369 @@ file_set_random_access(FILE_T stream, gboolean random_flag _U_, GPtrArray *seek)
     stream->fast_seek = seek;
 }
 
+void
+file_set_fast_seek_span(FILE_T stream, gint64 span)
+{
+    stream->fast_seek_span = span;
+#ifdef USE_READ_AHEAD
+    if (stream->read_ahead != NULL) {
+        read_ahead_stop(stream);
+        stream->read_ahead->inner->fast_seek_span = span;
+    }
+#endif
+}
+
+/*
+ * Have the rest of a compressed stream decompressed by a separate
+ * thread.  We only do this if we have a processor to spare for it,
+ * and if the file is seekable, as the thread reads it through a
+ * reader of its own that starts over from the beginning.
+ *
+ * Returns TRUE if the stream is being read ahead.
+ */
+gboolean
+#ifdef USE_READ_AHEAD
+file_set_read_ahead(FILE_T stream)
+#else
+file_set_read_ahead(FILE_T stream _U_)
+#endif
+{
+#ifdef USE_READ_AHEAD
+    struct read_ahead *ra;
+    FILE_T inner;
+    guint i;
+
+    if (stream->read_ahead != NULL)
+        return TRUE;
+    if (!stream->is_compressed || stream->compression == UNCOMPRESSED ||
+        stream->err != 0 || g_get_num_processors() < 2)
+        return FALSE;
+
+    inner = file_fdopen(stream->fd);
+    if (inner == NULL)
+        return FALSE;
+    if (ws_lseek64(stream->fd, stream->start, SEEK_SET) == -1) {
+        /* A pipe, presumably. */
+        inner->fd = -1;
+        file_close(inner);
+        return FALSE;
+    }
+    /*
+     * From here on, our own decompression state no longer matches
+     * the file position; everything comes through the thread.
+     */
+    inner->start = stream->start;
+    inner->raw_pos = stream->start;
+    inner->fast_seek_span = stream->fast_seek_span;
+#ifdef HAVE_ZLIB
+    inner->dont_check_crc = stream->dont_check_crc;
+#endif
+
+    ra = g_new0(struct read_ahead, 1);
+    ra->inner = inner;
+    ra->full = g_async_queue_new();
+    ra->empty = g_async_queue_new();
+    ra->chunk_size = stream->size << 1;
+    for (i = 0; i < READ_AHEAD_CHUNKS; i++) {
+        ra->chunks[i].data = (unsigned char *)g_malloc(ra->chunk_size);
+        g_async_queue_push(ra->empty, &ra->chunks[i]);
+    }
+    if (stream->fast_seek != NULL)
+        ra->points = g_ptr_array_new();
+    stream->read_ahead = ra;
+
+    /* The thread is started by the first read_ahead_fill(). */
+    return TRUE;
+#else
+    return FALSE;
+#endif
+}
+
+/*
+ * Saved fast seek points.
+ *
+ * Finding the seek points in a compressed file takes a pass over all of
+ * it; saving them lets the same file be seeked in straight away the next
+ * time it's opened.  The index is a header followed by one record per
+ * point, all in network byte order.  Each zlib point is followed by its
+ * 32K window, itself compressed, which keeps the index down to a small
+ * fraction of the size the windows take in memory.
+ *
+ * The header records the size and modification time of the compressed
+ * file, so that an index for another version of the file is ignored:
+ *
+ *   magic (8), version (4), number of points (4), file size (8), mtime (8)
+ *
+ * and each point is:
+ *
+ *   out (8), in (8), compression (1), bits (1), pad (2), adler (4),
+ *   total_out (4), compressed window length (4), window
+ */
+static const char fast_seek_magic[8] = { 'W', 'T', 'F', 'S', 'E', 'E', 'K', '\0' };
+#define FAST_SEEK_VERSION       1
+#define FAST_SEEK_HEADER_LEN    32
+#define FAST_SEEK_POINT_LEN     32
+
+/* compression types in the index, which mustn't change with compression_t */
+#define FAST_SEEK_UNCOMPRESSED      1
+#define FAST_SEEK_ZLIB              2
+#define FAST_SEEK_GZIP_AFTER_HEADER 3
+
+static void
+fast_seek_fill_header(guint8 *hdr, guint32 count, const ws_statb64 *statb)
+{
+    memcpy(hdr, fast_seek_magic, sizeof fast_seek_magic);
+    phton32(hdr + 8, FAST_SEEK_VERSION);
+    phton32(hdr + 12, count);
+    phton64(hdr + 16, (guint64)statb->st_size);
+    phton64(hdr + 24, (guint64)statb->st_mtime);
+}
+
+gboolean
+file_fast_seek_save(FILE_T stream, const char *path, int *err)
+{
+    guint8                  hdr[FAST_SEEK_HEADER_LEN];
+    guint8                  rec[FAST_SEEK_POINT_LEN];
+    ws_statb64              statb;
+    FILE                   *fp;
+    guint                   i;
+#ifdef HAVE_ZLIB
+    Bytef                  *window = NULL;
+    uLongf                  window_len;
+#endif
+
+    if (stream->fast_seek == NULL) {
+        /* We were never asked to keep seek points */
+        *err = EINVAL;
+        return FALSE;
+    }
+    if (file_fstat(stream, &statb, err) == -1)
+        return FALSE;
+
+    fp = ws_fopen(path, "wb");
+    if (fp == NULL) {
+        *err = errno;
+        return FALSE;
+    }
+
+    fast_seek_fill_header(hdr, stream->fast_seek->len, &statb);
+    if (fwrite(hdr, 1, sizeof hdr, fp) != sizeof hdr)
+        goto write_error;
+
+#ifdef HAVE_ZLIB
+    window = (Bytef *)g_malloc(compressBound(ZLIB_WINSIZE));
+#endif
+    for (i = 0; i < stream->fast_seek->len; i++) {
+        struct fast_seek_point *item = (struct fast_seek_point *)stream->fast_seek->pdata[i];
+
+        memset(rec, 0, sizeof rec);
+        phton64(rec, (guint64)item->out);
+        phton64(rec + 8, (guint64)item->in);
+        switch (item->compression) {
+
+        case UNCOMPRESSED:
+            rec[16] = FAST_SEEK_UNCOMPRESSED;
+            break;
+
+#ifdef HAVE_ZLIB
+        case ZLIB:
+            rec[16] = FAST_SEEK_ZLIB;
+#ifdef HAVE_INFLATEPRIME
+            rec[17] = (guint8)item->data.zlib.bits;
+#endif
+            phton32(rec + 20, item->data.zlib.adler);
+            phton32(rec + 24, item->data.zlib.total_out);
+            window_len = compressBound(ZLIB_WINSIZE);
+            if (compress2(window, &window_len, item->data.zlib.window,
+                          ZLIB_WINSIZE, Z_BEST_SPEED) != Z_OK) {
+                g_free(window);
+                fclose(fp);
+                *err = ENOMEM;
+                return FALSE;
+            }
+            phton32(rec + 28, (guint32)window_len);
+            break;
+
+        case GZIP_AFTER_HEADER:
+            rec[16] = FAST_SEEK_GZIP_AFTER_HEADER;
+            break;
+#endif
+
+        default:
+            /* We don't add any other kind of point */
+            g_assert_not_reached();
+        }
+        if (fwrite(rec, 1, sizeof rec, fp) != sizeof rec)
+            goto write_error;
+#ifdef HAVE_ZLIB
+        if (item->compression == ZLIB &&
+            fwrite(window, 1, window_len, fp) != window_len)
+            goto write_error;
+#endif
+    }
+#ifdef HAVE_ZLIB
+    g_free(window);
+#endif
+
+    if (fclose(fp) == EOF) {
+        *err = errno;
+        return FALSE;
+    }
+    return TRUE;
+
+write_error:
+    *err = errno;
+#ifdef HAVE_ZLIB
+    g_free(window);
+#endif
+    fclose(fp);
+    return FALSE;
+}
+
+gboolean
+file_fast_seek_load(FILE_T stream, const char *path, int *err)
+{
+    guint8                  hdr[FAST_SEEK_HEADER_LEN];
+    guint8                  expected[FAST_SEEK_HEADER_LEN];
+    guint8                  rec[FAST_SEEK_POINT_LEN];
+    ws_statb64              statb;
+    FILE                   *fp;
+    guint32                 count, i;
+    GPtrArray              *points;
+    struct fast_seek_point *val;
+    gint64                  last_out = -1;
+#ifdef HAVE_ZLIB
+    Bytef                  *window;
+    guint32                 window_len;
+    uLongf                  out_len;
+    int                     ret;
+#endif
+
+    *err = 0;
+    if (stream->fast_seek == NULL) {
+        *err = EINVAL;
+        return FALSE;
+    }
+    if (file_fstat(stream, &statb, err) == -1)
+        return FALSE;
+
+    fp = ws_fopen(path, "rb");
+    if (fp == NULL) {
+        *err = errno;
+        return FALSE;
+    }
+
+    /* Is it an index for this version of the file? */
+    if (fread(hdr, 1, sizeof hdr, fp) != sizeof hdr) {
+        fclose(fp);
+        return FALSE;
+    }
+    count = pntoh32(hdr + 12);
+    fast_seek_fill_header(expected, count, &statb);
+    if (memcmp(hdr, expected, sizeof hdr) != 0) {
+        fclose(fp);
+        return FALSE;
+    }
+
+    /*
+     * Read it all before touching the current points, so that
+     * we keep those if the index turns out to be bad.
+     */
+    points = g_ptr_array_new();
+#ifdef HAVE_ZLIB
+    window = (Bytef *)g_malloc(compressBound(ZLIB_WINSIZE));
+#endif
+    for (i = 0; i < count; i++) {
+        if (fread(rec, 1, sizeof rec, fp) != sizeof rec)
+            goto bad_index;
+
+        val = g_new(struct fast_seek_point, 1);
+        g_ptr_array_add(points, val);
+        val->out = (gint64)pntoh64(rec);
+        val->in = (gint64)pntoh64(rec + 8);
+        /* fast_seek_find() relies on the points being in order */
+        if (val->out < 0 || val->in < 0 || val->out <= last_out)
+            goto bad_index;
+        last_out = val->out;
+
+        switch (rec[16]) {
+
+        case FAST_SEEK_UNCOMPRESSED:
+            val->compression = UNCOMPRESSED;
+            break;
+
+#ifdef HAVE_ZLIB
+        case FAST_SEEK_ZLIB:
+            val->compression = ZLIB;
+#ifdef HAVE_INFLATEPRIME
+            val->data.zlib.bits = rec[17];
+            if (val->data.zlib.bits > 7)
+                goto bad_index;
+#else
+            /* zlib_fast_seek_add() wouldn't have added this one */
+            if (rec[17] != 0)
+                goto bad_index;
+#endif
+            val->data.zlib.adler = pntoh32(rec + 20);
+            val->data.zlib.total_out = pntoh32(rec + 24);
+            window_len = pntoh32(rec + 28);
+            if (window_len > compressBound(ZLIB_WINSIZE) ||
+                fread(window, 1, window_len, fp) != window_len)
+                goto bad_index;
+            out_len = ZLIB_WINSIZE;
+            ret = uncompress(val->data.zlib.window, &out_len, window, window_len);
+            if (ret != Z_OK || out_len != ZLIB_WINSIZE)
+                goto bad_index;
+            break;
+
+        case FAST_SEEK_GZIP_AFTER_HEADER:
+            val->compression = GZIP_AFTER_HEADER;
+            break;
+#endif
+
+        default:
+            goto bad_index;
+        }
+    }
+#ifdef HAVE_ZLIB
+    g_free(window);
+#endif
+    fclose(fp);
+
+    /*
+     * Swap the points in, unless we've already read further than the
+     * index goes.  The points we've found ourselves so far are then at
+     * the beginning of the file, and so covered by the index; once we
+     * read past its end, we add to it as before.
+     */
+    if (stream->fast_seek->len != 0 &&
+        ((struct fast_seek_point *)stream->fast_seek->pdata[stream->fast_seek->len - 1])->out >= last_out) {
+        for (i = 0; i < points->len; i++)
+            g_free(points->pdata[i]);
+        g_ptr_array_free(points, TRUE);
+        return TRUE;
+    }
+    for (i = 0; i < stream->fast_seek->len; i++)
+        g_free(stream->fast_seek->pdata[i]);
+    g_ptr_array_set_size(stream->fast_seek, 0);
+    for (i = 0; i < points->len; i++)
+        g_ptr_array_add(stream->fast_seek, points->pdata[i]);
+    g_ptr_array_free(points, TRUE);
+    return TRUE;
+
+bad_index:
+    for (i = 0; i < points->len; i++)
+        g_free(points->pdata[i]);
+    g_ptr_array_free(points, TRUE);
+#ifdef HAVE_ZLIB
+    g_free(window);
+#endif
+    if (ferror(fp))
+        *err = errno;
+    fclose(fp);
+    return FALSE;
+}
+
 gint64
 file_seek(FILE_T file, gint64 offset, int whence, int *err)
 {
@@ -975,13 +1787,38 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
         }
     }
 
+    /*
+     * Are we seeking forwards to data we already have in the buffer?
+     *
+     * That's what a rescan or retap does, reading the records of the
+     * file in order with a seek before each one.  Without this, the
+     * "fast seek" code below would do an lseek() and throw away the
+     * buffer for each record, so that every record cost a system
+     * call and a read of a whole buffer.
+     */
+    if (offset >= 0 && file->next && offset <= (gint64)file->have) {
+        file->have -= (unsigned)offset;
+        file->next += offset;
+        file->pos += offset;
+        return file->pos;
+    }
+
+#ifdef USE_READ_AHEAD
+    /*
+     * If a thread is reading ahead for us, seeking forwards just
+     * skips what it reads; seeking backwards moves it.
+     */
+    if (file->read_ahead != NULL && offset < 0)
+        return read_ahead_seek(file, file->pos + offset, err);
+#endif
+
     /*
      * No.  Do we have "fast seek" data for the location to which we
      * will be seeking?
      *
      * XXX, profile
      */
-    if ((here = fast_seek_find(file, file->pos + offset)) && (offset < 0 || offset > SPAN || here->compression == UNCOMPRESSED)) {
+    if (!HAS_READ_AHEAD(file) && (here = fast_seek_find(file, file->pos + offset)) && (offset < 0 || offset > file->fast_seek_span || here->compression == UNCOMPRESSED)) {
         gint64 off, off2;
 
         /*
@@ -1222,6 +2059,21 @@ file_read(void *buf, unsigned int len, FILE_T file)
                we're at the end of the input; just return
                with what we've gotten so far. */
             break;
+        } else if (file->compression == UNCOMPRESSED && buf != NULL &&
+                   len >= file->size) {
+            /* We have nothing in the output buffer, the
+               data isn't compressed, and we want at least
+               a buffer's worth of it; read it directly into
+               the caller's buffer rather than copying it
+               through the output buffer.  There's nothing
+               left in the output buffer to seek back into. */
+            if (raw_read(file, (unsigned char *)buf, len, &n) == -1)
+                return -1;
+            file->next = file->out;
+            buf = (char *)buf + n;
+            len -= n;
+            got += n;
+            file->pos += n;
         } else {
             /* We have nothing in the output buffer, and
                we can generate more data; get more output,
@@ -1409,6 +2261,10 @@ file_clearerr(FILE_T stream)
 void
 file_fdclose(FILE_T file)
 {
+#ifdef USE_READ_AHEAD
+    if (file->read_ahead != NULL)
+        read_ahead_stop(file);
+#endif
     ws_close(file->fd);
     file->fd = -1;
 }
@@ -1429,10 +2285,18 @@ file_close(FILE_T file)
 {
     int fd = file->fd;
 
+#ifdef USE_READ_AHEAD
+    if (file->read_ahead != NULL)
+        read_ahead_free(file);
+#endif
+
     /* free memory and close file */
     if (file->size) {
 #ifdef HAVE_ZLIB
         inflateEnd(&(file->strm));
+#endif
+#ifdef USE_LZ4
+        LZ4F_freeDecompressionContext(file->lz4_ctx);
 #endif
         g_free(file->out);
         g_free(file->in);
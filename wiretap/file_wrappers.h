@@ -29,6 +29,10 @@
 extern FILE_T file_open(const char *path);
 extern FILE_T file_fdopen(int fildes);
 extern void file_set_random_access(FILE_T stream, gboolean random_flag, GPtrArray *seek);
+extern void file_set_fast_seek_span(FILE_T stream, gint64 span);
+extern gboolean file_set_read_ahead(FILE_T stream);
+extern gboolean file_fast_seek_save(FILE_T stream, const char *path, int *err);
+extern gboolean file_fast_seek_load(FILE_T stream, const char *path, int *err);
 WS_DLL_PUBLIC gint64 file_seek(FILE_T stream, gint64 offset, int whence, int *err);
 WS_DLL_PUBLIC gint64 file_tell(FILE_T stream);
 extern gint64 file_tell_raw(FILE_T stream);
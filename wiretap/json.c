@@ -27,6 +27,224 @@
 #include "json.h"
 #include <wsutil/wsjsmn.h>
 
+/*
+ * A file that's too big to be read as a single record is read as one
+ * record per element of its top-level array, as written by "tshark -T
+ * json"; the offset of each element is its record's data offset, so
+ * that it can be read again with json_stream_seek_read().
+ */
+typedef struct {
+    gboolean end_of_array;      /* the sequential read reached the closing ] */
+} json_stream_t;
+
+#define JSON_IS_SPACE(c) ((c) == ' ' || (c) == '\t' || (c) == '\n' || (c) == '\r')
+
+/*
+ * Read the element of the top-level array that starts at the current
+ * offset into buf.  Only what's needed to find its end is looked at:
+ * the nesting depth, and strings, so that brackets in them aren't counted.
+ * If the element is a number or literal ended by the closing ] of the
+ * array, *end_of_array is set.
+ */
+static gboolean json_read_element(FILE_T fh, Buffer *buf, gboolean *end_of_array,
+    int *err, gchar **err_info)
+{
+    guint8 chunk[4096];
+    guint chunk_len = 0;
+    guint64 len = 0;
+    int depth = 0;
+    gboolean in_string = FALSE;
+    gboolean escaped = FALSE;
+    gboolean done = FALSE;
+    int c;
+
+    ws_buffer_clean(buf);
+    while (!done) {
+        c = file_getc(fh);
+        if (c == EOF) {
+            *err = file_error(fh, err_info);
+            if (*err == 0)
+                *err = WTAP_ERR_SHORT_READ;
+            return FALSE;
+        }
+
+        if (in_string) {
+            if (escaped) {
+                escaped = FALSE;
+            } else if (c == '\\') {
+                escaped = TRUE;
+            } else if (c == '"') {
+                in_string = FALSE;
+                done = (depth == 0);
+            }
+        } else if (c == '"') {
+            in_string = TRUE;
+        } else if (c == '{' || c == '[') {
+            depth++;
+        } else if (c == '}' || c == ']') {
+            if (depth == 0) {
+                /* The end of the array, after a number or literal */
+                if (len == 0 || c != ']') {
+                    *err = WTAP_ERR_BAD_FILE;
+                    *err_info = g_strdup("json: unexpected closing bracket");
+                    return FALSE;
+                }
+                *end_of_array = TRUE;
+                break;
+            }
+            done = (--depth == 0);
+        } else if (depth == 0 && (c == ',' || JSON_IS_SPACE(c))) {
+            /* The end of a number or literal */
+            break;
+        }
+
+        chunk[chunk_len++] = (guint8)c;
+        if (chunk_len == sizeof chunk) {
+            ws_buffer_append(buf, chunk, chunk_len);
+            chunk_len = 0;
+        }
+        if (++len > MAX_FILE_SIZE) {
+            *err = WTAP_ERR_BAD_FILE;
+            *err_info = g_strdup_printf("json: File has an array element bigger than maximum of %u bytes",
+                MAX_FILE_SIZE);
+            return FALSE;
+        }
+    }
+    ws_buffer_append(buf, chunk, chunk_len);
+
+    return TRUE;
+}
+
+static void json_set_phdr(struct wtap_pkthdr *phdr, guint32 packet_size)
+{
+    phdr->rec_type = REC_TYPE_PACKET;
+    phdr->presence_flags = 0; /* yes, we have no bananas^Wtime stamp */
+
+    phdr->caplen = packet_size;
+    phdr->len = packet_size;
+
+    phdr->ts.secs = 0;
+    phdr->ts.nsecs = 0;
+}
+
+/* Skip white space and the separators between array elements */
+static gboolean json_skip_separators(FILE_T fh, int *err, gchar **err_info)
+{
+    int c;
+
+    for (;;) {
+        c = file_peekc(fh);
+        if (c == EOF) {
+            *err = file_error(fh, err_info);
+            if (*err == 0)
+                *err = WTAP_ERR_SHORT_READ;
+            return FALSE;
+        }
+        if (c != ',' && !JSON_IS_SPACE(c))
+            return TRUE;
+        file_getc(fh);
+    }
+}
+
+static gboolean json_stream_read(wtap *wth, int *err, gchar **err_info, gint64 *data_offset)
+{
+    json_stream_t *json = (json_stream_t *)wth->priv;
+
+    *err = 0;
+
+    if (json->end_of_array)
+        return FALSE;
+
+    if (!json_skip_separators(wth->fh, err, err_info))
+        return FALSE;
+    if (file_peekc(wth->fh) == ']') {
+        json->end_of_array = TRUE;
+        return FALSE;
+    }
+
+    *data_offset = file_tell(wth->fh);
+
+    if (!json_read_element(wth->fh, wth->frame_buffer, &json->end_of_array, err, err_info))
+        return FALSE;
+    json_set_phdr(&wth->phdr, (guint32)ws_buffer_length(wth->frame_buffer));
+    return TRUE;
+}
+
+static gboolean json_stream_seek_read(wtap *wth, gint64 seek_off, struct wtap_pkthdr *phdr, Buffer *buf,
+    int *err, gchar **err_info)
+{
+    gboolean end_of_array = FALSE;
+
+    if (file_seek(wth->random_fh, seek_off, SEEK_SET, err) == -1)
+        return FALSE;
+
+    if (!json_read_element(wth->random_fh, buf, &end_of_array, err, err_info))
+        return FALSE;
+    json_set_phdr(phdr, (guint32)ws_buffer_length(buf));
+    return TRUE;
+}
+
+/*
+ * Check that a file too big to be a single record starts with an array
+ * whose first element looks like JSON, and set up to read it an element
+ * at a time.
+ */
+static wtap_open_return_val json_stream_open(wtap *wth, int *err, gchar **err_info)
+{
+    json_stream_t *json;
+    Buffer elem;
+    gboolean end_of_array = FALSE;
+    gint64 offset;
+    int c;
+
+    do {
+        c = file_getc(wth->fh);
+    } while (c != EOF && JSON_IS_SPACE(c));
+    if (c != '[') {
+        if (c == EOF && (*err = file_error(wth->fh, err_info)) != 0)
+            return WTAP_OPEN_ERROR;
+        return WTAP_OPEN_NOT_MINE;
+    }
+
+    if (!json_skip_separators(wth->fh, err, err_info)) {
+        if (*err == WTAP_ERR_SHORT_READ)
+            return WTAP_OPEN_NOT_MINE;
+        return WTAP_OPEN_ERROR;
+    }
+    offset = file_tell(wth->fh);
+
+    ws_buffer_init(&elem, 1500);
+    if (!json_read_element(wth->fh, &elem, &end_of_array, err, err_info)) {
+        ws_buffer_free(&elem);
+        if (*err == WTAP_ERR_SHORT_READ || *err == WTAP_ERR_BAD_FILE) {
+            g_free(*err_info);
+            *err_info = NULL;
+            return WTAP_OPEN_NOT_MINE;
+        }
+        return WTAP_OPEN_ERROR;
+    }
+    if (!wsjsmn_is_json_value(ws_buffer_start_ptr(&elem), ws_buffer_length(&elem))) {
+        ws_buffer_free(&elem);
+        return WTAP_OPEN_NOT_MINE;
+    }
+    ws_buffer_free(&elem);
+
+    if (file_seek(wth->fh, offset, SEEK_SET, err) == -1)
+        return WTAP_OPEN_ERROR;
+
+    json = g_new0(json_stream_t, 1);
+    wth->priv = json;
+
+    wth->file_type_subtype = WTAP_FILE_TYPE_SUBTYPE_JSON;
+    wth->file_encap = WTAP_ENCAP_JSON;
+    wth->file_tsprec = WTAP_TSPREC_SEC;
+    wth->subtype_read = json_stream_read;
+    wth->subtype_seek_read = json_stream_seek_read;
+    wth->snapshot_length = 0;
+
+    return WTAP_OPEN_MINE;
+}
+
 static gboolean json_read_file(wtap *wth, FILE_T fh, struct wtap_pkthdr *phdr,
     Buffer *buf, int *err, gchar **err_info)
 {
@@ -48,14 +266,7 @@ static gboolean json_read_file(wtap *wth, FILE_T fh, struct wtap_pkthdr *phdr,
     }
     packet_size = (int)file_size;
 
-    phdr->rec_type = REC_TYPE_PACKET;
-    phdr->presence_flags = 0; /* yes, we have no bananas^Wtime stamp */
-
-    phdr->caplen = packet_size;
-    phdr->len = packet_size;
-
-    phdr->ts.secs = 0;
-    phdr->ts.nsecs = 0;
+    json_set_phdr(phdr, packet_size);
 
     return wtap_read_packet_bytes(fh, buf, packet_size, err, err_info);
 }
@@ -96,6 +307,14 @@ wtap_open_return_val json_open(wtap *wth, int *err, gchar **err_info)
 {
     guint8* filebuf;
     int bytes_read;
+    gint64 file_size;
+
+    if ((file_size = wtap_file_size(wth, err)) == -1)
+        return WTAP_OPEN_ERROR;
+
+    /* Too big to be one record, but maybe an array of them */
+    if (file_size > MAX_FILE_SIZE)
+        return json_stream_open(wth, err, err_info);
 
     filebuf = (guint8*)g_malloc0(MAX_FILE_SIZE);
     if (!filebuf)
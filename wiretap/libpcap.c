@@ -42,12 +42,26 @@ typedef enum {
 	MAYBE_SWAPPED
 } swapped_type_t;
 
+/*
+ * For files with the standard record header, sequential reads get
+ * the header of the next record along with the data of the current
+ * one, so that reading a packet takes one file_read() rather than two.
+ */
+typedef enum {
+	NEXT_HDR_NONE,		/* next header not read yet */
+	NEXT_HDR_READ,		/* next header is in next_hdr */
+	NEXT_HDR_SHORT		/* file ended in the middle of it */
+} next_hdr_state_t;
+
 typedef struct {
 	gboolean byte_swapped;
 	swapped_type_t lengths_swapped;
 	guint16	version_major;
 	guint16	version_minor;
 	void *encap_priv;
+	gboolean read_next_hdr;
+	next_hdr_state_t next_hdr_state;
+	struct pcaprec_ss990915_hdr next_hdr;
 } libpcap_t;
 
 /* Try to read the first two records of the capture file. */
@@ -60,11 +74,14 @@ static gboolean libpcap_read(wtap *wth, int *err, gchar **err_info,
 static gboolean libpcap_seek_read(wtap *wth, gint64 seek_off,
     struct wtap_pkthdr *phdr, Buffer *buf, int *err, gchar **err_info);
 static gboolean libpcap_read_packet(wtap *wth, FILE_T fh,
-    struct wtap_pkthdr *phdr, Buffer *buf, int *err, gchar **err_info);
+    struct wtap_pkthdr *phdr, Buffer *buf, gboolean sequential, int *err,
+    gchar **err_info);
 static gboolean libpcap_dump(wtap_dumper *wdh, const struct wtap_pkthdr *phdr,
     const guint8 *pd, int *err, gchar **err_info);
 static int libpcap_read_header(wtap *wth, FILE_T fh, int *err, gchar **err_info,
     struct pcaprec_ss990915_hdr *hdr);
+static void libpcap_fixup_header(libpcap_t *libpcap,
+    struct pcaprec_ss990915_hdr *hdr);
 static void libpcap_close(wtap *wth);
 
 wtap_open_return_val libpcap_open(wtap *wth, int *err, gchar **err_info)
@@ -273,6 +290,8 @@ wtap_open_return_val libpcap_open(wtap *wth, int *err, gchar **err_info)
 	libpcap->version_major = hdr.version_major;
 	libpcap->version_minor = hdr.version_minor;
 	libpcap->encap_priv = NULL;
+	libpcap->read_next_hdr = FALSE;
+	libpcap->next_hdr_state = NEXT_HDR_NONE;
 	wth->priv = (void *)libpcap;
 	wth->subtype_read = libpcap_read;
 	wth->subtype_seek_read = libpcap_seek_read;
@@ -457,6 +476,15 @@ done:
 		/*Reset the ERF interface lookup table*/
 		libpcap->encap_priv = erf_priv_create();
 	}
+
+	/*
+	 * The modified and Nokia formats have bigger record headers,
+	 * and AIX has padding after them; only read the next header
+	 * ahead for the standard formats.
+	 */
+	if (wth->file_type_subtype == WTAP_FILE_TYPE_SUBTYPE_PCAP ||
+	    wth->file_type_subtype == WTAP_FILE_TYPE_SUBTYPE_PCAP_NSEC)
+		libpcap->read_next_hdr = TRUE;
 	return WTAP_OPEN_MINE;
 }
 
@@ -623,10 +651,14 @@ static int libpcap_try_header(wtap *wth, FILE_T fh, int *err, gchar **err_info,
 static gboolean libpcap_read(wtap *wth, int *err, gchar **err_info,
     gint64 *data_offset)
 {
+	libpcap_t *libpcap = (libpcap_t *)wth->priv;
+
 	*data_offset = file_tell(wth->fh);
+	if (libpcap->next_hdr_state == NEXT_HDR_READ)
+		*data_offset -= sizeof (struct pcaprec_hdr);
 
 	return libpcap_read_packet(wth, wth->fh, &wth->phdr,
-	    wth->frame_buffer, err, err_info);
+	    wth->frame_buffer, TRUE, err, err_info);
 }
 
 static gboolean
@@ -636,7 +668,7 @@ libpcap_seek_read(wtap *wth, gint64 seek_off, struct wtap_pkthdr *phdr,
 	if (file_seek(wth->random_fh, seek_off, SEEK_SET, err) == -1)
 		return FALSE;
 
-	if (!libpcap_read_packet(wth, wth->random_fh, phdr, buf, err,
+	if (!libpcap_read_packet(wth, wth->random_fh, phdr, buf, FALSE, err,
 	    err_info)) {
 		if (*err == 0)
 			*err = WTAP_ERR_SHORT_READ;
@@ -645,9 +677,42 @@ libpcap_seek_read(wtap *wth, gint64 seek_off, struct wtap_pkthdr *phdr,
 	return TRUE;
 }
 
+/*
+ * Read the packet data and, if we can, the header of the record after
+ * it, in one read.  If the file ends right after the packet, that's not
+ * an error here; the next read will report the EOF.
+ */
+static gboolean
+libpcap_read_data_and_next_header(libpcap_t *libpcap, FILE_T fh, Buffer *buf,
+    guint packet_size, int *err, gchar **err_info)
+{
+	guint8 *pd;
+	int bytes_read;
+
+	ws_buffer_assure_space(buf, packet_size + sizeof (struct pcaprec_hdr));
+	pd = ws_buffer_start_ptr(buf);
+	bytes_read = file_read(pd, packet_size + (guint)sizeof (struct pcaprec_hdr), fh);
+	if (bytes_read < 0 || (guint)bytes_read < packet_size) {
+		*err = file_error(fh, err_info);
+		if (*err == 0)
+			*err = WTAP_ERR_SHORT_READ;
+		return FALSE;
+	}
+
+	bytes_read -= packet_size;
+	if (bytes_read == (int)sizeof (struct pcaprec_hdr)) {
+		memcpy(&libpcap->next_hdr.hdr, pd + packet_size,
+		    sizeof (struct pcaprec_hdr));
+		libpcap_fixup_header(libpcap, &libpcap->next_hdr);
+		libpcap->next_hdr_state = NEXT_HDR_READ;
+	} else if (bytes_read != 0)
+		libpcap->next_hdr_state = NEXT_HDR_SHORT;
+	return TRUE;
+}
+
 static gboolean
 libpcap_read_packet(wtap *wth, FILE_T fh, struct wtap_pkthdr *phdr,
-    Buffer *buf, int *err, gchar **err_info)
+    Buffer *buf, gboolean sequential, int *err, gchar **err_info)
 {
 	struct pcaprec_ss990915_hdr hdr;
 	guint packet_size;
@@ -657,8 +722,19 @@ libpcap_read_packet(wtap *wth, FILE_T fh, struct wtap_pkthdr *phdr,
 
 	libpcap = (libpcap_t *)wth->priv;
 
-	if (!libpcap_read_header(wth, fh, err, err_info, &hdr))
-		return FALSE;
+	if (sequential && libpcap->next_hdr_state != NEXT_HDR_NONE) {
+		/* We read this header along with the previous packet. */
+		if (libpcap->next_hdr_state == NEXT_HDR_SHORT) {
+			libpcap->next_hdr_state = NEXT_HDR_NONE;
+			*err = WTAP_ERR_SHORT_READ;
+			return FALSE;
+		}
+		hdr = libpcap->next_hdr;
+		libpcap->next_hdr_state = NEXT_HDR_NONE;
+	} else {
+		if (!libpcap_read_header(wth, fh, err, err_info, &hdr))
+			return FALSE;
+	}
 
 	if (hdr.hdr.incl_len > wtap_max_snaplen_for_encap(wth->file_encap)) {
 		/*
@@ -735,8 +811,14 @@ libpcap_read_packet(wtap *wth, FILE_T fh, struct wtap_pkthdr *phdr,
 	/*
 	 * Read the packet data.
 	 */
-	if (!wtap_read_packet_bytes(fh, buf, packet_size, err, err_info))
-		return FALSE;	/* failed */
+	if (sequential && libpcap->read_next_hdr) {
+		if (!libpcap_read_data_and_next_header(libpcap, fh, buf,
+		    packet_size, err, err_info))
+			return FALSE;	/* failed */
+	} else {
+		if (!wtap_read_packet_bytes(fh, buf, packet_size, err, err_info))
+			return FALSE;	/* failed */
+	}
 
 	pcap_read_post_process(wth->file_type_subtype, wth->file_encap,
 	    phdr, ws_buffer_start_ptr(buf), libpcap->byte_swapped, -1);
@@ -750,7 +832,6 @@ static int libpcap_read_header(wtap *wth, FILE_T fh, int *err, gchar **err_info,
     struct pcaprec_ss990915_hdr *hdr)
 {
 	int bytes_to_read;
-	guint32 temp;
 	libpcap_t *libpcap;
 
 	switch (wth->file_type_subtype) {
@@ -782,6 +863,17 @@ static int libpcap_read_header(wtap *wth, FILE_T fh, int *err, gchar **err_info,
 		return FALSE;
 
 	libpcap = (libpcap_t *)wth->priv;
+	libpcap_fixup_header(libpcap, hdr);
+	return TRUE;
+}
+
+/* Put the fields of a record header in host byte order and in the
+   right order. */
+static void libpcap_fixup_header(libpcap_t *libpcap,
+    struct pcaprec_ss990915_hdr *hdr)
+{
+	guint32 temp;
+
 	if (libpcap->byte_swapped) {
 		/* Byte-swap the record header fields. */
 		hdr->hdr.ts_sec = GUINT32_SWAP_LE_BE(hdr->hdr.ts_sec);
@@ -812,8 +904,6 @@ static int libpcap_read_header(wtap *wth, FILE_T fh, int *err, gchar **err_info,
 		hdr->hdr.incl_len = temp;
 		break;
 	}
-
-	return TRUE;
 }
 
 /* Returns 0 if we could write the specified encapsulation type,
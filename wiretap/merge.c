@@ -35,6 +35,7 @@
 
 #include <string.h>
 #include "merge.h"
+#include "wtap-int.h"
 #include "wtap_opttypes.h"
 #include "pcapng.h"
 
@@ -115,6 +116,7 @@ add_idb_index_map(merge_in_file_t *in_file, const guint orig_index, const guint
  * @param in_file_count number of entries in in_file_names and in_files
  * @param in_file_names filenames of the input files
  * @param in_files input file array to be filled (>= sizeof(merge_in_file_t) * in_file_count)
+ * @param do_random TRUE if the files will also be read randomly
  * @param err wiretap error, if failed
  * @param err_info wiretap error string, if failed
  * @param err_fileno file on which open failed, if failed
@@ -122,7 +124,8 @@ add_idb_index_map(merge_in_file_t *in_file, const guint orig_index, const guint
  */
 static gboolean
 merge_open_in_files(guint in_file_count, const char *const *in_file_names,
-                    merge_in_file_t **in_files, merge_progress_callback_t* cb,
+                    merge_in_file_t **in_files, gboolean do_random,
+                    merge_progress_callback_t* cb,
                     int *err, gchar **err_info, guint *err_fileno)
 {
     guint i;
@@ -136,7 +139,7 @@ merge_open_in_files(guint in_file_count, const char *const *in_file_names,
 
     for (i = 0; i < in_file_count; i++) {
         files[i].filename    = in_file_names[i];
-        files[i].wth         = wtap_open_offline(in_file_names[i], WTAP_TYPE_AUTO, err, err_info, FALSE);
+        files[i].wth         = wtap_open_offline(in_file_names[i], WTAP_TYPE_AUTO, err, err_info, do_random);
         files[i].data_offset = 0;
         files[i].state       = PACKET_NOT_PRESENT;
         files[i].packet_num  = 0;
@@ -211,21 +214,93 @@ merge_select_frame_type(int in_file_count, merge_in_file_t in_files[])
 }
 
 /*
- * returns TRUE if first argument is earlier than second
+ * The files that have a packet present, kept in a binary min-heap on the
+ * packet time stamps so that the next packet can be picked without
+ * looking at every file.  Between packets with the same time stamp the
+ * one from the file with the higher index comes first, as it always has.
  */
+typedef struct {
+    nstime_t ts;            /* time stamp of the file's current packet */
+    guint    file_index;    /* index of the file in in_files */
+} merge_heap_entry_t;
+
+typedef struct {
+    merge_heap_entry_t *entries;
+    guint               count;
+    int                 last;   /* file returned last; must be read next, or -1 */
+    gboolean            primed; /* all of the files have been read from */
+} merge_heap_t;
+
 static gboolean
-is_earlier(nstime_t *l, nstime_t *r) /* XXX, move to nstime.c */
+merge_heap_entry_is_before(const merge_heap_entry_t *l, const merge_heap_entry_t *r)
 {
-    if (l->secs > r->secs) {  /* left is later */
-        return FALSE;
-    } else if (l->secs < r->secs) { /* left is earlier */
-        return TRUE;
-    } else if (l->nsecs > r->nsecs) { /* tv_sec equal, l.usec later */
-        return FALSE;
+    if (l->ts.secs != r->ts.secs)
+        return l->ts.secs < r->ts.secs;
+    if (l->ts.nsecs != r->ts.nsecs)
+        return l->ts.nsecs < r->ts.nsecs;
+    return l->file_index > r->file_index;
+}
+
+static void
+merge_heap_push(merge_heap_t *heap, const nstime_t *ts, guint file_index)
+{
+    merge_heap_entry_t entry;
+    guint i, parent;
+
+    entry.ts = *ts;
+    entry.file_index = file_index;
+
+    for (i = heap->count++; i > 0; i = parent) {
+        parent = (i - 1) / 2;
+        if (!merge_heap_entry_is_before(&entry, &heap->entries[parent]))
+            break;
+        heap->entries[i] = heap->entries[parent];
+    }
+    heap->entries[i] = entry;
+}
+
+static guint
+merge_heap_pop(merge_heap_t *heap)
+{
+    merge_heap_entry_t entry;
+    guint top, i, child;
+
+    g_assert(heap->count > 0);
+    top = heap->entries[0].file_index;
+    entry = heap->entries[--heap->count];
+
+    for (i = 0; (child = 2 * i + 1) < heap->count; i = child) {
+        if (child + 1 < heap->count &&
+            merge_heap_entry_is_before(&heap->entries[child + 1], &heap->entries[child]))
+            child++;
+        if (!merge_heap_entry_is_before(&heap->entries[child], &entry))
+            break;
+        heap->entries[i] = heap->entries[child];
+    }
+    if (heap->count > 0)
+        heap->entries[i] = entry;
+
+    return top;
+}
+
+/*
+ * Read the next packet from in_file and, if there is one, add the file
+ * to the heap.  Returns FALSE on a read error.
+ */
+static gboolean
+merge_heap_read(merge_heap_t *heap, merge_in_file_t in_files[], guint i,
+                int *err, gchar **err_info)
+{
+    if (!wtap_read(in_files[i].wth, err, err_info, &in_files[i].data_offset)) {
+        if (*err != 0) {
+            in_files[i].state = GOT_ERROR;
+            return FALSE;
+        }
+        in_files[i].state = AT_EOF;
+    } else {
+        in_files[i].state = PACKET_PRESENT;
+        merge_heap_push(heap, &wtap_phdr(in_files[i].wth)->ts, i);
     }
-    /* either one < two or one == two
-     * either way, return one
-     */
     return TRUE;
 }
 
@@ -243,6 +318,7 @@ is_earlier(nstime_t *l, nstime_t *r) /* XXX, move to nstime.c */
  *
  * @param in_file_count number of entries in in_files
  * @param in_files input file array
+ * @param heap the files with a packet present, ordered by time stamp
  * @param err wiretap error, if failed
  * @param err_info wiretap error string, if failed
  * @return pointer to merge_in_file_t for file from which that packet
@@ -250,51 +326,40 @@ is_earlier(nstime_t *l, nstime_t *r) /* XXX, move to nstime.c */
  */
 static merge_in_file_t *
 merge_read_packet(int in_file_count, merge_in_file_t in_files[],
-                  int *err, gchar **err_info)
+                  merge_heap_t *heap, int *err, gchar **err_info)
 {
     int i;
-    int ei = -1;
-    nstime_t tv = { sizeof(time_t) > sizeof(int) ? LONG_MAX : INT_MAX, INT_MAX };
-    struct wtap_pkthdr *phdr;
+    guint ei;
 
     /*
      * Make sure we have a packet available from each file, if there are any
-     * packets left in the file in question, and search for the packet
-     * with the earliest time stamp.
+     * packets left in the file in question; the only file that might not
+     * have one is the one we returned the last packet from.
      */
-    for (i = 0; i < in_file_count; i++) {
-        if (in_files[i].state == PACKET_NOT_PRESENT) {
-            /*
-             * No packet available, and we haven't seen an error or EOF yet,
-             * so try to read the next packet.
-             */
-            if (!wtap_read(in_files[i].wth, err, err_info, &in_files[i].data_offset)) {
-                if (*err != 0) {
-                    in_files[i].state = GOT_ERROR;
-                    return &in_files[i];
-                }
-                in_files[i].state = AT_EOF;
-            } else
-                in_files[i].state = PACKET_PRESENT;
-        }
-
-        if (in_files[i].state == PACKET_PRESENT) {
-            phdr = wtap_phdr(in_files[i].wth);
-            if (is_earlier(&phdr->ts, &tv)) {
-                tv = phdr->ts;
-                ei = i;
-            }
+    if (!heap->primed) {
+        for (i = 0; i < in_file_count; i++) {
+            if (!merge_heap_read(heap, in_files, i, err, err_info))
+                return &in_files[i];
         }
+        heap->primed = TRUE;
+    } else if (heap->last != -1) {
+        i = heap->last;
+        heap->last = -1;
+        if (!merge_heap_read(heap, in_files, i, err, err_info))
+            return &in_files[i];
     }
 
-    if (ei == -1) {
+    if (heap->count == 0) {
         /* All the streams are at EOF.  Return an EOF indication. */
         *err = 0;
         return NULL;
     }
 
+    ei = merge_heap_pop(heap);
+
     /* We'll need to read another packet from this file. */
     in_files[ei].state = PACKET_NOT_PRESENT;
+    heap->last = ei;
 
     /* Count this packet. */
     in_files[ei].packet_num++;
@@ -640,6 +705,117 @@ all_idbs_are_duplicates(const merge_in_file_t *in_files, const guint in_file_cou
     return TRUE;
 }
 
+/*
+ * is_duplicate_idb() always requires the encapsulation, time units,
+ * time stamp precision and snapshot length to match, and the names to
+ * match if both IDBs have one; the other options it only compares if
+ * both have them.  So the merged IDBs are indexed by those four fields
+ * and then by name, and an input IDB only has to be compared with the
+ * ones in its bucket that have its name or none.
+ */
+typedef struct {
+    GArray     *all;        /* indexes in the merged IDB list, ascending */
+    GArray     *unnamed;    /* those of them without a name */
+    GHashTable *named;      /* name -> GArray of the indexes with that name */
+} idb_bucket_t;
+
+static void
+free_index_array(gpointer data)
+{
+    g_array_free((GArray *)data, TRUE);
+}
+
+static void
+free_idb_bucket(gpointer data)
+{
+    idb_bucket_t *bucket = (idb_bucket_t *)data;
+
+    g_array_free(bucket->all, TRUE);
+    g_array_free(bucket->unnamed, TRUE);
+    g_hash_table_destroy(bucket->named);
+    g_free(bucket);
+}
+
+static GHashTable *
+idb_buckets_new(void)
+{
+    return g_hash_table_new_full(g_str_hash, g_str_equal, g_free, free_idb_bucket);
+}
+
+static gchar *
+idb_bucket_key(const wtap_block_t idb)
+{
+    wtapng_if_descr_mandatory_t *idb_mand =
+        (wtapng_if_descr_mandatory_t*)wtap_block_get_mandatory_data(idb);
+
+    return g_strdup_printf("%d/%" G_GINT64_MODIFIER "u/%d/%u", idb_mand->wtap_encap,
+                           idb_mand->time_units_per_second, idb_mand->tsprecision,
+                           idb_mand->snap_len);
+}
+
+static const char *
+idb_name(const wtap_block_t idb)
+{
+    char *if_name;
+
+    if (wtap_block_get_string_option_value(idb, OPT_IDB_NAME, &if_name) == WTAP_OPTTYPE_SUCCESS)
+        return if_name;
+    return NULL;
+}
+
+/* Record that the merged IDB at merged_index is idb */
+static void
+idb_buckets_add(GHashTable *buckets, const wtap_block_t idb, guint merged_index)
+{
+    gchar *key = idb_bucket_key(idb);
+    const char *name = idb_name(idb);
+    idb_bucket_t *bucket;
+    GArray *indexes;
+
+    bucket = (idb_bucket_t *)g_hash_table_lookup(buckets, key);
+    if (bucket == NULL) {
+        bucket = g_new(idb_bucket_t, 1);
+        bucket->all = g_array_new(FALSE, FALSE, sizeof(guint));
+        bucket->unnamed = g_array_new(FALSE, FALSE, sizeof(guint));
+        bucket->named = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, free_index_array);
+        g_hash_table_insert(buckets, key, bucket);
+    } else {
+        g_free(key);
+    }
+
+    g_array_append_val(bucket->all, merged_index);
+    if (name == NULL) {
+        g_array_append_val(bucket->unnamed, merged_index);
+    } else {
+        indexes = (GArray *)g_hash_table_lookup(bucket->named, name);
+        if (indexes == NULL) {
+            indexes = g_array_new(FALSE, FALSE, sizeof(guint));
+            g_hash_table_insert(bucket->named, g_strdup(name), indexes);
+        }
+        g_array_append_val(indexes, merged_index);
+    }
+}
+
+/* Lower *best to the first of indexes, below it, that idb duplicates */
+static void
+find_duplicate_in(const wtap_block_t idb, const wtapng_iface_descriptions_t *merged_idb_list,
+                  const GArray *indexes, guint *best)
+{
+    guint i, index;
+
+    if (indexes == NULL)
+        return;
+    for (i = 0; i < indexes->len; i++) {
+        index = g_array_index(indexes, guint, i);
+        if (index >= *best)
+            return;
+        if (is_duplicate_idb(idb, g_array_index(merged_idb_list->interface_data, wtap_block_t, index))) {
+            *best = index;
+            return;
+        }
+    }
+}
+
 /*
  * Returns true if the given input_file_idb is a duplicate of an existing one
  * in the merged_idb_list; it's a duplicate if the interface description data
@@ -647,31 +823,43 @@ all_idbs_are_duplicates(const merge_in_file_t *in_files, const guint in_file_cou
  * function, the input file IDB's index does NOT need to match the index
  * location of a previous one to be considered a duplicate; any match is
  * considered a success. That means it will even match another IDB from its
- * own (same) input file.
+ * own (same) input file.  The first match in the list is found, as if the
+ * list were searched in order.
  */
 static gboolean
 find_duplicate_idb(const wtap_block_t input_file_idb,
                const wtapng_iface_descriptions_t *merged_idb_list,
-               guint *found_index)
+               GHashTable *buckets, guint *found_index)
 {
-    wtap_block_t merged_idb;
-    guint i;
+    gchar *key;
+    const char *name;
+    idb_bucket_t *bucket;
+    guint best = G_MAXUINT;
 
     g_assert(input_file_idb != NULL);
     g_assert(merged_idb_list != NULL);
     g_assert(merged_idb_list->interface_data != NULL);
     g_assert(found_index != NULL);
 
-    for (i = 0; i < merged_idb_list->interface_data->len; i++) {
-        merged_idb = g_array_index(merged_idb_list->interface_data, wtap_block_t, i);
+    key = idb_bucket_key(input_file_idb);
+    bucket = (idb_bucket_t *)g_hash_table_lookup(buckets, key);
+    g_free(key);
+    if (bucket == NULL)
+        return FALSE;
 
-        if (is_duplicate_idb(input_file_idb, merged_idb)) {
-            *found_index = i;
-            return TRUE;
-        }
+    name = idb_name(input_file_idb);
+    if (name == NULL) {
+        find_duplicate_in(input_file_idb, merged_idb_list, bucket->all, &best);
+    } else {
+        find_duplicate_in(input_file_idb, merged_idb_list,
+                          (const GArray *)g_hash_table_lookup(bucket->named, name), &best);
+        find_duplicate_in(input_file_idb, merged_idb_list, bucket->unnamed, &best);
     }
 
-    return FALSE;
+    if (best == G_MAXUINT)
+        return FALSE;
+    *found_index = best;
+    return TRUE;
 }
 
 /* adds IDB to merged file info, returns its index */
@@ -709,6 +897,7 @@ generate_merged_idb(merge_in_file_t *in_files, const guint in_file_count, const
     wtap_block_t                 input_file_idb;
     guint                        itf_count, merged_index;
     guint                        i;
+    GHashTable                  *buckets;
 
     /* create new IDB info */
     merged_idb_list = g_new(wtapng_iface_descriptions_t,1);
@@ -742,6 +931,7 @@ generate_merged_idb(merge_in_file_t *in_files, const guint in_file_count, const
         g_free(input_file_idb_list);
     }
     else {
+        buckets = idb_buckets_new();
         for (i = 0; i < in_file_count; i++) {
             input_file_idb_list = wtap_file_get_idb_info(in_files[i].wth);
 
@@ -750,7 +940,7 @@ generate_merged_idb(merge_in_file_t *in_files, const guint in_file_count, const
                                                 wtap_block_t, itf_count);
 
                 if (mode == IDB_MERGE_MODE_ANY_SAME &&
-                    find_duplicate_idb(input_file_idb, merged_idb_list, &merged_index))
+                    find_duplicate_idb(input_file_idb, merged_idb_list, buckets, &merged_index))
                 {
                     merge_debug("merge::generate_merged_idb: mode ANY set and found a duplicate");
                     /*
@@ -768,11 +958,14 @@ generate_merged_idb(merge_in_file_t *in_files, const guint in_file_count, const
                      */
                     merged_index = add_idb_to_merged_file(merged_idb_list, input_file_idb);
                     add_idb_index_map(&in_files[i], itf_count, merged_index);
+                    if (mode == IDB_MERGE_MODE_ANY_SAME)
+                        idb_buckets_add(buckets, input_file_idb, merged_index);
                 }
             }
 
             g_free(input_file_idb_list);
         }
+        g_hash_table_destroy(buckets);
     }
 
     return merged_idb_list;
@@ -816,6 +1009,12 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
     int                 count = 0;
     gboolean            stop_flag = FALSE;
     struct wtap_pkthdr *phdr, snap_phdr;
+    merge_heap_t        heap;
+
+    heap.entries = g_new(merge_heap_entry_t, in_file_count);
+    heap.count = 0;
+    heap.last = -1;
+    heap.primed = FALSE;
 
     for (;;) {
         *err = 0;
@@ -825,7 +1024,7 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
                                                err_info);
         }
         else {
-            in_file = merge_read_packet(in_file_count, in_files, err,
+            in_file = merge_read_packet(in_file_count, in_files, &heap, err,
                                         err_info);
         }
 
@@ -886,6 +1085,8 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
         }
     }
 
+    g_free(heap.entries);
+
     if (cb)
         cb->callback_func(MERGE_EVENT_DONE, count, in_files, in_file_count, cb->data);
 
@@ -950,8 +1151,8 @@ merge_files(const gchar* out_filename, const int file_type,
     merge_debug("merge_files: begin");
 
     /* open the input files */
-    if (!merge_open_in_files(in_file_count, in_filenames, &in_files, cb,
-                             err, err_info, err_fileno)) {
+    if (!merge_open_in_files(in_file_count, in_filenames, &in_files, FALSE,
+                             cb, err, err_info, err_fileno)) {
         merge_debug("merge_files: merge_open_in_files() failed with err=%d", *err);
         *err_framenum = 0;
         return MERGE_ERR_CANT_OPEN_INFILE;
@@ -1053,8 +1254,8 @@ merge_files_to_tempfile(gchar **out_filenamep, const char *pfx,
     *out_filenamep = NULL;
 
     /* open the input files */
-    if (!merge_open_in_files(in_file_count, in_filenames, &in_files, cb,
-                             err, err_info, err_fileno)) {
+    if (!merge_open_in_files(in_file_count, in_filenames, &in_files, FALSE,
+                             cb, err, err_info, err_fileno)) {
         merge_debug("merge_files: merge_open_in_files() failed with err=%d", *err);
         *err_framenum = 0;
         return MERGE_ERR_CANT_OPEN_INFILE;
@@ -1152,8 +1353,8 @@ merge_files_to_stdout(const int file_type, const char *const *in_filenames,
     merge_debug("merge_files: begin");
 
     /* open the input files */
-    if (!merge_open_in_files(in_file_count, in_filenames, &in_files, cb,
-                             err, err_info, err_fileno)) {
+    if (!merge_open_in_files(in_file_count, in_filenames, &in_files, FALSE,
+                             cb, err, err_info, err_fileno)) {
         merge_debug("merge_files: merge_open_in_files() failed with err=%d", *err);
         *err_framenum = 0;
         return MERGE_ERR_CANT_OPEN_INFILE;
@@ -1217,6 +1418,250 @@ merge_files_to_stdout(const int file_type, const char *const *in_filenames,
     return status;
 }
 
+/*
+ * Virtual merged files.
+ *
+ * Rather than writing the merged packets out, hand them to the caller
+ * from a wtap of their own, the way a file with the merged IDBs would
+ * be read.  The offset of a packet is its offset in its own file with
+ * the index of that file in the bits above VIRTUAL_OFFSET_BITS, so that
+ * seeking to it only needs to pick the file and seek in that.
+ */
+#define VIRTUAL_OFFSET_BITS     48
+#define VIRTUAL_OFFSET_MASK     ((G_GINT64_CONSTANT(1) << VIRTUAL_OFFSET_BITS) - 1)
+#define VIRTUAL_MAX_FILES       (1U << (63 - VIRTUAL_OFFSET_BITS))
+
+typedef struct {
+    merge_in_file_t *in_files;
+    gchar          **in_filenames;  /* our copies, for in_files[].filename */
+    guint            in_file_count;
+    gboolean         do_append;
+    merge_heap_t     heap;
+} merge_virtual_t;
+
+static gboolean
+merge_virtual_map_interface_id(struct wtap_pkthdr *phdr,
+                               const merge_in_file_t *in_file,
+                               int *err, gchar **err_info)
+{
+    /* Files with no IDBs at all have nothing to map */
+    if (phdr->rec_type != REC_TYPE_PACKET || in_file->idb_index_map->len == 0)
+        return TRUE;
+
+    if (!map_phdr_interface_id(phdr, in_file)) {
+        *err = WTAP_ERR_BAD_FILE;
+        *err_info = g_strdup_printf("merge: record %u of \"%s\" has an interface ID that does not match any IDB in its file",
+                                    in_file->packet_num, in_file->filename);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static gboolean
+merge_virtual_read(wtap *wth, int *err, gchar **err_info, gint64 *data_offset)
+{
+    merge_virtual_t    *virt = (merge_virtual_t *)wth->priv;
+    merge_in_file_t    *in_file;
+    struct wtap_pkthdr *phdr;
+    Buffer              ft_specific_data;
+    guint               i;
+
+    /* Name resolution records are found by the files themselves */
+    for (i = 0; i < virt->in_file_count; i++) {
+        virt->in_files[i].wth->add_new_ipv4 = wth->add_new_ipv4;
+        virt->in_files[i].wth->add_new_ipv6 = wth->add_new_ipv6;
+    }
+
+    if (virt->do_append) {
+        in_file = merge_append_read_packet(virt->in_file_count, virt->in_files,
+                                           err, err_info);
+    }
+    else {
+        in_file = merge_read_packet(virt->in_file_count, virt->in_files,
+                                    &virt->heap, err, err_info);
+    }
+    if (in_file == NULL || *err != 0)
+        return FALSE;
+
+    /*
+     * The header is good until that file is read from again, which
+     * isn't until we're asked for the next packet; the file-type
+     * specific data stays with the file.
+     */
+    phdr = wtap_phdr(in_file->wth);
+    ft_specific_data = wth->phdr.ft_specific_data;
+    wth->phdr = *phdr;
+    wth->phdr.ft_specific_data = ft_specific_data;
+    if (!merge_virtual_map_interface_id(&wth->phdr, in_file, err, err_info))
+        return FALSE;
+
+    ws_buffer_assure_space(wth->frame_buffer, phdr->caplen);
+    memcpy(ws_buffer_start_ptr(wth->frame_buffer), wtap_buf_ptr(in_file->wth),
+           phdr->caplen);
+
+    *data_offset = ((gint64)(in_file - virt->in_files) << VIRTUAL_OFFSET_BITS) |
+                   in_file->data_offset;
+    return TRUE;
+}
+
+static gboolean
+merge_virtual_seek_read(wtap *wth, gint64 seek_off, struct wtap_pkthdr *phdr,
+                        Buffer *buf, int *err, gchar **err_info)
+{
+    merge_virtual_t *virt = (merge_virtual_t *)wth->priv;
+    merge_in_file_t *in_file;
+    guint64          file_index;
+
+    file_index = (guint64)seek_off >> VIRTUAL_OFFSET_BITS;
+    if (file_index >= virt->in_file_count) {
+        *err = WTAP_ERR_BAD_FILE;
+        *err_info = g_strdup_printf("merge: seek offset %" G_GINT64_MODIFIER "d is not in any of the files",
+                                    seek_off);
+        return FALSE;
+    }
+    in_file = &virt->in_files[file_index];
+
+    if (!wtap_seek_read(in_file->wth, seek_off & VIRTUAL_OFFSET_MASK, phdr, buf,
+                        err, err_info))
+        return FALSE;
+    return merge_virtual_map_interface_id(phdr, in_file, err, err_info);
+}
+
+static gint64
+merge_virtual_read_so_far(wtap *wth)
+{
+    merge_virtual_t *virt = (merge_virtual_t *)wth->priv;
+    gint64           so_far = 0;
+    guint            i;
+
+    for (i = 0; i < virt->in_file_count; i++)
+        so_far += wtap_read_so_far(virt->in_files[i].wth);
+    return so_far;
+}
+
+static gint64
+merge_virtual_file_size(wtap *wth, int *err)
+{
+    merge_virtual_t *virt = (merge_virtual_t *)wth->priv;
+    gint64           size, total = 0;
+    guint            i;
+
+    for (i = 0; i < virt->in_file_count; i++) {
+        size = wtap_file_size(virt->in_files[i].wth, err);
+        if (size == -1)
+            return -1;
+        total += size;
+    }
+    return total;
+}
+
+static void
+merge_virtual_sequential_close(wtap *wth)
+{
+    merge_virtual_t *virt = (merge_virtual_t *)wth->priv;
+    guint            i;
+
+    for (i = 0; i < virt->in_file_count; i++)
+        wtap_sequential_close(virt->in_files[i].wth);
+    g_free(virt->heap.entries);
+    virt->heap.entries = NULL;
+}
+
+static void
+merge_virtual_close(wtap *wth)
+{
+    merge_virtual_t *virt = (merge_virtual_t *)wth->priv;
+
+    merge_close_in_files(virt->in_file_count, virt->in_files);
+    g_free(virt->in_files);
+    g_strfreev(virt->in_filenames);
+    g_free(virt->heap.entries);
+}
+
+/*
+ * Opens the files as a single file that can be read sequentially and
+ * randomly, without merging them to a file first.  Returns NULL on
+ * failure.
+ */
+wtap *
+merge_open_virtual(const char *const *in_filenames, const guint in_file_count,
+                   const gboolean do_append, const idb_merge_mode mode,
+                   int *err, gchar **err_info, guint *err_fileno)
+{
+    merge_in_file_t    *in_files = NULL;
+    merge_virtual_t    *virt;
+    wtapng_iface_descriptions_t *idb_inf;
+    wtap               *wth;
+    guint               i;
+
+    g_assert(in_file_count > 0);
+    g_assert(in_filenames != NULL);
+    g_assert(err != NULL);
+    g_assert(err_info != NULL);
+    g_assert(err_fileno != NULL);
+
+    if (in_file_count > VIRTUAL_MAX_FILES) {
+        *err = WTAP_ERR_INTERNAL;
+        *err_info = g_strdup_printf("merge: can't open more than %u files as one",
+                                    VIRTUAL_MAX_FILES);
+        *err_fileno = 0;
+        return NULL;
+    }
+
+    if (!merge_open_in_files(in_file_count, in_filenames, &in_files, TRUE,
+                             NULL, err, err_info, err_fileno)) {
+        merge_debug("merge_open_virtual: merge_open_in_files() failed with err=%d", *err);
+        return NULL;
+    }
+
+    virt = g_new(merge_virtual_t, 1);
+    virt->in_files = in_files;
+    virt->in_filenames = g_new(gchar *, in_file_count + 1);
+    for (i = 0; i < in_file_count; i++) {
+        virt->in_filenames[i] = g_strdup(in_filenames[i]);
+        in_files[i].filename = virt->in_filenames[i];
+    }
+    virt->in_filenames[in_file_count] = NULL;
+    virt->in_file_count = in_file_count;
+    virt->do_append = do_append;
+    virt->heap.entries = g_new(merge_heap_entry_t, in_file_count);
+    virt->heap.count = 0;
+    virt->heap.last = -1;
+    virt->heap.primed = FALSE;
+
+    wth = (wtap *)g_malloc0(sizeof(wtap));
+    wth->fh = NULL;
+    wth->random_fh = NULL;
+    wth->file_type_subtype = WTAP_FILE_TYPE_SUBTYPE_PCAPNG;
+    wth->file_encap = merge_select_frame_type(in_file_count, in_files);
+    wth->file_tsprec = wtap_file_tsprec(in_files[0].wth);
+    wth->snapshot_length = wtap_snapshot_length(in_files[0].wth);
+    for (i = 1; i < in_file_count; i++) {
+        if (wtap_file_tsprec(in_files[i].wth) != wth->file_tsprec)
+            wth->file_tsprec = WTAP_TSPREC_PER_PACKET;
+        if (wth->snapshot_length != 0 &&
+            (wtap_snapshot_length(in_files[i].wth) == 0 ||
+             (guint)wtap_snapshot_length(in_files[i].wth) > wth->snapshot_length))
+            wth->snapshot_length = wtap_snapshot_length(in_files[i].wth);
+    }
+    wth->shb_hdrs = wtap_file_get_shb_for_new_file(in_files[0].wth);
+    idb_inf = generate_merged_idb(in_files, in_file_count, mode);
+    wth->interface_data = idb_inf->interface_data;
+    g_free(idb_inf);
+    wth->frame_buffer = (struct Buffer *)g_malloc(sizeof(struct Buffer));
+    ws_buffer_init(wth->frame_buffer, 1500);
+
+    wth->priv = virt;
+    wth->subtype_read = merge_virtual_read;
+    wth->subtype_seek_read = merge_virtual_seek_read;
+    wth->subtype_read_so_far = merge_virtual_read_so_far;
+    wth->subtype_file_size = merge_virtual_file_size;
+    wth->subtype_sequential_close = merge_virtual_sequential_close;
+    wth->subtype_close = merge_virtual_close;
+
+    return wth;
+}
+
 /*
  * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
  *
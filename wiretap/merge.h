@@ -212,6 +212,29 @@ merge_files_to_stdout(const int file_type, const char *const *in_filenames,
                       int *err, gchar **err_info, guint *err_fileno,
                       guint32 *err_framenum);
 
+/** Open the given input files as a single virtual file
+ *
+ * The packets are read from the files themselves, in chronological or
+ * file order, and the packets read can be seek-read again later, so the
+ * files can be looked at together without merging them to a file first.
+ * The packets are presented as pcapng, with their interface IDs mapped
+ * to the merged IDBs.
+ *
+ * @param in_filenames array of input filenames
+ * @param in_file_count the number of input files
+ * @param do_append if TRUE, the packets of each file follow those of
+ * the file before it, otherwise they're merged chronologically
+ * @param mode the IDB merge mode for pcapng files
+ * @param[out] err wiretap error, if failed
+ * @param[out] err_info wiretap error string, if failed
+ * @param[out] err_fileno file on which open failed, if failed
+ * @return the wtap to read from, or NULL on failure
+ */
+WS_DLL_PUBLIC wtap *
+merge_open_virtual(const char *const *in_filenames, const guint in_file_count,
+                   const gboolean do_append, const idb_merge_mode mode,
+                   int *err, gchar **err_info, guint *err_fileno);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -455,6 +455,55 @@ pcapng_read_option(FILE_T fh, pcapng_t *pn, pcapng_option_header_t *oh,
     return block_read;
 }
 
+/*
+ * Get the header of an option from a buffer holding all of a block's
+ * options, as read with one wtap_read_bytes() call; the option's
+ * content follows the header.  This does the same sanity checks as
+ * pcapng_read_option(), and returns the number of bytes the option,
+ * including any padding after it, takes up, or -1 on error.
+ */
+static int
+pcapng_get_option(pcapng_t *pn, guint8 *opt_ptr, guint to_read,
+                  pcapng_option_header_t **ohp,
+                  int *err, gchar **err_info, gchar* block_name)
+{
+    pcapng_option_header_t *oh;
+    guint   option_read;
+
+    /* sanity check: don't run past the end of the block */
+    if (to_read < sizeof (*oh)) {
+        *err = WTAP_ERR_BAD_FILE;
+        *err_info = g_strdup_printf("pcapng_get_option: Not enough data to read header of the %s block",
+                                    block_name);
+        return -1;
+    }
+
+    /* options are 32-bit aligned, so this is aligned */
+    oh = (pcapng_option_header_t *)(void *)opt_ptr;
+    if (pn->byte_swapped) {
+        oh->option_code      = GUINT16_SWAP_LE_BE(oh->option_code);
+        oh->option_length    = GUINT16_SWAP_LE_BE(oh->option_length);
+    }
+
+    /* sanity check: don't run past the end of the block */
+    if (to_read < sizeof (*oh) + oh->option_length) {
+        *err = WTAP_ERR_BAD_FILE;
+        *err_info = g_strdup_printf("pcapng_get_option: Not enough data to handle option length (%d) of the %s block",
+                                    oh->option_length, block_name);
+        return -1;
+    }
+    option_read = (guint)sizeof (*oh) + oh->option_length;
+
+    /* jump over potential padding bytes at end of option */
+    if ( (oh->option_length % 4) != 0)
+        option_read += 4 - (oh->option_length % 4);
+    if (option_read > to_read)
+        option_read = to_read;
+
+    *ohp = oh;
+    return (int)option_read;
+}
+
 typedef enum {
     PCAPNG_BLOCK_OK,
     PCAPNG_BLOCK_NOT_SHB,
@@ -1024,6 +1073,7 @@ pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh, pcapng_t *pn, wta
     guint8 *opt_ptr;
     pcapng_option_header_t *oh;
     guint8 *option_content;
+    char *comment;
     int pseudo_header_len;
     int fcslen;
 #ifdef HAVE_PLUGINS
@@ -1254,21 +1304,31 @@ pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh, pcapng_t *pn, wta
         block_read -    /* fixed and variable part, including padding */
         (int)sizeof(bh->block_total_length);
 
-    /* Allocate enough memory to hold all options */
+    /*
+     * Allocate enough memory to hold all options, and read them all
+     * at once; packet blocks are the bulk of most files, and reading
+     * their options a header, a value and a bit of padding at a time
+     * costs more than parsing them.
+     *
+     * The space after the options holds the comment, if any, so
+     * that we don't have to allocate a string for it.
+     */
     opt_cont_buf_len = to_read;
-    ws_buffer_assure_space(&wblock->packet_header->ft_specific_data, opt_cont_buf_len);
+    ws_buffer_assure_space(&wblock->packet_header->ft_specific_data, 2*opt_cont_buf_len + 1);
     opt_ptr = ws_buffer_start_ptr(&wblock->packet_header->ft_specific_data);
+    if (to_read != 0 && !wtap_read_bytes(fh, opt_ptr, to_read, err, err_info))
+        return FALSE;
 
     while (to_read != 0) {
-        /* read option */
-        oh = (pcapng_option_header_t *)(void *)opt_ptr;
-        option_content = opt_ptr + sizeof (pcapng_option_header_t);
-        bytes_read = pcapng_read_option(fh, pn, oh, option_content, opt_cont_buf_len, to_read, err, err_info, "packet");
+        /* get option */
+        bytes_read = pcapng_get_option(pn, opt_ptr, to_read, &oh, err, err_info, "packet");
         if (bytes_read <= 0) {
             pcapng_debug("pcapng_read_packet_block: failed to read option");
             /* XXX - free anything? */
             return FALSE;
         }
+        option_content = opt_ptr + sizeof (pcapng_option_header_t);
+        opt_ptr += bytes_read;
         block_read += bytes_read;
         to_read -= bytes_read;
 
@@ -1284,7 +1344,10 @@ pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh, pcapng_t *pn, wta
             case(OPT_COMMENT):
                 if (oh->option_length > 0 && oh->option_length < opt_cont_buf_len) {
                     wblock->packet_header->presence_flags |= WTAP_HAS_COMMENTS;
-                    wblock->packet_header->opt_comment = g_strndup((char *)option_content, oh->option_length);
+                    comment = (char *)ws_buffer_start_ptr(&wblock->packet_header->ft_specific_data) + opt_cont_buf_len;
+                    memcpy(comment, option_content, oh->option_length);
+                    comment[oh->option_length] = '\0';
+                    wblock->packet_header->opt_comment = comment;
                     pcapng_debug("pcapng_read_packet_block: length %u opt_comment '%s'", oh->option_length, wblock->packet_header->opt_comment);
                 } else {
                     pcapng_debug("pcapng_read_packet_block: opt_comment length %u seems strange", oh->option_length);
@@ -62,6 +62,8 @@ struct wtap {
     subtype_seek_read_func      subtype_seek_read;
     void                        (*subtype_sequential_close)(struct wtap*);
     void                        (*subtype_close)(struct wtap*);
+    gint64                      (*subtype_read_so_far)(struct wtap*);     /**< for files not read through fh */
+    gint64                      (*subtype_file_size)(struct wtap*, int*); /**< ditto */
     int                         file_encap;    /* per-file, for those
                                                 * file formats that have
                                                 * per-file encapsulation
@@ -103,6 +105,7 @@ struct wtap_dumper {
     gboolean                compressed;
     gboolean                needs_reload;   /* TRUE if the file requires re-loading after saving with wtap */
     gint64                  bytes_dumped;
+    char                    *write_buf;     /* stdio buffer of an uncompressed file we opened, or NULL */
 
     void                    *priv;          /* this one holds per-file state and is free'd automatically by wtap_dump_close() */
     void                    *wslua_data;    /* this one holds wslua state info and is not free'd */
@@ -34,6 +34,7 @@
 #include "file_wrappers.h"
 #include <wsutil/file_util.h>
 #include <wsutil/buffer.h>
+#include <wsutil/ws_trace.h>
 
 #ifdef HAVE_PLUGINS
 
@@ -115,6 +116,9 @@ wtap_file_size(wtap *wth, int *err)
 {
 	ws_statb64 statb;
 
+	if (wth->subtype_file_size != NULL)
+		return (*wth->subtype_file_size)(wth, err);
+
 	if (file_fstat((wth->fh == NULL) ? wth->random_fh : wth->fh,
 	    &statb, err) == -1)
 		return -1;
@@ -142,9 +146,35 @@ wtap_file_type_subtype(wtap *wth)
 gboolean
 wtap_iscompressed(wtap *wth)
 {
+	if (wth->fh == NULL && wth->random_fh == NULL)
+		return FALSE;
 	return file_iscompressed((wth->fh == NULL) ? wth->random_fh : wth->fh);
 }
 
+void
+wtap_set_fast_seek_span(wtap *wth, gint64 span)
+{
+	if (wth->fh != NULL)
+		file_set_fast_seek_span(wth->fh, span);
+	if (wth->random_fh != NULL)
+		file_set_fast_seek_span(wth->random_fh, span);
+}
+
+gboolean
+wtap_fast_seek_save(wtap *wth, const char *filename, int *err)
+{
+	/* Both handles share the seek points */
+	return file_fast_seek_save((wth->fh == NULL) ? wth->random_fh : wth->fh,
+	    filename, err);
+}
+
+gboolean
+wtap_fast_seek_load(wtap *wth, const char *filename, int *err)
+{
+	return file_fast_seek_load((wth->fh == NULL) ? wth->random_fh : wth->fh,
+	    filename, err);
+}
+
 guint
 wtap_snapshot_length(wtap *wth)
 {
@@ -1253,7 +1283,8 @@ wtap_close(wtap *wth)
 void
 wtap_cleareof(wtap *wth) {
 	/* Reset EOF */
-	file_clearerr(wth->fh);
+	if (wth->fh != NULL)
+		file_clearerr(wth->fh);
 }
 
 void wtap_set_cb_new_ipv4(wtap *wth, wtap_new_ipv4_callback_t add_new_ipv4) {
@@ -1279,6 +1310,8 @@ wtap_read(wtap *wth, int *err, gchar **err_info, gint64 *data_offset)
 	 *
 	 * Do the same for the packet time stamp resolution.
 	 */
+	WS_TRACE0(wtap_read_entry);
+
 	wth->phdr.pkt_encap = wth->file_encap;
 	wth->phdr.pkt_tsprec = wth->file_tsprec;
 
@@ -1294,8 +1327,9 @@ wtap_read(wtap *wth, int *err, gchar **err_info, gint64 *data_offset)
 		 * got enough compressed data to decompress the
 		 * last packet of the file.
 		 */
-		if (*err == 0)
+		if (*err == 0 && wth->fh != NULL)
 			*err = file_error(wth->fh, err_info);
+		WS_TRACE2(wtap_read_return, 0, 0);
 		return FALSE;	/* failure */
 	}
 
@@ -1314,6 +1348,7 @@ wtap_read(wtap *wth, int *err, gchar **err_info, gint64 *data_offset)
 	 */
 	g_assert(wth->phdr.pkt_encap != WTAP_ENCAP_PER_PACKET);
 
+	WS_TRACE2(wtap_read_return, 1, wth->phdr.caplen);
 	return TRUE;	/* success */
 }
 
@@ -1403,6 +1438,8 @@ wtap_read_packet_bytes(FILE_T fh, Buffer *buf, guint length, int *err,
 gint64
 wtap_read_so_far(wtap *wth)
 {
+	if (wth->subtype_read_so_far != NULL)
+		return (*wth->subtype_read_so_far)(wth);
 	return file_tell_raw(wth->fh);
 }
 
@@ -1445,13 +1482,17 @@ wtap_seek_read(wtap *wth, gint64 seek_off,
 	 *
 	 * Do the same for the packet time stamp resolution.
 	 */
+	WS_TRACE1(wtap_seek_read_entry, seek_off);
+
 	phdr->pkt_encap = wth->file_encap;
 	phdr->pkt_tsprec = wth->file_tsprec;
 
 	*err = 0;
 	*err_info = NULL;
-	if (!wth->subtype_seek_read(wth, seek_off, phdr, buf, err, err_info))
+	if (!wth->subtype_seek_read(wth, seek_off, phdr, buf, err, err_info)) {
+		WS_TRACE2(wtap_seek_read_return, 0, 0);
 		return FALSE;
+	}
 
 	/*
 	 * It makes no sense for the captured data length to be bigger
@@ -1468,6 +1509,7 @@ wtap_seek_read(wtap *wth, gint64 seek_off,
 	 */
 	g_assert(phdr->pkt_encap != WTAP_ENCAP_PER_PACKET);
 
+	WS_TRACE2(wtap_seek_read_return, 1, phdr->caplen);
 	return TRUE;
 }
 
@@ -1261,7 +1261,10 @@ struct wtap_pkthdr {
                                 /* pcapng variables */
     guint32   interface_id;     /* identifier of the interface. */
                                 /* options */
-    gchar     *opt_comment;     /* NULL if not available */
+    gchar     *opt_comment;     /* NULL if not available; when reading,
+                                   this may belong to libwiretap and only
+                                   be good until the next read into this
+                                   header, so copy it if you keep it */
     gboolean  has_comment_changed; /* TRUE if the comment has been changed. Currently only valid while dumping. */
 
     guint64   drop_count;       /* number of packets lost (by the interface and the
@@ -1631,6 +1634,36 @@ WS_DLL_PUBLIC
 gint64 wtap_file_size(wtap *wth, int *err);
 WS_DLL_PUBLIC
 gboolean wtap_iscompressed(wtap *wth);
+
+/*** saving and restoring the points used to seek in compressed files ***/
+
+/** Set the number of uncompressed bytes between the points we keep for
+ * seeking in a compressed file; more points make seeking faster, but
+ * take more memory (32K each).  Call this before reading any records. */
+WS_DLL_PUBLIC
+void wtap_set_fast_seek_span(wtap *wth, gint64 span);
+
+/** Save the seek points found so far, normally after a sequential pass
+ * over the whole file, into an index file.
+ *
+ * @param wth The wiretap session, opened for random access.
+ * @param filename The index file to write.
+ * @param err An errno value, if we fail.
+ * @return TRUE on success, FALSE on failure. */
+WS_DLL_PUBLIC
+gboolean wtap_fast_seek_save(wtap *wth, const char *filename, int *err);
+
+/** Load seek points saved by wtap_fast_seek_save(), so that we can seek
+ * anywhere in a compressed file without first reading up to that point.
+ *
+ * @param wth The wiretap session, opened for random access.
+ * @param filename The index file to read.
+ * @param err On failure, an errno value, or 0 if the index isn't usable
+ * because it's not an index, it's damaged or it was made for a different
+ * version of the file.
+ * @return TRUE on success, FALSE on failure. */
+WS_DLL_PUBLIC
+gboolean wtap_fast_seek_load(wtap *wth, const char *filename, int *err);
 WS_DLL_PUBLIC
 guint wtap_snapshot_length(wtap *wth); /* per file */
 WS_DLL_PUBLIC
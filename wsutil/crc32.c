@@ -27,8 +27,18 @@
 
 #include "config.h"
 
+#ifdef __APPLE__
+#if defined(__clang__) && (__clang_major__ >= 6)
+/* allow HAVE_SSE4_2 to be used for clang 6.0+ case because we know it works */
+#else
+/* don't allow it otherwise, for Mac OSX */
+#undef HAVE_SSE4_2
+#endif
+#endif
+
 #include <glib.h>
 #include <wsutil/crc32.h>
+#include "crc32_int.h"
 
 #define CRC32_ACCUMULATE(c,d,table) (c=(c>>8)^(table)[(c^(d))&0xFF])
 
@@ -377,11 +387,31 @@ crc32_ccitt_table_lookup (guchar pos)
 	return crc32_ccitt_table[pos];
 }
 
+#ifdef HAVE_SSE4_2
+/* -1 until we've checked the CPU, then whether it has the crc32 instruction */
+static int crc32c_use_sse42 = -1;
+
+static inline gboolean
+crc32c_sse42_usable(int len)
+{
+	/* For a few bytes the table is as fast as the check */
+	if (len < 16)
+		return FALSE;
+	if (G_UNLIKELY(crc32c_use_sse42 < 0))
+		crc32c_use_sse42 = crc32c_sse42_supported();
+	return crc32c_use_sse42;
+}
+#endif
+
 guint32
 crc32c_calculate(const void *buf, int len, guint32 crc)
 {
 	const guint8 *p = (const guint8 *)buf;
 	crc = CRC32C_SWAP(crc);
+#ifdef HAVE_SSE4_2
+	if (crc32c_sse42_usable(len))
+		return CRC32C_SWAP(crc32c_calculate_sse42(buf, len, crc));
+#endif
 	while (len-- > 0) {
 		CRC32C(crc, *p++);
 	}
@@ -392,6 +422,10 @@ guint32
 crc32c_calculate_no_swap(const void *buf, int len, guint32 crc)
 {
 	const guint8 *p = (const guint8 *)buf;
+#ifdef HAVE_SSE4_2
+	if (crc32c_sse42_usable(len))
+		return crc32c_calculate_sse42(buf, len, crc);
+#endif
 	while (len-- > 0) {
 		CRC32C(crc, *p++);
 	}
@@ -0,0 +1,93 @@
+/* crc32c_sse42.c
+ * CRC-32C using the SSE4.2 crc32 instruction
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+
+#ifdef HAVE_SSE4_2
+
+#include <glib.h>
+#include "ws_cpuid.h"
+
+#ifdef _WIN32
+  #include <tmmintrin.h>
+#endif
+
+#include <nmmintrin.h>
+#include <string.h>
+#include "crc32_int.h"
+
+gboolean
+crc32c_sse42_supported(void)
+{
+	return ws_cpuid_sse42() ? TRUE : FALSE;
+}
+
+/*
+ * The crc32 instruction implements the reflected Castagnoli polynomial,
+ * i.e. exactly what the crc32c_table loop in crc32.c computes, without
+ * any swapping of the CRC.
+ */
+guint32
+crc32c_calculate_sse42(const void *buf, int len, guint32 crc)
+{
+	const guint8 *p = (const guint8 *)buf;
+	guint32 v32;
+#if defined(__x86_64__) || defined(_M_X64)
+	guint64 crc64 = crc;
+	guint64 v64;
+
+	while (len >= 8) {
+		memcpy(&v64, p, sizeof v64);
+		crc64 = _mm_crc32_u64(crc64, v64);
+		p += 8;
+		len -= 8;
+	}
+	crc = (guint32)crc64;
+#endif
+
+	while (len >= 4) {
+		memcpy(&v32, p, sizeof v32);
+		crc = _mm_crc32_u32(crc, v32);
+		p += 4;
+		len -= 4;
+	}
+	while (len-- > 0) {
+		crc = _mm_crc32_u8(crc, *p++);
+	}
+
+	return crc;
+}
+
+#endif /* HAVE_SSE4_2 */
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -0,0 +1,108 @@
+/*
+ * microbench.h
+ * Timing of small operations for the benchmark modes of the test programs
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef __WSUTIL_MICROBENCH_H__
+#define __WSUTIL_MICROBENCH_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <glib.h>
+
+/*
+ * Each benchmark is run WS_MICROBENCH_WARMUP times untimed, so that caches
+ * and lazily allocated state are warm, and then WS_MICROBENCH_SAMPLES
+ * times timed.  The samples are reported as nanoseconds per operation at
+ * the minimum, median, 90th percentile and maximum, one line per
+ * benchmark so that the output of two builds can be diffed.  Compare the
+ * medians; the spread between them and the 90th percentile says how
+ * noisy the machine was.
+ */
+#define WS_MICROBENCH_WARMUP	3
+#define WS_MICROBENCH_SAMPLES	31
+
+/* Do one sample's worth of work, i.e. ops_per_call operations */
+typedef void (*ws_microbench_func)(gpointer data);
+
+static int
+ws_microbench_compare(const void *a, const void *b)
+{
+	gdouble da = *(const gdouble *)a;
+	gdouble db = *(const gdouble *)b;
+
+	return da < db ? -1 : da > db ? 1 : 0;
+}
+
+static inline void
+ws_microbench_header(void)
+{
+	printf("%-48s %10s %10s %10s %10s\n", "Benchmark (ns/op)", "min",
+			"p50", "p90", "max");
+}
+
+/* Time func and print its line; returns the median in ns/op */
+static inline gdouble
+ws_microbench_run(const char *name, guint64 ops_per_call,
+		ws_microbench_func func, gpointer data)
+{
+	gdouble	 samples[WS_MICROBENCH_SAMPLES];
+	GTimer	*timer;
+	int	 i;
+
+	for (i = 0; i < WS_MICROBENCH_WARMUP; i++)
+		func(data);
+
+	timer = g_timer_new();
+	for (i = 0; i < WS_MICROBENCH_SAMPLES; i++) {
+		g_timer_start(timer);
+		func(data);
+		samples[i] = g_timer_elapsed(timer, NULL) * 1e9 /
+				(gdouble)(ops_per_call ? ops_per_call : 1);
+	}
+	g_timer_destroy(timer);
+
+	qsort(samples, WS_MICROBENCH_SAMPLES, sizeof samples[0],
+			ws_microbench_compare);
+	printf("%-48s %10.2f %10.2f %10.2f %10.2f\n", name, samples[0],
+			samples[WS_MICROBENCH_SAMPLES / 2],
+			samples[(WS_MICROBENCH_SAMPLES - 1) * 9 / 10],
+			samples[WS_MICROBENCH_SAMPLES - 1]);
+	fflush(stdout);
+
+	return samples[WS_MICROBENCH_SAMPLES / 2];
+}
+
+#endif /* __WSUTIL_MICROBENCH_H__ */
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -34,20 +34,48 @@
 #endif
 #endif
 
+#include <string.h>
+
 #include <glib.h>
 #include "ws_symbol_export.h"
 #include "ws_mempbrk.h"
 #include "ws_mempbrk_int.h"
 
+/* SSE2 is part of the x86-64 baseline and NEON of the AArch64 one, so the
+ * few-needle kernels below don't need any run-time CPU detection. */
+#if defined(__SSE2__) || (defined(_MSC_VER) && (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)))
+#define WS_MEMPBRK_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define WS_MEMPBRK_NEON
+#include <arm_neon.h>
+#endif
+
 void
 ws_mempbrk_compile(ws_mempbrk_pattern* pattern, const gchar *needles)
 {
     const gchar *n = needles;
+    guint count = 0;
+
     while (*n) {
-        pattern->patt[(int)*n] = 1;
+        /* count each distinct needle once */
+        if (!memchr(needles, *n, n - needles)) {
+            if (count < WS_MEMPBRK_FEW_NEEDLES)
+                pattern->few_needles[count] = (guint8)*n;
+            count++;
+        }
+        pattern->patt[(guint8)*n] = 1;
         n++;
     }
 
+    pattern->num_few_needles = (count <= WS_MEMPBRK_FEW_NEEDLES) ? count : 0;
+    /* Repeat the last needle in the unused slots, so the kernels can always
+     * compare against all of them */
+    while (count > 0 && count < WS_MEMPBRK_FEW_NEEDLES) {
+        pattern->few_needles[count] = pattern->few_needles[count - 1];
+        count++;
+    }
+
 #ifdef HAVE_SSE4_2
     ws_mempbrk_sse42_compile(pattern, needles);
 #endif
@@ -72,9 +100,68 @@ ws_mempbrk_portable_exec(const guint8* haystack, size_t haystacklen, const ws_me
 }
 
 
+#ifdef WS_MEMPBRK_SSE2
+static const guint8 *
+ws_mempbrk_few_exec(const guint8* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, guchar *found_needle)
+{
+    const guint8 *haystack_end = haystack + haystacklen;
+    const __m128i n0 = _mm_set1_epi8((char)pattern->few_needles[0]);
+    const __m128i n1 = _mm_set1_epi8((char)pattern->few_needles[1]);
+    const __m128i n2 = _mm_set1_epi8((char)pattern->few_needles[2]);
+    const __m128i n3 = _mm_set1_epi8((char)pattern->few_needles[3]);
+    __m128i v, m;
+    int mask;
+
+    while (haystack_end - haystack >= 16) {
+        v = _mm_loadu_si128((const __m128i *)(const void *)haystack);
+        m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, n0), _mm_cmpeq_epi8(v, n1)),
+                         _mm_or_si128(_mm_cmpeq_epi8(v, n2), _mm_cmpeq_epi8(v, n3)));
+        mask = _mm_movemask_epi8(m);
+        if (mask) {
+            haystack += g_bit_nth_lsf((gulong)mask, -1);
+            if (found_needle)
+                *found_needle = *haystack;
+            return haystack;
+        }
+        haystack += 16;
+    }
+
+    return ws_mempbrk_portable_exec(haystack, haystack_end - haystack, pattern, found_needle);
+}
+#elif defined(WS_MEMPBRK_NEON)
+static const guint8 *
+ws_mempbrk_few_exec(const guint8* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, guchar *found_needle)
+{
+    const guint8 *haystack_end = haystack + haystacklen;
+    const uint8x16_t n0 = vdupq_n_u8(pattern->few_needles[0]);
+    const uint8x16_t n1 = vdupq_n_u8(pattern->few_needles[1]);
+    const uint8x16_t n2 = vdupq_n_u8(pattern->few_needles[2]);
+    const uint8x16_t n3 = vdupq_n_u8(pattern->few_needles[3]);
+    uint8x16_t v, m;
+
+    while (haystack_end - haystack >= 16) {
+        v = vld1q_u8(haystack);
+        m = vorrq_u8(vorrq_u8(vceqq_u8(v, n0), vceqq_u8(v, n1)),
+                     vorrq_u8(vceqq_u8(v, n2), vceqq_u8(v, n3)));
+        if (vmaxvq_u8(m)) {
+            /* there's a match in these 16 bytes; find which one */
+            return ws_mempbrk_portable_exec(haystack, 16, pattern, found_needle);
+        }
+        haystack += 16;
+    }
+
+    return ws_mempbrk_portable_exec(haystack, haystack_end - haystack, pattern, found_needle);
+}
+#endif
+
 WS_DLL_PUBLIC const guint8 *
 ws_mempbrk_exec(const guint8* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, guchar *found_needle)
 {
+#if defined(WS_MEMPBRK_SSE2) || defined(WS_MEMPBRK_NEON)
+    /* A few compares per vector beat pcmpistri, so try this first */
+    if (haystacklen >= 16 && pattern->num_few_needles)
+        return ws_mempbrk_few_exec(haystack, haystacklen, pattern, found_needle);
+#endif
 #ifdef HAVE_SSE4_2
     if (haystacklen >= 16 && pattern->use_sse42)
         return ws_mempbrk_sse42_exec(haystack, haystacklen, pattern, found_needle);
@@ -28,10 +28,17 @@
 #include <emmintrin.h>
 #endif
 
+/** Patterns with at most this many distinct needles are scanned by comparing
+ * a whole vector of haystack against each needle, where SIMD is available.
+ */
+#define WS_MEMPBRK_FEW_NEEDLES 4
+
 /** The pattern object used for ws_mempbrk_exec().
  */
 typedef struct {
     gchar patt[256];
+    guint8 few_needles[WS_MEMPBRK_FEW_NEEDLES];
+    guint num_few_needles; /* 0 if there are more needles than that */
 #ifdef HAVE_SSE4_2
     gboolean use_sse42;
     __m128i mask;
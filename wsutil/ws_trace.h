@@ -0,0 +1,81 @@
+/* ws_trace.h
+ * Static tracepoints for perf, bpftrace and SystemTap
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __WS_TRACE_H__
+#define __WS_TRACE_H__
+
+/*
+ * USDT probes in the "wireshark" provider, built in when <sys/sdt.h>
+ * (from SystemTap) is found on Linux and compiled to nothing otherwise.
+ * An unattached probe is a single nop, and its arguments are only
+ * computed into registers, so keep them to values already at hand.
+ *
+ * The probes come in _entry/_return pairs around the work they time:
+ *
+ *   wtap_read_entry, wtap_read_return(ok, caplen)
+ *   wtap_seek_read_entry(offset), wtap_seek_read_return(ok, caplen)
+ *   dissect_entry(frame number), dissect_return(frame number)
+ *   tap_push_entry(frame number), tap_push_return(frame number)
+ *   dfilter_apply_entry, dfilter_apply_return(matched)
+ *   capture_write_packet_entry(caplen), capture_write_packet_return(ok)
+ *
+ * For instance, the dissection latency of a running tshark:
+ *
+ *   bpftrace -p PID -e '
+ *     usdt:/usr/lib/libwireshark.so:wireshark:dissect_entry { @t[tid] = nsecs; }
+ *     usdt:/usr/lib/libwireshark.so:wireshark:dissect_return /@t[tid]/ {
+ *         @ns = hist(nsecs - @t[tid]); delete(@t[tid]); }'
+ *
+ * "perf list sdt_wireshark:*" shows them once added with "perf buildid-cache
+ * --add" on the binary or library.
+ */
+
+#if defined(HAVE_SYS_SDT_H) && defined(__linux__)
+
+#include <sys/sdt.h>
+
+#define WS_TRACE0(name)				DTRACE_PROBE(wireshark, name)
+#define WS_TRACE1(name, arg1)			DTRACE_PROBE1(wireshark, name, arg1)
+#define WS_TRACE2(name, arg1, arg2)		DTRACE_PROBE2(wireshark, name, arg1, arg2)
+
+#else
+
+#define WS_TRACE0(name)
+#define WS_TRACE1(name, arg1)
+#define WS_TRACE2(name, arg1, arg2)
+
+#endif
+
+#endif /* __WS_TRACE_H__ */
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
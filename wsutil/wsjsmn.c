@@ -70,6 +70,15 @@ gboolean jsmn_is_json(const guint8* buf, const size_t len)
         return ret;
 }
 
+gboolean wsjsmn_is_json_value(const guint8* buf, const size_t len)
+{
+        jsmn_parser p;
+
+        /* With no token array, jsmn only counts the tokens */
+        jsmn_init(&p);
+        return jsmn_parse(&p, (const char*)buf, len, NULL, 0) > 0;
+}
+
 int wsjsmn_parse(const char *buf, jsmntok_t *tokens, unsigned int max_tokens)
 {
         jsmn_parser p;
@@ -39,6 +39,13 @@ extern "C" {
  */
 WS_DLL_PUBLIC gboolean jsmn_is_json(const guint8* buf, const size_t len);
 
+/**
+ * Check if a buffer holds only valid JSON tokens, however many there are.
+ * Unlike jsmn_is_json() the tokens aren't stored, so the nesting of
+ * brackets isn't checked.
+ */
+WS_DLL_PUBLIC gboolean wsjsmn_is_json_value(const guint8* buf, const size_t len);
+
 WS_DLL_PUBLIC int wsjsmn_parse(const char *buf, jsmntok_t *tokens, unsigned int max_tokens);
 
 /**